@@ -0,0 +1,441 @@
+//-- includes -----
+#include "ChessboardCalibration.h"
+
+#include "opencv2/calib3d/calib3d.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+//-- constants -----
+static const int k_subpixel_window_half_size = 11;
+
+// With only a few boards the principal point and the 6th order radial term are poorly
+// constrained and wander off, so they are held until there is enough coverage
+static const int k_min_boards_for_full_model = 4;
+
+//-- prototypes -----
+static CameraCalibrationResult make_calibration_result(
+    const cv::Matx33d &intrinsic_matrix, const cv::Vec<double, 5> &distortion_coeffs);
+static void solve_camera_calibration(
+    const std::vector<cv::Point3f> &object_points,
+    const std::vector<std::vector<cv::Point2f>> &image_points_list,
+    const cv::Size &frame_size,
+    CameraCalibrationResult &in_out_result);
+
+//-- ChessboardPattern -----
+void
+ChessboardPattern::computeObjectPoints(std::vector<cv::Point3f> &out_object_points) const
+{
+    out_object_points.clear();
+
+    for (int i = 0; i < corners_high; ++i)
+    {
+        for (int j = 0; j < corners_wide; ++j)
+        {
+            out_object_points.push_back(cv::Point3f(float(j*square_length_mm), float(i*square_length_mm), 0.f));
+        }
+    }
+}
+
+//-- public functions -----
+bool chessboard_find_corners(
+    const cv::Mat &gray_frame,
+    const ChessboardPattern &pattern,
+    const int max_detection_width,
+    std::vector<cv::Point2f> &out_corners)
+{
+    const double scale =
+        (max_detection_width > 0 && gray_frame.cols > max_detection_width)
+        ? static_cast<double>(max_detection_width) / static_cast<double>(gray_frame.cols)
+        : 1.0;
+
+    // The corner search is most of the cost and scales with the pixel count
+    cv::Mat detection_frame;
+    if (scale < 1.0)
+    {
+        cv::resize(gray_frame, detection_frame, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+    else
+    {
+        detection_frame = gray_frame;
+    }
+
+    out_corners.clear();
+    if (!cv::findChessboardCorners(
+            detection_frame,
+            pattern.getSize(),
+            out_corners, // output corners
+            cv::CALIB_CB_ADAPTIVE_THRESH
+            + cv::CALIB_CB_FILTER_QUADS
+            // + cv::CALIB_CB_NORMALIZE_IMAGE is suuuper slow
+            + cv::CALIB_CB_FAST_CHECK) ||
+        static_cast<int>(out_corners.size()) != pattern.getCornerCount())
+    {
+        return false;
+    }
+
+    if (scale < 1.0)
+    {
+        const float inv_scale = static_cast<float>(1.0 / scale);
+
+        for (cv::Point2f &corner : out_corners)
+        {
+            corner *= inv_scale;
+        }
+    }
+
+    // Get subpixel accuracy on those corners, against the full resolution frame
+    cv::cornerSubPix(
+        gray_frame,
+        out_corners, // corners to refine
+        cv::Size(k_subpixel_window_half_size, k_subpixel_window_half_size), // winSize- Half of the side length of the search window
+        cv::Size(-1, -1), // zeroZone- (-1,-1) means no dead zone in search
+        cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::MAX_ITER, 30, 0.1));
+
+    return true;
+}
+
+bool chessboard_are_grid_lines_straight(
+    const ChessboardPattern &pattern,
+    const std::vector<cv::Point2f> &corners,
+    const float tolerance_px)
+{
+    if (static_cast<int>(corners.size()) != pattern.getCornerCount())
+    {
+        return false;
+    }
+
+    bool bAllLinesStraight = true;
+
+    for (int line_index = 0; bAllLinesStraight && line_index < pattern.corners_high; ++line_index)
+    {
+        const int start_index = line_index*pattern.corners_wide;
+        const int end_index = start_index + pattern.corners_wide - 1;
+
+        const cv::Point2f line_start = corners[start_index];
+        const cv::Point2f start_to_end = corners[end_index] - line_start;
+        const float line_length = static_cast<float>(cv::norm(start_to_end));
+
+        for (int point_index = start_index + 1; bAllLinesStraight && point_index < end_index; ++point_index)
+        {
+            const cv::Point2f start_to_point = corners[point_index] - line_start;
+            const float area = static_cast<float>(start_to_point.cross(start_to_end));
+            const float distance = (line_length > FLT_EPSILON) ? fabsf(area / line_length) : 0.f;
+
+            if (distance > tolerance_px)
+            {
+                bAllLinesStraight = false;
+            }
+        }
+    }
+
+    return bAllLinesStraight;
+}
+
+float chessboard_compute_corner_distance_sum(
+    const std::vector<cv::Point2f> &corners_a,
+    const std::vector<cv::Point2f> &corners_b)
+{
+    const size_t corner_count = std::min(corners_a.size(), corners_b.size());
+    float distance_sum = 0.f;
+
+    for (size_t corner_index = 0; corner_index < corner_count; ++corner_index)
+    {
+        distance_sum += static_cast<float>(cv::norm(corners_a[corner_index] - corners_b[corner_index]));
+    }
+
+    return distance_sum;
+}
+
+//-- ChessboardDetectorPool -----
+ChessboardDetectorPool::ChessboardDetectorPool(
+    const ChessboardPattern &pattern,
+    int worker_count,
+    int max_detection_width)
+    : m_pattern(pattern)
+    , m_maxDetectionWidth(max_detection_width)
+    , m_bExitSignaled(false)
+    , m_nextFrameIndex(0)
+    , m_lastPolledFrameIndex(-1)
+    , m_bHasDetection(false)
+{
+    for (int worker_index = 0; worker_index < std::max(worker_count, 1); ++worker_index)
+    {
+        Worker *worker = new Worker;
+        worker->frame_index = -1;
+        worker->bHasFrame = false;
+        m_workers.push_back(worker);
+    }
+
+    for (Worker *worker : m_workers)
+    {
+        worker->thread = std::thread(&ChessboardDetectorPool::workerFunc, this, worker);
+    }
+}
+
+ChessboardDetectorPool::~ChessboardDetectorPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bExitSignaled = true;
+    }
+    m_condition.notify_all();
+
+    for (Worker *worker : m_workers)
+    {
+        worker->thread.join();
+        delete worker;
+    }
+    m_workers.clear();
+}
+
+int
+ChessboardDetectorPool::submitFrame(const cv::Mat &gray_frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (Worker *worker : m_workers)
+    {
+        if (!worker->bHasFrame)
+        {
+            gray_frame.copyTo(worker->frame);
+            worker->frame_index = m_nextFrameIndex++;
+            worker->bHasFrame = true;
+            m_condition.notify_all();
+
+            return worker->frame_index;
+        }
+    }
+
+    return -1;
+}
+
+bool
+ChessboardDetectorPool::pollDetection(ChessboardDetection &out_detection)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_bHasDetection)
+    {
+        return false;
+    }
+
+    out_detection = m_latestDetection;
+    m_lastPolledFrameIndex = m_latestDetection.frame_index;
+    m_bHasDetection = false;
+
+    return true;
+}
+
+void
+ChessboardDetectorPool::workerFunc(Worker *worker)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        m_condition.wait(lock, [this, worker] { return m_bExitSignaled || worker->bHasFrame; });
+
+        if (m_bExitSignaled)
+        {
+            break;
+        }
+
+        // The frame belongs to this worker until bHasFrame is cleared
+        ChessboardDetection detection;
+        detection.frame_index = worker->frame_index;
+        lock.unlock();
+
+        detection.bFound = chessboard_find_corners(worker->frame, m_pattern, m_maxDetectionWidth, detection.corners);
+
+        lock.lock();
+        worker->bHasFrame = false;
+
+        // A newer frame may have finished first on another worker
+        if (detection.frame_index > m_lastPolledFrameIndex &&
+            (!m_bHasDetection || detection.frame_index > m_latestDetection.frame_index))
+        {
+            m_latestDetection = std::move(detection);
+            m_bHasDetection = true;
+        }
+    }
+}
+
+//-- IncrementalCameraCalibrator -----
+IncrementalCameraCalibrator::IncrementalCameraCalibrator(
+    const ChessboardPattern &pattern,
+    const cv::Size &frame_size,
+    const cv::Matx33d &initial_intrinsic_matrix,
+    const cv::Vec<double, 5> &initial_distortion_coeffs)
+    : m_pattern(pattern)
+    , m_frameSize(frame_size)
+    , m_initialResult(make_calibration_result(initial_intrinsic_matrix, initial_distortion_coeffs))
+    , m_latestResult(m_initialResult)
+    , m_solveGeneration(0)
+    , m_bExitSignaled(false)
+{
+    m_pattern.computeObjectPoints(m_objectPoints);
+    m_thread = std::thread(&IncrementalCameraCalibrator::solverFunc, this);
+}
+
+IncrementalCameraCalibrator::~IncrementalCameraCalibrator()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bExitSignaled = true;
+    }
+    m_condition.notify_all();
+
+    m_thread.join();
+}
+
+void
+IncrementalCameraCalibrator::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_boards.clear();
+    m_latestResult = m_initialResult;
+    ++m_solveGeneration;
+    m_condition.notify_all();
+}
+
+void
+IncrementalCameraCalibrator::addBoard(const std::vector<cv::Point2f> &corners)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_boards.push_back(corners);
+    m_condition.notify_all();
+}
+
+int
+IncrementalCameraCalibrator::getBoardCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return static_cast<int>(m_boards.size());
+}
+
+bool
+IncrementalCameraCalibrator::getIsSolving() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_latestResult.board_count != static_cast<int>(m_boards.size());
+}
+
+void
+IncrementalCameraCalibrator::getLatestResult(CameraCalibrationResult &out_result) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    out_result = m_latestResult;
+}
+
+void
+IncrementalCameraCalibrator::waitForResult(CameraCalibrationResult &out_result) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_condition.wait(lock, [this] {
+        return m_bExitSignaled || m_latestResult.board_count == static_cast<int>(m_boards.size());
+    });
+    out_result = m_latestResult;
+}
+
+void
+IncrementalCameraCalibrator::solverFunc()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        m_condition.wait(lock, [this] {
+            return m_bExitSignaled || m_latestResult.board_count != static_cast<int>(m_boards.size());
+        });
+
+        if (m_bExitSignaled)
+        {
+            break;
+        }
+
+        // Boards added during the solve are picked up by the next pass
+        const int generation = m_solveGeneration;
+        const std::vector<std::vector<cv::Point2f>> image_points_list = m_boards;
+        CameraCalibrationResult result = m_latestResult;
+        lock.unlock();
+
+        solve_camera_calibration(m_objectPoints, image_points_list, m_frameSize, result);
+
+        lock.lock();
+        if (generation == m_solveGeneration)
+        {
+            m_latestResult = result;
+        }
+        m_condition.notify_all();
+    }
+}
+
+//-- private functions -----
+static CameraCalibrationResult make_calibration_result(
+    const cv::Matx33d &intrinsic_matrix, const cv::Vec<double, 5> &distortion_coeffs)
+{
+    CameraCalibrationResult result;
+
+    result.intrinsic_matrix = intrinsic_matrix;
+    result.distortion_coeffs = distortion_coeffs;
+    result.reprojection_error = 0.0;
+    result.board_count = 0;
+
+    return result;
+}
+
+static void solve_camera_calibration(
+    const std::vector<cv::Point3f> &object_points,
+    const std::vector<std::vector<cv::Point2f>> &image_points_list,
+    const cv::Size &frame_size,
+    CameraCalibrationResult &in_out_result)
+{
+    const int board_count = static_cast<int>(image_points_list.size());
+    const std::vector<std::vector<cv::Point3f>> object_points_list(board_count, object_points);
+    cv::Mat intrinsic_matrix(in_out_result.intrinsic_matrix);
+    cv::Mat distortion_coeffs(in_out_result.distortion_coeffs);
+
+    // The first solve starts from the board homographies like a one shot calibration would,
+    // every later one from the previous solution, which usually converges in a few iterations
+    int flags = cv::CALIB_FIX_ASPECT_RATIO;
+    if (in_out_result.board_count > 0)
+    {
+        flags |= cv::CALIB_USE_INTRINSIC_GUESS;
+    }
+    if (board_count < k_min_boards_for_full_model)
+    {
+        flags |= cv::CALIB_FIX_PRINCIPAL_POINT | cv::CALIB_FIX_K3;
+    }
+
+    try
+    {
+        const double reprojection_error =
+            cv::calibrateCamera(
+                object_points_list, image_points_list,
+                frame_size,
+                intrinsic_matrix, distortion_coeffs, // Output we care about
+                cv::noArray(), cv::noArray(), // best fit board poses as rvec/tvec pairs
+                flags,
+                cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, DBL_EPSILON));
+
+        in_out_result.intrinsic_matrix = intrinsic_matrix;
+        in_out_result.distortion_coeffs = distortion_coeffs;
+        in_out_result.reprojection_error = reprojection_error;
+    }
+    catch (const cv::Exception &)
+    {
+        // Degenerate board set (e.g. all boards parallel), keep the previous solution
+    }
+
+    // Either way these boards have been dealt with
+    in_out_result.board_count = board_count;
+}
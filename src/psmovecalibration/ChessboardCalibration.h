@@ -0,0 +1,158 @@
+#ifndef CHESSBOARD_CALIBRATION_H
+#define CHESSBOARD_CALIBRATION_H
+
+//-- includes -----
+#include "opencv2/core/core.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-- definitions -----
+struct ChessboardPattern
+{
+    int corners_wide; // internal corners
+    int corners_high;
+    float square_length_mm;
+
+    inline int getCornerCount() const
+    {
+        return corners_wide*corners_high;
+    }
+
+    inline cv::Size getSize() const
+    {
+        return cv::Size(corners_wide, corners_high);
+    }
+
+    // Board corner positions in the board plane (z=0), row major like the detected corners
+    void computeObjectPoints(std::vector<cv::Point3f> &out_object_points) const;
+};
+
+struct ChessboardDetection
+{
+    int frame_index; // as returned by ChessboardDetectorPool::submitFrame
+    bool bFound;
+    std::vector<cv::Point2f> corners; // full resolution pixels, subpixel refined
+};
+
+struct CameraCalibrationResult
+{
+    cv::Matx33d intrinsic_matrix;
+    cv::Vec<double, 5> distortion_coeffs; // k1, k2, p1, p2, k3 (OpenCV order)
+    double reprojection_error; // rms px over every board in the solve
+    int board_count; // boards the solve used
+};
+
+//-- interface -----
+// Finds the chessboard on a downscaled copy of the frame, then refines the corners
+// against the full resolution frame.
+// * max_detection_width is the width the frame is shrunk to for the search (<= 0 for no downscale)
+// * Returns false if the whole pattern wasn't found
+bool chessboard_find_corners(
+    const cv::Mat &gray_frame,
+    const ChessboardPattern &pattern,
+    const int max_detection_width,
+    std::vector<cv::Point2f> &out_corners);
+
+// True if every row of corners lies within tolerance_px of the line through its end corners
+bool chessboard_are_grid_lines_straight(
+    const ChessboardPattern &pattern,
+    const std::vector<cv::Point2f> &corners,
+    const float tolerance_px);
+
+// Sum over all corners of the distance between corresponding corners of two detections
+float chessboard_compute_corner_distance_sum(
+    const std::vector<cv::Point2f> &corners_a,
+    const std::vector<cv::Point2f> &corners_b);
+
+// Runs chessboard_find_corners on a pool of worker threads so the caller never waits on it.
+// Frames submitted while every worker is busy are dropped, the detections come back
+// newest first and any older detection finishing late is discarded.
+class ChessboardDetectorPool
+{
+public:
+    ChessboardDetectorPool(const ChessboardPattern &pattern, int worker_count, int max_detection_width);
+    virtual ~ChessboardDetectorPool();
+
+    // Copies the frame to an idle worker.
+    // Returns the frame index the detection will carry or -1 if the frame was dropped.
+    int submitFrame(const cv::Mat &gray_frame);
+
+    // Returns true if a detection newer than the last one polled is ready
+    bool pollDetection(ChessboardDetection &out_detection);
+
+private:
+    struct Worker
+    {
+        std::thread thread;
+        cv::Mat frame;
+        int frame_index;
+        bool bHasFrame;
+    };
+
+    void workerFunc(Worker *worker);
+
+    const ChessboardPattern m_pattern;
+    const int m_maxDetectionWidth;
+    std::vector<Worker *> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_bExitSignaled;
+    int m_nextFrameIndex;
+    int m_lastPolledFrameIndex;
+    bool m_bHasDetection;
+    ChessboardDetection m_latestDetection;
+};
+
+// Camera intrinsics and distortion that are re-solved on a background thread every time
+// a board is added, warm started from the previous solution.
+// The solution is only ever a board or two behind the capture, so the result is ready
+// (nearly) as soon as the last board is accepted.
+class IncrementalCameraCalibrator
+{
+public:
+    IncrementalCameraCalibrator(
+        const ChessboardPattern &pattern,
+        const cv::Size &frame_size,
+        const cv::Matx33d &initial_intrinsic_matrix,
+        const cv::Vec<double, 5> &initial_distortion_coeffs);
+    virtual ~IncrementalCameraCalibrator();
+
+    // Forget every board and go back to the initial calibration
+    void reset();
+
+    // Adds a board and schedules a re-solve
+    void addBoard(const std::vector<cv::Point2f> &corners);
+
+    int getBoardCount() const;
+
+    // True while some added board isn't in the latest result yet
+    bool getIsSolving() const;
+
+    // Latest solution, or the initial calibration (with board_count 0) before the first solve
+    void getLatestResult(CameraCalibrationResult &out_result) const;
+
+    // Blocks until every added board is in the result
+    void waitForResult(CameraCalibrationResult &out_result) const;
+
+private:
+    void solverFunc();
+
+    const ChessboardPattern m_pattern;
+    const cv::Size m_frameSize;
+    const CameraCalibrationResult m_initialResult;
+    std::vector<cv::Point3f> m_objectPoints;
+
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_condition;
+    std::vector<std::vector<cv::Point2f>> m_boards;
+    CameraCalibrationResult m_latestResult;
+    int m_solveGeneration; // bumped by reset() so a solve in flight can't publish stale results
+    bool m_bExitSignaled;
+    std::thread m_thread;
+};
+
+#endif // CHESSBOARD_CALIBRATION_H
@@ -18,6 +18,15 @@
 // The max length of the service version string
 #define PSMOVESERVICE_MAX_VERSION_STRING_LEN 32
 
+// The max number of (stage, device) entries returned in the service statistics
+#define PSMOVESERVICE_MAX_STATISTICS_ENTRY_COUNT 64
+
+// The max length of a service statistics stage name
+#define PSMOVESERVICE_MAX_STATISTICS_STAGE_NAME_LEN 32
+
+// The max length of a service trace dump filename
+#define PSMOVESERVICE_MAX_TRACE_FILENAME_LEN 256
+
 // Defines a standard _PAUSE function
 #if __cplusplus >= 199711L  // if C++11
     #include <thread>
@@ -5,6 +5,12 @@
 #include "PSMoveClient_export.h"
 #include <boost/system/error_code.hpp>
 
+//-- pre-declarations -----
+namespace PSMoveProtocol
+{
+	class DeviceOutputDataFrame;
+};
+
 //-- interface -----
 class PSM_CPP_PRIVATE_CLASS IClientNetworkEventListener
 {
@@ -16,4 +22,14 @@ public:
 	virtual void handle_server_connection_socket_error(const boost::system::error_code& ec) = 0;
 };
 
+// Gets data frames on the client I/O thread the moment they're decoded.
+// The same frames still reach the IDataFrameListener on the next update().
+class PSM_CPP_PRIVATE_CLASS IDataFrameThreadListener
+{
+public:
+	virtual void handle_data_frame_on_io_thread(
+		const PSMoveProtocol::DeviceOutputDataFrame *data_frame, 
+		long long received_time_usec) = 0;
+};
+
 #endif // CLIENT_NETWORK_INTERFACE_H
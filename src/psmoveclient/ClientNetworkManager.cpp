@@ -1,12 +1,17 @@
 //-- includes -----
 #include "ClientNetworkManager.h"
 #include "ClientLog.h"
+#include "DataFrameParser.h"
 #include "PackedMessage.h"
 #include "PSMoveProtocol.pb.h"
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <vector>
 #include <deque>
 #include <boost/asio.hpp>
@@ -14,6 +19,16 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/cstdint.hpp>
 
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <errno.h>
+#define CLIENT_NETWORK_USE_RECVMMSG
+#endif
+
+#if !defined(_WIN32)
+#include <sys/select.h>
+#endif
+
 //-- pre-declarations -----
 using namespace std;
 namespace asio = boost::asio;
@@ -21,6 +36,17 @@ using asio::ip::tcp;
 using asio::ip::udp;
 using boost::uint8_t;
 
+//-- constants -----
+// Most data frames pulled off the UDP socket per receive call
+static const int k_max_data_frames_per_receive = 16;
+
+// How long the data frame thread waits on the socket before checking whether it should exit
+static const int k_data_frame_thread_wait_ms = 10;
+
+// Data frames read on the data frame thread wait here until the next update().
+// Past this, frames get dropped rather than growing without bound when update() isn't called.
+static const size_t k_max_received_data_frame_bytes = 64*1024;
+
 //-- implementation -----
 
 // -ClientNetworkManagerImpl-
@@ -53,9 +79,24 @@ public:
         , m_response_read_buffer()
         , m_packed_response(std::shared_ptr<PSMoveProtocol::Response>(new PSMoveProtocol::Response()))
 
-        , m_packed_output_data_frame(std::shared_ptr<PSMoveProtocol::DeviceOutputDataFrame>(new PSMoveProtocol::DeviceOutputDataFrame()))
+        , m_output_data_frame_parser()
+
+        , m_data_frame_thread_listener(nullptr)
+        , m_data_frame_thread()
+        , m_data_frame_thread_mutex()
+        , m_data_frame_thread_wake()
+        , m_data_frame_thread_reading(false)
+        , m_data_frame_thread_exit(false)
+        , m_received_data_frame_mutex()
+        , m_received_data_frames()
+        , m_has_dropped_data_frames(false)
+        , m_data_frame_thread_error()
+        , m_polled_data_frames()
+        , m_polled_data_frame_parser()
     
-        , m_write_bufer()
+        , m_write_buffers()
+        , m_gather_write_buffers()
+        , m_writing_request_count(0)
         , m_packed_request()
 
         , m_data_frame_listener(dataFrameListener)
@@ -64,7 +105,33 @@ public:
         , m_netEventListener(netEventListener)
         , m_pending_requests()
     {
-        memset(m_output_data_frame_buffer, 0, sizeof(m_output_data_frame_buffer));
+        memset(m_output_data_frame_buffers, 0, sizeof(m_output_data_frame_buffers));
+
+#if defined(CLIENT_NETWORK_USE_RECVMMSG)
+        // Each batch slot receives straight into its own data frame buffer
+        memset(m_output_data_frame_headers, 0, sizeof(m_output_data_frame_headers));
+        for (int frame_index = 0; frame_index < k_max_data_frames_per_receive; ++frame_index)
+        {
+            m_output_data_frame_iovecs[frame_index].iov_base = m_output_data_frame_buffers[frame_index];
+            m_output_data_frame_iovecs[frame_index].iov_len = sizeof(m_output_data_frame_buffers[frame_index]);
+            m_output_data_frame_headers[frame_index].msg_hdr.msg_iov = &m_output_data_frame_iovecs[frame_index];
+            m_output_data_frame_headers[frame_index].msg_hdr.msg_iovlen = 1;
+        }
+#endif
+    }
+
+    virtual ~ClientNetworkManagerImpl()
+    {
+        if (m_data_frame_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_data_frame_thread_mutex);
+                m_data_frame_thread_exit= true;
+            }
+
+            m_data_frame_thread_wake.notify_one();
+            m_data_frame_thread.join();
+        }
     }
 
     bool start()
@@ -93,8 +160,27 @@ public:
         start_udp_queued_data_frame_write();
     }
 
+    void start_data_frame_thread(IDataFrameThreadListener *listener)
+    {
+        if (m_data_frame_thread_listener == nullptr)
+        {
+            m_data_frame_thread_listener= listener;
+            m_data_frame_thread_reading= m_has_pending_udp_read;
+            m_data_frame_thread= std::thread(&ClientNetworkManagerImpl::data_frame_thread_func, this);
+
+            // If data frames were already being read through the io_service the thread takes over right away.
+            // The read still pending there won't read anything once it completes.
+        }
+    }
+
     void poll()
     {
+        // Forward the data frames the data frame thread read since the last poll
+        if (m_data_frame_thread_listener != nullptr)
+        {
+            dispatch_received_data_frames();
+        }
+
         bool keep_polling = true;
         int iteration_count = 0;
         const static int k_max_iteration_count = 32;
@@ -168,8 +254,21 @@ public:
         m_connection_stopped= true;
         m_has_pending_tcp_read= false;
         m_has_pending_tcp_write= false;
+        m_writing_request_count= 0;
         m_has_pending_udp_read = false;
         m_has_pending_udp_write = false;
+
+        // Waits for the data frame thread to finish any read in progress
+        {
+            std::lock_guard<std::mutex> lock(m_data_frame_thread_mutex);
+            m_data_frame_thread_reading= false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_received_data_frame_mutex);
+            m_received_data_frames.clear();
+            m_data_frame_thread_error.clear();
+        }
     }
 
 private:
@@ -526,18 +625,30 @@ private:
 
         if (m_pending_requests.size() > 0 && !m_has_pending_tcp_write)
         {
-            RequestPtr request= m_pending_requests[0];
+            // Everything queued so far goes out in a single gather write
+            const size_t request_count= m_pending_requests.size();
+
+            if (m_write_buffers.size() < request_count)
+            {
+                m_write_buffers.resize(request_count);
+            }
+            m_gather_write_buffers.clear();
 
-            m_packed_request.set_msg(request);
-            m_packed_request.pack(m_write_bufer);
+            for (size_t request_index= 0; request_index < request_count; ++request_index)
+            {
+                m_packed_request.set_msg(m_pending_requests[request_index]);
+                m_packed_request.pack(m_write_buffers[request_index]);
+                m_gather_write_buffers.push_back(boost::asio::buffer(m_write_buffers[request_index]));
+            }
 
-            // The queue should prevent us from writing more than one request as once
+            // The queue should prevent us from starting a write while one is in flight
             m_has_pending_tcp_write= true;
+            m_writing_request_count= request_count;
 
-            // Start an asynchronous operation to send a heartbeat message.
+            // Start an asynchronous operation to send the requests.
             boost::asio::async_write(
                 m_tcp_socket, 
-                boost::asio::buffer(m_write_bufer),
+                m_gather_write_buffers,
                 boost::bind(&ClientNetworkManagerImpl::handle_tcp_write_request_complete, this, _1));
         }
     }
@@ -552,8 +663,9 @@ private:
             // no longer is there a pending write
             m_has_pending_tcp_write= false;
 
-            // Remove the request from the pending send queue not that it's sent
-            m_pending_requests.pop_front();
+            // Remove the requests from the pending send queue now that they're sent
+            m_pending_requests.erase(m_pending_requests.begin(), m_pending_requests.begin() + m_writing_request_count);
+            m_writing_request_count= 0;
             
             // Start listening for the response
             start_tcp_read_response_header();
@@ -641,80 +753,328 @@ private:
     {
         if (!m_has_pending_udp_read)
         {
-            m_has_pending_udp_read= true;
-            m_udp_socket.async_receive_from(
-                asio::buffer(m_output_data_frame_buffer, sizeof(m_output_data_frame_buffer)),
-                m_udp_server_endpoint,
-                boost::bind(
-                    &ClientNetworkManagerImpl::handle_udp_read_data_frame, 
-                    this,
-                    asio::placeholders::error));
+            boost::system::error_code error;
+
+            // Data frames are pulled off the socket synchronously once it's readable,
+            // so those reads must never block
+            m_udp_socket.non_blocking(true, error);
+            if (error)
+            {
+                CLIENT_LOG_ERROR("ClientNetworkManager::start_udp_read_data_frame") 
+                    << "Failed to make UDP socket non-blocking: "  << error.message() << std::endl;
+            }
+
+            if (m_data_frame_thread_listener != nullptr)
+            {
+                // The data frame thread does all the reading from here on
+                {
+                    std::lock_guard<std::mutex> lock(m_data_frame_thread_mutex);
+                    m_data_frame_thread_reading= true;
+                }
+
+                m_data_frame_thread_wake.notify_one();
+            }
+            else
+            {
+                // Only wait for the socket to become readable.
+                // The data frames themselves get read in batches by receive_udp_data_frames().
+                m_has_pending_udp_read= true;
+                m_udp_socket.async_receive_from(
+                    asio::null_buffers(),
+                    m_udp_remote_endpoint,
+                    boost::bind(
+                        &ClientNetworkManagerImpl::handle_udp_read_data_frame, 
+                        this,
+                        asio::placeholders::error));
+            }
         }
     }
 
-    void handle_udp_read_data_frame(const boost::system::error_code& error)
+    void handle_udp_read_data_frame(boost::system::error_code error)
     {
         if (m_connection_stopped)
             return;
 
-        if (!error)
-        {
-            CLIENT_LOG_DEBUG("ClientNetworkManager::handle_udp_read_data_frame") << "Received DataFrame" << std::endl;
+        // No longer is there a pending read
+        m_has_pending_udp_read= false;
 
-            // Process the data frame now that we have received all of it
-            handle_udp_data_frame_received();
+        if (!error && m_data_frame_thread_listener == nullptr)
+        {
+            // Drain every data frame waiting on the socket,
+            // rather than taking one frame per io_service::poll()
+            receive_udp_data_frames(error);
+        }
 
-            // Start reading the next incoming data frame
+        if (!error)
+        {
+            // Wait for the next batch of incoming data frames
+            // (or hand the socket to the data frame thread if it has started since)
             start_udp_read_data_frame();
         }
         else
         {
-            CLIENT_LOG_ERROR("ClientNetworkManager::handle_tcp_write_request_complete") 
-                << "Error on receive: "  << error.message() << std::endl;
-            stop();
+            handle_udp_read_data_frame_error(error);
+        }
+    }
 
-            if (m_netEventListener)
+    void handle_udp_read_data_frame_error(const boost::system::error_code &error)
+    {
+        CLIENT_LOG_ERROR("ClientNetworkManager::handle_udp_read_data_frame_error") 
+            << "Error on receive: "  << error.message() << std::endl;
+        stop();
+
+        if (m_netEventListener)
+        {
+            m_netEventListener->handle_server_connection_socket_error(error);
+        }
+    }
+
+    // Reads data frames until the socket would block.
+    // A socket error or a malformed data frame stops the reading and is returned in out_error.
+    //###HipsterSloth $TODO pick a better error code that means "malformed data" than message_size
+    void receive_udp_data_frames(boost::system::error_code &out_error)
+    {
+        for (;;)
+        {
+#if defined(CLIENT_NETWORK_USE_RECVMMSG)
+            // Pull up to a whole batch of datagrams off the socket with one system call
+            const int frame_count = 
+                recvmmsg(
+                    m_udp_socket.native_handle(),
+                    m_output_data_frame_headers,
+                    k_max_data_frames_per_receive,
+                    MSG_DONTWAIT,
+                    nullptr);
+
+            if (frame_count < 0)
             {
-                m_netEventListener->handle_server_connection_socket_error(error);
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    out_error = boost::system::error_code(errno, asio::error::get_system_category());
+                }
+
+                break;
+            }
+
+            const long long received_time_usec = get_current_time_usec();
+
+            for (int frame_index = 0; frame_index < frame_count; ++frame_index)
+            {
+                const mmsghdr &header = m_output_data_frame_headers[frame_index];
+
+                if ((header.msg_hdr.msg_flags & MSG_TRUNC) != 0)
+                {
+                    CLIENT_LOG_WARNING("ClientNetworkManager::receive_udp_data_frames") 
+                        << "Dropping oversized data frame (" << header.msg_len << " bytes)" << std::endl;
+                }
+                else if (!handle_udp_data_frame_received(m_output_data_frame_buffers[frame_index], header.msg_len, received_time_usec))
+                {
+                    out_error = asio::error::message_size;
+                    return;
+                }
+            }
+
+            // A partial batch means the socket has been drained
+            if (frame_count < k_max_data_frames_per_receive)
+            {
+                break;
+            }
+#else
+            boost::system::error_code error;
+            const size_t bytes_received = 
+                m_udp_socket.receive_from(
+                    asio::buffer(m_output_data_frame_buffers[0], sizeof(m_output_data_frame_buffers[0])),
+                    m_udp_remote_endpoint,
+                    0,
+                    error);
+
+            if (error)
+            {
+                if (error != asio::error::would_block)
+                {
+                    out_error = error;
+                }
+
+                break;
             }
+
+            if (!handle_udp_data_frame_received(m_output_data_frame_buffers[0], static_cast<unsigned>(bytes_received), get_current_time_usec()))
+            {
+                out_error = asio::error::message_size;
+                break;
+            }
+#endif
         }
     }
 
-    // Called when enough data was read into m_data_frame_read_buffer for a complete data frame message. 
-    // Parse the data_frame and forward it on to the response handler.
-    void handle_udp_data_frame_received()
+    // Called for each complete data frame datagram received.
+    // Parse the data_frame in place and forward it on to the data frame listener,
+    // or to the thread listener when running on the data frame thread.
+    bool handle_udp_data_frame_received(const uint8_t *packed_data_frame, unsigned packed_size, long long received_time_usec)
     {
-        // No longer is there a pending read
-        m_has_pending_udp_read= false;
-
         CLIENT_LOG_DEBUG("ClientNetworkManager::handle_udp_data_frame_received") << "Parsing DataFrame" << std::endl;
-        
-        // TODO: Switch on data frame type to choose which m_packed_data_frame_X to use.
-        unsigned msg_len = m_packed_output_data_frame.decode_header(m_output_data_frame_buffer, sizeof(m_output_data_frame_buffer));
-        unsigned total_len= HEADER_SIZE+msg_len;
-        CLIENT_LOG_DEBUG("    ") << show_hex(m_output_data_frame_buffer, total_len) << std::endl;
-        CLIENT_LOG_DEBUG("    ") << msg_len << " bytes" << std::endl;
+        CLIENT_LOG_DEBUG("    ") << show_hex(packed_data_frame, packed_size) << std::endl;
+        CLIENT_LOG_DEBUG("    ") << packed_size << " bytes" << std::endl;
 
-        // Parse the response buffer
-        if (m_packed_output_data_frame.unpack(m_output_data_frame_buffer, total_len))
+        // The parsed frame lives on the parser's arena and is only valid until the next parse
+        const PSMoveProtocol::DeviceOutputDataFrame *data_frame = 
+            m_output_data_frame_parser.parse(packed_data_frame, packed_size);
+
+        if (data_frame == nullptr)
+        {
+            CLIENT_LOG_ERROR("ClientNetworkManager::handle_udp_data_frame_received") << "Error malformed response" << std::endl;
+            return false;
+        }
+
+        if (m_data_frame_thread_listener != nullptr)
         {
-            const PSMoveProtocol::DeviceOutputDataFrame *data_frame = m_packed_output_data_frame.get_msg().get();
+            m_data_frame_thread_listener->handle_data_frame_on_io_thread(data_frame, received_time_usec);
 
-            m_data_frame_listener->handle_data_frame(data_frame);
+            // Keep the packed frame for the IDataFrameListener on the next poll()
+            queue_received_data_frame(
+                packed_data_frame, 
+                DeviceOutputDataFrameParser::get_packed_size(packed_data_frame, packed_size));
         }
         else
         {
-            CLIENT_LOG_ERROR("ClientNetworkManager::handle_udp_data_frame_received") << "Error malformed response" << std::endl;
-            stop();
+            m_data_frame_listener->handle_data_frame(data_frame);
+        }
 
-            if (m_netEventListener)
+        return true;
+    }
+
+    // -- Data frame thread -----
+    void data_frame_thread_func()
+    {
+        std::unique_lock<std::mutex> lock(m_data_frame_thread_mutex);
+
+        while (!m_data_frame_thread_exit)
+        {
+            if (!m_data_frame_thread_reading)
             {
-                //###HipsterSloth $TODO pick a better error code that means "malformed data"
-                m_netEventListener->handle_server_connection_socket_error(boost::asio::error::message_size);
+                m_data_frame_thread_wake.wait(lock);
+                continue;
+            }
+
+            // Don't hold up stop() while waiting on the socket
+            lock.unlock();
+            const bool bIsReadable= wait_for_udp_data_frame(k_data_frame_thread_wait_ms);
+            lock.lock();
+
+            // stop() may have been called while we were waiting
+            if (bIsReadable && m_data_frame_thread_reading && !m_data_frame_thread_exit)
+            {
+                boost::system::error_code error;
+                receive_udp_data_frames(error);
+
+                if (error)
+                {
+                    // Reported from the next poll(), since only that thread may stop the connection
+                    m_data_frame_thread_reading= false;
+
+                    std::lock_guard<std::mutex> received_lock(m_received_data_frame_mutex);
+                    m_data_frame_thread_error= error;
+                }
             }
         }
     }
 
+    bool wait_for_udp_data_frame(int timeout_ms)
+    {
+        const auto udp_handle= m_udp_socket.native_handle();
+
+        fd_set read_set;
+        FD_ZERO(&read_set);
+        FD_SET(udp_handle, &read_set);
+
+        timeval timeout;
+        timeout.tv_sec= 0;
+        timeout.tv_usec= timeout_ms * 1000;
+
+        // The first argument is ignored on Windows
+        return select(static_cast<int>(udp_handle) + 1, &read_set, nullptr, nullptr, &timeout) > 0;
+    }
+
+    void queue_received_data_frame(const uint8_t *packed_data_frame, unsigned frame_size)
+    {
+        std::lock_guard<std::mutex> lock(m_received_data_frame_mutex);
+
+        if (m_received_data_frames.size() + frame_size > k_max_received_data_frame_bytes)
+        {
+            // Drop the oldest whole frames so the latest device state still reaches the next update
+            size_t drop_size= 0;
+            while (drop_size < m_received_data_frames.size() &&
+                   m_received_data_frames.size() - drop_size + frame_size > k_max_received_data_frame_bytes)
+            {
+                const unsigned remaining_size= static_cast<unsigned>(m_received_data_frames.size() - drop_size);
+                const unsigned queued_frame_size= 
+                    DeviceOutputDataFrameParser::get_packed_size(m_received_data_frames.data() + drop_size, remaining_size);
+
+                // Frames were checked when they were queued, but never spin on a bad size
+                drop_size= (queued_frame_size > 0) ? drop_size + queued_frame_size : m_received_data_frames.size();
+            }
+
+            m_received_data_frames.erase(m_received_data_frames.begin(), m_received_data_frames.begin() + drop_size);
+
+            if (!m_has_dropped_data_frames)
+            {
+                CLIENT_LOG_WARNING("ClientNetworkManager::queue_received_data_frame") 
+                    << "Dropping the oldest data frames until the next update" << std::endl;
+                m_has_dropped_data_frames= true;
+            }
+        }
+        else
+        {
+            m_has_dropped_data_frames= false;
+        }
+
+        m_received_data_frames.insert(m_received_data_frames.end(), packed_data_frame, packed_data_frame + frame_size);
+    }
+
+    void dispatch_received_data_frames()
+    {
+        boost::system::error_code error;
+
+        // Swap rather than copy so neither buffer gives back its memory
+        m_polled_data_frames.clear();
+        {
+            std::lock_guard<std::mutex> lock(m_received_data_frame_mutex);
+            m_polled_data_frames.swap(m_received_data_frames);
+            error= m_data_frame_thread_error;
+            m_data_frame_thread_error.clear();
+        }
+
+        // These were already checked when they were read
+        size_t offset= 0;
+        while (offset < m_polled_data_frames.size())
+        {
+            const uint8_t *packed_data_frame= m_polled_data_frames.data() + offset;
+            const unsigned remaining_size= static_cast<unsigned>(m_polled_data_frames.size() - offset);
+            const unsigned frame_size= DeviceOutputDataFrameParser::get_packed_size(packed_data_frame, remaining_size);
+            const PSMoveProtocol::DeviceOutputDataFrame *data_frame= 
+                m_polled_data_frame_parser.parse(packed_data_frame, frame_size);
+
+            assert(data_frame != nullptr);
+            m_data_frame_listener->handle_data_frame(data_frame);
+            offset+= frame_size;
+        }
+
+        if (error && !m_connection_stopped)
+        {
+            handle_udp_read_data_frame_error(error);
+        }
+    }
+
+    static long long get_current_time_usec()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
 private:
     std::string m_server_host;
     std::string m_server_port;
@@ -737,13 +1097,35 @@ private:
     vector<uint8_t> m_response_read_buffer;
     PackedMessage<PSMoveProtocol::Response> m_packed_response;
 
-    uint8_t m_output_data_frame_buffer[HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
-    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> m_packed_output_data_frame;
+    uint8_t m_output_data_frame_buffers[k_max_data_frames_per_receive][HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
+#if defined(CLIENT_NETWORK_USE_RECVMMSG)
+    mmsghdr m_output_data_frame_headers[k_max_data_frames_per_receive];
+    iovec m_output_data_frame_iovecs[k_max_data_frames_per_receive];
+#endif
+    DeviceOutputDataFrameParser m_output_data_frame_parser;
+
+    // The data frame thread. Once started it does all the reads from the UDP socket.
+    IDataFrameThreadListener *m_data_frame_thread_listener;
+    std::thread m_data_frame_thread;
+    std::mutex m_data_frame_thread_mutex; // held while the thread reads, guards the flags below
+    std::condition_variable m_data_frame_thread_wake;
+    bool m_data_frame_thread_reading;
+    bool m_data_frame_thread_exit;
+
+    // Frames and errors from the data frame thread waiting for the next poll()
+    std::mutex m_received_data_frame_mutex;
+    data_buffer m_received_data_frames; // packed frames back to back
+    bool m_has_dropped_data_frames;
+    boost::system::error_code m_data_frame_thread_error;
+    data_buffer m_polled_data_frames;
+    DeviceOutputDataFrameParser m_polled_data_frame_parser;
 
     uint8_t m_input_data_frame_buffer[HEADER_SIZE + MAX_INPUT_DATA_FRAME_MESSAGE_SIZE];
     PackedMessage<PSMoveProtocol::DeviceInputDataFrame> m_packed_input_data_frame;
     
-    vector<uint8_t> m_write_bufer;
+    vector<data_buffer> m_write_buffers;
+    vector<asio::const_buffer> m_gather_write_buffers;
+    size_t m_writing_request_count; // requests at the front of m_pending_requests being written
     PackedMessage<PSMoveProtocol::Request> m_packed_request;
 
     IDataFrameListener *m_data_frame_listener;
@@ -810,3 +1192,8 @@ void ClientNetworkManager::shutdown()
     m_implementation_ptr->stop();
     m_instance = NULL;
 }
+
+void ClientNetworkManager::start_data_frame_thread(IDataFrameThreadListener *listener)
+{
+    m_implementation_ptr->start_data_frame_thread(listener);
+}
@@ -29,6 +29,10 @@ public:
     void update();
     void shutdown();
 
+    // Moves data frame reads onto a client owned I/O thread that hands each frame to the given listener.
+    // The thread runs until the network manager is destroyed.
+    void start_data_frame_thread(IDataFrameThreadListener *listener);
+
 private:
     // Must use the overloaded constructor
     ClientNetworkManager();
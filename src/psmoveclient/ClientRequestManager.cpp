@@ -30,6 +30,7 @@ public:
         , m_callback_userdata(userdata)
         , m_pending_requests()
         , m_next_request_id(0)
+        , m_request_batch()
     {
     }
 
@@ -56,17 +57,79 @@ public:
         assert(m_pending_requests.find(request->request_id()) == m_pending_requests.end());
         m_pending_requests.insert(t_id_request_context_pair(request->request_id(), context));
 
-        // Send the request off to the network manager to get sent to the server
-        ClientNetworkManager::get_instance()->send_request(request);
+        if (m_request_batch)
+        {
+            // Held back until send_request_batch()
+            m_request_batch->mutable_request_batch()->add_requests()->CopyFrom(*request);
+        }
+        else
+        {
+            // Send the request off to the network manager to get sent to the server
+            ClientNetworkManager::get_instance()->send_request(request);
+        }
+    }
+
+    bool begin_request_batch()
+    {
+        if (m_request_batch)
+        {
+            // Batches don't nest
+            return false;
+        }
+
+        m_request_batch = RequestPtr(new PSMoveProtocol::Request());
+        m_request_batch->set_type(PSMoveProtocol::Request_RequestType_REQUEST_BATCH);
+        m_request_batch->set_request_id(-1); // Each batched request gets its own response, the batch none
+
+        return true;
+    }
+
+    bool send_request_batch()
+    {
+        if (!m_request_batch)
+        {
+            return false;
+        }
+
+        RequestPtr request_batch = m_request_batch;
+        m_request_batch.reset();
+
+        if (request_batch->request_batch().requests_size() > 0)
+        {
+            ClientNetworkManager::get_instance()->send_request(request_batch);
+        }
+
+        return true;
+    }
+
+    bool get_is_batching_requests() const
+    {
+        return static_cast<bool>(m_request_batch);
     }
 
     void handle_request_canceled(RequestPtr request)
+    {
+        if (request->type() == PSMoveProtocol::Request_RequestType_REQUEST_BATCH)
+        {
+            // Every request in the batch is waiting on its own response
+            for (const PSMoveProtocol::Request &batched_request : request->request_batch().requests())
+            {
+                handle_request_id_canceled(batched_request.request_id());
+            }
+        }
+        else
+        {
+            handle_request_id_canceled(request->request_id());
+        }
+    }
+
+    void handle_request_id_canceled(int request_id)
     {
         // Create a general canceled result
         ResponsePtr response(new PSMoveProtocol::Response);
 
         response->set_type(PSMoveProtocol::Response_ResponseType_GENERAL_RESULT);
-        response->set_request_id(request->request_id());
+        response->set_request_id(request_id);
         response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_CANCELED);
 
         handle_response(response);
@@ -162,6 +225,18 @@ public:
                 build_service_version_response_message(response, &out_response_message->payload.service_version);
                 out_response_message->payload_type = PSMResponseMessage::_responsePayloadType_ServiceVersion;
                 break;
+            case PSMoveProtocol::Response_ResponseType_SERVICE_STATISTICS:
+                // Too large for the payload union, see PSM_GetServiceStatisticsFromResponse
+                out_response_message->payload_type = PSMResponseMessage::_responsePayloadType_ServiceStatistics;
+                break;
+            case PSMoveProtocol::Response_ResponseType_TRACE_DUMPED:
+                build_service_trace_dump_response_message(response, &out_response_message->payload.service_trace_dump);
+                out_response_message->payload_type = PSMResponseMessage::_responsePayloadType_ServiceTraceDump;
+                break;
+            case PSMoveProtocol::Response_ResponseType_TRACKER_BUNDLE_ADJUSTMENT_RESULT:
+                build_tracker_bundle_adjustment_response_message(response, &out_response_message->payload.tracker_bundle_adjustment);
+                out_response_message->payload_type = PSMResponseMessage::_responsePayloadType_TrackerBundleAdjustment;
+                break;
             case PSMoveProtocol::Response_ResponseType_CONTROLLER_LIST:
                 build_controller_list_response_message(response, &out_response_message->payload.controller_list);
                 out_response_message->payload_type = PSMResponseMessage::_responsePayloadType_ControllerList;
@@ -194,6 +269,51 @@ public:
 		strncpy(service_version->version_string, VersionResponse.version().c_str(), PSMOVESERVICE_MAX_VERSION_STRING_LEN);
 	}
 
+	void build_service_trace_dump_response_message(
+		ResponsePtr response,
+		PSMServiceTraceDump *service_trace_dump)
+	{
+		const auto &TraceDumpResponse = response->result_trace_dumped();
+
+		strncpy(service_trace_dump->filename, TraceDumpResponse.filename().c_str(), PSMOVESERVICE_MAX_TRACE_FILENAME_LEN);
+		service_trace_dump->filename[PSMOVESERVICE_MAX_TRACE_FILENAME_LEN - 1] = '\0';
+		service_trace_dump->event_count = TraceDumpResponse.event_count();
+	}
+
+	void build_tracker_bundle_adjustment_response_message(
+		ResponsePtr response,
+		PSMTrackerBundleAdjustment *bundle_adjustment)
+	{
+		const auto &BundleAdjustmentResponse = response->result_tracker_bundle_adjustment();
+		int entry_count = 0;
+
+		for (auto it = BundleAdjustmentResponse.tracker_entries().begin();
+			it != BundleAdjustmentResponse.tracker_entries().end() && entry_count < PSMOVESERVICE_MAX_TRACKER_COUNT;
+			++it)
+		{
+			const auto &TrackerResponse = *it;
+			PSMTrackerBundleAdjustmentEntry &entry = bundle_adjustment->trackers[entry_count];
+
+			entry.tracker_id = TrackerResponse.tracker_id();
+			entry.observation_count = TrackerResponse.observation_count();
+			entry.initial_rms_px = TrackerResponse.initial_rms_px();
+			entry.final_rms_px = TrackerResponse.final_rms_px();
+			entry.tracker_pose = protocol_pose_to_psmove_pose(TrackerResponse.tracker_pose());
+			entry.focal_lengths = {TrackerResponse.focal_length_x(), TrackerResponse.focal_length_y()};
+			entry.principal_point = {TrackerResponse.principal_x(), TrackerResponse.principal_y()};
+
+			++entry_count;
+		}
+
+		bundle_adjustment->count = entry_count;
+		bundle_adjustment->sample_count = BundleAdjustmentResponse.sample_count();
+		bundle_adjustment->observation_count = BundleAdjustmentResponse.observation_count();
+		bundle_adjustment->iteration_count = BundleAdjustmentResponse.iteration_count();
+		bundle_adjustment->initial_rms_px = BundleAdjustmentResponse.initial_rms_px();
+		bundle_adjustment->final_rms_px = BundleAdjustmentResponse.final_rms_px();
+		bundle_adjustment->applied = BundleAdjustmentResponse.applied();
+	}
+
     void build_controller_list_response_message(
         ResponsePtr response,
         PSMControllerList *controller_list)
@@ -292,6 +412,12 @@ public:
             case PSMoveProtocol::TrackerType::PS3EYE:
                 TrackerInfo.tracker_type = PSMTracker_PS3Eye;
                 break;
+            case PSMoveProtocol::TrackerType::VIRTUAL_TRACKER:
+                TrackerInfo.tracker_type = PSMTracker_Virtual;
+                break;
+            case PSMoveProtocol::TrackerType::REMOTE_TRACKER:
+                TrackerInfo.tracker_type = PSMTracker_Remote;
+                break;
             default:
                 assert(0 && "unreachable");
             }
@@ -400,6 +526,7 @@ private:
     void *m_callback_userdata;
     t_request_context_map m_pending_requests;
     int m_next_request_id;
+    RequestPtr m_request_batch; // requests sent while a batch is open, null otherwise
 
     // These vectors is used solely to keep the ref counted pointers to the 
     // request/response parameter data valid until the next update call.
@@ -433,6 +560,21 @@ void ClientRequestManager::send_request(
     m_implementation_ptr->send_request(request);
 }
 
+bool ClientRequestManager::begin_request_batch()
+{
+    return m_implementation_ptr->begin_request_batch();
+}
+
+bool ClientRequestManager::send_request_batch()
+{
+    return m_implementation_ptr->send_request_batch();
+}
+
+bool ClientRequestManager::get_is_batching_requests() const
+{
+    return m_implementation_ptr->get_is_batching_requests();
+}
+
 void ClientRequestManager::handle_request_canceled(RequestPtr request)
 {
     m_implementation_ptr->handle_request_canceled(request);
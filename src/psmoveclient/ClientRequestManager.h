@@ -16,6 +16,11 @@ public:
 
     void send_request(RequestPtr request);
 
+    // Requests sent between these two calls go to the service together in one REQUEST_BATCH
+    bool begin_request_batch();
+    bool send_request_batch();
+    bool get_is_batching_requests() const;
+
     virtual void handle_request_canceled(RequestPtr request) override;
     virtual void handle_response(ResponsePtr response) override;
 
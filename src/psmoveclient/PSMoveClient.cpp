@@ -30,6 +30,7 @@ typedef std::vector<ResponsePtr> t_event_reference_cache;
 static void processPSMoveRecenterAction(PSMController *controller);
 static void processDualShock4RecenterAction(PSMController *controller);
 
+static void nullResponseCallback(const PSMResponseMessage *response, void *userdata);
 static void applyControllerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, PSMController *controller);
 static void applyPSMoveDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, PSMPSMove *psmove);
 static void applyPSNaviDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, PSMPSNavi *psnavi);
@@ -38,6 +39,7 @@ static void applyVirtualControllerDataFrame(const PSMoveProtocol::DeviceOutputDa
 static void applyPSMButtonState(PSMButtonState &button, unsigned int button_bitmask, unsigned int button_bit);
 static void applyTrackerDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_TrackerDataPacket& tracker_packet, PSMTracker *tracker);
 static void applyHmdDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMHeadMountedDisplay *hmd);
+static long long getCurrentTimeUsec();
 static void applyMorpheusDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMMorpheus *morpheus);
 static void applyVirtualHMDDataFrame(const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet, PSMVirtualHMD *virtualHMD);
 
@@ -232,6 +234,29 @@ PSMoveClient::PSMoveClient(
 			this, // INotificationListener
 			m_request_manager, // IResponseListener
 			this); // IClientNetworkEventListener
+
+	// No stream limits until a client asks for them
+	memset(m_controller_stream_limits, 0, sizeof(m_controller_stream_limits));
+	memset(m_hmd_stream_limits, 0, sizeof(m_hmd_stream_limits));
+
+	// No data callbacks until a client registers them
+	for (PSMControllerID controller_id= 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+	{
+		ControllerDataCallback &data_callback= m_controller_data_callbacks[controller_id];
+
+		data_callback.callback= nullptr;
+		data_callback.callback_userdata= nullptr;
+		memset(&data_callback.snapshot, 0, sizeof(PSMController));
+		data_callback.bNeedsKeyframe= false;
+	}
+	for (PSMHmdID hmd_id= 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)
+	{
+		HmdDataCallback &data_callback= m_hmd_data_callbacks[hmd_id];
+
+		data_callback.callback= nullptr;
+		data_callback.callback_userdata= nullptr;
+		memset(&data_callback.snapshot, 0, sizeof(PSMHeadMountedDisplay));
+	}
 }
 
 PSMoveClient::~PSMoveClient()
@@ -286,6 +311,24 @@ bool PSMoveClient::pollWasSystemButtonPressed()
 	return bWasSystemButtonPressed; 
 }
 
+bool PSMoveClient::pollHasTrackerPoseDrifted()
+{
+	bool bHasTrackerPoseDrifted= m_bHasTrackerPoseDrifted;
+
+	m_bHasTrackerPoseDrifted= false;
+
+	return bHasTrackerPoseDrifted; 
+}
+
+bool PSMoveClient::pollHasTrackingColorCalibrated()
+{
+	bool bHasTrackingColorCalibrated= m_bHasTrackingColorCalibrated;
+
+	m_bHasTrackingColorCalibrated= false;
+
+	return bHasTrackingColorCalibrated; 
+}
+
 // -- ClientPSMoveAPI System -----
 bool PSMoveClient::startup(e_log_severity_level log_level)
 {
@@ -300,6 +343,8 @@ bool PSMoveClient::startup(e_log_severity_level log_level)
 	m_bHasTrackerListChanged= false;
 	m_bHasHMDListChanged= false;
 	m_bWasSystemButtonPressed = false;
+	m_bHasTrackerPoseDrifted = false;
+	m_bHasTrackingColorCalibrated = false;
 
     // Attempt to connect to the server
     if (success)
@@ -358,6 +403,9 @@ void PSMoveClient::update()
     // Publish modified device state back to the service
     publish();
 
+    // Recover data callbacks that lost track of a delta frame stream
+    request_data_callback_keyframes();
+
     // Process incoming/outgoing networking requests
     m_network_manager->update();
 }
@@ -644,6 +692,45 @@ PSMRequestID PSMoveClient::get_service_version()
     return request->request_id();
 }
 
+PSMRequestID PSMoveClient::get_service_statistics(bool reset_after_read)
+{
+    CLIENT_LOG_INFO("get_service_statistics") << "requesting service statistics" << std::endl;
+
+    RequestPtr request(new PSMoveProtocol::Request());
+    request->set_type(PSMoveProtocol::Request_RequestType_GET_SERVICE_STATISTICS);
+    request->mutable_request_get_service_statistics()->set_reset_after_read(reset_after_read);
+
+    m_request_manager->send_request(request);
+
+    return request->request_id();
+}
+
+PSMRequestID PSMoveClient::set_service_trace_recording(bool enabled)
+{
+    CLIENT_LOG_INFO("set_service_trace_recording") << "requesting service trace recording " << (enabled ? "on" : "off") << std::endl;
+
+    RequestPtr request(new PSMoveProtocol::Request());
+    request->set_type(PSMoveProtocol::Request_RequestType_SET_TRACE_RECORDING);
+    request->mutable_request_set_trace_recording()->set_enabled(enabled);
+
+    m_request_manager->send_request(request);
+
+    return request->request_id();
+}
+
+PSMRequestID PSMoveClient::dump_service_trace(const std::string &filename)
+{
+    CLIENT_LOG_INFO("dump_service_trace") << "requesting service trace dump" << std::endl;
+
+    RequestPtr request(new PSMoveProtocol::Request());
+    request->set_type(PSMoveProtocol::Request_RequestType_DUMP_TRACE);
+    request->mutable_request_dump_trace()->set_filename(filename);
+
+    m_request_manager->send_request(request);
+
+    return request->request_id();
+}
+
 // -- ClientPSMoveAPI Requests -----
 bool PSMoveClient::allocate_controller_listener(PSMControllerID ControllerID)
 {
@@ -707,6 +794,21 @@ PSMRequestID PSMoveClient::get_controller_list()
     return request->request_id();
 }
 
+void PSMoveClient::set_controller_data_stream_limits(PSMControllerID controller_id, const PSMStreamLimits *limits)
+{
+	if (IS_VALID_CONTROLLER_INDEX(controller_id))
+	{
+		if (limits != nullptr)
+		{
+			m_controller_stream_limits[controller_id]= *limits;
+		}
+		else
+		{
+			memset(&m_controller_stream_limits[controller_id], 0, sizeof(PSMStreamLimits));
+		}
+	}
+}
+
 PSMRequestID PSMoveClient::start_controller_data_stream(PSMControllerID controller_id, unsigned int flags)
 {
 	PSMRequestID requestID= PSM_INVALID_REQUEST_ID;
@@ -750,6 +852,23 @@ PSMRequestID PSMoveClient::start_controller_data_stream(PSMControllerID controll
 			request->mutable_request_start_psmove_data_stream()->set_disable_roi(true);
 		}
 
+		if ((flags & PSMStreamFlags_useDeltaFrames) > 0)
+		{
+			request->mutable_request_start_psmove_data_stream()->set_use_delta_frames(true);
+		}
+
+		// Delta frames of an earlier stream don't apply to this one
+		m_controller_frame_decoders[controller_id].reset();
+		{
+			std::lock_guard<std::mutex> lock(m_data_callback_mutex);
+			m_controller_data_callbacks[controller_id].frame_decoder.reset();
+		}
+
+		const PSMStreamLimits &limits= m_controller_stream_limits[controller_id];
+		request->mutable_request_start_psmove_data_stream()->set_max_stream_rate_hz(limits.max_rate_hz);
+		request->mutable_request_start_psmove_data_stream()->set_position_deadband_cm(limits.position_deadband_cm);
+		request->mutable_request_start_psmove_data_stream()->set_orientation_deadband_degrees(limits.orientation_deadband_degrees);
+
 		m_request_manager->send_request(request);
 
 		requestID= request->request_id();
@@ -970,6 +1089,48 @@ PSMRequestID PSMoveClient::stop_tracker_data_stream(PSMTrackerID tracker_id)
     return request->request_id();
 }
 
+PSMRequestID PSMoveClient::start_tracker_bundle_adjustment(PSMControllerID controller_id)
+{
+    CLIENT_LOG_INFO("start_tracker_bundle_adjustment") << "requesting tracker bundle adjustment recording for controller " << controller_id << std::endl;
+
+    RequestPtr request(new PSMoveProtocol::Request());
+    request->set_type(PSMoveProtocol::Request_RequestType_START_TRACKER_BUNDLE_ADJUSTMENT);
+    request->mutable_request_start_tracker_bundle_adjustment()->set_controller_id(controller_id);
+
+    m_request_manager->send_request(request);
+
+    return request->request_id();
+}
+
+PSMRequestID PSMoveClient::start_tracking_color_calibration(PSMControllerID controller_id, PSMTrackingColorType tracking_color)
+{
+    CLIENT_LOG_INFO("start_tracking_color_calibration") << "requesting tracking color calibration for controller " << controller_id << std::endl;
+
+    RequestPtr request(new PSMoveProtocol::Request());
+    request->set_type(PSMoveProtocol::Request_RequestType_START_TRACKING_COLOR_CALIBRATION);
+    request->mutable_request_start_tracking_color_calibration()->set_controller_id(controller_id);
+    request->mutable_request_start_tracking_color_calibration()->set_color_type(
+        static_cast<PSMoveProtocol::TrackingColorType>(tracking_color));
+
+    m_request_manager->send_request(request);
+
+    return request->request_id();
+}
+
+PSMRequestID PSMoveClient::solve_tracker_bundle_adjustment(bool refine_intrinsics, bool apply_result)
+{
+    CLIENT_LOG_INFO("solve_tracker_bundle_adjustment") << "requesting tracker bundle adjustment solve" << std::endl;
+
+    RequestPtr request(new PSMoveProtocol::Request());
+    request->set_type(PSMoveProtocol::Request_RequestType_SOLVE_TRACKER_BUNDLE_ADJUSTMENT);
+    request->mutable_request_solve_tracker_bundle_adjustment()->set_refine_intrinsics(refine_intrinsics);
+    request->mutable_request_solve_tracker_bundle_adjustment()->set_apply_result(apply_result);
+
+    m_request_manager->send_request(request);
+
+    return request->request_id();
+}
+
 bool PSMoveClient::open_video_stream(PSMTrackerID tracker_id)
 {
     bool bSuccess = false;
@@ -1133,6 +1294,21 @@ PSMRequestID PSMoveClient::get_hmd_list()
 }    
 
     
+void PSMoveClient::set_hmd_data_stream_limits(PSMHmdID hmd_id, const PSMStreamLimits *limits)
+{
+	if (IS_VALID_HMD_INDEX(hmd_id))
+	{
+		if (limits != nullptr)
+		{
+			m_hmd_stream_limits[hmd_id]= *limits;
+		}
+		else
+		{
+			memset(&m_hmd_stream_limits[hmd_id], 0, sizeof(PSMStreamLimits));
+		}
+	}
+}
+
 PSMRequestID PSMoveClient::start_hmd_data_stream(
     PSMHmdID hmd_id,
     unsigned int flags)
@@ -1174,6 +1350,14 @@ PSMRequestID PSMoveClient::start_hmd_data_stream(
 		request->mutable_request_start_hmd_data_stream()->set_disable_roi(true);
 	}
 
+	if (IS_VALID_HMD_INDEX(hmd_id))
+	{
+		const PSMStreamLimits &limits= m_hmd_stream_limits[hmd_id];
+		request->mutable_request_start_hmd_data_stream()->set_max_stream_rate_hz(limits.max_rate_hz);
+		request->mutable_request_start_hmd_data_stream()->set_position_deadband_cm(limits.position_deadband_cm);
+		request->mutable_request_start_hmd_data_stream()->set_orientation_deadband_degrees(limits.orientation_deadband_degrees);
+	}
+
     m_request_manager->send_request(request);
 
     return request->request_id();
@@ -1217,6 +1401,26 @@ PSMRequestID PSMoveClient::send_opaque_request(
 
     return request->request_id();
 }    
+
+// -- Request Batching --
+bool PSMoveClient::begin_request_batch()
+{
+    CLIENT_LOG_INFO("begin_request_batch") << "collecting requests into a batch" << std::endl;
+
+    return m_request_manager->begin_request_batch();
+}
+
+bool PSMoveClient::send_request_batch()
+{
+    CLIENT_LOG_INFO("send_request_batch") << "sending request batch" << std::endl;
+
+    return m_request_manager->send_request_batch();
+}
+
+bool PSMoveClient::get_is_batching_requests() const
+{
+    return m_request_manager->get_is_batching_requests();
+}
     
 // IDataFrameListener
 void PSMoveClient::handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame)
@@ -1236,7 +1440,20 @@ void PSMoveClient::handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame
 			{
 				PSMController *controller= get_controller_view(controller_id);
 
-				applyControllerDataFrame(controller_packet, controller);
+				switch (m_controller_frame_decoders[controller_id].decode(controller_packet))
+				{
+				case ControllerDataFrameDeltaDecoder::decodeFullFrame:
+					applyControllerDataFrame(controller_packet, controller);
+					break;
+				case ControllerDataFrameDeltaDecoder::decodeRebuiltFrame:
+					applyControllerDataFrame(m_controller_frame_decoders[controller_id].getRebuiltPacket(), controller);
+					break;
+				case ControllerDataFrameDeltaDecoder::decodeMissingKeyframe:
+					request_controller_keyframe(controller_id);
+					break;
+				case ControllerDataFrameDeltaDecoder::decodeDroppedFrame:
+					break;
+				}
 			}
         } break;
     case PSMoveProtocol::DeviceOutputDataFrame::TRACKER:
@@ -1275,6 +1492,81 @@ void PSMoveClient::handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame
     }
 }
 
+// IDataFrameThreadListener
+void PSMoveClient::handle_data_frame_on_io_thread(
+	const PSMoveProtocol::DeviceOutputDataFrame *data_frame,
+	long long received_time_usec)
+{
+	std::lock_guard<std::mutex> lock(m_data_callback_mutex);
+
+    switch (data_frame->device_category())
+    {
+    case PSMoveProtocol::DeviceOutputDataFrame::CONTROLLER:
+        {
+            const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet= data_frame->controller_data_packet();
+			const PSMControllerID controller_id= controller_packet.controller_id();
+
+			if (IS_VALID_CONTROLLER_INDEX(controller_id) && 
+				m_controller_data_callbacks[controller_id].callback != nullptr)
+			{
+				ControllerDataCallback &data_callback= m_controller_data_callbacks[controller_id];
+				const int last_sequence_num= data_callback.snapshot.OutputSequenceNum;
+
+				switch (data_callback.frame_decoder.decode(controller_packet))
+				{
+				case ControllerDataFrameDeltaDecoder::decodeFullFrame:
+					applyControllerDataFrame(controller_packet, &data_callback.snapshot);
+					break;
+				case ControllerDataFrameDeltaDecoder::decodeRebuiltFrame:
+					applyControllerDataFrame(data_callback.frame_decoder.getRebuiltPacket(), &data_callback.snapshot);
+					break;
+				case ControllerDataFrameDeltaDecoder::decodeMissingKeyframe:
+					// Only the application thread can send requests
+					data_callback.bNeedsKeyframe= true;
+					break;
+				case ControllerDataFrameDeltaDecoder::decodeDroppedFrame:
+					break;
+				}
+
+				// Skip frames that arrived out of order
+				if (data_callback.snapshot.OutputSequenceNum != last_sequence_num)
+				{
+					PSMDataFrameTimestamps timestamps;
+					timestamps.received_time_usec= received_time_usec;
+					timestamps.decoded_time_usec= getCurrentTimeUsec();
+
+					data_callback.callback(&data_callback.snapshot, &timestamps, data_callback.callback_userdata);
+				}
+			}
+        } break;
+    case PSMoveProtocol::DeviceOutputDataFrame::TRACKER:
+        break;
+    case PSMoveProtocol::DeviceOutputDataFrame::HMD:
+        {
+            const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket& hmd_packet = data_frame->hmd_data_packet();
+			const PSMHmdID hmd_id= hmd_packet.hmd_id();
+
+			if (IS_VALID_HMD_INDEX(hmd_id) && 
+				m_hmd_data_callbacks[hmd_id].callback != nullptr)
+			{
+				HmdDataCallback &data_callback= m_hmd_data_callbacks[hmd_id];
+				const int last_sequence_num= data_callback.snapshot.OutputSequenceNum;
+
+				applyHmdDataFrame(hmd_packet, &data_callback.snapshot);
+
+				if (data_callback.snapshot.OutputSequenceNum != last_sequence_num)
+				{
+					PSMDataFrameTimestamps timestamps;
+					timestamps.received_time_usec= received_time_usec;
+					timestamps.decoded_time_usec= getCurrentTimeUsec();
+
+					data_callback.callback(&data_callback.snapshot, &timestamps, data_callback.callback_userdata);
+				}
+			}
+        } break;
+    }
+}
+
 static void applyControllerDataFrame(
 	const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket& controller_packet, 
 	PSMController *controller)
@@ -2158,6 +2450,12 @@ void PSMoveClient::handle_notification(ResponsePtr notification)
 	case PSMoveProtocol::Response_ResponseType_SYSTEM_BUTTON_PRESSED:
 		specificEventType = PSMEventMessage::PSMEvent_systemButtonPressed;
 		break;
+    case PSMoveProtocol::Response_ResponseType_TRACKER_POSE_DRIFTED:
+        specificEventType = PSMEventMessage::PSMEvent_trackerPoseDrifted;
+        break;
+    case PSMoveProtocol::Response_ResponseType_TRACKING_COLOR_CALIBRATED:
+        specificEventType = PSMEventMessage::PSMEvent_trackingColorCalibrated;
+        break;
     }
 
     enqueue_event_message(specificEventType, notification);
@@ -2253,6 +2551,12 @@ void PSMoveClient::process_event_message(
     case PSMEventMessage::PSMEvent_systemButtonPressed:
         m_bWasSystemButtonPressed= true;
         break;
+    case PSMEventMessage::PSMEvent_trackerPoseDrifted:
+        m_bHasTrackerPoseDrifted= true;
+        break;
+    case PSMEventMessage::PSMEvent_trackingColorCalibrated:
+        m_bHasTrackingColorCalibrated= true;
+        break;
     default:
         assert(0 && "unreachable");
         break;
@@ -2359,6 +2663,49 @@ void PSMoveClient::enqueue_response_message(
     m_message_queue.push_back(message);
 }
 
+void PSMoveClient::request_controller_keyframe(PSMControllerID controller_id)
+{
+    CLIENT_LOG_DEBUG("request_controller_keyframe") << "lost the keyframe of ControllerID: " << controller_id << std::endl;
+
+    RequestPtr request(new PSMoveProtocol::Request());
+    request->set_type(PSMoveProtocol::Request_RequestType_REQUEST_CONTROLLER_KEYFRAME);
+    request->mutable_request_controller_keyframe()->set_controller_id(controller_id);
+
+    m_request_manager->send_request(request);
+
+    // Internal request, the response shouldn't show up in the message queue
+    register_callback(request->request_id(), nullResponseCallback, nullptr);
+}
+
+void PSMoveClient::request_data_callback_keyframes()
+{
+	bool bNeedsKeyframe[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+
+	{
+		std::lock_guard<std::mutex> lock(m_data_callback_mutex);
+
+		for (PSMControllerID controller_id= 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+		{
+			bNeedsKeyframe[controller_id]= m_controller_data_callbacks[controller_id].bNeedsKeyframe;
+			m_controller_data_callbacks[controller_id].bNeedsKeyframe= false;
+		}
+	}
+
+	// Sent outside the lock so the I/O thread isn't held up by the request
+	for (PSMControllerID controller_id= 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+	{
+		if (bNeedsKeyframe[controller_id])
+		{
+			request_controller_keyframe(controller_id);
+		}
+	}
+}
+
+static void nullResponseCallback(
+    const PSMResponseMessage *response,
+    void *userdata)
+{ }
+
 bool PSMoveClient::cancel_callback(PSMRequestID request_id)
 {
     bool bSuccess = false;
@@ -2388,3 +2735,77 @@ bool PSMoveClient::cancel_callback(PSMRequestID request_id)
 
     return bSuccess;
 }
+
+bool PSMoveClient::register_controller_data_callback(
+	PSMControllerID controller_id, 
+	PSMControllerDataCallback callback, 
+	void *callback_userdata)
+{
+	bool bSuccess= false;
+
+	// Unregistering always works, but the data frame thread needs an active connection to read from
+	if (IS_VALID_CONTROLLER_INDEX(controller_id) && (callback == nullptr || m_bIsConnected))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_data_callback_mutex);
+			ControllerDataCallback &data_callback= m_controller_data_callbacks[controller_id];
+
+			// The snapshot starts over from the next data frame
+			data_callback.callback= callback;
+			data_callback.callback_userdata= callback_userdata;
+			memset(&data_callback.snapshot, 0, sizeof(PSMController));
+			data_callback.snapshot.ControllerID= controller_id;
+			data_callback.snapshot.ControllerType= PSMController_None;
+			data_callback.frame_decoder.reset();
+			data_callback.bNeedsKeyframe= false;
+		}
+
+		if (callback != nullptr)
+		{
+			m_network_manager->start_data_frame_thread(this);
+		}
+
+		bSuccess= true;
+	}
+
+	return bSuccess;
+}
+
+bool PSMoveClient::register_hmd_data_callback(
+	PSMHmdID hmd_id, 
+	PSMHmdDataCallback callback, 
+	void *callback_userdata)
+{
+	bool bSuccess= false;
+
+	// Unregistering always works, but the data frame thread needs an active connection to read from
+	if (IS_VALID_HMD_INDEX(hmd_id) && (callback == nullptr || m_bIsConnected))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_data_callback_mutex);
+			HmdDataCallback &data_callback= m_hmd_data_callbacks[hmd_id];
+
+			// The snapshot starts over from the next data frame
+			data_callback.callback= callback;
+			data_callback.callback_userdata= callback_userdata;
+			memset(&data_callback.snapshot, 0, sizeof(PSMHeadMountedDisplay));
+			data_callback.snapshot.HmdID= hmd_id;
+			data_callback.snapshot.HmdType= PSMHmd_None;
+		}
+
+		if (callback != nullptr)
+		{
+			m_network_manager->start_data_frame_thread(this);
+		}
+
+		bSuccess= true;
+	}
+
+	return bSuccess;
+}
+
+static long long getCurrentTimeUsec()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -6,8 +6,11 @@
 #include "PSMoveProtocolInterface.h"
 #include "ClientNetworkInterface.h"
 #include "ClientLog.h"
+#include "DataFrameDelta.h"
 #include <deque>
 #include <map>
+#include <mutex>
+#include <string>
 #include <vector>
 
 //-- typedefs -----
@@ -17,6 +20,7 @@ typedef std::vector<ResponsePtr> t_event_reference_cache;
 //-- definitions -----
 class PSMoveClient : 
     public IDataFrameListener,
+    public IDataFrameThreadListener,
     public INotificationListener,
     public IClientNetworkEventListener
 {
@@ -33,6 +37,8 @@ public:
 	bool pollHasTrackerListChanged();
 	bool pollHasHMDListChanged();
 	bool pollWasSystemButtonPressed();
+	bool pollHasTrackerPoseDrifted();
+	bool pollHasTrackingColorCalibrated();
 
     // -- ClientPSMoveAPI System -----
     bool startup(e_log_severity_level log_level);
@@ -43,12 +49,16 @@ public:
 
 	// -- System Requests ----
     PSMRequestID get_service_version();
+    PSMRequestID get_service_statistics(bool reset_after_read);
+    PSMRequestID set_service_trace_recording(bool enabled);
+    PSMRequestID dump_service_trace(const std::string &filename);
 
     // -- ClientPSMoveAPI Requests -----
     bool allocate_controller_listener(PSMControllerID controller_id);
     void free_controller_listener(PSMControllerID controller_id);   
     PSMController* get_controller_view(PSMControllerID controller_id);
     PSMRequestID get_controller_list();
+    void set_controller_data_stream_limits(PSMControllerID controller_id, const PSMStreamLimits *limits);
     PSMRequestID start_controller_data_stream(PSMControllerID controller_id, unsigned int flags);
     PSMRequestID stop_controller_data_stream(PSMControllerID controller_id);
     PSMRequestID set_led_tracking_color(PSMControllerID controller_id, PSMTrackingColorType tracking_color);
@@ -63,6 +73,9 @@ public:
     PSMRequestID get_tracker_list();
     PSMRequestID start_tracker_data_stream(PSMTrackerID tracker_id);
     PSMRequestID stop_tracker_data_stream(PSMTrackerID tracker_id);
+    PSMRequestID start_tracker_bundle_adjustment(PSMControllerID controller_id);
+    PSMRequestID solve_tracker_bundle_adjustment(bool refine_intrinsics, bool apply_result);
+    PSMRequestID start_tracking_color_calibration(PSMControllerID controller_id, PSMTrackingColorType tracking_color);
 	bool open_video_stream(PSMTrackerID tracker_id);
 	bool poll_video_stream(PSMTrackerID tracker_id);
 	void close_video_stream(PSMTrackerID tracker_id);
@@ -72,15 +85,25 @@ public:
     void free_hmd_listener(PSMHmdID HmdID);   
 	PSMHeadMountedDisplay* get_hmd_view(PSMHmdID tracker_id);
     PSMRequestID get_hmd_list();    
+    void set_hmd_data_stream_limits(PSMHmdID hmd_id, const PSMStreamLimits *limits);
     PSMRequestID start_hmd_data_stream(PSMHmdID hmd_id, unsigned int flags);
     PSMRequestID stop_hmd_data_stream(PSMHmdID hmd_id);
     PSMRequestID set_hmd_data_stream_tracker_index(PSMHmdID hmd_id, PSMTrackerID tracker_id);
     
     PSMRequestID send_opaque_request(PSMRequestHandle request_handle);
 
+    // -- Request Batching --
+    bool begin_request_batch();
+    bool send_request_batch();
+    bool get_is_batching_requests() const;
+
     // -- Callback API --
     bool register_callback(PSMRequestID request_id, PSMResponseCallback callback, void *callback_userdata);
     bool cancel_callback(PSMRequestID request_id);
+
+    // -- Data Callback API --
+    bool register_controller_data_callback(PSMControllerID controller_id, PSMControllerDataCallback callback, void *callback_userdata);
+    bool register_hmd_data_callback(PSMHmdID hmd_id, PSMHmdDataCallback callback, void *callback_userdata);
     
 protected:
     void publish();
@@ -88,6 +111,11 @@ protected:
     // IDataFrameListener
     virtual void handle_data_frame(const PSMoveProtocol::DeviceOutputDataFrame *data_frame) override;
 
+    // IDataFrameThreadListener
+    virtual void handle_data_frame_on_io_thread(
+        const PSMoveProtocol::DeviceOutputDataFrame *data_frame, 
+        long long received_time_usec) override;
+
     // INotificationListener
     virtual void handle_notification(ResponsePtr notification) override;
 
@@ -107,6 +135,8 @@ protected:
     void enqueue_event_message(PSMEventMessage::eEventType event_type, ResponsePtr event);
     bool execute_callback(const PSMResponseMessage *response_message);
     void enqueue_response_message(const PSMResponseMessage *response_message);
+    void request_controller_keyframe(PSMControllerID controller_id);
+    void request_data_callback_keyframes();
 
 private:
     //-- Pending requests -----
@@ -117,12 +147,38 @@ private:
     
     //-- Controller Views -----
 	PSMController m_controllers[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+	PSMStreamLimits m_controller_stream_limits[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+	ControllerDataFrameDeltaDecoder m_controller_frame_decoders[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
 
     //-- Tracker Views -----
 	PSMTracker m_trackers[PSMOVESERVICE_MAX_TRACKER_COUNT];
     
     //-- HMD Views -----
 	PSMHeadMountedDisplay m_HMDs[PSMOVESERVICE_MAX_HMD_COUNT];
+	PSMStreamLimits m_hmd_stream_limits[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    //-- Data Callbacks -----
+    // Called from the client I/O thread, so each keeps its own device state built from every data frame,
+    // separate from the views the application reads between updates.
+    // Everything here is guarded by m_data_callback_mutex.
+    struct ControllerDataCallback
+    {
+        PSMControllerDataCallback callback;
+        void *callback_userdata;
+        PSMController snapshot;
+        ControllerDataFrameDeltaDecoder frame_decoder;
+        bool bNeedsKeyframe; // requested from the next update()
+    };
+    struct HmdDataCallback
+    {
+        PSMHmdDataCallback callback;
+        void *callback_userdata;
+        PSMHeadMountedDisplay snapshot;
+    };
+
+    std::mutex m_data_callback_mutex;
+    ControllerDataCallback m_controller_data_callbacks[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    HmdDataCallback m_hmd_data_callbacks[PSMOVESERVICE_MAX_HMD_COUNT];
 
 	bool m_bIsConnected;
 	bool m_bHasConnectionStatusChanged;
@@ -130,6 +186,8 @@ private:
 	bool m_bHasTrackerListChanged;
 	bool m_bHasHMDListChanged;
 	bool m_bWasSystemButtonPressed;
+	bool m_bHasTrackerPoseDrifted;
+	bool m_bHasTrackingColorCalibrated;
 
     struct PendingRequest
     {
@@ -79,6 +79,12 @@ public:
 
             assert(g_psm_client != nullptr);
 			g_psm_client->register_callback(m_request_id, PSMBlockingRequest::response_callback, this);
+
+			// The request might be sitting in an open batch, which would never get a response while we wait
+			if (g_psm_client->get_is_batching_requests())
+			{
+				g_psm_client->send_request_batch();
+			}
     
 			while (!m_bReceived && !timeout.HasElapsed())
 			{
@@ -163,6 +169,16 @@ bool PSM_WasSystemButtonPressed()
 	return g_psm_client != nullptr && g_psm_client->pollWasSystemButtonPressed();
 }
 
+bool PSM_HasTrackerPoseDrifted()
+{
+	return g_psm_client != nullptr && g_psm_client->pollHasTrackerPoseDrifted();
+}
+
+bool PSM_HasTrackingColorCalibrated()
+{
+	return g_psm_client != nullptr && g_psm_client->pollHasTrackingColorCalibrated();
+}
+
 PSMResult PSM_Initialize(const char* host, const char* port, int timeout_ms)
 {
     PSMResult result = PSMResult_Error;
@@ -245,6 +261,60 @@ PSMResult PSM_GetServiceVersionString(char *out_version_string, size_t max_versi
     return result_code;
 }
 
+PSMResult PSM_GetServiceStatistics(PSMServiceStatistics *out_statistics, bool reset_after_read, int timeout_ms)
+{
+    PSMResult result_code= PSMResult_Error;
+
+    if (g_psm_client != nullptr && out_statistics != nullptr)
+    {
+	    PSMBlockingRequest request(g_psm_client->get_service_statistics(reset_after_read));
+        result_code= request.send(timeout_ms);
+
+        if (result_code == PSMResult_Success)
+        {
+            assert(request.get_response_payload_type() == PSMResponseMessage::_responsePayloadType_ServiceStatistics);
+
+            // The response handle stays valid until the next PSM_Update
+            result_code= PSM_GetServiceStatisticsFromResponse(&request.get_response_message(), out_statistics);
+        }
+    }
+    
+    return result_code;
+}
+
+PSMResult PSM_SetServiceTraceRecording(bool enabled, int timeout_ms)
+{
+    PSMResult result_code= PSMResult_Error;
+
+    if (g_psm_client != nullptr)
+    {
+	    PSMBlockingRequest request(g_psm_client->set_service_trace_recording(enabled));
+        result_code= request.send(timeout_ms);
+    }
+    
+    return result_code;
+}
+
+PSMResult PSM_DumpServiceTrace(const char *filename, PSMServiceTraceDump *out_trace_dump, int timeout_ms)
+{
+    PSMResult result_code= PSMResult_Error;
+
+    if (g_psm_client != nullptr)
+    {
+	    PSMBlockingRequest request(g_psm_client->dump_service_trace((filename != nullptr) ? filename : ""));
+        result_code= request.send(timeout_ms);
+
+        if (result_code == PSMResult_Success && out_trace_dump != nullptr)
+        {
+            assert(request.get_response_payload_type() == PSMResponseMessage::_responsePayloadType_ServiceTraceDump);
+
+            *out_trace_dump= request.get_response_message().payload.service_trace_dump;
+        }
+    }
+    
+    return result_code;
+}
+
 PSMResult PSM_GetServiceVersionStringAsync(PSMRequestID *out_request_id)
 {
     PSMResult result= PSMResult_Error;
@@ -264,6 +334,68 @@ PSMResult PSM_GetServiceVersionStringAsync(PSMRequestID *out_request_id)
     return result;
 }
 
+PSMResult PSM_GetServiceStatisticsAsync(bool reset_after_read, PSMRequestID *out_request_id)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr)
+    {
+        PSMRequestID req_id = g_psm_client->get_service_statistics(reset_after_read);
+
+        if (out_request_id != nullptr)
+        {
+            *out_request_id= req_id;
+        }
+
+        result= (req_id != PSM_INVALID_REQUEST_ID) ? PSMResult_RequestSent : PSMResult_Error;
+    }
+
+    return result;
+}
+
+PSMResult PSM_GetServiceStatisticsFromResponse(const PSMResponseMessage *response, PSMServiceStatistics *out_statistics)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (response != nullptr && out_statistics != nullptr &&
+        response->result_code == PSMResult_Success &&
+        response->payload_type == PSMResponseMessage::_responsePayloadType_ServiceStatistics &&
+        response->opaque_response_handle != nullptr)
+    {
+        const PSMoveProtocol::Response *protocol_response= 
+            reinterpret_cast<const PSMoveProtocol::Response *>(response->opaque_response_handle);
+        const auto &StatisticsResponse = protocol_response->result_service_statistics();
+        int entry_count = 0;
+
+        for (auto it = StatisticsResponse.stage_entries().begin();
+            it != StatisticsResponse.stage_entries().end() && entry_count < PSMOVESERVICE_MAX_STATISTICS_ENTRY_COUNT;
+            ++it)
+        {
+            const auto &StageResponse = *it;
+            PSMServiceStageStatistics &entry = out_statistics->entries[entry_count];
+
+            strncpy(entry.stage_name, StageResponse.stage_name().c_str(), PSMOVESERVICE_MAX_STATISTICS_STAGE_NAME_LEN);
+            entry.stage_name[PSMOVESERVICE_MAX_STATISTICS_STAGE_NAME_LEN - 1] = '\0';
+            entry.device_id = StageResponse.device_id();
+            entry.sample_count = StageResponse.sample_count();
+            entry.samples_per_second = StageResponse.samples_per_second();
+            entry.p50_microseconds = StageResponse.p50_microseconds();
+            entry.p99_microseconds = StageResponse.p99_microseconds();
+            entry.max_microseconds = StageResponse.max_microseconds();
+
+            ++entry_count;
+        }
+
+        out_statistics->count = entry_count;
+        out_statistics->total_count = StatisticsResponse.stage_entries_size();
+        out_statistics->sample_window_seconds = StatisticsResponse.sample_window_seconds();
+
+        result= PSMResult_Success;
+    }
+
+    return result;
+}
+
 PSMResult PSM_Shutdown()
 {
 	PSMResult result= PSMResult_Error;
@@ -379,6 +511,19 @@ PSMResult PSM_FreeControllerListener(PSMControllerID controller_id)
     return result;
 }
 
+PSMResult PSM_SetControllerDataStreamLimits(PSMControllerID controller_id, const PSMStreamLimits *limits)
+{
+    PSMResult result_code= PSMResult_Error;
+
+    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    {
+        g_psm_client->set_controller_data_stream_limits(controller_id, limits);
+        result_code= PSMResult_Success;
+    }
+
+    return result_code;
+}
+
 PSMResult PSM_StartControllerDataStreamAsync(PSMControllerID controller_id, unsigned int data_stream_flags, PSMRequestID *out_request_id)
 {
     PSMResult result_code= PSMResult_Error;
@@ -1153,6 +1298,54 @@ PSMResult PSM_StopTrackerDataStream(PSMTrackerID tracker_id, int timeout_ms)
     return result;
 }
 
+PSMResult PSM_StartTrackerBundleAdjustment(PSMControllerID controller_id, int timeout_ms)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    {
+		PSMBlockingRequest request(g_psm_client->start_tracker_bundle_adjustment(controller_id));
+
+		result= request.send(timeout_ms);
+    }
+
+    return result;
+}
+
+PSMResult PSM_SolveTrackerBundleAdjustment(bool refine_intrinsics, bool apply_result, PSMTrackerBundleAdjustment *out_result, int timeout_ms)
+{
+    PSMResult result_code= PSMResult_Error;
+
+    if (g_psm_client != nullptr)
+    {
+        PSMBlockingRequest request(g_psm_client->solve_tracker_bundle_adjustment(refine_intrinsics, apply_result));
+        result_code= request.send(timeout_ms);
+
+        if (result_code == PSMResult_Success && out_result != nullptr)
+        {
+            assert(request.get_response_payload_type() == PSMResponseMessage::_responsePayloadType_TrackerBundleAdjustment);
+
+            *out_result= request.get_response_message().payload.tracker_bundle_adjustment;
+        }
+    }
+
+    return result_code;
+}
+
+PSMResult PSM_StartTrackingColorCalibration(PSMControllerID controller_id, PSMTrackingColorType tracking_color, int timeout_ms)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr && IS_VALID_CONTROLLER_INDEX(controller_id))
+    {
+		PSMBlockingRequest request(g_psm_client->start_tracking_color_calibration(controller_id, tracking_color));
+
+		result= request.send(timeout_ms);
+    }
+
+    return result;
+}
+
 PSMResult PSM_GetTrackingSpaceSettings(PSMTrackingSpace *out_tracking_space, int timeout_ms)
 {
     PSMResult result_code= PSMResult_Error;
@@ -1669,6 +1862,19 @@ PSMResult PSM_GetHmdList(PSMHmdList *out_hmd_list, int timeout_ms)
     return result_code;
 }
 
+PSMResult PSM_SetHmdDataStreamLimits(PSMHmdID hmd_id, const PSMStreamLimits *limits)
+{
+    PSMResult result= PSMResult_Error;
+
+    if (g_psm_client != nullptr && IS_VALID_HMD_INDEX(hmd_id))
+    {
+        g_psm_client->set_hmd_data_stream_limits(hmd_id, limits);
+        result= PSMResult_Success;
+    }
+
+    return result;
+}
+
 PSMResult PSM_StartHmdDataStream(PSMHmdID hmd_id, unsigned int data_stream_flags, int timeout_ms)
 {
     PSMResult result= PSMResult_Error;
@@ -1839,6 +2045,22 @@ PSMResult PSM_CancelCallback(PSMRequestID request_id)
         return PSMResult_Error;
 }
 
+PSMResult PSM_RegisterControllerDataCallback(PSMControllerID controller_id, PSMControllerDataCallback callback, void *callback_userdata)
+{
+    if (g_psm_client != nullptr)
+        return g_psm_client->register_controller_data_callback(controller_id, callback, callback_userdata) ? PSMResult_Success : PSMResult_Error;
+    else
+        return PSMResult_Error;
+}
+
+PSMResult PSM_RegisterHmdDataCallback(PSMHmdID hmd_id, PSMHmdDataCallback callback, void *callback_userdata)
+{
+    if (g_psm_client != nullptr)
+        return g_psm_client->register_hmd_data_callback(hmd_id, callback, callback_userdata) ? PSMResult_Success : PSMResult_Error;
+    else
+        return PSMResult_Error;
+}
+
 static void null_response_callback(
     const PSMResponseMessage *response,
     void *userdata)
@@ -1851,3 +2073,19 @@ PSMResult PSM_EatResponse(PSMRequestID request_id)
     else
         return PSMResult_Error;
 }
+
+PSMResult PSM_BeginRequestBatch()
+{
+    if (g_psm_client != nullptr)
+        return g_psm_client->begin_request_batch() ? PSMResult_Success : PSMResult_Error;
+    else
+        return PSMResult_Error;
+}
+
+PSMResult PSM_SendRequestBatch()
+{
+    if (g_psm_client != nullptr)
+        return g_psm_client->send_request_batch() ? PSMResult_RequestSent : PSMResult_Error;
+    else
+        return PSMResult_Error;
+}
@@ -111,8 +111,19 @@ typedef enum
 	PSMStreamFlags_includeCalibratedSensorData = 0x08,	///< Add calibrated IMU sensor state
     PSMStreamFlags_includeRawTrackerData = 0x10,		///< Add raw optical tracking projection info
 	PSMStreamFlags_disableROI = 0x20,					///< Disable Region-of-Interest tracking optimization
+	PSMStreamFlags_useDeltaFrames = 0x40,				///< Only send what changed since a periodic keyframe (controller streams)
 } PSMControllerDataStreamFlags;
 
+/// Limits on how many data frames the service sends for a controller or HMD data stream.
+/// Frames for button and tracking state changes, and for trigger or stick moves of more than
+/// 1/16 of their range, are always sent right away. Smaller analog changes wait for the next frame.
+typedef struct
+{
+    float max_rate_hz;						///< Most frames per second, 0 sends every update
+    float position_deadband_cm;				///< Skip frames that moved less than this since the last frame, 0 to disable
+    float orientation_deadband_degrees;		///< Skip frames that turned less than this since the last frame, 0 to disable
+} PSMStreamLimits;
+
 /// The possible rumble channels available to the comtrollers
 typedef enum
 {
@@ -143,7 +154,9 @@ typedef enum
 typedef enum
 {
     PSMTracker_None= -1,
-    PSMTracker_PS3Eye
+    PSMTracker_PS3Eye,
+    PSMTracker_Virtual,
+    PSMTracker_Remote
 } PSMTrackerType;
 
 /// The list of possible HMD types tracked by PSMoveService
@@ -542,7 +555,9 @@ typedef struct
         PSMEvent_controllerListUpdated,
         PSMEvent_trackerListUpdated,
         PSMEvent_hmdListUpdated,
-        PSMEvent_systemButtonPressed
+        PSMEvent_systemButtonPressed,
+        PSMEvent_trackerPoseDrifted,
+        PSMEvent_trackingColorCalibrated
     } event_type;
 
     /// Opaque handle that can be converted to a <const PSMoveProtocol::Response *> pointer
@@ -559,6 +574,34 @@ typedef struct
 	char version_string[PSMOVESERVICE_MAX_VERSION_STRING_LEN];
 } PSMServiceVersion;
 
+/// Latency of one service pipeline stage on one device
+typedef struct
+{
+    char stage_name[PSMOVESERVICE_MAX_STATISTICS_STAGE_NAME_LEN];	///< e.g. "tracker_contours"
+    int device_id;					///< Controller, tracker or HMD id (depending on the stage), -1 if not tied to a device
+    long long sample_count;
+    float samples_per_second;		///< Throughput over the sample window
+    float p50_microseconds;
+    float p99_microseconds;
+    float max_microseconds;
+} PSMServiceStageStatistics;
+
+/// Per stage timing collected by PSMoveService
+typedef struct
+{
+    PSMServiceStageStatistics entries[PSMOVESERVICE_MAX_STATISTICS_ENTRY_COUNT];
+    int count;
+    int total_count;				///< Entries the service reported, more than count if the rest didn't fit in entries
+    float sample_window_seconds;	///< Time since the service started or the statistics were last reset
+} PSMServiceStatistics;
+
+/// Where PSMoveService wrote its trace dump
+typedef struct
+{
+    char filename[PSMOVESERVICE_MAX_TRACE_FILENAME_LEN];	///< Relative to the service working directory
+    int event_count;
+} PSMServiceTraceDump;
+
 /// List of controllers attached to PSMoveService
 typedef struct
 {
@@ -578,6 +621,31 @@ typedef struct
     float global_forward_degrees;
 } PSMTrackerList;
 
+/// One tracker refined by a tracker bundle adjustment
+typedef struct
+{
+    PSMTrackerID tracker_id;
+    int observation_count;			///< Bulb sightings by this tracker
+    float initial_rms_px;			///< Reprojection error with the old pose
+    float final_rms_px;				///< Reprojection error with the refined pose
+    PSMPosef tracker_pose;			///< Refined world space pose
+    PSMVector2f focal_lengths;		///< Refined (or unchanged) focal lengths in pixels
+    PSMVector2f principal_point;	///< Refined (or unchanged) lens center in pixels
+} PSMTrackerBundleAdjustmentEntry;
+
+/// Result of refining all tracker poses jointly from recorded bulb sightings
+typedef struct
+{
+    PSMTrackerBundleAdjustmentEntry trackers[PSMOVESERVICE_MAX_TRACKER_COUNT];
+    int count;
+    int sample_count;				///< Synchronized samples recorded
+    int observation_count;			///< Sightings used by the solve
+    int iteration_count;
+    float initial_rms_px;
+    float final_rms_px;
+    bool applied;					///< Whether the refined poses were written to the tracker configs
+} PSMTrackerBundleAdjustment;
+
 /// List of HMDs connected to PSMoveSerivce
 typedef struct
 {
@@ -613,8 +681,10 @@ typedef struct
     union
     {
 		PSMServiceVersion service_version;	///< Response to service version request
+		PSMServiceTraceDump service_trace_dump; ///< Response to service trace dump request
         PSMControllerList controller_list;	///< Response to controller list request
         PSMTrackerList tracker_list;		///< Response to tracker list request
+		PSMTrackerBundleAdjustment tracker_bundle_adjustment; ///< Response to tracker bundle adjustment solve request
 		PSMHmdList hmd_list;				///< Response to hmd list request
         PSMTrackingSpace tracking_space;	///< Response to tracking space request
     } payload;
@@ -628,6 +698,9 @@ typedef struct
         _responsePayloadType_TrackerList,
         _responsePayloadType_TrackingSpace,
 		_responsePayloadType_HmdList,
+		_responsePayloadType_ServiceStatistics,
+		_responsePayloadType_ServiceTraceDump,
+		_responsePayloadType_TrackerBundleAdjustment,
 
         _responsePayloadType_Count
     } payload_type;
@@ -636,6 +709,19 @@ typedef struct
 /// Registered response callback function for a PSMoveService request
 typedef void(*PSMResponseCallback)(const PSMResponseMessage *response, void *userdata);
 
+/// When the client got a device data frame, in microseconds since the epoch (system clock)
+typedef struct
+{
+    long long received_time_usec;	///< Read off the socket
+    long long decoded_time_usec;	///< Decoded into the device snapshot, right before the data callback
+} PSMDataFrameTimestamps;
+
+/// Registered data callback for a controller, see \ref PSM_RegisterControllerDataCallback
+typedef void(*PSMControllerDataCallback)(const PSMController *controller, const PSMDataFrameTimestamps *timestamps, void *userdata);
+
+/// Registered data callback for an HMD, see \ref PSM_RegisterHmdDataCallback
+typedef void(*PSMHmdDataCallback)(const PSMHeadMountedDisplay *hmd, const PSMDataFrameTimestamps *timestamps, void *userdata);
+
 // Message Container
 //------------------
 
@@ -713,6 +799,8 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_InitializeAsync(const char* host, const char*
 	  - \ref PSM_HasTrackerListChanged()
 	  - \ref PSM_HasHMDListChanged()
 	  - \ref PSM_WasSystemButtonPressed()
+	  - \ref PSM_HasTrackerPoseDrifted()
+	  - \ref PSM_HasTrackingColorCalibrated()
 	  
 	\return PSMResult_Success if there is an active connection or PSMResult_Error if there is no valid connection
  */
@@ -789,6 +877,27 @@ PSM_PUBLIC_FUNCTION(bool) PSM_HasHMDListChanged();
  */
 PSM_PUBLIC_FUNCTION(bool) PSM_WasSystemButtonPressed();
 
+/** \brief Get the "tracker pose drifted" flag
+	This flag is only filled in when \ref PSM_Update() is called.
+	The service sets it when one tracker's view of the bulbs stops agreeing with the other trackers,
+	e.g. after the camera got bumped. Depending on the service config the tracker pose has either
+	been corrected already or the trackers should be recalibrated.
+	Call \ref PSM_GetTrackerList() to refresh the tracker poses.
+	
+	\return true if the service reported a tracker pose drift since the last call.
+ */
+PSM_PUBLIC_FUNCTION(bool) PSM_HasTrackerPoseDrifted();
+
+/** \brief Get the "tracking color calibrated" flag
+	This flag is only filled in when \ref PSM_Update() is called.
+	The service sets it when a color calibration started with \ref PSM_StartTrackingColorCalibration() finished,
+	whether or not any tracker got a new color preset.
+	Request the tracker settings again to see the new color presets.
+	
+	\return true if the service finished a tracking color calibration since the last call.
+ */
+PSM_PUBLIC_FUNCTION(bool) PSM_HasTrackingColorCalibrated();
+
 // System Blocking Queries
 /** \brief Get the client API version string from PSMoveService
 	Sends a request to PSMoveService to get the protocol version.
@@ -802,6 +911,37 @@ PSM_PUBLIC_FUNCTION(bool) PSM_WasSystemButtonPressed();
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceVersionString(char *out_version_string, size_t max_version_string, int timeout_ms);
 
+/** \brief Get the per stage latency and throughput statistics from PSMoveService
+	Sends a request to PSMoveService for the p50/p99/max time spent in each stage of its pipeline
+	(sensor processing, filtering, video processing, publishing and UDP sends), per device.
+	\remark Blocking - Returns after either the statistics are returned OR the timeout period is reached. 
+	\param[out] out_statistics The statistics for every stage and device with samples in the current window,
+	  up to PSMOVESERVICE_MAX_STATISTICS_ENTRY_COUNT of them (see total_count)
+	\param reset_after_read If true, the service starts a new sample window after answering
+	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
+	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceStatistics(PSMServiceStatistics *out_statistics, bool reset_after_read, int timeout_ms);
+
+/** \brief Start or stop recording a timeline of the PSMoveService frame loop
+	While recording, the service keeps the most recent events (device updates, worker thread reads,
+	video processing and network sends) in a fixed size ring. See \ref PSM_DumpServiceTrace.
+	\remark Blocking - Returns after either the service acknowledges the request OR the timeout period is reached. 
+	\param enabled true to start recording, false to stop
+	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
+	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetServiceTraceRecording(bool enabled, int timeout_ms);
+
+/** \brief Write the recorded PSMoveService timeline to a Chrome trace (chrome://tracing, Perfetto) JSON file
+	\remark Blocking - Returns after either the file is written OR the timeout period is reached. 
+	\param filename The name of the file to write in the service working directory, or NULL for the default name
+	\param[out] out_trace_dump The name of the file written and the number of events in it
+	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
+	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_DumpServiceTrace(const char *filename, PSMServiceTraceDump *out_trace_dump, int timeout_ms);
+
 // System Async Queries
 /** \brief Get the client API version string from PSMoveService
 	Sends a request to PSMoveService to get the protocol version.
@@ -816,6 +956,28 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceVersionString(char *out_version_str
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceVersionStringAsync(PSMRequestID *out_request_id);
 
+/** \brief Get the per stage latency and throughput statistics from PSMoveService
+	\remark Async - Starts a request for the statistics. Result obtained in one of two ways:
+	  - Register callback for request id with \ref PSM_RegisterCallback and the poll with \ref PSM_Update()
+	  - Poll with \ref PSM_UpdateNoPollMessages() and then call \ref PSM_PollNextMessage() to see if 
+	  _responsePayloadType_ServiceStatistics response has been received.
+	The statistics are too large to carry in every \ref PSMResponseMessage, so they aren't in its payload.
+	Read them out of the response with \ref PSM_GetServiceStatisticsFromResponse.
+	\param reset_after_read If true, the service starts a new sample window after answering
+	\param[out] out_request_id The id of the request sent to PSMoveService. Can be used to register callback with \ref PSM_RegisterCallback.
+	\return PSMResult_RequestSent on success or PSMResult_Error if the request couldn't be sent.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceStatisticsAsync(bool reset_after_read, PSMRequestID *out_request_id);
+
+/** \brief Copy the statistics out of a service statistics response
+	\remark The response is only valid inside its response callback or until the next \ref PSM_Update
+	\param response A response with the _responsePayloadType_ServiceStatistics payload type
+	\param[out] out_statistics The statistics for every stage and device with samples in the response's window,
+	  up to PSMOVESERVICE_MAX_STATISTICS_ENTRY_COUNT of them (see total_count)
+	\return PSMResult_Success, or PSMResult_Error if the response isn't a successful statistics response
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetServiceStatisticsFromResponse(const PSMResponseMessage *response, PSMServiceStatistics *out_statistics);
+
 // Async Message Handling API
 /** \brief Retrieve the next message from the message queue.
 	A call to \ref PSM_UpdateNoPollMessages will queue messages received from PSMoveService.
@@ -871,6 +1033,45 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_CancelCallback(PSMRequestID request_id);
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_EatResponse(PSMRequestID request_id);
 
+/** \brief Starts collecting requests into a batch
+	Async requests made after this call are held back until \ref PSM_SendRequestBatch sends them to PSMoveService 
+	in a single message, which the service runs in order within one update.
+	Each request in the batch still gets its own request id and response.
+	Blocking requests send the open batch first since they have to wait on their own response.
+	\return PSMResult_Success if no batch was open yet, PSMResult_Error otherwise
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_BeginRequestBatch();
+
+/** \brief Sends the requests collected since \ref PSM_BeginRequestBatch
+	Sending an empty batch just closes it.
+	\return PSMResult_RequestSent if a batch was open, PSMResult_Error otherwise
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SendRequestBatch();
+
+/** \brief Registers a callback for every data frame of a controller's data stream
+	Registering the first data callback starts a client owned I/O thread that reads data frames as soon as they arrive.
+	The callback is called from that thread the moment a data frame for the controller is decoded,
+	without waiting for the next \ref PSM_Update.
+	It gets a snapshot of the controller state kept just for the callback, valid only for the duration of the call.
+	The \ref PSMController returned by \ref PSM_GetController still only changes in \ref PSM_Update or 
+	\ref PSM_UpdateNoPollMessages, which still need to be called to send requests and receive responses.
+	The callback must not call back into the client API.
+	\param controller_id The id of the controller whose data frames we want
+	\param callback A callback function pointer, or NULL to unregister the callback
+	\param callback_userdata Userdata for the callback function
+	\return PSMResult_Success if the controller_id is valid and, when registering a callback, the connection is active
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_RegisterControllerDataCallback(PSMControllerID controller_id, PSMControllerDataCallback callback, void *callback_userdata);
+
+/** \brief Registers a callback for every data frame of an HMD's data stream
+	Works the same way as \ref PSM_RegisterControllerDataCallback.
+	\param hmd_id The id of the HMD whose data frames we want
+	\param callback A callback function pointer, or NULL to unregister the callback
+	\param callback_userdata Userdata for the callback function
+	\return PSMResult_Success if the hmd_id is valid and, when registering a callback, the connection is active
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_RegisterHmdDataCallback(PSMHmdID hmd_id, PSMHmdDataCallback callback, void *callback_userdata);
+
 // Controller Pool
 /** \brief Fetches the \ref PSMController data for the given controller
 	The client API maintains a pool of controller structs. 
@@ -923,6 +1124,7 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerList(PSMControllerList *out_cont
 		- PSMStreamFlags_includeCalibratedSensorData = add calibrated sensor data values
 		- PSMStreamFlags_includeRawTrackerData = add tracker projection info for each tacker
 		- PSMStreamFlags_disableROI = turns off RegionOfInterest optimization used to reduce CPU load when finding tracking bulb
+		- PSMStreamFlags_useDeltaFrames = smaller data frames holding only the state that changed since the last keyframe
 	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
 	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
  */
@@ -939,6 +1141,16 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_StartControllerDataStream(PSMControllerID con
 	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error. */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_StopControllerDataStream(PSMControllerID controller_id, int timeout_ms);
 
+/** \brief Sets the stream limits used the next time the data stream of the given controller is started
+	Lets a client that doesn't need every update (e.g. a 10Hz dashboard) save the service and the network the frames it would drop anyway.
+	\remark Not a request - Takes effect on the next call to \ref PSM_StartControllerDataStream.
+	\remark The deadbands only hold back pose changes, see \ref PSMStreamLimits for the analog inputs.
+	\param controller_id The id of the controller whose stream to limit
+	\param limits The limits to use, or NULL to send every update again
+	\return PSMResult_Success or PSMResult_Error if the controller id is invalid
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetControllerDataStreamLimits(PSMControllerID controller_id, const PSMStreamLimits *limits);
+
 /** \brief Requests changing the tracking color type of a given controller.
 	Sends a request to PSMoveService to change the tracking color of a controller.
 	If another controller already is using the color being assigned to this controller, it will be assigned an available color.
@@ -1124,6 +1336,7 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_GetControllerListAsync(PSMRequestID *out_requ
 		- PSMStreamFlags_includeCalibratedSensorData = add calibrated sensor data values
 		- PSMStreamFlags_includeRawTrackerData = add tracker projection info for each tacker
 		- PSMStreamFlags_disableROI = turns off RegionOfInterest optimization used to reduce CPU load when finding tracking bulb
+		- PSMStreamFlags_useDeltaFrames = smaller data frames holding only the state that changed since the last keyframe
 	\param[out] out_request_id The id of the request sent to PSMoveService. Can be used to register callback with \ref PSM_RegisterCallback.
 	\return PSMResult_RequestSent on success or PSMResult_Error if there was no valid connection
  */
@@ -1272,6 +1485,44 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_StartTrackerDataStream(PSMTrackerID tracker_i
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_StopTrackerDataStream(PSMTrackerID tracker_id, int timeout_ms);
 
+/** \brief Start recording bulb sightings to refine all tracker poses jointly
+	Every service update where two or more trackers see the bulb of the given controller adds one sample.
+	Wave the controller slowly through as much of the shared tracking volume as possible, then call
+	\ref PSM_SolveTrackerBundleAdjustment. Starting again throws away any earlier samples.
+	\remark Only sphere (bulb) tracked controllers can be used
+	\remark Blocking - Returns after either the service acknowledges the request OR the timeout period is reached. 
+	\param controller_id The id of the tracked controller to record
+	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
+	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_StartTrackerBundleAdjustment(PSMControllerID controller_id, int timeout_ms);
+
+/** \brief Stop recording and refine the tracker poses from the recorded bulb sightings
+	Runs a bundle adjustment over every tracker that saw the bulb and reports the reprojection error
+	before and after. The refined poses are only applied if they lower the error.
+	\remark Blocking - Returns after either the solve completes OR the timeout period is reached. 
+	\param refine_intrinsics Also refine the focal lengths and principal points (the lens distortion stays as is)
+	\param apply_result Write the refined poses (and intrinsics) to the tracker configs
+	\param[out] out_result The refined trackers and the reprojection error before and after
+	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
+	\return PSMResult_Success upon receiving result, PSMResult_Timeoout, or PSMResult_Error on request error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SolveTrackerBundleAdjustment(bool refine_intrinsics, bool apply_result, PSMTrackerBundleAdjustment *out_result, int timeout_ms);
+
+/** \brief Automatically calibrate a tracking color on every open tracker using a controller's bulb
+	The service turns the controller bulb off then on in the given color, finds the bulb in each tracker's video
+	as the pixels that light up, and fits that tracker's color preset for the color to them.
+	The bulb should be in view of the trackers and the controller held still for the couple of seconds this takes.
+	The service reports completion through \ref PSM_HasTrackingColorCalibrated().
+	Trackers that don't find the bulb, or whose fitted range would also pick up the background, keep their preset.
+	\remark Blocking - Returns after either the service starts the calibration OR the timeout period is reached. 
+	\param controller_id The id of the controller whose bulb is in view
+	\param tracking_color The bulb color to calibrate
+	\param timeout_ms The conection timeout period in milliseconds, usually PSM_DEFAULT_TIMEOUT
+	\return PSMResult_Success if the calibration started, PSMResult_Timeoout, or PSMResult_Error on request error.
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_StartTrackingColorCalibration(PSMControllerID controller_id, PSMTrackingColorType tracking_color, int timeout_ms);
+
 /** \brief Request the tracking space settings
 	Sends a request to PSMoveService to get the tracking space settings for PSMoveService.
 	The settings contain the direction of global forward (usually the -Z axis)
@@ -1515,6 +1766,14 @@ PSM_PUBLIC_FUNCTION(PSMResult) PSM_StartHmdDataStream(PSMHmdID hmd_id, unsigned
  */
 PSM_PUBLIC_FUNCTION(PSMResult) PSM_StopHmdDataStream(PSMHmdID hmd_id, int timeout_ms);
 
+/** \brief Sets the stream limits used the next time the data stream of the given HMD is started
+	\remark Not a request - Takes effect on the next call to \ref PSM_StartHmdDataStream.
+	\param hmd_id The id of the HMD whose stream to limit
+	\param limits The limits to use, or NULL to send every update again
+	\return PSMResult_Success or PSMResult_Error if the HMD id is invalid
+ */
+PSM_PUBLIC_FUNCTION(PSMResult) PSM_SetHmdDataStreamLimits(PSMHmdID hmd_id, const PSMStreamLimits *limits);
+
 /** \brief Requests setting the selected tracker index for an HMD
 	This request is used to set the selected tracker index on an HMD data stream
     when the data stream has tracking projection data active. The projection data is
@@ -151,6 +151,7 @@ AppStage_ColorCalibration::AppStage_ColorCalibration(App *app)
     , m_bAutoChangeColor(false)
     , m_bAutoChangeTracker(false)
     , m_bAutoCalibrate(false)
+    , m_bWaitingForBulbCalibration(false)
     , m_bShowWindows(true)
     , m_bShowAlignment(false)
     , m_bShowAlignmentColor(false)
@@ -255,6 +256,13 @@ void AppStage_ColorCalibration::update()
         }
     }
 
+    // The service finished fitting the color presets from the blinking bulb
+    if (PSM_HasTrackingColorCalibrated())
+    {
+        m_bWaitingForBulbCalibration= false;
+        request_tracker_get_settings();
+    }
+
     // Try and read the next video frame from shared memory
     if (m_video_buffer_state != nullptr)
     {
@@ -698,6 +706,18 @@ void AppStage_ColorCalibration::renderUI()
             }
             ImGui::Text("Tracking [C]olor: %s", k_tracking_color_names[m_masterTrackingColorType]);
 
+            if (m_masterControllerView != nullptr)
+            {
+                if (m_bWaitingForBulbCalibration)
+                {
+                    ImGui::Text("Calibrating from the bulb, hold the controller still...");
+                }
+                else if (ImGui::Button("Calibrate From Bulb (All Trackers)"))
+                {
+                    request_start_bulb_color_calibration();
+                }
+            }
+
             // -- Hue --
             if (ImGui::Button("-##HueCenter"))
             {
@@ -1145,6 +1165,16 @@ void AppStage_ColorCalibration::request_set_controller_tracking_color(
     PSM_SetControllerLEDOverrideColor(controllerView->ControllerID, r, g, b);
 }
 
+void AppStage_ColorCalibration::request_start_bulb_color_calibration()
+{
+    // The service blinks the bulb and fits this color's preset on every tracker that sees it
+    if (PSM_StartTrackingColorCalibration(
+            m_masterControllerView->ControllerID, m_masterTrackingColorType, PSM_DEFAULT_TIMEOUT) == PSMResult_Success)
+    {
+        m_bWaitingForBulbCalibration= true;
+    }
+}
+
 void AppStage_ColorCalibration::request_start_hmd_stream()
 {
     // Start receiving data from the controller
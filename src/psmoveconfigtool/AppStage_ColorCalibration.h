@@ -141,6 +141,8 @@ protected:
         const PSMResponseMessage *response,
         void *userdata);
 
+    void request_start_bulb_color_calibration();
+
     void request_save_default_tracker_profile();
     void request_apply_default_tracker_profile();
 
@@ -198,6 +200,7 @@ private:
 	bool m_bAutoChangeColor;
 	bool m_bAutoChangeTracker;
 	bool m_bAutoCalibrate;
+	bool m_bWaitingForBulbCalibration; // the service is blinking the bulb to fit the presets
 
 	// Setting Windows visability
 	bool m_bShowWindows;
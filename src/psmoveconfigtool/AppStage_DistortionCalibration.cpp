@@ -7,6 +7,7 @@
 #include "AssetManager.h"
 #include "App.h"
 #include "Camera.h"
+#include "ChessboardCalibration.h"
 #include "ClientLog.h"
 #include "MathUtility.h"
 #include "Renderer.h"
@@ -23,6 +24,8 @@
 #include "opencv2/opencv.hpp"
 #include "opencv2/calib3d/calib3d.hpp"
 
+#include <algorithm>
+#include <thread>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -54,6 +57,9 @@ static const char *k_video_display_mode_names[] = {
 
 #define STRAIGHT_LINE_TOLERANCE 5 // error tolerance in pixels
 
+#define DETECTION_FRAME_WIDTH 320 // chessboard corner search resolution
+#define MAX_DETECTION_WORKER_COUNT 4
+
 //-- private definitions -----
 class OpenCVBufferState
 {
@@ -63,6 +69,8 @@ public:
         , frameWidth(static_cast<int>(_trackerInfo.tracker_screen_dimensions.x))
         , frameHeight(static_cast<int>(_trackerInfo.tracker_screen_dimensions.y))
         , capturedBoardCount(0)
+        , solvedBoardCount(0)
+        , calibrator(nullptr)
     {
         // Video Frame data
         bgrSourceBuffer = new cv::Mat(frameHeight, frameWidth, CV_8UC3);
@@ -78,6 +86,14 @@ public:
         distortionMapX = new cv::Mat(cv::Size(frameWidth, frameHeight), CV_32FC1);
         distortionMapY = new cv::Mat(cv::Size(frameWidth, frameHeight), CV_32FC1);
 
+        // Corner detection runs on the spare cores, one frame per worker
+        pattern.corners_wide = PATTERN_W;
+        pattern.corners_high = PATTERN_H;
+        pattern.square_length_mm = DEFAULT_SQUARE_LEN_MM;
+        const int worker_count =
+            std::max(std::min(static_cast<int>(std::thread::hardware_concurrency()) - 1, MAX_DETECTION_WORKER_COUNT), 1);
+        detectorPool = new ChessboardDetectorPool(pattern, worker_count, DETECTION_FRAME_WIDTH);
+
         resetCaptureState();
         resetCalibrationState();
     }
@@ -97,21 +113,58 @@ public:
         // Distortion state
         delete distortionMapX;
         delete distortionMapY;
+
+        // Calibration workers
+        delete detectorPool;
+        if (calibrator != nullptr)
+        {
+            delete calibrator;
+        }
+    }
+
+    void startCapture(const float square_length_mm)
+    {
+        // The board size only matters to the solver
+        pattern.square_length_mm = square_length_mm;
+
+        if (calibrator != nullptr)
+        {
+            delete calibrator;
+        }
+        calibrator = new IncrementalCameraCalibrator(
+            pattern,
+            cv::Size(frameWidth, frameHeight),
+            cv::Matx33d(
+                trackerInfo.tracker_focal_lengths.x, 0.0, trackerInfo.tracker_principal_point.x,
+                0.0, trackerInfo.tracker_focal_lengths.y, trackerInfo.tracker_principal_point.y,
+                0.0, 0.0, 1.0),
+            cv::Vec<double, 5>(
+                trackerInfo.tracker_k1, trackerInfo.tracker_k2,
+                trackerInfo.tracker_p1, trackerInfo.tracker_p2,
+                trackerInfo.tracker_k3));
+
+        resetCaptureState();
+        resetCalibrationState();
     }
 
     void resetCaptureState()
     {
+        if (calibrator != nullptr)
+        {
+            calibrator->reset();
+        }
+
         capturedBoardCount= 0;
         bCurrentImagePointsValid= false;
         currentImagePoints.clear();
         lastValidImagePoints.clear();
         quadList.clear();
-        imagePointsList.clear();
     }
 
     void resetCalibrationState()
     {
         reprojectionError= 0.f;
+        solvedBoardCount= 0;
 
         // Fill in the intrinsic matrix
         intrinsic_matrix->at<double>(0, 0)= trackerInfo.tracker_focal_lengths.x;
@@ -157,28 +210,16 @@ public:
 
     void findAndAppendNewChessBoard(bool appWantsAppend)
     {
-        
         if (capturedBoardCount < DESIRED_CAPTURE_BOARD_COUNT)
         {
-            std::vector<cv::Point2f> new_image_points;
-
-            // Find chessboard corners:
-            if (cv::findChessboardCorners(
-                    *gsBuffer, 
-                    cv::Size(PATTERN_W, PATTERN_H), 
-                    new_image_points, // output corners
-                    cv::CALIB_CB_ADAPTIVE_THRESH 
-                    + cv::CALIB_CB_FILTER_QUADS 
-                    // + cv::CALIB_CB_NORMALIZE_IMAGE is suuuper slow
-                    + cv::CALIB_CB_FAST_CHECK))
+            // Hand the frame to an idle detection worker (dropped if they are all busy)
+            // and pick up whatever detection finished since the last update
+            detectorPool->submitFrame(*gsBuffer);
+
+            ChessboardDetection detection;
+            if (detectorPool->pollDetection(detection) && detection.bFound)
             {
-                // Get subpixel accuracy on those corners
-                cv::cornerSubPix(
-                    *gsBuffer, 
-                    new_image_points, // corners to refine
-                    cv::Size(11, 11), // winSize- Half of the side length of the search window
-                    cv::Size(-1, -1), // zeroZone- (-1,-1) means no dead zone in search
-                    cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::MAX_ITER, 30, 0.1));
+                const std::vector<cv::Point2f> &new_image_points= detection.corners;
 
                 // Append the new chessboard corner pixels into the image_points matrix
                 // Append the corresponding 3d chessboard corners into the object_points matrix
@@ -188,16 +229,8 @@ public:
                     // See if the board is stationary (didn't move much since last frame)
                     if (currentImagePoints.size() > 0)
                     {
-                        float error_sum= 0.f;
-
-                        for (int corner_index= 0; corner_index < CORNER_COUNT; ++corner_index)
-                        {
-                            float squared_error= static_cast<float>(cv::norm(new_image_points[corner_index] - currentImagePoints[corner_index]));
-
-                            error_sum+= squared_error;
-                        }
-
-                        bCurrentImagePointsValid= error_sum <= BOARD_MOVED_ERROR_SUM;
+                        bCurrentImagePointsValid= 
+                            chessboard_compute_corner_distance_sum(new_image_points, currentImagePoints) <= BOARD_MOVED_ERROR_SUM;
                     }
                     else
                     {
@@ -210,22 +243,15 @@ public:
                     {
                         if (lastValidImagePoints.size() > 0)
                         {
-                            float error_sum= 0.f;
-
-                            for (int corner_index= 0; corner_index < CORNER_COUNT; ++corner_index)
-                            {
-                                float squared_error= static_cast<float>(cv::norm(new_image_points[corner_index] - lastValidImagePoints[corner_index]));
-
-                                error_sum+= squared_error;
-                            }
-
-                            bCurrentImagePointsValid= error_sum >= BOARD_NEW_LOCATION_ERROR_SUM;
+                            bCurrentImagePointsValid= 
+                                chessboard_compute_corner_distance_sum(new_image_points, lastValidImagePoints) >= BOARD_NEW_LOCATION_ERROR_SUM;
                         }
                     }
 
                     if (bCurrentImagePointsValid)
                     {
-                        bCurrentImagePointsValid= areGridLinesStraight(new_image_points);
+                        bCurrentImagePointsValid= 
+                            chessboard_are_grid_lines_straight(pattern, new_image_points, STRAIGHT_LINE_TOLERANCE);
                     }
 
                     // If it's a valid new location, append it to the board list
@@ -237,8 +263,8 @@ public:
                         quadList.push_back(new_image_points[CORNER_COUNT-1]);
                         quadList.push_back(new_image_points[CORNER_COUNT-PATTERN_W]);                        
 
-                        // Append the new images points and object points
-                        imagePointsList.push_back(new_image_points);
+                        // Re-solve the calibration in the background with the new board
+                        calibrator->addBoard(new_image_points);
 
                         // Remember the last valid captured points
                         lastValidImagePoints= currentImagePoints;
@@ -254,72 +280,37 @@ public:
         }
     }
 
-    static bool areGridLinesStraight(const std::vector<cv::Point2f> &corners)
+    // Picks up the latest background solve, so the undistorted preview and the error
+    // follow along as boards are captured.
+    // Returns true once every captured board is in the calibration.
+    bool updateCameraCalibration()
     {
-        assert(corners.size() == CORNER_COUNT);
-        bool bAllLinesStraight= true;
+        CameraCalibrationResult result;
+        calibrator->getLatestResult(result);
 
-        for (int line_index= 0; bAllLinesStraight && line_index < PATTERN_H; ++line_index)
+        if (result.board_count != solvedBoardCount)
         {
-            int start_index= line_index*PATTERN_W;
-            int end_index= start_index + PATTERN_W - 1;
-
-            cv::Point2f line_start= corners[start_index];
-            cv::Point2f line_end= corners[end_index];
-
-            for (int point_index= start_index + 1; bAllLinesStraight && point_index < end_index; ++point_index)
+            for (int row = 0; row < 3; ++row)
             {
-                cv::Point2f point= corners[point_index];
-
-                if (distanceToLine(line_start, line_end, point) > STRAIGHT_LINE_TOLERANCE)
+                for (int col = 0; col < 3; ++col)
                 {
-                    bAllLinesStraight= false;
+                    intrinsic_matrix->at<double>(row, col)= result.intrinsic_matrix(row, col);
                 }
             }
-        }
 
-        return bAllLinesStraight;
-    }
-
-    static float distanceToLine(cv::Point2f line_start, cv::Point2f line_end, cv::Point2f point)
-    {
-        const auto start_to_end= line_end - line_start;
-        const auto start_to_point= point - line_start;
-
-        float area = static_cast<float>(start_to_point.cross(start_to_end));
-        float line_length= static_cast<float>(cv::norm(start_to_end));
-        return fabsf(safe_divide_with_default(area, line_length, 0.f));
-    }
+            for (int coeff_index = 0; coeff_index < 5; ++coeff_index)
+            {
+                distortion_coeffs->at<double>(coeff_index, 0)= result.distortion_coeffs[coeff_index];
+            }
 
-    bool computeCameraCalibration(const float square_length_mm)
-    {
-        bool bSuccess= false;
+            reprojectionError= result.reprojection_error;
+            solvedBoardCount= result.board_count;
 
-        if (capturedBoardCount >= DESIRED_CAPTURE_BOARD_COUNT)
-        {
-            // Only need to calculate objectPointsList once,
-            // then resize for each set of image points.
-            std::vector<std::vector<cv::Point3f> > objectPointsList(1);
-            calcBoardCornerPositions(square_length_mm, objectPointsList[0]);
-            objectPointsList.resize(imagePointsList.size(), objectPointsList[0]);
-            
-            // Compute the camera intrinsic matrix and distortion parameters
-            reprojectionError= 
-                cv::calibrateCamera(
-                    objectPointsList, imagePointsList,
-                    cv::Size(frameWidth, frameHeight), 
-                    *intrinsic_matrix, *distortion_coeffs, // Output we care about
-                    cv::noArray(), cv::noArray(), // best fit board poses as rvec/tvec pairs
-                    cv::CALIB_FIX_ASPECT_RATIO,
-                    cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, DBL_EPSILON));
-            
             // Regenerate the distortion map now for the new calibration
             rebuildDistortionMap();
-
-            bSuccess= true;
         }
 
-        return bSuccess;
+        return capturedBoardCount >= DESIRED_CAPTURE_BOARD_COUNT && solvedBoardCount == capturedBoardCount;
     }
 
     void rebuildDistortionMap()
@@ -334,19 +325,6 @@ public:
             *distortionMapX, *distortionMapY);
     }
     
-    void calcBoardCornerPositions(const float square_length_mm, std::vector<cv::Point3f>& corners)
-    {
-        corners.clear();
-        
-        for( int i = 0; i < PATTERN_H; ++i )
-        {
-            for( int j = 0; j < PATTERN_W; ++j )
-            {
-                corners.push_back(cv::Point3f(float(j*square_length_mm), float(i*square_length_mm), 0.f));
-            }
-        }
-    }
-
     const PSMClientTrackerInfo &trackerInfo;
     int frameWidth;
     int frameHeight;
@@ -358,14 +336,15 @@ public:
     cv::Mat *bgrUndistortBuffer;
 
     // Chess board computed state
+    ChessboardPattern pattern;
     int capturedBoardCount;
     std::vector<cv::Point2f> lastValidImagePoints;
     std::vector<cv::Point2f> currentImagePoints;
     bool bCurrentImagePointsValid;
     std::vector<cv::Point2f> quadList;
-    std::vector<std::vector<cv::Point2f>> imagePointsList;
 
     // Calibration state
+    int solvedBoardCount;
     double reprojectionError;
     cv::Mat *intrinsic_matrix;
     cv::Mat *distortion_coeffs;
@@ -373,6 +352,10 @@ public:
     // Distortion preview
     cv::Mat *distortionMapX;
     cv::Mat *distortionMapY;
+
+    // Calibration workers
+    ChessboardDetectorPool *detectorPool;
+    IncrementalCameraCalibrator *calibrator;
 };
 
 //-- public methods -----
@@ -467,10 +450,9 @@ void AppStage_DistortionCalibration::update()
                 ImGuiIO io_state = ImGui::GetIO();
                 m_opencv_state->findAndAppendNewChessBoard(io_state.KeysDown[32]);
 
-                if (m_opencv_state->capturedBoardCount >= DESIRED_CAPTURE_BOARD_COUNT)
+                // Will update intrinsic_matrix and distortion_coeffs
+                if (m_opencv_state->updateCameraCalibration())
                 {
-                    
-                    m_opencv_state->computeCameraCalibration(m_square_length_mm); //Will update intrinsic_matrix and distortion_coeffs
                     cv::Mat *intrinsic_matrix= m_opencv_state->intrinsic_matrix;
                     cv::Mat *distortion_coeffs= m_opencv_state->distortion_coeffs;
                     
@@ -652,6 +634,7 @@ void AppStage_DistortionCalibration::renderUI()
 				request_tracker_set_temp_exposure(128.f);
 				request_tracker_set_temp_gain(128.f);
 
+				m_opencv_state->startCapture(m_square_length_mm);
 				m_menuState = eMenuState::capture;
 			}
 			ImGui::SameLine();
@@ -717,13 +700,18 @@ void AppStage_DistortionCalibration::renderUI()
 
             {
                 ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x / 2.f - k_panel_width / 2.f, 20.f));
-                ImGui::SetNextWindowSize(ImVec2(k_panel_width, 110));
+                ImGui::SetNextWindowSize(ImVec2(k_panel_width, 130));
                 ImGui::Begin(k_window_title, nullptr, window_flags);
 
                 const float samplePercentage= 
                     static_cast<float>(m_opencv_state->capturedBoardCount) / static_cast<float>(DESIRED_CAPTURE_BOARD_COUNT);
                 ImGui::ProgressBar(samplePercentage, ImVec2(k_panel_width - 20, 20));
 
+                if (m_opencv_state->solvedBoardCount > 0)
+                {
+                    ImGui::Text("Error: %f (%d boards)", m_opencv_state->reprojectionError, m_opencv_state->solvedBoardCount);
+                }
+
                 if (ImGui::Button("Restart"))
                 {
                     m_opencv_state->resetCaptureState();
@@ -32,11 +32,13 @@ static const double k_stabilize_wait_time_ms= 1000.f;
 static const int k_max_identity_magnetometer_samples= 100;
 static const int k_min_sample_distance= 20;
 static const int k_min_sample_distance_sq= k_min_sample_distance*k_min_sample_distance;
+static const float k_robust_fit_outlier_tolerance= 0.15f; // fraction of the fit radius
 
 enum eEllipseFitMethod
 {
     _ellipse_fit_method_least_squares,
     _ellipse_fit_method_box,
+    _ellipse_fit_method_robust,
 };
 
 //-- private methods -----
@@ -53,6 +55,7 @@ struct MagnetometerBoundsStatistics
     PSMVector3i maxSampleExtent;
 
     EigenFitEllipsoid sampleFitEllipsoid;
+    EigenStreamingEllipsoidFit streamingFit;
     int ellipseFitMethod;
 
 	MagnetometerBoundsStatistics()
@@ -60,7 +63,7 @@ struct MagnetometerBoundsStatistics
 		, samplePercentage(0)
 		, minSampleExtent()
 		, maxSampleExtent()
-		, ellipseFitMethod(_ellipse_fit_method_least_squares)
+		, ellipseFitMethod(_ellipse_fit_method_robust)
 	{
 		clear();
 	}
@@ -79,6 +82,7 @@ struct MagnetometerBoundsStatistics
 		maxSampleExtent= *k_psm_int_vector3_zero;
 
 		sampleFitEllipsoid.clear();
+		streamingFit.clear();
 	}
 
 	bool addSample(const PSMVector3i &sample)
@@ -111,18 +115,12 @@ struct MagnetometerBoundsStatistics
             magnetometerEigenSamples[sampleCount] = psm_vector3i_to_eigen_vector3(sample);
             ++sampleCount;
 
+            // The streaming fit is kept current whatever the fit method so switching to it is free
+            eigen_alignment_streaming_ellipsoid_add_samples(
+                streamingFit, &magnetometerEigenSamples[sampleCount-1], 1, k_robust_fit_outlier_tolerance, 1.f);
+
             // Compute a best fit ellipsoid for the sample points
-            switch (ellipseFitMethod)
-            {
-            case _ellipse_fit_method_least_squares:
-                eigen_alignment_fit_least_squares_axis_aligned_ellipsoid(
-                    magnetometerEigenSamples, sampleCount, sampleFitEllipsoid);
-                break;
-            case _ellipse_fit_method_box:
-                eigen_alignment_fit_bounding_box_ellipsoid(
-                    magnetometerEigenSamples, sampleCount, sampleFitEllipsoid);
-                break;
-            }
+            refitEllipsoid();
 
             // Update the extents progress based on min extent size
             int minRange = computeMagnetometerCalibrationMinRange();
@@ -138,6 +136,38 @@ struct MagnetometerBoundsStatistics
 		return bSuccess;
 	}
 
+	void refitEllipsoid()
+	{
+		switch (ellipseFitMethod)
+		{
+		case _ellipse_fit_method_least_squares:
+			eigen_alignment_fit_least_squares_axis_aligned_ellipsoid(
+				magnetometerEigenSamples, sampleCount, sampleFitEllipsoid);
+			break;
+		case _ellipse_fit_method_box:
+			eigen_alignment_fit_bounding_box_ellipsoid(
+				magnetometerEigenSamples, sampleCount, sampleFitEllipsoid);
+			break;
+		case _ellipse_fit_method_robust:
+			if (eigen_alignment_streaming_ellipsoid_solve(streamingFit))
+			{
+				sampleFitEllipsoid= streamingFit.ellipsoid;
+
+				// Report the same error measure as the other fit methods
+				sampleFitEllipsoid.error=
+					eigen_alignment_compute_ellipsoid_fit_error(
+						magnetometerEigenSamples, sampleCount, sampleFitEllipsoid);
+			}
+			else
+			{
+				// Too few samples for a rotated fit yet
+				eigen_alignment_fit_least_squares_axis_aligned_ellipsoid(
+					magnetometerEigenSamples, sampleCount, sampleFitEllipsoid);
+			}
+			break;
+		}
+	}
+
 private:
 	void expandMagnetometerBounds(const PSMVector3i &sample)
 	{
@@ -767,25 +797,25 @@ void AppStage_MagnetometerCalibration::renderUI()
 
             {
                 ImGui::SetNextWindowPos(ImVec2(10.f, 450.f));
-                ImGui::SetNextWindowSize(ImVec2(170.f, 80.f));
+                ImGui::SetNextWindowSize(ImVec2(170.f, 100.f));
                 ImGui::Begin("Ellipse Fitting Mode", nullptr, window_flags);
 
+                if (ImGui::RadioButton("Robust Fit", &m_boundsStatistics->ellipseFitMethod, _ellipse_fit_method_robust))
+                {
+                    // Rotated ellipsoid fit that ignores outlier samples
+                    m_boundsStatistics->refitEllipsoid();
+                }
+
                 if (ImGui::RadioButton("Least Squares Fit", &m_boundsStatistics->ellipseFitMethod, _ellipse_fit_method_least_squares))
                 {
                     // Re-fit using min bounds
-                    eigen_alignment_fit_least_squares_axis_aligned_ellipsoid(
-                        m_boundsStatistics->magnetometerEigenSamples, 
-						m_boundsStatistics->sampleCount, 
-						m_boundsStatistics->sampleFitEllipsoid);
+                    m_boundsStatistics->refitEllipsoid();
                 }
 
                 if (ImGui::RadioButton("Bounds Fit", &m_boundsStatistics->ellipseFitMethod, _ellipse_fit_method_box))
                 {
                     // Refit to a box
-                    eigen_alignment_fit_bounding_box_ellipsoid(
-                        m_boundsStatistics->magnetometerEigenSamples, 
-						m_boundsStatistics->sampleCount, 
-						m_boundsStatistics->sampleFitEllipsoid);
+                    m_boundsStatistics->refitEllipsoid();
                 }
 
                 ImGui::End();
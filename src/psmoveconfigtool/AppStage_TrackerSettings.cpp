@@ -65,6 +65,8 @@ void AppStage_TrackerSettings::render()
             switch (trackerInfo.tracker_type)
             {
             case PSMoveProtocol::PS3EYE:
+            case PSMoveProtocol::VIRTUAL_TRACKER:
+            case PSMoveProtocol::REMOTE_TRACKER:
                 {
                     glm::mat4 scale3 = glm::scale(glm::mat4(1.f), glm::vec3(3.f, 3.f, 3.f));
                     drawPS3EyeModel(scale3);
@@ -233,6 +235,14 @@ void AppStage_TrackerSettings::renderUI()
                 {
                     ImGui::BulletText("Controller Type: PS3 Eye");
                 } break;
+            case PSMTracker_Virtual:
+                {
+                    ImGui::BulletText("Controller Type: Virtual");
+                } break;
+            case PSMTracker_Remote:
+                {
+                    ImGui::BulletText("Controller Type: Remote");
+                } break;
             default:
                 assert(0 && "Unreachable");
             }
@@ -2,7 +2,102 @@
 #include "MathAlignment.h"
 #include "Eigen/SVD"
 #include "Eigen/Dense"
+#include <algorithm>
 #include <iostream>
+#include <vector>
+
+//-- constants -----
+static const int k_soft_posit_max_points = 32;
+static const int k_soft_posit_max_starts = 4; // canned starts when there is no usable prediction
+static const int k_soft_posit_sinkhorn_iterations = 20;
+static const double k_soft_posit_beta_final = 0.5; // 1/px^2
+static const double k_soft_posit_beta_update = 1.05; // slowest annealing rate, from the paper
+static const double k_soft_posit_max_exponent = 60.0;
+static const double k_soft_posit_min_facing_cos = -0.17; // model points facing up to ~100 degrees away still count as visible
+static const int k_soft_posit_refine_iterations = 10;
+
+static const double k_bundle_adjustment_huber_threshold_px = 2.0;
+static const double k_bundle_adjustment_position_prior_sigma = 10.0; // world units (cm in the service)
+static const double k_bundle_adjustment_orientation_prior_sigma = 0.1; // radians
+static const double k_bundle_adjustment_intrinsics_prior_sigma_px = 20.0;
+static const double k_bundle_adjustment_min_depth = 1e-3;
+static const double k_bundle_adjustment_behind_camera_residual_px = 1e4;
+static const double k_bundle_adjustment_initial_lambda = 1e-3;
+static const double k_bundle_adjustment_max_lambda = 1e10;
+static const double k_bundle_adjustment_min_relative_cost_decrease = 1e-9;
+static const int k_bundle_adjustment_point_iterations = 10;
+
+static const int k_streaming_ellipsoid_batch_size = 32; // monomial columns per rank update
+static const int k_streaming_ellipsoid_min_samples = 10; // 9 degrees of freedom
+static const int k_streaming_ellipsoid_min_gating_samples = 50; // trust the fit enough to reject with it
+static const float k_streaming_ellipsoid_rejection_rate_decay = 0.99f; // ~100 sample window
+static const float k_streaming_ellipsoid_restart_rejection_rate = 0.5f;
+
+//-- private definitions -----
+struct SoftPositResult
+{
+    Eigen::Matrix3f rotation;
+    Eigen::Vector3f position;
+    int correspondences[k_soft_posit_max_points];
+    int match_count;
+    float reprojection_error_px;
+};
+
+// Working copy of a camera, the rotation is camera to world
+struct BundleAdjustmentCameraState
+{
+    Eigen::Matrix3d rotation;
+    Eigen::Vector3d position;
+    double focal_length_x, focal_length_y;
+    double principal_x, principal_y;
+};
+
+typedef std::vector<BundleAdjustmentCameraState, Eigen::aligned_allocator<BundleAdjustmentCameraState> > BundleAdjustmentCameraList;
+typedef std::vector<Eigen::Vector3d, Eigen::aligned_allocator<Eigen::Vector3d> > BundleAdjustmentPointList;
+
+//-- prototypes -----
+static bool soft_posit_anneal(
+    const Eigen::Vector3f *model_points, const Eigen::Vector3f *model_normals, const int model_point_count,
+    const Eigen::Vector2f *image_points, const int image_point_count,
+    const float focal_length_px, const float image_noise_px,
+    const Eigen::Matrix3f &initial_rotation, const Eigen::Vector3f &initial_position,
+    const int iteration_count,
+    SoftPositResult &out_result);
+static void soft_posit_compute_visibility(
+    const Eigen::Vector3f *model_points, const Eigen::Vector3f *model_normals, const int model_point_count,
+    const Eigen::Matrix3d &R, const Eigen::Vector3d &T,
+    bool *out_visible);
+static bool soft_posit_update_pose(
+    const Eigen::Vector3f *model_points, const int model_point_count,
+    const Eigen::Vector2f *image_points, const int image_point_count,
+    const double f,
+    const double m[][k_soft_posit_max_points + 1],
+    Eigen::Matrix3d &R, Eigen::Vector3d &T);
+static bool bundle_adjustment_project(
+    const BundleAdjustmentCameraState &camera, const Eigen::Vector3d &world_point,
+    Eigen::Vector2d &out_pixel, Eigen::Vector3d &out_camera_point);
+static double bundle_adjustment_compute_residual(
+    const BundleAdjustmentCameraState &camera, const Eigen::Vector3d &world_point,
+    const Eigen::Vector2f &observed_pixel);
+static double bundle_adjustment_huber_cost(const double residual_px);
+static double bundle_adjustment_huber_weight(const double residual_px);
+static bool bundle_adjustment_triangulate_point(
+    const BundleAdjustmentCameraList &cameras,
+    const EigenBundleAdjustmentObservation *observations, const std::vector<int> &point_observations,
+    Eigen::Vector3d &out_point);
+static void bundle_adjustment_refine_point(
+    const BundleAdjustmentCameraList &cameras,
+    const EigenBundleAdjustmentObservation *observations, const std::vector<int> &point_observations,
+    Eigen::Vector3d &point);
+static double bundle_adjustment_compute_cost(
+    const BundleAdjustmentCameraList &cameras, const BundleAdjustmentCameraList &initial_cameras,
+    const BundleAdjustmentPointList &points,
+    const EigenBundleAdjustmentObservation *observations, const std::vector<int> &used_observations,
+    const bool refine_intrinsics);
+static double bundle_adjustment_compute_rms(
+    const BundleAdjustmentCameraList &cameras, const BundleAdjustmentPointList &points,
+    const EigenBundleAdjustmentObservation *observations, const std::vector<int> &used_observations,
+    const int camera_count, float *out_camera_rms_px);
 
 //-- public methods -----
 Eigen::Quaternionf
@@ -388,6 +483,198 @@ eigen_alignment_fit_least_squares_axis_aligned_ellipsoid(
     }
 }
 
+int
+eigen_alignment_streaming_ellipsoid_add_samples(
+    EigenStreamingEllipsoidFit &fit,
+    const Eigen::Vector3f *points, const int point_count,
+    const float outlier_tolerance,
+    const float forget_factor)
+{
+    // Monomials of the accepted samples are gathered into a fixed size block
+    // and folded into the scatter matrix with one rank update per block
+    Eigen::Matrix<double, 10, k_streaming_ellipsoid_batch_size> monomials;
+    int batch_count = 0;
+    int accepted_count = 0;
+
+    for (int point_index = 0; point_index <= point_count; ++point_index)
+    {
+        if (batch_count == k_streaming_ellipsoid_batch_size ||
+            (point_index == point_count && batch_count > 0))
+        {
+            if (forget_factor < 1.f)
+            {
+                const double decay = pow(static_cast<double>(forget_factor), batch_count);
+
+                fit.scatter *= decay;
+                fit.weight_sum *= decay;
+            }
+
+            fit.scatter.selfadjointView<Eigen::Lower>().rankUpdate(monomials.leftCols(batch_count));
+            fit.weight_sum += static_cast<double>(batch_count);
+            batch_count = 0;
+        }
+
+        if (point_index == point_count)
+        {
+            break;
+        }
+
+        const Eigen::Vector3f &point = points[point_index];
+
+        if (fit.bHasFit && fit.sample_count >= k_streaming_ellipsoid_min_gating_samples)
+        {
+            const float radius = eigen_alignment_project_point_on_ellipsoid_basis(point, fit.ellipsoid).norm();
+            const bool bRejected = fabsf(radius - 1.f) > outlier_tolerance;
+
+            fit.rejection_rate =
+                k_streaming_ellipsoid_rejection_rate_decay*fit.rejection_rate +
+                (1.f - k_streaming_ellipsoid_rejection_rate_decay)*(bRejected ? 1.f : 0.f);
+
+            if (bRejected)
+            {
+                ++fit.rejected_count;
+
+                if (fit.rejection_rate < k_streaming_ellipsoid_restart_rejection_rate)
+                {
+                    continue;
+                }
+
+                // The samples stopped agreeing with the fit for good, start over from this one
+                const int rejected_count = fit.rejected_count;
+                fit.clear();
+                fit.rejected_count = rejected_count;
+                batch_count = 0;
+                accepted_count = 0;
+            }
+        }
+
+        if (!fit.bHasReference)
+        {
+            fit.reference_point = point.cast<double>();
+            fit.bHasReference = true;
+        }
+
+        const Eigen::Vector3d u = point.cast<double>() - fit.reference_point;
+        const double x = u.x(), y = u.y(), z = u.z();
+
+        monomials.col(batch_count) << x*x, y*y, z*z, 2.0*x*y, 2.0*x*z, 2.0*y*z, 2.0*x, 2.0*y, 2.0*z, 1.0;
+        ++batch_count;
+        ++accepted_count;
+        ++fit.sample_count;
+    }
+
+    return accepted_count;
+}
+
+bool
+eigen_alignment_streaming_ellipsoid_solve(EigenStreamingEllipsoidFit &fit)
+{
+    if (fit.sample_count < k_streaming_ellipsoid_min_samples || fit.weight_sum <= k_real_epsilon)
+    {
+        return false;
+    }
+
+    const Eigen::Matrix<double, 10, 10> S = fit.scatter.selfadjointView<Eigen::Lower>();
+    const double W = S(9, 9);
+
+    // Condition the problem: move the sums to the sample mean and unit rms radius.
+    // Every monomial of u' = s*(u - t) is a linear combination of the monomials of u,
+    // so the sums transform as S' = T*S*T'.
+    const Eigen::Vector3d t = Eigen::Vector3d(S(6, 9), S(7, 9), S(8, 9)) / (2.0*W);
+    const double mean_squared_radius = (S(0, 9) + S(1, 9) + S(2, 9)) / W - t.squaredNorm();
+    if (mean_squared_radius <= k_real_epsilon)
+    {
+        return false;
+    }
+
+    const double s = 1.0 / sqrt(mean_squared_radius);
+    const double s2 = s*s;
+    Eigen::Matrix<double, 10, 10> T = Eigen::Matrix<double, 10, 10>::Zero();
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        // x'^2 = s^2*x^2 - s^2*t_x*(2x) + s^2*t_x^2
+        T(axis, axis) = s2;
+        T(axis, 6 + axis) = -s2*t[axis];
+        T(axis, 9) = s2*t[axis]*t[axis];
+
+        // 2x' = s*(2x) - 2*s*t_x
+        T(6 + axis, 6 + axis) = s;
+        T(6 + axis, 9) = -2.0*s*t[axis];
+    }
+    const int cross_axes[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+    for (int cross_index = 0; cross_index < 3; ++cross_index)
+    {
+        // 2x'y' = s^2*(2xy) - s^2*t_y*(2x) - s^2*t_x*(2y) + 2*s^2*t_x*t_y
+        const int a = cross_axes[cross_index][0];
+        const int b = cross_axes[cross_index][1];
+
+        T(3 + cross_index, 3 + cross_index) = s2;
+        T(3 + cross_index, 6 + a) = -s2*t[b];
+        T(3 + cross_index, 6 + b) = -s2*t[a];
+        T(3 + cross_index, 9) = 2.0*s2*t[a]*t[b];
+    }
+    T(9, 9) = 1.0;
+
+    // The quadric coefficients minimizing the algebraic error (with |v|=1)
+    // are the eigenvector of the smallest eigenvalue
+    const Eigen::Matrix<double, 10, 10> S_conditioned = T*S*T.transpose();
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double, 10, 10> > quadric_solver(S_conditioned);
+    if (quadric_solver.info() != Eigen::Success)
+    {
+        return false;
+    }
+
+    const Eigen::Matrix<double, 10, 1> v = quadric_solver.eigenvectors().col(0);
+    Eigen::Matrix3d A;
+    A << v(0), v(3), v(4),
+         v(3), v(1), v(5),
+         v(4), v(5), v(2);
+    const Eigen::Vector3d b(v(6), v(7), v(8));
+
+    // u'A u' + 2b'u' + d = (u' - c)'A(u' - c) - gamma
+    Eigen::Matrix3d A_inverse;
+    bool bInvertible = false;
+    A.computeInverseWithCheck(A_inverse, bInvertible, 1e-12);
+    if (!bInvertible)
+    {
+        return false;
+    }
+
+    const Eigen::Vector3d center = -A_inverse*b;
+    const double gamma = center.dot(A*center) - v(9);
+    if (fabs(gamma) <= 1e-12)
+    {
+        return false;
+    }
+
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> shape_solver(A / gamma);
+    if (shape_solver.info() != Eigen::Success || shape_solver.eigenvalues().minCoeff() <= 0.0)
+    {
+        // Hyperboloid or worse, the samples don't cover enough of the surface yet
+        return false;
+    }
+
+    Eigen::Matrix3d basis = shape_solver.eigenvectors();
+    if (basis.determinant() < 0.0)
+    {
+        basis.col(2) = -basis.col(2);
+    }
+
+    // Back to the sample space
+    fit.ellipsoid.center = (fit.reference_point + t + center / s).cast<float>();
+    fit.ellipsoid.basis = basis.cast<float>();
+    fit.ellipsoid.extents =
+        Eigen::Vector3d(
+            1.0 / sqrt(shape_solver.eigenvalues()(0)),
+            1.0 / sqrt(shape_solver.eigenvalues()(1)),
+            1.0 / sqrt(shape_solver.eigenvalues()(2))).cast<float>() / static_cast<float>(s);
+    fit.ellipsoid.error =
+        static_cast<float>(sqrt(std::max(quadric_solver.eigenvalues()(0), 0.0) / W) / fabs(gamma));
+    fit.bHasFit = true;
+
+    return true;
+}
+
 Eigen::Vector3f
 eigen_alignment_project_point_on_ellipsoid_basis(
     const Eigen::Vector3f &point,
@@ -773,184 +1060,970 @@ eigen_alignment_fit_focal_cone_to_sphere(
 
 
 bool
-eigen_quaternion_compute_normalized_weighted_average(
-    const Eigen::Quaternionf *quaternions,
-    const float *weights,
-    const int count,
-    Eigen::Quaternionf *out_result)
+eigen_alignment_fit_focal_cone_to_sphere_robust(
+    const Eigen::Vector2f *points,
+    const float *point_weights,
+    const int point_count,
+    const float sphere_radius,
+    const float focal_length_pts,
+    const int max_iterations,
+    Eigen::Vector3f *out_sphere_center,
+    EigenFitEllipse *out_ellipse_projection)
 {
-    bool success = false;
+    // Huber tuning constant (95% efficiency for gaussian residuals)
+    const float k_huber_threshold = 1.345f;
 
-    if (count == 1)
+    if (point_count < 3)
     {
-        *out_result= quaternions[0];
-        success= true;
+        return false;
     }
-    else if (count == 2)
-    {
-		assert(weights == nullptr || weights[0] >= 0);
-		assert(weights == nullptr || weights[1] >= 0);
-		const float w0 = (weights != nullptr) ? weights[0] : 0.5f;
-		const float w1 = (weights != nullptr) ? weights[1] : 0.5f;
-        const float u= safe_divide_with_default(w1, w0 + w1, 0.f);
 
-        *out_result= eigen_quaternion_normalized_lerp(quaternions[0], quaternions[1], u);
-        success= true;
-    }
-    else if (count > 2)
-    {
-        // http://stackoverflow.com/questions/12374087/average-of-multiple-quaternions
-        Eigen::MatrixXf q(4, count);
-        Eigen::MatrixXf q_transpose(count, 4);
+    // Same linear system as above: [x y -|p|] * [Bx By c]^T = -f^2 for every contour point.
+    // Accumulating the 3x3 normal equations keeps this allocation free.
+    const float zz = focal_length_pts * focal_length_pts;
+    const float b = -zz;
+    float robust_sigma = 0.f;
+    Eigen::Vector3f Bx_By_c = Eigen::Vector3f::Zero();
 
-        float total_weight= 0.f;
-		if (weights != nullptr)
-		{
-			for (int index = 0; index < count; ++index)
-			{
-				assert(weights[index] >= 0);
-				total_weight += weights[index];
-			}
-		}
+    for (int iteration = 0; iteration <= max_iterations; ++iteration)
+    {
+        Eigen::Matrix3f AtA = Eigen::Matrix3f::Zero();
+        Eigen::Vector3f Atb = Eigen::Vector3f::Zero();
 
-        for (int index = 0; index < count; ++index)
+        for (int i = 0; i < point_count; ++i)
         {
-			// Normalize the weights against the total weight
-            const Eigen::Quaternionf &sample = quaternions[index];
-			const float weight = (weights != nullptr) ? weights[index] : 0.f;
-            const float normalized_weight= safe_divide_with_default(weight, total_weight, 1.f);
+            const Eigen::Vector2f &p = points[i];
+            const Eigen::Vector3f a(p.x(), p.y(), -sqrtf(p.x()*p.x() + p.y()*p.y() + zz));
+            float w = (point_weights != nullptr) ? point_weights[i] : 1.f;
 
-            const float w= sample.w() * normalized_weight;
-            const float x= sample.x() * normalized_weight;
-            const float y= sample.y() * normalized_weight;
-            const float z= sample.z() * normalized_weight;
+            if (iteration > 0 && robust_sigma > k_real_epsilon)
+            {
+                const float residual = fabsf(a.dot(Bx_By_c) - b);
+                const float cutoff = k_huber_threshold * robust_sigma;
 
-            q(0, index) = w;
-            q(1, index) = x;
-            q(2, index) = y;
-            q(3, index) = z;
+                if (residual > cutoff)
+                {
+                    w *= cutoff / residual;
+                }
+            }
 
-            q_transpose(index, 0) = w;
-            q_transpose(index, 1) = x;
-            q_transpose(index, 2) = y;
-            q_transpose(index, 3) = z;
+            AtA += w * (a * a.transpose());
+            Atb += (w * b) * a;
         }
 
-        Eigen::Matrix4f M= q*q_transpose;
+        const Eigen::Vector3f solution = AtA.ldlt().solve(Atb);
+        if (!solution.allFinite())
+        {
+            return false;
+        }
 
-        Eigen::EigenSolver<Eigen::Matrix4f> eigsolv(M);
-        if (eigsolv.info() == Eigen::Success)
+        const float step = (solution - Bx_By_c).norm();
+        Bx_By_c = solution;
+
+        // Robust scale estimate for the next round: weighted RMS of the residuals
+        float weighted_sq_sum = 0.f;
+        float weight_sum = 0.f;
+        for (int i = 0; i < point_count; ++i)
         {
-            int largest_row = 0;
-            float largest_eigenvalue = eigsolv.eigenvalues()[0].real();
-            for (int row_ix = 1; row_ix < 4; ++row_ix) 
-            {
-                if (eigsolv.eigenvalues()[row_ix].real() > largest_eigenvalue)
-                {
-                    largest_eigenvalue = eigsolv.eigenvalues()[row_ix].real();
-                    largest_row = row_ix;
-                }                
-            }
+            const Eigen::Vector2f &p = points[i];
+            const Eigen::Vector3f a(p.x(), p.y(), -sqrtf(p.x()*p.x() + p.y()*p.y() + zz));
+            const float w = (point_weights != nullptr) ? point_weights[i] : 1.f;
+            const float residual = a.dot(Bx_By_c) - b;
 
-            Eigen::Vector4f largest_eigenvector = eigsolv.eigenvectors().col(largest_row).real();
-            float w= largest_eigenvector(0);
-            float x= largest_eigenvector(1);
-            float y= largest_eigenvector(2);
-            float z= largest_eigenvector(3);
+            weighted_sq_sum += w * residual * residual;
+            weight_sum += w;
+        }
+        robust_sigma = (weight_sum > k_real_epsilon) ? sqrtf(weighted_sq_sum / weight_sum) : 0.f;
 
-            *out_result= Eigen::Quaternionf(w, x, y, z).normalized();
-            success= true;
+        if (iteration > 0 && step <= k_real_epsilon * Bx_By_c.norm())
+        {
+            break;
         }
     }
 
-    return success;
+    // Convert the cone parameters into a sphere center (same as the unweighted fit)
+    const float norm_norm_B = sqrtf(Bx_By_c[0] * Bx_By_c[0] + Bx_By_c[1] * Bx_By_c[1] + zz);
+    const float cos_theta = Bx_By_c[2] / norm_norm_B;
+    const float k = cos_theta * cos_theta;
+
+    if (k >= 1.f)
+    {
+        return false;
+    }
+
+    const float norm_B = sphere_radius / sqrtf(1.f - k);
+
+    *out_sphere_center << Bx_By_c[0], Bx_By_c[1], focal_length_pts;
+    *out_sphere_center *= (norm_B / norm_norm_B);
+
+    if (out_ellipse_projection != nullptr)
+    {
+        eigen_alignment_project_ellipse(out_sphere_center, k,
+                                        focal_length_pts, zz,
+                                        out_ellipse_projection);
+
+        out_ellipse_projection->error =
+            eigen_alignment_compute_ellipse_fit_error(
+                points, point_count, *out_ellipse_projection);
+    }
+
+    return out_sphere_center->allFinite();
 }
 
 bool
-eigen_quaternion_compute_weighted_average(
-    const Eigen::Quaterniond *quaternions,
-    const double *weights,
-    const int count,
-    Eigen::Quaterniond *out_result)
+eigen_alignment_soft_posit(
+    const Eigen::Vector3f *model_points,
+    const Eigen::Vector3f *model_normals,
+    const int model_point_count,
+    const Eigen::Vector2f *image_points,
+    const int image_point_count,
+    const float focal_length_px,
+    const float image_noise_px,
+    const Eigen::Quaternionf *initial_orientation,
+    const Eigen::Vector3f *initial_position,
+    const int max_iterations,
+    Eigen::Quaternionf *out_orientation,
+    Eigen::Vector3f *out_position,
+    int *out_correspondences,
+    float *out_reprojection_error_px)
 {
-    bool success = false;
-
-    if (count == 1)
+    if (model_point_count < 3 || image_point_count < 3 ||
+        model_point_count > k_soft_posit_max_points || image_point_count > k_soft_posit_max_points ||
+        focal_length_px <= k_real_epsilon || max_iterations < 1)
     {
-        *out_result= quaternions[0];
-        success= true;
+        return false;
     }
-    else
+
+    // POSIT needs 4 points to be unambiguous, but take 3 if that's all there is
+    const int min_match_count = std::min(image_point_count, 4);
+    int remaining_iterations = max_iterations;
+    SoftPositResult best_result;
+    best_result.match_count = 0;
+    best_result.reprojection_error_px = k_real_max;
+
+    // Start from the prediction with half of the budget
+    if (initial_orientation != nullptr && initial_position != nullptr)
     {
-        // http://stackoverflow.com/questions/12374087/average-of-multiple-quaternions
-        Eigen::MatrixXd q(4, count);
-        Eigen::MatrixXd q_transpose(count, 4);
+        const int guess_iterations = (max_iterations + 1) / 2;
+        SoftPositResult result;
+
+        if (soft_posit_anneal(
+                model_points, model_normals, model_point_count,
+                image_points, image_point_count,
+                focal_length_px, image_noise_px,
+                initial_orientation->normalized().toRotationMatrix(), *initial_position,
+                guess_iterations, result))
+        {
+            best_result = result;
+        }
 
-        for (int index = 0; index < count; ++index)
+        remaining_iterations -= guess_iterations;
+    }
+
+    // Without a prediction (or if it led nowhere) face the model towards the camera at a few
+    // different yaws, at the distance that makes its size match the spread of the image points
+    if (best_result.match_count < min_match_count && remaining_iterations > 0)
+    {
+        Eigen::Vector3f model_centroid = Eigen::Vector3f::Zero();
+        for (int model_index = 0; model_index < model_point_count; ++model_index)
         {
-            const Eigen::Quaterniond &sample = quaternions[index];
-			const double signed_weight= (weights != nullptr) ? weights[index] : 1.f;
-            const double unsigned_weight= fabs(signed_weight);
+            model_centroid += model_points[model_index];
+        }
+        model_centroid /= static_cast<float>(model_point_count);
 
-            const double w= sample.w() * unsigned_weight;
-			// For negative weights, use the conjugate of the quaternion 
-			// (i.e. flip the rotation axis)
-            const double x= sample.x() * signed_weight;
-            const double y= sample.y() * signed_weight;
-            const double z= sample.z() * signed_weight;
+        float model_radius = 0.f;
+        for (int model_index = 0; model_index < model_point_count; ++model_index)
+        {
+            model_radius = fmaxf(model_radius, (model_points[model_index] - model_centroid).norm());
+        }
 
-            q(0, index) = w;
-            q(1, index) = x;
-            q(2, index) = y;
-            q(3, index) = z;
+        Eigen::Vector2f image_centroid = Eigen::Vector2f::Zero();
+        for (int image_index = 0; image_index < image_point_count; ++image_index)
+        {
+            image_centroid += image_points[image_index];
+        }
+        image_centroid /= static_cast<float>(image_point_count);
 
-            q_transpose(index, 0) = w;
-            q_transpose(index, 1) = x;
-            q_transpose(index, 2) = y;
-            q_transpose(index, 3) = z;
+        float image_radius = 0.f;
+        for (int image_index = 0; image_index < image_point_count; ++image_index)
+        {
+            image_radius = fmaxf(image_radius, (image_points[image_index] - image_centroid).norm());
         }
 
-        Eigen::Matrix4d M= q*q_transpose;
+        const float depth = focal_length_px * model_radius / fmaxf(image_radius, 1.f);
+        const Eigen::Vector3f centroid_position(
+            image_centroid.x() * depth / focal_length_px,
+            image_centroid.y() * depth / focal_length_px,
+            depth);
+        const int iterations_per_start = std::max(remaining_iterations / k_soft_posit_max_starts, 1);
 
-        Eigen::EigenSolver<Eigen::Matrix4d> eigsolv(M);
-        if (eigsolv.info() == Eigen::Success)
+        for (int start_index = 0; start_index < k_soft_posit_max_starts; ++start_index)
         {
-            int largest_row = 0;
-            double largest_eigenvalue = eigsolv.eigenvalues()[0].real();
-            for (int row_ix = 1; row_ix < 4; ++row_ix) 
+            const float yaw = k_real_two_pi * static_cast<float>(start_index) / static_cast<float>(k_soft_posit_max_starts);
+            const Eigen::Matrix3f start_rotation = Eigen::AngleAxisf(yaw, Eigen::Vector3f::UnitY()).toRotationMatrix();
+            const Eigen::Vector3f start_position = centroid_position - start_rotation * model_centroid;
+            SoftPositResult result;
+
+            if (soft_posit_anneal(
+                    model_points, model_normals, model_point_count,
+                    image_points, image_point_count,
+                    focal_length_px, image_noise_px,
+                    start_rotation, start_position,
+                    iterations_per_start, result))
             {
-                if (eigsolv.eigenvalues()[row_ix].real() > largest_eigenvalue)
+                if (result.match_count > best_result.match_count ||
+                    (result.match_count == best_result.match_count &&
+                     result.reprojection_error_px < best_result.reprojection_error_px))
                 {
-                    largest_eigenvalue = eigsolv.eigenvalues()[row_ix].real();
-                    largest_row = row_ix;
-                }                
+                    best_result = result;
+                }
             }
+        }
+    }
 
-            Eigen::Vector4d largest_eigenvector = eigsolv.eigenvectors().col(largest_row).real();
-            double w= largest_eigenvector(0);
-            double x= largest_eigenvector(1);
-            double y= largest_eigenvector(2);
-            double z= largest_eigenvector(3);
+    if (best_result.match_count < min_match_count)
+    {
+        return false;
+    }
 
-            *out_result= Eigen::Quaterniond(w, x, y, z).normalized();
-            success= true;
-        }
+    *out_orientation = Eigen::Quaternionf(best_result.rotation).normalized();
+    *out_position = best_result.position;
+
+    if (out_correspondences != nullptr)
+    {
+        std::copy(best_result.correspondences, best_result.correspondences + image_point_count, out_correspondences);
     }
 
-    return success;
+    if (out_reprojection_error_px != nullptr)
+    {
+        *out_reprojection_error_px = best_result.reprojection_error_px;
+    }
+
+    return true;
 }
 
-void 
-eigen_vector3f_compute_mean_and_variance(
-	const Eigen::Vector3f *samples,
-    const int sample_count,
-	Eigen::Vector3f *out_mean,
-    Eigen::Vector3f *out_variance)
+bool
+eigen_alignment_bundle_adjust_cameras(
+    EigenBundleAdjustmentCamera *cameras,
+    const int camera_count,
+    const EigenBundleAdjustmentObservation *observations,
+    const int observation_count,
+    const int point_count,
+    const bool refine_intrinsics,
+    const int max_iterations,
+    EigenBundleAdjustmentResult *out_result,
+    float *out_initial_camera_rms_px,
+    float *out_final_camera_rms_px)
 {
-	assert(out_mean != nullptr || out_variance != nullptr);
+    out_result->clear();
 
-	Eigen::Vector3f mean= Eigen::Vector3f::Zero();
-	Eigen::Vector3f variance= Eigen::Vector3f::Zero();
+    if (camera_count < 2 || observation_count < 2 || point_count < 1 || max_iterations < 1)
+    {
+        return false;
+    }
+
+    // Work in double precision on rotation matrices
+    BundleAdjustmentCameraList initial_cameras(camera_count);
+    for (int camera_index = 0; camera_index < camera_count; ++camera_index)
+    {
+        const EigenBundleAdjustmentCamera &source = cameras[camera_index];
+        BundleAdjustmentCameraState &camera = initial_cameras[camera_index];
+
+        if (source.focal_length_x <= k_real_epsilon || source.focal_length_y <= k_real_epsilon)
+        {
+            return false;
+        }
+
+        camera.rotation = source.orientation.normalized().toRotationMatrix().cast<double>();
+        camera.position = source.position.cast<double>();
+        camera.focal_length_x = source.focal_length_x;
+        camera.focal_length_y = source.focal_length_y;
+        camera.principal_x = source.principal_x;
+        camera.principal_y = source.principal_y;
+    }
+
+    // Group the observations by point
+    std::vector< std::vector<int> > point_observations(point_count);
+    for (int observation_index = 0; observation_index < observation_count; ++observation_index)
+    {
+        const EigenBundleAdjustmentObservation &observation = observations[observation_index];
+
+        if (observation.camera_index >= 0 && observation.camera_index < camera_count &&
+            observation.point_index >= 0 && observation.point_index < point_count &&
+            observation.pixel.allFinite())
+        {
+            point_observations[observation.point_index].push_back(observation_index);
+        }
+    }
+
+    // Triangulate every point seen by at least two different cameras,
+    // then give it the best position it can have with the initial cameras
+    BundleAdjustmentPointList points(point_count, Eigen::Vector3d::Zero());
+    std::vector<int> used_points;
+    std::vector<int> used_observations;
+
+    for (int point_index = 0; point_index < point_count; ++point_index)
+    {
+        const std::vector<int> &point_observation_list = point_observations[point_index];
+        bool bSeenByTwoCameras = false;
+
+        for (size_t list_index = 1; list_index < point_observation_list.size(); ++list_index)
+        {
+            if (observations[point_observation_list[list_index]].camera_index !=
+                observations[point_observation_list[0]].camera_index)
+            {
+                bSeenByTwoCameras = true;
+                break;
+            }
+        }
+
+        if (bSeenByTwoCameras &&
+            bundle_adjustment_triangulate_point(initial_cameras, observations, point_observation_list, points[point_index]))
+        {
+            bundle_adjustment_refine_point(initial_cameras, observations, point_observation_list, points[point_index]);
+
+            used_points.push_back(point_index);
+            used_observations.insert(
+                used_observations.end(), point_observation_list.begin(), point_observation_list.end());
+        }
+    }
+
+    out_result->point_count = static_cast<int>(used_points.size());
+    out_result->observation_count = static_cast<int>(used_observations.size());
+
+    if (used_points.empty())
+    {
+        return false;
+    }
+
+    out_result->initial_rms_px = static_cast<float>(
+        bundle_adjustment_compute_rms(
+            initial_cameras, points, observations, used_observations, camera_count, out_initial_camera_rms_px));
+
+    // Levenberg-Marquardt on [camera blocks | point blocks].
+    // Camera block: rotation delta (3), position delta (3) and optionally fx, fy, cx, cy.
+    // The point blocks are eliminated with the Schur complement S = U - W*V^-1*W^T,
+    // S is small (6 or 10 per camera) and solved densely.
+    const int block_size = refine_intrinsics ? 10 : 6;
+    const int camera_parameter_count = camera_count * block_size;
+
+    BundleAdjustmentCameraList current_cameras = initial_cameras;
+    double current_cost =
+        bundle_adjustment_compute_cost(
+            current_cameras, initial_cameras, points, observations, used_observations, refine_intrinsics);
+    double lambda = k_bundle_adjustment_initial_lambda;
+
+    Eigen::MatrixXd U(camera_parameter_count, camera_parameter_count);
+    Eigen::VectorXd camera_gradient(camera_parameter_count);
+    std::vector<Eigen::Matrix3d, Eigen::aligned_allocator<Eigen::Matrix3d> > V(point_count);
+    std::vector<Eigen::Vector3d, Eigen::aligned_allocator<Eigen::Vector3d> > point_gradient(point_count);
+    std::vector<Eigen::Matrix<double, Eigen::Dynamic, 3> > W(observation_count);
+    std::vector<bool> observation_in_front(observation_count, false);
+
+    int iteration = 0;
+    while (iteration < max_iterations)
+    {
+        ++iteration;
+
+        // Build the normal equations at the current estimate
+        U.setZero();
+        camera_gradient.setZero();
+
+        for (int point_index : used_points)
+        {
+            V[point_index].setZero();
+            point_gradient[point_index].setZero();
+        }
+
+        for (int observation_index : used_observations)
+        {
+            const EigenBundleAdjustmentObservation &observation = observations[observation_index];
+            const BundleAdjustmentCameraState &camera = current_cameras[observation.camera_index];
+            const Eigen::Vector3d &point = points[observation.point_index];
+
+            Eigen::Vector2d projection;
+            Eigen::Vector3d p;
+            observation_in_front[observation_index] = bundle_adjustment_project(camera, point, projection, p);
+            if (!observation_in_front[observation_index])
+            {
+                continue;
+            }
+
+            const Eigen::Vector2d residual = projection - observation.pixel.cast<double>();
+            const double weight = bundle_adjustment_huber_weight(residual.norm());
+
+            // d(u,v)/d(camera space point)
+            const double inv_z = 1.0 / p.z();
+            Eigen::Matrix<double, 2, 3> J_proj;
+            J_proj <<
+                camera.focal_length_x * inv_z, 0.0, -camera.focal_length_x * p.x() * inv_z * inv_z,
+                0.0, -camera.focal_length_y * inv_z, camera.focal_length_y * p.y() * inv_z * inv_z;
+
+            // p = R^T*(X - c) with R <- R*exp(dtheta): dp/dtheta = [p]x, dp/dc = -R^T, dp/dX = R^T
+            Eigen::Matrix3d p_cross;
+            p_cross <<
+                0.0, -p.z(), p.y(),
+                p.z(), 0.0, -p.x(),
+                -p.y(), p.x(), 0.0;
+
+            Eigen::Matrix<double, 2, Eigen::Dynamic> J_camera(2, block_size);
+            J_camera.block<2, 3>(0, 0) = J_proj * p_cross;
+            J_camera.block<2, 3>(0, 3) = -J_proj * camera.rotation.transpose();
+            if (refine_intrinsics)
+            {
+                J_camera.block<2, 4>(0, 6) <<
+                    p.x() * inv_z, 0.0, 1.0, 0.0,
+                    0.0, -p.y() * inv_z, 0.0, 1.0;
+            }
+
+            const Eigen::Matrix<double, 2, 3> J_point = J_proj * camera.rotation.transpose();
+            const int camera_offset = observation.camera_index * block_size;
+
+            U.block(camera_offset, camera_offset, block_size, block_size) += weight * J_camera.transpose() * J_camera;
+            camera_gradient.segment(camera_offset, block_size) += weight * J_camera.transpose() * residual;
+            V[observation.point_index] += weight * J_point.transpose() * J_point;
+            point_gradient[observation.point_index] += weight * J_point.transpose() * residual;
+            W[observation_index] = weight * J_camera.transpose() * J_point;
+        }
+
+        // Weak priors toward the initial cameras hold the gauge
+        for (int camera_index = 0; camera_index < camera_count; ++camera_index)
+        {
+            const BundleAdjustmentCameraState &camera = current_cameras[camera_index];
+            const BundleAdjustmentCameraState &initial_camera = initial_cameras[camera_index];
+            const int camera_offset = camera_index * block_size;
+
+            const Eigen::AngleAxisd rotation_error(initial_camera.rotation.transpose() * camera.rotation);
+            const double orientation_weight =
+                1.0 / (k_bundle_adjustment_orientation_prior_sigma * k_bundle_adjustment_orientation_prior_sigma);
+            const double position_weight =
+                1.0 / (k_bundle_adjustment_position_prior_sigma * k_bundle_adjustment_position_prior_sigma);
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                U(camera_offset + axis, camera_offset + axis) += orientation_weight;
+                U(camera_offset + 3 + axis, camera_offset + 3 + axis) += position_weight;
+            }
+            camera_gradient.segment<3>(camera_offset) +=
+                orientation_weight * rotation_error.angle() * rotation_error.axis();
+            camera_gradient.segment<3>(camera_offset + 3) +=
+                position_weight * (camera.position - initial_camera.position);
+
+            if (refine_intrinsics)
+            {
+                const double intrinsics_weight =
+                    1.0 / (k_bundle_adjustment_intrinsics_prior_sigma_px * k_bundle_adjustment_intrinsics_prior_sigma_px);
+
+                for (int parameter = 6; parameter < 10; ++parameter)
+                {
+                    U(camera_offset + parameter, camera_offset + parameter) += intrinsics_weight;
+                }
+                camera_gradient(camera_offset + 6) += intrinsics_weight * (camera.focal_length_x - initial_camera.focal_length_x);
+                camera_gradient(camera_offset + 7) += intrinsics_weight * (camera.focal_length_y - initial_camera.focal_length_y);
+                camera_gradient(camera_offset + 8) += intrinsics_weight * (camera.principal_x - initial_camera.principal_x);
+                camera_gradient(camera_offset + 9) += intrinsics_weight * (camera.principal_y - initial_camera.principal_y);
+            }
+        }
+
+        // Try damped steps until one lowers the cost
+        bool bStepAccepted = false;
+        bool bConverged = false;
+
+        while (!bStepAccepted && lambda <= k_bundle_adjustment_max_lambda)
+        {
+            // Reduced camera system
+            Eigen::MatrixXd S = U;
+            for (int parameter = 0; parameter < camera_parameter_count; ++parameter)
+            {
+                S(parameter, parameter) += lambda * std::max(U(parameter, parameter), 1e-9);
+            }
+            Eigen::VectorXd reduced_gradient = -camera_gradient;
+
+            std::vector<Eigen::Matrix3d, Eigen::aligned_allocator<Eigen::Matrix3d> > V_inverse(point_count);
+
+            for (int point_index : used_points)
+            {
+                Eigen::Matrix3d V_damped = V[point_index];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    V_damped(axis, axis) += lambda * std::max(V_damped(axis, axis), 1e-9);
+                }
+
+                // A point no camera sees from the front this round stays where it is
+                bool bInvertible = false;
+                V_damped.computeInverseWithCheck(V_inverse[point_index], bInvertible);
+                if (!bInvertible)
+                {
+                    V_inverse[point_index].setZero();
+                    continue;
+                }
+
+                const std::vector<int> &point_observation_list = point_observations[point_index];
+                for (int observation_a : point_observation_list)
+                {
+                    if (!observation_in_front[observation_a])
+                        continue;
+
+                    const int offset_a = observations[observation_a].camera_index * block_size;
+                    const Eigen::Matrix<double, Eigen::Dynamic, 3> WV = W[observation_a] * V_inverse[point_index];
+
+                    reduced_gradient.segment(offset_a, block_size) += WV * point_gradient[point_index];
+
+                    for (int observation_b : point_observation_list)
+                    {
+                        if (!observation_in_front[observation_b])
+                            continue;
+
+                        const int offset_b = observations[observation_b].camera_index * block_size;
+                        S.block(offset_a, offset_b, block_size, block_size) -= WV * W[observation_b].transpose();
+                    }
+                }
+            }
+
+            Eigen::VectorXd camera_step;
+            bool bSolved = false;
+            const Eigen::LDLT<Eigen::MatrixXd> ldlt(S);
+            if (ldlt.info() == Eigen::Success)
+            {
+                camera_step = ldlt.solve(reduced_gradient);
+                bSolved = camera_step.allFinite();
+            }
+
+            if (!bSolved)
+            {
+                lambda *= 10.0;
+                continue;
+            }
+
+            // Apply the step to copies of the cameras and points
+            BundleAdjustmentCameraList candidate_cameras = current_cameras;
+            for (int camera_index = 0; camera_index < camera_count; ++camera_index)
+            {
+                BundleAdjustmentCameraState &camera = candidate_cameras[camera_index];
+                const Eigen::VectorXd step = camera_step.segment(camera_index * block_size, block_size);
+                const Eigen::Vector3d rotation_step = step.head<3>();
+                const double rotation_angle = rotation_step.norm();
+
+                if (rotation_angle > 0.0)
+                {
+                    camera.rotation =
+                        camera.rotation * Eigen::AngleAxisd(rotation_angle, rotation_step / rotation_angle).toRotationMatrix();
+                }
+                camera.position += step.segment<3>(3);
+
+                if (refine_intrinsics)
+                {
+                    camera.focal_length_x += step(6);
+                    camera.focal_length_y += step(7);
+                    camera.principal_x += step(8);
+                    camera.principal_y += step(9);
+                }
+            }
+
+            BundleAdjustmentPointList candidate_points = points;
+            for (int point_index : used_points)
+            {
+                Eigen::Vector3d camera_term = point_gradient[point_index];
+                for (int observation_index : point_observations[point_index])
+                {
+                    if (observation_in_front[observation_index])
+                    {
+                        const int camera_offset = observations[observation_index].camera_index * block_size;
+                        camera_term += W[observation_index].transpose() * camera_step.segment(camera_offset, block_size);
+                    }
+                }
+
+                candidate_points[point_index] -= V_inverse[point_index] * camera_term;
+            }
+
+            const double candidate_cost =
+                bundle_adjustment_compute_cost(
+                    candidate_cameras, initial_cameras, candidate_points, observations, used_observations, refine_intrinsics);
+
+            if (candidate_cost < current_cost)
+            {
+                bConverged = (current_cost - candidate_cost) < k_bundle_adjustment_min_relative_cost_decrease * current_cost;
+                current_cameras = candidate_cameras;
+                points = candidate_points;
+                current_cost = candidate_cost;
+                lambda = std::max(lambda * 0.1, 1e-12);
+                bStepAccepted = true;
+            }
+            else
+            {
+                lambda *= 10.0;
+            }
+        }
+
+        if (!bStepAccepted || bConverged)
+        {
+            break;
+        }
+    }
+
+    out_result->iteration_count = iteration;
+    out_result->final_rms_px = static_cast<float>(
+        bundle_adjustment_compute_rms(
+            current_cameras, points, observations, used_observations, camera_count, out_final_camera_rms_px));
+
+    for (int camera_index = 0; camera_index < camera_count; ++camera_index)
+    {
+        const BundleAdjustmentCameraState &source = current_cameras[camera_index];
+        EigenBundleAdjustmentCamera &camera = cameras[camera_index];
+
+        camera.orientation = Eigen::Quaternionf(source.rotation.cast<float>()).normalized();
+        camera.position = source.position.cast<float>();
+        camera.focal_length_x = static_cast<float>(source.focal_length_x);
+        camera.focal_length_y = static_cast<float>(source.focal_length_y);
+        camera.principal_x = static_cast<float>(source.principal_x);
+        camera.principal_y = static_cast<float>(source.principal_y);
+    }
+
+    return true;
+}
+
+bool
+eigen_alignment_refine_camera_pose(
+    EigenBundleAdjustmentCamera *camera,
+    const Eigen::Vector3f *world_points,
+    const Eigen::Vector2f *pixels,
+    const int point_count,
+    const int max_iterations,
+    float *out_initial_rms_px,
+    float *out_final_rms_px)
+{
+    if (point_count < 3 || max_iterations < 1 ||
+        camera->focal_length_x <= k_real_epsilon || camera->focal_length_y <= k_real_epsilon)
+    {
+        return false;
+    }
+
+    BundleAdjustmentCameraState state;
+    state.rotation = camera->orientation.normalized().toRotationMatrix().cast<double>();
+    state.position = camera->position.cast<double>();
+    state.focal_length_x = camera->focal_length_x;
+    state.focal_length_y = camera->focal_length_y;
+    state.principal_x = camera->principal_x;
+    state.principal_y = camera->principal_y;
+
+    BundleAdjustmentPointList points(point_count);
+    for (int point_index = 0; point_index < point_count; ++point_index)
+    {
+        points[point_index] = world_points[point_index].cast<double>();
+    }
+
+    double cost = 0.0;
+    double squared_error = 0.0;
+    for (int point_index = 0; point_index < point_count; ++point_index)
+    {
+        const double residual = bundle_adjustment_compute_residual(state, points[point_index], pixels[point_index]);
+
+        cost += bundle_adjustment_huber_cost(residual);
+        squared_error += residual*residual;
+    }
+
+    if (out_initial_rms_px != nullptr)
+    {
+        *out_initial_rms_px = static_cast<float>(sqrt(squared_error / point_count));
+    }
+
+    // Levenberg-Marquardt on the rotation delta (3) and the position delta (3)
+    double lambda = k_bundle_adjustment_initial_lambda;
+    int front_count = 0;
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        Eigen::Matrix<double, 6, 6> JtJ = Eigen::Matrix<double, 6, 6>::Zero();
+        Eigen::Matrix<double, 6, 1> Jtr = Eigen::Matrix<double, 6, 1>::Zero();
+
+        front_count = 0;
+        for (int point_index = 0; point_index < point_count; ++point_index)
+        {
+            Eigen::Vector2d projection;
+            Eigen::Vector3d p;
+            if (!bundle_adjustment_project(state, points[point_index], projection, p))
+            {
+                continue;
+            }
+
+            const Eigen::Vector2d residual = projection - pixels[point_index].cast<double>();
+            const double weight = bundle_adjustment_huber_weight(residual.norm());
+            const double inv_z = 1.0 / p.z();
+            Eigen::Matrix<double, 2, 3> J_proj;
+            J_proj <<
+                state.focal_length_x * inv_z, 0.0, -state.focal_length_x * p.x() * inv_z * inv_z,
+                0.0, -state.focal_length_y * inv_z, state.focal_length_y * p.y() * inv_z * inv_z;
+            Eigen::Matrix3d p_cross;
+            p_cross <<
+                0.0, -p.z(), p.y(),
+                p.z(), 0.0, -p.x(),
+                -p.y(), p.x(), 0.0;
+
+            Eigen::Matrix<double, 2, 6> J;
+            J.block<2, 3>(0, 0) = J_proj * p_cross;
+            J.block<2, 3>(0, 3) = -J_proj * state.rotation.transpose();
+
+            JtJ += weight * J.transpose() * J;
+            Jtr += weight * J.transpose() * residual;
+            ++front_count;
+        }
+
+        if (front_count < 3)
+        {
+            return false;
+        }
+
+        bool bStepAccepted = false;
+        bool bConverged = false;
+        while (!bStepAccepted && lambda <= k_bundle_adjustment_max_lambda)
+        {
+            Eigen::Matrix<double, 6, 6> JtJ_damped = JtJ;
+            for (int parameter = 0; parameter < 6; ++parameter)
+            {
+                JtJ_damped(parameter, parameter) += lambda * std::max(JtJ(parameter, parameter), 1e-9);
+            }
+
+            const Eigen::Matrix<double, 6, 1> step = JtJ_damped.ldlt().solve(-Jtr);
+            if (!step.allFinite())
+            {
+                lambda *= 10.0;
+                continue;
+            }
+
+            BundleAdjustmentCameraState candidate = state;
+            const Eigen::Vector3d rotation_step = step.head<3>();
+            const double rotation_angle = rotation_step.norm();
+            if (rotation_angle > 0.0)
+            {
+                candidate.rotation =
+                    candidate.rotation * Eigen::AngleAxisd(rotation_angle, rotation_step / rotation_angle).toRotationMatrix();
+            }
+            candidate.position += step.tail<3>();
+
+            double candidate_cost = 0.0;
+            for (int point_index = 0; point_index < point_count; ++point_index)
+            {
+                candidate_cost += bundle_adjustment_huber_cost(
+                    bundle_adjustment_compute_residual(candidate, points[point_index], pixels[point_index]));
+            }
+
+            if (candidate_cost < cost)
+            {
+                bConverged = (cost - candidate_cost) < k_bundle_adjustment_min_relative_cost_decrease * cost;
+                state = candidate;
+                cost = candidate_cost;
+                lambda = std::max(lambda * 0.1, 1e-12);
+                bStepAccepted = true;
+            }
+            else
+            {
+                lambda *= 10.0;
+            }
+        }
+
+        if (!bStepAccepted || bConverged)
+        {
+            break;
+        }
+    }
+
+    if (out_final_rms_px != nullptr)
+    {
+        squared_error = 0.0;
+        for (int point_index = 0; point_index < point_count; ++point_index)
+        {
+            const double residual = bundle_adjustment_compute_residual(state, points[point_index], pixels[point_index]);
+
+            squared_error += residual*residual;
+        }
+
+        *out_final_rms_px = static_cast<float>(sqrt(squared_error / point_count));
+    }
+
+    camera->orientation = Eigen::Quaternionf(state.rotation.cast<float>()).normalized();
+    camera->position = state.position.cast<float>();
+
+    return true;
+}
+
+bool
+eigen_quaternion_compute_normalized_weighted_average(
+    const Eigen::Quaternionf *quaternions,
+    const float *weights,
+    const int count,
+    Eigen::Quaternionf *out_result)
+{
+    bool success = false;
+
+    if (count == 1)
+    {
+        *out_result= quaternions[0];
+        success= true;
+    }
+    else if (count == 2)
+    {
+		assert(weights == nullptr || weights[0] >= 0);
+		assert(weights == nullptr || weights[1] >= 0);
+		const float w0 = (weights != nullptr) ? weights[0] : 0.5f;
+		const float w1 = (weights != nullptr) ? weights[1] : 0.5f;
+        const float u= safe_divide_with_default(w1, w0 + w1, 0.f);
+
+        *out_result= eigen_quaternion_normalized_lerp(quaternions[0], quaternions[1], u);
+        success= true;
+    }
+    else if (count > 2)
+    {
+        // http://stackoverflow.com/questions/12374087/average-of-multiple-quaternions
+        Eigen::MatrixXf q(4, count);
+        Eigen::MatrixXf q_transpose(count, 4);
+
+        float total_weight= 0.f;
+		if (weights != nullptr)
+		{
+			for (int index = 0; index < count; ++index)
+			{
+				assert(weights[index] >= 0);
+				total_weight += weights[index];
+			}
+		}
+
+        for (int index = 0; index < count; ++index)
+        {
+			// Normalize the weights against the total weight
+            const Eigen::Quaternionf &sample = quaternions[index];
+			const float weight = (weights != nullptr) ? weights[index] : 0.f;
+            const float normalized_weight= safe_divide_with_default(weight, total_weight, 1.f);
+
+            const float w= sample.w() * normalized_weight;
+            const float x= sample.x() * normalized_weight;
+            const float y= sample.y() * normalized_weight;
+            const float z= sample.z() * normalized_weight;
+
+            q(0, index) = w;
+            q(1, index) = x;
+            q(2, index) = y;
+            q(3, index) = z;
+
+            q_transpose(index, 0) = w;
+            q_transpose(index, 1) = x;
+            q_transpose(index, 2) = y;
+            q_transpose(index, 3) = z;
+        }
+
+        Eigen::Matrix4f M= q*q_transpose;
+
+        Eigen::EigenSolver<Eigen::Matrix4f> eigsolv(M);
+        if (eigsolv.info() == Eigen::Success)
+        {
+            int largest_row = 0;
+            float largest_eigenvalue = eigsolv.eigenvalues()[0].real();
+            for (int row_ix = 1; row_ix < 4; ++row_ix) 
+            {
+                if (eigsolv.eigenvalues()[row_ix].real() > largest_eigenvalue)
+                {
+                    largest_eigenvalue = eigsolv.eigenvalues()[row_ix].real();
+                    largest_row = row_ix;
+                }                
+            }
+
+            Eigen::Vector4f largest_eigenvector = eigsolv.eigenvectors().col(largest_row).real();
+            float w= largest_eigenvector(0);
+            float x= largest_eigenvector(1);
+            float y= largest_eigenvector(2);
+            float z= largest_eigenvector(3);
+
+            *out_result= Eigen::Quaternionf(w, x, y, z).normalized();
+            success= true;
+        }
+    }
+
+    return success;
+}
+
+bool
+eigen_quaternion_compute_weighted_average(
+    const Eigen::Quaterniond *quaternions,
+    const double *weights,
+    const int count,
+    Eigen::Quaterniond *out_result)
+{
+    bool success = false;
+
+    if (count == 1)
+    {
+        *out_result= quaternions[0];
+        success= true;
+    }
+    else
+    {
+        // http://stackoverflow.com/questions/12374087/average-of-multiple-quaternions
+        Eigen::MatrixXd q(4, count);
+        Eigen::MatrixXd q_transpose(count, 4);
+
+        for (int index = 0; index < count; ++index)
+        {
+            const Eigen::Quaterniond &sample = quaternions[index];
+			const double signed_weight= (weights != nullptr) ? weights[index] : 1.f;
+            const double unsigned_weight= fabs(signed_weight);
+
+            const double w= sample.w() * unsigned_weight;
+			// For negative weights, use the conjugate of the quaternion 
+			// (i.e. flip the rotation axis)
+            const double x= sample.x() * signed_weight;
+            const double y= sample.y() * signed_weight;
+            const double z= sample.z() * signed_weight;
+
+            q(0, index) = w;
+            q(1, index) = x;
+            q(2, index) = y;
+            q(3, index) = z;
+
+            q_transpose(index, 0) = w;
+            q_transpose(index, 1) = x;
+            q_transpose(index, 2) = y;
+            q_transpose(index, 3) = z;
+        }
+
+        Eigen::Matrix4d M= q*q_transpose;
+
+        Eigen::EigenSolver<Eigen::Matrix4d> eigsolv(M);
+        if (eigsolv.info() == Eigen::Success)
+        {
+            int largest_row = 0;
+            double largest_eigenvalue = eigsolv.eigenvalues()[0].real();
+            for (int row_ix = 1; row_ix < 4; ++row_ix) 
+            {
+                if (eigsolv.eigenvalues()[row_ix].real() > largest_eigenvalue)
+                {
+                    largest_eigenvalue = eigsolv.eigenvalues()[row_ix].real();
+                    largest_row = row_ix;
+                }                
+            }
+
+            Eigen::Vector4d largest_eigenvector = eigsolv.eigenvectors().col(largest_row).real();
+            double w= largest_eigenvector(0);
+            double x= largest_eigenvector(1);
+            double y= largest_eigenvector(2);
+            double z= largest_eigenvector(3);
+
+            *out_result= Eigen::Quaterniond(w, x, y, z).normalized();
+            success= true;
+        }
+    }
+
+    return success;
+}
+
+void 
+eigen_vector3f_compute_mean_and_variance(
+	const Eigen::Vector3f *samples,
+    const int sample_count,
+	Eigen::Vector3f *out_mean,
+    Eigen::Vector3f *out_variance)
+{
+	assert(out_mean != nullptr || out_variance != nullptr);
+
+	Eigen::Vector3f mean= Eigen::Vector3f::Zero();
+	Eigen::Vector3f variance= Eigen::Vector3f::Zero();
 
 	if (sample_count > 0.f)
 	{
@@ -1209,4 +2282,568 @@ eigen_alignment_compute_camera_fundamental_matrix(
 
 	// Compute the fundamental matrix from camera A to camera B
 	F_ab = Kb.inverse().transpose() * E * Ka.inverse();
-}
\ No newline at end of file
+}
+
+//-- private methods -----
+static bool soft_posit_anneal(
+    const Eigen::Vector3f *model_points, const Eigen::Vector3f *model_normals, const int model_point_count,
+    const Eigen::Vector2f *image_points, const int image_point_count,
+    const float focal_length_px, const float image_noise_px,
+    const Eigen::Matrix3f &initial_rotation, const Eigen::Vector3f &initial_position,
+    const int iteration_count,
+    SoftPositResult &out_result)
+{
+    const int J = image_point_count;
+    const int K = model_point_count;
+    const double f = static_cast<double>(focal_length_px);
+
+    // Squared image distance beyond which a pair is more likely an outlier than a match
+    // (99% of a 2 DOF Gaussian with the given noise)
+    const double noise = std::max(static_cast<double>(image_noise_px), 0.5);
+    const double alpha = 9.21 * noise * noise;
+
+    Eigen::Matrix3d R = initial_rotation.cast<double>();
+    Eigen::Vector3d T = initial_position.cast<double>();
+    if (T.z() <= k_real_epsilon)
+    {
+        return false;
+    }
+
+    bool visible[k_soft_posit_max_points];
+    soft_posit_compute_visibility(model_points, model_normals, K, R, T, visible);
+
+    // The paper starts from a fixed, very flat beta and relies on many random starts.
+    // Here beta starts at the scale of the initial reprojection error instead,
+    // otherwise the uniform first assignments collapse the model towards a point.
+    double nearest_error_sum = 0.0;
+    for (int j = 0; j < J; ++j)
+    {
+        double nearest_error_sqrd = k_real_max;
+
+        for (int k = 0; k < K; ++k)
+        {
+            const Eigen::Vector3d C = R * model_points[k].cast<double>() + T;
+
+            if (visible[k] && C.z() > k_real_epsilon)
+            {
+                const double dx = f * C.x() / C.z() - image_points[j].x();
+                const double dy = f * C.y() / C.z() - image_points[j].y();
+
+                nearest_error_sqrd = std::min(nearest_error_sqrd, dx*dx + dy*dy);
+            }
+        }
+
+        nearest_error_sum += nearest_error_sqrd;
+    }
+
+    // Anneal from beta_initial to beta_final at the paper's rate,
+    // or faster if that doesn't fit in the given number of iterations
+    const double beta_initial =
+        std::min(1.0 / std::max(nearest_error_sum / static_cast<double>(J), alpha), k_soft_posit_beta_final);
+    const double beta_update =
+        std::max(
+            pow(k_soft_posit_beta_final / beta_initial, 1.0 / static_cast<double>(std::max(iteration_count - 1, 1))),
+            k_soft_posit_beta_update);
+
+    // Assignment matrix with slack row and column
+    double m[k_soft_posit_max_points + 1][k_soft_posit_max_points + 1];
+    double beta = beta_initial;
+
+    for (int iteration = 0; iteration < iteration_count && beta <= k_soft_posit_beta_final * beta_update; ++iteration)
+    {
+        // Perspective correction terms and distances from the current pose
+        const double s = f / T.z();
+        const Eigen::Vector4d Q1(s * R(0, 0), s * R(0, 1), s * R(0, 2), s * T.x());
+        const Eigen::Vector4d Q2(s * R(1, 0), s * R(1, 1), s * R(1, 2), s * T.y());
+
+        soft_posit_compute_visibility(model_points, model_normals, K, R, T, visible);
+
+        for (int k = 0; k < K; ++k)
+        {
+            const Eigen::Vector3d P = model_points[k].cast<double>();
+            const Eigen::Vector4d Ph(P.x(), P.y(), P.z(), 1.0);
+            const double Q1_Ph = Q1.dot(Ph);
+            const double Q2_Ph = Q2.dot(Ph);
+            const double w = R.row(2).dot(P) / T.z() + 1.0;
+
+            for (int j = 0; j < J; ++j)
+            {
+                if (visible[k])
+                {
+                    const double dx = Q1_Ph - w * image_points[j].x();
+                    const double dy = Q2_Ph - w * image_points[j].y();
+                    const double exponent = std::min(-beta * (dx*dx + dy*dy - alpha), k_soft_posit_max_exponent);
+
+                    m[j][k] = exp(exponent);
+                }
+                else
+                {
+                    m[j][k] = 0.0;
+                }
+            }
+        }
+        for (int j = 0; j <= J; ++j)
+        {
+            m[j][K] = 1.0;
+        }
+        for (int k = 0; k <= K; ++k)
+        {
+            m[J][k] = 1.0;
+        }
+
+        // Sinkhorn: alternately normalize the rows and columns (slack excluded)
+        for (int sinkhorn_iteration = 0; sinkhorn_iteration < k_soft_posit_sinkhorn_iterations; ++sinkhorn_iteration)
+        {
+            for (int j = 0; j < J; ++j)
+            {
+                double row_sum = 0.0;
+                for (int k = 0; k <= K; ++k)
+                {
+                    row_sum += m[j][k];
+                }
+                for (int k = 0; k <= K; ++k)
+                {
+                    m[j][k] /= row_sum;
+                }
+            }
+
+            for (int k = 0; k < K; ++k)
+            {
+                double column_sum = 0.0;
+                for (int j = 0; j <= J; ++j)
+                {
+                    column_sum += m[j][k];
+                }
+                for (int j = 0; j <= J; ++j)
+                {
+                    m[j][k] /= column_sum;
+                }
+            }
+        }
+
+        if (!soft_posit_update_pose(model_points, K, image_points, J, f, m, R, T))
+        {
+            return false;
+        }
+
+        beta *= beta_update;
+    }
+
+    // Harden the assignment: each image point takes its best model point
+    // if that beats the slack in both its row and the model point's column
+    int match_count = 0;
+    for (int j = 0; j < J; ++j)
+    {
+        int best_k = -1;
+        double best_m = m[j][K];
+
+        for (int k = 0; k < K; ++k)
+        {
+            if (m[j][k] > best_m && m[j][k] > m[J][k])
+            {
+                best_m = m[j][k];
+                best_k = k;
+            }
+        }
+
+        out_result.correspondences[j] = best_k;
+        if (best_k != -1)
+        {
+            ++match_count;
+        }
+    }
+
+    // The annealed pose is still blurred by the soft weights of the other candidates,
+    // so finish with plain POSIT on the hard matches
+    if (match_count >= 4)
+    {
+        for (int iteration = 0; iteration < k_soft_posit_refine_iterations; ++iteration)
+        {
+            for (int j = 0; j <= J; ++j)
+            {
+                for (int k = 0; k <= K; ++k)
+                {
+                    m[j][k] = 0.0;
+                }
+            }
+            for (int j = 0; j < J; ++j)
+            {
+                if (out_result.correspondences[j] != -1)
+                {
+                    m[j][out_result.correspondences[j]] = 1.0;
+                }
+            }
+
+            if (!soft_posit_update_pose(model_points, K, image_points, J, f, m, R, T))
+            {
+                return false;
+            }
+        }
+    }
+
+    // Only keep matches that reproject within the outlier distance
+    out_result.match_count = 0;
+    double error_sum = 0.0;
+    for (int j = 0; j < J; ++j)
+    {
+        const int k = out_result.correspondences[j];
+
+        if (k != -1)
+        {
+            const Eigen::Vector3d C = R * model_points[k].cast<double>() + T;
+            bool bAccepted = false;
+
+            if (C.z() > k_real_epsilon)
+            {
+                const double dx = f * C.x() / C.z() - image_points[j].x();
+                const double dy = f * C.y() / C.z() - image_points[j].y();
+                const double error_sqrd = dx*dx + dy*dy;
+
+                if (error_sqrd <= alpha)
+                {
+                    error_sum += sqrt(error_sqrd);
+                    bAccepted = true;
+                }
+            }
+
+            if (bAccepted)
+            {
+                ++out_result.match_count;
+            }
+            else
+            {
+                out_result.correspondences[j] = -1;
+            }
+        }
+    }
+
+    out_result.rotation = R.cast<float>();
+    out_result.position = T.cast<float>();
+    out_result.reprojection_error_px =
+        (out_result.match_count > 0) ? static_cast<float>(error_sum / static_cast<double>(out_result.match_count)) : k_real_max;
+
+    return T.z() > k_real_epsilon && R.allFinite() && T.allFinite();
+}
+
+static void soft_posit_compute_visibility(
+    const Eigen::Vector3f *model_points, const Eigen::Vector3f *model_normals, const int model_point_count,
+    const Eigen::Matrix3d &R, const Eigen::Vector3d &T,
+    bool *out_visible)
+{
+    for (int k = 0; k < model_point_count; ++k)
+    {
+        if (model_normals != nullptr)
+        {
+            // Cosine between the point's facing and the direction back to the camera
+            const Eigen::Vector3d C = R * model_points[k].cast<double>() + T;
+            const Eigen::Vector3d N = R * model_normals[k].cast<double>();
+            const double facing_cos = -N.dot(C) / std::max(C.norm() * N.norm(), static_cast<double>(k_real_epsilon));
+
+            out_visible[k] = facing_cos > k_soft_posit_min_facing_cos;
+        }
+        else
+        {
+            out_visible[k] = true;
+        }
+    }
+}
+
+static bool soft_posit_update_pose(
+    const Eigen::Vector3f *model_points, const int model_point_count,
+    const Eigen::Vector2f *image_points, const int image_point_count,
+    const double f,
+    const double m[][k_soft_posit_max_points + 1],
+    Eigen::Matrix3d &R, Eigen::Vector3d &T)
+{
+    // Weighted POSIT step: fit the scaled orthographic rows Q1, Q2 to the
+    // perspective corrected image points of the (soft) matches
+    Eigen::Matrix4d L = Eigen::Matrix4d::Zero();
+    Eigen::Vector4d b1 = Eigen::Vector4d::Zero();
+    Eigen::Vector4d b2 = Eigen::Vector4d::Zero();
+    for (int k = 0; k < model_point_count; ++k)
+    {
+        const Eigen::Vector3d P = model_points[k].cast<double>();
+        const Eigen::Vector4d Ph(P.x(), P.y(), P.z(), 1.0);
+        const double w = R.row(2).dot(P) / T.z() + 1.0;
+        double column_weight = 0.0;
+
+        for (int j = 0; j < image_point_count; ++j)
+        {
+            column_weight += m[j][k];
+            b1 += (m[j][k] * w * image_points[j].x()) * Ph;
+            b2 += (m[j][k] * w * image_points[j].y()) * Ph;
+        }
+
+        L += column_weight * (Ph * Ph.transpose());
+    }
+
+    // SVD rather than an inverse so that (nearly) coplanar matches don't blow up
+    const Eigen::JacobiSVD<Eigen::Matrix4d> svd(L, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    const Eigen::Vector4d Q1 = svd.solve(b1);
+    const Eigen::Vector4d Q2 = svd.solve(b2);
+    const double s1 = Q1.head<3>().norm();
+    const double s2 = Q2.head<3>().norm();
+
+    if (s1 <= k_real_epsilon || s2 <= k_real_epsilon || !Q1.allFinite() || !Q2.allFinite())
+    {
+        return false;
+    }
+
+    // Project the rows back onto the nearest rotation
+    const double s = sqrt(s1 * s2);
+    const Eigen::Vector3d r1 = Q1.head<3>() / s1;
+    const Eigen::Vector3d r2 = Q2.head<3>() / s2;
+    Eigen::Matrix3d R_approx;
+    R_approx.row(0) = r1;
+    R_approx.row(1) = r2;
+    R_approx.row(2) = r1.cross(r2);
+
+    const Eigen::JacobiSVD<Eigen::Matrix3d> rotation_svd(R_approx, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Eigen::Matrix3d D = Eigen::Matrix3d::Identity();
+    D(2, 2) = (rotation_svd.matrixU() * rotation_svd.matrixV().transpose()).determinant() < 0.0 ? -1.0 : 1.0;
+    R = rotation_svd.matrixU() * D * rotation_svd.matrixV().transpose();
+
+    T = Eigen::Vector3d(Q1(3) / s, Q2(3) / s, f / s);
+
+    return true;
+}
+
+static bool bundle_adjustment_project(
+    const BundleAdjustmentCameraState &camera, const Eigen::Vector3d &world_point,
+    Eigen::Vector2d &out_pixel, Eigen::Vector3d &out_camera_point)
+{
+    out_camera_point = camera.rotation.transpose() * (world_point - camera.position);
+
+    if (out_camera_point.z() < k_bundle_adjustment_min_depth)
+    {
+        return false;
+    }
+
+    out_pixel.x() = camera.principal_x + camera.focal_length_x * out_camera_point.x() / out_camera_point.z();
+    out_pixel.y() = camera.principal_y - camera.focal_length_y * out_camera_point.y() / out_camera_point.z();
+
+    return true;
+}
+
+static double bundle_adjustment_compute_residual(
+    const BundleAdjustmentCameraState &camera, const Eigen::Vector3d &world_point,
+    const Eigen::Vector2f &observed_pixel)
+{
+    Eigen::Vector2d projection;
+    Eigen::Vector3d camera_point;
+
+    // A point behind the camera counts as a very bad observation
+    return bundle_adjustment_project(camera, world_point, projection, camera_point)
+        ? (projection - observed_pixel.cast<double>()).norm()
+        : k_bundle_adjustment_behind_camera_residual_px;
+}
+
+static double bundle_adjustment_huber_cost(const double residual_px)
+{
+    const double k = k_bundle_adjustment_huber_threshold_px;
+
+    return (residual_px <= k) ? residual_px * residual_px : 2.0 * k * residual_px - k * k;
+}
+
+static double bundle_adjustment_huber_weight(const double residual_px)
+{
+    const double k = k_bundle_adjustment_huber_threshold_px;
+
+    return (residual_px <= k) ? 1.0 : k / residual_px;
+}
+
+static bool bundle_adjustment_triangulate_point(
+    const BundleAdjustmentCameraList &cameras,
+    const EigenBundleAdjustmentObservation *observations, const std::vector<int> &point_observations,
+    Eigen::Vector3d &out_point)
+{
+    // The point closest to all of the viewing rays:
+    // sum((I - d*d^T)) * X = sum((I - d*d^T) * c)
+    Eigen::Matrix3d A = Eigen::Matrix3d::Zero();
+    Eigen::Vector3d b = Eigen::Vector3d::Zero();
+
+    for (int observation_index : point_observations)
+    {
+        const EigenBundleAdjustmentObservation &observation = observations[observation_index];
+        const BundleAdjustmentCameraState &camera = cameras[observation.camera_index];
+        const Eigen::Vector3d camera_ray(
+            (observation.pixel.x() - camera.principal_x) / camera.focal_length_x,
+            (camera.principal_y - observation.pixel.y()) / camera.focal_length_y,
+            1.0);
+        const Eigen::Vector3d d = (camera.rotation * camera_ray).normalized();
+        const Eigen::Matrix3d P = Eigen::Matrix3d::Identity() - d * d.transpose();
+
+        A += P;
+        b += P * camera.position;
+    }
+
+    const Eigen::LDLT<Eigen::Matrix3d> ldlt(A);
+    if (ldlt.info() != Eigen::Success || !ldlt.isPositive() || std::abs(A.determinant()) < 1e-12)
+    {
+        return false;
+    }
+
+    out_point = ldlt.solve(b);
+    if (!out_point.allFinite())
+    {
+        return false;
+    }
+
+    // Parallel rays can meet behind a camera
+    for (int observation_index : point_observations)
+    {
+        const BundleAdjustmentCameraState &camera = cameras[observations[observation_index].camera_index];
+
+        if ((camera.rotation.transpose() * (out_point - camera.position)).z() < k_bundle_adjustment_min_depth)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void bundle_adjustment_refine_point(
+    const BundleAdjustmentCameraList &cameras,
+    const EigenBundleAdjustmentObservation *observations, const std::vector<int> &point_observations,
+    Eigen::Vector3d &point)
+{
+    // Gauss-Newton on the point alone with the cameras held fixed
+    for (int iteration = 0; iteration < k_bundle_adjustment_point_iterations; ++iteration)
+    {
+        Eigen::Matrix3d JtJ = Eigen::Matrix3d::Zero();
+        Eigen::Vector3d Jtr = Eigen::Vector3d::Zero();
+        double cost = 0.0;
+
+        for (int observation_index : point_observations)
+        {
+            const EigenBundleAdjustmentObservation &observation = observations[observation_index];
+            const BundleAdjustmentCameraState &camera = cameras[observation.camera_index];
+
+            Eigen::Vector2d projection;
+            Eigen::Vector3d p;
+            if (!bundle_adjustment_project(camera, point, projection, p))
+            {
+                return;
+            }
+
+            const Eigen::Vector2d residual = projection - observation.pixel.cast<double>();
+            const double weight = bundle_adjustment_huber_weight(residual.norm());
+            const double inv_z = 1.0 / p.z();
+            Eigen::Matrix<double, 2, 3> J_proj;
+            J_proj <<
+                camera.focal_length_x * inv_z, 0.0, -camera.focal_length_x * p.x() * inv_z * inv_z,
+                0.0, -camera.focal_length_y * inv_z, camera.focal_length_y * p.y() * inv_z * inv_z;
+            const Eigen::Matrix<double, 2, 3> J = J_proj * camera.rotation.transpose();
+
+            JtJ += weight * J.transpose() * J;
+            Jtr += weight * J.transpose() * residual;
+            cost += bundle_adjustment_huber_cost(residual.norm());
+        }
+
+        bool bInvertible = false;
+        Eigen::Matrix3d JtJ_inverse;
+        JtJ.computeInverseWithCheck(JtJ_inverse, bInvertible);
+        if (!bInvertible)
+        {
+            return;
+        }
+
+        const Eigen::Vector3d candidate = point - JtJ_inverse * Jtr;
+        double candidate_cost = 0.0;
+        for (int observation_index : point_observations)
+        {
+            const EigenBundleAdjustmentObservation &observation = observations[observation_index];
+
+            candidate_cost += bundle_adjustment_huber_cost(
+                bundle_adjustment_compute_residual(cameras[observation.camera_index], candidate, observation.pixel));
+        }
+
+        if (!candidate.allFinite() || candidate_cost >= cost)
+        {
+            return;
+        }
+
+        point = candidate;
+    }
+}
+
+static double bundle_adjustment_compute_cost(
+    const BundleAdjustmentCameraList &cameras, const BundleAdjustmentCameraList &initial_cameras,
+    const BundleAdjustmentPointList &points,
+    const EigenBundleAdjustmentObservation *observations, const std::vector<int> &used_observations,
+    const bool refine_intrinsics)
+{
+    double cost = 0.0;
+
+    for (int observation_index : used_observations)
+    {
+        const EigenBundleAdjustmentObservation &observation = observations[observation_index];
+
+        cost += bundle_adjustment_huber_cost(
+            bundle_adjustment_compute_residual(
+                cameras[observation.camera_index], points[observation.point_index], observation.pixel));
+    }
+
+    for (size_t camera_index = 0; camera_index < cameras.size(); ++camera_index)
+    {
+        const BundleAdjustmentCameraState &camera = cameras[camera_index];
+        const BundleAdjustmentCameraState &initial_camera = initial_cameras[camera_index];
+        const Eigen::AngleAxisd rotation_error(initial_camera.rotation.transpose() * camera.rotation);
+        const double orientation_error = rotation_error.angle() / k_bundle_adjustment_orientation_prior_sigma;
+        const double position_error =
+            (camera.position - initial_camera.position).norm() / k_bundle_adjustment_position_prior_sigma;
+
+        cost += orientation_error * orientation_error + position_error * position_error;
+
+        if (refine_intrinsics)
+        {
+            const Eigen::Vector4d intrinsics_error =
+                Eigen::Vector4d(
+                    camera.focal_length_x - initial_camera.focal_length_x,
+                    camera.focal_length_y - initial_camera.focal_length_y,
+                    camera.principal_x - initial_camera.principal_x,
+                    camera.principal_y - initial_camera.principal_y)
+                / k_bundle_adjustment_intrinsics_prior_sigma_px;
+
+            cost += intrinsics_error.squaredNorm();
+        }
+    }
+
+    return cost;
+}
+
+static double bundle_adjustment_compute_rms(
+    const BundleAdjustmentCameraList &cameras, const BundleAdjustmentPointList &points,
+    const EigenBundleAdjustmentObservation *observations, const std::vector<int> &used_observations,
+    const int camera_count, float *out_camera_rms_px)
+{
+    std::vector<double> camera_squared_error(camera_count, 0.0);
+    std::vector<int> camera_observation_count(camera_count, 0);
+    double squared_error = 0.0;
+
+    for (int observation_index : used_observations)
+    {
+        const EigenBundleAdjustmentObservation &observation = observations[observation_index];
+        const double residual =
+            bundle_adjustment_compute_residual(
+                cameras[observation.camera_index], points[observation.point_index], observation.pixel);
+
+        squared_error += residual * residual;
+        camera_squared_error[observation.camera_index] += residual * residual;
+        ++camera_observation_count[observation.camera_index];
+    }
+
+    if (out_camera_rms_px != nullptr)
+    {
+        for (int camera_index = 0; camera_index < camera_count; ++camera_index)
+        {
+            out_camera_rms_px[camera_index] =
+                (camera_observation_count[camera_index] > 0)
+                ? static_cast<float>(sqrt(camera_squared_error[camera_index] / camera_observation_count[camera_index]))
+                : 0.f;
+        }
+    }
+
+    return used_observations.empty() ? 0.0 : sqrt(squared_error / used_observations.size());
+}
@@ -45,6 +45,79 @@ public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
+// Running sums of eigen_alignment_streaming_ellipsoid_add_samples.
+// The size is fixed no matter how many samples went in.
+struct EigenStreamingEllipsoidFit
+{
+    Eigen::Matrix<double, 10, 10> scatter; // sum of the outer products of each sample's quadric monomials (lower triangle)
+    Eigen::Vector3d reference_point; // first sample, the sums are taken relative to it
+    double weight_sum; // decayed sample count
+    int sample_count; // accepted samples
+    int rejected_count;
+    float rejection_rate; // running fraction of recent samples rejected by the gate
+    bool bHasReference;
+    bool bHasFit;
+    EigenFitEllipsoid ellipsoid; // latest solve, error is the rms of the ellipsoid equation
+
+    void clear()
+    {
+        scatter = Eigen::Matrix<double, 10, 10>::Zero();
+        reference_point = Eigen::Vector3d::Zero();
+        weight_sum = 0.0;
+        sample_count = 0;
+        rejected_count = 0;
+        rejection_rate = 0.f;
+        bHasReference = false;
+        bHasFit = false;
+        ellipsoid.clear();
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// Pinhole camera refined by eigen_alignment_bundle_adjust_cameras.
+// Camera space is x right, y up, z forward; pixels have +y down (u = cx + fx*x/z, v = cy - fy*y/z)
+struct EigenBundleAdjustmentCamera
+{
+    Eigen::Quaternionf orientation; // camera to world
+    Eigen::Vector3f position; // camera center in world space
+    float focal_length_x, focal_length_y; // px
+    float principal_x, principal_y; // px
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// One undistorted sighting of an unknown world point by one camera
+struct EigenBundleAdjustmentObservation
+{
+    int camera_index;
+    int point_index;
+    Eigen::Vector2f pixel;
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+struct EigenBundleAdjustmentResult
+{
+    int iteration_count;
+    int point_count; // points seen by at least two cameras
+    int observation_count; // observations of those points
+    float initial_rms_px; // with the initial cameras and the best points for them
+    float final_rms_px;
+
+    void clear()
+    {
+        iteration_count = 0;
+        point_count = 0;
+        observation_count = 0;
+        initial_rms_px = 0.f;
+        final_rms_px = 0.f;
+    }
+};
+
 //-- interface -----
 Eigen::Quaternionf
 eigen_alignment_quaternion_between_vectors(const Eigen::Vector3f &from, const Eigen::Vector3f &to);
@@ -79,6 +152,27 @@ eigen_alignment_fit_least_squares_axis_aligned_ellipsoid(
     const Eigen::Vector3f *points, const int point_count,
     EigenFitEllipsoid &out_ellipsoid);
 
+// Streaming general ellipsoid fit:
+// Accumulates the algebraic least squares fit of a rotated ellipsoid (all 10 quadric coefficients),
+// a batch of samples at a time, into sums whose size doesn't depend on the sample count.
+// * Once there is a fit, samples farther than outlier_tolerance (a fraction of the radius) from it
+//   are rejected; when most recent samples get rejected the field changed and the fit starts over
+// * forget_factor < 1 decays the weight of the older samples with every new one (for background
+//   refinement), 1 keeps them all
+// * Returns the number of accepted samples
+int
+eigen_alignment_streaming_ellipsoid_add_samples(
+    EigenStreamingEllipsoidFit &fit,
+    const Eigen::Vector3f *points, const int point_count,
+    const float outlier_tolerance,
+    const float forget_factor);
+
+// Solves the running sums of a streaming ellipsoid fit into fit.ellipsoid (and sets fit.bHasFit).
+// Constant cost: one 10x10 and one 3x3 symmetric eigen decomposition.
+// * Returns false if there are too few samples or the best fit quadric isn't an ellipsoid
+bool
+eigen_alignment_streaming_ellipsoid_solve(EigenStreamingEllipsoidFit &fit);
+
 Eigen::Vector3f
 eigen_alignment_project_point_on_ellipsoid_basis(
     const Eigen::Vector3f &point,
@@ -125,6 +219,91 @@ eigen_alignment_fit_focal_cone_to_sphere(
     Eigen::Vector3f *out_sphere_center,
     EigenFitEllipse *out_ellipse_projection= nullptr);
 
+// Robust, weighted variant of the Doc_ok method.
+// Solves the same cone fit from the 3x3 weighted normal equations and then
+// re-weights outliers with a Huber loss for up to max_iterations rounds (IRLS).
+// * point_weights can be nullptr for uniform weights (e.g. pass edge gradient strength)
+// * Returns false if the fit degenerates
+bool
+eigen_alignment_fit_focal_cone_to_sphere_robust(
+    const Eigen::Vector2f *points,
+    const float *point_weights,
+    const int point_count,
+    const float sphere_radius,
+    const float focal_length_pts, // a.k.a. "f_px"
+    const int max_iterations,
+    Eigen::Vector3f *out_sphere_center,
+    EigenFitEllipse *out_ellipse_projection= nullptr);
+
+// SoftPOSIT (David, DeMenthon, Duraiswami and Samet 2004):
+// Solves for the pose of a rigid point model given image points, without knowing
+// which image point belongs to which model point. The correspondences and the pose are
+// found together by annealing a soft assignment matrix while iterating POSIT.
+// * image_points are in pixels relative to the principal point, camera space is
+//   x right, y up, z forward (u = f*x/z, v = f*y/z)
+// * Unmatched image points (outliers) and model points (occluded) fall into slack
+// * model_normals (optional) are the directions the model points face (e.g. LEDs);
+//   points facing away from the camera at the current pose are not matched
+// * The prediction (initial_orientation/initial_position) gets half of the budget; without one,
+//   or if it leads nowhere, a few canned starts share the rest
+// * max_iterations is the total annealing budget across all starts
+// * out_correspondences (optional, image_point_count entries) gets the matched model index or -1
+// * Returns false if too few points could be matched
+bool
+eigen_alignment_soft_posit(
+    const Eigen::Vector3f *model_points,
+    const Eigen::Vector3f *model_normals,
+    const int model_point_count,
+    const Eigen::Vector2f *image_points,
+    const int image_point_count,
+    const float focal_length_px,
+    const float image_noise_px,
+    const Eigen::Quaternionf *initial_orientation,
+    const Eigen::Vector3f *initial_position,
+    const int max_iterations,
+    Eigen::Quaternionf *out_orientation,
+    Eigen::Vector3f *out_position,
+    int *out_correspondences= nullptr,
+    float *out_reprojection_error_px= nullptr);
+
+// Sparse bundle adjustment:
+// Jointly refines the poses (and optionally the intrinsics) of several cameras together with
+// the world points they all observed, minimizing the Huber-weighted reprojection error.
+// * Points are triangulated from the initial cameras; points seen by fewer than two cameras are ignored
+// * Levenberg-Marquardt over the camera parameters, with the points eliminated by a Schur complement
+// * The gauge (world origin, orientation and scale) is held by weak priors pulling every camera
+//   toward its initial pose, so the result stays in the frame of the initial cameras
+// * cameras are updated in place
+// * out_initial_camera_rms_px/out_final_camera_rms_px (optional) get camera_count entries
+// * Returns false if there is not enough data or the solve fails
+bool
+eigen_alignment_bundle_adjust_cameras(
+    EigenBundleAdjustmentCamera *cameras,
+    const int camera_count,
+    const EigenBundleAdjustmentObservation *observations,
+    const int observation_count,
+    const int point_count,
+    const bool refine_intrinsics,
+    const int max_iterations,
+    EigenBundleAdjustmentResult *out_result,
+    float *out_initial_camera_rms_px= nullptr,
+    float *out_final_camera_rms_px= nullptr);
+
+// Camera resection:
+// Refines the pose of one camera (intrinsics held fixed) against world points that are known
+// independently of it, minimizing the Huber-weighted reprojection error of its undistorted pixels.
+// * camera is updated in place
+// * Returns false if there are too few points in front of the camera or the solve fails
+bool
+eigen_alignment_refine_camera_pose(
+    EigenBundleAdjustmentCamera *camera,
+    const Eigen::Vector3f *world_points,
+    const Eigen::Vector2f *pixels,
+    const int point_count,
+    const int max_iterations,
+    float *out_initial_rms_px= nullptr,
+    float *out_final_rms_px= nullptr);
+
 // Compute the weighted average of multiple quaternions
 // * All weights will be renormalized against the total weight
 // * All input weights must be >= 0
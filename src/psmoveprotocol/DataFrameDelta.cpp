@@ -0,0 +1,488 @@
+//-- includes -----
+#include "DataFrameDelta.h"
+#include "PSMoveProtocol.pb.h"
+#include <vector>
+
+//-- constants -----
+// Only fields 1-31 of a device state message fit in changed_state_fields.
+// Fields past that are always sent whole and always replace the keyframe value.
+static const int k_max_masked_field_number = 31;
+
+//-- private methods -----
+typedef PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket t_controller_data_packet;
+
+// Where the fields of one device state message (psmove_state, ...) are.
+// Descriptors never change, so this is looked up once rather than per frame.
+struct DeviceStateLayout
+{
+    const google::protobuf::FieldDescriptor *state_field;
+    std::vector<const google::protobuf::FieldDescriptor *> masked_fields;
+    const google::protobuf::FieldDescriptor *position_field; // null if the device state has no pose
+    const google::protobuf::FieldDescriptor *orientation_field;
+};
+
+static inline unsigned int get_field_mask_bit(const google::protobuf::FieldDescriptor *field)
+{
+    return (field != nullptr && field->number() <= k_max_masked_field_number) ? (1u << field->number()) : 0u;
+}
+
+static void build_device_state_layout(const int state_field_number, DeviceStateLayout &out_layout)
+{
+    const google::protobuf::Descriptor *state_descriptor;
+
+    out_layout.state_field = t_controller_data_packet::descriptor()->FindFieldByNumber(state_field_number);
+    state_descriptor = out_layout.state_field->message_type();
+
+    for (int field_index = 0; field_index < state_descriptor->field_count(); ++field_index)
+    {
+        const google::protobuf::FieldDescriptor *field = state_descriptor->field(field_index);
+
+        if (get_field_mask_bit(field) != 0)
+        {
+            out_layout.masked_fields.push_back(field);
+        }
+    }
+
+    out_layout.position_field = state_descriptor->FindFieldByName("position_cm");
+    out_layout.orientation_field = state_descriptor->FindFieldByName("orientation");
+}
+
+struct DeviceStateLayoutTable
+{
+    DeviceStateLayout psmove_state;
+    DeviceStateLayout psnavi_state;
+    DeviceStateLayout psdualshock4_state;
+    DeviceStateLayout virtualcontroller_state;
+
+    DeviceStateLayoutTable()
+    {
+        build_device_state_layout(t_controller_data_packet::kPsmoveStateFieldNumber, psmove_state);
+        build_device_state_layout(t_controller_data_packet::kPsnaviStateFieldNumber, psnavi_state);
+        build_device_state_layout(t_controller_data_packet::kPsdualshock4StateFieldNumber, psdualshock4_state);
+        build_device_state_layout(t_controller_data_packet::kVirtualcontrollerStateFieldNumber, virtualcontroller_state);
+    }
+};
+
+// The layout of the device state that is set, or null
+static const DeviceStateLayout *find_device_state_layout(const t_controller_data_packet &packet)
+{
+    static const DeviceStateLayoutTable k_layouts;
+
+    if (packet.has_psmove_state())
+        return &k_layouts.psmove_state;
+    if (packet.has_psnavi_state())
+        return &k_layouts.psnavi_state;
+    if (packet.has_psdualshock4_state())
+        return &k_layouts.psdualshock4_state;
+    if (packet.has_virtualcontroller_state())
+        return &k_layouts.virtualcontroller_state;
+
+    return nullptr;
+}
+
+static bool is_sequence_num_newer(int sequence_num, int other_sequence_num)
+{
+    // Wraps around cleanly
+    return static_cast<int>(static_cast<unsigned int>(sequence_num) - static_cast<unsigned int>(other_sequence_num)) > 0;
+}
+
+static bool are_messages_equal(const google::protobuf::Message &a, const google::protobuf::Message &b);
+
+// Exact value comparison of one field of two messages of the same type.
+// Unlike a MessageDifferencer this doesn't allocate, which matters at one call per field per frame.
+static bool are_fields_equal(
+    const google::protobuf::Message &a,
+    const google::protobuf::Message &b,
+    const google::protobuf::FieldDescriptor *field)
+{
+    const google::protobuf::Reflection *reflection = a.GetReflection();
+
+    if (field->is_repeated())
+    {
+        const int count = reflection->FieldSize(a, field);
+
+        if (count != reflection->FieldSize(b, field))
+        {
+            return false;
+        }
+
+        for (int index = 0; index < count; ++index)
+        {
+            bool bEqual = false;
+
+            switch (field->cpp_type())
+            {
+            case google::protobuf::FieldDescriptor::CPPTYPE_INT32:
+                bEqual = reflection->GetRepeatedInt32(a, field, index) == reflection->GetRepeatedInt32(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_INT64:
+                bEqual = reflection->GetRepeatedInt64(a, field, index) == reflection->GetRepeatedInt64(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_UINT32:
+                bEqual = reflection->GetRepeatedUInt32(a, field, index) == reflection->GetRepeatedUInt32(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_UINT64:
+                bEqual = reflection->GetRepeatedUInt64(a, field, index) == reflection->GetRepeatedUInt64(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_FLOAT:
+                bEqual = reflection->GetRepeatedFloat(a, field, index) == reflection->GetRepeatedFloat(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE:
+                bEqual = reflection->GetRepeatedDouble(a, field, index) == reflection->GetRepeatedDouble(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_BOOL:
+                bEqual = reflection->GetRepeatedBool(a, field, index) == reflection->GetRepeatedBool(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_ENUM:
+                bEqual = reflection->GetRepeatedEnumValue(a, field, index) == reflection->GetRepeatedEnumValue(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_STRING:
+                bEqual = reflection->GetRepeatedString(a, field, index) == reflection->GetRepeatedString(b, field, index);
+                break;
+            case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+                bEqual = are_messages_equal(reflection->GetRepeatedMessage(a, field, index), reflection->GetRepeatedMessage(b, field, index));
+                break;
+            }
+
+            if (!bEqual)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    switch (field->cpp_type())
+    {
+    case google::protobuf::FieldDescriptor::CPPTYPE_INT32:
+        return reflection->GetInt32(a, field) == reflection->GetInt32(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_INT64:
+        return reflection->GetInt64(a, field) == reflection->GetInt64(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_UINT32:
+        return reflection->GetUInt32(a, field) == reflection->GetUInt32(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_UINT64:
+        return reflection->GetUInt64(a, field) == reflection->GetUInt64(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_FLOAT:
+        return reflection->GetFloat(a, field) == reflection->GetFloat(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE:
+        return reflection->GetDouble(a, field) == reflection->GetDouble(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_BOOL:
+        return reflection->GetBool(a, field) == reflection->GetBool(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_ENUM:
+        return reflection->GetEnumValue(a, field) == reflection->GetEnumValue(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_STRING:
+        return reflection->GetString(a, field) == reflection->GetString(b, field);
+    case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+        {
+            const bool bHasA = reflection->HasField(a, field);
+
+            if (bHasA != reflection->HasField(b, field))
+            {
+                return false;
+            }
+
+            return !bHasA || are_messages_equal(reflection->GetMessage(a, field), reflection->GetMessage(b, field));
+        }
+    }
+
+    return false;
+}
+
+static bool are_messages_equal(const google::protobuf::Message &a, const google::protobuf::Message &b)
+{
+    const google::protobuf::Descriptor *descriptor = a.GetDescriptor();
+
+    for (int field_index = 0; field_index < descriptor->field_count(); ++field_index)
+    {
+        if (!are_fields_equal(a, b, descriptor->field(field_index)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-- public methods -----
+ControllerDataFrameDeltaEncoder::ControllerDataFrameDeltaEncoder()
+    : m_keyframe()
+    , m_framesSinceKeyframe(0)
+    , m_bKeyframeRequested(false)
+    , m_keyframeCompressedOrientation(0)
+{
+    m_keyframeCompressedPosition[0] = m_keyframeCompressedPosition[1] = m_keyframeCompressedPosition[2] = 0;
+}
+
+ControllerDataFrameDeltaEncoder::~ControllerDataFrameDeltaEncoder()
+{
+}
+
+void
+ControllerDataFrameDeltaEncoder::encode(t_controller_data_packet *packet)
+{
+    const DeviceStateLayout *layout = find_device_state_layout(*packet);
+
+    if (layout == nullptr)
+    {
+        // Nothing worth a delta, send it as is
+        packet->set_delta_frame_type(t_controller_data_packet::FULL_FRAME);
+        return;
+    }
+
+    const google::protobuf::Reflection *packet_reflection = packet->GetReflection();
+    const bool bSendKeyframe =
+        !m_keyframe ||
+        m_bKeyframeRequested ||
+        m_framesSinceKeyframe >= DATA_FRAME_DELTA_KEYFRAME_INTERVAL - 1 ||
+        !packet_reflection->HasField(*m_keyframe, layout->state_field);
+
+    if (bSendKeyframe)
+    {
+        packet->set_delta_frame_type(t_controller_data_packet::KEYFRAME);
+        packet->set_keyframe_sequence_num(packet->sequence_num());
+
+        if (!m_keyframe)
+        {
+            m_keyframe.reset(new t_controller_data_packet);
+        }
+        m_keyframe->CopyFrom(*packet);
+
+        // Delta frames where only half of the pose moved send the other half from here
+        const google::protobuf::Message &keyframe_state = packet_reflection->GetMessage(*m_keyframe, layout->state_field);
+        const google::protobuf::Reflection *state_reflection = keyframe_state.GetReflection();
+
+        if (layout->position_field != nullptr)
+        {
+            const PSMoveProtocol::Position &position =
+                static_cast<const PSMoveProtocol::Position &>(state_reflection->GetMessage(keyframe_state, layout->position_field));
+
+            m_keyframeCompressedPosition[0] = compressPositionComponent(position.x());
+            m_keyframeCompressedPosition[1] = compressPositionComponent(position.y());
+            m_keyframeCompressedPosition[2] = compressPositionComponent(position.z());
+        }
+
+        if (layout->orientation_field != nullptr)
+        {
+            const PSMoveProtocol::Orientation &orientation =
+                static_cast<const PSMoveProtocol::Orientation &>(state_reflection->GetMessage(keyframe_state, layout->orientation_field));
+
+            m_keyframeCompressedOrientation =
+                compressOrientation(orientation.x(), orientation.y(), orientation.z(), orientation.w());
+        }
+
+        m_framesSinceKeyframe = 0;
+        m_bKeyframeRequested = false;
+        return;
+    }
+
+    google::protobuf::Message *state = packet_reflection->MutableMessage(packet, layout->state_field);
+    const google::protobuf::Message &keyframe_state = packet_reflection->GetMessage(*m_keyframe, layout->state_field);
+    const google::protobuf::Reflection *state_reflection = state->GetReflection();
+
+    // Drop every masked field that still matches the keyframe
+    unsigned int changed_state_fields = 0;
+
+    for (const google::protobuf::FieldDescriptor *field : layout->masked_fields)
+    {
+        if (are_fields_equal(*state, keyframe_state, field))
+        {
+            state_reflection->ClearField(state, field);
+        }
+        else
+        {
+            changed_state_fields |= get_field_mask_bit(field);
+        }
+    }
+
+    // Any change to the pose sends all of it compressed
+    const unsigned int position_bit = get_field_mask_bit(layout->position_field);
+    const unsigned int orientation_bit = get_field_mask_bit(layout->orientation_field);
+
+    if ((changed_state_fields & (position_bit | orientation_bit)) != 0)
+    {
+        PSMoveProtocol::CompressedPose *compressed_pose = packet->mutable_compressed_pose();
+
+        if ((changed_state_fields & position_bit) != 0)
+        {
+            const PSMoveProtocol::Position &position =
+                static_cast<const PSMoveProtocol::Position &>(state_reflection->GetMessage(*state, layout->position_field));
+
+            compressed_pose->set_position_x(compressPositionComponent(position.x()));
+            compressed_pose->set_position_y(compressPositionComponent(position.y()));
+            compressed_pose->set_position_z(compressPositionComponent(position.z()));
+        }
+        else if (layout->position_field != nullptr)
+        {
+            compressed_pose->set_position_x(m_keyframeCompressedPosition[0]);
+            compressed_pose->set_position_y(m_keyframeCompressedPosition[1]);
+            compressed_pose->set_position_z(m_keyframeCompressedPosition[2]);
+        }
+
+        if ((changed_state_fields & orientation_bit) != 0)
+        {
+            const PSMoveProtocol::Orientation &orientation =
+                static_cast<const PSMoveProtocol::Orientation &>(state_reflection->GetMessage(*state, layout->orientation_field));
+
+            compressed_pose->set_orientation(
+                compressOrientation(orientation.x(), orientation.y(), orientation.z(), orientation.w()));
+        }
+        else if (layout->orientation_field != nullptr)
+        {
+            compressed_pose->set_orientation(m_keyframeCompressedOrientation);
+        }
+
+        if (layout->position_field != nullptr)
+        {
+            state_reflection->ClearField(state, layout->position_field);
+        }
+        if (layout->orientation_field != nullptr)
+        {
+            state_reflection->ClearField(state, layout->orientation_field);
+        }
+        changed_state_fields |= position_bit | orientation_bit;
+    }
+
+    packet->set_delta_frame_type(t_controller_data_packet::DELTA_FRAME);
+    packet->set_keyframe_sequence_num(m_keyframe->keyframe_sequence_num());
+    packet->set_changed_state_fields(changed_state_fields);
+
+    ++m_framesSinceKeyframe;
+}
+
+ControllerDataFrameDeltaDecoder::ControllerDataFrameDeltaDecoder()
+    : m_keyframe(new t_controller_data_packet)
+    , m_rebuilt(new t_controller_data_packet)
+    , m_bHasKeyframe(false)
+    , m_bHasRequestedKeyframe(false)
+    , m_requestedKeyframeSequenceNum(0)
+{
+}
+
+ControllerDataFrameDeltaDecoder::~ControllerDataFrameDeltaDecoder()
+{
+}
+
+void
+ControllerDataFrameDeltaDecoder::reset()
+{
+    m_keyframe->Clear();
+    m_bHasKeyframe = false;
+    m_bHasRequestedKeyframe = false;
+}
+
+ControllerDataFrameDeltaDecoder::eDecodeResult
+ControllerDataFrameDeltaDecoder::decode(const t_controller_data_packet &packet)
+{
+    switch (packet.delta_frame_type())
+    {
+    case t_controller_data_packet::KEYFRAME:
+        {
+            // A keyframe that shows up after a newer one is too late to be of use
+            if (m_bHasKeyframe && !is_sequence_num_newer(packet.sequence_num(), m_keyframe->sequence_num()))
+            {
+                return decodeDroppedFrame;
+            }
+
+            m_keyframe->CopyFrom(packet);
+            m_bHasKeyframe = true;
+            m_bHasRequestedKeyframe = false;
+
+            return decodeFullFrame;
+        }
+
+    case t_controller_data_packet::DELTA_FRAME:
+        break;
+
+    default:
+        return decodeFullFrame;
+    }
+
+    const DeviceStateLayout *layout = find_device_state_layout(packet);
+    const google::protobuf::Reflection *packet_reflection = packet.GetReflection();
+    const bool bHasMatchingKeyframe =
+        m_bHasKeyframe &&
+        packet.keyframe_sequence_num() == m_keyframe->sequence_num() &&
+        (layout == nullptr || packet_reflection->HasField(*m_keyframe, layout->state_field));
+
+    if (!bHasMatchingKeyframe)
+    {
+        // Late delta frames of a keyframe we already replaced are just dropped,
+        // otherwise the keyframe was lost and we ask for a new one once
+        const bool bLostKeyframe =
+            !m_bHasKeyframe || is_sequence_num_newer(packet.keyframe_sequence_num(), m_keyframe->sequence_num());
+        const bool bAlreadyRequested =
+            m_bHasRequestedKeyframe && m_requestedKeyframeSequenceNum == packet.keyframe_sequence_num();
+
+        if (bLostKeyframe && !bAlreadyRequested)
+        {
+            m_bHasRequestedKeyframe = true;
+            m_requestedKeyframeSequenceNum = packet.keyframe_sequence_num();
+
+            return decodeMissingKeyframe;
+        }
+
+        return decodeDroppedFrame;
+    }
+
+    // Everything but the device state comes from the delta frame itself
+    m_rebuilt->CopyFrom(packet);
+    m_rebuilt->clear_compressed_pose();
+
+    if (layout == nullptr)
+    {
+        return decodeRebuiltFrame;
+    }
+
+    const google::protobuf::Message &delta_state = packet_reflection->GetMessage(packet, layout->state_field);
+    google::protobuf::Message *state = packet_reflection->MutableMessage(m_rebuilt.get(), layout->state_field);
+    const google::protobuf::Descriptor *state_descriptor = state->GetDescriptor();
+    const google::protobuf::Reflection *state_reflection = state->GetReflection();
+    const unsigned int changed_state_fields = packet.changed_state_fields();
+
+    // Keyframe state with the changed fields replaced by the ones of the delta frame
+    state->CopyFrom(packet_reflection->GetMessage(*m_keyframe, layout->state_field));
+
+    for (int field_index = 0; field_index < state_descriptor->field_count(); ++field_index)
+    {
+        const google::protobuf::FieldDescriptor *field = state_descriptor->field(field_index);
+        const unsigned int field_bit = get_field_mask_bit(field);
+
+        if (field_bit == 0 || (changed_state_fields & field_bit) != 0)
+        {
+            state_reflection->ClearField(state, field);
+        }
+    }
+
+    state->MergeFrom(delta_state);
+
+    if (packet.has_compressed_pose())
+    {
+        const PSMoveProtocol::CompressedPose &compressed_pose = packet.compressed_pose();
+
+        if (layout->position_field != nullptr)
+        {
+            PSMoveProtocol::Position *position =
+                static_cast<PSMoveProtocol::Position *>(state_reflection->MutableMessage(state, layout->position_field));
+
+            position->set_x(decompressPositionComponent(compressed_pose.position_x()));
+            position->set_y(decompressPositionComponent(compressed_pose.position_y()));
+            position->set_z(decompressPositionComponent(compressed_pose.position_z()));
+        }
+
+        if (layout->orientation_field != nullptr)
+        {
+            PSMoveProtocol::Orientation *orientation =
+                static_cast<PSMoveProtocol::Orientation *>(state_reflection->MutableMessage(state, layout->orientation_field));
+            float x, y, z, w;
+
+            decompressOrientation(compressed_pose.orientation(), x, y, z, w);
+            orientation->set_x(x);
+            orientation->set_y(y);
+            orientation->set_z(z);
+            orientation->set_w(w);
+        }
+    }
+
+    return decodeRebuiltFrame;
+}
@@ -0,0 +1,162 @@
+#ifndef DATA_FRAME_DELTA_H
+#define DATA_FRAME_DELTA_H
+
+//-- includes -----
+#include <math.h>
+#include <stdint.h>
+#include <memory>
+
+//-- constants -----
+// A delta frame stream sends a keyframe at least this often (about half a second at 120Hz)
+#define DATA_FRAME_DELTA_KEYFRAME_INTERVAL 60
+
+// Compressed pose precision
+#define DATA_FRAME_DELTA_POSITION_UNITS_PER_CM 100.f
+#define DATA_FRAME_DELTA_ORIENTATION_COMPONENT_BITS 20
+
+//-- pre-declarations -----
+namespace PSMoveProtocol
+{
+    class DeviceOutputDataFrame_ControllerDataPacket;
+};
+
+//-- definitions -----
+/// Service side of a controller stream started with use_delta_frames, one per connection and controller.
+/// Every DATA_FRAME_DELTA_KEYFRAME_INTERVAL packets (or when the client asks) the full packet goes out as a keyframe.
+/// In between only the fields of the device state message (psmove_state, ...) that differ from that keyframe are sent,
+/// with the pose squeezed into a CompressedPose. Since every delta frame refers to the keyframe and not to the
+/// frame before it, losing a delta frame costs nothing and losing a keyframe only the frames up to the next one.
+class ControllerDataFrameDeltaEncoder
+{
+public:
+    ControllerDataFrameDeltaEncoder();
+    ~ControllerDataFrameDeltaEncoder();
+
+    // The client lost the keyframe, turn the next packet into one
+    inline void requestKeyframe()
+    { m_bKeyframeRequested = true; }
+
+    // Rewrites a full data packet in place into a keyframe or a delta frame
+    void encode(PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *packet);
+
+private:
+    std::unique_ptr<PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket> m_keyframe;
+    int m_framesSinceKeyframe;
+    bool m_bKeyframeRequested;
+
+    // The keyframe pose, quantized once when the keyframe is taken
+    int32_t m_keyframeCompressedPosition[3];
+    uint64_t m_keyframeCompressedOrientation;
+};
+
+/// Client side, rebuilds the full data packets of a delta frame stream
+class ControllerDataFrameDeltaDecoder
+{
+public:
+    enum eDecodeResult
+    {
+        decodeFullFrame,       // the packet is complete already, use it as is
+        decodeRebuiltFrame,    // use getRebuiltPacket()
+        decodeMissingKeyframe, // a delta frame of a keyframe we don't have, ask the service for a new keyframe
+        decodeDroppedFrame     // a late or unusable frame, skip it
+    };
+
+    ControllerDataFrameDeltaDecoder();
+    ~ControllerDataFrameDeltaDecoder();
+
+    eDecodeResult decode(const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket &packet);
+
+    inline const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket &getRebuiltPacket() const
+    { return *m_rebuilt; }
+
+    // Forget the keyframe, e.g. when the stream is restarted
+    void reset();
+
+private:
+    std::unique_ptr<PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket> m_keyframe;
+    std::unique_ptr<PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket> m_rebuilt;
+    bool m_bHasKeyframe;
+    bool m_bHasRequestedKeyframe;
+    int m_requestedKeyframeSequenceNum;
+};
+
+//-- compressed pose -----
+// Quantizes a position to DATA_FRAME_DELTA_POSITION_UNITS_PER_CM
+inline int32_t compressPositionComponent(const float position_cm)
+{
+    return static_cast<int32_t>(floorf(position_cm * DATA_FRAME_DELTA_POSITION_UNITS_PER_CM + 0.5f));
+}
+
+inline float decompressPositionComponent(const int32_t position)
+{
+    return static_cast<float>(position) / DATA_FRAME_DELTA_POSITION_UNITS_PER_CM;
+}
+
+// Packs a unit quaternion into 64 bits: the index of its largest component in the top two bits,
+// then the other three (flipped so the largest one is positive, which makes them at most 1/sqrt(2))
+// with DATA_FRAME_DELTA_ORIENTATION_COMPONENT_BITS each. The largest one follows from them being a unit quaternion.
+inline uint64_t compressOrientation(const float x, const float y, const float z, const float w)
+{
+    const float q[4] = { x, y, z, w };
+    const float k_max_component = 0.70710678f;
+    const uint32_t k_max_quantized = (1u << DATA_FRAME_DELTA_ORIENTATION_COMPONENT_BITS) - 1;
+
+    int largest_index = 0;
+    for (int index = 1; index < 4; ++index)
+    {
+        if (fabsf(q[index]) > fabsf(q[largest_index]))
+        {
+            largest_index = index;
+        }
+    }
+
+    const float sign = q[largest_index] < 0.f ? -1.f : 1.f;
+    uint64_t packed = static_cast<uint64_t>(largest_index);
+
+    for (int index = 0; index < 4; ++index)
+    {
+        if (index != largest_index)
+        {
+            const float unit = (sign * q[index] / k_max_component + 1.f) * 0.5f;
+            const float clamped = unit < 0.f ? 0.f : (unit > 1.f ? 1.f : unit);
+
+            packed = (packed << DATA_FRAME_DELTA_ORIENTATION_COMPONENT_BITS) |
+                static_cast<uint64_t>(floorf(clamped * static_cast<float>(k_max_quantized) + 0.5f));
+        }
+    }
+
+    return packed;
+}
+
+inline void decompressOrientation(const uint64_t packed, float &out_x, float &out_y, float &out_z, float &out_w)
+{
+    const float k_max_component = 0.70710678f;
+    const uint32_t k_max_quantized = (1u << DATA_FRAME_DELTA_ORIENTATION_COMPONENT_BITS) - 1;
+    const int largest_index = static_cast<int>((packed >> (3 * DATA_FRAME_DELTA_ORIENTATION_COMPONENT_BITS)) & 0x3);
+
+    float q[4];
+    float sum_sqr = 0.f;
+    int shift = 2 * DATA_FRAME_DELTA_ORIENTATION_COMPONENT_BITS;
+
+    for (int index = 0; index < 4; ++index)
+    {
+        if (index != largest_index)
+        {
+            const uint32_t quantized = static_cast<uint32_t>((packed >> shift) & k_max_quantized);
+            const float unit = static_cast<float>(quantized) / static_cast<float>(k_max_quantized);
+
+            q[index] = (unit * 2.f - 1.f) * k_max_component;
+            sum_sqr += q[index] * q[index];
+            shift -= DATA_FRAME_DELTA_ORIENTATION_COMPONENT_BITS;
+        }
+    }
+
+    q[largest_index] = sqrtf(sum_sqr < 1.f ? 1.f - sum_sqr : 0.f);
+
+    out_x = q[0];
+    out_y = q[1];
+    out_z = q[2];
+    out_w = q[3];
+}
+
+#endif // DATA_FRAME_DELTA_H
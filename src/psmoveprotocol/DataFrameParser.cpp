@@ -0,0 +1,60 @@
+//-- includes -----
+#include "DataFrameParser.h"
+#include "PackedMessage.h"
+#include "PSMoveProtocol.pb.h"
+#include <google/protobuf/arena.h>
+
+//-- public methods -----
+DeviceOutputDataFrameParser::DeviceOutputDataFrameParser()
+    : m_arenaBlock(DATA_FRAME_PARSER_ARENA_BLOCK_SIZE)
+    , m_arena()
+{
+    google::protobuf::ArenaOptions options;
+
+    // The arena hands out memory from our block first and keeps it across Reset()
+    options.initial_block = m_arenaBlock.data();
+    options.initial_block_size = m_arenaBlock.size();
+
+    m_arena.reset(new google::protobuf::Arena(options));
+}
+
+DeviceOutputDataFrameParser::~DeviceOutputDataFrameParser()
+{
+    // The arena has to go before the block it lives in
+    m_arena.reset();
+}
+
+const PSMoveProtocol::DeviceOutputDataFrame *
+DeviceOutputDataFrameParser::parse(const uint8_t *packed_data_frame, unsigned packed_size)
+{
+    const unsigned frame_size = get_packed_size(packed_data_frame, packed_size);
+
+    if (frame_size == 0)
+    {
+        return nullptr;
+    }
+
+    // Drops the last frame all at once
+    m_arena->Reset();
+
+    PSMoveProtocol::DeviceOutputDataFrame *data_frame =
+        google::protobuf::Arena::CreateMessage<PSMoveProtocol::DeviceOutputDataFrame>(m_arena.get());
+
+    return data_frame->ParseFromArray(packed_data_frame + HEADER_SIZE, static_cast<int>(frame_size - HEADER_SIZE)) ? data_frame : nullptr;
+}
+
+unsigned DeviceOutputDataFrameParser::get_packed_size(const uint8_t *packed_data_frame, unsigned packed_size)
+{
+    if (packed_size < HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    unsigned msg_size = 0;
+    for (unsigned i = 0; i < HEADER_SIZE; ++i)
+    {
+        msg_size = msg_size * 256 + (static_cast<unsigned>(packed_data_frame[i]) & 0xFF);
+    }
+
+    return (msg_size <= packed_size - HEADER_SIZE) ? HEADER_SIZE + msg_size : 0;
+}
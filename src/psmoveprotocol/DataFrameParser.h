@@ -0,0 +1,51 @@
+#ifndef DATA_FRAME_PARSER_H
+#define DATA_FRAME_PARSER_H
+
+//-- includes -----
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+//-- constants -----
+// Room for the message tree of the largest data frame many times over,
+// so parsing a frame never has to go to the heap for more
+#define DATA_FRAME_PARSER_ARENA_BLOCK_SIZE (16*1024)
+
+//-- pre-declarations -----
+namespace google
+{
+    namespace protobuf
+    {
+        class Arena;
+    };
+};
+
+namespace PSMoveProtocol
+{
+    class DeviceOutputDataFrame;
+};
+
+//-- definitions -----
+/// Parses packed device data frames (header + body) without any heap allocations once warmed up.
+/// Every frame is parsed into a fresh message on an arena living in one preallocated block,
+/// which is rewound before the next frame rather than freeing the message tree piece by piece.
+class DeviceOutputDataFrameParser
+{
+public:
+    DeviceOutputDataFrameParser();
+    ~DeviceOutputDataFrameParser();
+
+    // Returns null if the buffer doesn't hold a valid data frame.
+    // The returned frame is only valid until the next call.
+    const PSMoveProtocol::DeviceOutputDataFrame *parse(const uint8_t *packed_data_frame, unsigned packed_size);
+
+    // Size of the header + message at the start of the buffer (datagrams can have padding after it),
+    // or 0 if the buffer is too short to hold it
+    static unsigned get_packed_size(const uint8_t *packed_data_frame, unsigned packed_size);
+
+private:
+    std::vector<char> m_arenaBlock;
+    std::unique_ptr<google::protobuf::Arena> m_arena;
+};
+
+#endif // DATA_FRAME_PARSER_H
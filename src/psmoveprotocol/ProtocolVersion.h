@@ -12,9 +12,9 @@
 #define PSM_RELEASE_VERSION_PRODUCT 0
 #define PSM_RELEASE_VERSION_MAJOR   9
 #define PSM_RELEASE_VERSION_PHASE   alpha
-#define PSM_RELEASE_VERSION_MINOR   9
+#define PSM_RELEASE_VERSION_MINOR   10
 #define PSM_RELEASE_VERSION_RELEASE 0
-#define PSM_RELEASE_VERSION_HOTFIX  1
+#define PSM_RELEASE_VERSION_HOTFIX  0
 
 /// "Product.Major-Phase Minor.Release.Hotfix"
 #if !defined(PSM_RELEASE_VERSION_STRING)
@@ -19,9 +19,15 @@
 // NOTE: This list must match the tracker order in CommonDeviceState::eDeviceType
 USBDeviceFilter k_supported_tracker_infos[MAX_CAMERA_TYPE_INDEX] = {
     { 0x1415, 0x2000 }, // PS3Eye
+    { 0x0000, 0x0000 }, // VirtualTracker (not a USB device)
+    { 0x0000, 0x0000 }, // RemoteTracker (not a USB device)
     //{ 0x05a9, 0x058a }, // PS4 Camera - TODO
 };
 
+//-- Statics
+int TrackerDeviceEnumerator::virtual_tracker_count= 0;
+int TrackerDeviceEnumerator::remote_tracker_count= 0;
+
 // -- private prototypes -----
 static bool is_tracker_supported(USBDeviceEnumerator* enumerator, CommonDeviceState::eDeviceType device_type_filter, CommonDeviceState::eDeviceType &out_device_type);
 
@@ -30,6 +36,7 @@ TrackerDeviceEnumerator::TrackerDeviceEnumerator()
 	: DeviceEnumerator()
 	, m_usb_enumerator(nullptr)
     , m_cameraIndex(-1)
+    , m_virtualTrackerIndex(-1)
 {
 	USBDeviceManager *usbRequestMgr = USBDeviceManager::getInstance();
 
@@ -61,7 +68,11 @@ int TrackerDeviceEnumerator::get_vendor_id() const
 	USBDeviceFilter devInfo;
 	int vendor_id = -1;
 
-	if (is_valid() && usb_device_enumerator_get_filter(m_usb_enumerator, devInfo))
+	if (m_virtualTrackerIndex >= 0)
+	{
+		vendor_id = is_valid() ? 0x0000 : -1;
+	}
+	else if (is_valid() && usb_device_enumerator_get_filter(m_usb_enumerator, devInfo))
 	{
 		vendor_id = devInfo.vendor_id;
 	}
@@ -74,7 +85,11 @@ int TrackerDeviceEnumerator::get_product_id() const
 	USBDeviceFilter devInfo;
 	int product_id = -1;
 
-	if (is_valid() && usb_device_enumerator_get_filter(m_usb_enumerator, devInfo))
+	if (m_virtualTrackerIndex >= 0)
+	{
+		product_id = is_valid() ? 0x0000 : -1;
+	}
+	else if (is_valid() && usb_device_enumerator_get_filter(m_usb_enumerator, devInfo))
 	{
 		product_id = devInfo.product_id;
 	}
@@ -97,7 +112,10 @@ const char *TrackerDeviceEnumerator::get_path() const
 
 bool TrackerDeviceEnumerator::is_valid() const
 {
-	return m_usb_enumerator != nullptr && usb_device_enumerator_is_valid(m_usb_enumerator);
+	return 
+		(m_virtualTrackerIndex < 0) 
+		? is_usb_valid() 
+		: m_virtualTrackerIndex < virtual_tracker_count + remote_tracker_count;
 }
 
 bool TrackerDeviceEnumerator::next()
@@ -105,15 +123,30 @@ bool TrackerDeviceEnumerator::next()
 	USBDeviceManager *usbRequestMgr = USBDeviceManager::getInstance();
 	bool foundValid = false;
 
-	while (is_valid() && !foundValid)
+	if (m_virtualTrackerIndex < 0)
 	{
-		usb_device_enumerator_next(m_usb_enumerator);
+		while (is_usb_valid() && !foundValid)
+		{
+			usb_device_enumerator_next(m_usb_enumerator);
+
+			if (testUSBEnumerator())
+			{
+				foundValid= true;
+			}
+		}
 
-		if (testUSBEnumerator())
+		// Virtual and remote trackers are enumerated once the USB cameras run out
+		if (!foundValid)
 		{
-			foundValid= true;
+			m_virtualTrackerIndex= 0;
+			foundValid= testVirtualEnumerator();
 		}
 	}
+	else if (is_valid())
+	{
+		++m_virtualTrackerIndex;
+		foundValid= testVirtualEnumerator();
+	}
 
 	if (foundValid)
 	{
@@ -127,7 +160,7 @@ bool TrackerDeviceEnumerator::testUSBEnumerator()
 {
 	bool foundValid= false;
 
-	if (is_valid() && is_tracker_supported(m_usb_enumerator, m_deviceTypeFilter, m_deviceType))
+	if (is_usb_valid() && is_tracker_supported(m_usb_enumerator, m_deviceTypeFilter, m_deviceType))
 	{
 		char USBPath[256];
 
@@ -152,6 +185,48 @@ bool TrackerDeviceEnumerator::testUSBEnumerator()
 	return foundValid;
 }
 
+bool TrackerDeviceEnumerator::testVirtualEnumerator()
+{
+	bool foundValid= false;
+
+	while (!foundValid && is_valid())
+	{
+		const bool bIsRemote= m_virtualTrackerIndex >= virtual_tracker_count;
+		const CommonDeviceState::eDeviceType device_type= 
+			bIsRemote ? CommonDeviceState::RemoteTracker : CommonDeviceState::VirtualTracker;
+
+		if (m_deviceTypeFilter != CommonDeviceState::INVALID_DEVICE_TYPE &&
+			m_deviceTypeFilter != device_type)
+		{
+			// Filtered out, skip ahead
+			++m_virtualTrackerIndex;
+		}
+		else
+		{
+			if (bIsRemote)
+			{
+				ServerUtility::format_string(
+					m_currentUSBPath, sizeof(m_currentUSBPath), "RemoteTracker_%d", m_virtualTrackerIndex - virtual_tracker_count);
+			}
+			else
+			{
+				ServerUtility::format_string(
+					m_currentUSBPath, sizeof(m_currentUSBPath), "VirtualTracker_%d", m_virtualTrackerIndex);
+			}
+			m_deviceType= device_type;
+
+			foundValid= true;
+		}
+	}
+
+	return foundValid;
+}
+
+bool TrackerDeviceEnumerator::is_usb_valid() const
+{
+	return m_usb_enumerator != nullptr && usb_device_enumerator_is_valid(m_usb_enumerator);
+}
+
 //-- private methods -----
 static bool is_tracker_supported(
 	USBDeviceEnumerator *enumerator, 
@@ -168,6 +243,12 @@ static bool is_tracker_supported(
 		{
 			const USBDeviceFilter &supported_type = k_supported_tracker_infos[tracker_type_index];
 
+			if (supported_type.vendor_id == 0x0000)
+			{
+				// Not a USB camera
+				continue;
+			}
+
 			if (devInfo.product_id == supported_type.product_id &&
 				devInfo.vendor_id == supported_type.vendor_id)
 			{
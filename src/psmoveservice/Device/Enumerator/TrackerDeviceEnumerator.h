@@ -18,15 +18,25 @@ public:
 	int get_product_id() const override;
     const char *get_path() const override;
     inline int get_camera_index() const { return m_cameraIndex; }
+    // Index among the remote trackers, -1 for every other kind of tracker
+    inline int get_remote_tracker_index() const
+    { return (m_virtualTrackerIndex >= virtual_tracker_count) ? m_virtualTrackerIndex - virtual_tracker_count : -1; }
 	inline struct USBDeviceEnumerator* get_usb_device_enumerator() const { return m_usb_enumerator; }
 
+    // Assigned by the tracker manager on startup
+    static int virtual_tracker_count;
+    static int remote_tracker_count;
+
 protected: 
 	bool testUSBEnumerator();
+	bool testVirtualEnumerator();
+	bool is_usb_valid() const;
 
 private:
     char m_currentUSBPath[256];
 	struct USBDeviceEnumerator* m_usb_enumerator;
     int m_cameraIndex;
+    int m_virtualTrackerIndex; // -1 while still enumerating USB cameras, then the virtual trackers followed by the remote ones
 };
 
 #endif // TRACKER_DEVICE_ENUMERATOR_H
@@ -204,7 +204,9 @@ struct CommonDeviceState
         SUPPORTED_CONTROLLER_TYPE_COUNT = Controller + 0x04,
         
         PS3EYE = TrackingCamera + 0x00,
-        SUPPORTED_CAMERA_TYPE_COUNT = TrackingCamera + 0x01,
+        VirtualTracker = TrackingCamera + 0x01,
+        RemoteTracker = TrackingCamera + 0x02,
+        SUPPORTED_CAMERA_TYPE_COUNT = TrackingCamera + 0x03,
         
         Morpheus = HeadMountedDisplay + 0x00,
         VirtualHMD = HeadMountedDisplay + 0x01,
@@ -245,6 +247,12 @@ struct CommonDeviceState
         case PS3EYE:
             result = "PSEYE";
             break;
+        case VirtualTracker:
+            result = "VirtualTracker";
+            break;
+        case RemoteTracker:
+            result = "RemoteTracker";
+            break;
         case Morpheus:
             result = "Morpheus";
             break;
@@ -364,6 +372,7 @@ struct CommonDeviceTrackingShape
 
 		struct {
 			CommonDevicePosition point[MAX_POINT_CLOUD_POINT_COUNT];
+			CommonDeviceVector normal[MAX_POINT_CLOUD_POINT_COUNT]; // direction each point (LED) faces
 			int point_count;
 		} point_cloud;
     } shape;
@@ -0,0 +1,132 @@
+//-- includes -----
+#include "BlobAssignment.h"
+#include <algorithm>
+#include <assert.h>
+#include <limits>
+
+//-- constants -----
+static const float k_min_position_sigma_px = 2.f;
+static const float k_max_center_distance_sq = 9.f; // 3 sigma gate on the blob's center
+static const float k_radius_sigma_fraction = 0.35f; // blob radius noise relative to the predicted radius
+static const float k_min_radius_sigma_px = 2.f;
+static const float k_gated_cost = 1.0e4f; // stands in for "never", keeps the solver's sums finite
+
+//-- public methods -----
+float computeBlobAssignmentCost(const BlobAssignmentPrediction &prediction, const BlobAssignmentCandidate &blob)
+{
+    const float position_sigma = std::max(prediction.position_sigma_px, k_min_position_sigma_px);
+    const float center_distance_sq = (blob.center - prediction.center).squaredNorm() / (position_sigma*position_sigma);
+
+    if (center_distance_sq > k_max_center_distance_sq)
+    {
+        return k_gated_cost;
+    }
+
+    const float radius_sigma = std::max(k_radius_sigma_fraction*prediction.radius, k_min_radius_sigma_px);
+    const float radius_error = (blob.radius - prediction.radius) / radius_sigma;
+
+    return center_distance_sq + radius_error*radius_error;
+}
+
+//-- BlobAssignmentSolver -----
+int
+BlobAssignmentSolver::solve(const float *costs, const int device_count, const int blob_count, int *out_device_blob_indices)
+{
+    // Columns are the blobs followed by one private "unassigned" column per device,
+    // so there are always at least as many columns as rows.
+    // Rows and columns are 1-based below, column 0 is the solver's free slot.
+    const int row_count = device_count;
+    const int column_count = blob_count + device_count;
+    const float infinity = std::numeric_limits<float>::max();
+
+    auto cost = [costs, blob_count](int row, int column) -> float {
+        if (column < blob_count)
+        {
+            return std::min(costs[row*blob_count + column], k_gated_cost);
+        }
+
+        return (column - blob_count == row) ? BLOB_ASSIGNMENT_MAX_COST : k_gated_cost;
+    };
+
+    m_potential_u.assign(row_count + 1, 0.f);
+    m_potential_v.assign(column_count + 1, 0.f);
+    m_column_rows.assign(column_count + 1, 0);
+    m_column_ways.assign(column_count + 1, 0);
+
+    for (int row = 1; row <= row_count; ++row)
+    {
+        int free_column = 0;
+
+        m_column_rows[0] = row;
+        m_min_slack.assign(column_count + 1, infinity);
+        m_column_used.assign(column_count + 1, false);
+
+        // Grow an alternating path from the new row until it reaches a free column
+        do
+        {
+            const int path_row = m_column_rows[free_column];
+            float delta = infinity;
+            int next_column = 0;
+
+            m_column_used[free_column] = true;
+            for (int column = 1; column <= column_count; ++column)
+            {
+                if (!m_column_used[column])
+                {
+                    const float slack = cost(path_row - 1, column - 1) - m_potential_u[path_row] - m_potential_v[column];
+
+                    if (slack < m_min_slack[column])
+                    {
+                        m_min_slack[column] = slack;
+                        m_column_ways[column] = free_column;
+                    }
+                    if (m_min_slack[column] < delta)
+                    {
+                        delta = m_min_slack[column];
+                        next_column = column;
+                    }
+                }
+            }
+
+            for (int column = 0; column <= column_count; ++column)
+            {
+                if (m_column_used[column])
+                {
+                    m_potential_u[m_column_rows[column]] += delta;
+                    m_potential_v[column] -= delta;
+                }
+                else
+                {
+                    m_min_slack[column] -= delta;
+                }
+            }
+
+            free_column = next_column;
+        } while (m_column_rows[free_column] != 0);
+
+        // Flip the path
+        do
+        {
+            const int previous_column = m_column_ways[free_column];
+
+            m_column_rows[free_column] = m_column_rows[previous_column];
+            free_column = previous_column;
+        } while (free_column != 0);
+    }
+
+    int assigned_count = 0;
+
+    std::fill(out_device_blob_indices, out_device_blob_indices + device_count, -1);
+    for (int column = 1; column <= blob_count; ++column)
+    {
+        const int row = m_column_rows[column];
+
+        if (row != 0 && costs[(row - 1)*blob_count + (column - 1)] <= BLOB_ASSIGNMENT_MAX_COST)
+        {
+            out_device_blob_indices[row - 1] = column - 1;
+            ++assigned_count;
+        }
+    }
+
+    return assigned_count;
+}
@@ -0,0 +1,52 @@
+#ifndef BLOB_ASSIGNMENT_H
+#define BLOB_ASSIGNMENT_H
+
+//-- includes -----
+#include "MathEigen.h"
+#include <vector>
+
+//-- constants -----
+// Pairs costing more than this are left unassigned
+#define BLOB_ASSIGNMENT_MAX_COST 16.f
+
+//-- definitions -----
+// Where a device is expected to show up in a camera frame
+struct BlobAssignmentPrediction
+{
+    Eigen::Vector2f center; // pixels
+    float radius; // pixels, from the tracking shape's size at the predicted depth
+    float position_sigma_px; // uncertainty of the predicted center
+};
+
+struct BlobAssignmentCandidate
+{
+    Eigen::Vector2f center; // pixels
+    float radius; // pixels
+};
+
+// Squared Mahalanobis distance of the blob's center from the prediction plus a size mismatch term.
+// Returns a cost above BLOB_ASSIGNMENT_MAX_COST if the blob is out of the prediction's gate.
+float computeBlobAssignmentCost(const BlobAssignmentPrediction &prediction, const BlobAssignmentCandidate &blob);
+
+/// Pairs the devices seen by one camera with the blobs found in its frame at the lowest total cost
+/// (Hungarian algorithm), so two nearby devices can't both claim the same blob.
+/// Every device can also stay unassigned at BLOB_ASSIGNMENT_MAX_COST.
+/// Working buffers are kept between calls, steady state solves don't allocate.
+class BlobAssignmentSolver
+{
+public:
+    // costs is device_count x blob_count, row major.
+    // out_device_blob_indices[i] is set to the blob index paired with device i or -1.
+    // Returns the number of devices that got a blob.
+    int solve(const float *costs, const int device_count, const int blob_count, int *out_device_blob_indices);
+
+private:
+    std::vector<float> m_potential_u;
+    std::vector<float> m_potential_v;
+    std::vector<int> m_column_rows;
+    std::vector<int> m_column_ways;
+    std::vector<float> m_min_slack;
+    std::vector<bool> m_column_used;
+};
+
+#endif // BLOB_ASSIGNMENT_H
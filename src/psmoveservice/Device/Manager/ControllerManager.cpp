@@ -6,6 +6,7 @@
 #include "OrientationFilter.h"
 #include "PSMoveProtocol.pb.h"
 #include "ServerLog.h"
+#include "ServerTrace.h"
 #include "ServerControllerView.h"
 #include "ServerDeviceView.h"
 #include "ServerNetworkManager.h"
@@ -15,6 +16,9 @@
 #include "hidapi.h"
 #include "gamepad/Gamepad.h"
 
+//-- constants -----
+static const int k_default_max_controller_count = 5; // slot count before it became configurable
+
 //-- methods -----
 //-- Tracker Manager Config -----
 const int ControllerManagerConfig::CONFIG_VERSION = 1;
@@ -22,6 +26,7 @@ const int ControllerManagerConfig::CONFIG_VERSION = 1;
 ControllerManagerConfig::ControllerManagerConfig(const std::string &fnamebase)
     : PSMoveConfig(fnamebase)
     , virtual_controller_count(0)
+    , max_controller_count(k_default_max_controller_count)
 {
 
 };
@@ -33,6 +38,7 @@ ControllerManagerConfig::config2ptree()
 
     pt.put("version", ControllerManagerConfig::CONFIG_VERSION);
     pt.put("virtual_controller_count", virtual_controller_count);
+    pt.put("max_controller_count", max_controller_count);
 
     return pt;
 }
@@ -45,6 +51,7 @@ ControllerManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
     if (version == ControllerManagerConfig::CONFIG_VERSION)
     {
         virtual_controller_count = pt.get<int>("virtual_controller_count", 0);
+        max_controller_count = pt.get<int>("max_controller_count", k_default_max_controller_count);
     }
     else
     {
@@ -65,6 +72,12 @@ ControllerManager::startup()
 {
     bool success = true;
 
+    // Load any config from disk (before the base class allocates the configured device slots)
+    cfg.load();
+
+    // Save back out the config in case there were updated defaults
+    cfg.save();
+
     if (!DeviceTypeManager::startup())
     {
         success = false;
@@ -72,12 +85,6 @@ ControllerManager::startup()
 
     if (success)
     {
-		// Load any config from disk
-		cfg.load();
-
-        // Save back out the config in case there were updated defaults
-        cfg.save();
-
         // Copy the virtual controller count into the Virtual and Gamepad controller enumerator's static variable.
         // This breaks the dependency between the Controller Manager and the enumerator.
         VirtualControllerEnumerator::virtual_controller_count= cfg.virtual_controller_count;
@@ -125,7 +132,15 @@ ControllerManager::shutdown()
 void
 ControllerManager::updateStateAndPredict(TrackerManager* tracker_manager)
 {
-	for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+	// Hand out each new frame's blobs before the controllers go looking for them,
+	// so two controllers can't both claim the same blob
+	if (tracker_manager->getConfig().use_global_blob_assignment)
+	{
+		SERVER_TRACE_SCOPE("TrackerManager::assignControllerBlobs");
+		tracker_manager->assignControllerBlobs();
+	}
+
+	for (int device_id : getOpenDeviceIds())
 	{
 		ServerControllerViewPtr controllerView = getControllerViewPtr(device_id);
 
@@ -133,8 +148,14 @@ ControllerManager::updateStateAndPredict(TrackerManager* tracker_manager)
 			controllerView->getControllerDeviceType() != CommonDeviceState::PSNavi &&
             (controllerView->getIsBluetooth() || controllerView->getIsVirtualController()))
 		{
-			controllerView->updateOpticalPoseEstimation(tracker_manager);
-			controllerView->updateStateAndPredict();
+			{
+				SERVER_TRACE_DEVICE_SCOPE("ServerControllerView::updateOpticalPoseEstimation", device_id);
+				controllerView->updateOpticalPoseEstimation(tracker_manager);
+			}
+			{
+				SERVER_TRACE_DEVICE_SCOPE("ServerControllerView::updateStateAndPredict", device_id);
+				controllerView->updateStateAndPredict();
+			}
 		}
 	}
 }
@@ -144,7 +165,7 @@ void ControllerManager::publish()
     DeviceTypeManager::publish();
 
     bool bWasSystemButtonPressed= false;
-    for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+    for (int device_id : getOpenDeviceIds())
 	{
 		ServerControllerViewPtr controllerView = getControllerViewPtr(device_id);
 
@@ -154,7 +175,7 @@ void ControllerManager::publish()
         }
     }
 
-    if (bWasSystemButtonPressed)
+    if (bWasSystemButtonPressed && ServerNetworkManager::get_instance() != nullptr)
     {
         ResponsePtr response(new PSMoveProtocol::Response);
         response->set_type(PSMoveProtocol::Response_ResponseType_SYSTEM_BUTTON_PRESSED);
@@ -27,6 +27,7 @@ public:
 
     int version;
     int virtual_controller_count;
+    int max_controller_count; // controller slots to allocate, at most PSMOVESERVICE_MAX_CONTROLLER_COUNT
 };
 
 class ControllerManager : public DeviceTypeManager
@@ -48,11 +49,8 @@ public:
         return cfg;
     }
 
+    // Compile time ceiling, the slot count actually used is getMaxDevices()
     static const int k_max_devices = PSMOVESERVICE_MAX_CONTROLLER_COUNT;
-    int getMaxDevices() const override
-    {
-        return ControllerManager::k_max_devices;
-    }
 
     int getGamepadCount() const;
 
@@ -69,6 +67,15 @@ protected:
 	// Fetch latest controller state
 	void poll_devices() override;
 
+	int getConfiguredMaxDevices() const override
+	{
+		return cfg.max_controller_count;
+	}
+	int getDeviceCountCeiling() const override
+	{
+		return ControllerManager::k_max_devices;
+	}
+
 	// Controller enumerator methods
     class DeviceEnumerator *allocate_device_enumerator() override;
     void free_device_enumerator(class DeviceEnumerator *) override;
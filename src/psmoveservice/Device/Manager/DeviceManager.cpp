@@ -13,6 +13,7 @@
 #include "ServerTrackerView.h"
 #include "ServerRequestHandler.h"
 #include "ServerLog.h"
+#include "ServerTrace.h"
 #include "ServerDeviceView.h"
 #include "ServerNetworkManager.h"
 #include "ServerUtility.h"
@@ -194,21 +195,33 @@ DeviceManager::startup()
 void
 DeviceManager::update()
 {
+    SERVER_TRACE_SCOPE("DeviceManager::update");
+
 	if (m_platform_api != nullptr)
 	{
+        SERVER_TRACE_SCOPE("DeviceManager::platform_poll");
 		m_platform_api->poll(); // Send device hotplug events
 	}
 
-    m_controller_manager->poll(); // Update controller counts and poll button/IMU state
-    m_tracker_manager->poll(); // Update tracker count and poll video frames
-    m_hmd_manager->poll(); // Update HMD count and poll IMU state
+    {
+        SERVER_TRACE_SCOPE("DeviceManager::poll");
+        m_controller_manager->poll(); // Update controller counts and poll button/IMU state
+        m_tracker_manager->poll(); // Update tracker count and poll video frames
+        m_hmd_manager->poll(); // Update HMD count and poll IMU state
+    }
 
-    m_controller_manager->updateStateAndPredict(m_tracker_manager); // Compute pose/prediction of tracking blob+IMU state
-    m_hmd_manager->updateStateAndPredict(m_tracker_manager); // Compute pose/prediction of tracking blobs+IMU state
+    {
+        SERVER_TRACE_SCOPE("DeviceManager::updateStateAndPredict");
+        m_controller_manager->updateStateAndPredict(m_tracker_manager); // Compute pose/prediction of tracking blob+IMU state
+        m_hmd_manager->updateStateAndPredict(m_tracker_manager); // Compute pose/prediction of tracking blobs+IMU state
+    }
 
-    m_controller_manager->publish(); // publish controller state to any listening clients  (common case)
-    m_tracker_manager->publish(); // publish tracker state to any listening clients (probably only used by ConfigTool)
-    m_hmd_manager->publish(); // publish hmd state to any listening clients (common case)
+    {
+        SERVER_TRACE_SCOPE("DeviceManager::publish");
+        m_controller_manager->publish(); // publish controller state to any listening clients  (common case)
+        m_tracker_manager->publish(); // publish tracker state to any listening clients (probably only used by ConfigTool)
+        m_hmd_manager->publish(); // publish hmd state to any listening clients (common case)
+    }
 }
 
 void
@@ -8,12 +8,15 @@
 #include "ServerUtility.h"
 #include "ServerRequestHandler.h"
 
+#include <algorithm>
+
 //-- methods -----
 /// Constructor and set intervals (ms) for reconnect and polling
 DeviceTypeManager::DeviceTypeManager(const int recon_int, const int poll_int)
     : reconnect_interval(recon_int)
     , poll_interval(poll_int)
     , m_deviceViews(nullptr)
+    , m_maxDevices(0)
 	, m_bIsDeviceListDirty(false)
 {
 }
@@ -29,8 +32,20 @@ DeviceTypeManager::startup()
 {
     assert(m_deviceViews == nullptr);
 
-    const int maxDeviceCount = getMaxDevices();
+    const int ceiling = getDeviceCountCeiling();
+    const int configuredCount = getConfiguredMaxDevices();
+    m_maxDevices = std::max(std::min(configuredCount, ceiling), 1);
+
+    if (m_maxDevices != configuredCount)
+    {
+        SERVER_LOG_WARNING("DeviceTypeManager::startup") <<
+            "Configured device count " << configuredCount << " clamped to " << m_maxDevices;
+    }
+
+    const int maxDeviceCount = m_maxDevices;
     m_deviceViews = new ServerDeviceViewPtr[maxDeviceCount];
+    m_openDeviceIds.clear();
+    m_openDeviceIds.reserve(maxDeviceCount);
 
     // Allocate all of the device views
     for (int device_id = 0; device_id < maxDeviceCount; ++device_id)
@@ -68,6 +83,7 @@ DeviceTypeManager::shutdown()
 		// Free the device view pointer list
 		delete[] m_deviceViews;
 		m_deviceViews = nullptr;
+		m_openDeviceIds.clear();
 	}
 }
 
@@ -116,13 +132,10 @@ DeviceTypeManager::update_connected_devices()
     if (can_update_connected_devices())
     {
         const int maxDeviceCount = getMaxDevices();
-        bool exists_in_enumerator[64];
         bool bSendControllerUpdatedNotification = false;
 
-        // Initialize temp table used to keep track of open devices
-        // still found in the enumerator
-        assert(maxDeviceCount <= 64);
-        memset(exists_in_enumerator, 0, sizeof(exists_in_enumerator));
+        // Temp table used to keep track of open devices still found in the enumerator
+        std::vector<bool> exists_in_enumerator(maxDeviceCount, false);
 
         // Step 1
         // Mark any open devices that still show up in the enumerator.
@@ -206,6 +219,9 @@ DeviceTypeManager::update_connected_devices()
             }
         }
 
+        // Devices may also have been closed outside of this method (e.g. bluetooth unpairing)
+        rebuild_open_device_list();
+
         // List of open devices changed, tell the clients
         if (bSendControllerUpdatedNotification)
         {
@@ -222,7 +238,7 @@ void
 DeviceTypeManager::publish()
 {
     // Publish any new data to client connections
-    for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+    for (int device_id : m_openDeviceIds)
     {
         ServerDeviceViewPtr device = getDeviceViewPtr(device_id);
 
@@ -230,6 +246,29 @@ DeviceTypeManager::publish()
     }
 }
 
+void
+DeviceTypeManager::rebuild_open_device_list()
+{
+    // Per-frame loops only visit open devices, so let the manager drop state tied to the ones that closed
+    for (int device_id : m_openDeviceIds)
+    {
+        if (!m_deviceViews[device_id]->getIsOpen())
+        {
+            handle_device_closed(device_id);
+        }
+    }
+
+    m_openDeviceIds.clear();
+
+    for (int device_id = 0; device_id < m_maxDevices; ++device_id)
+    {
+        if (m_deviceViews[device_id]->getIsOpen())
+        {
+            m_openDeviceIds.push_back(device_id);
+        }
+    }
+}
+
 void
 DeviceTypeManager::send_device_list_changed_notification()
 {
@@ -238,7 +277,11 @@ DeviceTypeManager::send_device_list_changed_notification()
     response->set_request_id(-1);
     response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
 
-    ServerNetworkManager::get_instance()->send_notification_to_all_clients(response);
+    // No network manager when running headless (e.g. the tracking benchmark)
+    if (ServerNetworkManager::get_instance() != nullptr)
+    {
+        ServerNetworkManager::get_instance()->send_notification_to_all_clients(response);
+    }
 }
 
 bool
@@ -260,7 +303,7 @@ DeviceTypeManager::poll_devices()
     {
         bool bAllUpdatedOk = true;
 
-        for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+        for (int device_id : m_openDeviceIds)
         {
             ServerDeviceViewPtr device = getDeviceViewPtr(device_id);
             bAllUpdatedOk &= device->poll();
@@ -268,6 +311,8 @@ DeviceTypeManager::poll_devices()
 
         if (!bAllUpdatedOk)
         {
+            // Devices that failed to poll were closed
+            rebuild_open_device_list();
             send_device_list_changed_notification();
         }
     }
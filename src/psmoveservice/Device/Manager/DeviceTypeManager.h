@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <chrono>
+#include <vector>
 
 //-- typedefs -----
 class ServerDeviceView;
@@ -26,7 +27,19 @@ public:
     void poll();
     virtual void publish();
 
-    virtual int getMaxDevices() const = 0;
+    /// Number of device slots, fixed by the manager's config at startup
+    inline int getMaxDevices() const
+    {
+        return m_maxDevices;
+    }
+
+    /// Ids of the currently open devices in ascending order.
+    /// Per-frame work should walk this instead of every slot so it scales with
+    /// the connected devices rather than the configured capacity.
+    inline const std::vector<int> &getOpenDeviceIds() const
+    {
+        return m_openDeviceIds;
+    }
 
     /**
     Returns an upcast device view ptr. Useful for generic functions that are
@@ -54,6 +67,16 @@ protected:
     */
     bool update_connected_devices();
 
+    /// Slot count to allocate in startup(), clamped to [1, getDeviceCountCeiling()]
+    virtual int getConfiguredMaxDevices() const = 0;
+    /// Compile time upper bound on the slot count (sizes the stack arrays of the device views)
+    virtual int getDeviceCountCeiling() const = 0;
+
+    /// Re-collects the open device ids after devices were opened or closed
+    void rebuild_open_device_list();
+    /// Called by rebuild_open_device_list() for each device that was open at the previous rebuild and isn't anymore
+    virtual void handle_device_closed(int device_id) {}
+
     virtual bool can_poll_connected_devices();
     virtual bool can_update_connected_devices();
     virtual class DeviceEnumerator *allocate_device_enumerator() = 0;
@@ -71,6 +94,8 @@ protected:
     std::chrono::time_point<std::chrono::high_resolution_clock> m_last_poll_time;
 
     ServerDeviceViewPtr *m_deviceViews;
+    int m_maxDevices;
+    std::vector<int> m_openDeviceIds;
 
 	bool m_bIsDeviceListDirty;
 };
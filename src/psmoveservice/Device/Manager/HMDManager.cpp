@@ -2,12 +2,16 @@
 #include "HMDManager.h"
 #include "HMDDeviceEnumerator.h"
 #include "ServerLog.h"
+#include "ServerTrace.h"
 #include "ServerHMDView.h"
 #include "ServerDeviceView.h"
 #include "PSMoveProtocol.pb.h"
 #include <boost/foreach.hpp>
 #include "VirtualHMDDeviceEnumerator.h"
 
+//-- constants -----
+static const int k_default_max_hmd_count = 4; // slot count before it became configurable
+
 //-- methods -----
 //-- Tracker Manager Config -----
 const int HMDManagerConfig::CONFIG_VERSION = 1;
@@ -15,6 +19,7 @@ const int HMDManagerConfig::CONFIG_VERSION = 1;
 HMDManagerConfig::HMDManagerConfig(const std::string &fnamebase)
     : PSMoveConfig(fnamebase)
     , virtual_hmd_count(0)
+    , max_hmd_count(k_default_max_hmd_count)
 {
 
 };
@@ -26,6 +31,7 @@ HMDManagerConfig::config2ptree()
 
     pt.put("version", HMDManagerConfig::CONFIG_VERSION);
     pt.put("virtual_hmd_count", virtual_hmd_count);
+    pt.put("max_hmd_count", max_hmd_count);
 
     return pt;
 }
@@ -38,6 +44,7 @@ HMDManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
     if (version == HMDManagerConfig::CONFIG_VERSION)
     {
         virtual_hmd_count = pt.get<int>("virtual_hmd_count", 0);
+        max_hmd_count = pt.get<int>("max_hmd_count", k_default_max_hmd_count);
     }
     else
     {
@@ -58,14 +65,14 @@ HMDManager::startup()
 {
     bool success = false;
 
-    if (DeviceTypeManager::startup())
-    {
-		// Load any config from disk
-		cfg.load();
+    // Load any config from disk (before the base class allocates the configured device slots)
+    cfg.load();
 
-        // Save back out the config in case there were updated defaults
-        cfg.save();
+    // Save back out the config in case there were updated defaults
+    cfg.save();
 
+    if (DeviceTypeManager::startup())
+    {
         // Copy the virtual controller count into the Virtual controller enumerator static variable.
         // This breaks the dependency between the Controller Manager and the enumerator.
         VirtualHMDDeviceEnumerator::virtual_hmd_count= cfg.virtual_hmd_count;
@@ -85,14 +92,20 @@ HMDManager::shutdown()
 void
 HMDManager::updateStateAndPredict(TrackerManager* tracker_manager)
 {
-	for (int device_id = 0; device_id < getMaxDevices(); ++device_id)
+	for (int device_id : getOpenDeviceIds())
 	{
 		ServerHMDViewPtr hmdView = getHMDViewPtr(device_id);
 
 		if (hmdView->getIsOpen())
 		{
-			hmdView->updateOpticalPoseEstimation(tracker_manager);
-			hmdView->updateStateAndPredict();
+			{
+				SERVER_TRACE_DEVICE_SCOPE("ServerHMDView::updateOpticalPoseEstimation", device_id);
+				hmdView->updateOpticalPoseEstimation(tracker_manager);
+			}
+			{
+				SERVER_TRACE_DEVICE_SCOPE("ServerHMDView::updateStateAndPredict", device_id);
+				hmdView->updateStateAndPredict();
+			}
 		}
 	}
 }
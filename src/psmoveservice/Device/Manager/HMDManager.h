@@ -28,6 +28,7 @@ public:
 
     int version;
     int virtual_hmd_count;
+    int max_hmd_count; // hmd slots to allocate, at most PSMOVESERVICE_MAX_HMD_COUNT
 };
 
 class HMDManager : public DeviceTypeManager
@@ -40,11 +41,8 @@ public:
 
 	void updateStateAndPredict(TrackerManager* tracker_manager);
 
+    // Compile time ceiling, the slot count actually used is getMaxDevices()
     static const int k_max_devices = PSMOVESERVICE_MAX_HMD_COUNT;
-    int getMaxDevices() const override
-    {
-        return HMDManager::k_max_devices;
-    }
 
     ServerHMDViewPtr getHMDViewPtr(int device_id);
 
@@ -54,6 +52,15 @@ public:
     }
 
 protected:
+    int getConfiguredMaxDevices() const override
+    {
+        return cfg.max_hmd_count;
+    }
+    int getDeviceCountCeiling() const override
+    {
+        return HMDManager::k_max_devices;
+    }
+
     bool can_update_connected_devices() override;
     class DeviceEnumerator *allocate_device_enumerator() override;
     void free_device_enumerator(class DeviceEnumerator *) override;
@@ -0,0 +1,273 @@
+//-- includes -----
+#include "LEDBlinkCode.h"
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+
+//-- constants -----
+static const float k_bit_guard_fraction = 0.2f; // ignore frames this close to either end of a bit
+static const float k_min_track_gate_px = 24.f;
+static const float k_track_gate_radius_scale = 2.f; // a blob can move this many radii between frames
+static const float k_track_expiry_bits = 2.5f; // a bulb is only dark for one bit per cycle
+static const float k_max_slot_samples = 24.f; // older evidence is halved past this many frames per slot
+static const float k_min_slot_samples = 2.f;
+static const float k_min_dark_rate = 0.6f; // fraction of its own slot's frames the blob has to be missing
+static const float k_min_slot_contrast = 0.4f; // ... above the worst missing rate of the other slots
+
+//-- private methods -----
+static int positive_modulo(int value, int modulus)
+{
+    const int result = value % modulus;
+
+    return (result < 0) ? result + modulus : result;
+}
+
+static float milliseconds_since_epoch(
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &epoch,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &timestamp)
+{
+    const std::chrono::duration<float, std::milli> elapsed = timestamp - epoch;
+
+    return elapsed.count();
+}
+
+//-- LEDBlinkCodeTiming -----
+int
+LEDBlinkCodeTiming::computeCommandedDarkSlot(const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const
+{
+    assert(slot_count > 0 && bit_duration_ms > 0.f);
+    const float bits = milliseconds_since_epoch(epoch, now) / bit_duration_ms;
+
+    return positive_modulo(static_cast<int>(floorf(bits)), slot_count);
+}
+
+int
+LEDBlinkCodeTiming::computeObservedDarkSlot(const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp) const
+{
+    assert(slot_count > 0 && bit_duration_ms > 0.f);
+    const float bits = (milliseconds_since_epoch(epoch, frame_timestamp) - led_latency_ms) / bit_duration_ms;
+    const float bit_index = floorf(bits);
+    const float bit_phase = bits - bit_index;
+
+    if (bit_phase < k_bit_guard_fraction || bit_phase > 1.f - k_bit_guard_fraction)
+    {
+        return -1;
+    }
+
+    return positive_modulo(static_cast<int>(bit_index), slot_count);
+}
+
+//-- LEDBlinkCodeIdentifier -----
+LEDBlinkCodeIdentifier::LEDBlinkCodeIdentifier()
+{
+    reset();
+}
+
+void
+LEDBlinkCodeIdentifier::reset()
+{
+    m_tracks.clear();
+}
+
+void
+LEDBlinkCodeIdentifier::addFrame(
+    const LEDBlinkCodeTiming &timing,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp,
+    const LEDBlinkCodeBlob *blobs,
+    const int blob_count,
+    int *out_blob_slots)
+{
+    assert(timing.slot_count > 0 && timing.slot_count <= LED_BLINK_CODE_MAX_SLOTS);
+    const int observed_slot = timing.computeObservedDarkSlot(frame_timestamp);
+
+    // Pair blobs with tracks, closest pairs first
+    m_blob_track_indices.assign(blob_count, -1);
+    m_track_matched.assign(m_tracks.size(), false);
+    for (;;)
+    {
+        int best_blob_index = -1;
+        int best_track_index = -1;
+        float best_distance = 0.f;
+
+        for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+        {
+            if (m_blob_track_indices[blob_index] != -1)
+            {
+                continue;
+            }
+
+            for (int track_index = 0; track_index < static_cast<int>(m_tracks.size()); ++track_index)
+            {
+                if (m_track_matched[track_index])
+                {
+                    continue;
+                }
+
+                const BlobTrack &track = m_tracks[track_index];
+                const float gate = std::max(k_min_track_gate_px, k_track_gate_radius_scale*track.radius);
+                const float distance = (blobs[blob_index].center - track.center).norm();
+
+                if (distance < gate && (best_blob_index == -1 || distance < best_distance))
+                {
+                    best_blob_index = blob_index;
+                    best_track_index = track_index;
+                    best_distance = distance;
+                }
+            }
+        }
+
+        if (best_blob_index == -1)
+        {
+            break;
+        }
+
+        m_blob_track_indices[best_blob_index] = best_track_index;
+        m_track_matched[best_track_index] = true;
+    }
+
+    // Record which tracks were seen during the bit being shown, drop the ones missing for too long
+    const float expiry_ms = k_track_expiry_bits*timing.bit_duration_ms;
+    for (int track_index = static_cast<int>(m_tracks.size()) - 1; track_index >= 0; --track_index)
+    {
+        BlobTrack &track = m_tracks[track_index];
+
+        if (m_track_matched[track_index])
+        {
+            if (observed_slot != -1)
+            {
+                track.present_counts[observed_slot] += 1.f;
+            }
+        }
+        else if (milliseconds_since_epoch(track.last_seen_timestamp, frame_timestamp) > expiry_ms)
+        {
+            m_tracks.erase(m_tracks.begin() + track_index);
+
+            for (int &blob_track_index : m_blob_track_indices)
+            {
+                assert(blob_track_index != track_index);
+                if (blob_track_index > track_index)
+                {
+                    --blob_track_index;
+                }
+            }
+        }
+        else if (observed_slot != -1)
+        {
+            track.absent_counts[observed_slot] += 1.f;
+        }
+    }
+
+    // Move the matched tracks along and start tracks for the new blobs
+    for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+    {
+        const LEDBlinkCodeBlob &blob = blobs[blob_index];
+
+        if (m_blob_track_indices[blob_index] == -1)
+        {
+            BlobTrack track;
+            track.slot = -1;
+            track.slot_contrast = 0.f;
+            for (int slot = 0; slot < LED_BLINK_CODE_MAX_SLOTS; ++slot)
+            {
+                track.present_counts[slot] = 0.f;
+                track.absent_counts[slot] = 0.f;
+            }
+            if (observed_slot != -1)
+            {
+                track.present_counts[observed_slot] = 1.f;
+            }
+
+            m_blob_track_indices[blob_index] = static_cast<int>(m_tracks.size());
+            m_tracks.push_back(track);
+        }
+
+        BlobTrack &track = m_tracks[m_blob_track_indices[blob_index]];
+        track.center = blob.center;
+        track.radius = blob.radius;
+        track.last_seen_timestamp = frame_timestamp;
+    }
+
+    // Update every track's slot, two tracks can't share one
+    for (BlobTrack &track : m_tracks)
+    {
+        identifyTrack(timing, track);
+    }
+    for (int track_index = 0; track_index < static_cast<int>(m_tracks.size()); ++track_index)
+    {
+        BlobTrack &track = m_tracks[track_index];
+
+        for (int other_index = track_index + 1; track.slot != -1 && other_index < static_cast<int>(m_tracks.size()); ++other_index)
+        {
+            BlobTrack &other_track = m_tracks[other_index];
+
+            if (other_track.slot == track.slot)
+            {
+                if (other_track.slot_contrast > track.slot_contrast)
+                {
+                    track.slot = -1;
+                }
+                else
+                {
+                    other_track.slot = -1;
+                }
+            }
+        }
+    }
+
+    for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+    {
+        out_blob_slots[blob_index] = m_tracks[m_blob_track_indices[blob_index]].slot;
+    }
+}
+
+void
+LEDBlinkCodeIdentifier::identifyTrack(const LEDBlinkCodeTiming &timing, BlobTrack &track) const
+{
+    float dark_rates[LED_BLINK_CODE_MAX_SLOTS];
+    bool bSampled[LED_BLINK_CODE_MAX_SLOTS];
+    int best_slot = -1;
+
+    for (int slot = 0; slot < timing.slot_count; ++slot)
+    {
+        float sample_count = track.present_counts[slot] + track.absent_counts[slot];
+
+        // Let old evidence fade so a blob that changes hands is re-identified
+        if (sample_count > k_max_slot_samples)
+        {
+            track.present_counts[slot] *= 0.5f;
+            track.absent_counts[slot] *= 0.5f;
+            sample_count *= 0.5f;
+        }
+
+        bSampled[slot] = sample_count >= k_min_slot_samples;
+        dark_rates[slot] = bSampled[slot] ? track.absent_counts[slot] / sample_count : 0.f;
+
+        if (bSampled[slot] && (best_slot == -1 || dark_rates[slot] > dark_rates[best_slot]))
+        {
+            best_slot = slot;
+        }
+    }
+
+    track.slot = -1;
+    track.slot_contrast = 0.f;
+
+    if (best_slot != -1 && dark_rates[best_slot] >= k_min_dark_rate)
+    {
+        float worst_other_rate = -1.f;
+
+        for (int slot = 0; slot < timing.slot_count; ++slot)
+        {
+            if (slot != best_slot && bSampled[slot])
+            {
+                worst_other_rate = std::max(worst_other_rate, dark_rates[slot]);
+            }
+        }
+
+        // Needs to have been seen lit in at least one other slot
+        if (worst_other_rate >= 0.f && dark_rates[best_slot] - worst_other_rate >= k_min_slot_contrast)
+        {
+            track.slot = best_slot;
+            track.slot_contrast = dark_rates[best_slot] - worst_other_rate;
+        }
+    }
+}
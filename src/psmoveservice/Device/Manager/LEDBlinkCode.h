@@ -0,0 +1,82 @@
+#ifndef LED_BLINK_CODE_H
+#define LED_BLINK_CODE_H
+
+//-- includes -----
+#include "MathEigen.h"
+#include <chrono>
+#include <vector>
+
+//-- constants -----
+// Most controllers that can share one tracking color
+#define LED_BLINK_CODE_MAX_SLOTS 8
+
+//-- definitions -----
+/// Clock of the blink codes that let several controllers share one tracking color.
+/// Time is cut into bits of bit_duration_ms. Every controller sharing a color owns one code slot
+/// and its bulb goes dark during that slot's bit of every slot_count bit cycle, so each code is a
+/// single dark bit per cycle and the bulbs stay lit (and trackable) the rest of the time.
+struct LEDBlinkCodeTiming
+{
+    std::chrono::time_point<std::chrono::high_resolution_clock> epoch;
+    int slot_count;
+    float bit_duration_ms;
+    float led_latency_ms; // from commanding the bulb to the camera seeing it change
+
+    // Slot whose bulb should be dark right now
+    int computeCommandedDarkSlot(const std::chrono::time_point<std::chrono::high_resolution_clock> &now) const;
+
+    // Slot whose bulb was dark while a frame with the given timestamp was exposed,
+    // -1 if the frame lands too close to a bit boundary to tell
+    int computeObservedDarkSlot(const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp) const;
+};
+
+struct LEDBlinkCodeBlob
+{
+    Eigen::Vector2f center; // pixels
+    float radius; // pixels
+};
+
+/// Follows the blobs of one tracking color on one tracker from frame to frame
+/// and works out which code slot each blob belongs to from the bits it goes missing in.
+class LEDBlinkCodeIdentifier
+{
+public:
+    LEDBlinkCodeIdentifier();
+
+    // Forget every blob (e.g. when the controllers sharing the color changed)
+    void reset();
+
+    // Feeds the blobs of the color found in one frame.
+    // out_blob_slots[i] is set to the code slot of blobs[i] or -1 if it isn't identified (yet).
+    void addFrame(
+        const LEDBlinkCodeTiming &timing,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp,
+        const LEDBlinkCodeBlob *blobs,
+        const int blob_count,
+        int *out_blob_slots);
+
+    inline int getTrackCount() const
+    {
+        return static_cast<int>(m_tracks.size());
+    }
+
+private:
+    struct BlobTrack
+    {
+        Eigen::Vector2f center;
+        float radius;
+        std::chrono::time_point<std::chrono::high_resolution_clock> last_seen_timestamp;
+        float present_counts[LED_BLINK_CODE_MAX_SLOTS]; // frames the blob was seen during each slot's dark bit
+        float absent_counts[LED_BLINK_CODE_MAX_SLOTS]; // frames it was missing
+        int slot;
+        float slot_contrast; // how much more often the blob goes missing in its slot than in any other
+    };
+
+    void identifyTrack(const LEDBlinkCodeTiming &timing, BlobTrack &track) const;
+
+    std::vector<BlobTrack> m_tracks;
+    std::vector<int> m_blob_track_indices; // scratch, per blob of the current frame
+    std::vector<bool> m_track_matched; // scratch, per track
+};
+
+#endif // LED_BLINK_CODE_H
@@ -0,0 +1,336 @@
+//-- includes -----
+#include "TrackerDriftEstimator.h"
+#include "TrackerManager.h"
+#include "MathAlignment.h"
+#include "MathUtility.h"
+#include "PSMoveProtocol.pb.h"
+#include "ServerLog.h"
+#include "ServerNetworkManager.h"
+#include "ServerStatistics.h"
+#include "ServerTrackerView.h"
+
+//-- constants -----
+static const int k_max_drift_samples = 200; // per tracker, ~20 seconds of waving at the sample rate below
+static const int k_min_drift_samples = 100;
+static const float k_min_drift_sample_interval_milli = 100.f; // neighbouring frames add little but cost
+static const float k_drift_check_interval_milli = 2000.f;
+static const float k_max_reference_ray_distance_cm = 3.f; // the other trackers have to agree on the bulb
+static const float k_min_drift_improvement_ratio = 0.5f; // the correction has to halve the residual
+static const int k_min_consecutive_drift_detections = 2;
+static const float k_drift_correction_step = 0.5f; // fraction of the correction applied per detection
+static const float k_drift_notification_interval_milli = 60000.f; // while only reporting the drift
+static const int k_drift_solve_max_iterations = 10;
+
+//-- prototypes -----
+static EigenBundleAdjustmentCamera make_tracker_camera(const ServerTrackerView *tracker);
+
+//-- public methods -----
+TrackerDriftEstimator::TrackerDriftEstimator()
+{
+    reset();
+}
+
+void
+TrackerDriftEstimator::reset()
+{
+    for (int tracker_id = 0; tracker_id < PSMOVESERVICE_MAX_TRACKER_COUNT; ++tracker_id)
+    {
+        TrackerDriftState &state = m_trackers[tracker_id];
+
+        state.samples.clear();
+        state.next_sample_index = 0;
+        state.consecutive_detections = 0;
+        state.last_sample_time = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        state.bHasLastNotification = false;
+    }
+
+    m_last_check_time = std::chrono::high_resolution_clock::now();
+}
+
+void
+TrackerDriftEstimator::addSample(
+    const TrackerManager *tracker_manager,
+    const int *tracker_ids,
+    const CommonDevicePosition *tracker_relative_positions_cm,
+    int tracker_count)
+{
+    if (tracker_count < 3)
+    {
+        return;
+    }
+
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+
+    // World space viewing ray of the bulb from every tracker
+    EigenBundleAdjustmentCamera cameras[PSMOVESERVICE_MAX_TRACKER_COUNT];
+    Eigen::Vector3f ray_directions[PSMOVESERVICE_MAX_TRACKER_COUNT];
+    for (int list_index = 0; list_index < tracker_count; ++list_index)
+    {
+        const CommonDevicePosition &position = tracker_relative_positions_cm[list_index];
+
+        if (position.z <= k_real_epsilon)
+        {
+            return;
+        }
+
+        cameras[list_index] = make_tracker_camera(tracker_manager->getTrackerViewPtr(tracker_ids[list_index]).get());
+        ray_directions[list_index] =
+            cameras[list_index].orientation * Eigen::Vector3f(position.x, position.y, position.z).normalized();
+    }
+
+    for (int list_index = 0; list_index < tracker_count; ++list_index)
+    {
+        TrackerDriftState &state = m_trackers[tracker_ids[list_index]];
+        const std::chrono::duration<float, std::milli> time_since_last_sample = now - state.last_sample_time;
+
+        if (time_since_last_sample.count() < k_min_drift_sample_interval_milli)
+        {
+            continue;
+        }
+
+        // Where the other trackers put the bulb: the point closest to all of their rays
+        Eigen::Matrix3f A = Eigen::Matrix3f::Zero();
+        Eigen::Vector3f b = Eigen::Vector3f::Zero();
+        for (int other_index = 0; other_index < tracker_count; ++other_index)
+        {
+            if (other_index != list_index)
+            {
+                const Eigen::Vector3f &d = ray_directions[other_index];
+                const Eigen::Matrix3f P = Eigen::Matrix3f::Identity() - d * d.transpose();
+
+                A += P;
+                b += P * cameras[other_index].position;
+            }
+        }
+
+        bool bInvertible = false;
+        Eigen::Matrix3f A_inverse;
+        A.computeInverseWithCheck(A_inverse, bInvertible, 1e-6f);
+        if (!bInvertible)
+        {
+            continue;
+        }
+
+        const Eigen::Vector3f reference_position = A_inverse * b;
+
+        // Skip frames where the other trackers disagree (bad fits, partial occlusion)
+        bool bConsistent = true;
+        for (int other_index = 0; bConsistent && other_index < tracker_count; ++other_index)
+        {
+            if (other_index != list_index)
+            {
+                const Eigen::Vector3f offset = reference_position - cameras[other_index].position;
+                const Eigen::Vector3f &d = ray_directions[other_index];
+
+                bConsistent = (offset - d * d.dot(offset)).norm() <= k_max_reference_ray_distance_cm;
+            }
+        }
+
+        if (!bConsistent)
+        {
+            continue;
+        }
+
+        const EigenBundleAdjustmentCamera &camera = cameras[list_index];
+        const CommonDevicePosition &position = tracker_relative_positions_cm[list_index];
+        DriftSample sample;
+        sample.reference_position_cm = reference_position;
+        sample.pixel = Eigen::Vector2f(
+            camera.principal_x + camera.focal_length_x * position.x / position.z,
+            camera.principal_y - camera.focal_length_y * position.y / position.z);
+
+        if (static_cast<int>(state.samples.size()) < k_max_drift_samples)
+        {
+            state.samples.push_back(sample);
+        }
+        else
+        {
+            state.samples[state.next_sample_index] = sample;
+        }
+        state.next_sample_index = (state.next_sample_index + 1) % k_max_drift_samples;
+        state.last_sample_time = now;
+    }
+}
+
+void
+TrackerDriftEstimator::update(TrackerManager *tracker_manager)
+{
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<float, std::milli> time_since_last_check = now - m_last_check_time;
+
+    if (time_since_last_check.count() < k_drift_check_interval_milli)
+    {
+        return;
+    }
+    m_last_check_time = now;
+
+    StatScopedTimer stat_timer(_stat_stage_tracker_drift_check, -1);
+    const TrackerManagerConfig &cfg = tracker_manager->getConfig();
+
+    // Find the tracker that a pose correction helps the most.
+    // Only one tracker is corrected at a time: a drifted tracker also skews the reference
+    // positions of the trackers it helps triangulate, but far less than its own.
+    int drifted_tracker_id = -1;
+    float best_improvement_px = 0.f;
+    float drifted_initial_rms_px = 0.f;
+    float drifted_final_rms_px = 0.f;
+    EigenBundleAdjustmentCamera drifted_camera;
+
+    for (int tracker_id : tracker_manager->getOpenDeviceIds())
+    {
+        ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
+        const TrackerDriftState &state = m_trackers[tracker_id];
+
+        if (!tracker->getIsOpen() || static_cast<int>(state.samples.size()) < k_min_drift_samples)
+        {
+            continue;
+        }
+
+        std::vector<Eigen::Vector3f> reference_positions(state.samples.size());
+        std::vector<Eigen::Vector2f> pixels(state.samples.size());
+        for (size_t sample_index = 0; sample_index < state.samples.size(); ++sample_index)
+        {
+            reference_positions[sample_index] = state.samples[sample_index].reference_position_cm;
+            pixels[sample_index] = state.samples[sample_index].pixel;
+        }
+
+        EigenBundleAdjustmentCamera camera = make_tracker_camera(tracker.get());
+        float initial_rms_px, final_rms_px;
+        if (eigen_alignment_refine_camera_pose(
+                &camera,
+                reference_positions.data(), pixels.data(), static_cast<int>(pixels.size()),
+                k_drift_solve_max_iterations,
+                &initial_rms_px, &final_rms_px) &&
+            initial_rms_px > cfg.drift_detection_threshold_px &&
+            final_rms_px < initial_rms_px * k_min_drift_improvement_ratio &&
+            initial_rms_px - final_rms_px > best_improvement_px)
+        {
+            drifted_tracker_id = tracker_id;
+            best_improvement_px = initial_rms_px - final_rms_px;
+            drifted_initial_rms_px = initial_rms_px;
+            drifted_final_rms_px = final_rms_px;
+            drifted_camera = camera;
+        }
+    }
+
+    for (int tracker_id = 0; tracker_id < PSMOVESERVICE_MAX_TRACKER_COUNT; ++tracker_id)
+    {
+        if (tracker_id != drifted_tracker_id)
+        {
+            m_trackers[tracker_id].consecutive_detections = 0;
+        }
+    }
+
+    if (drifted_tracker_id == -1)
+    {
+        return;
+    }
+
+    // Wait for the drift to show up in more than one check before acting on it
+    TrackerDriftState &drifted_state = m_trackers[drifted_tracker_id];
+    ++drifted_state.consecutive_detections;
+    if (drifted_state.consecutive_detections < k_min_consecutive_drift_detections)
+    {
+        return;
+    }
+
+    ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(drifted_tracker_id);
+    const EigenBundleAdjustmentCamera current_camera = make_tracker_camera(tracker.get());
+    const float correction_degrees = current_camera.orientation.angularDistance(drifted_camera.orientation) * k_radians_to_degreees;
+    const float correction_cm = (drifted_camera.position - current_camera.position).norm();
+
+    if (cfg.apply_drift_correction)
+    {
+        // Move part of the way there, the next detection (on fresh samples) finishes the job
+        const Eigen::Quaternionf orientation =
+            current_camera.orientation.slerp(k_drift_correction_step, drifted_camera.orientation).normalized();
+        const Eigen::Vector3f position =
+            current_camera.position + (drifted_camera.position - current_camera.position) * k_drift_correction_step;
+
+        CommonDevicePose pose;
+        pose.Orientation.w = orientation.w();
+        pose.Orientation.x = orientation.x();
+        pose.Orientation.y = orientation.y();
+        pose.Orientation.z = orientation.z();
+        pose.PositionCm.set(position.x(), position.y(), position.z());
+        tracker->setTrackerPose(&pose);
+
+        SERVER_LOG_INFO("TrackerDriftEstimator::update") <<
+            "Tracker " << drifted_tracker_id << " drifted by " << correction_degrees << " deg, " << correction_cm <<
+            " cm (reprojection error " << drifted_initial_rms_px << "px -> " << drifted_final_rms_px << "px), correcting";
+
+        // Every stored reference position depends on the old pose
+        clearSamples();
+        sendDriftNotification(
+            drifted_tracker_id, drifted_initial_rms_px, drifted_final_rms_px, correction_degrees, correction_cm, true);
+    }
+    else
+    {
+        const std::chrono::duration<float, std::milli> time_since_notification = now - drifted_state.last_notification_time;
+
+        if (!drifted_state.bHasLastNotification || time_since_notification.count() >= k_drift_notification_interval_milli)
+        {
+            SERVER_LOG_WARNING("TrackerDriftEstimator::update") <<
+                "Tracker " << drifted_tracker_id << " appears to have moved by " << correction_degrees << " deg, " << correction_cm <<
+                " cm (reprojection error " << drifted_initial_rms_px << "px -> " << drifted_final_rms_px << "px)";
+
+            drifted_state.last_notification_time = now;
+            drifted_state.bHasLastNotification = true;
+            sendDriftNotification(
+                drifted_tracker_id, drifted_initial_rms_px, drifted_final_rms_px, correction_degrees, correction_cm, false);
+        }
+    }
+}
+
+//-- private methods -----
+void
+TrackerDriftEstimator::clearSamples()
+{
+    for (int tracker_id = 0; tracker_id < PSMOVESERVICE_MAX_TRACKER_COUNT; ++tracker_id)
+    {
+        m_trackers[tracker_id].samples.clear();
+        m_trackers[tracker_id].next_sample_index = 0;
+        m_trackers[tracker_id].consecutive_detections = 0;
+    }
+}
+
+void
+TrackerDriftEstimator::sendDriftNotification(
+    int tracker_id, float initial_rms_px, float final_rms_px,
+    float correction_degrees, float correction_cm, bool bApplied)
+{
+    if (ServerNetworkManager::get_instance() != nullptr)
+    {
+        ResponsePtr response(new PSMoveProtocol::Response);
+        response->set_type(PSMoveProtocol::Response_ResponseType_TRACKER_POSE_DRIFTED);
+        response->set_request_id(-1);
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+
+        PSMoveProtocol::Response_ResultTrackerPoseDrifted *drift = response->mutable_result_tracker_pose_drifted();
+        drift->set_tracker_id(tracker_id);
+        drift->set_initial_rms_px(initial_rms_px);
+        drift->set_final_rms_px(final_rms_px);
+        drift->set_correction_degrees(correction_degrees);
+        drift->set_correction_cm(correction_cm);
+        drift->set_applied(bApplied);
+
+        ServerNetworkManager::get_instance()->send_notification_to_all_clients(response);
+    }
+}
+
+static EigenBundleAdjustmentCamera make_tracker_camera(const ServerTrackerView *tracker)
+{
+    const CommonDevicePose pose = tracker->getTrackerPose();
+    float distortion_k1, distortion_k2, distortion_k3, distortion_p1, distortion_p2;
+    EigenBundleAdjustmentCamera camera;
+
+    camera.orientation = Eigen::Quaternionf(pose.Orientation.w, pose.Orientation.x, pose.Orientation.y, pose.Orientation.z);
+    camera.position = Eigen::Vector3f(pose.PositionCm.x, pose.PositionCm.y, pose.PositionCm.z);
+    tracker->getCameraIntrinsics(
+        camera.focal_length_x, camera.focal_length_y,
+        camera.principal_x, camera.principal_y,
+        distortion_k1, distortion_k2, distortion_k3,
+        distortion_p1, distortion_p2);
+
+    return camera;
+}
@@ -0,0 +1,64 @@
+#ifndef TRACKER_DRIFT_ESTIMATOR_H
+#define TRACKER_DRIFT_ESTIMATOR_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+#include "PSMoveProtocolInterface.h"
+#include "MathEigen.h"
+#include <chrono>
+#include <vector>
+
+//-- pre-declarations -----
+class TrackerManager;
+
+//-- definitions -----
+/// Watches for trackers that get bumped during a session.
+/// Every bulb sighting by a tracker is paired with where the other trackers put the bulb.
+/// When one tracker's sightings systematically disagree with the rest, a small pose correction
+/// is solved against those reference positions, then either applied a step at a time or
+/// only reported to the clients.
+class TrackerDriftEstimator
+{
+public:
+    TrackerDriftEstimator();
+
+    void reset();
+
+    // Called once per controller update with the trackers that fit the bulb on a new frame.
+    // Needs at least three trackers so that every tracker has two others to check it against.
+    void addSample(
+        const TrackerManager *tracker_manager,
+        const int *tracker_ids,
+        const CommonDevicePosition *tracker_relative_positions_cm,
+        int tracker_count);
+
+    // Rate limited drift check, cheap to call every tracker manager poll
+    void update(TrackerManager *tracker_manager);
+
+private:
+    struct DriftSample
+    {
+        Eigen::Vector3f reference_position_cm; // where the other trackers put the bulb (world space)
+        Eigen::Vector2f pixel; // where this tracker saw it (undistorted)
+    };
+
+    struct TrackerDriftState
+    {
+        std::vector<DriftSample> samples; // ring buffer
+        int next_sample_index;
+        int consecutive_detections;
+        std::chrono::time_point<std::chrono::high_resolution_clock> last_sample_time;
+        std::chrono::time_point<std::chrono::high_resolution_clock> last_notification_time;
+        bool bHasLastNotification;
+    };
+
+    void clearSamples();
+    void sendDriftNotification(
+        int tracker_id, float initial_rms_px, float final_rms_px,
+        float correction_degrees, float correction_cm, bool bApplied);
+
+    TrackerDriftState m_trackers[PSMOVESERVICE_MAX_TRACKER_COUNT];
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_last_check_time;
+};
+
+#endif // TRACKER_DRIFT_ESTIMATOR_H
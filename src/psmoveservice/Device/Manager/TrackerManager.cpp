@@ -5,14 +5,25 @@
 #include "DeviceManager.h"
 #include "HMDManager.h"
 #include "ServerLog.h"
+#include "ServerTrace.h"
 #include "ServerControllerView.h"
 #include "ServerHMDView.h"
 #include "ServerTrackerView.h"
 #include "ServerDeviceView.h"
+#include "MathAlignment.h"
 #include "MathUtility.h"
 #include "PSMoveProtocol.pb.h"
+#include "RemoteTrackerLink.h"
+
+#include <algorithm>
 
 //-- constants -----
+static const int k_max_bundle_adjustment_samples = 3000;
+static const float k_bundle_adjustment_min_sample_spacing_cm = 2.f; // skip samples while the bulb holds still
+static const int k_bundle_adjustment_max_iterations = 50;
+static const int k_default_max_tracker_count = 8; // slot count before it became configurable
+static const int k_min_led_blink_code_slot_count = 2;
+static const int k_default_remote_tracker_port = 9514; // next to the client connection port
 
 //-- Tracker Manager Config -----
 const int TrackerManagerConfig::CONFIG_VERSION = 2;
@@ -26,9 +37,31 @@ TrackerManagerConfig::TrackerManagerConfig(const std::string &fnamebase)
     optical_tracking_timeout= 100;
 	tracker_sleep_ms = 1;
 	use_bgr_to_hsv_lookup_table = true;
+	use_rle_blob_extractor = false;
+	use_sphere_edge_refinement = false;
+	sphere_edge_refinement_ray_count = 32;
+	sphere_edge_refinement_search_px = 3.f;
 	exclude_opposed_cameras = false;
 	min_valid_projection_area= 16;
 	disable_roi = false;
+	use_adaptive_roi = false;
+	use_global_blob_assignment = false;
+	max_tracker_count = k_default_max_tracker_count;
+	virtual_tracker_count = 0;
+	remote_tracker_count = 0;
+	remote_tracker_transport = "udp";
+	remote_tracker_port = k_default_remote_tracker_port;
+	tracker_node_mode = false;
+	tracker_node_fusion_host = "127.0.0.1";
+	tracker_node_camera_id_base = 0;
+	tracker_node_max_blobs_per_color = 4;
+	use_drift_detection = true;
+	apply_drift_correction = false;
+	drift_detection_threshold_px = 2.f;
+	use_led_blink_codes = false;
+	led_blink_code_slot_count = 4;
+	led_blink_code_bit_ms = 250.f; // PSMove LED writes go out at most every 120ms
+	led_blink_code_latency_ms = 70.f;
 	default_tracker_profile.frame_width = 640;
 	//default_tracker_profile.frame_height = 480;
 	default_tracker_profile.frame_rate = 40;
@@ -53,6 +86,10 @@ TrackerManagerConfig::config2ptree()
 	pt.put("ignore_pose_from_one_tracker", ignore_pose_from_one_tracker);
     pt.put("optical_tracking_timeout", optical_tracking_timeout);
 	pt.put("use_bgr_to_hsv_lookup_table", use_bgr_to_hsv_lookup_table);
+	pt.put("use_rle_blob_extractor", use_rle_blob_extractor);
+	pt.put("use_sphere_edge_refinement", use_sphere_edge_refinement);
+	pt.put("sphere_edge_refinement_ray_count", sphere_edge_refinement_ray_count);
+	pt.put("sphere_edge_refinement_search_px", sphere_edge_refinement_search_px);
 	pt.put("tracker_sleep_ms", tracker_sleep_ms);
 
 	pt.put("excluded_opposed_cameras", exclude_opposed_cameras);	
@@ -60,6 +97,28 @@ TrackerManagerConfig::config2ptree()
 	pt.put("min_valid_projection_area", min_valid_projection_area);	
 
 	pt.put("disable_roi", disable_roi);
+	pt.put("use_adaptive_roi", use_adaptive_roi);
+	pt.put("use_global_blob_assignment", use_global_blob_assignment);
+
+	pt.put("max_tracker_count", max_tracker_count);
+	pt.put("virtual_tracker_count", virtual_tracker_count);
+
+	pt.put("remote_tracker_count", remote_tracker_count);
+	pt.put("remote_tracker_transport", remote_tracker_transport);
+	pt.put("remote_tracker_port", remote_tracker_port);
+	pt.put("tracker_node_mode", tracker_node_mode);
+	pt.put("tracker_node_fusion_host", tracker_node_fusion_host);
+	pt.put("tracker_node_camera_id_base", tracker_node_camera_id_base);
+	pt.put("tracker_node_max_blobs_per_color", tracker_node_max_blobs_per_color);
+
+	pt.put("use_drift_detection", use_drift_detection);
+	pt.put("apply_drift_correction", apply_drift_correction);
+	pt.put("drift_detection_threshold_px", drift_detection_threshold_px);
+
+	pt.put("use_led_blink_codes", use_led_blink_codes);
+	pt.put("led_blink_code_slot_count", led_blink_code_slot_count);
+	pt.put("led_blink_code_bit_ms", led_blink_code_bit_ms);
+	pt.put("led_blink_code_latency_ms", led_blink_code_latency_ms);
 
 	pt.put("default_tracker_profile.frame_width", default_tracker_profile.frame_width);
 	//pt.put("default_tracker_profile.frame_height", default_tracker_profile.frame_height);
@@ -85,10 +144,32 @@ TrackerManagerConfig::ptree2config(const boost::property_tree::ptree &pt)
 		ignore_pose_from_one_tracker = pt.get<bool>("ignore_pose_from_one_tracker", ignore_pose_from_one_tracker);
         optical_tracking_timeout= pt.get<int>("optical_tracking_timeout", optical_tracking_timeout);
 		use_bgr_to_hsv_lookup_table = pt.get<bool>("use_bgr_to_hsv_lookup_table", use_bgr_to_hsv_lookup_table);
+		use_rle_blob_extractor = pt.get<bool>("use_rle_blob_extractor", use_rle_blob_extractor);
+		use_sphere_edge_refinement = pt.get<bool>("use_sphere_edge_refinement", use_sphere_edge_refinement);
+		sphere_edge_refinement_ray_count = pt.get<int>("sphere_edge_refinement_ray_count", sphere_edge_refinement_ray_count);
+		sphere_edge_refinement_search_px = pt.get<float>("sphere_edge_refinement_search_px", sphere_edge_refinement_search_px);
 		tracker_sleep_ms = pt.get<int>("tracker_sleep_ms", tracker_sleep_ms);
 		exclude_opposed_cameras = pt.get<bool>("excluded_opposed_cameras", exclude_opposed_cameras);
 		min_valid_projection_area = pt.get<float>("min_valid_projection_area", min_valid_projection_area);	
 		disable_roi = pt.get<bool>("disable_roi", disable_roi);
+		use_adaptive_roi = pt.get<bool>("use_adaptive_roi", use_adaptive_roi);
+		use_global_blob_assignment = pt.get<bool>("use_global_blob_assignment", use_global_blob_assignment);
+		max_tracker_count = pt.get<int>("max_tracker_count", max_tracker_count);
+		virtual_tracker_count = pt.get<int>("virtual_tracker_count", virtual_tracker_count);
+		remote_tracker_count = pt.get<int>("remote_tracker_count", remote_tracker_count);
+		remote_tracker_transport = pt.get<std::string>("remote_tracker_transport", remote_tracker_transport);
+		remote_tracker_port = pt.get<int>("remote_tracker_port", remote_tracker_port);
+		tracker_node_mode = pt.get<bool>("tracker_node_mode", tracker_node_mode);
+		tracker_node_fusion_host = pt.get<std::string>("tracker_node_fusion_host", tracker_node_fusion_host);
+		tracker_node_camera_id_base = pt.get<int>("tracker_node_camera_id_base", tracker_node_camera_id_base);
+		tracker_node_max_blobs_per_color = pt.get<int>("tracker_node_max_blobs_per_color", tracker_node_max_blobs_per_color);
+		use_drift_detection = pt.get<bool>("use_drift_detection", use_drift_detection);
+		apply_drift_correction = pt.get<bool>("apply_drift_correction", apply_drift_correction);
+		drift_detection_threshold_px = pt.get<float>("drift_detection_threshold_px", drift_detection_threshold_px);
+		use_led_blink_codes = pt.get<bool>("use_led_blink_codes", use_led_blink_codes);
+		led_blink_code_slot_count = pt.get<int>("led_blink_code_slot_count", led_blink_code_slot_count);
+		led_blink_code_bit_ms = pt.get<float>("led_blink_code_bit_ms", led_blink_code_bit_ms);
+		led_blink_code_latency_ms = pt.get<float>("led_blink_code_latency_ms", led_blink_code_latency_ms);
 		default_tracker_profile.frame_width = pt.get<float>("default_tracker_profile.frame_width", 640);
 		//default_tracker_profile.frame_height = pt.get<float>("default_tracker_profile.frame_height", 480);
 		default_tracker_profile.frame_rate = pt.get<float>("default_tracker_profile.frame_rate", 40);
@@ -147,21 +228,59 @@ TrackerManagerConfig::get_global_down_axis() const
 TrackerManager::TrackerManager()
     : DeviceTypeManager(10000, 13)
     , m_tracker_list_dirty(false)
+    , m_full_frame_scan_tracker_id(-1)
+    , m_bundle_adjustment_controller_id(-1)
+    , m_bundle_adjustment_sample_count(0)
 {
+    for (int tracker_id = 0; tracker_id < k_max_devices; ++tracker_id)
+    {
+        m_bundle_adjustment_last_positions[tracker_id].clear();
+        m_bundle_adjustment_has_last_position[tracker_id] = false;
+    }
+
+    for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+    {
+        m_blink_code_generations[color_index] = 0;
+    }
+    for (int controller_id = 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+    {
+        m_blink_code_slots[controller_id] = -1;
+    }
 }
 
 bool 
 TrackerManager::startup()
 {
+    // Load any config from disk (before the base class allocates the configured device slots)
+    cfg.load();
+
+    // Save back out the config in case there were updated defaults
+    cfg.save();
+
     bool bSuccess = DeviceTypeManager::startup();
 
     if (bSuccess)
     {
-		// Load any config from disk
-		cfg.load();
-
-        // Save back out the config in case there were updated defaults
-        cfg.save();
+        // Copy the virtual tracker count into the tracker enumerator's static variable.
+        // This breaks the dependency between the Tracker Manager and the enumerator.
+        TrackerDeviceEnumerator::virtual_tracker_count= cfg.virtual_tracker_count;
+        TrackerDeviceEnumerator::remote_tracker_count= cfg.remote_tracker_count;
+
+        // Tracker nodes send over the same link the remote trackers listen on
+        RemoteTrackerLinkSettings link_settings;
+        link_settings.transport= cfg.remote_tracker_transport;
+        link_settings.fusion_host= cfg.tracker_node_fusion_host;
+        link_settings.port= cfg.remote_tracker_port;
+        link_settings.bSend= cfg.tracker_node_mode;
+        link_settings.bReceive= cfg.remote_tracker_count > 0;
+        RemoteTrackerLink::getInstance()->startup(link_settings);
+
+        // The blink code clock starts now, every tracker frame is matched against it
+        m_blink_code_timing.epoch = std::chrono::high_resolution_clock::now();
+        m_blink_code_timing.slot_count =
+            std::max(std::min(cfg.led_blink_code_slot_count, LED_BLINK_CODE_MAX_SLOTS), k_min_led_blink_code_slot_count);
+        m_blink_code_timing.bit_duration_ms = std::max(cfg.led_blink_code_bit_ms, 1.f);
+        m_blink_code_timing.led_latency_ms = cfg.led_blink_code_latency_ms;
 
         // Refresh the tracker list
         mark_tracker_list_dirty();
@@ -176,10 +295,36 @@ TrackerManager::startup()
     return bSuccess;
 }
 
+void
+TrackerManager::shutdown()
+{
+    DeviceTypeManager::shutdown();
+
+    RemoteTrackerLink::getInstance()->shutdown();
+}
+
+void
+TrackerManager::publish()
+{
+    // Every controller and HMD has looked at the slot holder's new frame by now
+    // (publishing clears the new frame flag, so check first)
+    if (m_full_frame_scan_tracker_id != -1)
+    {
+        ServerTrackerViewPtr tracker_view = getTrackerViewPtr(m_full_frame_scan_tracker_id);
+
+        if (tracker_view->getIsOpen() && tracker_view->getHasUnpublishedState())
+        {
+            advanceFullFrameScanSlot();
+        }
+    }
+
+    DeviceTypeManager::publish();
+}
+
 void
 TrackerManager::closeAllTrackers()
 {
-    for (int tracker_id = 0; tracker_id < k_max_devices; ++tracker_id)
+    for (int tracker_id : getOpenDeviceIds())
     {
         ServerTrackerViewPtr tracker_view = getTrackerViewPtr(tracker_id);
 
@@ -188,6 +333,7 @@ TrackerManager::closeAllTrackers()
             tracker_view->close();
         }
     }
+    rebuild_open_device_list();
 
     // Refresh the tracker list once we're allowed to
     mark_tracker_list_dirty();
@@ -196,6 +342,88 @@ TrackerManager::closeAllTrackers()
     send_device_list_changed_notification();
 }
 
+void
+TrackerManager::poll_devices()
+{
+    DeviceTypeManager::poll_devices();
+
+    // Don't leave the full frame scan slot with a tracker that went away (or nobody at all)
+    if (m_full_frame_scan_tracker_id == -1 || !getTrackerViewPtr(m_full_frame_scan_tracker_id)->getIsOpen())
+    {
+        advanceFullFrameScanSlot();
+    }
+
+    if (cfg.tracker_node_mode)
+    {
+        sendTrackerNodeFrames();
+    }
+
+    if (cfg.use_led_blink_codes)
+    {
+        updateLEDBlinkCodes();
+    }
+
+    if (cfg.use_drift_detection)
+    {
+        m_drift_estimator.update(this);
+    }
+
+    m_color_calibrator.update(this);
+}
+
+void
+TrackerManager::advanceFullFrameScanSlot()
+{
+    // Pass the full frame scan slot on to the next open tracker
+    // (the open id list is ascending, so wrap around to its front past the last one)
+    const std::vector<int> &open_tracker_ids = getOpenDeviceIds();
+    int next_tracker_id = open_tracker_ids.empty() ? -1 : open_tracker_ids.front();
+    for (int tracker_id : open_tracker_ids)
+    {
+        if (tracker_id > m_full_frame_scan_tracker_id)
+        {
+            next_tracker_id = tracker_id;
+            break;
+        }
+    }
+    m_full_frame_scan_tracker_id = next_tracker_id;
+}
+
+void
+TrackerManager::sendTrackerNodeFrames()
+{
+    SERVER_TRACE_SCOPE("TrackerManager::sendTrackerNodeFrames");
+
+    for (int tracker_id : getOpenDeviceIds())
+    {
+        ServerTrackerViewPtr tracker = getTrackerViewPtr(tracker_id);
+
+        // Remote trackers show frames that came from a node already
+        if (tracker->getIsOpen() && 
+            tracker->getHasUnpublishedState() &&
+            tracker->getTrackerDeviceType() != CommonDeviceState::RemoteTracker)
+        {
+            tracker->sendBlobObservations(
+                cfg.tracker_node_camera_id_base + tracker_id, 
+                std::max(cfg.tracker_node_max_blobs_per_color, 1));
+        }
+    }
+}
+
+void
+TrackerManager::assignControllerBlobs()
+{
+    for (int tracker_id : getOpenDeviceIds())
+    {
+        ServerTrackerViewPtr tracker = getTrackerViewPtr(tracker_id);
+
+        if (tracker->getIsOpen() && tracker->getHasUnpublishedState())
+        {
+            tracker->computeControllerBlobAssignment();
+        }
+    }
+}
+
 bool
 TrackerManager::can_update_connected_devices()
 {
@@ -242,9 +470,56 @@ int TrackerManager::getListUpdatedResponseType()
 	return PSMoveProtocol::Response_ResponseType_TRACKER_LIST_UPDATED;
 }
 
+void
+TrackerManager::handle_device_closed(int device_id)
+{
+    // Controllers and HMDs only update the estimates of open trackers,
+    // so the last one from a tracker that closed would otherwise look current forever
+    ControllerManager *controllerManager= DeviceManager::getInstance()->m_controller_manager;
+    for (int controller_id = 0; controller_id < controllerManager->getMaxDevices(); ++controller_id)
+    {
+        controllerManager->getControllerViewPtr(controller_id)->clearTrackerPoseEstimate(device_id);
+    }
+
+    HMDManager *hmdManager= DeviceManager::getInstance()->m_hmd_manager;
+    for (int hmd_id = 0; hmd_id < hmdManager->getMaxDevices(); ++hmd_id)
+    {
+        hmdManager->getHMDViewPtr(hmd_id)->clearTrackerPoseEstimate(device_id);
+    }
+}
+
 eCommonTrackingColorID 
-TrackerManager::allocateTrackingColorID()
+TrackerManager::allocateTrackingColorID(bool bAllowSharedColor)
 {
+    if (m_available_color_ids.empty() && bAllowSharedColor && cfg.use_led_blink_codes)
+    {
+        // Every color is taken, double up on the color with the fewest controllers
+        eCommonTrackingColorID shared_color = eCommonTrackingColorID::INVALID_COLOR;
+        int shared_color_user_count = 0;
+
+        for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+        {
+            const eCommonTrackingColorID color_id = static_cast<eCommonTrackingColorID>(color_index);
+            const int user_count = countControllersUsingTrackingColorID(color_id, nullptr);
+
+            if (user_count > 0 && user_count < m_blink_code_timing.slot_count &&
+                !getIsTrackingColorIDUsedByHMD(color_id) &&
+                (shared_color == eCommonTrackingColorID::INVALID_COLOR || user_count < shared_color_user_count))
+            {
+                shared_color = color_id;
+                shared_color_user_count = user_count;
+            }
+        }
+
+        if (shared_color == eCommonTrackingColorID::INVALID_COLOR)
+        {
+            SERVER_LOG_WARNING("TrackerManager::allocateTrackingColorID") <<
+                "Every tracking color is shared by " << m_blink_code_timing.slot_count << " controllers already";
+        }
+
+        return shared_color;
+    }
+
     assert(m_available_color_ids.size() > 0);
     eCommonTrackingColorID tracking_color = m_available_color_ids.front();
 
@@ -259,6 +534,17 @@ TrackerManager::claimTrackingColorID(const ServerControllerView *claiming_contro
     bool bColorWasInUse = false;
     bool bSuccess= true;
 
+    // With blink codes a color other controllers have is shared with them rather than taken away
+    if (cfg.use_led_blink_codes)
+    {
+        const int user_count = countControllersUsingTrackingColorID(color_id, claiming_controller_view);
+
+        if (user_count > 0 && user_count < m_blink_code_timing.slot_count && !getIsTrackingColorIDUsedByHMD(color_id))
+        {
+            return true;
+        }
+    }
+
     // If any other controller has this tracking color, make them pick a new color (if possible)
     HMDManager *hmdManager= DeviceManager::getInstance()->m_hmd_manager;
     for (int device_id = 0; device_id < hmdManager->getMaxDevices(); ++device_id)
@@ -296,7 +582,7 @@ TrackerManager::claimTrackingColorID(const ServerControllerView *claiming_contro
             {
                 if (controller_view->getTrackingColorID() == color_id)
                 {
-                    controller_view->setTrackingColorID(allocateTrackingColorID());
+                    controller_view->setTrackingColorID(allocateTrackingColorID(true));
                     bColorWasInUse = true;
                     break;
                 }
@@ -355,6 +641,7 @@ TrackerManager::claimTrackingColorID(const ServerHMDView *claiming_hmd_view, eCo
     {
         // If any other controller has this tracking color, make them pick a new color
         ControllerManager *controllerManager= DeviceManager::getInstance()->m_controller_manager;
+        eCommonTrackingColorID newTrackingColor= eCommonTrackingColorID::INVALID_COLOR;
         for (int device_id = 0; device_id < controllerManager->getMaxDevices(); ++device_id)
         {
             ServerControllerViewPtr controller_view = controllerManager->getControllerViewPtr(device_id);
@@ -363,9 +650,27 @@ TrackerManager::claimTrackingColorID(const ServerHMDView *claiming_hmd_view, eCo
             {
                 if (controller_view->getTrackingColorID() == color_id)
                 {
-                    controller_view->setTrackingColorID(allocateTrackingColorID());
+                    // Controllers sharing the color by blink code move to the new color together
+                    if (newTrackingColor == eCommonTrackingColorID::INVALID_COLOR)
+                    {
+                        if (m_available_color_ids.empty())
+                        {
+                            SERVER_LOG_WARNING("TrackerManager::claimTrackingColorID") <<
+                                "No free tracking color to move the controllers sharing the HMD's color to";
+                            bSuccess= false;
+                            break;
+                        }
+
+                        newTrackingColor= allocateTrackingColorID();
+                    }
+
+                    controller_view->setTrackingColorID(newTrackingColor);
                     bColorWasInUse = true;
-                    break;
+
+                    if (!cfg.use_led_blink_codes)
+                    {
+                        break;
+                    }
                 }
             }
         }
@@ -388,8 +693,346 @@ TrackerManager::claimTrackingColorID(const ServerHMDView *claiming_hmd_view, eCo
 }
 
 void 
-TrackerManager::freeTrackingColorID(eCommonTrackingColorID color_id)
+TrackerManager::freeTrackingColorID(eCommonTrackingColorID color_id, const ServerControllerView *releasing_controller_view)
 {
+    if (cfg.use_led_blink_codes &&
+        (color_id == eCommonTrackingColorID::INVALID_COLOR ||
+         countControllersUsingTrackingColorID(color_id, releasing_controller_view) > 0))
+    {
+        // Still in use by the other controllers sharing it
+        return;
+    }
+
     assert(std::find(m_available_color_ids.begin(), m_available_color_ids.end(), color_id) == m_available_color_ids.end());
     m_available_color_ids.push_back(color_id);
 }
+
+void
+TrackerManager::updateLEDBlinkCodes()
+{
+    ControllerManager *controllerManager= DeviceManager::getInstance()->m_controller_manager;
+    const int slot_count = m_blink_code_timing.slot_count;
+    int group_sizes[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+    int group_members[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES][LED_BLINK_CODE_MAX_SLOTS];
+
+    // Group the tracked controllers by color, in controller id order
+    for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+    {
+        group_sizes[color_index] = 0;
+    }
+    for (int controller_id : controllerManager->getOpenDeviceIds())
+    {
+        ServerControllerViewPtr controller_view = controllerManager->getControllerViewPtr(controller_id);
+        const eCommonTrackingColorID color_id = controller_view->getTrackingColorID();
+
+        m_blink_code_slots[controller_id] = -1;
+
+        if (controller_view->getIsTrackingEnabled() &&
+            color_id != eCommonTrackingColorID::INVALID_COLOR &&
+            group_sizes[color_id] < slot_count)
+        {
+            group_members[color_id][group_sizes[color_id]++] = controller_id;
+        }
+    }
+
+    // Deal the code slots, a lone controller on a color keeps its bulb steady
+    for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+    {
+        std::vector<int> &group = m_blink_code_groups[color_index];
+        const int group_size = group_sizes[color_index] >= 2 ? group_sizes[color_index] : 0;
+
+        if (static_cast<int>(group.size()) != group_size ||
+            !std::equal(group.begin(), group.end(), group_members[color_index]))
+        {
+            group.assign(group_members[color_index], group_members[color_index] + group_size);
+            ++m_blink_code_generations[color_index];
+        }
+
+        for (int slot = 0; slot < group_size; ++slot)
+        {
+            m_blink_code_slots[group[slot]] = slot;
+        }
+    }
+
+    // Drive the bulbs from the code clock
+    const int dark_slot = m_blink_code_timing.computeCommandedDarkSlot(std::chrono::high_resolution_clock::now());
+    for (int controller_id : controllerManager->getOpenDeviceIds())
+    {
+        const int slot = m_blink_code_slots[controller_id];
+
+        controllerManager->getControllerViewPtr(controller_id)->setLEDBlinkDark(slot != -1 && slot == dark_slot);
+    }
+}
+
+int
+TrackerManager::countControllersUsingTrackingColorID(
+    eCommonTrackingColorID color_id,
+    const ServerControllerView *excluded_controller_view) const
+{
+    ControllerManager *controllerManager= DeviceManager::getInstance()->m_controller_manager;
+    int user_count = 0;
+
+    for (int controller_id : controllerManager->getOpenDeviceIds())
+    {
+        ServerControllerViewPtr controller_view = controllerManager->getControllerViewPtr(controller_id);
+
+        if (controller_view.get() != excluded_controller_view &&
+            controller_view->getIsOpen() &&
+            controller_view->getTrackingColorID() == color_id)
+        {
+            ++user_count;
+        }
+    }
+
+    return user_count;
+}
+
+bool
+TrackerManager::getIsTrackingColorIDUsedByHMD(eCommonTrackingColorID color_id) const
+{
+    HMDManager *hmdManager= DeviceManager::getInstance()->m_hmd_manager;
+
+    for (int hmd_id : hmdManager->getOpenDeviceIds())
+    {
+        ServerHMDViewPtr hmd_view = hmdManager->getHMDViewPtr(hmd_id);
+
+        if (hmd_view->getIsOpen() && hmd_view->getTrackingColorID() == color_id)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+TrackerManager::startBundleAdjustmentRecording(int controller_id)
+{
+    m_bundle_adjustment_controller_id = controller_id;
+    m_bundle_adjustment_sample_count = 0;
+    m_bundle_adjustment_observations.clear();
+
+    for (int tracker_id = 0; tracker_id < k_max_devices; ++tracker_id)
+    {
+        m_bundle_adjustment_has_last_position[tracker_id] = false;
+    }
+
+    SERVER_LOG_INFO("TrackerManager::startBundleAdjustmentRecording") << "Recording bulb sightings of controller " << controller_id;
+}
+
+void
+TrackerManager::stopBundleAdjustmentRecording()
+{
+    m_bundle_adjustment_controller_id = -1;
+}
+
+void
+TrackerManager::addBundleAdjustmentSample(
+    const int *tracker_ids,
+    const CommonDevicePosition *tracker_relative_positions_cm,
+    int tracker_count)
+{
+    if (tracker_count < 2 || m_bundle_adjustment_sample_count >= k_max_bundle_adjustment_samples)
+    {
+        return;
+    }
+
+    // Only keep the sample once the bulb has moved, a bulb held still adds no information
+    bool bHasMoved = false;
+    for (int list_index = 0; list_index < tracker_count; ++list_index)
+    {
+        const int tracker_id = tracker_ids[list_index];
+        const CommonDevicePosition &position = tracker_relative_positions_cm[list_index];
+        const CommonDevicePosition &last_position = m_bundle_adjustment_last_positions[tracker_id];
+        const float dx = position.x - last_position.x;
+        const float dy = position.y - last_position.y;
+        const float dz = position.z - last_position.z;
+
+        if (!m_bundle_adjustment_has_last_position[tracker_id] ||
+            sqrtf(dx*dx + dy*dy + dz*dz) >= k_bundle_adjustment_min_sample_spacing_cm)
+        {
+            bHasMoved = true;
+            break;
+        }
+    }
+
+    if (!bHasMoved)
+    {
+        return;
+    }
+
+    // Store the undistorted pixel of the bulb center, the sphere fit already removed the lens distortion
+    for (int list_index = 0; list_index < tracker_count; ++list_index)
+    {
+        const int tracker_id = tracker_ids[list_index];
+        const CommonDevicePosition &position = tracker_relative_positions_cm[list_index];
+
+        if (position.z <= k_real_epsilon)
+        {
+            continue;
+        }
+
+        float focal_length_x, focal_length_y, principal_x, principal_y;
+        float distortion_k1, distortion_k2, distortion_k3, distortion_p1, distortion_p2;
+        getTrackerViewPtr(tracker_id)->getCameraIntrinsics(
+            focal_length_x, focal_length_y,
+            principal_x, principal_y,
+            distortion_k1, distortion_k2, distortion_k3,
+            distortion_p1, distortion_p2);
+
+        BundleAdjustmentObservation observation;
+        observation.sample_index = m_bundle_adjustment_sample_count;
+        observation.tracker_id = tracker_id;
+        observation.pixel_x = principal_x + focal_length_x * position.x / position.z;
+        observation.pixel_y = principal_y - focal_length_y * position.y / position.z;
+        m_bundle_adjustment_observations.push_back(observation);
+
+        m_bundle_adjustment_last_positions[tracker_id] = position;
+        m_bundle_adjustment_has_last_position[tracker_id] = true;
+    }
+
+    ++m_bundle_adjustment_sample_count;
+}
+
+bool
+TrackerManager::solveBundleAdjustment(
+    bool refine_intrinsics,
+    bool apply_result,
+    TrackerBundleAdjustmentSummary &out_summary)
+{
+    memset(&out_summary, 0, sizeof(TrackerBundleAdjustmentSummary));
+    out_summary.sample_count = m_bundle_adjustment_sample_count;
+
+    stopBundleAdjustmentRecording();
+
+    // One bundle adjustment camera per open tracker that saw the bulb
+    int camera_index_for_tracker[k_max_devices];
+    EigenBundleAdjustmentCamera cameras[k_max_devices];
+    int camera_count = 0;
+
+    for (int tracker_id = 0; tracker_id < getMaxDevices(); ++tracker_id)
+    {
+        ServerTrackerViewPtr tracker = getTrackerViewPtr(tracker_id);
+
+        camera_index_for_tracker[tracker_id] = -1;
+
+        if (tracker->getIsOpen() && m_bundle_adjustment_has_last_position[tracker_id])
+        {
+            const CommonDevicePose pose = tracker->getTrackerPose();
+            float distortion_k1, distortion_k2, distortion_k3, distortion_p1, distortion_p2;
+            EigenBundleAdjustmentCamera &camera = cameras[camera_count];
+
+            camera.orientation = Eigen::Quaternionf(pose.Orientation.w, pose.Orientation.x, pose.Orientation.y, pose.Orientation.z);
+            camera.position = Eigen::Vector3f(pose.PositionCm.x, pose.PositionCm.y, pose.PositionCm.z);
+            tracker->getCameraIntrinsics(
+                camera.focal_length_x, camera.focal_length_y,
+                camera.principal_x, camera.principal_y,
+                distortion_k1, distortion_k2, distortion_k3,
+                distortion_p1, distortion_p2);
+
+            out_summary.trackers[camera_count].tracker_id = tracker_id;
+            camera_index_for_tracker[tracker_id] = camera_count;
+            ++camera_count;
+        }
+    }
+    out_summary.tracker_count = camera_count;
+
+    // Each sample is one world point
+    std::vector<EigenBundleAdjustmentObservation> observations;
+    observations.reserve(m_bundle_adjustment_observations.size());
+    for (const BundleAdjustmentObservation &source : m_bundle_adjustment_observations)
+    {
+        const int camera_index = camera_index_for_tracker[source.tracker_id];
+
+        if (camera_index != -1)
+        {
+            EigenBundleAdjustmentObservation observation;
+            observation.camera_index = camera_index;
+            observation.point_index = source.sample_index;
+            observation.pixel = Eigen::Vector2f(source.pixel_x, source.pixel_y);
+            observations.push_back(observation);
+
+            ++out_summary.trackers[camera_index].observation_count;
+        }
+    }
+
+    EigenBundleAdjustmentResult result;
+    float initial_camera_rms_px[k_max_devices];
+    float final_camera_rms_px[k_max_devices];
+    const bool bSuccess =
+        eigen_alignment_bundle_adjust_cameras(
+            cameras, camera_count,
+            observations.data(), static_cast<int>(observations.size()),
+            m_bundle_adjustment_sample_count,
+            refine_intrinsics,
+            k_bundle_adjustment_max_iterations,
+            &result, initial_camera_rms_px, final_camera_rms_px);
+
+    if (!bSuccess)
+    {
+        SERVER_LOG_WARNING("TrackerManager::solveBundleAdjustment") <<
+            "Not enough shared bulb sightings (" << m_bundle_adjustment_sample_count << " samples, " 
+            << camera_count << " trackers) to refine the tracker poses";
+        return false;
+    }
+
+    out_summary.observation_count = result.observation_count;
+    out_summary.iteration_count = result.iteration_count;
+    out_summary.initial_rms_px = result.initial_rms_px;
+    out_summary.final_rms_px = result.final_rms_px;
+
+    for (int camera_index = 0; camera_index < camera_count; ++camera_index)
+    {
+        const EigenBundleAdjustmentCamera &camera = cameras[camera_index];
+        TrackerBundleAdjustmentEntry &entry = out_summary.trackers[camera_index];
+
+        entry.initial_rms_px = initial_camera_rms_px[camera_index];
+        entry.final_rms_px = final_camera_rms_px[camera_index];
+        entry.pose.Orientation.w = camera.orientation.w();
+        entry.pose.Orientation.x = camera.orientation.x();
+        entry.pose.Orientation.y = camera.orientation.y();
+        entry.pose.Orientation.z = camera.orientation.z();
+        entry.pose.PositionCm.set(camera.position.x(), camera.position.y(), camera.position.z());
+        entry.focal_length_x = camera.focal_length_x;
+        entry.focal_length_y = camera.focal_length_y;
+        entry.principal_x = camera.principal_x;
+        entry.principal_y = camera.principal_y;
+    }
+
+    SERVER_LOG_INFO("TrackerManager::solveBundleAdjustment") <<
+        "Refined " << camera_count << " tracker poses from " << result.point_count << " samples: reprojection error " 
+        << result.initial_rms_px << "px -> " << result.final_rms_px << "px";
+
+    // Only keep a solution that actually fits the data better
+    if (apply_result && result.final_rms_px < result.initial_rms_px)
+    {
+        for (int camera_index = 0; camera_index < camera_count; ++camera_index)
+        {
+            const TrackerBundleAdjustmentEntry &entry = out_summary.trackers[camera_index];
+            ServerTrackerViewPtr tracker = getTrackerViewPtr(entry.tracker_id);
+
+            if (refine_intrinsics)
+            {
+                float focal_length_x, focal_length_y, principal_x, principal_y;
+                float distortion_k1, distortion_k2, distortion_k3, distortion_p1, distortion_p2;
+                tracker->getCameraIntrinsics(
+                    focal_length_x, focal_length_y,
+                    principal_x, principal_y,
+                    distortion_k1, distortion_k2, distortion_k3,
+                    distortion_p1, distortion_p2);
+                tracker->setCameraIntrinsics(
+                    entry.focal_length_x, entry.focal_length_y,
+                    entry.principal_x, entry.principal_y,
+                    distortion_k1, distortion_k2, distortion_k3,
+                    distortion_p1, distortion_p2);
+            }
+
+            tracker->setTrackerPose(&entry.pose);
+            tracker->saveSettings();
+        }
+
+        out_summary.bApplied = true;
+    }
+
+    return true;
+}
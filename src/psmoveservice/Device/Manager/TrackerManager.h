@@ -4,10 +4,14 @@
 //-- includes -----
 #include <memory>
 #include <deque>
+#include <vector>
 #include "DeviceTypeManager.h"
 #include "DeviceEnumerator.h"
 #include "DeviceInterface.h"
 #include "PSMoveConfig.h"
+#include "LEDBlinkCode.h"
+#include "TrackerDriftEstimator.h"
+#include "TrackingColorCalibrator.h"
 
 //-- typedefs -----
 
@@ -39,6 +43,30 @@ struct TrackerProfile
     }
 };
 
+// Outcome of a joint refinement of all tracker poses, see TrackerManager::solveBundleAdjustment
+struct TrackerBundleAdjustmentEntry
+{
+    int tracker_id;
+    int observation_count;
+    float initial_rms_px;
+    float final_rms_px;
+    CommonDevicePose pose;
+    float focal_length_x, focal_length_y;
+    float principal_x, principal_y;
+};
+
+struct TrackerBundleAdjustmentSummary
+{
+    int sample_count;
+    int observation_count;
+    int iteration_count;
+    float initial_rms_px;
+    float final_rms_px;
+    bool bApplied;
+    int tracker_count;
+    TrackerBundleAdjustmentEntry trackers[PSMOVESERVICE_MAX_TRACKER_COUNT];
+};
+
 class TrackerManagerConfig : public PSMoveConfig
 {
 public:
@@ -55,9 +83,31 @@ public:
     int optical_tracking_timeout;
 	int tracker_sleep_ms;
 	bool use_bgr_to_hsv_lookup_table;
+	bool use_rle_blob_extractor; // label blobs with RLEBlobExtractor instead of cv::findContours
+	bool use_sphere_edge_refinement; // re-fit sphere projections to subpixel image edges
+	int sphere_edge_refinement_ray_count; // edge search rays cast per sphere
+	float sphere_edge_refinement_search_px; // edge search distance either side of the hull
 	bool exclude_opposed_cameras;
 	float min_valid_projection_area;
 	bool disable_roi;
+	bool use_adaptive_roi; // velocity scaled ROI with progressively larger fallback windows
+	bool use_global_blob_assignment; // pair each frame's blobs with all the controllers at once, see BlobAssignment.h
+	int max_tracker_count; // tracker slots to allocate, at most PSMOVESERVICE_MAX_TRACKER_COUNT
+	int virtual_tracker_count; // VirtualTrackers rendering the synthetic scene, enumerated after the USB cameras
+	int remote_tracker_count; // RemoteTrackers showing tracker node cameras, enumerated after the virtual trackers
+	std::string remote_tracker_transport; // "udp" between hosts, "loopback" for nodes and remote trackers in this service
+	int remote_tracker_port; // UDP port the central host listens on
+	bool tracker_node_mode; // send the blobs this host's cameras find to a central host, see RemoteTracker
+	std::string tracker_node_fusion_host;
+	int tracker_node_camera_id_base; // a node camera's id is this plus its tracker id, unique across the nodes
+	int tracker_node_max_blobs_per_color;
+	bool use_drift_detection; // watch for bumped trackers (needs three or more trackers)
+	bool apply_drift_correction; // correct a bumped tracker's pose instead of only reporting it
+	float drift_detection_threshold_px; // reprojection error against the other trackers that counts as drift
+	bool use_led_blink_codes; // share tracking colors between controllers once they run out, see LEDBlinkCode.h
+	int led_blink_code_slot_count; // controllers per shared color, also the length of the code cycle in bits
+	float led_blink_code_bit_ms;
+	float led_blink_code_latency_ms; // from commanding a bulb to seeing it change on camera
     TrackerProfile default_tracker_profile;
 	float global_forward_degrees;
 
@@ -75,14 +125,13 @@ public:
     TrackerManager();
 
     bool startup() override;
+    void shutdown() override;
+    void publish() override;
 
     void closeAllTrackers();
 
+    // Compile time ceiling, the slot count actually used is getMaxDevices()
     static const int k_max_devices = PSMOVESERVICE_MAX_TRACKER_COUNT;
-    int getMaxDevices() const override
-    {
-        return TrackerManager::k_max_devices;
-    }
 
     ServerTrackerViewPtr getTrackerViewPtr(int device_id) const;
 
@@ -102,14 +151,99 @@ public:
         return cfg;
     }
 
-    eCommonTrackingColorID allocateTrackingColorID();
+    // Full frame reacquisition scans are handed to one open tracker at a time, round robin,
+    // so that losing a device doesn't make every camera scan the whole frame at once.
+    // The slot moves on once its holder has processed a frame, so every camera gets a turn
+    // no matter how the camera frame rates line up with the poll rate.
+    inline bool getIsFullFrameScanSlot(int tracker_id) const
+    {
+        return tracker_id == m_full_frame_scan_tracker_id;
+    }
+
+    // Global blob assignment: every tracker with a new frame pairs its blobs
+    // with the controllers it's following before they compute their projections
+    void assignControllerBlobs();
+
+    // Controllers pass bAllowSharedColor so that with blink codes enabled they can be handed
+    // a color another controller already has once every color is taken (INVALID_COLOR if all are full)
+    eCommonTrackingColorID allocateTrackingColorID(bool bAllowSharedColor = false);
     bool claimTrackingColorID(const class ServerControllerView *controller_view, eCommonTrackingColorID color_id);
     bool claimTrackingColorID(const class ServerHMDView *hmd_view, eCommonTrackingColorID color_id);
-    void freeTrackingColorID(eCommonTrackingColorID color_id);
+    // A color shared through blink codes only goes back to the pool once no other controller uses it
+    void freeTrackingColorID(eCommonTrackingColorID color_id, const class ServerControllerView *releasing_controller_view = nullptr);
+
+    // LED blink codes: controllers that share a tracking color each get a code slot
+    // and are told apart by which bit of the code cycle their bulb goes dark in
+    inline const LEDBlinkCodeTiming &getLEDBlinkCodeTiming() const
+    {
+        return m_blink_code_timing;
+    }
+
+    // Code slot of the controller, -1 if it doesn't share its tracking color
+    inline int getLEDBlinkCodeSlot(int controller_id) const
+    {
+        return m_blink_code_slots[controller_id];
+    }
+
+    // Bumped every time the controllers sharing the color change, the slots are re-dealt then
+    inline int getLEDBlinkCodeGeneration(eCommonTrackingColorID color_id) const
+    {
+        return m_blink_code_generations[color_id];
+    }
+
+    inline int getLEDBlinkCodeGroupSize(eCommonTrackingColorID color_id) const
+    {
+        return static_cast<int>(m_blink_code_groups[color_id].size());
+    }
+
+    // Tracker pose refinement: while recording, every update where two or more trackers
+    // fit the bulb of the recorded controller adds one synchronized sample
+    void startBundleAdjustmentRecording(int controller_id);
+    void stopBundleAdjustmentRecording();
+    inline bool getIsRecordingBundleAdjustment(int controller_id) const
+    {
+        return controller_id >= 0 && controller_id == m_bundle_adjustment_controller_id;
+    }
+    void addBundleAdjustmentSample(
+        const int *tracker_ids, const CommonDevicePosition *tracker_relative_positions_cm, int tracker_count);
+    bool solveBundleAdjustment(bool refine_intrinsics, bool apply_result, TrackerBundleAdjustmentSummary &out_summary);
+
+    // Drift detection: every update where three or more trackers fit a bulb
+    inline void addDriftSample(
+        const int *tracker_ids, const CommonDevicePosition *tracker_relative_positions_cm, int tracker_count)
+    {
+        if (cfg.use_drift_detection)
+        {
+            m_drift_estimator.addSample(this, tracker_ids, tracker_relative_positions_cm, tracker_count);
+        }
+    }
+
+    // Automatic color calibration: blinks the controller's bulb in the given color and fits every
+    // open tracker's preset for that color to the pixels that change, see TrackingColorCalibrator
+    inline bool startTrackingColorCalibration(int controller_id, eCommonTrackingColorID color_id)
+    {
+        return m_color_calibrator.start(this, controller_id, color_id);
+    }
 
 protected:
+    int getConfiguredMaxDevices() const override
+    {
+        return cfg.max_tracker_count;
+    }
+    int getDeviceCountCeiling() const override
+    {
+        return TrackerManager::k_max_devices;
+    }
+
+    void poll_devices() override;
+    void handle_device_closed(int device_id) override;
+    void advanceFullFrameScanSlot();
+    void sendTrackerNodeFrames();
     bool can_update_connected_devices() override;
     void mark_tracker_list_dirty();
+    void updateLEDBlinkCodes();
+    int countControllersUsingTrackingColorID(eCommonTrackingColorID color_id, const class ServerControllerView *excluded_controller_view) const;
+    bool getIsTrackingColorIDUsedByHMD(eCommonTrackingColorID color_id) const;
 
     DeviceEnumerator *allocate_device_enumerator() override;
     void free_device_enumerator(DeviceEnumerator *) override;
@@ -120,6 +254,27 @@ private:
     std::deque<eCommonTrackingColorID> m_available_color_ids;
     TrackerManagerConfig cfg;
     bool m_tracker_list_dirty;
+    int m_full_frame_scan_tracker_id;
+
+    struct BundleAdjustmentObservation
+    {
+        int sample_index;
+        int tracker_id;
+        float pixel_x, pixel_y; // undistorted
+    };
+    int m_bundle_adjustment_controller_id;
+    int m_bundle_adjustment_sample_count;
+    std::vector<BundleAdjustmentObservation> m_bundle_adjustment_observations;
+    CommonDevicePosition m_bundle_adjustment_last_positions[k_max_devices];
+    bool m_bundle_adjustment_has_last_position[k_max_devices];
+
+    TrackerDriftEstimator m_drift_estimator;
+    TrackingColorCalibrator m_color_calibrator;
+
+    LEDBlinkCodeTiming m_blink_code_timing;
+    std::vector<int> m_blink_code_groups[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES]; // ids of the controllers sharing each color
+    int m_blink_code_generations[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+    int m_blink_code_slots[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
 };
 
 #endif // TRACKER_MANAGER_H
\ No newline at end of file
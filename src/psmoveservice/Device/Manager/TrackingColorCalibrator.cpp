@@ -0,0 +1,691 @@
+//-- includes -----
+#include "TrackingColorCalibrator.h"
+#include "DeviceManager.h"
+#include "TrackerManager.h"
+#include "PSMoveProtocol.pb.h"
+#include "ServerControllerView.h"
+#include "ServerLog.h"
+#include "ServerNetworkManager.h"
+#include "ServerTrackerView.h"
+
+#include "opencv2/opencv.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+//-- constants -----
+static const float k_led_settle_milli = 250.f; // bluetooth LED update plus a camera exposure
+static const float k_phase_timeout_milli = 1500.f; // give up on trackers that stopped sending frames
+static const int k_frames_per_phase = 3;
+static const int k_min_led_difference = 48; // brightest channel change of a bulb pixel
+static const int k_min_bulb_pixel_count = 30;
+static const int k_min_hue_saturation = 64; // below this the hue of a pixel is mostly noise
+static const float k_hue_trim_fraction = 0.02f; // dropped from either end of the hue histogram
+static const float k_saturation_value_trim_fraction = 0.05f; // dropped from the low end
+static const int k_hue_margin = 3;
+static const int k_min_hue_range = 6;
+static const int k_saturation_value_margin = 16;
+static const int k_background_exclusion_radius_px = 7; // bulb halo left out of the background check
+static const float k_max_background_match_fraction = 0.002f;
+
+//-- private definitions -----
+struct TrackingColorCapture
+{
+    int tracker_id;
+    bool bActive;
+    std::chrono::time_point<std::chrono::high_resolution_clock> last_frame_timestamp;
+    int off_frame_count;
+    int on_frame_count;
+    cv::Mat off_max_bgr; // brightest each pixel got with the bulb off
+    cv::Mat on_min_bgr; // darkest each pixel got with the bulb on
+    cv::Mat on_sum_bgr; // CV_32FC3, averaged for the bulb colors
+    std::thread solve_thread;
+    std::atomic_bool bSolveDone;
+    TrackingColorCalibrationResult result;
+
+    TrackingColorCapture(int id)
+        : tracker_id(id)
+        , bActive(false)
+        , off_frame_count(0)
+        , on_frame_count(0)
+        , bSolveDone(false)
+    {
+        result.tracker_id = id;
+        result.bApplied = false;
+        result.bulb_pixel_count = 0;
+        result.background_match_fraction = 0.f;
+        result.hsv_range.clear();
+    }
+};
+
+//-- prototypes -----
+static bool get_tracking_color_rgb(eCommonTrackingColorID color_id, unsigned char &r, unsigned char &g, unsigned char &b);
+static void compute_tracking_color_range(TrackingColorCapture *capture);
+static int find_histogram_percentile(const int *histogram, int bin_count, int total, float fraction);
+static inline int wrap_hue(int hue);
+
+//-- public methods -----
+TrackingColorCalibrator::TrackingColorCalibrator()
+    : m_phase(_phase_idle)
+    , m_controller_id(-1)
+    , m_color_id(eCommonTrackingColorID::INVALID_COLOR)
+    , m_bRestoreLEDOverride(false)
+    , m_capture_count(0)
+{
+    for (int tracker_id = 0; tracker_id < PSMOVESERVICE_MAX_TRACKER_COUNT; ++tracker_id)
+    {
+        m_captures[tracker_id] = nullptr;
+    }
+}
+
+TrackingColorCalibrator::~TrackingColorCalibrator()
+{
+    for (int tracker_id = 0; tracker_id < PSMOVESERVICE_MAX_TRACKER_COUNT; ++tracker_id)
+    {
+        TrackingColorCapture *capture = m_captures[tracker_id];
+
+        if (capture != nullptr)
+        {
+            if (capture->solve_thread.joinable())
+            {
+                capture->solve_thread.join();
+            }
+
+            delete capture;
+        }
+    }
+}
+
+bool
+TrackingColorCalibrator::start(TrackerManager *tracker_manager, int controller_id, eCommonTrackingColorID color_id)
+{
+    if (m_phase != _phase_idle)
+    {
+        SERVER_LOG_WARNING("TrackingColorCalibrator::start") << "A color calibration is already running";
+        return false;
+    }
+
+    ServerControllerViewPtr controller_view = DeviceManager::getInstance()->getControllerViewPtr(controller_id);
+    if (!controller_view || !controller_view->getIsOpen())
+    {
+        return false;
+    }
+
+    unsigned char r, g, b;
+    if (!get_tracking_color_rgb(color_id, r, g, b))
+    {
+        SERVER_LOG_WARNING("TrackingColorCalibrator::start") << "Invalid tracking color " << color_id;
+        return false;
+    }
+
+    // Only the trackers open now take part, the per-frame steps just walk these
+    m_capture_count = 0;
+    for (int tracker_id : tracker_manager->getOpenDeviceIds())
+    {
+        if (m_captures[tracker_id] != nullptr)
+        {
+            delete m_captures[tracker_id];
+        }
+
+        m_captures[tracker_id] = new TrackingColorCapture(tracker_id);
+        m_captures[tracker_id]->bActive = true;
+
+        m_capture_tracker_ids[m_capture_count] = tracker_id;
+        ++m_capture_count;
+    }
+
+    if (m_capture_count == 0)
+    {
+        SERVER_LOG_WARNING("TrackingColorCalibrator::start") << "No open trackers to calibrate";
+        return false;
+    }
+
+    SERVER_LOG_INFO("TrackingColorCalibrator::start") <<
+        "Calibrating tracking color " << color_id << " with controller " << controller_id << " on " << m_capture_count << " trackers";
+
+    m_controller_id = controller_id;
+    m_color_id = color_id;
+    m_bRestoreLEDOverride = controller_view->getIsLEDOverrideActive();
+
+    controller_view->setLEDOverride(0, 0, 0);
+    m_phase = _phase_led_off;
+    m_phase_start_time = std::chrono::high_resolution_clock::now();
+
+    return true;
+}
+
+void
+TrackingColorCalibrator::update(TrackerManager *tracker_manager)
+{
+    if (m_phase == _phase_idle)
+    {
+        return;
+    }
+
+    ServerControllerViewPtr controller_view = DeviceManager::getInstance()->getControllerViewPtr(m_controller_id);
+    if (m_phase != _phase_solving && (!controller_view || !controller_view->getIsOpen()))
+    {
+        SERVER_LOG_WARNING("TrackingColorCalibrator::update") << "Controller " << m_controller_id << " closed during the color calibration";
+        finish(tracker_manager, false);
+        return;
+    }
+
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+    const std::chrono::duration<float, std::milli> phase_duration = now - m_phase_start_time;
+
+    switch (m_phase)
+    {
+    case _phase_led_off:
+    case _phase_led_on:
+        if (phase_duration.count() >= k_led_settle_milli)
+        {
+            bool bAllCaptured = false;
+
+            captureFrames(tracker_manager, m_phase == _phase_led_on, bAllCaptured);
+
+            if (bAllCaptured || phase_duration.count() >= k_phase_timeout_milli)
+            {
+                if (m_phase == _phase_led_off)
+                {
+                    unsigned char r, g, b;
+                    get_tracking_color_rgb(m_color_id, r, g, b);
+
+                    controller_view->setLEDOverride(r, g, b);
+                    m_phase = _phase_led_on;
+                    m_phase_start_time = now;
+                }
+                else
+                {
+                    startSolving();
+                }
+            }
+        }
+        break;
+    case _phase_solving:
+        {
+            bool bAllSolved = true;
+
+            for (int capture_index = 0; capture_index < m_capture_count && bAllSolved; ++capture_index)
+            {
+                const TrackingColorCapture *capture = m_captures[m_capture_tracker_ids[capture_index]];
+
+                if (capture != nullptr && capture->bActive && !capture->bSolveDone)
+                {
+                    bAllSolved = false;
+                }
+            }
+
+            if (bAllSolved)
+            {
+                finish(tracker_manager, true);
+            }
+        } break;
+    default:
+        break;
+    }
+}
+
+//-- private methods -----
+void
+TrackingColorCalibrator::captureFrames(TrackerManager *tracker_manager, bool bLEDOn, bool &out_bAllCaptured)
+{
+    const std::chrono::time_point<std::chrono::high_resolution_clock> settle_time =
+        m_phase_start_time + std::chrono::microseconds(static_cast<int>(k_led_settle_milli * 1000.f));
+
+    out_bAllCaptured = true;
+
+    for (int capture_index = 0; capture_index < m_capture_count; ++capture_index)
+    {
+        const int tracker_id = m_capture_tracker_ids[capture_index];
+        TrackingColorCapture *capture = m_captures[tracker_id];
+
+        if (capture == nullptr || !capture->bActive)
+        {
+            continue;
+        }
+
+        int &frame_count = bLEDOn ? capture->on_frame_count : capture->off_frame_count;
+        ServerTrackerViewPtr tracker_view = tracker_manager->getTrackerViewPtr(tracker_id);
+
+        if (!tracker_view->getIsOpen())
+        {
+            capture->bActive = false;
+            continue;
+        }
+
+        // Only frames exposed after the bulb settled, and each frame only once
+        const std::chrono::time_point<std::chrono::high_resolution_clock> frame_timestamp = tracker_view->getLastNewDataTimestamp();
+        const ITrackerInterface *tracker_device = static_cast<const ITrackerInterface *>(tracker_view->getDevice());
+        const unsigned char *buffer = tracker_device->getVideoFrameBuffer();
+
+        if (frame_count < k_frames_per_phase &&
+            buffer != nullptr &&
+            frame_timestamp > settle_time &&
+            frame_timestamp != capture->last_frame_timestamp)
+        {
+            int width, height;
+            tracker_device->getVideoFrameDimensions(&width, &height, nullptr);
+
+            const cv::Mat frame(height, width, CV_8UC3, const_cast<unsigned char *>(buffer));
+
+            if (!capture->off_max_bgr.empty() && capture->off_max_bgr.size() != frame.size())
+            {
+                SERVER_LOG_WARNING("TrackingColorCalibrator::captureFrames") << "Tracker " << tracker_id << " changed frame size, skipping it";
+                capture->bActive = false;
+                continue;
+            }
+
+            if (!bLEDOn)
+            {
+                if (frame_count == 0)
+                {
+                    frame.copyTo(capture->off_max_bgr);
+                }
+                else
+                {
+                    cv::max(capture->off_max_bgr, frame, capture->off_max_bgr);
+                }
+            }
+            else
+            {
+                if (frame_count == 0)
+                {
+                    frame.copyTo(capture->on_min_bgr);
+                    frame.convertTo(capture->on_sum_bgr, CV_32F);
+                }
+                else
+                {
+                    cv::min(capture->on_min_bgr, frame, capture->on_min_bgr);
+                    cv::accumulate(frame, capture->on_sum_bgr);
+                }
+            }
+
+            capture->last_frame_timestamp = frame_timestamp;
+            ++frame_count;
+        }
+
+        if (frame_count < k_frames_per_phase)
+        {
+            out_bAllCaptured = false;
+        }
+    }
+}
+
+void
+TrackingColorCalibrator::startSolving()
+{
+    // Every tracker is solved on its own thread, the service loop keeps running meanwhile
+    for (int capture_index = 0; capture_index < m_capture_count; ++capture_index)
+    {
+        const int tracker_id = m_capture_tracker_ids[capture_index];
+        TrackingColorCapture *capture = m_captures[tracker_id];
+
+        if (capture == nullptr || !capture->bActive)
+        {
+            continue;
+        }
+
+        if (capture->off_frame_count > 0 && capture->on_frame_count > 0)
+        {
+            capture->bSolveDone = false;
+            capture->solve_thread = std::thread(compute_tracking_color_range, capture);
+        }
+        else
+        {
+            SERVER_LOG_WARNING("TrackingColorCalibrator::startSolving") << "Tracker " << tracker_id << " sent no frames, skipping it";
+            capture->bActive = false;
+        }
+    }
+
+    m_phase = _phase_solving;
+}
+
+void
+TrackingColorCalibrator::finish(TrackerManager *tracker_manager, bool bApplyResults)
+{
+    ServerControllerViewPtr controller_view = DeviceManager::getInstance()->getControllerViewPtr(m_controller_id);
+    TrackingColorCalibrationResult results[PSMOVESERVICE_MAX_TRACKER_COUNT];
+    int result_count = 0;
+
+    for (int capture_index = 0; capture_index < m_capture_count; ++capture_index)
+    {
+        const int tracker_id = m_capture_tracker_ids[capture_index];
+        TrackingColorCapture *capture = m_captures[tracker_id];
+
+        if (capture == nullptr)
+        {
+            continue;
+        }
+
+        if (capture->solve_thread.joinable())
+        {
+            capture->solve_thread.join();
+        }
+
+        if (bApplyResults && capture->bActive)
+        {
+            ServerTrackerViewPtr tracker_view = tracker_manager->getTrackerViewPtr(tracker_id);
+            TrackingColorCalibrationResult &result = capture->result;
+
+            if (result.bApplied && tracker_view->getIsOpen() && controller_view)
+            {
+                tracker_view->setControllerTrackingColorPreset(controller_view.get(), m_color_id, &result.hsv_range);
+
+                SERVER_LOG_INFO("TrackingColorCalibrator::finish") <<
+                    "Tracker " << tracker_id << " color " << m_color_id <<
+                    ": hue " << result.hsv_range.hue_range.center << "+/-" << result.hsv_range.hue_range.range <<
+                    ", sat " << result.hsv_range.saturation_range.center << "+/-" << result.hsv_range.saturation_range.range <<
+                    ", val " << result.hsv_range.value_range.center << "+/-" << result.hsv_range.value_range.range <<
+                    " (" << result.bulb_pixel_count << " bulb pixels)";
+            }
+            else
+            {
+                result.bApplied = false;
+
+                SERVER_LOG_WARNING("TrackingColorCalibrator::finish") <<
+                    "Tracker " << tracker_id << " kept its color preset (" << result.bulb_pixel_count << " bulb pixels, " <<
+                    result.background_match_fraction*100.f << "% background match)";
+            }
+
+            results[result_count] = result;
+            ++result_count;
+        }
+
+        delete capture;
+        m_captures[tracker_id] = nullptr;
+    }
+
+    // Put the bulb back the way we found it
+    if (controller_view)
+    {
+        if (m_bRestoreLEDOverride)
+        {
+            unsigned char r, g, b;
+            get_tracking_color_rgb(m_color_id, r, g, b);
+
+            controller_view->setLEDOverride(r, g, b);
+        }
+        else
+        {
+            controller_view->clearLEDOverride();
+        }
+    }
+
+    sendCalibratedNotification(results, result_count);
+
+    m_phase = _phase_idle;
+    m_controller_id = -1;
+    m_color_id = eCommonTrackingColorID::INVALID_COLOR;
+    m_capture_count = 0;
+}
+
+void
+TrackingColorCalibrator::sendCalibratedNotification(const TrackingColorCalibrationResult *results, int result_count)
+{
+    if (ServerNetworkManager::get_instance() != nullptr)
+    {
+        ResponsePtr response(new PSMoveProtocol::Response);
+        response->set_type(PSMoveProtocol::Response_ResponseType_TRACKING_COLOR_CALIBRATED);
+        response->set_request_id(-1);
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+
+        PSMoveProtocol::Response_ResultTrackingColorCalibrated *calibrated = response->mutable_result_tracking_color_calibrated();
+        calibrated->set_controller_id(m_controller_id);
+
+        for (int result_index = 0; result_index < result_count; ++result_index)
+        {
+            const TrackingColorCalibrationResult &result = results[result_index];
+            PSMoveProtocol::Response_ResultTrackingColorCalibrated_TrackerEntry *entry = calibrated->add_tracker_entries();
+            PSMoveProtocol::TrackingColorPreset *preset = entry->mutable_color_preset();
+
+            entry->set_tracker_id(result.tracker_id);
+            entry->set_applied(result.bApplied);
+            entry->set_bulb_pixel_count(result.bulb_pixel_count);
+            entry->set_background_match_fraction(result.background_match_fraction);
+            preset->set_color_type(static_cast<PSMoveProtocol::TrackingColorType>(m_color_id));
+            preset->set_hue_center(result.hsv_range.hue_range.center);
+            preset->set_hue_range(result.hsv_range.hue_range.range);
+            preset->set_saturation_center(result.hsv_range.saturation_range.center);
+            preset->set_saturation_range(result.hsv_range.saturation_range.range);
+            preset->set_value_center(result.hsv_range.value_range.center);
+            preset->set_value_range(result.hsv_range.value_range.range);
+        }
+
+        ServerNetworkManager::get_instance()->send_notification_to_all_clients(response);
+    }
+}
+
+//-- private functions -----
+static bool get_tracking_color_rgb(eCommonTrackingColorID color_id, unsigned char &r, unsigned char &g, unsigned char &b)
+{
+    bool bValid = true;
+
+    switch (color_id)
+    {
+    case eCommonTrackingColorID::Magenta:
+        r = 0xFF; g = 0x00; b = 0xFF;
+        break;
+    case eCommonTrackingColorID::Cyan:
+        r = 0x00; g = 0xFF; b = 0xFF;
+        break;
+    case eCommonTrackingColorID::Yellow:
+        r = 0xFF; g = 0xFF; b = 0x00;
+        break;
+    case eCommonTrackingColorID::Red:
+        r = 0xFF; g = 0x00; b = 0x00;
+        break;
+    case eCommonTrackingColorID::Green:
+        r = 0x00; g = 0xFF; b = 0x00;
+        break;
+    case eCommonTrackingColorID::Blue:
+        r = 0x00; g = 0x00; b = 0xFF;
+        break;
+    default:
+        r = g = b = 0;
+        bValid = false;
+    }
+
+    return bValid;
+}
+
+// Runs on a solve thread, only touches the capture it was given
+static void compute_tracking_color_range(TrackingColorCapture *capture)
+{
+    TrackingColorCalibrationResult &result = capture->result;
+    result.bApplied = false;
+
+    // Pixels that only light up with the bulb on: the darkest "on" frame against the brightest "off" frame,
+    // so flicker and noise don't count as the bulb
+    cv::Mat difference_bgr;
+    cv::subtract(capture->on_min_bgr, capture->off_max_bgr, difference_bgr);
+
+    cv::Mat difference_channels[3];
+    cv::split(difference_bgr, difference_channels);
+
+    // Brightest channel, a luminance weighting would all but hide a blue bulb
+    cv::Mat difference;
+    cv::max(difference_channels[0], difference_channels[1], difference);
+    cv::max(difference, difference_channels[2], difference);
+
+    cv::Mat led_mask;
+    cv::threshold(difference, led_mask, k_min_led_difference, 255, cv::THRESH_BINARY);
+    cv::morphologyEx(led_mask, led_mask, cv::MORPH_OPEN, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3)));
+
+    // The biggest blob is the bulb, the rest are its reflections
+    cv::Mat labels, stats, centroids;
+    const int label_count = cv::connectedComponentsWithStats(led_mask, labels, stats, centroids, 8, CV_32S);
+    int bulb_label = -1;
+    int bulb_area = 0;
+    for (int label = 1; label < label_count; ++label)
+    {
+        const int area = stats.at<int>(label, cv::CC_STAT_AREA);
+
+        if (area > bulb_area)
+        {
+            bulb_label = label;
+            bulb_area = area;
+        }
+    }
+
+    result.bulb_pixel_count = bulb_area;
+    if (bulb_label < 0 || bulb_area < k_min_bulb_pixel_count)
+    {
+        capture->bSolveDone = true;
+        return;
+    }
+
+    const cv::Mat bulb_mask = (labels == bulb_label);
+
+    // Bulb colors averaged over the "on" frames
+    cv::Mat on_mean_bgr, on_mean_hsv;
+    capture->on_sum_bgr.convertTo(on_mean_bgr, CV_8U, 1.0 / static_cast<double>(capture->on_frame_count));
+    cv::cvtColor(on_mean_bgr, on_mean_hsv, cv::COLOR_BGR2HSV);
+
+    // Hue of the saturated bulb pixels, the blown out center has no meaningful hue
+    int hue_histogram[180] = {0};
+    int hue_sample_count = 0;
+    for (int y = 0; y < on_mean_hsv.rows; ++y)
+    {
+        const uchar *mask_row = bulb_mask.ptr<uchar>(y);
+        const cv::Vec3b *hsv_row = on_mean_hsv.ptr<cv::Vec3b>(y);
+
+        for (int x = 0; x < on_mean_hsv.cols; ++x)
+        {
+            if (mask_row[x] != 0 && hsv_row[x][1] >= k_min_hue_saturation)
+            {
+                ++hue_histogram[hsv_row[x][0]];
+                ++hue_sample_count;
+            }
+        }
+    }
+
+    if (hue_sample_count < k_min_bulb_pixel_count)
+    {
+        capture->bSolveDone = true;
+        return;
+    }
+
+    // Hue wraps around, so trim the histogram around its (smoothed) peak
+    int peak_hue = 0;
+    int peak_count = -1;
+    for (int hue = 0; hue < 180; ++hue)
+    {
+        int count = 0;
+        for (int offset = -2; offset <= 2; ++offset)
+        {
+            count += hue_histogram[wrap_hue(hue + offset)];
+        }
+
+        if (count > peak_count)
+        {
+            peak_hue = hue;
+            peak_count = count;
+        }
+    }
+
+    int hue_offset_histogram[180];
+    for (int offset = -90; offset < 90; ++offset)
+    {
+        hue_offset_histogram[offset + 90] = hue_histogram[wrap_hue(peak_hue + offset)];
+    }
+
+    const int hue_low = find_histogram_percentile(hue_offset_histogram, 180, hue_sample_count, k_hue_trim_fraction) - 90;
+    const int hue_high = find_histogram_percentile(hue_offset_histogram, 180, hue_sample_count, 1.f - k_hue_trim_fraction) - 90;
+    const float hue_center = static_cast<float>(wrap_hue(peak_hue + (hue_low + hue_high) / 2));
+    const float hue_range = static_cast<float>(std::max((hue_high - hue_low) / 2 + k_hue_margin, k_min_hue_range));
+
+    // Saturation and value of the bulb pixels inside that hue range, only the low end needs a bound
+    int saturation_histogram[256] = {0};
+    int value_histogram[256] = {0};
+    int in_hue_count = 0;
+    for (int y = 0; y < on_mean_hsv.rows; ++y)
+    {
+        const uchar *mask_row = bulb_mask.ptr<uchar>(y);
+        const cv::Vec3b *hsv_row = on_mean_hsv.ptr<cv::Vec3b>(y);
+
+        for (int x = 0; x < on_mean_hsv.cols; ++x)
+        {
+            const int hue_distance = std::abs(wrap_hue(hsv_row[x][0] - static_cast<int>(hue_center) + 90) - 90);
+
+            if (mask_row[x] != 0 && hue_distance <= hue_range)
+            {
+                ++saturation_histogram[hsv_row[x][1]];
+                ++value_histogram[hsv_row[x][2]];
+                ++in_hue_count;
+            }
+        }
+    }
+
+    const int saturation_min =
+        std::max(find_histogram_percentile(saturation_histogram, 256, in_hue_count, k_saturation_value_trim_fraction) - k_saturation_value_margin, 0);
+    const int value_min =
+        std::max(find_histogram_percentile(value_histogram, 256, in_hue_count, k_saturation_value_trim_fraction) - k_saturation_value_margin, 0);
+
+    result.hsv_range.hue_range.center = hue_center;
+    result.hsv_range.hue_range.range = hue_range;
+    result.hsv_range.saturation_range.center = static_cast<float>(saturation_min + 255) / 2.f;
+    result.hsv_range.saturation_range.range = static_cast<float>(255 - saturation_min) / 2.f;
+    result.hsv_range.value_range.center = static_cast<float>(value_min + 255) / 2.f;
+    result.hsv_range.value_range.range = static_cast<float>(255 - value_min) / 2.f;
+
+    // How much of the rest of the frame the new range would still pick up
+    cv::Mat bulb_halo_mask;
+    cv::dilate(
+        bulb_mask, bulb_halo_mask,
+        cv::getStructuringElement(
+            cv::MORPH_ELLIPSE,
+            cv::Size(2*k_background_exclusion_radius_px + 1, 2*k_background_exclusion_radius_px + 1)));
+
+    int background_count = 0;
+    int background_match_count = 0;
+    for (int y = 0; y < on_mean_hsv.rows; ++y)
+    {
+        const uchar *halo_row = bulb_halo_mask.ptr<uchar>(y);
+        const cv::Vec3b *hsv_row = on_mean_hsv.ptr<cv::Vec3b>(y);
+
+        for (int x = 0; x < on_mean_hsv.cols; ++x)
+        {
+            if (halo_row[x] == 0)
+            {
+                const int hue_distance = std::abs(wrap_hue(hsv_row[x][0] - static_cast<int>(hue_center) + 90) - 90);
+
+                if (hue_distance <= hue_range && hsv_row[x][1] >= saturation_min && hsv_row[x][2] >= value_min)
+                {
+                    ++background_match_count;
+                }
+                ++background_count;
+            }
+        }
+    }
+
+    result.background_match_fraction =
+        (background_count > 0) ? static_cast<float>(background_match_count) / static_cast<float>(background_count) : 0.f;
+    result.bApplied = result.background_match_fraction <= k_max_background_match_fraction;
+
+    capture->bSolveDone = true;
+}
+
+static int find_histogram_percentile(const int *histogram, int bin_count, int total, float fraction)
+{
+    const int target = static_cast<int>(fraction*static_cast<float>(total));
+    int cumulative = 0;
+
+    for (int bin = 0; bin < bin_count; ++bin)
+    {
+        cumulative += histogram[bin];
+
+        if (cumulative > target)
+        {
+            return bin;
+        }
+    }
+
+    return bin_count - 1;
+}
+
+static inline int wrap_hue(int hue)
+{
+    return ((hue % 180) + 180) % 180;
+}
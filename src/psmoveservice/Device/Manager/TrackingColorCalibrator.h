@@ -0,0 +1,71 @@
+#ifndef TRACKING_COLOR_CALIBRATOR_H
+#define TRACKING_COLOR_CALIBRATOR_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+#include "PSMoveProtocolInterface.h"
+#include <chrono>
+
+//-- pre-declarations -----
+class TrackerManager;
+struct TrackingColorCapture;
+
+//-- definitions -----
+// Outcome of the automatic color calibration on one tracker
+struct TrackingColorCalibrationResult
+{
+    int tracker_id;
+    bool bApplied; // false if the bulb wasn't found or the fitted range also matched the background
+    int bulb_pixel_count;
+    float background_match_fraction; // fraction of the non bulb pixels the fitted range still accepts
+    CommonHSVColorRange hsv_range;
+};
+
+/// Fits a controller's tracking color preset on every open tracker without user input.
+/// The bulb is turned off then on while each tracker captures a few frames of both,
+/// the pixels that only light up with the bulb on are the bulb. A tight HSV range is fit
+/// to their histogram on one worker thread per tracker and written to the tracker configs.
+class TrackingColorCalibrator
+{
+public:
+    TrackingColorCalibrator();
+    virtual ~TrackingColorCalibrator();
+
+    // Blinks the controller's bulb in color_id (which needn't be its assigned tracking color).
+    // Returns false if a calibration is already running or the controller isn't open
+    bool start(TrackerManager *tracker_manager, int controller_id, eCommonTrackingColorID color_id);
+
+    inline bool getIsRunning() const
+    {
+        return m_phase != _phase_idle;
+    }
+
+    // Steps the capture and applies the results once every solve finished, cheap when idle
+    void update(TrackerManager *tracker_manager);
+
+private:
+    enum eCalibrationPhase
+    {
+        _phase_idle,
+        _phase_led_off,
+        _phase_led_on,
+        _phase_solving,
+    };
+
+    void captureFrames(TrackerManager *tracker_manager, bool bLEDOn, bool &out_bAllCaptured);
+    void startSolving();
+    void finish(TrackerManager *tracker_manager, bool bApplyResults);
+    void sendCalibratedNotification(const TrackingColorCalibrationResult *results, int result_count);
+
+    eCalibrationPhase m_phase;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_phase_start_time;
+    int m_controller_id;
+    eCommonTrackingColorID m_color_id;
+    bool m_bRestoreLEDOverride; // the bulb had an override (e.g. from the config tool) before we started
+    TrackingColorCapture *m_captures[PSMOVESERVICE_MAX_TRACKER_COUNT];
+    // The trackers that were open at start(), the only ones with a capture
+    int m_capture_tracker_ids[PSMOVESERVICE_MAX_TRACKER_COUNT];
+    int m_capture_count;
+};
+
+#endif // TRACKING_COLOR_CALIBRATOR_H
@@ -0,0 +1,294 @@
+//-- includes -----
+#include "RLEBlobExtractor.h"
+
+#include <algorithm>
+#include <assert.h>
+
+//-- private methods -----
+static inline double sum_of_integers(const int first, const int last)
+{
+    // Sum of first..last inclusive
+    return 0.5 * static_cast<double>(last - first + 1) * static_cast<double>(first + last);
+}
+
+static inline double sum_of_squares_up_to(const int n)
+{
+    // Sum of 0^2 .. n^2 (zero for n = -1)
+    const double dn = static_cast<double>(n);
+
+    return dn * (dn + 1.0) * (2.0 * dn + 1.0) / 6.0;
+}
+
+static inline double sum_of_squares(const int first, const int last)
+{
+    // Sum of first^2..last^2 inclusive (frame coordinates are never negative)
+    assert(first >= 0);
+    return sum_of_squares_up_to(last) - sum_of_squares_up_to(first - 1);
+}
+
+static void blob_clear(RLEBlob &blob)
+{
+    blob.area = 0;
+    blob.min_x = INT_MAX;
+    blob.min_y = INT_MAX;
+    blob.max_x = INT_MIN;
+    blob.max_y = INT_MIN;
+    blob.m00 = blob.m10 = blob.m01 = 0.0;
+    blob.m20 = blob.m11 = blob.m02 = 0.0;
+}
+
+static void blob_add_run(RLEBlob &blob, const int x_start, const int x_end, const int y)
+{
+    const int n = x_end - x_start + 1;
+    const double dy = static_cast<double>(y);
+    const double sum_x = sum_of_integers(x_start, x_end);
+    const double sum_xx = sum_of_squares(x_start, x_end);
+
+    blob.area += n;
+    blob.min_x = std::min(blob.min_x, x_start);
+    blob.max_x = std::max(blob.max_x, x_end);
+    blob.min_y = std::min(blob.min_y, y);
+    blob.max_y = std::max(blob.max_y, y);
+    blob.m00 += static_cast<double>(n);
+    blob.m10 += sum_x;
+    blob.m01 += static_cast<double>(n) * dy;
+    blob.m20 += sum_xx;
+    blob.m11 += sum_x * dy;
+    blob.m02 += static_cast<double>(n) * dy * dy;
+}
+
+static void blob_merge(RLEBlob &blob, const RLEBlob &other)
+{
+    blob.area += other.area;
+    blob.min_x = std::min(blob.min_x, other.min_x);
+    blob.max_x = std::max(blob.max_x, other.max_x);
+    blob.min_y = std::min(blob.min_y, other.min_y);
+    blob.max_y = std::max(blob.max_y, other.max_y);
+    blob.m00 += other.m00;
+    blob.m10 += other.m10;
+    blob.m01 += other.m01;
+    blob.m20 += other.m20;
+    blob.m11 += other.m11;
+    blob.m02 += other.m02;
+}
+
+//-- public implementation -----
+RLEBlobExtractor::RLEBlobExtractor()
+{
+}
+
+void RLEBlobExtractor::reserve(int run_count, int blob_count)
+{
+    m_runs.reserve(run_count);
+    m_label_parent.reserve(run_count);
+    m_label_stats.reserve(run_count);
+    m_label_to_blob.reserve(run_count);
+    m_blobs.reserve(blob_count);
+    m_largest_blobs.reserve(blob_count);
+}
+
+int RLEBlobExtractor::extractBlobs(
+    const unsigned char *mask,
+    const int width, const int height, const int stride,
+    const int origin_x, const int origin_y)
+{
+    m_runs.clear();
+    m_label_parent.clear();
+    m_label_stats.clear();
+    m_blobs.clear();
+    m_largest_blobs.clear();
+
+    // Runs of the previous row are [prev_row_begin, prev_row_end) in m_runs
+    size_t prev_row_begin = 0;
+    size_t prev_row_end = 0;
+
+    for (int row = 0; row < height; ++row)
+    {
+        const unsigned char *row_pixels = mask + static_cast<size_t>(row) * static_cast<size_t>(stride);
+        const int y = origin_y + row;
+        const size_t row_begin = m_runs.size();
+        size_t prev_run_index = prev_row_begin;
+
+        int col = 0;
+        while (col < width)
+        {
+            // Skip background
+            while (col < width && row_pixels[col] == 0)
+            {
+                ++col;
+            }
+            if (col >= width)
+            {
+                break;
+            }
+
+            // Walk the run of foreground pixels
+            const int run_start = col;
+            while (col < width && row_pixels[col] != 0)
+            {
+                ++col;
+            }
+
+            Run run;
+            run.x_start = origin_x + run_start;
+            run.x_end = origin_x + col - 1;
+            run.y = y;
+            run.label = -1;
+
+            // Connect to every run on the previous row that touches this one (8-connectivity).
+            // Runs within a row are sorted, so skip the ones entirely to the left.
+            while (prev_run_index < prev_row_end && m_runs[prev_run_index].x_end + 1 < run.x_start)
+            {
+                ++prev_run_index;
+            }
+            for (size_t test_index = prev_run_index;
+                test_index < prev_row_end && m_runs[test_index].x_start <= run.x_end + 1;
+                ++test_index)
+            {
+                const int prev_label = m_runs[test_index].label;
+
+                if (run.label == -1)
+                {
+                    run.label = findRoot(prev_label);
+                }
+                else
+                {
+                    unionLabels(run.label, prev_label);
+                }
+            }
+
+            if (run.label == -1)
+            {
+                run.label = createLabel();
+            }
+
+            blob_add_run(m_label_stats[run.label], run.x_start, run.x_end, run.y);
+            m_runs.push_back(run);
+        }
+
+        prev_row_begin = row_begin;
+        prev_row_end = m_runs.size();
+    }
+
+    // Fold the stats of every merged label into its root and number the roots
+    const int label_count = static_cast<int>(m_label_parent.size());
+    m_label_to_blob.resize(label_count);
+    for (int label = 0; label < label_count; ++label)
+    {
+        const int root = findRoot(label);
+
+        if (root != label)
+        {
+            blob_merge(m_label_stats[root], m_label_stats[label]);
+            m_label_to_blob[label] = -1;
+        }
+    }
+    for (int label = 0; label < label_count; ++label)
+    {
+        if (m_label_parent[label] == label)
+        {
+            m_label_to_blob[label] = static_cast<int>(m_blobs.size());
+            m_blobs.push_back(m_label_stats[label]);
+        }
+    }
+    for (int label = 0; label < label_count; ++label)
+    {
+        m_label_to_blob[label] = m_label_to_blob[m_label_parent[label]];
+    }
+
+    return static_cast<int>(m_blobs.size());
+}
+
+int RLEBlobExtractor::computeLargestBlobs(const int max_count, const int min_area)
+{
+    m_largest_blobs.clear();
+
+    for (int blob_index = 0; blob_index < static_cast<int>(m_blobs.size()); ++blob_index)
+    {
+        if (m_blobs[blob_index].area >= min_area)
+        {
+            m_largest_blobs.push_back(blob_index);
+        }
+    }
+
+    const int keep_count = std::min(max_count, static_cast<int>(m_largest_blobs.size()));
+    std::partial_sort(
+        m_largest_blobs.begin(), m_largest_blobs.begin() + keep_count, m_largest_blobs.end(),
+        [this](const int a, const int b) {
+            return m_blobs[b].area < m_blobs[a].area;
+    });
+    m_largest_blobs.resize(keep_count);
+
+    return keep_count;
+}
+
+//-- private implementation -----
+int RLEBlobExtractor::createLabel()
+{
+    const int label = static_cast<int>(m_label_parent.size());
+    RLEBlob stats;
+
+    blob_clear(stats);
+    m_label_parent.push_back(label);
+    m_label_stats.push_back(stats);
+
+    return label;
+}
+
+int RLEBlobExtractor::findRoot(int label)
+{
+    int root = label;
+    while (m_label_parent[root] != root)
+    {
+        root = m_label_parent[root];
+    }
+
+    // Path compression
+    while (m_label_parent[label] != root)
+    {
+        const int next = m_label_parent[label];
+        m_label_parent[label] = root;
+        label = next;
+    }
+
+    return root;
+}
+
+void RLEBlobExtractor::unionLabels(int label_a, int label_b)
+{
+    const int root_a = findRoot(label_a);
+    const int root_b = findRoot(label_b);
+
+    // Always keep the older label as the root
+    if (root_a < root_b)
+    {
+        m_label_parent[root_b] = root_a;
+    }
+    else if (root_b < root_a)
+    {
+        m_label_parent[root_a] = root_b;
+    }
+}
+
+void RLEBlobExtractor::computeBlobRowExtents(int blob_index)
+{
+    const RLEBlob &blob = m_blobs[blob_index];
+    const int row_count = blob.max_y - blob.min_y + 1;
+
+    m_row_min_x.assign(row_count, INT_MAX);
+    m_row_max_x.assign(row_count, INT_MIN);
+
+    for (auto it = m_runs.begin(); it != m_runs.end(); ++it)
+    {
+        const Run &run = *it;
+
+        if (run.y >= blob.min_y && run.y <= blob.max_y &&
+            m_label_to_blob[run.label] == blob_index)
+        {
+            const int row = run.y - blob.min_y;
+
+            m_row_min_x[row] = std::min(m_row_min_x[row], run.x_start);
+            m_row_max_x[row] = std::max(m_row_max_x[row], run.x_end);
+        }
+    }
+}
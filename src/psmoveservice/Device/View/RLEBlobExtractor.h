@@ -0,0 +1,110 @@
+#ifndef RLE_BLOB_EXTRACTOR_H
+#define RLE_BLOB_EXTRACTOR_H
+
+//-- includes -----
+#include <vector>
+#include <climits>
+
+//-- definitions -----
+// Statistics for one 8-connected blob in a thresholded (0 / non-zero) mask.
+// All coordinates are in frame space (i.e. ROI origin already added).
+struct RLEBlob
+{
+    int area; // pixel count
+    int min_x, min_y;
+    int max_x, max_y;
+
+    // Raw image moments (sum of x^i*y^j over all blob pixels)
+    double m00, m10, m01, m20, m11, m02;
+
+    inline float getCenterX() const { return static_cast<float>(m10 / m00); }
+    inline float getCenterY() const { return static_cast<float>(m01 / m00); }
+};
+
+// Run-length-encoded connected component labeller.
+// Makes a single pass over the mask, collecting runs of foreground pixels and merging
+// overlapping runs of adjacent rows with a union-find. Area, bounding box and moments
+// are accumulated per run, so no second pass over the pixels is needed.
+// All working buffers are kept between calls, so steady-state extraction doesn't allocate.
+class RLEBlobExtractor
+{
+public:
+    RLEBlobExtractor();
+
+    // Pre-size the working buffers
+    void reserve(int run_count, int blob_count);
+
+    // Label every blob in the given mask.
+    // mask points at the first pixel of the (width x height) region, rows are stride bytes apart.
+    // (origin_x, origin_y) is the location of the region within the full frame.
+    // Returns the number of blobs found.
+    int extractBlobs(
+        const unsigned char *mask,
+        const int width, const int height, const int stride,
+        const int origin_x, const int origin_y);
+
+    // Sort the blobs from the last extraction by area and keep the largest max_count
+    // that have at least min_area pixels. Returns the number of blobs kept.
+    int computeLargestBlobs(const int max_count, const int min_area= 1);
+
+    inline int getBlobCount() const { return static_cast<int>(m_blobs.size()); }
+    inline const RLEBlob &getBlob(int blob_index) const { return m_blobs[blob_index]; }
+
+    inline int getLargestBlobCount() const { return static_cast<int>(m_largest_blobs.size()); }
+    inline const RLEBlob &getLargestBlob(int sorted_index) const { return m_blobs[m_largest_blobs[sorted_index]]; }
+
+    // Writes the outline of one of the largest blobs as a closed polygon:
+    // the left-most pixel of each row top to bottom, then the right-most pixel of each row bottom to top.
+    // For convex blobs this is the exact pixel boundary, otherwise it is the row-wise hull.
+    // t_point_type needs a (int x, int y) constructor (e.g. cv::Point).
+    template <typename t_point_type>
+    void computeLargestBlobOutline(int sorted_index, std::vector<t_point_type> &out_points)
+    {
+        const int blob_index = m_largest_blobs[sorted_index];
+        const RLEBlob &blob = m_blobs[blob_index];
+        const int row_count = blob.max_y - blob.min_y + 1;
+
+        computeBlobRowExtents(blob_index);
+
+        out_points.clear();
+        for (int row = 0; row < row_count; ++row)
+        {
+            if (m_row_min_x[row] != INT_MAX)
+            {
+                out_points.push_back(t_point_type(m_row_min_x[row], blob.min_y + row));
+            }
+        }
+        for (int row = row_count - 1; row >= 0; --row)
+        {
+            if (m_row_max_x[row] != INT_MIN && m_row_max_x[row] != m_row_min_x[row])
+            {
+                out_points.push_back(t_point_type(m_row_max_x[row], blob.min_y + row));
+            }
+        }
+    }
+
+private:
+    struct Run
+    {
+        int x_start; // frame space, inclusive
+        int x_end; // frame space, inclusive
+        int y; // frame space
+        int label;
+    };
+
+    int createLabel();
+    int findRoot(int label);
+    void unionLabels(int label_a, int label_b);
+    void computeBlobRowExtents(int blob_index);
+
+    std::vector<Run> m_runs;
+    std::vector<int> m_label_parent;
+    std::vector<RLEBlob> m_label_stats;
+    std::vector<int> m_label_to_blob;
+    std::vector<RLEBlob> m_blobs;
+    std::vector<int> m_largest_blobs;
+    std::vector<int> m_row_min_x;
+    std::vector<int> m_row_max_x;
+};
+
+#endif // RLE_BLOB_EXTRACTOR_H
@@ -8,6 +8,7 @@
 #include "MathAlignment.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
+#include "ServerStatistics.h"
 #include "CompoundPoseFilter.h"
 #include "KalmanPoseFilter.h"
 #include "PSDualShock4Controller.h"
@@ -124,6 +125,7 @@ ServerControllerView::ServerControllerView(const int device_id)
     , m_tracking_enabled(false)
     , m_roi_disable_count(0)
     , m_LED_override_active(false)
+    , m_LED_blink_dark(false)
     , m_device(nullptr)
     , m_tracker_pose_estimations(nullptr)
     , m_multicam_pose_estimation(nullptr)
@@ -315,13 +317,15 @@ bool ServerControllerView::open(const class DeviceEnumerator *enumerator)
         else
         {
             // Allocate a color from the list of remaining available color ids
-            eCommonTrackingColorID allocatedColorID= DeviceManager::getInstance()->m_tracker_manager->allocateTrackingColorID();
+            // (or one shared with other controllers when the colors ran out and blink codes are on)
+            eCommonTrackingColorID allocatedColorID= DeviceManager::getInstance()->m_tracker_manager->allocateTrackingColorID(true);
 
             // Attempt to assign the tracking color id to the controller
-            if (!m_device->setTrackingColorID(allocatedColorID))
+            if (allocatedColorID != eCommonTrackingColorID::INVALID_COLOR &&
+                !m_device->setTrackingColorID(allocatedColorID))
             {
                 // If the device can't be assigned a tracking color, release the color back to the pool
-                DeviceManager::getInstance()->m_tracker_manager->freeTrackingColorID(allocatedColorID);
+                DeviceManager::getInstance()->m_tracker_manager->freeTrackingColorID(allocatedColorID, this);
             }
         }
     }
@@ -342,10 +346,12 @@ void ServerControllerView::close()
     {
         if (tracking_color_id != eCommonTrackingColorID::INVALID_COLOR)
         {
-            DeviceManager::getInstance()->m_tracker_manager->freeTrackingColorID(tracking_color_id);
+            DeviceManager::getInstance()->m_tracker_manager->freeTrackingColorID(tracking_color_id, this);
         }
     }
 
+    m_LED_blink_dark = false;
+
     ServerDeviceView::close();
 }
 
@@ -453,13 +459,19 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
         int valid_projection_tracker_ids[TrackerManager::k_max_devices];
         int projections_found = 0;
 
+        // Trackers that fit the bulb on a new video frame this update (tracker pose refinement)
+        int fresh_sphere_tracker_ids[TrackerManager::k_max_devices];
+        CommonDevicePosition fresh_sphere_positions_cm[TrackerManager::k_max_devices];
+        int fresh_spheres_found = 0;
+
         CommonDeviceTrackingShape trackingShape;
         m_device->getTrackingShape(trackingShape);
         assert(trackingShape.shape_type != eCommonTrackingShapeType::INVALID_SHAPE);
 
         // Find the projection of the controller from the perspective of each tracker.
         // In the case of sphere projections, go ahead and compute the tracker relative position as well.
-        for (int tracker_id = 0; tracker_id < tracker_manager->getMaxDevices(); ++tracker_id)
+        // Estimates of trackers that closed were cleared by the tracker manager.
+        for (int tracker_id : tracker_manager->getOpenDeviceIds())
         {
             ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
             ControllerOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
@@ -504,6 +516,13 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
                             // Actually apply the pose estimate state
                             trackerPoseEstimateRef= newTrackerPoseEstimate;
                             trackerPoseEstimateRef.last_visible_timestamp = now;
+
+                            if (trackingShape.shape_type == eCommonTrackingShapeType::Sphere)
+                            {
+                                fresh_sphere_tracker_ids[fresh_spheres_found] = tracker_id;
+                                fresh_sphere_positions_cm[fresh_spheres_found] = trackerPoseEstimateRef.position_cm;
+                                ++fresh_spheres_found;
+                            }
                         }
                     }
 
@@ -534,6 +553,18 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
             trackerPoseEstimateRef.bCurrentlyTracking = bCurrentlyTracking;
         }
 
+        if (fresh_spheres_found > 1 && tracker_manager->getIsRecordingBundleAdjustment(getDeviceID()))
+        {
+            tracker_manager->addBundleAdjustmentSample(
+                fresh_sphere_tracker_ids, fresh_sphere_positions_cm, fresh_spheres_found);
+        }
+
+        if (fresh_spheres_found > 2)
+        {
+            tracker_manager->addDriftSample(
+                fresh_sphere_tracker_ids, fresh_sphere_positions_cm, fresh_spheres_found);
+        }
+
         // How we compute the final world pose estimate varies based on
         // * Number of trackers that currently have a valid projections of the controller
         // * The kind of projection shape (psmove sphere or ds4 lightbar)
@@ -654,6 +685,8 @@ void ServerControllerView::updateOpticalPoseEstimation(TrackerManager* tracker_m
 void 
 ServerControllerView::notifySensorDataReceived(const CommonDeviceState *sensor_state)
 {
+	StatScopedTimer stat_timer(_stat_stage_controller_sensor, getDeviceID());
+
     // Compute the time in seconds since the last update
     const t_high_resolution_timepoint now = std::chrono::high_resolution_clock::now();
 	t_high_resolution_duration durationSinceLastUpdate= t_high_resolution_duration::zero();
@@ -770,6 +803,8 @@ void ServerControllerView::updateStateAndPredict()
 		m_last_filter_update_timestamp_valid = true;
 
 		{
+			StatScopedTimer stat_timer(_stat_stage_controller_filter, getDeviceID());
+
 			PoseFilterPacket filter_packet;
 			filter_packet.clear();
 
@@ -996,6 +1031,15 @@ void ServerControllerView::clearLEDOverride()
     update_LED_color_internal();
 }
 
+void ServerControllerView::setLEDBlinkDark(bool bDark)
+{
+    if (m_LED_blink_dark != bDark)
+    {
+        m_LED_blink_dark = bDark;
+        update_LED_color_internal();
+    }
+}
+
 eCommonTrackingColorID ServerControllerView::getTrackingColorID() const
 {
     eCommonTrackingColorID tracking_color_id = eCommonTrackingColorID::INVALID_COLOR;
@@ -1109,7 +1153,7 @@ void ServerControllerView::update_LED_color_internal()
         g = std::get<1>(m_LED_override_color);
         b = std::get<2>(m_LED_override_color);
     }
-    else if (m_tracking_enabled)
+    else if (m_tracking_enabled && !m_LED_blink_dark)
     {
         r = std::get<0>(m_tracking_color);
         g = std::get<1>(m_tracking_color);
@@ -1222,6 +1266,8 @@ bool ServerControllerView::setControllerRumble(
 
 void ServerControllerView::publish_device_data_frame()
 {
+    StatScopedTimer stat_timer(_stat_stage_controller_publish, getDeviceID());
+
     // Tell the server request handler we want to send out controller updates.
     // This will call generate_controller_data_frame_for_stream for each listening connection.
     ServerRequestHandler::get_instance()->publish_controller_data_frame(
@@ -1376,7 +1422,7 @@ static void generate_psmove_data_frame_for_stream(
             int selectedTrackerId= stream_info->selected_tracker_index;
             unsigned int validTrackerBitmask= 0;
 
-            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+            for (int trackerId : DeviceManager::getInstance()->m_tracker_manager->getOpenDeviceIds())
             {
                 const ControllerOpticalPoseEstimation *positionEstimate= 
                     controller_view->getTrackerPoseEstimate(trackerId);
@@ -1622,7 +1668,7 @@ static void generate_psdualshock4_data_frame_for_stream(
             int selectedTrackerId= stream_info->selected_tracker_index;
             unsigned int validTrackerBitmask= 0;
 
-            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+            for (int trackerId : DeviceManager::getInstance()->m_tracker_manager->getOpenDeviceIds())
             {
                 const ControllerOpticalPoseEstimation *positionEstimate= 
                     controller_view->getTrackerPoseEstimate(trackerId);
@@ -1808,7 +1854,7 @@ static void generate_virtual_controller_data_frame_for_stream(
             int selectedTrackerId= stream_info->selected_tracker_index;
             unsigned int validTrackerBitmask= 0;
 
-            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+            for (int trackerId : DeviceManager::getInstance()->m_tracker_manager->getOpenDeviceIds())
             {
                 const ControllerOpticalPoseEstimation *positionEstimate= 
                     controller_view->getTrackerPoseEstimate(trackerId);
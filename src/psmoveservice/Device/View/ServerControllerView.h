@@ -142,6 +142,9 @@ public:
     // Returns true 
     inline bool getIsLEDOverrideActive() const { return m_LED_override_active; }
 
+    // Darkens the tracking color during this controller's blink code bit (see TrackerManager)
+    void setLEDBlinkDark(bool bDark);
+
     // Get the currently assigned tracking color ID for the controller
 	eCommonTrackingColorID getTrackingColorID() const;
 
@@ -179,6 +182,11 @@ public:
         return (m_tracker_pose_estimations != nullptr) ? &m_tracker_pose_estimations[trackerId] : nullptr;
     }
 
+    // Forget the pose estimate relative to a tracker that closed
+    inline void clearTrackerPoseEstimate(int trackerId) {
+        if (m_tracker_pose_estimations != nullptr) m_tracker_pose_estimations[trackerId].clear();
+    }
+
     // Get the pose estimate derived from multicam pose tracking
     inline const ControllerOpticalPoseEstimation *getMulticamPoseEstimate() const { 
         return m_multicam_pose_estimation; 
@@ -220,6 +228,7 @@ private:
     // Override color state
     std::tuple<unsigned char, unsigned char, unsigned char> m_LED_override_color;
     bool m_LED_override_active;
+    bool m_LED_blink_dark;
 
     // Device state
     IControllerInterface *m_device;
@@ -9,6 +9,7 @@
 #include "PSMoveProtocol.pb.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
+#include "ServerStatistics.h"
 #include "ServerTrackerView.h"
 #include "TrackerManager.h"
 
@@ -239,6 +240,14 @@ void ServerHMDView::close()
     ServerDeviceView::close();
 }
 
+bool ServerHMDView::poll()
+{
+    // Unlike the controllers, HMD sensor packets are read and parsed on the main thread
+    StatScopedTimer stat_timer(_stat_stage_hmd_sensor, getDeviceID());
+
+    return ServerDeviceView::poll();
+}
+
 void ServerHMDView::resetPoseFilter()
 {
 	assert(m_device != nullptr);
@@ -293,7 +302,8 @@ void ServerHMDView::updateOpticalPoseEstimation(TrackerManager* tracker_manager)
 
         // Find the projection of the controller from the perspective of each tracker.
         // In the case of sphere projections, go ahead and compute the tracker relative position as well.
-        for (int tracker_id = 0; tracker_id < tracker_manager->getMaxDevices(); ++tracker_id)
+        // Estimates of trackers that closed were cleared by the tracker manager.
+        for (int tracker_id : tracker_manager->getOpenDeviceIds())
         {
             ServerTrackerViewPtr tracker = tracker_manager->getTrackerViewPtr(tracker_id);
             HMDOpticalPoseEstimation &trackerPoseEstimateRef = m_tracker_pose_estimations[tracker_id];
@@ -487,6 +497,7 @@ void ServerHMDView::updateStateAndPredict()
 	// computing the new orientation along the way.
 	for (int lookBackIndex = firstLookBackIndex; lookBackIndex >= 0; --lookBackIndex)
 	{
+		StatScopedTimer stat_timer(_stat_stage_hmd_filter, getDeviceID());
 		const CommonHMDState *hmdState = getState(lookBackIndex);
 
 		switch (hmdState->DeviceType)
@@ -728,6 +739,8 @@ float ServerHMDView::getROIPredictionTime() const
 
 void ServerHMDView::publish_device_data_frame()
 {
+    StatScopedTimer stat_timer(_stat_stage_hmd_publish, getDeviceID());
+
     // Tell the server request handler we want to send out HMD updates.
     // This will call generate_hmd_data_frame_for_stream for each listening connection.
     ServerRequestHandler::get_instance()->publish_hmd_data_frame(
@@ -1208,7 +1221,7 @@ static void generate_morpheus_hmd_data_frame_for_stream(
             int selectedTrackerId= stream_info->selected_tracker_index;
             unsigned int validTrackerBitmask= 0;
 
-            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+            for (int trackerId : DeviceManager::getInstance()->m_tracker_manager->getOpenDeviceIds())
             {
 			    const HMDOpticalPoseEstimation *positionEstimate = hmd_view->getTrackerPoseEstimate(trackerId);
 
@@ -1327,7 +1340,7 @@ static void generate_virtual_hmd_data_frame_for_stream(
 			int selectedTrackerId= stream_info->selected_tracker_index;
             unsigned int validTrackerBitmask= 0;
 
-            for (int trackerId = 0; trackerId < TrackerManager::k_max_devices; ++trackerId)
+            for (int trackerId : DeviceManager::getInstance()->m_tracker_manager->getOpenDeviceIds())
             {
 			    const HMDOpticalPoseEstimation *positionEstimate = hmd_view->getTrackerPoseEstimate(trackerId);
 
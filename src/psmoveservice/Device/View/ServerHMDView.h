@@ -48,6 +48,7 @@ public:
 
     bool open(const class DeviceEnumerator *enumerator) override;
     void close() override;
+    bool poll() override;
 
 	// Recreate and initialize the pose filter for the HMD
 	void resetPoseFilter();
@@ -116,6 +117,11 @@ public:
 		return (m_tracker_pose_estimations != nullptr) ? &m_tracker_pose_estimations[trackerId] : nullptr;
 	}
 
+	// Forget the pose estimate relative to a tracker that closed
+	inline void clearTrackerPoseEstimate(int trackerId) {
+		if (m_tracker_pose_estimations != nullptr) m_tracker_pose_estimations[trackerId].clear();
+	}
+
 	// Get the pose estimate derived from multicam pose tracking
 	inline const HMDOpticalPoseEstimation *getMulticamPoseEstimate() const {
 		return m_multicam_pose_estimation;
@@ -1,4 +1,6 @@
 //-- includes -----
+#include "BlobAssignment.h"
+#include "ControllerManager.h"
 #include "DeviceEnumerator.h"
 #include "DeviceManager.h"
 #include "ServerTrackerView.h"
@@ -9,13 +11,21 @@
 #include "MathGLM.h"
 #include "MathAlignment.h"
 #include "PS3EyeTracker.h"
+#include "VirtualTracker.h"
+#include "RemoteTracker.h"
+#include "RemoteTrackerLink.h"
 #include "PSMoveProtocol.pb.h"
 #include "ServerUtility.h"
 #include "ServerLog.h"
 #include "ServerRequestHandler.h"
+#include "ServerStatistics.h"
+#include "ServerTrace.h"
 #include "SharedTrackerState.h"
 #include "TrackerManager.h"
 #include "PoseFilterInterface.h"
+#include "RLEBlobExtractor.h"
+#include "ScratchVectorList.h"
+#include "SubpixelEdge.h"
 
 #include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/mapped_region.hpp>
@@ -32,6 +42,34 @@
 //-- constants ----
 static const int k_min_roi_size= 32;
 
+// Initial sizing of the per-tracker contour scratch buffers.
+// They will still grow past this if a frame needs it, but only once.
+static const int k_scratch_contour_list_reserve= 16;
+static const int k_scratch_contour_point_reserve= 512;
+static const int k_scratch_blob_run_reserve= 4096;
+
+// Sphere edge refinement
+static const float k_edge_sample_step_px= 0.5f; // distance between intensity samples along a ray
+static const int k_max_edge_samples_per_ray= 64; // caps the search window at +/-16px
+static const int k_max_edge_refinement_rays= 128;
+static const int k_min_refined_edge_points= 8;
+static const float k_min_edge_gradient= 12.f; // summed BGR intensity change per pixel
+static const int k_edge_refinement_iterations= 5; // robust re-weighting rounds
+
+// Point cloud (Morpheus) pose solve
+static const float k_point_cloud_image_noise_px= 2.f; // expected LED centroid jitter
+static const int k_point_cloud_pose_iteration_budget= 200; // SoftPOSIT annealing steps per frame
+
+// Adaptive ROI search
+static const int k_max_roi_search_level= 3; // each missed frame doubles the window, up to 8x
+static const float k_roi_velocity_margin= 0.5f; // window padding per pixel of predicted motion
+static const float k_max_roi_prediction_seconds= 0.1f; // don't extrapolate the filter further than this
+
+// Global blob assignment
+static const float k_blob_assignment_radius_sigma_fraction= 0.5f; // prediction noise at rest, relative to the bulb's size
+static const float k_blob_assignment_motion_sigma_fraction= 0.5f; // extra noise per pixel of predicted motion
+static const int k_blob_assignment_extra_blobs= 2; // candidates beyond one per device, room for reflections
+
 //-- typedefs ----
 typedef std::vector<cv::Point> t_opencv_int_contour;
 typedef std::vector<t_opencv_int_contour> t_opencv_int_contour_list;
@@ -39,10 +77,17 @@ typedef std::vector<t_opencv_int_contour> t_opencv_int_contour_list;
 typedef std::vector<cv::Point2f> t_opencv_float_contour;
 typedef std::vector<t_opencv_float_contour> t_opencv_float_contour_list;
 
+typedef ScratchVectorList<cv::Point> t_opencv_int_contour_scratch_list;
+typedef ScratchVectorList<cv::Point2f> t_opencv_float_contour_scratch_list;
+
 //-- template utility methods
 template<typename t_opencv_contour_type>
 cv::Point2f computeSafeCenterOfMassForContour(const t_opencv_contour_type &contour);
 
+//-- utility methods
+static void convertIntContourToFloatContour(const t_opencv_int_contour &in_contour, t_opencv_float_contour &out_contour);
+static void convertFloatContourToEigenContour(const t_opencv_float_contour &in_contour, std::vector<Eigen::Vector2f> &out_contour);
+
 //-- private methods -----
 class SharedVideoFrameReadWriteAccessor
 {
@@ -332,6 +377,29 @@ private:
 OpenCVBGRToHSVMapper *OpenCVBGRToHSVMapper::m_instance = nullptr;
 int OpenCVBGRToHSVMapper::m_refCount= 0;
 
+// Per tracked device state of the adaptive ROI search on one tracker
+struct ROISearchState
+{
+    int search_level; // 0 = velocity scaled prediction window, +1 for every frame the device was missed
+    bool bSearching; // the device has been missed at least once since it was last found
+    std::chrono::time_point<std::chrono::high_resolution_clock> search_start_timestamp;
+    int search_frame_count;
+    int full_frame_scan_count;
+    double search_cost_total_ms;
+    double search_cost_max_ms;
+
+    inline void clear()
+    {
+        search_level= 0;
+        bSearching= false;
+        search_start_timestamp= std::chrono::time_point<std::chrono::high_resolution_clock>();
+        search_frame_count= 0;
+        full_frame_scan_count= 0;
+        search_cost_total_ms= 0.0;
+        search_cost_max_ms= 0.0;
+    }
+};
+
 class OpenCVBufferState
 {
 public:
@@ -342,6 +410,8 @@ public:
         , gsLowerBuffer(nullptr)
         , gsUpperBuffer(nullptr)
         , maskedBuffer(nullptr)
+        , rleBlobExtractor(nullptr)
+        , nodeSequenceNumber(0)
     {
         device->getVideoFrameDimensions(&frameWidth, &frameHeight, nullptr);
 
@@ -361,6 +431,45 @@ public:
         {
             bgr2hsv = nullptr;
         }
+
+        if (cfg.use_rle_blob_extractor)
+        {
+            rleBlobExtractor = new RLEBlobExtractor;
+            rleBlobExtractor->reserve(k_scratch_blob_run_reserve, k_scratch_contour_list_reserve);
+        }
+
+        // Size the contour scratch buffers up front so the tracking loop can reuse them
+        rawContours.reserve(k_scratch_contour_list_reserve);
+        sortedContours.reserve(k_scratch_contour_list_reserve);
+        biggestContours.reserve(k_scratch_contour_list_reserve, k_scratch_contour_point_reserve);
+        contourAreas.reserve(k_scratch_contour_list_reserve);
+        convexContour.reserve(k_scratch_contour_point_reserve);
+        floatContour.reserve(k_scratch_contour_point_reserve);
+        undistortedContour.reserve(k_scratch_contour_point_reserve);
+        undistortedContours.reserve(k_scratch_contour_list_reserve, k_scratch_contour_point_reserve);
+        eigenContour.reserve(k_scratch_contour_point_reserve);
+        refinedEdgeContour.reserve(k_max_edge_refinement_rays);
+        refinedEdgeWeights.reserve(k_max_edge_refinement_rays);
+        nodeFramePoints.reserve(k_scratch_contour_point_reserve);
+
+        for (int controller_id = 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+        {
+            controllerROISearchStates[controller_id].clear();
+        }
+        for (int hmd_id = 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)
+        {
+            hmdROISearchStates[hmd_id].clear();
+        }
+        for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+        {
+            blinkCodeColorStates[color_index].generation= -1;
+            blinkCodeColorStates[color_index].bFrameSearched= false;
+        }
+        for (int controller_id = 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+        {
+            controllerBlobAssignments[controller_id].bAssigned= false;
+            controllerBlobAssignments[controller_id].contour.reserve(k_scratch_contour_point_reserve);
+        }
         
         //Apply default ROI (full frame).
         applyROI(cv::Rect2i(cv::Point(0,0), cv::Size(frameWidth, frameHeight)));
@@ -402,6 +511,11 @@ public:
         {
             OpenCVBGRToHSVMapper::dispose(bgr2hsv);
         }
+
+        if (rleBlobExtractor != nullptr)
+        {
+            delete rleBlobExtractor;
+        }
     }
 
     void writeVideoFrame(const unsigned char *video_buffer)
@@ -468,9 +582,11 @@ public:
 
     // Return points in raw image space:
     // i.e. [0, 0] at lower left  to [frameWidth-1, frameHeight-1] at lower right
+    // The output lists are expected to be the scratch lists below (or other long lived lists)
+    // so that their buffers get reused from frame to frame.
     bool computeBiggestNContours(
         const CommonHSVColorRange &hsvColorRange,
-        t_opencv_int_contour_list &out_biggest_N_contours,
+        t_opencv_int_contour_scratch_list &out_biggest_N_contours,
         std::vector<double> &out_contour_areas,
         const int max_contour_count,
         const int min_points_in_contour = 6)
@@ -527,74 +643,73 @@ public:
         
         //TODO: Why no blurring of the gsLowerBuffer?
 
-        // Find the largest convex blob in the filtered grayscale buffer
+        // Find the largest blobs in the filtered grayscale buffer
+        if (rleBlobExtractor != nullptr)
+        {
+            computeBiggestNBlobOutlines(out_biggest_N_contours, out_contour_areas, max_contour_count, min_points_in_contour);
+        }
+        else
         {
-            struct ContourInfo
-            {
-                int contour_index;
-                double contour_area;
-            };
-            std::vector<ContourInfo> sorted_contour_list;
-
             // Find all counters in the image buffer
+            // NOTE: findContours resizes rawContours in place, 
+            // so the inner point buffers are reused whenever the contour count is stable
             cv::Size size; cv::Point ofs;
             gsLowerROI.locateROI(size, ofs);
-            t_opencv_int_contour_list contours;
             cv::findContours(gsLowerROI,
-                             contours,
+                             rawContours,
                              CV_RETR_EXTERNAL,
                              CV_CHAIN_APPROX_SIMPLE,  //CV_CHAIN_APPROX_NONE?
                              ofs);
 
             // Compute the area of each contour
+            sortedContours.clear();
             int contour_index = 0;
-            for (auto it = contours.begin(); it != contours.end(); ++it) 
+            for (auto it = rawContours.begin(); it != rawContours.end(); ++it) 
             {
                 const double contour_area = cv::contourArea(*it);
                 const ContourInfo contour_info = { contour_index, contour_area };
 
-                sorted_contour_list.push_back(contour_info);
+                sortedContours.push_back(contour_info);
                 ++contour_index;
             }
             
             // Sort the list of contours by area, largest to smallest
-            if (sorted_contour_list.size() > 1)
+            if (sortedContours.size() > 1)
             {
                 std::sort(
-                    sorted_contour_list.begin(), sorted_contour_list.end(), 
+                    sortedContours.begin(), sortedContours.end(), 
                     [](const ContourInfo &a, const ContourInfo &b) {
                         return b.contour_area < a.contour_area;
                 });
             }
 
             // Copy up to N valid contours
-            for (auto it = sorted_contour_list.begin(); 
-                it != sorted_contour_list.end() && static_cast<int>(out_biggest_N_contours.size()) < max_contour_count; 
+            const int max_x = frameWidth - 1;
+            const int max_y = frameHeight - 1;
+            for (auto it = sortedContours.begin(); 
+                it != sortedContours.end() && static_cast<int>(out_biggest_N_contours.size()) < max_contour_count; 
                 ++it)
             {
                 const ContourInfo &contour_info = *it;
-                t_opencv_int_contour &contour = contours[contour_info.contour_index];
+                t_opencv_int_contour &contour = rawContours[contour_info.contour_index];
 
                 if (contour.size() > min_points_in_contour)
                 {
-                    // Remove any points in contour on edge of camera/ROI
+                    // Remove any points in contour on edge of camera/ROI.
+                    // Compacts the contour in a single pass rather than erasing point by point.
                     // TODO: Contours touching image border will be clipped,
                     // so this might not be necessary.
-                    t_opencv_int_contour::iterator it = contour.begin();
-                    while (it != contour.end()) 
-                    {
-                        if (it->x == 0 || it->x == (frameWidth - 1) || it->y == 0 || it->y == (frameHeight - 1))
-                        {
-                            it = contour.erase(it);
-                        }
-                        else
-                        {
-                            ++it;
-                        }
-                    }
+                    contour.erase(
+                        std::remove_if(
+                            contour.begin(), contour.end(),
+                            [max_x, max_y](const cv::Point &p) {
+                                return p.x == 0 || p.x == max_x || p.y == 0 || p.y == max_y;
+                        }),
+                        contour.end());
 
                     // Add cleaned up contour to the output list
-                    out_biggest_N_contours.push_back(contour);
+                    t_opencv_int_contour &out_contour = out_biggest_N_contours.push_back();
+                    out_contour.assign(contour.begin(), contour.end());
                     // Add its area to the output list too.
                     out_contour_areas.push_back(contour_info.contour_area);
                 }
@@ -603,19 +718,333 @@ public:
 
         return (out_biggest_N_contours.size() > 0);
     }
+
+    // True if the blobs of a blink coded color were already found in the given frame,
+    // so the controllers sharing the color after the first can skip the full frame HSV conversion
+    bool getIsBlinkCodeSearchCached(
+        const eCommonTrackingColorID color_id,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp) const
+    {
+        const TrackerManager *tracker_manager= DeviceManager::getInstance()->m_tracker_manager;
+        const BlinkCodeColorState &state= blinkCodeColorStates[color_id];
+
+        return state.bFrameSearched &&
+            state.frame_timestamp == frame_timestamp &&
+            state.generation == tracker_manager->getLEDBlinkCodeGeneration(color_id);
+    }
+
+    // Finds the contour of the controller with the given blink code slot among
+    // the blobs of a tracking color several controllers share.
+    // The full frame is searched once per video frame for every blob of the color
+    // and the identifier works out which blob is whose from the dark bits of each code.
+    bool computeBlinkCodedContour(
+        const CommonHSVColorRange &hsvColorRange,
+        const eCommonTrackingColorID color_id,
+        const int blink_code_slot,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp,
+        t_opencv_int_contour_scratch_list &out_biggest_contours,
+        std::vector<double> &out_contour_areas)
+    {
+        const TrackerManager *tracker_manager= DeviceManager::getInstance()->m_tracker_manager;
+        BlinkCodeColorState &state= blinkCodeColorStates[color_id];
+        const int generation= tracker_manager->getLEDBlinkCodeGeneration(color_id);
+
+        // Start over when the controllers sharing the color change
+        if (state.generation != generation)
+        {
+            state.identifier.reset();
+            state.generation= generation;
+            state.bFrameSearched= false;
+        }
+
+        if (!state.bFrameSearched || state.frame_timestamp != frame_timestamp)
+        {
+            // One extra blob leaves room for a reflection without losing a bulb
+            const int max_blob_count= tracker_manager->getLEDBlinkCodeGroupSize(color_id) + 1;
+
+            computeBiggestNContours(hsvColorRange, state.contours, state.contour_areas, max_blob_count);
+
+            state.blobs.clear();
+            for (size_t contour_index = 0; contour_index < state.contours.size(); ++contour_index)
+            {
+                cv::Point2f center;
+                float radius;
+                cv::minEnclosingCircle(state.contours[contour_index], center, radius);
+
+                LEDBlinkCodeBlob blob;
+                blob.center= Eigen::Vector2f(center.x, center.y);
+                blob.radius= radius;
+                state.blobs.push_back(blob);
+            }
+
+            state.blob_slots.resize(state.blobs.size());
+            state.identifier.addFrame(
+                tracker_manager->getLEDBlinkCodeTiming(), frame_timestamp,
+                state.blobs.data(), static_cast<int>(state.blobs.size()), state.blob_slots.data());
+
+            state.frame_timestamp= frame_timestamp;
+            state.bFrameSearched= true;
+        }
+
+        out_biggest_contours.clear();
+        out_contour_areas.clear();
+        for (size_t blob_index = 0; blob_index < state.blob_slots.size(); ++blob_index)
+        {
+            if (state.blob_slots[blob_index] == blink_code_slot)
+            {
+                const t_opencv_int_contour &contour= state.contours[blob_index];
+
+                out_biggest_contours.push_back().assign(contour.begin(), contour.end());
+                out_contour_areas.push_back(state.contour_areas[blob_index]);
+                break;
+            }
+        }
+
+        return (out_biggest_contours.size() > 0);
+    }
+
+    // The blob assigned to the controller in the given frame, nullptr if it wasn't given one
+    const ControllerBlobAssignment *getControllerBlobAssignment(
+        const int controller_id,
+        const std::chrono::time_point<std::chrono::high_resolution_clock> &frame_timestamp) const
+    {
+        const ControllerBlobAssignment &assignment= controllerBlobAssignments[controller_id];
+
+        return (assignment.bAssigned && assignment.frame_timestamp == frame_timestamp) ? &assignment : nullptr;
+    }
+
+    // Alternative to findContours used when the RLE blob extractor is enabled.
+    // Labels the thresholded ROI in a single pass and only traces outlines for the winning blobs.
+    void computeBiggestNBlobOutlines(
+        t_opencv_int_contour_scratch_list &out_biggest_N_contours,
+        std::vector<double> &out_contour_areas,
+        const int max_contour_count,
+        const int min_points_in_contour)
+    {
+        cv::Size size; cv::Point ofs;
+        gsLowerROI.locateROI(size, ofs);
+
+        rleBlobExtractor->extractBlobs(
+            gsLowerROI.data, gsLowerROI.cols, gsLowerROI.rows, static_cast<int>(gsLowerROI.step), 
+            ofs.x, ofs.y);
+
+        // Every outline point is a distinct pixel of the blob, so an outline with more than
+        // min_points_in_contour points needs at least min_points_in_contour + 1 pixels of area.
+        // Blobs smaller than that would fail the same point count check the findContours path makes.
+        const int min_blob_area = min_points_in_contour + 1;
+
+        // Ask for every blob big enough to have a usable outline, biggest first,
+        // since some may still be dropped after the border filter below
+        const int blob_count = rleBlobExtractor->computeLargestBlobs(rleBlobExtractor->getBlobCount(), min_blob_area);
+
+        const int max_x = frameWidth - 1;
+        const int max_y = frameHeight - 1;
+        for (int blob_index = 0; 
+            blob_index < blob_count && static_cast<int>(out_biggest_N_contours.size()) < max_contour_count; 
+            ++blob_index)
+        {
+            t_opencv_int_contour &out_contour = out_biggest_N_contours.push_back();
+            rleBlobExtractor->computeLargestBlobOutline(blob_index, out_contour);
+
+            if (out_contour.size() > min_points_in_contour)
+            {
+                // Same frame border filtering as the findContours path
+                out_contour.erase(
+                    std::remove_if(
+                        out_contour.begin(), out_contour.end(),
+                        [max_x, max_y](const cv::Point &p) {
+                            return p.x == 0 || p.x == max_x || p.y == 0 || p.y == max_y;
+                    }),
+                    out_contour.end());
+
+                out_contour_areas.push_back(static_cast<double>(rleBlobExtractor->getLargestBlob(blob_index).area));
+            }
+            else
+            {
+                out_biggest_N_contours.pop_back();
+            }
+        }
+    }
     
+    // Re-fit a sphere using subpixel edge points instead of the integer convex hull.
+    // Rays are cast from the hull's center of mass; along each ray the BGR intensity
+    // is sampled around the hull boundary and the strongest bright-to-dark transition
+    // is located to subpixel precision with a parabolic fit. The edge points are then
+    // undistorted and fed to the robust cone fit, weighted by edge strength.
+    // Cost is bounded by ray_count * (2*search_px / k_edge_sample_step_px) bilinear samples.
+    // Returns false (leaving the outputs alone) if not enough clean edges were found.
+    bool refineSphereFit(
+        const t_opencv_int_contour &convex_contour,
+        const cv::Matx33f &camera_matrix,
+        const cv::Matx<float, 5, 1> &distortions,
+        const float sphere_radius,
+        const int ray_count,
+        const float search_px,
+        Eigen::Vector3f *in_out_sphere_center,
+        EigenFitEllipse *in_out_ellipse_projection)
+    {
+        const int safe_ray_count = std::min(std::max(ray_count, k_min_refined_edge_points), k_max_edge_refinement_rays);
+        const int half_sample_count = 
+            std::min(static_cast<int>(search_px / k_edge_sample_step_px), k_max_edge_samples_per_ray / 2 - 1);
+        const int sample_count = 2 * half_sample_count + 1;
+        const cv::Point2f origin = computeSafeCenterOfMassForContour<t_opencv_int_contour>(convex_contour);
+
+        if (convex_contour.size() < 3 || half_sample_count < 2)
+        {
+            return false;
+        }
+
+        refinedEdgeContour.clear();
+        refinedEdgeWeights.clear();
+
+        for (int ray_index = 0; ray_index < safe_ray_count; ++ray_index)
+        {
+            const float angle = k_real_two_pi * static_cast<float>(ray_index) / static_cast<float>(safe_ray_count);
+            const cv::Point2f direction(cosf(angle), sinf(angle));
+
+            // Where does the ray leave the (integer) hull?
+            const float hull_radius = computeConvexContourRayExit(convex_contour, origin, direction);
+            if (hull_radius <= 0.f)
+            {
+                continue;
+            }
+
+            // Sample the intensity profile across the hull boundary
+            float intensity[k_max_edge_samples_per_ray];
+            bool bInBounds = true;
+            for (int sample_index = 0; bInBounds && sample_index < sample_count; ++sample_index)
+            {
+                const float t = hull_radius + static_cast<float>(sample_index - half_sample_count) * k_edge_sample_step_px;
+
+                bInBounds = sampleBGRIntensity(origin + direction * t, intensity[sample_index]);
+            }
+            if (!bInBounds)
+            {
+                continue;
+            }
+
+            // Find the steepest falloff (bulb is brighter than the background)
+            float edge_index;
+            float edge_gradient;
+            if (!find_subpixel_falling_edge(
+                    intensity, sample_count, k_edge_sample_step_px, k_min_edge_gradient, 
+                    edge_index, edge_gradient))
+            {
+                continue;
+            }
+
+            const float edge_t = 
+                hull_radius + (edge_index - static_cast<float>(half_sample_count)) * k_edge_sample_step_px;
+
+            refinedEdgeContour.push_back(origin + direction * edge_t);
+            refinedEdgeWeights.push_back(edge_gradient);
+        }
+
+        if (static_cast<int>(refinedEdgeContour.size()) < k_min_refined_edge_points)
+        {
+            return false;
+        }
+
+        // Same normalized space as the hull based fit
+        cv::undistortPoints(refinedEdgeContour, undistortedContour, camera_matrix, distortions);
+        convertFloatContourToEigenContour(undistortedContour, eigenContour);
+
+        Eigen::Vector3f sphere_center;
+        EigenFitEllipse ellipse_projection;
+        const bool bFitOk=
+            eigen_alignment_fit_focal_cone_to_sphere_robust(
+                eigenContour.data(),
+                refinedEdgeWeights.data(),
+                static_cast<int>(eigenContour.size()),
+                sphere_radius,
+                1,
+                k_edge_refinement_iterations,
+                &sphere_center,
+                &ellipse_projection);
+
+        if (bFitOk && ellipse_projection.area > k_real_epsilon)
+        {
+            *in_out_sphere_center = sphere_center;
+            *in_out_ellipse_projection = ellipse_projection;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Sum of the B, G and R channels at a subpixel location (bilinear)
+    bool sampleBGRIntensity(const cv::Point2f &location, float &out_intensity) const
+    {
+        const int x0 = static_cast<int>(floorf(location.x));
+        const int y0 = static_cast<int>(floorf(location.y));
+
+        if (x0 < 0 || y0 < 0 || x0 + 1 >= frameWidth || y0 + 1 >= frameHeight)
+        {
+            return false;
+        }
+
+        const float fx = location.x - static_cast<float>(x0);
+        const float fy = location.y - static_cast<float>(y0);
+        const unsigned char *row0 = bgrBuffer->ptr<unsigned char>(y0) + x0 * 3;
+        const unsigned char *row1 = bgrBuffer->ptr<unsigned char>(y0 + 1) + x0 * 3;
+        const float i00 = static_cast<float>(row0[0] + row0[1] + row0[2]);
+        const float i10 = static_cast<float>(row0[3] + row0[4] + row0[5]);
+        const float i01 = static_cast<float>(row1[0] + row1[1] + row1[2]);
+        const float i11 = static_cast<float>(row1[3] + row1[4] + row1[5]);
+
+        out_intensity = 
+            (1.f - fy) * ((1.f - fx) * i00 + fx * i10) + 
+            fy * ((1.f - fx) * i01 + fx * i11);
+
+        return true;
+    }
+
+    // Distance along a ray from an interior point to where it exits a convex polygon (or -1)
+    static float computeConvexContourRayExit(
+        const t_opencv_int_contour &convex_contour,
+        const cv::Point2f &origin,
+        const cv::Point2f &direction)
+    {
+        float best_t = -1.f;
+        const size_t point_count = convex_contour.size();
+
+        for (size_t point_index = 0; point_index < point_count; ++point_index)
+        {
+            const cv::Point2f p0(convex_contour[point_index]);
+            const cv::Point2f p1(convex_contour[(point_index + 1) % point_count]);
+            const cv::Point2f edge = p1 - p0;
+            const float denom = direction.cross(edge);
+
+            if (fabsf(denom) > k_real_epsilon)
+            {
+                const cv::Point2f to_p0 = p0 - origin;
+                const float t = to_p0.cross(edge) / denom;
+                const float s = to_p0.cross(direction) / denom;
+
+                if (t > 0.f && s >= 0.f && s <= 1.f)
+                {
+                    best_t = std::max(best_t, t);
+                }
+            }
+        }
+
+        return best_t;
+    }
+
     void
     draw_contour(const t_opencv_int_contour &contour)
     {
         // Draws the contour directly onto the shared mem buffer.
         // This is useful for debugging
-        std::vector<t_opencv_int_contour> contours = {contour};
+        // (polylines on the raw point array avoids building a temporary contour list)
+        const cv::Point *contour_points = contour.data();
+        const int contour_point_count = static_cast<int>(contour.size());
         const cv::Point2f massCenter = computeSafeCenterOfMassForContour<t_opencv_int_contour>(contour);
-        cv::drawContours(*bgrShmemBuffer, contours, 0, cv::Scalar(255, 255, 255));
-        cv::rectangle(*bgrShmemBuffer, cv::boundingRect(contour), cv::Scalar(255, 255, 255));
+        const cv::Rect bounding_rect = cv::boundingRect(contour);
+        cv::polylines(*bgrShmemBuffer, &contour_points, &contour_point_count, 1, true, cv::Scalar(255, 255, 255));
+        cv::rectangle(*bgrShmemBuffer, bounding_rect, cv::Scalar(255, 255, 255));
         cv::drawMarker(*bgrShmemBuffer, massCenter, cv::Scalar(255, 255, 255), 0,
-            (cv::boundingRect(contour).height < cv::boundingRect(contour).width) ?
-            cv::boundingRect(contour).height : cv::boundingRect(contour).width);
+            (bounding_rect.height < bounding_rect.width) ? bounding_rect.height : bounding_rect.width);
     }
     
     void
@@ -698,6 +1127,65 @@ public:
     int frameWidth;
     int frameHeight;
 
+    // Per-tracker contour scratch buffers.
+    // Cleared, never freed, between frames so steady state blob extraction doesn't hit the heap.
+    struct ContourInfo
+    {
+        int contour_index;
+        double contour_area;
+    };
+    t_opencv_int_contour_list rawContours;
+    std::vector<ContourInfo> sortedContours;
+    t_opencv_int_contour_scratch_list biggestContours;
+    std::vector<double> contourAreas;
+    t_opencv_int_contour convexContour;
+    t_opencv_float_contour floatContour;
+    t_opencv_float_contour undistortedContour;
+    t_opencv_float_contour_scratch_list undistortedContours;
+    std::vector<Eigen::Vector2f> eigenContour;
+    t_opencv_float_contour refinedEdgeContour;
+    std::vector<float> refinedEdgeWeights;
+
+    // Adaptive ROI search state for each device this tracker looks for
+    ROISearchState controllerROISearchStates[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    ROISearchState hmdROISearchStates[PSMOVESERVICE_MAX_HMD_COUNT];
+
+    // Blobs of each tracking color shared by blink coded controllers (see LEDBlinkCode.h)
+    struct BlinkCodeColorState
+    {
+        LEDBlinkCodeIdentifier identifier;
+        int generation; // TrackerManager blink code generation the identifier was built for
+        bool bFrameSearched;
+        std::chrono::time_point<std::chrono::high_resolution_clock> frame_timestamp; // frame the blobs below came from
+        t_opencv_int_contour_scratch_list contours;
+        std::vector<double> contour_areas;
+        std::vector<LEDBlinkCodeBlob> blobs;
+        std::vector<int> blob_slots;
+    };
+    BlinkCodeColorState blinkCodeColorStates[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES];
+
+    // Blob picked for each controller by ServerTrackerView::computeControllerBlobAssignment()
+    struct ControllerBlobAssignment
+    {
+        bool bAssigned;
+        std::chrono::time_point<std::chrono::high_resolution_clock> frame_timestamp; // frame the blob came from
+        cv::Rect2i search_roi;
+        t_opencv_int_contour contour;
+        double contour_area;
+    };
+    ControllerBlobAssignment controllerBlobAssignments[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+
+    // Blob outlines sent to the central host when running as a tracker node (see RemoteTracker.h)
+    RemoteTrackerFrame nodeFrame;
+    std::vector<RemoteTrackerPoint> nodeFramePoints;
+    unsigned int nodeSequenceNumber;
+    BlobAssignmentSolver blobAssignmentSolver;
+    std::vector<BlobAssignmentPrediction> blobAssignmentPredictions;
+    std::vector<BlobAssignmentCandidate> blobAssignmentCandidates;
+    std::vector<float> blobAssignmentCosts;
+    std::vector<int> blobAssignmentControllerIds;
+    std::vector<int> blobAssignmentIndices;
+
     cv::Mat *bgrBuffer; // source video frame
     cv::Mat *bgrShmemBuffer; //Frame onto which we draw debug lines, and transmit via shared mem.
     cv::Mat bgrROI;
@@ -709,6 +1197,7 @@ public:
     cv::Mat gsUpperROI;
     cv::Mat *maskedBuffer; // bgr image ANDed together with grayscale mask
     OpenCVBGRToHSVMapper *bgr2hsv; // Used to convert an rgb image to an hsv image
+    RLEBlobExtractor *rleBlobExtractor; // Used instead of findContours when enabled in the config
 };
 
 // -- Utility Methods -----
@@ -734,15 +1223,44 @@ static bool computeTrackerRelativeLightBarPose(
 static bool computeTrackerRelativePointCloudContourPose(
     const ITrackerInterface *tracker_device,
     const CommonDeviceTrackingShape *tracking_shape,
-    const t_opencv_float_contour_list &opencv_contours,
+    const t_opencv_float_contour_scratch_list &opencv_contours,
     const CommonDevicePose *tracker_relative_pose_guess,
     HMDOpticalPoseEstimation *out_pose_estimate);
+static void refineSphereFitIfEnabled(
+    OpenCVBufferState *buffer_state,
+    const TrackerManagerConfig &trackerMgrConfig,
+    const cv::Matx33f &camera_matrix,
+    const cv::Matx<float, 5, 1> &distortions,
+    const float sphere_radius,
+    Eigen::Vector3f *in_out_sphere_center,
+    EigenFitEllipse *in_out_ellipse_projection);
+static float computeTrackingShapeBoundingRadius(
+    const CommonDeviceTrackingShape *tracking_shape);
+static CommonDeviceScreenLocation computeProjectionPixelCenter(
+    const CommonDeviceTrackingProjection *projection);
+static bool computeControllerBlobPrediction(
+    const ServerTrackerView *tracker,
+    const ServerControllerView *controller,
+    const CommonDeviceTrackingShape *tracking_shape,
+    const CommonDeviceTrackingProjection *prior_tracking_projection,
+    BlobAssignmentPrediction &out_prediction,
+    cv::Rect2i &out_search_roi);
 static cv::Rect2i computeTrackerROIForPoseProjection(
     const bool disabled_roi,
     const ServerTrackerView *tracker,
     const IPoseFilter* pose_filter,
     const CommonDeviceTrackingProjection *prior_tracking_projection,
-    const CommonDeviceTrackingShape *tracking_shape);
+    const CommonDeviceTrackingShape *tracking_shape,
+    const ROISearchState *roi_search_state= nullptr,
+    const bool allow_full_frame_scan= true);
+static void updateROISearchState(
+    const ServerTrackerView *tracker,
+    const char *device_type,
+    const int device_id,
+    const bool found_device,
+    const cv::Rect2i &searched_roi,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &search_start,
+    ROISearchState *roi_search_state);
 static bool computeBestFitTriangleForContour(
     const t_opencv_float_contour &opencv_contour,
     cv::Point2f &out_triangle_top,
@@ -883,6 +1401,8 @@ void ServerTrackerView::stopSharedMemoryVideoStream()
 
 bool ServerTrackerView::poll()
 {
+    StatScopedTimer stat_timer(_stat_stage_tracker_frame_grab, getDeviceID());
+    SERVER_TRACE_DEVICE_SCOPE("ServerTrackerView::poll", getDeviceID());
     bool bSuccess = ServerDeviceView::poll();
 
     if (bSuccess && m_device != nullptr)
@@ -910,6 +1430,14 @@ bool ServerTrackerView::allocate_device_interface(const class DeviceEnumerator *
     {
         m_device = new PS3EyeTracker();
     } break;
+    case CommonDeviceState::VirtualTracker:
+    {
+        m_device = new VirtualTracker();
+    } break;
+    case CommonDeviceState::RemoteTracker:
+    {
+        m_device = new RemoteTracker();
+    } break;
     default:
         break;
     }
@@ -931,6 +1459,9 @@ void ServerTrackerView::free_device_interface()
 
 void ServerTrackerView::publish_device_data_frame()
 {
+    StatScopedTimer stat_timer(_stat_stage_tracker_publish, getDeviceID());
+    SERVER_TRACE_DEVICE_SCOPE("ServerTrackerView::publish", getDeviceID());
+
     // Copy the video frame to shared memory (if requested)
     if (m_shared_memory_accesor != nullptr && m_shared_memory_video_stream_count > 0)
     {
@@ -961,6 +1492,12 @@ void ServerTrackerView::generate_tracker_data_frame_for_stream(
         {
             //TODO: PS3EYE tracker location
         } break;
+    case CommonDeviceState::VirtualTracker:
+        {
+        } break;
+    case CommonDeviceState::RemoteTracker:
+        {
+        } break;
     default:
         assert(0 && "Unhandled Tracker type");
     }
@@ -968,6 +1505,68 @@ void ServerTrackerView::generate_tracker_data_frame_for_stream(
     data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame::TRACKER);
 }
 
+void ServerTrackerView::sendBlobObservations(const int node_camera_id, const int max_blobs_per_color)
+{
+    SERVER_TRACE_DEVICE_SCOPE("ServerTrackerView::sendBlobObservations", getDeviceID());
+
+    if (m_opencv_buffer_state == nullptr)
+    {
+        return;
+    }
+
+    OpenCVBufferState *state= m_opencv_buffer_state;
+    RemoteTrackerFrame &frame= state->nodeFrame;
+    const std::chrono::duration<double, std::micro> capture_age= 
+        std::chrono::high_resolution_clock::now() - getLastNewDataTimestamp();
+
+    frame.clear();
+    frame.camera_id= node_camera_id;
+    frame.sequence_number= state->nodeSequenceNumber++;
+    frame.capture_age_us= static_cast<unsigned int>(std::max(capture_age.count(), 0.0));
+    frame.frame_width= state->frameWidth;
+    frame.frame_height= state->frameHeight;
+    m_device->getCameraIntrinsics(
+        frame.intrinsics.focal_length_x, frame.intrinsics.focal_length_y,
+        frame.intrinsics.principal_x, frame.intrinsics.principal_y,
+        frame.intrinsics.distortion_k1, frame.intrinsics.distortion_k2, frame.intrinsics.distortion_k3,
+        frame.intrinsics.distortion_p1, frame.intrinsics.distortion_p2);
+
+    // The node has no controllers of its own, so search the full frame for every color it has a preset for.
+    // The central host matches the blobs to controllers the same way it does for its own cameras.
+    state->applyROI(cv::Rect2i(cv::Point(0, 0), cv::Size(state->frameWidth, state->frameHeight)));
+
+    for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+    {
+        CommonHSVColorRange hsvColorRange;
+        m_device->getTrackingColorPreset("", static_cast<eCommonTrackingColorID>(color_index), &hsvColorRange);
+
+        state->computeBiggestNContours(hsvColorRange, state->biggestContours, state->contourAreas, max_blobs_per_color);
+
+        for (size_t contour_index = 0; contour_index < state->biggestContours.size(); ++contour_index)
+        {
+            // The convex hull is all the pose fitting needs and is a fraction of the outline's points
+            cv::convexHull(state->biggestContours[contour_index], state->convexContour);
+
+            state->nodeFramePoints.clear();
+            for (const cv::Point &point : state->convexContour)
+            {
+                RemoteTrackerPoint remote_point;
+                remote_point.x= static_cast<short>(point.x);
+                remote_point.y= static_cast<short>(point.y);
+                state->nodeFramePoints.push_back(remote_point);
+            }
+
+            frame.addBlob(
+                color_index, 
+                static_cast<float>(state->contourAreas[contour_index]),
+                state->nodeFramePoints.data(), 
+                static_cast<int>(state->nodeFramePoints.size()));
+        }
+    }
+
+    RemoteTrackerLink::getInstance()->sendFrame(frame);
+}
+
 void ServerTrackerView::loadSettings()
 {
     m_device->loadSettings();
@@ -1234,20 +1833,152 @@ void ServerTrackerView::getHMDTrackingColorPreset(
     return m_device->getTrackingColorPreset(hmd_id, color, out_preset);
 }
 
+void
+ServerTrackerView::computeControllerBlobAssignment()
+{
+    SERVER_TRACE_DEVICE_SCOPE("ServerTrackerView::computeControllerBlobAssignment", getDeviceID());
+    ControllerManager *controllerManager= DeviceManager::getInstance()->m_controller_manager;
+    const TrackerManager *trackerManager= DeviceManager::getInstance()->m_tracker_manager;
+    OpenCVBufferState *state= m_opencv_buffer_state;
+    const std::chrono::time_point<std::chrono::high_resolution_clock> frameTimestamp= getLastNewDataTimestamp();
+
+    for (int controller_id = 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+    {
+        state->controllerBlobAssignments[controller_id].bAssigned= false;
+    }
+
+    // Blobs of different colors can't be confused, so each color is its own matching problem
+    for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+    {
+        const eCommonTrackingColorID color_id= static_cast<eCommonTrackingColorID>(color_index);
+        const ServerControllerView *first_controller= nullptr;
+        cv::Rect2i search_roi;
+
+        state->blobAssignmentPredictions.clear();
+        state->blobAssignmentControllerIds.clear();
+
+        // Predict where each controller of the color this tracker is following shows up next.
+        // Controllers it lost (or blink coded ones) keep searching on their own.
+        for (int controller_id : controllerManager->getOpenDeviceIds())
+        {
+            ServerControllerViewPtr controller_view= controllerManager->getControllerViewPtr(controller_id);
+
+            if (!controller_view->getIsTrackingEnabled() ||
+                controller_view->getTrackingColorID() != color_id ||
+                trackerManager->getLEDBlinkCodeSlot(controller_id) != -1)
+            {
+                continue;
+            }
+
+            const ControllerOpticalPoseEstimation *priorPoseEst= controller_view->getTrackerPoseEstimate(getDeviceID());
+            if (priorPoseEst == nullptr || 
+                !priorPoseEst->bCurrentlyTracking ||
+                priorPoseEst->projection.shape_type == eCommonTrackingProjectionType::INVALID_PROJECTION)
+            {
+                continue;
+            }
+
+            CommonDeviceTrackingShape tracking_shape;
+            BlobAssignmentPrediction prediction;
+            cv::Rect2i controller_roi;
+            if (controller_view->getTrackingShape(tracking_shape) &&
+                computeControllerBlobPrediction(
+                    this, controller_view.get(), &tracking_shape, &priorPoseEst->projection, prediction, controller_roi))
+            {
+                search_roi= (first_controller != nullptr) ? (search_roi | controller_roi) : controller_roi;
+                first_controller= (first_controller != nullptr) ? first_controller : controller_view.get();
+
+                state->blobAssignmentPredictions.push_back(prediction);
+                state->blobAssignmentControllerIds.push_back(controller_id);
+            }
+        }
+
+        if (first_controller == nullptr)
+        {
+            continue;
+        }
+
+        // Find every blob of the color around the predictions in one pass
+        const int device_count= static_cast<int>(state->blobAssignmentPredictions.size());
+        CommonHSVColorRange hsvColorRange;
+        getControllerTrackingColorPreset(first_controller, color_id, &hsvColorRange);
+        {
+            StatScopedTimer stat_timer(_stat_stage_tracker_hsv, getDeviceID());
+
+            state->applyROI(search_roi);
+        }
+        {
+            StatScopedTimer stat_timer(_stat_stage_tracker_contours, getDeviceID());
+
+            state->computeBiggestNContours(
+                hsvColorRange, state->biggestContours, state->contourAreas, device_count + k_blob_assignment_extra_blobs);
+        }
+
+        const int blob_count= static_cast<int>(state->biggestContours.size());
+        state->blobAssignmentCandidates.clear();
+        for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+        {
+            cv::Point2f center;
+            float radius;
+            cv::minEnclosingCircle(state->biggestContours[blob_index], center, radius);
+
+            BlobAssignmentCandidate candidate;
+            candidate.center= Eigen::Vector2f(center.x, center.y);
+            candidate.radius= radius;
+            state->blobAssignmentCandidates.push_back(candidate);
+        }
+
+        // Score every blob against every prediction and pair them up
+        state->blobAssignmentCosts.resize(device_count*blob_count);
+        for (int device_index = 0; device_index < device_count; ++device_index)
+        {
+            for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+            {
+                state->blobAssignmentCosts[device_index*blob_count + blob_index]= 
+                    computeBlobAssignmentCost(
+                        state->blobAssignmentPredictions[device_index], 
+                        state->blobAssignmentCandidates[blob_index]);
+            }
+        }
+
+        state->blobAssignmentIndices.resize(device_count);
+        state->blobAssignmentSolver.solve(
+            state->blobAssignmentCosts.data(), device_count, blob_count, state->blobAssignmentIndices.data());
+
+        for (int device_index = 0; device_index < device_count; ++device_index)
+        {
+            const int blob_index= state->blobAssignmentIndices[device_index];
+
+            if (blob_index != -1)
+            {
+                const t_opencv_int_contour &contour= state->biggestContours[blob_index];
+                OpenCVBufferState::ControllerBlobAssignment &assignment= 
+                    state->controllerBlobAssignments[state->blobAssignmentControllerIds[device_index]];
+
+                assignment.bAssigned= true;
+                assignment.frame_timestamp= frameTimestamp;
+                assignment.search_roi= search_roi;
+                assignment.contour.assign(contour.begin(), contour.end());
+                assignment.contour_area= state->contourAreas[blob_index];
+            }
+        }
+    }
+}
+
 bool
 ServerTrackerView::computeProjectionForController(
     const ServerControllerView* tracked_controller,
     const CommonDeviceTrackingShape *tracking_shape,
     ControllerOpticalPoseEstimation *out_pose_estimate)
 {
+    SERVER_TRACE_DEVICE_SCOPE("ServerTrackerView::computeProjectionForController", getDeviceID());
     bool bSuccess = true;
 
     // Get the HSV filter used to find the tracking blob
     CommonHSVColorRange hsvColorRange;
+    const eCommonTrackingColorID tracked_color_id = tracked_controller->getTrackingColorID();
     if (bSuccess)
     {
-        eCommonTrackingColorID tracked_color_id = tracked_controller->getTrackingColorID();
-
         if (tracked_color_id != eCommonTrackingColorID::INVALID_COLOR)
         {
             getControllerTrackingColorPreset(tracked_controller, tracked_color_id, &hsvColorRange);
@@ -1258,6 +1989,11 @@ ServerTrackerView::computeProjectionForController(
         }
     }
 
+    // Controllers sharing their tracking color are told apart by blink code over the full frame
+    const int blink_code_slot= 
+        DeviceManager::getInstance()->m_tracker_manager->getLEDBlinkCodeSlot(tracked_controller->getDeviceID());
+    const std::chrono::time_point<std::chrono::high_resolution_clock> frameTimestamp= getLastNewDataTimestamp();
+
     // Compute a region of interest in the tracker buffer around where we expect to find the tracking shape
     const TrackerManagerConfig &trackerMgrConfig= DeviceManager::getInstance()->m_tracker_manager->getConfig();
     const bool bRoiDisabled = tracked_controller->getIsROIDisabled() || trackerMgrConfig.disable_roi;
@@ -1266,26 +2002,104 @@ ServerTrackerView::computeProjectionForController(
         tracked_controller->getTrackerPoseEstimate(this->getDeviceID());
     const bool bIsTracking = priorPoseEst->bCurrentlyTracking;
 
-    cv::Rect2i ROI= computeTrackerROIForPoseProjection(
-        bRoiDisabled,
-        this,		
-        bIsTracking ? tracked_controller->getPoseFilter() : nullptr,
-        bIsTracking ? &priorPoseEst->projection : nullptr,
-        tracking_shape);
+    const std::chrono::time_point<std::chrono::high_resolution_clock> searchStartTime= 
+        std::chrono::high_resolution_clock::now();
+    ROISearchState *roiSearchState= nullptr;
+    cv::Rect2i ROI;
+    bool bSkipHsvConversion= false;
+
+    // Blob already picked for this controller by computeControllerBlobAssignment(), if any
+    const OpenCVBufferState::ControllerBlobAssignment *blobAssignment= 
+        (blink_code_slot == -1) 
+        ? m_opencv_buffer_state->getControllerBlobAssignment(tracked_controller->getDeviceID(), frameTimestamp)
+        : nullptr;
+
+    if (blink_code_slot != -1)
+    {
+        // The other blobs of the color have to be followed too, so no ROI here.
+        // The frame only needs converting for the first controller of the color.
+        ROI= cv::Rect2i(cv::Point(0, 0), cv::Size(m_opencv_buffer_state->frameWidth, m_opencv_buffer_state->frameHeight));
+        bSkipHsvConversion= m_opencv_buffer_state->getIsBlinkCodeSearchCached(tracked_color_id, frameTimestamp);
+    }
+    else if (blobAssignment != nullptr)
+    {
+        // The frame was already searched around every controller of this color
+        ROI= blobAssignment->search_roi;
+        bSkipHsvConversion= true;
+
+        if (trackerMgrConfig.use_adaptive_roi)
+        {
+            roiSearchState= &m_opencv_buffer_state->controllerROISearchStates[tracked_controller->getDeviceID()];
+        }
+    }
+    else if (trackerMgrConfig.use_adaptive_roi)
+    {
+        // Keep searching around the last known projection after tracking is lost,
+        // only falling back to a full frame scan when it's this tracker's turn
+        const bool bHasPriorProjection= 
+            priorPoseEst->projection.shape_type != eCommonTrackingProjectionType::INVALID_PROJECTION;
+
+        roiSearchState= &m_opencv_buffer_state->controllerROISearchStates[tracked_controller->getDeviceID()];
+        ROI= computeTrackerROIForPoseProjection(
+            bRoiDisabled,
+            this,
+            bHasPriorProjection ? tracked_controller->getPoseFilter() : nullptr,
+            bHasPriorProjection ? &priorPoseEst->projection : nullptr,
+            tracking_shape,
+            roiSearchState,
+            DeviceManager::getInstance()->m_tracker_manager->getIsFullFrameScanSlot(this->getDeviceID()));
 
-    m_opencv_buffer_state->applyROI(ROI);
+        // An empty ROI means this frame was skipped waiting for a full frame scan slot
+        bSuccess= bSuccess && ROI.area() > 0;
+    }
+    else
+    {
+        ROI= computeTrackerROIForPoseProjection(
+            bRoiDisabled,
+            this,		
+            bIsTracking ? tracked_controller->getPoseFilter() : nullptr,
+            bIsTracking ? &priorPoseEst->projection : nullptr,
+            tracking_shape);
+    }
+
+    if (ROI.area() > 0 && !bSkipHsvConversion)
+    {
+        StatScopedTimer stat_timer(_stat_stage_tracker_hsv, getDeviceID());
+
+        m_opencv_buffer_state->applyROI(ROI);
+    }
 
     // Find the contour associated with the controller
-    t_opencv_int_contour_list biggest_contours;
-    std::vector<double> contour_areas;
+    // (results land in the tracker's scratch buffers, reused each frame)
+    t_opencv_int_contour_scratch_list &biggest_contours= m_opencv_buffer_state->biggestContours;
+    std::vector<double> &contour_areas= m_opencv_buffer_state->contourAreas;
     if (bSuccess)
     {
-        bSuccess = m_opencv_buffer_state->computeBiggestNContours(hsvColorRange, biggest_contours, contour_areas, 1);
+        StatScopedTimer stat_timer(_stat_stage_tracker_contours, getDeviceID());
+
+        if (blink_code_slot != -1)
+        {
+            bSuccess = m_opencv_buffer_state->computeBlinkCodedContour(
+                hsvColorRange, tracked_color_id, blink_code_slot, frameTimestamp, biggest_contours, contour_areas);
+        }
+        else if (blobAssignment != nullptr)
+        {
+            biggest_contours.clear();
+            contour_areas.clear();
+            biggest_contours.push_back().assign(blobAssignment->contour.begin(), blobAssignment->contour.end());
+            contour_areas.push_back(blobAssignment->contour_area);
+        }
+        else
+        {
+            bSuccess = m_opencv_buffer_state->computeBiggestNContours(hsvColorRange, biggest_contours, contour_areas, 1);
+        }
     }
     
     // Process the contour for its 2D and 3D pose.
     if (bSuccess)
     {
+        StatScopedTimer stat_timer(_stat_stage_tracker_pose_fit, getDeviceID());
+
         // Get camera parameters.
         // Needed for undistortion.
         cv::Matx33f camera_matrix;
@@ -1299,16 +2113,16 @@ ServerTrackerView::computeProjectionForController(
         case eCommonTrackingShapeType::Sphere:
             {
                 // Compute the convex hull of the contour
-                t_opencv_int_contour convex_contour;
+                t_opencv_int_contour &convex_contour= m_opencv_buffer_state->convexContour;
                 cv::convexHull(biggest_contours[0], convex_contour);
                 m_opencv_buffer_state->draw_contour(convex_contour);
 
                 // Convert integer to float
-                t_opencv_float_contour convex_contour_f;
-                cv::Mat(convex_contour).convertTo(convex_contour_f, cv::Mat(convex_contour_f).type());
+                t_opencv_float_contour &convex_contour_f= m_opencv_buffer_state->floatContour;
+                convertIntContourToFloatContour(convex_contour, convex_contour_f);
 
                 // Undistort points
-                t_opencv_float_contour undistort_contour;  //destination for undistorted contour
+                t_opencv_float_contour &undistort_contour= m_opencv_buffer_state->undistortedContour;  //destination for undistorted contour
                 cv::undistortPoints(convex_contour_f, undistort_contour,
                                     camera_matrix,
                                     distortions);//,
@@ -1322,18 +2136,19 @@ ServerTrackerView::computeProjectionForController(
                 Eigen::Vector3f sphere_center;
                 EigenFitEllipse ellipse_projection;
 
-                std::vector<Eigen::Vector2f> eigen_contour;
-                std::for_each(undistort_contour.begin(),
-                              undistort_contour.end(),
-                              [&eigen_contour](cv::Point2f& p) {
-                                  eigen_contour.push_back(Eigen::Vector2f(p.x, p.y));
-                              });
+                std::vector<Eigen::Vector2f> &eigen_contour= m_opencv_buffer_state->eigenContour;
+                convertFloatContourToEigenContour(undistort_contour, eigen_contour);
                 eigen_alignment_fit_focal_cone_to_sphere(eigen_contour.data(),
                                                          static_cast<int>(eigen_contour.size()),
                                                          tracking_shape->shape.sphere.radius_cm,
                                                          1, //I was expecting this to be -1. Is it +1 because we're using -F_PY?
                                                          &sphere_center,
                                                          &ellipse_projection);
+
+                // Optionally tighten the fit using subpixel edges from the source image
+                refineSphereFitIfEnabled(
+                    m_opencv_buffer_state, trackerMgrConfig, camera_matrix, distortions,
+                    tracking_shape->shape.sphere.radius_cm, &sphere_center, &ellipse_projection);
                 
                 if (ellipse_projection.area > k_real_epsilon)
                 {
@@ -1375,11 +2190,11 @@ ServerTrackerView::computeProjectionForController(
                 m_opencv_buffer_state->draw_contour(biggest_contours[0]);
 
                 // Convert integer contour to float
-                t_opencv_float_contour biggest_contour_f;
-                cv::Mat(biggest_contours[0]).convertTo(biggest_contour_f, cv::Mat(biggest_contour_f).type());
+                t_opencv_float_contour &biggest_contour_f= m_opencv_buffer_state->floatContour;
+                convertIntContourToFloatContour(biggest_contours[0], biggest_contour_f);
 
                 // Compute an undistorted version of the contour
-                t_opencv_float_contour undistort_contour;
+                t_opencv_float_contour &undistort_contour= m_opencv_buffer_state->undistortedContour;
                 cv::undistortPoints(biggest_contour_f, undistort_contour,
                                     camera_matrix,
                                     distortions,
@@ -1415,6 +2230,13 @@ ServerTrackerView::computeProjectionForController(
         }
     }
 
+    if (roiSearchState != nullptr)
+    {
+        updateROISearchState(
+            this, "controller", tracked_controller->getDeviceID(),
+            bSuccess, ROI, searchStartTime, roiSearchState);
+    }
+
     return bSuccess;
 }
 
@@ -1423,6 +2245,7 @@ bool ServerTrackerView::computeProjectionForHMD(
     const struct CommonDeviceTrackingShape *tracking_shape,
     struct HMDOpticalPoseEstimation *out_pose_estimate)
 {
+    SERVER_TRACE_DEVICE_SCOPE("ServerTrackerView::computeProjectionForHMD", getDeviceID());
     bool bSuccess = true;
 
     // Get the HSV filter used to find the tracking blob
@@ -1449,19 +2272,54 @@ bool ServerTrackerView::computeProjectionForHMD(
         tracked_hmd->getTrackerPoseEstimate(this->getDeviceID());
     const bool bIsTracking = priorPoseEst->bCurrentlyTracking;
 
-    cv::Rect2i ROI = computeTrackerROIForPoseProjection(
-        bRoiDisabled,
-        this, 
-        bIsTracking ? tracked_hmd->getPoseFilter() : nullptr,
-        bIsTracking ? &priorPoseEst->projection : nullptr,
-        tracking_shape);
-    m_opencv_buffer_state->applyROI(ROI);
+    const std::chrono::time_point<std::chrono::high_resolution_clock> searchStartTime= 
+        std::chrono::high_resolution_clock::now();
+    ROISearchState *roiSearchState= nullptr;
+    cv::Rect2i ROI;
+
+    if (trackerMgrConfig.use_adaptive_roi)
+    {
+        // See computeProjectionForController
+        const bool bHasPriorProjection= 
+            priorPoseEst->projection.shape_type != eCommonTrackingProjectionType::INVALID_PROJECTION;
+
+        roiSearchState= &m_opencv_buffer_state->hmdROISearchStates[tracked_hmd->getDeviceID()];
+        ROI= computeTrackerROIForPoseProjection(
+            bRoiDisabled,
+            this,
+            bHasPriorProjection ? tracked_hmd->getPoseFilter() : nullptr,
+            bHasPriorProjection ? &priorPoseEst->projection : nullptr,
+            tracking_shape,
+            roiSearchState,
+            DeviceManager::getInstance()->m_tracker_manager->getIsFullFrameScanSlot(this->getDeviceID()));
+
+        bSuccess= bSuccess && ROI.area() > 0;
+    }
+    else
+    {
+        ROI = computeTrackerROIForPoseProjection(
+            bRoiDisabled,
+            this, 
+            bIsTracking ? tracked_hmd->getPoseFilter() : nullptr,
+            bIsTracking ? &priorPoseEst->projection : nullptr,
+            tracking_shape);
+    }
+
+    if (ROI.area() > 0)
+    {
+        StatScopedTimer stat_timer(_stat_stage_tracker_hsv, getDeviceID());
+
+        m_opencv_buffer_state->applyROI(ROI);
+    }
 
     // Find the N best contours associated with the HMD
-    t_opencv_int_contour_list biggest_contours;
-    std::vector<double> contour_areas;
+    // (results land in the tracker's scratch buffers, reused each frame)
+    t_opencv_int_contour_scratch_list &biggest_contours= m_opencv_buffer_state->biggestContours;
+    std::vector<double> &contour_areas= m_opencv_buffer_state->contourAreas;
     if (bSuccess)
     {
+        StatScopedTimer stat_timer(_stat_stage_tracker_contours, getDeviceID());
+
         bSuccess = 
             m_opencv_buffer_state->computeBiggestNContours(
                 hsvColorRange, biggest_contours, contour_areas, CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT);
@@ -1470,6 +2328,8 @@ bool ServerTrackerView::computeProjectionForHMD(
     // Compute the tracker relative 3d position of the controller from the contour
     if (bSuccess)
     {
+        StatScopedTimer stat_timer(_stat_stage_tracker_pose_fit, getDeviceID());
+
         cv::Matx33f camera_matrix;
         cv::Matx<float, 5, 1> distortions;
         computeOpenCVCameraIntrinsicMatrix(m_device, camera_matrix, distortions);
@@ -1480,16 +2340,16 @@ bool ServerTrackerView::computeProjectionForHMD(
         case eCommonTrackingShapeType::Sphere:
             {
                 // Compute the convex hull of the contour
-                t_opencv_int_contour convex_contour;
+                t_opencv_int_contour &convex_contour= m_opencv_buffer_state->convexContour;
                 cv::convexHull(biggest_contours[0], convex_contour);
                 m_opencv_buffer_state->draw_contour(convex_contour);
 
                 // Convert integer to float
-                t_opencv_float_contour convex_contour_f;
-                cv::Mat(convex_contour).convertTo(convex_contour_f, cv::Mat(convex_contour_f).type());
+                t_opencv_float_contour &convex_contour_f= m_opencv_buffer_state->floatContour;
+                convertIntContourToFloatContour(convex_contour, convex_contour_f);
 
                 // Undistort points
-                t_opencv_float_contour undistorted_contour;  //destination for undistorted contour
+                t_opencv_float_contour &undistorted_contour= m_opencv_buffer_state->undistortedContour;  //destination for undistorted contour
                 cv::undistortPoints(convex_contour_f, undistorted_contour,
                                     camera_matrix,
                                     distortions);//,
@@ -1503,18 +2363,19 @@ bool ServerTrackerView::computeProjectionForHMD(
                 Eigen::Vector3f sphere_center;
                 EigenFitEllipse ellipse_projection;
 
-                std::vector<Eigen::Vector2f> eigen_contour;
-                std::for_each(undistorted_contour.begin(),
-                              undistorted_contour.end(),
-                              [&eigen_contour](const cv::Point2f& p) {
-                                  eigen_contour.push_back(Eigen::Vector2f(p.x, p.y));
-                              });
+                std::vector<Eigen::Vector2f> &eigen_contour= m_opencv_buffer_state->eigenContour;
+                convertFloatContourToEigenContour(undistorted_contour, eigen_contour);
                 eigen_alignment_fit_focal_cone_to_sphere(eigen_contour.data(),
                                                          static_cast<int>(eigen_contour.size()),
                                                          tracking_shape->shape.sphere.radius_cm,
                                                          1, //I was expecting this to be -1. Is it +1 because we're using -F_PY?
                                                          &sphere_center,
                                                          &ellipse_projection);
+
+                // Optionally tighten the fit using subpixel edges from the source image
+                refineSphereFitIfEnabled(
+                    m_opencv_buffer_state, trackerMgrConfig, camera_matrix, distortions,
+                    tracking_shape->shape.sphere.radius_cm, &sphere_center, &ellipse_projection);
                 
                 if (ellipse_projection.area > k_real_epsilon)
                 {
@@ -1554,25 +2415,24 @@ bool ServerTrackerView::computeProjectionForHMD(
                 CommonDevicePose tracker_pose_guess= {prior_post_est->position_cm, prior_post_est->orientation};
 
                 // Undistort the source contours
-                t_opencv_float_contour_list undistorted_contours;
+                t_opencv_float_contour_scratch_list &undistorted_contours= m_opencv_buffer_state->undistortedContours;
+                undistorted_contours.clear();
                 for (auto it = biggest_contours.begin(); it != biggest_contours.end(); ++it)
                 {
                     // Draw the source contour
                     m_opencv_buffer_state->draw_contour(*it);
 
                     // Convert integer contour to float
-                    t_opencv_float_contour biggest_contour_f;
-                    cv::Mat(*it).convertTo(biggest_contour_f, cv::Mat(biggest_contour_f).type());
+                    t_opencv_float_contour &biggest_contour_f= m_opencv_buffer_state->floatContour;
+                    convertIntContourToFloatContour(*it, biggest_contour_f);
 
                     // Compute an undistorted version of the contour
-                    t_opencv_float_contour undistort_contour;
+                    t_opencv_float_contour &undistort_contour= undistorted_contours.push_back();
                     cv::undistortPoints(biggest_contour_f, undistort_contour,
                         camera_matrix,
                         distortions,
                         cv::noArray(),
                         camera_matrix);
-
-                    undistorted_contours.push_back(biggest_contour_f);
                 }
 
                 bSuccess =
@@ -1592,6 +2452,13 @@ bool ServerTrackerView::computeProjectionForHMD(
         }
     }
 
+    if (roiSearchState != nullptr)
+    {
+        updateROISearchState(
+            this, "HMD", tracked_hmd->getDeviceID(),
+            bSuccess, ROI, searchStartTime, roiSearchState);
+    }
+
     return bSuccess;
 }
 
@@ -1613,6 +2480,8 @@ ServerTrackerView::computePoseForProjection(
         } break;
     case eCommonTrackingShapeType::LightBar:
         {
+            StatScopedTimer stat_timer(_stat_stage_tracker_pose_fit, getDeviceID());
+
             bSuccess =
                 computeTrackerRelativeLightBarPose(
                     m_device,
@@ -1933,46 +2802,52 @@ ServerTrackerView::triangulateWorldPositions(
 std::vector<CommonDeviceScreenLocation>
 ServerTrackerView::projectTrackerRelativePositions(const std::vector<CommonDevicePosition> &objectPositions) const
 {
+    std::vector<CommonDeviceScreenLocation> screenLocations(objectPositions.size());
+
+    if (!objectPositions.empty())
+    {
+        projectTrackerRelativePositions(
+            objectPositions.data(), static_cast<int>(objectPositions.size()), screenLocations.data());
+    }
+    
+    return screenLocations;
+}
+
+void
+ServerTrackerView::projectTrackerRelativePositions(
+    const CommonDevicePosition *objectPositions,
+    const int position_count,
+    CommonDeviceScreenLocation *out_screen_locations) const
+{
+    static_assert(sizeof(CommonDevicePosition) == sizeof(cv::Point3f), "CommonDevicePosition must be three packed floats");
+    static_assert(sizeof(CommonDeviceScreenLocation) == sizeof(cv::Point2f), "CommonDeviceScreenLocation must be two packed floats");
+
     cv::Matx33f camera_matrix;
     cv::Matx<float, 5, 1> distortions;
     computeOpenCVCameraIntrinsicMatrix(m_device, camera_matrix, distortions);
     
     // Use the identity transform for tracker relative positions
-    cv::Mat rvec(3, 1, cv::DataType<double>::type, double(0));
-    cv::Mat tvec(3, 1, cv::DataType<double>::type, double(0));
-    
-    std::vector<cv::Point3f> cvObjectPoints;
-    size_t i;
-    for (i=0; i<objectPositions.size(); ++i) {
-        cvObjectPoints.push_back(cv::Point3f(objectPositions[i].x,
-                                             objectPositions[i].y,
-                                             objectPositions[i].z));
-    }
-    
-    // Projected point
-    std::vector<cv::Point2f> projectedPoints;
+    const cv::Vec3d rvec(0.0, 0.0, 0.0);
+    const cv::Vec3d tvec(0.0, 0.0, 0.0);
+
+    // Project straight from and into the caller's arrays.
+    // The output header already has the right size and type, so projectPoints writes into it in place.
+    const cv::Mat cvObjectPoints(position_count, 1, CV_32FC3, const_cast<CommonDevicePosition *>(objectPositions));
+    cv::Mat projectedPoints(position_count, 1, CV_32FC2, out_screen_locations);
     cv::projectPoints(cvObjectPoints,
                       rvec,
                       tvec,
                       camera_matrix,
                       distortions,
                       projectedPoints);
-    
-    std::vector<CommonDeviceScreenLocation> screenLocations;
-    for (i=0; i<projectedPoints.size(); ++i) {
-        CommonDeviceScreenLocation thisloc;
-        thisloc.set(projectedPoints[i].x, projectedPoints[i].y);
-        screenLocations.push_back(thisloc);
-    }
-    
-    return screenLocations;
+    assert(projectedPoints.data == reinterpret_cast<uchar *>(out_screen_locations));
 }
 
 CommonDeviceScreenLocation
 ServerTrackerView::projectTrackerRelativePosition(const CommonDevicePosition *trackerRelativePosition) const
 {
-    std::vector<CommonDevicePosition> trp_vec {*trackerRelativePosition};
-    CommonDeviceScreenLocation screenLocation = projectTrackerRelativePositions(trp_vec)[0];
+    CommonDeviceScreenLocation screenLocation;
+    projectTrackerRelativePositions(trackerRelativePosition, 1, &screenLocation);
 
     return screenLocation;
 }
@@ -2054,7 +2929,7 @@ static bool computeTrackerRelativeLightBarProjection(
 
     bool bValidTrackerProjection= true;
     float projectionArea= 0.f;
-    std::vector<cv::Point2f> cvImagePoints;
+    cv::Point2f cvImagePoints[7];
     {
         cv::Point2f tri_top, tri_bottom_left, tri_bottom_right;
         cv::Point2f quad_top_right, quad_top_left, quad_bottom_left, quad_bottom_right;
@@ -2085,13 +2960,13 @@ static bool computeTrackerRelativeLightBarProjection(
             tri_top= 0.5f*(quad_top_right + quad_top_left);
 
             // Put the image points in corresponding order with cvObjectPoints
-            cvImagePoints.push_back(tri_bottom_right);
-            cvImagePoints.push_back(tri_bottom_left);
-            cvImagePoints.push_back(tri_top);
-            cvImagePoints.push_back(quad_top_right);
-            cvImagePoints.push_back(quad_top_left);
-            cvImagePoints.push_back(quad_bottom_left);
-            cvImagePoints.push_back(quad_bottom_right);
+            cvImagePoints[0]= tri_bottom_right;
+            cvImagePoints[1]= tri_bottom_left;
+            cvImagePoints[2]= tri_top;
+            cvImagePoints[3]= quad_top_right;
+            cvImagePoints[4]= quad_top_left;
+            cvImagePoints[5]= quad_bottom_left;
+            cvImagePoints[6]= quad_bottom_right;
 
             // The projection area is the size of the best fit quad
             projectionArea= 
@@ -2264,7 +3139,7 @@ static bool computeTrackerRelativeLightBarPose(
 static bool computeTrackerRelativePointCloudContourPose(
     const ITrackerInterface *tracker_device,
     const CommonDeviceTrackingShape *tracking_shape,
-    const t_opencv_float_contour_list &opencv_contours,
+    const t_opencv_float_contour_scratch_list &opencv_contours,
     const CommonDevicePose *tracker_relative_pose_guess,
     HMDOpticalPoseEstimation *out_pose_estimate)
 {
@@ -2274,28 +3149,97 @@ static bool computeTrackerRelativePointCloudContourPose(
     float projectionArea = 0.f;
 
     // Compute centers of mass for the contours
-    t_opencv_float_contour cvImagePoints;
-    for (auto it = opencv_contours.begin(); it != opencv_contours.end(); ++it)
+    cv::Point2f cvImagePoints[CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT];
+    int imagePointCount = 0;
+    for (auto it = opencv_contours.begin(); 
+        it != opencv_contours.end() && imagePointCount < CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT; 
+        ++it)
     {
-        cv::Point2f massCenter= computeSafeCenterOfMassForContour<t_opencv_float_contour>(*it);
-
-        cvImagePoints.push_back(massCenter);
+        cvImagePoints[imagePointCount]= computeSafeCenterOfMassForContour<t_opencv_float_contour>(*it);
+        ++imagePointCount;
     }
 
-    if (cvImagePoints.size() >= 3)
+    if (imagePointCount >= 3)
     {
-        //###HipsterSloth $TODO Solve the pose using SoftPOSIT
-        out_pose_estimate->position_cm.clear();
-        out_pose_estimate->orientation.clear();
-        out_pose_estimate->bOrientationValid = false;
-        bValidTrackerPose = true;
+        // The contours were undistorted back into pixel space.
+        // Re-center them on the principal point with +Y up (F_PY is negated in the camera matrix).
+        cv::Matx33f cvCameraMatrix;
+        cv::Matx<float, 5, 1> cvDistCoeffs;
+        computeOpenCVCameraIntrinsicMatrix(tracker_device, cvCameraMatrix, cvDistCoeffs);
+
+        const float focal_length_px = cvCameraMatrix(0, 0);
+        Eigen::Vector2f eigenImagePoints[CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT];
+        for (int point_index = 0; point_index < imagePointCount; ++point_index)
+        {
+            eigenImagePoints[point_index] = Eigen::Vector2f(
+                cvImagePoints[point_index].x - cvCameraMatrix(0, 2),
+                (cvImagePoints[point_index].y - cvCameraMatrix(1, 2)) * focal_length_px / cvCameraMatrix(1, 1));
+        }
+
+        // LEDs facing away from the camera are left out of the matching
+        Eigen::Vector3f eigenModelPoints[CommonDeviceTrackingShape::MAX_POINT_CLOUD_POINT_COUNT];
+        Eigen::Vector3f eigenModelNormals[CommonDeviceTrackingShape::MAX_POINT_CLOUD_POINT_COUNT];
+        const int modelPointCount = tracking_shape->shape.point_cloud.point_count;
+        for (int point_index = 0; point_index < modelPointCount; ++point_index)
+        {
+            const CommonDevicePosition &point = tracking_shape->shape.point_cloud.point[point_index];
+            const CommonDeviceVector &normal = tracking_shape->shape.point_cloud.normal[point_index];
+
+            eigenModelPoints[point_index] = Eigen::Vector3f(point.x, point.y, point.z);
+            eigenModelNormals[point_index] = Eigen::Vector3f(normal.i, normal.j, normal.k);
+        }
+
+        // Seed the solver with the last tracker relative pose if there is one,
+        // otherwise it falls back to a few canned starting poses
+        Eigen::Quaternionf guessOrientation;
+        Eigen::Vector3f guessPosition;
+        if (tracker_relative_pose_guess != nullptr)
+        {
+            guessOrientation = Eigen::Quaternionf(
+                tracker_relative_pose_guess->Orientation.w,
+                tracker_relative_pose_guess->Orientation.x,
+                tracker_relative_pose_guess->Orientation.y,
+                tracker_relative_pose_guess->Orientation.z);
+            guessPosition = Eigen::Vector3f(
+                tracker_relative_pose_guess->PositionCm.x,
+                tracker_relative_pose_guess->PositionCm.y,
+                tracker_relative_pose_guess->PositionCm.z);
+        }
+
+        // Correspondence free PnP: SoftPOSIT with a fixed iteration budget
+        Eigen::Quaternionf solvedOrientation;
+        Eigen::Vector3f solvedPosition;
+        bValidTrackerPose =
+            eigen_alignment_soft_posit(
+                eigenModelPoints, eigenModelNormals, modelPointCount,
+                eigenImagePoints, imagePointCount,
+                focal_length_px,
+                k_point_cloud_image_noise_px,
+                tracker_relative_pose_guess != nullptr ? &guessOrientation : nullptr,
+                tracker_relative_pose_guess != nullptr ? &guessPosition : nullptr,
+                k_point_cloud_pose_iteration_budget,
+                &solvedOrientation,
+                &solvedPosition);
+
+        if (bValidTrackerPose)
+        {
+            out_pose_estimate->position_cm.set(solvedPosition.x(), solvedPosition.y(), solvedPosition.z());
+            out_pose_estimate->orientation.w = solvedOrientation.w();
+            out_pose_estimate->orientation.x = solvedOrientation.x();
+            out_pose_estimate->orientation.y = solvedOrientation.y();
+            out_pose_estimate->orientation.z = solvedOrientation.z();
+            out_pose_estimate->bOrientationValid = true;
+        }
+    }
+    else
+    {
+        bValidTrackerPose = false;
     }
 
     // Return the projection of the tracking shape
     if (bValidTrackerPose)
     {
         CommonDeviceTrackingProjection *out_projection = &out_pose_estimate->projection;
-        const int imagePointCount = static_cast<int>(cvImagePoints.size());
 
         out_projection->shape_type = eCommonTrackingProjectionType::ProjectionType_Points;
 
@@ -2313,12 +3257,196 @@ static bool computeTrackerRelativePointCloudContourPose(
     return bValidTrackerPose;
 }
 
+// Shared by the controller and hmd sphere fits.
+// Leaves the hull based fit alone when refinement is off, the hull fit failed or the refinement did.
+static void refineSphereFitIfEnabled(
+    OpenCVBufferState *buffer_state,
+    const TrackerManagerConfig &trackerMgrConfig,
+    const cv::Matx33f &camera_matrix,
+    const cv::Matx<float, 5, 1> &distortions,
+    const float sphere_radius,
+    Eigen::Vector3f *in_out_sphere_center,
+    EigenFitEllipse *in_out_ellipse_projection)
+{
+    if (trackerMgrConfig.use_sphere_edge_refinement && in_out_ellipse_projection->area > k_real_epsilon)
+    {
+        buffer_state->refineSphereFit(
+            buffer_state->convexContour,
+            camera_matrix,
+            distortions,
+            sphere_radius,
+            trackerMgrConfig.sphere_edge_refinement_ray_count,
+            trackerMgrConfig.sphere_edge_refinement_search_px,
+            in_out_sphere_center,
+            in_out_ellipse_projection);
+    }
+}
+
+static float computeTrackingShapeBoundingRadius(
+    const CommonDeviceTrackingShape *tracking_shape)
+{
+    float shape_radius = 0.f;
+
+    switch (tracking_shape->shape_type)
+    {
+    case eCommonTrackingShapeType::Sphere:
+        {
+            shape_radius = tracking_shape->shape.sphere.radius_cm;
+        } break;
+
+    case eCommonTrackingShapeType::LightBar:
+        {
+            // Half the diagonal of the lightbar quad
+            const auto &shape_tl = tracking_shape->shape.light_bar.quad[CommonDeviceTrackingShape::QuadVertexUpperLeft];
+            const auto &shape_br = tracking_shape->shape.light_bar.quad[CommonDeviceTrackingShape::QuadVertexLowerRight];
+            const CommonDeviceVector half_vec = { (shape_tl.x - shape_br.x)*0.5f, (shape_tl.y - shape_br.y)*0.5f, (shape_tl.z - shape_br.z)*0.5f };
+
+            shape_radius = fmaxf(sqrtf(half_vec.i*half_vec.i + half_vec.j*half_vec.j + half_vec.k*half_vec.k), 1.f);
+        } break;
+
+    case eCommonTrackingShapeType::PointCloud:
+        {
+            // Half the diagonal of the point cloud's bounding box
+            CommonDevicePosition shape_tl = tracking_shape->shape.point_cloud.point[0];
+            CommonDevicePosition shape_br = tracking_shape->shape.point_cloud.point[0];
+            for (int point_index = 1; point_index < tracking_shape->shape.point_cloud.point_count; ++point_index)
+            {
+                const CommonDevicePosition &point = tracking_shape->shape.point_cloud.point[point_index];
+                shape_tl.set(fmaxf(shape_tl.x, point.x), fmaxf(shape_tl.y, point.y), fmaxf(shape_tl.z, point.z));
+                shape_br.set(fminf(shape_br.x, point.x), fminf(shape_br.y, point.y), fminf(shape_br.z, point.z));
+            }
+            const CommonDeviceVector half_vec = { (shape_tl.x - shape_br.x)*0.5f, (shape_tl.y - shape_br.y)*0.5f, (shape_tl.z - shape_br.z)*0.5f };
+
+            shape_radius = fmaxf(sqrtf(half_vec.i*half_vec.i + half_vec.j*half_vec.j + half_vec.k*half_vec.k), 1.f);
+        } break;
+
+    default:
+        {
+            assert(false && "unreachable");
+        } break;
+    }
+
+    return shape_radius;
+}
+
+static CommonDeviceScreenLocation computeProjectionPixelCenter(
+    const CommonDeviceTrackingProjection *projection)
+{
+    CommonDeviceScreenLocation projection_pixel_center;
+    projection_pixel_center.clear();
+
+    switch (projection->shape_type)
+    {
+    case eCommonTrackingProjectionType::ProjectionType_Ellipse:
+        {
+            // Use the center of the ellipsoid projection
+            projection_pixel_center = projection->shape.ellipse.center;
+        } break;
+
+    case eCommonTrackingProjectionType::ProjectionType_LightBar:
+        {
+            // Use the center of the quad projection
+            const auto proj_tl = projection->shape.lightbar.quad[CommonDeviceTrackingShape::QuadVertexUpperLeft];
+            const auto proj_br = projection->shape.lightbar.quad[CommonDeviceTrackingShape::QuadVertexLowerRight];
+
+            projection_pixel_center.set(0.5f * (proj_tl.x + proj_br.x), 0.5f * (proj_tl.y + proj_br.y));
+        } break;
+
+    case eCommonTrackingProjectionType::ProjectionType_Points:
+        {
+            // Compute the centroid of the projection pixels
+            for (int point_index = 0; point_index < projection->shape.points.point_count; ++point_index)
+            {
+                const auto &pixel = projection->shape.points.point[point_index];
+
+                projection_pixel_center.x += pixel.x;
+                projection_pixel_center.y += pixel.y;
+            }
+            const float N = static_cast<float>(projection->shape.points.point_count);
+            projection_pixel_center.x /= N;
+            projection_pixel_center.y /= N;
+        } break;
+
+    default:
+        {
+            assert(false && "unreachable");
+        } break;
+    }
+
+    return projection_pixel_center;
+}
+
+static bool computeControllerBlobPrediction(
+    const ServerTrackerView *tracker,
+    const ServerControllerView *controller,
+    const CommonDeviceTrackingShape *tracking_shape,
+    const CommonDeviceTrackingProjection *prior_tracking_projection,
+    BlobAssignmentPrediction &out_prediction,
+    cv::Rect2i &out_search_roi)
+{
+    const IPoseFilter *pose_filter= controller->getPoseFilter();
+
+    if (pose_filter == nullptr || !pose_filter->getIsPositionStateValid())
+    {
+        return false;
+    }
+
+    const float shape_radius_cm = computeTrackingShapeBoundingRadius(tracking_shape);
+    if (shape_radius_cm <= 0.f)
+    {
+        return false;
+    }
+
+    // Where the filter puts the controller now and by the time of the next frame
+    const float frame_rate = static_cast<float>(tracker->getFrameRate());
+    const float frame_seconds = (frame_rate > k_real_epsilon) ? 1.f / frame_rate : 0.f;
+    const Eigen::Vector3f position_cm = pose_filter->getPositionCm(0.f);
+    const Eigen::Vector3f predicted_position_cm = position_cm + pose_filter->getVelocityCmPerSec() * frame_seconds;
+
+    CommonDevicePosition world_position_cm, predicted_world_position_cm;
+    world_position_cm.set(position_cm.x(), position_cm.y(), position_cm.z());
+    predicted_world_position_cm.set(predicted_position_cm.x(), predicted_position_cm.y(), predicted_position_cm.z());
+
+    const CommonDevicePosition tracker_position_cm = tracker->computeTrackerPosition(&world_position_cm);
+    const CommonDevicePosition predicted_tracker_position_cm = tracker->computeTrackerPosition(&predicted_world_position_cm);
+    CommonDevicePosition predicted_edge_cm = predicted_tracker_position_cm;
+    predicted_edge_cm.x += shape_radius_cm;
+
+    const CommonDevicePosition trps[3] = { tracker_position_cm, predicted_tracker_position_cm, predicted_edge_cm };
+    CommonDeviceScreenLocation screen_locs[3];
+    tracker->projectTrackerRelativePositions(trps, 3, screen_locs);
+
+    // Move the last projection this tracker saw by the predicted motion on screen
+    // rather than trusting the filter's absolute position, which is only as good as the tracker calibration
+    const CommonDeviceScreenLocation prior_center = computeProjectionPixelCenter(prior_tracking_projection);
+    const Eigen::Vector2f motion_px(screen_locs[1].x - screen_locs[0].x, screen_locs[1].y - screen_locs[0].y);
+    const float radius_px = 
+        Eigen::Vector2f(screen_locs[2].x - screen_locs[1].x, screen_locs[2].y - screen_locs[1].y).norm();
+
+    out_prediction.center = Eigen::Vector2f(prior_center.x, prior_center.y) + motion_px;
+    out_prediction.radius = radius_px;
+    out_prediction.position_sigma_px = 
+        k_blob_assignment_radius_sigma_fraction*radius_px + k_blob_assignment_motion_sigma_fraction*motion_px.norm();
+
+    // The search window covers the prediction's gate
+    const int half_size = 
+        std::max(static_cast<int>(radius_px + 3.f*out_prediction.position_sigma_px), k_min_roi_size / 2);
+    out_search_roi = cv::Rect2i(
+        static_cast<int>(out_prediction.center.x()) - half_size,
+        static_cast<int>(out_prediction.center.y()) - half_size,
+        2 * half_size, 2 * half_size);
+
+    return true;
+}
+
 static cv::Rect2i computeTrackerROIForPoseProjection(
     const bool roi_disabled,
     const ServerTrackerView *tracker,
     const IPoseFilter* pose_filter,
     const CommonDeviceTrackingProjection *prior_tracking_projection,
-    const CommonDeviceTrackingShape *tracking_shape)
+    const CommonDeviceTrackingShape *tracking_shape,
+    const ROISearchState *roi_search_state,
+    const bool allow_full_frame_scan)
 {
     // Get expected ROI
     // Default to full screen.
@@ -2340,113 +3468,26 @@ static cv::Rect2i computeTrackerROIForPoseProjection(
         CommonDevicePosition tracker_position_cm = tracker->computeTrackerPosition(&world_position_cm);
 
         // Project the state computed position +/- object extents onto the image.
+        // Simply: center - shape_radius, center + shape_radius.
+        const float shape_radius = computeTrackingShapeBoundingRadius(tracking_shape);
         CommonDevicePosition tl, br;
-        switch (tracking_shape->shape_type)
-        {
-        case eCommonTrackingShapeType::Sphere:
-            {
-                // Simply: center - radius, center + radius.
-                tl.set(tracker_position_cm.x - tracking_shape->shape.sphere.radius_cm,
-                    tracker_position_cm.y + tracking_shape->shape.sphere.radius_cm,
-                    tracker_position_cm.z);
-                br.set(tracker_position_cm.x + tracking_shape->shape.sphere.radius_cm,
-                    tracker_position_cm.y - tracking_shape->shape.sphere.radius_cm,
-                    tracker_position_cm.z);
-            } break;
-
-        case eCommonTrackingShapeType::LightBar:
-            {
-                // Compute the bounding radius of the lightbar tracking shape
-                const auto &shape_tl = tracking_shape->shape.light_bar.quad[CommonDeviceTrackingShape::QuadVertexUpperLeft];
-                const auto &shape_br = tracking_shape->shape.light_bar.quad[CommonDeviceTrackingShape::QuadVertexLowerRight];
-                const CommonDeviceVector half_vec = { (shape_tl.x - shape_br.x)*0.5f, (shape_tl.y - shape_br.y)*0.5f, (shape_tl.z - shape_br.z)*0.5f };
-                const auto shape_radius = fmaxf(sqrtf(half_vec.i*half_vec.i + half_vec.j*half_vec.j + half_vec.k*half_vec.k), 1.f);
-
-                // Simply: center - shape_radius, center + shape_radius.
-                tl.set(tracker_position_cm.x - shape_radius,
-                    tracker_position_cm.y + shape_radius,
-                    tracker_position_cm.z);
-                br.set(tracker_position_cm.x + shape_radius,
-                    tracker_position_cm.y - shape_radius,
-                    tracker_position_cm.z);
-            } break;
-
-        case eCommonTrackingShapeType::PointCloud:
-            {
-                // Compute the bounding radius of the point cloud
-                CommonDevicePosition shape_tl = tracking_shape->shape.point_cloud.point[0];
-                CommonDevicePosition shape_br = tracking_shape->shape.point_cloud.point[0];
-                for (int point_index = 1; point_index < tracking_shape->shape.point_cloud.point_count; ++point_index)
-                {
-                    const CommonDevicePosition &point = tracking_shape->shape.point_cloud.point[point_index];
-                    shape_tl.set(fmaxf(shape_tl.x, point.x), fmaxf(shape_tl.y, point.y), fmaxf(shape_tl.z, point.z));
-                    shape_br.set(fminf(shape_br.x, point.x), fminf(shape_br.y, point.y), fminf(shape_br.z, point.z));
-                }
-                const CommonDeviceVector half_vec = { (shape_tl.x - shape_br.x)*0.5f, (shape_tl.y - shape_br.y)*0.5f, (shape_tl.z - shape_br.z)*0.5f };
-                const auto shape_radius = fmaxf(sqrtf(half_vec.i*half_vec.i + half_vec.j*half_vec.j + half_vec.k*half_vec.k), 1.f);
-
-                // Simply: center - shape_radius, center + shape_radius.
-                tl.set(tracker_position_cm.x - shape_radius,
-                    tracker_position_cm.y + shape_radius,
-                    tracker_position_cm.z);
-                br.set(tracker_position_cm.x + shape_radius,
-                    tracker_position_cm.y - shape_radius,
-                    tracker_position_cm.z);
-            } break;
-
-        default:
-            {
-                assert(false && "unreachable");
-            } break;
-        }
+        tl.set(tracker_position_cm.x - shape_radius,
+            tracker_position_cm.y + shape_radius,
+            tracker_position_cm.z);
+        br.set(tracker_position_cm.x + shape_radius,
+            tracker_position_cm.y - shape_radius,
+            tracker_position_cm.z);
 
         // Extract the pixel projection center from the previous frame's projection.
-        CommonDeviceScreenLocation projection_pixel_center;
-        projection_pixel_center.clear();
-
-        switch (prior_tracking_projection->shape_type)
-        {
-        case eCommonTrackingProjectionType::ProjectionType_Ellipse:
-            {
-                // Use the center of the ellipsoid projection for the ROI area
-                projection_pixel_center = prior_tracking_projection->shape.ellipse.center;
-            } break;
-
-        case eCommonTrackingProjectionType::ProjectionType_LightBar:
-            {
-                // Use the center of the quad projection for the ROI area
-                const auto proj_tl = prior_tracking_projection->shape.lightbar.quad[CommonDeviceTrackingShape::QuadVertexUpperLeft];
-                const auto proj_br = prior_tracking_projection->shape.lightbar.quad[CommonDeviceTrackingShape::QuadVertexLowerRight];
-
-                projection_pixel_center.set(0.5f * (proj_tl.x + proj_br.x), 0.5f * (proj_tl.y + proj_br.y));
-            } break;
-
-        case eCommonTrackingProjectionType::ProjectionType_Points:
-            {
-                // Compute the centroid of the projection pixels
-                for (int point_index = 0; point_index < prior_tracking_projection->shape.points.point_count; ++point_index)
-                {
-                    const auto &pixel = prior_tracking_projection->shape.points.point[point_index];
-
-                    projection_pixel_center.x += pixel.x;
-                    projection_pixel_center.y += pixel.y;
-                }
-                const float N = static_cast<float>(prior_tracking_projection->shape.points.point_count);
-                projection_pixel_center.x /= N;
-                projection_pixel_center.y /= N;
-            } break;
-
-        default:
-            {
-                assert(false && "unreachable");
-            } break;
-        }
+        const CommonDeviceScreenLocation projection_pixel_center= 
+            computeProjectionPixelCenter(prior_tracking_projection);
 
         // The center of the ROI is the pixel projection center from last frame
         // The size of the ROI computed by projecting the bounding box 
         {
-            std::vector<CommonDevicePosition> trps{ tl, br };
-            std::vector<CommonDeviceScreenLocation> screen_locs = tracker->projectTrackerRelativePositions(trps);
+            const CommonDevicePosition trps[2] = { tl, br };
+            CommonDeviceScreenLocation screen_locs[2];
+            tracker->projectTrackerRelativePositions(trps, 2, screen_locs);
 
             const int proj_min_x = static_cast<int>(std::min(screen_locs[0].x, screen_locs[1].x));
             const int proj_max_x = static_cast<int>(std::max(screen_locs[0].x, screen_locs[1].x));
@@ -2461,16 +3502,141 @@ static cv::Rect2i computeTrackerROIForPoseProjection(
             const int safe_proj_width = std::max(proj_width, k_min_roi_size);
             const int safe_proj_height = std::max(proj_height, k_min_roi_size);
 
+            if (roi_search_state != nullptr)
+            {
+                // Have we run out of windows to try?
+                if (roi_search_state->search_level > k_max_roi_search_level)
+                {
+                    // Full frame scan (or nothing at all until it's our turn)
+                    return allow_full_frame_scan ? ROI : cv::Rect2i();
+                }
+
+                // Move the window to where the filter says the device will be by now,
+                // and pad it by a fraction of that motion to cover any acceleration
+                const float frame_rate = static_cast<float>(tracker->getFrameRate());
+                const float frame_seconds = (frame_rate > k_real_epsilon) ? 1.f / frame_rate : 0.f;
+                const float prediction_seconds = 
+                    std::min(frame_seconds * static_cast<float>(roi_search_state->search_level + 1), k_max_roi_prediction_seconds);
+                const Eigen::Vector3f predicted_position_cm = 
+                    position_cm + pose_filter->getVelocityCmPerSec() * prediction_seconds;
+
+                CommonDevicePosition predicted_world_position_cm;
+                predicted_world_position_cm.set(predicted_position_cm.x(), predicted_position_cm.y(), predicted_position_cm.z());
+                const CommonDevicePosition predicted_tracker_position_cm = 
+                    tracker->computeTrackerPosition(&predicted_world_position_cm);
+
+                const CommonDeviceScreenLocation current_pixel = tracker->projectTrackerRelativePosition(&tracker_position_cm);
+                const CommonDeviceScreenLocation predicted_pixel = tracker->projectTrackerRelativePosition(&predicted_tracker_position_cm);
+                const float delta_x = predicted_pixel.x - current_pixel.x;
+                const float delta_y = predicted_pixel.y - current_pixel.y;
+
+                // Each missed frame doubles the window
+                const int level_scale = 1 << roi_search_state->search_level;
+                const int search_half_width = 
+                    level_scale * (safe_proj_width + static_cast<int>(k_roi_velocity_margin * fabsf(delta_x)));
+                const int search_half_height = 
+                    level_scale * (safe_proj_height + static_cast<int>(k_roi_velocity_margin * fabsf(delta_y)));
+                const cv::Point2i search_center(
+                    static_cast<int>(projection_pixel_center.x + delta_x),
+                    static_cast<int>(projection_pixel_center.y + delta_y));
+                const cv::Rect2i search_roi(
+                    search_center + cv::Point2i(-search_half_width, -search_half_height),
+                    cv::Size(2*search_half_width, 2*search_half_height));
+
+                // A window that swung wholly off the frame has nothing left to search.
+                // Don't let applyROI widen it to the full frame outside of our scan slot.
+                const cv::Rect2i clamped_search_roi = search_roi & ROI;
+
+                if (clamped_search_roi.area() > 0)
+                {
+                    return clamped_search_roi;
+                }
+
+                return allow_full_frame_scan ? ROI : cv::Rect2i();
+            }
+
             const cv::Point2i roi_top_left = roi_center + cv::Point2i(-safe_proj_width, -safe_proj_height);
             const cv::Size roi_size(2*safe_proj_width, 2*safe_proj_height);
 
             ROI = cv::Rect2i(roi_top_left, roi_size);
         }
     }
+    else if (!roi_disabled && roi_search_state != nullptr && !allow_full_frame_scan)
+    {
+        // Never seen on this tracker, wait for our turn to scan the full frame
+        ROI = cv::Rect2i();
+    }
 
     return ROI;
 }
 
+static void updateROISearchState(
+    const ServerTrackerView *tracker,
+    const char *device_type,
+    const int device_id,
+    const bool found_device,
+    const cv::Rect2i &searched_roi,
+    const std::chrono::time_point<std::chrono::high_resolution_clock> &search_start,
+    ROISearchState *roi_search_state)
+{
+    const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+
+    if (found_device)
+    {
+        if (roi_search_state->bSearching)
+        {
+            const std::chrono::duration<double, std::milli> recovery_time = now - roi_search_state->search_start_timestamp;
+            const double average_cost_ms = 
+                roi_search_state->search_cost_total_ms / static_cast<double>(std::max(roi_search_state->search_frame_count, 1));
+
+            // Only a real tracking loss is worth reporting, not the odd dropped frame
+            if (roi_search_state->search_level > k_max_roi_search_level)
+            {
+                SERVER_LOG_INFO("ServerTrackerView::updateROISearchState") << 
+                    "Tracker " << tracker->getDeviceID() << " reacquired " << device_type << " " << device_id <<
+                    " after " << recovery_time.count() << "ms (" << roi_search_state->search_frame_count << " frames, " <<
+                    roi_search_state->full_frame_scan_count << " full frame scans, search cost avg " << 
+                    average_cost_ms << "ms, max " << roi_search_state->search_cost_max_ms << "ms per frame)";
+            }
+            else
+            {
+                SERVER_LOG_DEBUG("ServerTrackerView::updateROISearchState") << 
+                    "Tracker " << tracker->getDeviceID() << " reacquired " << device_type << " " << device_id <<
+                    " at search level " << roi_search_state->search_level << " after " << recovery_time.count() << "ms";
+            }
+        }
+
+        roi_search_state->clear();
+    }
+    else
+    {
+        const std::chrono::duration<double, std::milli> frame_cost = now - search_start;
+
+        if (!roi_search_state->bSearching)
+        {
+            roi_search_state->bSearching = true;
+            roi_search_state->search_start_timestamp = search_start;
+        }
+
+        // Count what was actually scanned: the window may hang off the frame,
+        // and applyROI scans the full frame for a window with nothing left on it
+        float screenWidth, screenHeight;
+        tracker->getPixelDimensions(screenWidth, screenHeight);
+        const cv::Rect2i frame_roi(0, 0, static_cast<int>(screenWidth), static_cast<int>(screenHeight));
+        const cv::Rect2i clamped_roi = searched_roi & frame_roi;
+        if (searched_roi.area() > 0 &&
+            (clamped_roi.area() == 0 || (clamped_roi.width >= frame_roi.width && clamped_roi.height >= frame_roi.height)))
+        {
+            ++roi_search_state->full_frame_scan_count;
+        }
+
+        ++roi_search_state->search_frame_count;
+        roi_search_state->search_cost_total_ms += frame_cost.count();
+        roi_search_state->search_cost_max_ms = std::max(roi_search_state->search_cost_max_ms, frame_cost.count());
+        roi_search_state->search_level = std::min(roi_search_state->search_level + 1, k_max_roi_search_level + 1);
+    }
+}
+
 static bool computeBestFitTriangleForContour(
     const t_opencv_float_contour &opencv_contour,
     cv::Point2f &out_triangle_top,
@@ -2499,10 +3665,7 @@ static bool computeBestFitTriangleForContour(
     cv::Point2f best_fit_origin_12 = (cv_min_triangle[1] + cv_min_triangle[2]) / 2.f;
     cv::Point2f best_fit_origin_20 = (cv_min_triangle[2] + cv_min_triangle[0]) / 2.f;
 
-    t_opencv_float_contour cv_midpoint_triangle;
-    cv_midpoint_triangle.push_back(best_fit_origin_01);
-    cv_midpoint_triangle.push_back(best_fit_origin_12);
-    cv_midpoint_triangle.push_back(best_fit_origin_20);
+    const cv::Point2f cv_midpoint_triangle[3]= {best_fit_origin_01, best_fit_origin_12, best_fit_origin_20};
 
     // Find the corner closest to the center of mass.
     // This is the bottom of the triangle.
@@ -2629,6 +3792,34 @@ static bool computeBestFitQuadForContour(
     return true;
 }
 
+static void convertIntContourToFloatContour(
+    const t_opencv_int_contour &in_contour,
+    t_opencv_float_contour &out_contour)
+{
+    // Element-wise copy into a reused buffer 
+    // (cv::Mat::convertTo would allocate a new destination every call)
+    out_contour.resize(in_contour.size());
+    for (size_t point_index = 0; point_index < in_contour.size(); ++point_index)
+    {
+        const cv::Point &in_point = in_contour[point_index];
+
+        out_contour[point_index] = cv::Point2f(static_cast<float>(in_point.x), static_cast<float>(in_point.y));
+    }
+}
+
+static void convertFloatContourToEigenContour(
+    const t_opencv_float_contour &in_contour,
+    std::vector<Eigen::Vector2f> &out_contour)
+{
+    out_contour.resize(in_contour.size());
+    for (size_t point_index = 0; point_index < in_contour.size(); ++point_index)
+    {
+        const cv::Point2f &in_point = in_contour[point_index];
+
+        out_contour[point_index] = Eigen::Vector2f(in_point.x, in_point.y);
+    }
+}
+
 template<typename t_opencv_contour_type>
 cv::Point2f computeSafeCenterOfMassForContour(const t_opencv_contour_type &contour)
 {
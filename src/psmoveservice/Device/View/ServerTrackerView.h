@@ -63,6 +63,13 @@ public:
     double getGain() const;
     void setGain(double value, bool bUpdateConfig);
     
+    // Tracker node only: sends the blobs of every tracking color in the latest frame
+    // to the central host, where a RemoteTracker with the same camera id shows them
+    void sendBlobObservations(const int node_camera_id, const int max_blobs_per_color);
+
+    // Pairs the blobs of the latest frame with the controllers this tracker is following (see BlobAssignment.h),
+    // computeProjectionForController() then uses the assigned blob instead of searching on its own
+    void computeControllerBlobAssignment();
     bool computeProjectionForController(
         const class ServerControllerView* tracked_controller, 
 		const struct CommonDeviceTrackingShape *tracking_shape,
@@ -79,6 +86,12 @@ public:
     
     std::vector<CommonDeviceScreenLocation> projectTrackerRelativePositions(
                                 const std::vector<CommonDevicePosition> &objectPositions) const;
+
+    // Same as above, into a caller owned array of position_count screen locations
+    void projectTrackerRelativePositions(
+        const CommonDevicePosition *objectPositions,
+        const int position_count,
+        CommonDeviceScreenLocation *out_screen_locations) const;
     
     CommonDeviceScreenLocation projectTrackerRelativePosition(const CommonDevicePosition *trackerRelativePosition) const;
     
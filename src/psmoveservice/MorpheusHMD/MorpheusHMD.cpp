@@ -625,6 +625,15 @@ MorpheusHMD::getTrackingShape(CommonDeviceTrackingShape &outTrackingShape) const
 	outTrackingShape.shape.point_cloud.point[6].set(-8.f, -4.5f, -2.5f); // 6
 	outTrackingShape.shape.point_cloud.point[7].set(6.f, -1.f, -24.f); // 7
 	outTrackingShape.shape.point_cloud.point[8].set(-6.f, -1.f, -24.f); // 8
+	outTrackingShape.shape.point_cloud.normal[0].set(0.f, 0.f, 1.f);
+	outTrackingShape.shape.point_cloud.normal[1].set(0.f, 0.f, 1.f);
+	outTrackingShape.shape.point_cloud.normal[2].set(1.f, 0.f, 0.f);
+	outTrackingShape.shape.point_cloud.normal[3].set(0.f, 0.f, 1.f);
+	outTrackingShape.shape.point_cloud.normal[4].set(0.f, 0.f, 1.f);
+	outTrackingShape.shape.point_cloud.normal[5].set(-1.f, 0.f, 0.f);
+	outTrackingShape.shape.point_cloud.normal[6].set(0.f, 0.f, 1.f);
+	outTrackingShape.shape.point_cloud.normal[7].set(0.f, 0.f, -1.f);
+	outTrackingShape.shape.point_cloud.normal[8].set(0.f, 0.f, -1.f);
 	outTrackingShape.shape.point_cloud.point_count = 9;
 }
 
@@ -4,6 +4,7 @@
 #include "ControllerDeviceEnumerator.h"
 #include "MathUtility.h"
 #include "ServerLog.h"
+#include "ServerTrace.h"
 #include "ServerUtility.h"
 #include "WorkerThread.h"
 #include "BluetoothQueries.h"
@@ -326,10 +327,16 @@ protected:
     {
 		// Attempt to read the next sensor update packet from the HMD
 		memcpy(&m_previousHIDInputPacket, &m_currentHIDInputPacket, sizeof(DualShock4DataInput));
-		int res = hid_read(m_hidDevice, (unsigned char*)&m_currentHIDInputPacket, sizeof(DualShock4DataInput));
+		int res = -1;
+		{
+			SERVER_TRACE_SCOPE("DualShock4HidPacketProcessor::hid_read");
+			res = hid_read(m_hidDevice, (unsigned char*)&m_currentHIDInputPacket, sizeof(DualShock4DataInput));
+		}
 
 		if (res > 0)
 		{
+			SERVER_TRACE_SCOPE("DualShock4HidPacketProcessor::process_packet");
+
 			PSDualShock4ControllerConfig cfg;
 			m_cfg.fetchValue(cfg);
 
@@ -1,11 +1,24 @@
 #include "PSMoveConfig.h"
 #include "DeviceInterface.h"
+#include "ServerLog.h"
+#include "ServerTrace.h"
 #include "ServerUtility.h"
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-- constants -----
+static const std::chrono::milliseconds k_config_write_delay(500); // quiet period after the last save of a file
+static const std::chrono::milliseconds k_config_max_write_delay(2000); // upper bound while saves keep coming
 
 // Format: {hue center, hue range}, {sat center, sat range}, {val center, val range}
 // All hue angles are 60 degrees apart to maximize hue separation for 6 max tracked colors.
@@ -21,14 +34,252 @@ const CommonHSVColorRange g_default_color_presets[] = {
 };
 const CommonHSVColorRange *k_default_color_presets = g_default_color_presets;
 
+//-- private methods -----
+// Write to a temp file and rename it over the config,
+// so a crash mid-write never leaves a truncated config behind
+static void write_config_file(const std::string &path, const boost::property_tree::ptree &pt)
+{
+    SERVER_TRACE_SCOPE("PSMoveConfig::write_config_file");
+    const std::string temp_path = path + ".tmp";
+
+    try
+    {
+        boost::property_tree::write_json(temp_path, pt);
+        boost::filesystem::rename(temp_path, path);
+    }
+    catch (std::exception &e)
+    {
+        SERVER_MT_LOG_ERROR("PSMoveConfig::save") << "Failed to write " << path << ": " << e.what();
+    }
+}
+
+//-- private definitions -----
+// Config snapshots waiting to be written, one per file
+struct PendingConfigWrite
+{
+    boost::property_tree::ptree pt;
+    std::chrono::steady_clock::time_point first_save_time;
+    std::chrono::steady_clock::time_point last_save_time;
+};
+
+class ConfigWriterThread
+{
+public:
+    ConfigWriterThread()
+        : m_bRunning(false)
+        , m_bExitSignaled(false)
+    {
+    }
+
+    ~ConfigWriterThread()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_bRunning)
+        {
+            m_bExitSignaled = false;
+            m_thread = std::thread(&ConfigWriterThread::threadFunc, this);
+            m_bRunning = true;
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (!m_bRunning)
+            {
+                return;
+            }
+
+            m_bExitSignaled = true;
+        }
+
+        // The thread writes out everything still pending before it exits
+        m_condition.notify_one();
+        m_thread.join();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bRunning = false;
+    }
+
+    // Returns false (leaving pt untouched) if the writer isn't running
+    // and the caller should write the file itself
+    bool enqueue(const std::string &path, boost::property_tree::ptree &&pt)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_bRunning || m_bExitSignaled)
+        {
+            return false;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        auto it = m_pending.find(path);
+
+        if (it != m_pending.end())
+        {
+            // Coalesce with the write that's already waiting
+            it->second.pt = std::move(pt);
+            it->second.last_save_time = now;
+        }
+        else
+        {
+            PendingConfigWrite &pending = m_pending[path];
+
+            pending.pt = std::move(pt);
+            pending.first_save_time = now;
+            pending.last_save_time = now;
+        }
+
+        m_condition.notify_one();
+
+        return true;
+    }
+
+    // A load should see the latest save, even if it hasn't hit the disk yet
+    bool fetchPending(const std::string &path, boost::property_tree::ptree &out_pt)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(path);
+
+        if (it != m_pending.end())
+        {
+            out_pt = it->second.pt;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Held while a config file is being written or read
+    inline std::mutex &getFileMutex() { return m_file_mutex; }
+
+private:
+    void threadFunc()
+    {
+        ServerUtility::set_current_thread_name("Config Writer Thread");
+        trace_set_thread_name("Config Writer Thread");
+
+        std::vector<std::pair<std::string, boost::property_tree::ptree>> ready_writes;
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        for (;;)
+        {
+            // Pull out every file whose quiet period has passed (or everything when exiting)
+            const auto now = std::chrono::steady_clock::now();
+            auto next_deadline = std::chrono::steady_clock::time_point::max();
+
+            for (auto it = m_pending.begin(); it != m_pending.end(); )
+            {
+                const auto deadline =
+                    std::min(it->second.last_save_time + k_config_write_delay,
+                             it->second.first_save_time + k_config_max_write_delay);
+
+                if (m_bExitSignaled || deadline <= now)
+                {
+                    ready_writes.push_back(std::make_pair(it->first, std::move(it->second.pt)));
+                    it = m_pending.erase(it);
+                }
+                else
+                {
+                    next_deadline = std::min(next_deadline, deadline);
+                    ++it;
+                }
+            }
+
+            if (!ready_writes.empty())
+            {
+                // Take the file lock before letting go of the queue,
+                // so a load can't slip in between and read the old file
+                std::lock_guard<std::mutex> file_lock(m_file_mutex);
+                lock.unlock();
+
+                for (auto &write : ready_writes)
+                {
+                    write_config_file(write.first, write.second);
+                }
+                ready_writes.clear();
+
+                lock.lock();
+            }
+            else if (m_bExitSignaled)
+            {
+                break;
+            }
+            else if (next_deadline == std::chrono::steady_clock::time_point::max())
+            {
+                m_condition.wait(lock);
+            }
+            else
+            {
+                m_condition.wait_until(lock, next_deadline);
+            }
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::map<std::string, PendingConfigWrite> m_pending;
+    std::mutex m_file_mutex;
+    std::thread m_thread;
+    bool m_bRunning;
+    bool m_bExitSignaled;
+};
+
+//-- globals -----
+static ConfigWriterThread g_config_writer;
+static std::string g_config_directory_override;
+
+//-- public methods -----
 PSMoveConfig::PSMoveConfig(const std::string &fnamebase)
 : ConfigFileBase(fnamebase)
 {
 }
 
+void
+PSMoveConfig::startBackgroundWriter()
+{
+    g_config_writer.start();
+}
+
+void
+PSMoveConfig::stopBackgroundWriter()
+{
+    g_config_writer.stop();
+}
+
+void
+PSMoveConfig::setConfigDirectory(const std::string &directory)
+{
+    g_config_directory_override = directory;
+}
+
 const std::string
 PSMoveConfig::getConfigPath()
 {
+    // Only touch the file system the first time
+    if (!m_configPath.empty())
+    {
+        return m_configPath;
+    }
+
+    if (!g_config_directory_override.empty())
+    {
+        boost::filesystem::path configpath(g_config_directory_override);
+        boost::filesystem::create_directories(configpath);
+        configpath /= ConfigFileBase + ".json";
+        m_configPath = configpath.string();
+
+        return m_configPath;
+    }
+
     const char *homedir;
 #ifdef _WIN32
     size_t homedir_buffer_req_size;
@@ -49,13 +300,24 @@ PSMoveConfig::getConfigPath()
     boost::filesystem::create_directory(configpath);
     configpath /= ConfigFileBase + ".json";
     std::cout << "Config file name: " << configpath << std::endl;
-    return configpath.string();
+    m_configPath = configpath.string();
+
+    return m_configPath;
 }
 
 void
 PSMoveConfig::save()
 {
-    boost::property_tree::write_json(getConfigPath(), config2ptree());
+    // Snapshot the config on the calling thread, the disk write happens on the writer thread
+    const std::string configPath = getConfigPath();
+    boost::property_tree::ptree pt = config2ptree();
+
+    if (!g_config_writer.enqueue(configPath, std::move(pt)))
+    {
+        std::lock_guard<std::mutex> file_lock(g_config_writer.getFileMutex());
+
+        write_config_file(configPath, pt);
+    }
 }
 
 bool
@@ -65,12 +327,22 @@ PSMoveConfig::load()
     boost::property_tree::ptree pt;
     std::string configPath = getConfigPath();
 
-    if ( boost::filesystem::exists( configPath ) )
+    if (g_config_writer.fetchPending(configPath, pt))
     {
-        boost::property_tree::read_json(configPath, pt);
         ptree2config(pt);
         bLoadedOk = true;
     }
+    else
+    {
+        std::lock_guard<std::mutex> file_lock(g_config_writer.getFileMutex());
+
+        if ( boost::filesystem::exists( configPath ) )
+        {
+            boost::property_tree::read_json(configPath, pt);
+            ptree2config(pt);
+            bLoadedOk = true;
+        }
+    }
 
     return bLoadedOk;
 }
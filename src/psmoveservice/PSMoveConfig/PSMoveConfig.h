@@ -14,6 +14,17 @@ public:
     PSMoveConfig(const std::string &fnamebase = std::string("PSMoveConfig"));
     void save();
     bool load();
+
+    // Once the background writer is running, save() only snapshots the config and returns.
+    // Repeated saves of the same file are coalesced and written out after a short quiet period.
+    // Without the writer (e.g. in the tools) save() writes synchronously.
+    static void startBackgroundWriter();
+    // Writes out every pending config and stops the writer thread
+    static void stopBackgroundWriter();
+
+    // Keep every config file in the given directory instead of the per-user PSMoveService one
+    // (e.g. a scratch directory for tests and benchmarks). Set before any config is loaded.
+    static void setConfigDirectory(const std::string &directory);
     
     std::string ConfigFileBase;
 
@@ -44,6 +55,8 @@ public:
 
 private:
     const std::string getConfigPath();
+
+    std::string m_configPath;
 };
 /*
 Note that PSMoveConfig is an abstract class because it has 2 pure virtual functions.
@@ -38,6 +38,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "PSMoveController.h"
 #include "ControllerDeviceEnumerator.h"
 #include "ServerLog.h"
+#include "ServerTrace.h"
 #include "ServerUtility.h"
 #include "BluetoothQueries.h"
 #include "MathAlignment.h"
@@ -366,19 +367,25 @@ protected:
 
 		// Attempt to read the next sensor update packet from the HMD
         int res = -1;
-		if (m_model == _psmove_controller_ZCM2)
-		{
-			memcpy(&m_previousHIDInputPacket.data.zcm2, &m_currentHIDInputPacket.data.zcm2, sizeof(PSMoveDataInputZCM2));
-			res= hid_read_timeout(m_hidDevice, (unsigned char*)&m_currentHIDInputPacket.data.zcm2, sizeof(PSMoveDataInputZCM2), cfg.poll_timeout_ms);
-		}
-		else
 		{
-			memcpy(&m_previousHIDInputPacket.data.zcm1, &m_currentHIDInputPacket.data.zcm1, sizeof(PSMoveDataInputZCM1));
-			res= hid_read_timeout(m_hidDevice, (unsigned char*)&m_currentHIDInputPacket.data.zcm1, sizeof(PSMoveDataInputZCM1), cfg.poll_timeout_ms);
+			SERVER_TRACE_SCOPE("PSMoveHidPacketProcessor::hid_read");
+
+			if (m_model == _psmove_controller_ZCM2)
+			{
+				memcpy(&m_previousHIDInputPacket.data.zcm2, &m_currentHIDInputPacket.data.zcm2, sizeof(PSMoveDataInputZCM2));
+				res= hid_read_timeout(m_hidDevice, (unsigned char*)&m_currentHIDInputPacket.data.zcm2, sizeof(PSMoveDataInputZCM2), cfg.poll_timeout_ms);
+			}
+			else
+			{
+				memcpy(&m_previousHIDInputPacket.data.zcm1, &m_currentHIDInputPacket.data.zcm1, sizeof(PSMoveDataInputZCM1));
+				res= hid_read_timeout(m_hidDevice, (unsigned char*)&m_currentHIDInputPacket.data.zcm1, sizeof(PSMoveDataInputZCM1), cfg.poll_timeout_ms);
+			}
 		}
 
 		if (res > 0)
 		{
+			SERVER_TRACE_SCOPE("PSMoveHidPacketProcessor::process_packet");
+
 			// https://github.com/hrl7/node-psvr/blob/master/lib/psvr.js
 			PSMoveControllerInputState newState;
 
@@ -0,0 +1,659 @@
+// -- includes -----
+#include "RemoteTracker.h"
+#include "RemoteTrackerLink.h"
+#include "ServerLog.h"
+#include "ServerUtility.h"
+#include "MathUtility.h"
+#include "PSMoveProtocol.pb.h"
+#include "TrackerDeviceEnumerator.h"
+#include "opencv2/opencv.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+// -- constants -----
+#define REMOTE_TRACKER_STATE_BUFFER_MAX 16
+
+// -- public methods
+// -- Remote Tracker Config
+const int RemoteTrackerConfig::CONFIG_VERSION = 1;
+
+RemoteTrackerConfig::RemoteTrackerConfig(const std::string &fnamebase)
+    : PSMoveConfig(fnamebase)
+    , is_valid(false)
+    , max_poll_failure_count(100)
+    , camera_id(0)
+    , max_frame_age_ms(100.0)
+    , frame_width(640)
+    , frame_height(480)
+    , frame_rate(60)
+    , focalLengthX(554.2563) // pixels, same defaults as the PS3 Eye
+    , focalLengthY(554.2563) // pixels
+    , principalX(320.0) // pixels
+    , principalY(240.0) // pixels
+    , hfov(60.0) // degrees
+    , vfov(45.0) // degrees
+    , zNear(10.0) // cm
+    , zFar(200.0) // cm
+    , distortionK1(0.0)
+    , distortionK2(0.0)
+    , distortionK3(0.0)
+    , distortionP1(0.0)
+    , distortionP2(0.0)
+{
+    pose.clear();
+
+    SharedColorPresets.table_name.clear();
+    for (int preset_index = 0; preset_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++preset_index)
+    {
+        SharedColorPresets.color_presets[preset_index] = k_default_color_presets[preset_index];
+    }
+};
+
+const boost::property_tree::ptree
+RemoteTrackerConfig::config2ptree()
+{
+    boost::property_tree::ptree pt;
+
+    pt.put("is_valid", is_valid);
+    pt.put("version", RemoteTrackerConfig::CONFIG_VERSION);
+    pt.put("max_poll_failure_count", max_poll_failure_count);
+    pt.put("camera_id", camera_id);
+    pt.put("max_frame_age_ms", max_frame_age_ms);
+    pt.put("frame_width", frame_width);
+    pt.put("frame_height", frame_height);
+    pt.put("frame_rate", frame_rate);
+    pt.put("focalLengthX", focalLengthX);
+    pt.put("focalLengthY", focalLengthY);
+    pt.put("principalX", principalX);
+    pt.put("principalY", principalY);
+    pt.put("hfov", hfov);
+    pt.put("vfov", vfov);
+    pt.put("zNear", zNear);
+    pt.put("zFar", zFar);
+    pt.put("distortionK1", distortionK1);
+    pt.put("distortionK2", distortionK2);
+    pt.put("distortionK3", distortionK3);
+    pt.put("distortionP1", distortionP1);
+    pt.put("distortionP2", distortionP2);
+
+    pt.put("pose.orientation.w", pose.Orientation.w);
+    pt.put("pose.orientation.x", pose.Orientation.x);
+    pt.put("pose.orientation.y", pose.Orientation.y);
+    pt.put("pose.orientation.z", pose.Orientation.z);
+    pt.put("pose.position.x", pose.PositionCm.x);
+    pt.put("pose.position.y", pose.PositionCm.y);
+    pt.put("pose.position.z", pose.PositionCm.z);
+
+    writeColorPropertyPresetTable(&SharedColorPresets, pt);
+
+    return pt;
+}
+
+void
+RemoteTrackerConfig::ptree2config(const boost::property_tree::ptree &pt)
+{
+    int config_version = pt.get<int>("version", 0);
+    if (config_version == RemoteTrackerConfig::CONFIG_VERSION)
+    {
+        is_valid = pt.get<bool>("is_valid", false);
+        max_poll_failure_count = pt.get<long>("max_poll_failure_count", 100);
+        camera_id = pt.get<int>("camera_id", camera_id);
+        max_frame_age_ms = pt.get<double>("max_frame_age_ms", max_frame_age_ms);
+        frame_width = pt.get<double>("frame_width", frame_width);
+        frame_height = pt.get<double>("frame_height", frame_height);
+        frame_rate = pt.get<double>("frame_rate", frame_rate);
+        focalLengthX = pt.get<double>("focalLengthX", focalLengthX);
+        focalLengthY = pt.get<double>("focalLengthY", focalLengthY);
+        principalX = pt.get<double>("principalX", principalX);
+        principalY = pt.get<double>("principalY", principalY);
+        hfov = pt.get<double>("hfov", hfov);
+        vfov = pt.get<double>("vfov", vfov);
+        zNear = pt.get<double>("zNear", zNear);
+        zFar = pt.get<double>("zFar", zFar);
+        distortionK1 = pt.get<double>("distortionK1", distortionK1);
+        distortionK2 = pt.get<double>("distortionK2", distortionK2);
+        distortionK3 = pt.get<double>("distortionK3", distortionK3);
+        distortionP1 = pt.get<double>("distortionP1", distortionP1);
+        distortionP2 = pt.get<double>("distortionP2", distortionP2);
+
+        pose.Orientation.w = pt.get<float>("pose.orientation.w", 1.0);
+        pose.Orientation.x = pt.get<float>("pose.orientation.x", 0.0);
+        pose.Orientation.y = pt.get<float>("pose.orientation.y", 0.0);
+        pose.Orientation.z = pt.get<float>("pose.orientation.z", 0.0);
+        pose.PositionCm.x = pt.get<float>("pose.position.x", 0.0);
+        pose.PositionCm.y = pt.get<float>("pose.position.y", 0.0);
+        pose.PositionCm.z = pt.get<float>("pose.position.z", 0.0);
+
+        readColorPropertyPresetTable(pt, &SharedColorPresets);
+    }
+    else
+    {
+        SERVER_LOG_WARNING("RemoteTrackerConfig") <<
+            "Config version " << config_version << " does not match expected version " <<
+            RemoteTrackerConfig::CONFIG_VERSION << ", Using defaults.";
+    }
+}
+
+// -- Remote Tracker
+RemoteTracker::RemoteTracker()
+    : cfg()
+    , DevicePath()
+    , bIsOpen(false)
+    , bHasWarnedFrameSize(false)
+    , FrameBuffer()
+    , FrameWidth(0)
+    , FrameHeight(0)
+    , ReceivedFrame()
+    , PaintedBounds()
+    , NextPollSequenceNumber(0)
+    , TrackerStates()
+{
+    ReceivedFrame.clear();
+}
+
+RemoteTracker::~RemoteTracker()
+{
+    if (getIsOpen())
+    {
+        SERVER_LOG_ERROR("~RemoteTracker") << "Tracker deleted without calling close() first!";
+    }
+}
+
+// -- IDeviceInterface
+bool RemoteTracker::matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const
+{
+    // Down-cast the enumerator so we can use the correct get_path.
+    const TrackerDeviceEnumerator *pEnum = static_cast<const TrackerDeviceEnumerator *>(enumerator);
+
+    bool matches = false;
+
+    if (pEnum->get_device_type() == CommonDeviceState::RemoteTracker)
+    {
+        std::string enumerator_path = pEnum->get_path();
+
+        matches = (enumerator_path == DevicePath);
+    }
+
+    return matches;
+}
+
+bool RemoteTracker::open(const DeviceEnumerator *enumerator)
+{
+    const TrackerDeviceEnumerator *tracker_enumerator = static_cast<const TrackerDeviceEnumerator *>(enumerator);
+    const char *cur_dev_path = tracker_enumerator->get_path();
+
+    bool bSuccess = false;
+
+    if (getIsOpen())
+    {
+        SERVER_LOG_WARNING("RemoteTracker::open") << "RemoteTracker(" << cur_dev_path << ") already open. Ignoring request.";
+        bSuccess = true;
+    }
+    else
+    {
+        SERVER_LOG_INFO("RemoteTracker::open") << "Opening RemoteTracker(" << cur_dev_path << ")";
+
+        DevicePath = cur_dev_path;
+
+        // Load the config file, named after the device path.
+        // By default RemoteTracker_N shows the node camera with id N.
+        cfg = RemoteTrackerConfig(DevicePath);
+        cfg.camera_id = tracker_enumerator->get_remote_tracker_index();
+        cfg.load();
+
+        // Save the config back out again in case defaults changed
+        cfg.save();
+
+        FrameWidth = static_cast<int>(cfg.frame_width);
+        FrameHeight = static_cast<int>(cfg.frame_height);
+        FrameBuffer.assign(static_cast<size_t>(FrameWidth * FrameHeight * 3), 0);
+        PaintedBounds.clear();
+        updatePaintColors();
+
+        if (!RemoteTrackerLink::getInstance()->getIsReceiving())
+        {
+            SERVER_LOG_WARNING("RemoteTracker::open") << "The remote tracker link isn't receiving, RemoteTracker(" << cur_dev_path << ") will stay dark";
+        }
+
+        bHasWarnedFrameSize = false;
+        NextPollSequenceNumber = 0;
+        bIsOpen = true;
+        bSuccess = true;
+    }
+
+    return bSuccess;
+}
+
+bool RemoteTracker::getIsOpen() const
+{
+    return bIsOpen;
+}
+
+bool RemoteTracker::getIsReadyToPoll() const
+{
+    return getIsOpen();
+}
+
+IDeviceInterface::ePollResult RemoteTracker::poll()
+{
+    IDeviceInterface::ePollResult result = IDeviceInterface::_PollResultFailure;
+
+    if (getIsOpen())
+    {
+        RemoteTrackerLink *link = RemoteTrackerLink::getInstance();
+        std::chrono::time_point<std::chrono::high_resolution_clock> receive_time;
+        bool bNewFrame = false;
+
+        link->pollPackets();
+
+        if (link->fetchLatestFrame(cfg.camera_id, ReceivedFrame, receive_time))
+        {
+            const std::chrono::duration<double, std::milli> queued_time = std::chrono::high_resolution_clock::now() - receive_time;
+            const double frame_age_ms = static_cast<double>(ReceivedFrame.capture_age_us) / 1000.0 + queued_time.count();
+
+            if (ReceivedFrame.frame_width != FrameWidth || ReceivedFrame.frame_height != FrameHeight)
+            {
+                if (!bHasWarnedFrameSize)
+                {
+                    SERVER_LOG_WARNING("RemoteTracker::poll") <<
+                        "RemoteTracker(" << DevicePath << ") expects " << FrameWidth << "x" << FrameHeight <<
+                        " frames but camera " << cfg.camera_id << " sends " <<
+                        ReceivedFrame.frame_width << "x" << ReceivedFrame.frame_height << ", ignoring them";
+                    bHasWarnedFrameSize = true;
+                }
+            }
+            else if (frame_age_ms <= cfg.max_frame_age_ms)
+            {
+                updateIntrinsicsFromFrame(ReceivedFrame);
+                paintFrame(ReceivedFrame);
+                bNewFrame = true;
+            }
+        }
+
+        // New data available. Keep iterating.
+        // Otherwise the device is still in a valid state, the node just hasn't sent anything.
+        result = bNewFrame ? IDeviceInterface::_PollResultSuccessNewData : IDeviceInterface::_PollResultSuccessNoData;
+
+        {
+            RemoteTrackerState newState;
+
+            // Increment the sequence for every new polling packet
+            newState.PollSequenceNumber = NextPollSequenceNumber;
+            ++NextPollSequenceNumber;
+
+            // Make room for new entry if at the max queue size
+            if (TrackerStates.size() >= REMOTE_TRACKER_STATE_BUFFER_MAX)
+            {
+                TrackerStates.erase(TrackerStates.begin(), TrackerStates.begin() + TrackerStates.size() - REMOTE_TRACKER_STATE_BUFFER_MAX);
+            }
+
+            TrackerStates.push_back(newState);
+        }
+    }
+
+    return result;
+}
+
+void RemoteTracker::close()
+{
+    if (bIsOpen)
+    {
+        FrameBuffer.clear();
+        PaintedBounds.clear();
+        DevicePath = "";
+        bIsOpen = false;
+    }
+    else
+    {
+        SERVER_LOG_INFO("RemoteTracker::close") << "RemoteTracker already closed. Ignoring request.";
+    }
+}
+
+long RemoteTracker::getMaxPollFailureCount() const
+{
+    return cfg.max_poll_failure_count;
+}
+
+CommonDeviceState::eDeviceType RemoteTracker::getDeviceType() const
+{
+    return CommonDeviceState::RemoteTracker;
+}
+
+const CommonDeviceState *RemoteTracker::getState(int lookBack) const
+{
+    const int queueSize = static_cast<int>(TrackerStates.size());
+    const CommonDeviceState * result =
+        (lookBack < queueSize) ? &TrackerStates.at(queueSize - lookBack - 1) : nullptr;
+
+    return result;
+}
+
+// -- ITrackerInterface
+ITrackerInterface::eDriverType RemoteTracker::getDriverType() const
+{
+    // No driver of its own, report the closest match
+    return ITrackerInterface::Generic_Webcam;
+}
+
+std::string RemoteTracker::getUSBDevicePath() const
+{
+    return DevicePath;
+}
+
+bool RemoteTracker::getVideoFrameDimensions(
+    int *out_width,
+    int *out_height,
+    int *out_stride) const
+{
+    if (out_width != nullptr)
+    {
+        *out_width = FrameWidth;
+    }
+
+    if (out_height != nullptr)
+    {
+        *out_height = FrameHeight;
+    }
+
+    if (out_stride != nullptr)
+    {
+        *out_stride = FrameWidth * 3; // BGR
+    }
+
+    return getIsOpen();
+}
+
+const unsigned char *RemoteTracker::getVideoFrameBuffer() const
+{
+    return FrameBuffer.empty() ? nullptr : FrameBuffer.data();
+}
+
+void RemoteTracker::loadSettings()
+{
+    // The frame size is fixed while open, the tracker view's buffers are sized from it
+    const double frame_width = cfg.frame_width;
+    const double frame_height = cfg.frame_height;
+
+    cfg.load();
+    cfg.frame_width = frame_width;
+    cfg.frame_height = frame_height;
+
+    updatePaintColors();
+}
+
+void RemoteTracker::saveSettings()
+{
+    cfg.save();
+}
+
+void RemoteTracker::setFrameWidth(double value, bool bUpdateConfig)
+{
+    // Set by the node camera
+}
+
+double RemoteTracker::getFrameWidth() const
+{
+    return static_cast<double>(FrameWidth);
+}
+
+void RemoteTracker::setFrameHeight(double value, bool bUpdateConfig)
+{
+    // Set by the node camera
+}
+
+double RemoteTracker::getFrameHeight() const
+{
+    return static_cast<double>(FrameHeight);
+}
+
+void RemoteTracker::setFrameRate(double value, bool bUpdateConfig)
+{
+    if (bUpdateConfig)
+    {
+        cfg.frame_rate = value;
+    }
+}
+
+double RemoteTracker::getFrameRate() const
+{
+    return cfg.frame_rate;
+}
+
+void RemoteTracker::setExposure(double value, bool bUpdateConfig)
+{
+    // Set on the node
+}
+
+double RemoteTracker::getExposure() const
+{
+    return 0.0;
+}
+
+void RemoteTracker::setGain(double value, bool bUpdateConfig)
+{
+    // Set on the node
+}
+
+double RemoteTracker::getGain() const
+{
+    return 0.0;
+}
+
+void RemoteTracker::getCameraIntrinsics(
+    float &outFocalLengthX, float &outFocalLengthY,
+    float &outPrincipalX, float &outPrincipalY,
+    float &outDistortionK1, float &outDistortionK2, float &outDistortionK3,
+    float &outDistortionP1, float &outDistortionP2) const
+{
+    outFocalLengthX = static_cast<float>(cfg.focalLengthX);
+    outFocalLengthY = static_cast<float>(cfg.focalLengthY);
+    outPrincipalX = static_cast<float>(cfg.principalX);
+    outPrincipalY = static_cast<float>(cfg.principalY);
+    outDistortionK1 = static_cast<float>(cfg.distortionK1);
+    outDistortionK2 = static_cast<float>(cfg.distortionK2);
+    outDistortionK3 = static_cast<float>(cfg.distortionK3);
+    outDistortionP1 = static_cast<float>(cfg.distortionP1);
+    outDistortionP2 = static_cast<float>(cfg.distortionP2);
+}
+
+void RemoteTracker::setCameraIntrinsics(
+    float focalLengthX, float focalLengthY,
+    float principalX, float principalY,
+    float distortionK1, float distortionK2, float distortionK3,
+    float distortionP1, float distortionP2)
+{
+    // Only lasts until the next packet, the node camera's calibration wins
+    cfg.focalLengthX = focalLengthX;
+    cfg.focalLengthY = focalLengthY;
+    cfg.principalX = principalX;
+    cfg.principalY = principalY;
+    cfg.distortionK1 = distortionK1;
+    cfg.distortionK2 = distortionK2;
+    cfg.distortionK3 = distortionK3;
+    cfg.distortionP1 = distortionP1;
+    cfg.distortionP2 = distortionP2;
+}
+
+CommonDevicePose RemoteTracker::getTrackerPose() const
+{
+    return cfg.pose;
+}
+
+void RemoteTracker::setTrackerPose(
+    const struct CommonDevicePose *pose)
+{
+    cfg.pose = *pose;
+    cfg.save();
+}
+
+void RemoteTracker::getFOV(float &outHFOV, float &outVFOV) const
+{
+    outHFOV = static_cast<float>(cfg.hfov);
+    outVFOV = static_cast<float>(cfg.vfov);
+}
+
+void RemoteTracker::getZRange(float &outZNear, float &outZFar) const
+{
+    outZNear = static_cast<float>(cfg.zNear);
+    outZFar = static_cast<float>(cfg.zFar);
+}
+
+void RemoteTracker::gatherTrackerOptions(
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+    // No tracker specific options
+}
+
+bool RemoteTracker::setOptionIndex(
+    const std::string &option_name,
+    int option_index)
+{
+    return false;
+}
+
+bool RemoteTracker::getOptionIndex(
+    const std::string &option_name,
+    int &out_option_index) const
+{
+    return false;
+}
+
+void RemoteTracker::gatherTrackingColorPresets(
+    const std::string &controller_serial,
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+    // The blobs were already told apart by color on the node,
+    // every device gets the shared presets the blobs are painted with
+    for (int list_index = 0; list_index < MAX_TRACKING_COLOR_TYPES; ++list_index)
+    {
+        const CommonHSVColorRange &hsvRange = cfg.SharedColorPresets.color_presets[list_index];
+        const eCommonTrackingColorID colorType = static_cast<eCommonTrackingColorID>(list_index);
+
+        PSMoveProtocol::TrackingColorPreset *colorPreset = settings->add_color_presets();
+        colorPreset->set_color_type(static_cast<PSMoveProtocol::TrackingColorType>(colorType));
+        colorPreset->set_hue_center(hsvRange.hue_range.center);
+        colorPreset->set_hue_range(hsvRange.hue_range.range);
+        colorPreset->set_saturation_center(hsvRange.saturation_range.center);
+        colorPreset->set_saturation_range(hsvRange.saturation_range.range);
+        colorPreset->set_value_center(hsvRange.value_range.center);
+        colorPreset->set_value_range(hsvRange.value_range.range);
+    }
+}
+
+void RemoteTracker::setTrackingColorPreset(
+    const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    const CommonHSVColorRange *preset)
+{
+    cfg.SharedColorPresets.color_presets[color] = *preset;
+    cfg.save();
+
+    updatePaintColors();
+}
+
+void RemoteTracker::getTrackingColorPreset(
+    const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    CommonHSVColorRange *out_preset) const
+{
+    *out_preset = cfg.SharedColorPresets.color_presets[color];
+}
+
+// -- private methods
+void RemoteTracker::updateIntrinsicsFromFrame(const RemoteTrackerFrame &frame)
+{
+    const RemoteTrackerIntrinsics &intrinsics = frame.intrinsics;
+
+    if (static_cast<float>(cfg.focalLengthX) != intrinsics.focal_length_x ||
+        static_cast<float>(cfg.focalLengthY) != intrinsics.focal_length_y ||
+        static_cast<float>(cfg.principalX) != intrinsics.principal_x ||
+        static_cast<float>(cfg.principalY) != intrinsics.principal_y ||
+        static_cast<float>(cfg.distortionK1) != intrinsics.distortion_k1 ||
+        static_cast<float>(cfg.distortionK2) != intrinsics.distortion_k2 ||
+        static_cast<float>(cfg.distortionK3) != intrinsics.distortion_k3 ||
+        static_cast<float>(cfg.distortionP1) != intrinsics.distortion_p1 ||
+        static_cast<float>(cfg.distortionP2) != intrinsics.distortion_p2)
+    {
+        setCameraIntrinsics(
+            intrinsics.focal_length_x, intrinsics.focal_length_y,
+            intrinsics.principal_x, intrinsics.principal_y,
+            intrinsics.distortion_k1, intrinsics.distortion_k2, intrinsics.distortion_k3,
+            intrinsics.distortion_p1, intrinsics.distortion_p2);
+
+        if (intrinsics.focal_length_x > 0.f && intrinsics.focal_length_y > 0.f)
+        {
+            cfg.hfov = 2.0 * atan(0.5 * FrameWidth / cfg.focalLengthX) * k_real64_radians_to_degreees;
+            cfg.vfov = 2.0 * atan(0.5 * FrameHeight / cfg.focalLengthY) * k_real64_radians_to_degreees;
+        }
+
+        // Only written when the node's calibration changes
+        cfg.save();
+    }
+}
+
+void RemoteTracker::updatePaintColors()
+{
+    for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+    {
+        const CommonHSVColorRange &preset = cfg.SharedColorPresets.color_presets[color_index];
+
+        // Centered on the preset, so the blob search on this tracker always picks the paint back up
+        float hue = fmodf(preset.hue_range.center, 180.f);
+        hue = (hue < 0.f) ? hue + 180.f : hue;
+
+        const cv::Mat hsv(1, 1, CV_8UC3, cv::Scalar(
+            std::min(hue, 179.f),
+            clampf(preset.saturation_range.center, 0.f, 255.f),
+            clampf(preset.value_range.center, 0.f, 255.f)));
+        cv::Mat bgr;
+        cv::cvtColor(hsv, bgr, cv::COLOR_HSV2BGR);
+
+        const cv::Vec3b bgr_color = bgr.at<cv::Vec3b>(0, 0);
+        PaintColors[color_index][0] = bgr_color[0];
+        PaintColors[color_index][1] = bgr_color[1];
+        PaintColors[color_index][2] = bgr_color[2];
+    }
+}
+
+void RemoteTracker::paintFrame(const RemoteTrackerFrame &frame)
+{
+    cv::Mat frame_mat(FrameHeight, FrameWidth, CV_8UC3, FrameBuffer.data());
+
+    // Only the last frame's blobs need clearing, the rest of the frame stays black
+    for (size_t bounds_index = 0; bounds_index + 3 < PaintedBounds.size(); bounds_index += 4)
+    {
+        const cv::Rect painted_rect(
+            cv::Point(PaintedBounds[bounds_index], PaintedBounds[bounds_index + 1]),
+            cv::Point(PaintedBounds[bounds_index + 2], PaintedBounds[bounds_index + 3]));
+
+        frame_mat(painted_rect & cv::Rect(0, 0, FrameWidth, FrameHeight)).setTo(cv::Scalar(0, 0, 0));
+    }
+    PaintedBounds.clear();
+
+    std::vector<cv::Point> hull;
+    for (const RemoteTrackerBlob &blob : frame.blobs)
+    {
+        if (blob.color_id < 0 || blob.color_id >= eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES || blob.point_count < 3)
+        {
+            continue;
+        }
+
+        hull.clear();
+        for (int point_index = 0; point_index < blob.point_count; ++point_index)
+        {
+            const RemoteTrackerPoint &point = frame.points[blob.first_point + point_index];
+
+            hull.push_back(cv::Point(point.x, point.y));
+        }
+
+        const unsigned char *color = PaintColors[blob.color_id];
+        cv::fillConvexPoly(frame_mat, hull.data(), static_cast<int>(hull.size()), cv::Scalar(color[0], color[1], color[2]));
+
+        const cv::Rect bounds = cv::boundingRect(hull);
+        PaintedBounds.push_back(bounds.x);
+        PaintedBounds.push_back(bounds.y);
+        PaintedBounds.push_back(bounds.x + bounds.width);
+        PaintedBounds.push_back(bounds.y + bounds.height);
+    }
+}
@@ -0,0 +1,159 @@
+#ifndef REMOTE_TRACKER_H
+#define REMOTE_TRACKER_H
+
+// -- includes -----
+#include "PSMoveConfig.h"
+#include "DeviceEnumerator.h"
+#include "DeviceInterface.h"
+#include "RemoteTrackerPacket.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <deque>
+
+// -- pre-declarations -----
+namespace PSMoveProtocol
+{
+    class Response_ResultTrackerSettings;
+};
+
+// -- definitions -----
+class RemoteTrackerConfig : public PSMoveConfig
+{
+public:
+    RemoteTrackerConfig(const std::string &fnamebase = "RemoteTrackerConfig");
+
+    virtual const boost::property_tree::ptree config2ptree();
+    virtual void ptree2config(const boost::property_tree::ptree &pt);
+
+    bool is_valid;
+    long max_poll_failure_count;
+    int camera_id; // the tracker node camera this tracker shows, see TrackerManagerConfig::tracker_node_camera_id_base
+    double max_frame_age_ms; // older frames are dropped instead of being fused
+    double frame_width;
+    double frame_height;
+    double frame_rate;
+
+    // Follow the node camera's calibration, updated from its packets
+    double focalLengthX;
+    double focalLengthY;
+    double principalX;
+    double principalY;
+    double hfov;
+    double vfov;
+    double zNear;
+    double zFar;
+    double distortionK1;
+    double distortionK2;
+    double distortionK3;
+    double distortionP1;
+    double distortionP2;
+
+    CommonDevicePose pose;
+    CommonHSVColorRangeTable SharedColorPresets;
+
+    static const int CONFIG_VERSION;
+};
+
+struct RemoteTrackerState : public CommonDeviceState
+{
+    RemoteTrackerState()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        CommonDeviceState::clear();
+        DeviceType = CommonDeviceState::RemoteTracker;
+    }
+};
+
+/// A camera on another host, running the service as a tracker node.
+/// The node only sends the outlines of the blobs it finds (see RemoteTrackerLink),
+/// which are painted back into a black frame in the colors of this tracker's presets
+/// so the regular blob search and pose fitting run on them unchanged.
+/// The tracker's pose is calibrated on the central host like any other tracker.
+class RemoteTracker : public ITrackerInterface {
+public:
+    RemoteTracker();
+    virtual ~RemoteTracker();
+
+    // -- IDeviceInterface
+    bool matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const override;
+    bool open(const DeviceEnumerator *enumerator) override;
+    bool getIsOpen() const override;
+    bool getIsReadyToPoll() const override;
+    IDeviceInterface::ePollResult poll() override;
+    void close() override;
+    long getMaxPollFailureCount() const override;
+    static CommonDeviceState::eDeviceType getDeviceTypeStatic()
+    { return CommonDeviceState::RemoteTracker; }
+    CommonDeviceState::eDeviceType getDeviceType() const override;
+    const CommonDeviceState *getState(int lookBack = 0) const override;
+
+    // -- ITrackerInterface
+    ITrackerInterface::eDriverType getDriverType() const override;
+    std::string getUSBDevicePath() const override;
+    bool getVideoFrameDimensions(int *out_width, int *out_height, int *out_stride) const override;
+    const unsigned char *getVideoFrameBuffer() const override;
+    void loadSettings() override;
+    void saveSettings() override;
+    void setFrameWidth(double value, bool bUpdateConfig) override;
+    double getFrameWidth() const override;
+    void setFrameHeight(double value, bool bUpdateConfig) override;
+    double getFrameHeight() const override;
+    void setFrameRate(double value, bool bUpdateConfig) override;
+    double getFrameRate() const override;
+    void setExposure(double value, bool bUpdateConfig) override;
+    double getExposure() const override;
+    void setGain(double value, bool bUpdateConfig) override;
+    double getGain() const override;
+    void getCameraIntrinsics(
+        float &outFocalLengthX, float &outFocalLengthY,
+        float &outPrincipalX, float &outPrincipalY,
+        float &outDistortionK1, float &outDistortionK2, float &outDistortionK3,
+        float &outDistortionP1, float &outDistortionP2) const override;
+    void setCameraIntrinsics(
+        float focalLengthX, float focalLengthY,
+        float principalX, float principalY,
+        float distortionK1, float distortionK2, float distortionK3,
+        float distortionP1, float distortionP2) override;
+    CommonDevicePose getTrackerPose() const override;
+    void setTrackerPose(const struct CommonDevicePose *pose) override;
+    void getFOV(float &outHFOV, float &outVFOV) const override;
+    void getZRange(float &outZNear, float &outZFar) const override;
+    void gatherTrackerOptions(PSMoveProtocol::Response_ResultTrackerSettings* settings) const override;
+    bool setOptionIndex(const std::string &option_name, int option_index) override;
+    bool getOptionIndex(const std::string &option_name, int &out_option_index) const override;
+    void gatherTrackingColorPresets(const std::string &controller_serial, PSMoveProtocol::Response_ResultTrackerSettings* settings) const override;
+    void setTrackingColorPreset(const std::string &controller_serial, eCommonTrackingColorID color, const CommonHSVColorRange *preset) override;
+    void getTrackingColorPreset(const std::string &controller_serial, eCommonTrackingColorID color, CommonHSVColorRange *out_preset) const override;
+
+    // -- Getters
+    inline const RemoteTrackerConfig &getConfig() const
+    { return cfg; }
+
+private:
+    void updateIntrinsicsFromFrame(const RemoteTrackerFrame &frame);
+    void updatePaintColors();
+    void paintFrame(const RemoteTrackerFrame &frame);
+
+    RemoteTrackerConfig cfg;
+    std::string DevicePath;
+    bool bIsOpen;
+    bool bHasWarnedFrameSize;
+    std::vector<unsigned char> FrameBuffer;
+    int FrameWidth;
+    int FrameHeight;
+
+    // Received blobs, in the BGR color each tracking color's preset is centered on
+    RemoteTrackerFrame ReceivedFrame;
+    unsigned char PaintColors[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES][3];
+    std::vector<int> PaintedBounds; // x0, y0, x1, y1 of every blob painted last frame
+
+    // Read Tracker State
+    int NextPollSequenceNumber;
+    std::deque<RemoteTrackerState> TrackerStates;
+};
+#endif // REMOTE_TRACKER_H
@@ -0,0 +1,336 @@
+// -- includes -----
+#include "RemoteTrackerLink.h"
+#include "ServerLog.h"
+#include <boost/asio.hpp>
+#include <deque>
+#include <string.h>
+#include <vector>
+
+// -- constants -----
+static const int k_max_loopback_packets = 64; // about a second of one camera, older packets get dropped
+static const int k_sequence_restart_gap = 1000; // a sequence number this far behind means the node restarted
+
+// -- private definitions -----
+class IRemoteTrackerTransport
+{
+public:
+    virtual ~IRemoteTrackerTransport() {}
+
+    virtual bool send(const unsigned char *packet, int packet_size) = 0;
+
+    // Non-blocking, returns the size of the packet read or 0 if none is waiting
+    virtual int receive(unsigned char *out_buffer, int buffer_size) = 0;
+};
+
+// Hands the packets straight to the receiving side of the same process
+class RemoteTrackerLoopbackTransport : public IRemoteTrackerTransport
+{
+public:
+    bool send(const unsigned char *packet, int packet_size) override
+    {
+        if (static_cast<int>(m_packets.size()) >= k_max_loopback_packets)
+        {
+            m_packets.pop_front();
+        }
+
+        m_packets.push_back(std::vector<unsigned char>(packet, packet + packet_size));
+
+        return true;
+    }
+
+    int receive(unsigned char *out_buffer, int buffer_size) override
+    {
+        int packet_size = 0;
+
+        while (packet_size == 0 && !m_packets.empty())
+        {
+            const std::vector<unsigned char> &packet = m_packets.front();
+
+            // Oversized packets are dropped, like a datagram truncated by the socket
+            if (static_cast<int>(packet.size()) <= buffer_size)
+            {
+                packet_size = static_cast<int>(packet.size());
+                memcpy(out_buffer, packet.data(), packet.size());
+            }
+
+            m_packets.pop_front();
+        }
+
+        return packet_size;
+    }
+
+private:
+    std::deque<std::vector<unsigned char>> m_packets;
+};
+
+// One datagram per frame, lost or late frames are simply skipped
+class RemoteTrackerUDPTransport : public IRemoteTrackerTransport
+{
+public:
+    RemoteTrackerUDPTransport()
+        : m_io_service()
+        , m_socket(m_io_service)
+        , m_fusion_endpoint()
+    {
+    }
+
+    ~RemoteTrackerUDPTransport()
+    {
+        boost::system::error_code error;
+        m_socket.close(error);
+    }
+
+    bool open(const RemoteTrackerLinkSettings &settings)
+    {
+        using boost::asio::ip::udp;
+        boost::system::error_code error;
+
+        m_socket.open(udp::v4(), error);
+
+        if (!error && settings.bReceive)
+        {
+            m_socket.bind(udp::endpoint(udp::v4(), static_cast<unsigned short>(settings.port)), error);
+        }
+
+        if (!error && settings.bSend)
+        {
+            udp::resolver resolver(m_io_service);
+            udp::resolver::query query(udp::v4(), settings.fusion_host, std::to_string(settings.port));
+            udp::resolver::iterator endpoint_iter = resolver.resolve(query, error);
+
+            if (!error)
+            {
+                m_fusion_endpoint = *endpoint_iter;
+            }
+        }
+
+        if (!error)
+        {
+            m_socket.non_blocking(true, error);
+        }
+
+        if (error)
+        {
+            SERVER_LOG_ERROR("RemoteTrackerUDPTransport::open") << "Failed to open the tracker node socket: " << error.message();
+        }
+
+        return !error;
+    }
+
+    bool send(const unsigned char *packet, int packet_size) override
+    {
+        boost::system::error_code error;
+
+        m_socket.send_to(boost::asio::buffer(packet, packet_size), m_fusion_endpoint, 0, error);
+
+        return !error;
+    }
+
+    int receive(unsigned char *out_buffer, int buffer_size) override
+    {
+        boost::asio::ip::udp::endpoint sender_endpoint;
+        boost::system::error_code error;
+
+        const size_t packet_size =
+            m_socket.receive_from(boost::asio::buffer(out_buffer, buffer_size), sender_endpoint, 0, error);
+
+        // would_block just means there's nothing waiting
+        return error ? 0 : static_cast<int>(packet_size);
+    }
+
+private:
+    boost::asio::io_service m_io_service;
+    boost::asio::ip::udp::socket m_socket;
+    boost::asio::ip::udp::endpoint m_fusion_endpoint;
+};
+
+// -- private methods -----
+static bool is_sequence_number_newer(unsigned int sequence_number, unsigned int other_sequence_number)
+{
+    // Wraps around cleanly
+    return static_cast<int>(sequence_number - other_sequence_number) > 0;
+}
+
+// -- public methods -----
+RemoteTrackerLink::RemoteTrackerLink()
+    : m_settings()
+    , m_transport(nullptr)
+    , m_mailboxes()
+    , m_decoded_frame()
+    , m_dropped_packet_count(0)
+{
+    m_settings.port = 0;
+    m_settings.bSend = false;
+    m_settings.bReceive = false;
+}
+
+RemoteTrackerLink::~RemoteTrackerLink()
+{
+    shutdown();
+}
+
+RemoteTrackerLink *
+RemoteTrackerLink::getInstance()
+{
+    static RemoteTrackerLink link;
+
+    return &link;
+}
+
+bool
+RemoteTrackerLink::startup(const RemoteTrackerLinkSettings &settings)
+{
+    bool bSuccess = true;
+
+    shutdown();
+    m_settings = settings;
+
+    if (!settings.bSend && !settings.bReceive)
+    {
+        // Neither a tracker node nor has remote trackers
+    }
+    else if (settings.transport == "loopback")
+    {
+        m_transport = new RemoteTrackerLoopbackTransport;
+    }
+    else if (settings.transport == "udp")
+    {
+        RemoteTrackerUDPTransport *udp_transport = new RemoteTrackerUDPTransport;
+
+        if (udp_transport->open(settings))
+        {
+            m_transport = udp_transport;
+        }
+        else
+        {
+            delete udp_transport;
+            bSuccess = false;
+        }
+    }
+    else
+    {
+        SERVER_LOG_ERROR("RemoteTrackerLink::startup") << "Unknown remote tracker transport: " << settings.transport;
+        bSuccess = false;
+    }
+
+    if (m_transport != nullptr)
+    {
+        SERVER_LOG_INFO("RemoteTrackerLink::startup") <<
+            "Remote tracker link up (" << settings.transport <<
+            (settings.bSend ? ", sending" : "") <<
+            (settings.bReceive ? ", receiving" : "") << ")";
+    }
+
+    return bSuccess;
+}
+
+void
+RemoteTrackerLink::shutdown()
+{
+    if (m_transport != nullptr)
+    {
+        if (m_dropped_packet_count > 0)
+        {
+            SERVER_LOG_INFO("RemoteTrackerLink::shutdown") << "Dropped " << m_dropped_packet_count << " bad or late remote tracker packets";
+        }
+
+        delete m_transport;
+        m_transport = nullptr;
+    }
+
+    m_mailboxes.clear();
+    m_dropped_packet_count = 0;
+}
+
+bool
+RemoteTrackerLink::sendFrame(const RemoteTrackerFrame &frame)
+{
+    bool bSuccess = false;
+
+    if (getIsSending())
+    {
+        const int packet_size = encodeRemoteTrackerFrame(frame, m_packet_buffer, sizeof(m_packet_buffer));
+
+        bSuccess = packet_size > 0 && m_transport->send(m_packet_buffer, packet_size);
+    }
+
+    return bSuccess;
+}
+
+void
+RemoteTrackerLink::pollPackets()
+{
+    if (!getIsReceiving())
+    {
+        return;
+    }
+
+    int packet_size;
+    while ((packet_size = m_transport->receive(m_packet_buffer, sizeof(m_packet_buffer))) > 0)
+    {
+        if (!decodeRemoteTrackerFrame(m_packet_buffer, packet_size, m_decoded_frame))
+        {
+            ++m_dropped_packet_count;
+            continue;
+        }
+
+        auto mailbox_iter = m_mailboxes.find(m_decoded_frame.camera_id);
+        if (mailbox_iter == m_mailboxes.end())
+        {
+            CameraMailbox new_mailbox;
+            new_mailbox.frame.clear();
+            new_mailbox.last_fetched_sequence_number = 0;
+            new_mailbox.bHasFetched = false;
+            new_mailbox.bHasNewFrame = false;
+
+            mailbox_iter = m_mailboxes.insert(std::make_pair(m_decoded_frame.camera_id, new_mailbox)).first;
+        }
+
+        CameraMailbox &mailbox = mailbox_iter->second;
+        const unsigned int sequence_number = m_decoded_frame.sequence_number;
+
+        // Datagrams can show up out of order, never replace a frame with an older one
+        const bool bOlderThanWaiting =
+            mailbox.bHasNewFrame &&
+            !is_sequence_number_newer(sequence_number, mailbox.frame.sequence_number);
+        const bool bOlderThanFetched =
+            mailbox.bHasFetched &&
+            !is_sequence_number_newer(sequence_number, mailbox.last_fetched_sequence_number) &&
+            static_cast<int>(mailbox.last_fetched_sequence_number - sequence_number) < k_sequence_restart_gap;
+
+        if (bOlderThanWaiting || bOlderThanFetched)
+        {
+            ++m_dropped_packet_count;
+            continue;
+        }
+
+        std::swap(mailbox.frame, m_decoded_frame);
+        mailbox.receive_time = std::chrono::high_resolution_clock::now();
+        mailbox.bHasNewFrame = true;
+    }
+}
+
+bool
+RemoteTrackerLink::fetchLatestFrame(
+    int camera_id,
+    RemoteTrackerFrame &out_frame,
+    std::chrono::time_point<std::chrono::high_resolution_clock> &out_receive_time)
+{
+    auto mailbox_iter = m_mailboxes.find(camera_id);
+
+    if (mailbox_iter == m_mailboxes.end() || !mailbox_iter->second.bHasNewFrame)
+    {
+        return false;
+    }
+
+    CameraMailbox &mailbox = mailbox_iter->second;
+
+    // Swap rather than copy, the mailbox gets the caller's buffers to decode into next time
+    std::swap(out_frame, mailbox.frame);
+    out_receive_time = mailbox.receive_time;
+    mailbox.last_fetched_sequence_number = out_frame.sequence_number;
+    mailbox.bHasFetched = true;
+    mailbox.bHasNewFrame = false;
+
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef REMOTE_TRACKER_LINK_H
+#define REMOTE_TRACKER_LINK_H
+
+// -- includes -----
+#include "RemoteTrackerPacket.h"
+#include <chrono>
+#include <map>
+#include <string>
+
+// -- definitions -----
+struct RemoteTrackerLinkSettings
+{
+    // "loopback" keeps the packets in this process (node and central host in one service, for testing),
+    // "udp" sends them from the tracker nodes to the central host over the network
+    std::string transport;
+    std::string fusion_host; // where a tracker node sends to
+    int port; // where the central host listens
+    bool bSend; // this service is a tracker node
+    bool bReceive; // this service has remote trackers
+};
+
+/// Carries tracker node blob observations to the RemoteTrackers of the central host.
+/// Shared by every tracker of the service, see TrackerManager for the configuration.
+class RemoteTrackerLink
+{
+public:
+    static RemoteTrackerLink *getInstance();
+
+    bool startup(const RemoteTrackerLinkSettings &settings);
+    void shutdown();
+
+    inline bool getIsSending() const
+    { return m_transport != nullptr && m_settings.bSend; }
+    inline bool getIsReceiving() const
+    { return m_transport != nullptr && m_settings.bReceive; }
+
+    // Encodes the frame into one packet, blobs that don't fit are dropped from the end
+    bool sendFrame(const RemoteTrackerFrame &frame);
+
+    // Reads every waiting packet, only the newest frame of each camera is kept
+    void pollPackets();
+
+    // The newest frame of the camera not fetched yet, false if nothing new arrived
+    bool fetchLatestFrame(
+        int camera_id,
+        RemoteTrackerFrame &out_frame,
+        std::chrono::time_point<std::chrono::high_resolution_clock> &out_receive_time);
+
+private:
+    RemoteTrackerLink();
+    ~RemoteTrackerLink();
+
+    struct CameraMailbox
+    {
+        RemoteTrackerFrame frame;
+        std::chrono::time_point<std::chrono::high_resolution_clock> receive_time;
+        unsigned int last_fetched_sequence_number;
+        bool bHasFetched;
+        bool bHasNewFrame;
+    };
+
+    RemoteTrackerLinkSettings m_settings;
+    class IRemoteTrackerTransport *m_transport;
+    std::map<int, CameraMailbox> m_mailboxes;
+    RemoteTrackerFrame m_decoded_frame;
+    unsigned char m_packet_buffer[REMOTE_TRACKER_MAX_PACKET_SIZE];
+    int m_dropped_packet_count;
+};
+
+#endif // REMOTE_TRACKER_LINK_H
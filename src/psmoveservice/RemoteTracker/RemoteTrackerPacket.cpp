@@ -0,0 +1,271 @@
+//-- includes -----
+#include "RemoteTrackerPacket.h"
+#include <assert.h>
+#include <string.h>
+
+//-- constants -----
+static const unsigned int k_packet_magic = 0x54524D50; // "PMRT"
+
+// magic, version, blob count, camera id, sequence number, capture age, frame size, intrinsics
+static const int k_header_size = 4 + 1 + 1 + 2 + 4 + 4 + 2 + 2 + 9 * 4;
+
+// color, point count, area (the points follow)
+static const int k_blob_header_size = 1 + 1 + 4;
+static const int k_point_size = 2 + 2;
+
+static const int k_max_blob_count = 255;
+
+//-- private methods -----
+// Everything goes out little endian, whatever the host
+static unsigned char *write_u8(unsigned char *cursor, unsigned int value)
+{
+    cursor[0] = static_cast<unsigned char>(value & 0xff);
+    return cursor + 1;
+}
+
+static unsigned char *write_u16(unsigned char *cursor, unsigned int value)
+{
+    cursor[0] = static_cast<unsigned char>(value & 0xff);
+    cursor[1] = static_cast<unsigned char>((value >> 8) & 0xff);
+    return cursor + 2;
+}
+
+static unsigned char *write_u32(unsigned char *cursor, unsigned int value)
+{
+    cursor[0] = static_cast<unsigned char>(value & 0xff);
+    cursor[1] = static_cast<unsigned char>((value >> 8) & 0xff);
+    cursor[2] = static_cast<unsigned char>((value >> 16) & 0xff);
+    cursor[3] = static_cast<unsigned char>((value >> 24) & 0xff);
+    return cursor + 4;
+}
+
+static unsigned char *write_f32(unsigned char *cursor, float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return write_u32(cursor, bits);
+}
+
+static const unsigned char *read_u8(const unsigned char *cursor, unsigned int &out_value)
+{
+    out_value = cursor[0];
+    return cursor + 1;
+}
+
+static const unsigned char *read_u16(const unsigned char *cursor, unsigned int &out_value)
+{
+    out_value = static_cast<unsigned int>(cursor[0]) | (static_cast<unsigned int>(cursor[1]) << 8);
+    return cursor + 2;
+}
+
+static const unsigned char *read_u32(const unsigned char *cursor, unsigned int &out_value)
+{
+    out_value =
+        static_cast<unsigned int>(cursor[0]) |
+        (static_cast<unsigned int>(cursor[1]) << 8) |
+        (static_cast<unsigned int>(cursor[2]) << 16) |
+        (static_cast<unsigned int>(cursor[3]) << 24);
+    return cursor + 4;
+}
+
+static const unsigned char *read_f32(const unsigned char *cursor, float &out_value)
+{
+    unsigned int bits;
+    cursor = read_u32(cursor, bits);
+    memcpy(&out_value, &bits, sizeof(out_value));
+    return cursor;
+}
+
+//-- RemoteTrackerFrame -----
+void
+RemoteTrackerFrame::clear()
+{
+    camera_id = 0;
+    sequence_number = 0;
+    capture_age_us = 0;
+    frame_width = 0;
+    frame_height = 0;
+    memset(&intrinsics, 0, sizeof(intrinsics));
+    blobs.clear();
+    points.clear();
+}
+
+void
+RemoteTrackerFrame::addBlob(int color_id, float area, const RemoteTrackerPoint *blob_points, int blob_point_count)
+{
+    RemoteTrackerBlob blob;
+    blob.color_id = color_id;
+    blob.area = area;
+    blob.first_point = static_cast<int>(points.size());
+    blob.point_count = (blob_point_count < REMOTE_TRACKER_MAX_BLOB_POINTS) ? blob_point_count : REMOTE_TRACKER_MAX_BLOB_POINTS;
+
+    for (int point_index = 0; point_index < blob.point_count; ++point_index)
+    {
+        points.push_back(blob_points[(point_index * blob_point_count) / blob.point_count]);
+    }
+
+    blobs.push_back(blob);
+}
+
+//-- public methods -----
+int encodeRemoteTrackerFrame(
+    const RemoteTrackerFrame &frame,
+    unsigned char *out_buffer,
+    const int buffer_size,
+    int *out_encoded_blob_count)
+{
+    if (out_encoded_blob_count != nullptr)
+    {
+        *out_encoded_blob_count = 0;
+    }
+
+    if (buffer_size < k_header_size)
+    {
+        return 0;
+    }
+
+    // Work out how many blobs fit before writing the count into the header
+    int packet_size = k_header_size;
+    int blob_count = 0;
+    for (const RemoteTrackerBlob &blob : frame.blobs)
+    {
+        const int blob_size = k_blob_header_size + blob.point_count * k_point_size;
+
+        if (blob_count >= k_max_blob_count || packet_size + blob_size > buffer_size)
+        {
+            break;
+        }
+
+        packet_size += blob_size;
+        ++blob_count;
+    }
+
+    unsigned char *cursor = out_buffer;
+    cursor = write_u32(cursor, k_packet_magic);
+    cursor = write_u8(cursor, REMOTE_TRACKER_PACKET_VERSION);
+    cursor = write_u8(cursor, static_cast<unsigned int>(blob_count));
+    cursor = write_u16(cursor, static_cast<unsigned int>(frame.camera_id));
+    cursor = write_u32(cursor, frame.sequence_number);
+    cursor = write_u32(cursor, frame.capture_age_us);
+    cursor = write_u16(cursor, static_cast<unsigned int>(frame.frame_width));
+    cursor = write_u16(cursor, static_cast<unsigned int>(frame.frame_height));
+    cursor = write_f32(cursor, frame.intrinsics.focal_length_x);
+    cursor = write_f32(cursor, frame.intrinsics.focal_length_y);
+    cursor = write_f32(cursor, frame.intrinsics.principal_x);
+    cursor = write_f32(cursor, frame.intrinsics.principal_y);
+    cursor = write_f32(cursor, frame.intrinsics.distortion_k1);
+    cursor = write_f32(cursor, frame.intrinsics.distortion_k2);
+    cursor = write_f32(cursor, frame.intrinsics.distortion_k3);
+    cursor = write_f32(cursor, frame.intrinsics.distortion_p1);
+    cursor = write_f32(cursor, frame.intrinsics.distortion_p2);
+
+    for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+    {
+        const RemoteTrackerBlob &blob = frame.blobs[blob_index];
+
+        cursor = write_u8(cursor, static_cast<unsigned int>(blob.color_id));
+        cursor = write_u8(cursor, static_cast<unsigned int>(blob.point_count));
+        cursor = write_f32(cursor, blob.area);
+
+        for (int point_index = 0; point_index < blob.point_count; ++point_index)
+        {
+            const RemoteTrackerPoint &point = frame.points[blob.first_point + point_index];
+
+            cursor = write_u16(cursor, static_cast<unsigned short>(point.x));
+            cursor = write_u16(cursor, static_cast<unsigned short>(point.y));
+        }
+    }
+    assert(cursor - out_buffer == packet_size);
+
+    if (out_encoded_blob_count != nullptr)
+    {
+        *out_encoded_blob_count = blob_count;
+    }
+
+    return packet_size;
+}
+
+bool decodeRemoteTrackerFrame(
+    const unsigned char *buffer,
+    const int packet_size,
+    RemoteTrackerFrame &out_frame)
+{
+    if (packet_size < k_header_size)
+    {
+        return false;
+    }
+
+    const unsigned char *cursor = buffer;
+    const unsigned char *end = buffer + packet_size;
+    unsigned int magic, version, blob_count, camera_id, frame_width, frame_height;
+
+    cursor = read_u32(cursor, magic);
+    cursor = read_u8(cursor, version);
+    if (magic != k_packet_magic || version != REMOTE_TRACKER_PACKET_VERSION)
+    {
+        return false;
+    }
+
+    cursor = read_u8(cursor, blob_count);
+    cursor = read_u16(cursor, camera_id);
+    cursor = read_u32(cursor, out_frame.sequence_number);
+    cursor = read_u32(cursor, out_frame.capture_age_us);
+    cursor = read_u16(cursor, frame_width);
+    cursor = read_u16(cursor, frame_height);
+    cursor = read_f32(cursor, out_frame.intrinsics.focal_length_x);
+    cursor = read_f32(cursor, out_frame.intrinsics.focal_length_y);
+    cursor = read_f32(cursor, out_frame.intrinsics.principal_x);
+    cursor = read_f32(cursor, out_frame.intrinsics.principal_y);
+    cursor = read_f32(cursor, out_frame.intrinsics.distortion_k1);
+    cursor = read_f32(cursor, out_frame.intrinsics.distortion_k2);
+    cursor = read_f32(cursor, out_frame.intrinsics.distortion_k3);
+    cursor = read_f32(cursor, out_frame.intrinsics.distortion_p1);
+    cursor = read_f32(cursor, out_frame.intrinsics.distortion_p2);
+
+    out_frame.camera_id = static_cast<int>(camera_id);
+    out_frame.frame_width = static_cast<int>(frame_width);
+    out_frame.frame_height = static_cast<int>(frame_height);
+    out_frame.blobs.clear();
+    out_frame.points.clear();
+
+    for (unsigned int blob_index = 0; blob_index < blob_count; ++blob_index)
+    {
+        if (end - cursor < k_blob_header_size)
+        {
+            return false;
+        }
+
+        unsigned int color_id, point_count;
+        RemoteTrackerBlob blob;
+
+        cursor = read_u8(cursor, color_id);
+        cursor = read_u8(cursor, point_count);
+        cursor = read_f32(cursor, blob.area);
+
+        if (end - cursor < static_cast<int>(point_count) * k_point_size)
+        {
+            return false;
+        }
+
+        blob.color_id = static_cast<int>(color_id);
+        blob.first_point = static_cast<int>(out_frame.points.size());
+        blob.point_count = static_cast<int>(point_count);
+
+        for (unsigned int point_index = 0; point_index < point_count; ++point_index)
+        {
+            unsigned int x, y;
+            RemoteTrackerPoint point;
+
+            cursor = read_u16(cursor, x);
+            cursor = read_u16(cursor, y);
+            point.x = static_cast<short>(static_cast<unsigned short>(x));
+            point.y = static_cast<short>(static_cast<unsigned short>(y));
+            out_frame.points.push_back(point);
+        }
+
+        out_frame.blobs.push_back(blob);
+    }
+
+    // Trailing bytes mean the sender and receiver disagree on the layout
+    return cursor == end;
+}
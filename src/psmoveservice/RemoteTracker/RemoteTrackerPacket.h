@@ -0,0 +1,72 @@
+#ifndef REMOTE_TRACKER_PACKET_H
+#define REMOTE_TRACKER_PACKET_H
+
+//-- includes -----
+#include <vector>
+
+//-- constants -----
+#define REMOTE_TRACKER_PACKET_VERSION 1
+
+// Keeps a frame in one UDP datagram on an ethernet MTU
+#define REMOTE_TRACKER_MAX_PACKET_SIZE 1400
+
+#define REMOTE_TRACKER_MAX_BLOB_POINTS 255
+
+//-- definitions -----
+struct RemoteTrackerPoint
+{
+    short x, y; // pixels
+};
+
+// The node camera's calibration, sent along so the central host doesn't need its own copy
+struct RemoteTrackerIntrinsics
+{
+    float focal_length_x, focal_length_y;
+    float principal_x, principal_y;
+    float distortion_k1, distortion_k2, distortion_k3;
+    float distortion_p1, distortion_p2;
+};
+
+struct RemoteTrackerBlob
+{
+    int color_id; // eCommonTrackingColorID
+    float area; // pixels, of the blob before its outline was reduced to the hull
+    int first_point; // into RemoteTrackerFrame::points
+    int point_count;
+};
+
+/// The blobs a tracker node found in one camera frame.
+/// Only the convex hull of every blob goes over the wire, not the image.
+struct RemoteTrackerFrame
+{
+    int camera_id;
+    unsigned int sequence_number;
+    unsigned int capture_age_us; // time between the frame's capture and sending it, on the node's clock
+    int frame_width;
+    int frame_height;
+    RemoteTrackerIntrinsics intrinsics;
+    std::vector<RemoteTrackerBlob> blobs;
+    std::vector<RemoteTrackerPoint> points;
+
+    void clear();
+
+    // Outlines past REMOTE_TRACKER_MAX_BLOB_POINTS are thinned out evenly
+    void addBlob(int color_id, float area, const RemoteTrackerPoint *blob_points, int blob_point_count);
+};
+
+// Encodes as many of the frame's blobs as fit in buffer_size, in order, so add the biggest blobs first.
+// Returns the packet size in bytes (0 if not even the header fits).
+int encodeRemoteTrackerFrame(
+    const RemoteTrackerFrame &frame,
+    unsigned char *out_buffer,
+    const int buffer_size,
+    int *out_encoded_blob_count = nullptr);
+
+// Returns false (out_frame left partially written) if the packet is truncated,
+// from another protocol version or not a tracker node packet at all.
+bool decodeRemoteTrackerFrame(
+    const unsigned char *buffer,
+    const int packet_size,
+    RemoteTrackerFrame &out_frame);
+
+#endif // REMOTE_TRACKER_PACKET_H
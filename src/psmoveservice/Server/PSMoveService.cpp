@@ -6,7 +6,9 @@
 #include "ServerRequestHandler.h"
 #include "DeviceManager.h"
 #include "ProtocolVersion.h"
+#include "PSMoveConfig.h"
 #include "ServerLog.h"
+#include "ServerTrace.h"
 #include "SharedTrackerState.h"
 #include "TrackerManager.h"
 #include "USBDeviceManager.h"
@@ -30,6 +32,7 @@
 #if defined(BOOST_POSIX_API)
 #define DAEMON_RUNNING_DIR	"/tmp"
 #define DAEMON_LOCK_FILE	"psmoveserviced.lock"
+#define DAEMON_FRONTEND_LOCK_FILE_FORMAT	"psmoveserviced_frontend_%d.lock"
 #endif // defined(BOOST_POSIX_API)
 
 //-- definitions -----
@@ -39,11 +42,13 @@ public:
     PSMoveServiceImpl()
         : m_io_service()
         , m_signals(m_io_service)
+        , m_trace_signals(m_io_service)
         , m_usb_device_manager()
         , m_device_manager()
         , m_request_handler(&m_device_manager)
         , m_network_manager()
         , m_status()
+        , m_sharing_mode(get_device_sharing_mode())
     {
         // Register to handle the signals that indicate when the server should exit.
         m_signals.add(SIGINT);
@@ -52,6 +57,12 @@ public:
         m_signals.add(SIGQUIT);
 #endif // defined(SIGQUIT)
         m_signals.async_wait(boost::bind(&PSMoveServiceImpl::handle_termination_signal, this));
+
+#if defined(SIGUSR1)
+        // SIGUSR1 dumps the trace event ring without having to connect a client
+        m_trace_signals.add(SIGUSR1);
+        m_trace_signals.async_wait(boost::bind(&PSMoveServiceImpl::handle_trace_dump_signal, this));
+#endif // defined(SIGUSR1)
     }
 
     /// Entry point into boost::application
@@ -66,7 +77,8 @@ public:
             {
                 m_status = context.find<boost::application::status>();
 
-				const TrackerManagerConfig &cfg = DeviceManager::getInstance()->m_tracker_manager->getConfig();
+				// Front-ends never start the device manager, so go through our own instance
+				const TrackerManagerConfig &cfg = m_device_manager.m_tracker_manager->getConfig();
 
                 while (m_status->state() != boost::application::status::stoped)
                 {
@@ -140,6 +152,13 @@ private:
     {
         bool success= true;
 
+        /** Name the main thread's track in the trace and start recording if requested */
+        trace_set_thread_name("main");
+        if (PSMoveService::getInstance()->getProgramSettings()->trace_recording)
+        {
+            trace_set_recording(true);
+        }
+
 		/** Make sure the shared memory directory exists (if non-default path is defined) */
 		#if defined(BOOST_INTERPROCESS_SHARED_DIR_PATH)
 		boost::filesystem::path shared_mem_dir(BOOST_INTERPROCESS_SHARED_DIR_PATH);
@@ -154,8 +173,16 @@ private:
 		}
 		#endif // BOOST_INTERPROCESS_SHARED_DIR_PATH       
 
-        /** Setup the usb async transfer thread before we attempt to initialize the trackers */
+        /** Move config file writes off the main thread before any device can save its config */
         if (success)
+        {
+            PSMoveConfig::startBackgroundWriter();
+        }
+
+        /** Setup the usb async transfer thread before we attempt to initialize the trackers
+            A front-end leaves all of the devices to the broker
+        */
+        if (success && m_sharing_mode != _eDeviceSharingMode_Frontend)
         {
             if (!m_usb_device_manager.startup())
             {
@@ -165,7 +192,7 @@ private:
         }
 
         /** Setup the controller manager */
-        if (success)
+        if (success && m_sharing_mode != _eDeviceSharingMode_Frontend)
         {
             if (!m_device_manager.startup())
             {
@@ -179,7 +206,9 @@ private:
 		*/
         if (success)
         {
-            if (!m_network_manager.startup(&m_io_service, &m_request_handler))
+            const int server_port= PSMoveService::getInstance()->getProgramSettings()->server_port;
+
+            if (!m_network_manager.startup(&m_io_service, &m_request_handler, server_port))
             {
                 SERVER_LOG_FATAL("PSMoveService") << "Failed to initialize the service network manager";
                 success= false;
@@ -189,7 +218,7 @@ private:
         /** Setup the request handler */
         if (success)
         {
-            if (!m_request_handler.startup())
+            if (!m_request_handler.startup(m_sharing_mode))
             {
                 SERVER_LOG_FATAL("PSMoveService") << "Failed to initialize the service request handler";
                 success= false;
@@ -202,20 +231,34 @@ private:
     /// Called in the application loop.
     void update()
     {
+        SERVER_TRACE_SCOPE("PSMoveService::update");
+
         /** Update an async requests still waiting to complete */
-        m_request_handler.update();
+        {
+            SERVER_TRACE_SCOPE("ServerRequestHandler::update");
+            m_request_handler.update();
+        }
 
-        /** Process any async results from the USB transfer thread */
-        m_usb_device_manager.update();
+        if (m_sharing_mode != _eDeviceSharingMode_Frontend)
+        {
+            /** Process any async results from the USB transfer thread */
+            {
+                SERVER_TRACE_SCOPE("USBDeviceManager::update");
+                m_usb_device_manager.update();
+            }
 
-        /**
-         Update the list of active tracked controllers
-         Send controller updates to the client
-         */
-        m_device_manager.update();
+            /**
+             Update the list of active tracked controllers
+             Send controller updates to the client
+             */
+            m_device_manager.update();
+        }
 
         /** Process incoming/outgoing networking requests */
-        m_network_manager.update();
+        {
+            SERVER_TRACE_SCOPE("ServerNetworkManager::update");
+            m_network_manager.update();
+        }
     }
 
     void shutdown()
@@ -227,12 +270,38 @@ private:
         // Must be before device manager since closing a connection can modify device state
         m_network_manager.shutdown();
 
-        // Disconnect any actively connected controllers
-        m_device_manager.shutdown();
+        // A front-end never started any devices
+        if (m_sharing_mode != _eDeviceSharingMode_Frontend)
+        {
+            // Disconnect any actively connected controllers
+            m_device_manager.shutdown();
 
-        // Shutdown the usb async request thread
-        // Must be after device manager since devices can have an active usb connection
-        m_usb_device_manager.shutdown();
+            // Shutdown the usb async request thread
+            // Must be after device manager since devices can have an active usb connection
+            m_usb_device_manager.shutdown();
+        }
+
+        // Write out any config changes still waiting on the writer thread
+        // Must be last since closing devices can save their configs
+        PSMoveConfig::stopBackgroundWriter();
+    }
+
+    static eDeviceSharingMode get_device_sharing_mode()
+    {
+        const PSMoveService::ProgramSettings *settings= PSMoveService::getInstance()->getProgramSettings();
+
+        if (settings->device_broker)
+        {
+            return _eDeviceSharingMode_Broker;
+        }
+        else if (settings->device_frontend)
+        {
+            return _eDeviceSharingMode_Frontend;
+        }
+        else
+        {
+            return _eDeviceSharingMode_None;
+        }
     }
 
     void handle_termination_signal()
@@ -242,6 +311,15 @@ private:
         m_status->state(boost::application::status::stoped);
     }
 
+    void handle_trace_dump_signal()
+    {
+        SERVER_LOG_INFO("PSMoveService") << "Received trace dump signal.";
+        trace_write_chrome_json(TRACE_DEFAULT_DUMP_FILE, nullptr);
+
+        // Keep listening for further dump requests
+        m_trace_signals.async_wait(boost::bind(&PSMoveServiceImpl::handle_trace_dump_signal, this));
+    }
+
 private:   
     // The io_service used to perform asynchronous operations.
     boost::asio::io_service m_io_service;
@@ -249,6 +327,9 @@ private:
     // The signal_set is used to register for process termination notifications.
     boost::asio::signal_set m_signals;
 
+    // The signal_set used to request a trace dump (SIGUSR1)
+    boost::asio::signal_set m_trace_signals;
+
     // Manages all control and bulk transfer requests in another thread
     USBDeviceManager m_usb_device_manager;
 
@@ -263,6 +344,9 @@ private:
 
     // Whether the application should keep running or not
     std::shared_ptr<boost::application::status> m_status;
+
+    // Whether we own the devices and share them, or serve clients from another instance's devices
+    eDeviceSharingMode m_sharing_mode;
 };
 
 static void parse_program_settings(
@@ -295,6 +379,19 @@ static void parse_program_settings(
 	{
 		settings.working_directory.clear();
 	}
+
+    settings.trace_recording = options_map.count("trace") > 0;
+    settings.device_broker = options_map.count("broker") > 0;
+    settings.device_frontend = options_map.count("frontend") > 0;
+
+    if (options_map.count("port"))
+    {
+        settings.server_port = options_map["port"].as<int>();
+    }
+    else
+    {
+        settings.server_port = 0;
+    }
 }
 
 #if defined(BOOST_WINDOWS_API) 
@@ -330,6 +427,22 @@ bool win32_service_management_action(
 			service_options+= "\"";
         }
 
+        if (options_map.count("broker"))
+        {
+            service_options+= " --broker";
+        }
+
+        if (options_map.count("frontend"))
+        {
+            service_options+= " --frontend";
+        }
+
+        if (options_map.count("port"))
+        {
+            service_options+= " --port ";
+            service_options+= std::to_string(options_map["port"].as<int>());
+        }
+
         boost::system::error_code ec;
 		boost::application::example::install_windows_service(
             boost::application::setup_arg(options_map["name"].as<std::string>()), 
@@ -396,7 +509,7 @@ bool win32_service_management_action(
 #endif // defined(BOOST_WINDOWS_API)
 
 #if defined(BOOST_POSIX_API)
-void daemonize()
+void daemonize(const char *lock_file_name)
 {
     // already a daemon
     if(getppid()==1)
@@ -445,7 +558,7 @@ void daemonize()
     
     // Create the lock file
     {
-        int lock_fp = open(DAEMON_LOCK_FILE, O_RDWR|O_CREAT, 0640);
+        int lock_fp = open(lock_file_name, O_RDWR|O_CREAT, 0640);
         
         // can not open
         if (lock_fp < 0)
@@ -507,6 +620,10 @@ int PSMoveService::exec(int argc, char *argv[])
         ("log_level,l", boost::program_options::value<std::string>(), "The level of logging to use: trace, debug, info, warning, error, fatal")
         ("admin_password,p", boost::program_options::value<std::string>(), "Remember the admin password for this machine (optional)")
 		("working_directory", boost::program_options::value<std::string>(), "service working directory (optional)")
+        ("trace", "Record a timeline of the service loop from startup (dump it with SIGUSR1 or a DUMP_TRACE request)")
+        ("broker", "Own the devices and share their state with front-end instances")
+        ("frontend", "Serve clients from the devices of a broker instance instead of opening any (use with --port)")
+        ("port", boost::program_options::value<int>(), "Listen on this port instead of the configured one (optional)")
 #if defined(BOOST_WINDOWS_API)
         (",i", "install service")
         (",u", "uninstall service")
@@ -534,6 +651,18 @@ int PSMoveService::exec(int argc, char *argv[])
         return 0;
     }
 
+    if (m_settings.device_broker && m_settings.device_frontend)
+    {
+        std::cout << "Can't run as both a broker and a front-end" << std::endl;
+        return 1;
+    }
+
+    if (m_settings.device_frontend && m_settings.server_port <= 0)
+    {
+        std::cout << "A front-end needs a --port of its own to listen on" << std::endl;
+        return 1;
+    }
+
     if (options_map.count("-h"))
     {
         std::cout << "Valid Options: " << std::endl;
@@ -553,7 +682,18 @@ int PSMoveService::exec(int argc, char *argv[])
     #if defined(BOOST_POSIX_API)
     if (options_map.count("-d"))
     {
-        daemonize();
+        // Front-ends can run alongside the broker and each other, one per port
+        if (m_settings.device_frontend)
+        {
+            char lock_file_name[64];
+            snprintf(lock_file_name, sizeof(lock_file_name), DAEMON_FRONTEND_LOCK_FILE_FORMAT, m_settings.server_port);
+
+            daemonize(lock_file_name);
+        }
+        else
+        {
+            daemonize(DAEMON_LOCK_FILE);
+        }
     }
     #endif // defined(BOOST_POSIX_API)
 
@@ -571,7 +711,16 @@ int PSMoveService::exec(int argc, char *argv[])
 	}
 
     // initialize logging system
-    log_init(this->getProgramSettings()->log_level, "PSMoveService.log");
+    // (front-ends log to their own file so they don't fight over the broker's)
+    if (m_settings.device_frontend)
+    {
+        log_init(this->getProgramSettings()->log_level,
+            "PSMoveService_frontend_" + std::to_string(m_settings.server_port) + ".log");
+    }
+    else
+    {
+        log_init(this->getProgramSettings()->log_level, "PSMoveService.log");
+    }
 
     // Start the service app
     SERVER_LOG_INFO("main") << "Starting PSMoveService v" << PSM_RELEASE_VERSION_STRING << " (protocol v" << PSM_PROTOCOL_VERSION_STRING << ")";
@@ -13,6 +13,10 @@ public:
         std::string log_level;
         std::string admin_password;
 		std::string working_directory;
+        bool trace_recording;
+        bool device_broker;   // Share device state with front-end instances
+        bool device_frontend; // Serve clients from a broker instance's device state
+        int server_port;      // Overrides the configured port when > 0
     };
 
     PSMoveService();
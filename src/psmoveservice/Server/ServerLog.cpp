@@ -1,22 +1,138 @@
 //-- includes -----
 #include "ServerLog.h"
 
-#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <ostream>
+#include <thread>
+#include <vector>
 
 #ifdef _MSC_VER
 #pragma warning (disable: 4996) // 'This function or variable may be unsafe': localtime
 #endif
 
+//-- constants -----
+static const size_t k_log_ring_capacity = 1024; // log lines buffered per thread
+static const std::chrono::milliseconds k_log_flush_interval(10);
+
+//-- definitions -----
+struct LogRecord
+{
+	std::chrono::system_clock::time_point timestamp;
+	e_log_severity_level level;
+	std::string text;
+};
+
+// Single producer (the thread that logs) / single consumer (the writer thread) ring of log records.
+// Records are moved in and out, so the strings built by the producer are never copied.
+class LogRecordRing
+{
+public:
+	LogRecordRing(size_t capacity)
+		: m_records(capacity + 1)
+		, m_head(0)
+		, m_tail(0)
+		, m_bThreadExited(false)
+	{
+	}
+
+	// Producer side
+	bool push(LogRecord &record)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		const size_t next_head = (head + 1) % m_records.size();
+
+		if (next_head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		m_records[head] = std::move(record);
+		m_head.store(next_head, std::memory_order_release);
+
+		return true;
+	}
+
+	// Consumer side
+	bool pop(LogRecord &out_record)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (tail == m_head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		out_record = std::move(m_records[tail]);
+		m_tail.store((tail + 1) % m_records.size(), std::memory_order_release);
+
+		return true;
+	}
+
+	inline void markThreadExited() { m_bThreadExited.store(true); }
+	inline bool hasThreadExited() const { return m_bThreadExited.load(); }
+
+private:
+	std::vector<LogRecord> m_records;
+	std::atomic<size_t> m_head;
+	std::atomic<size_t> m_tail;
+	std::atomic_bool m_bThreadExited;
+};
+
+// Owned by each thread that logs. Lets the writer thread know when the ring can be dropped.
+struct LogRecordRingHandle
+{
+	std::shared_ptr<LogRecordRing> ring;
+
+	~LogRecordRingHandle()
+	{
+		if (ring)
+		{
+			ring->markThreadExited();
+		}
+	}
+};
+
 //-- globals -----
 e_log_severity_level g_min_log_level= _log_severity_level_info;
 std::ostream *g_console_stream= nullptr;
 std::ostream *g_file_stream = nullptr;
-std::mutex *g_logger_mutex = nullptr;
+
+// Writer thread state
+static std::atomic_bool g_log_running(false);
+static std::atomic_bool g_log_exit_signaled(false);
+static std::atomic<int> g_log_dropped_count(0);
+static std::thread g_log_thread;
+static std::mutex g_log_wake_mutex;
+static std::condition_variable g_log_wake_condition;
+
+// Every thread's ring. The mutex is only taken when a thread logs for the first time
+// and by the writer thread when collecting.
+static std::mutex g_log_ring_registry_mutex;
+static std::vector<std::shared_ptr<LogRecordRing>> g_log_rings;
+static thread_local LogRecordRingHandle t_log_ring_handle;
+
+// Not every exit path calls log_dispose().
+// Make sure the writer thread is drained and joined before the globals above go away.
+static struct LogShutdownGuard
+{
+	~LogShutdownGuard()
+	{
+		log_dispose();
+	}
+} g_log_shutdown_guard;
+
+//-- prototypes -----
+static void log_thread_func();
+static size_t log_collect_records(std::vector<LogRecord> &out_records);
+static void log_write_records(std::vector<LogRecord> &records, std::string &output_buffer);
+static void log_append_timestamp_prefix(const std::chrono::system_clock::time_point &timestamp, std::string &output_buffer);
 
 //-- public implementation -----
 void log_init(const std::string &log_level, const std::string &log_filename)
@@ -55,11 +171,24 @@ void log_init(const std::string &log_level, const std::string &log_filename)
 	{
 		g_file_stream = new std::ofstream(log_filename, std::ofstream::out);
 	}
-	g_logger_mutex = new std::mutex();
+
+	g_log_dropped_count.store(0);
+	g_log_exit_signaled.store(false);
+	g_log_thread = std::thread(log_thread_func);
+	g_log_running.store(true);
 }
 
 void log_dispose()
 {
+	if (g_log_running.load())
+	{
+		// Stop accepting new lines, then let the writer thread drain what's left
+		g_log_running.store(false);
+		g_log_exit_signaled.store(true);
+		g_log_wake_condition.notify_one();
+		g_log_thread.join();
+	}
+
 	if (g_console_stream != nullptr)
 	{
 		g_console_stream->flush();
@@ -69,16 +198,10 @@ void log_dispose()
 
 	if (g_file_stream != nullptr)
 	{
-		g_console_stream->flush();
+		g_file_stream->flush();
 		delete g_file_stream;
 		g_file_stream = nullptr;
 	}
-
-	if (g_logger_mutex != nullptr)
-	{
-		delete g_logger_mutex;
-		g_logger_mutex = nullptr;
-	}
 }
 
 bool log_can_emit_level(e_log_severity_level level)
@@ -88,54 +211,170 @@ bool log_can_emit_level(e_log_severity_level level)
 
 std::string log_get_timestamp_prefix()
 {
-    auto now = std::chrono::system_clock::now();
-    auto seconds = std::chrono::time_point_cast<std::chrono::seconds>(now);
-    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now - seconds);
-    time_t in_time_t = std::chrono::system_clock::to_time_t(now);
+	std::string prefix;
 
-    std::stringstream ss;
-    ss << "[" << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %H:%M:%S") << "." << milliseconds.count() << "]: ";
+	log_append_timestamp_prefix(std::chrono::system_clock::now(), prefix);
 
-    return ss.str();
+	return prefix;
 }
 
 //-- member functions -----
-LoggerStream::LoggerStream(bool bEmit) :
-	m_bEmitLine(bEmit)
+LoggerStream::LoggerStream(e_log_severity_level level)
+	: m_lineBuffer()
+	, m_timestamp(std::chrono::system_clock::now())
+	, m_level(level)
 {
 }
 
 LoggerStream::~LoggerStream()
 {
-	write_line();
+	if (!g_log_running.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	// First log line from this thread: give it a ring
+	if (!t_log_ring_handle.ring)
+	{
+		t_log_ring_handle.ring = std::make_shared<LogRecordRing>(k_log_ring_capacity);
+
+		std::lock_guard<std::mutex> lock(g_log_ring_registry_mutex);
+		g_log_rings.push_back(t_log_ring_handle.ring);
+	}
+
+	LogRecord record;
+	record.timestamp = m_timestamp;
+	record.level = m_level;
+	record.text = m_lineBuffer.str();
+
+	if (t_log_ring_handle.ring->push(record))
+	{
+		// Don't sit on errors until the next flush
+		if (m_level >= _log_severity_level_error)
+		{
+			g_log_wake_condition.notify_one();
+		}
+	}
+	else
+	{
+		// The writer thread can't keep up. Never block the caller.
+		++g_log_dropped_count;
+	}
+}
+
+//-- private implementation -----
+static void log_thread_func()
+{
+	std::vector<LogRecord> records;
+	std::string output_buffer;
+
+	records.reserve(k_log_ring_capacity);
+	output_buffer.reserve(k_log_ring_capacity * 128);
+
+	while (!g_log_exit_signaled.load())
+	{
+		if (log_collect_records(records) > 0)
+		{
+			log_write_records(records, output_buffer);
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock(g_log_wake_mutex);
+			g_log_wake_condition.wait_for(lock, k_log_flush_interval);
+		}
+	}
+
+	// Final drain
+	while (log_collect_records(records) > 0)
+	{
+		log_write_records(records, output_buffer);
+	}
 }
 
-void LoggerStream::write_line()
+static size_t log_collect_records(std::vector<LogRecord> &out_records)
 {
-	if (m_bEmitLine)
+	std::lock_guard<std::mutex> lock(g_log_ring_registry_mutex);
+	LogRecord record;
+
+	out_records.clear();
+	for (auto it = g_log_rings.begin(); it != g_log_rings.end(); )
 	{
-		const std::string line = m_lineBuffer.str();
+		LogRecordRing *ring = it->get();
+
+		// Check for exit before draining, so nothing pushed before the thread went away is lost
+		const bool bThreadExited = ring->hasThreadExited();
 
-		if (g_console_stream != nullptr)
+		while (ring->pop(record))
 		{
-			*g_console_stream << line << std::endl;
+			out_records.push_back(std::move(record));
 		}
 
-		if (g_file_stream != nullptr)
+		if (bThreadExited)
 		{
-			*g_file_stream << line << std::endl;
+			it = g_log_rings.erase(it);
+		}
+		else
+		{
+			++it;
 		}
 	}
+
+	// Interleave the lines of all threads in the order they were logged
+	std::stable_sort(
+		out_records.begin(), out_records.end(),
+		[](const LogRecord &a, const LogRecord &b) {
+			return a.timestamp < b.timestamp;
+	});
+
+	return out_records.size();
 }
 
-ThreadSafeLoggerStream::ThreadSafeLoggerStream(bool bEmit) :
-	LoggerStream(bEmit)
+static void log_write_records(std::vector<LogRecord> &records, std::string &output_buffer)
 {
+	output_buffer.clear();
+
+	const int dropped_count = g_log_dropped_count.exchange(0);
+	if (dropped_count > 0)
+	{
+		log_append_timestamp_prefix(std::chrono::system_clock::now(), output_buffer);
+		output_buffer.append("ServerLog - dropped ");
+		output_buffer.append(std::to_string(dropped_count));
+		output_buffer.append(" log lines\n");
+	}
+
+	for (const LogRecord &record : records)
+	{
+		log_append_timestamp_prefix(record.timestamp, output_buffer);
+		output_buffer.append(record.text);
+		output_buffer.push_back('\n');
+	}
+
+	// One write and one flush per batch
+	if (g_console_stream != nullptr)
+	{
+		g_console_stream->write(output_buffer.data(), output_buffer.size());
+		g_console_stream->flush();
+	}
+
+	if (g_file_stream != nullptr)
+	{
+		g_file_stream->write(output_buffer.data(), output_buffer.size());
+		g_file_stream->flush();
+	}
 }
 
-void ThreadSafeLoggerStream::write_line()
+static void log_append_timestamp_prefix(const std::chrono::system_clock::time_point &timestamp, std::string &output_buffer)
 {
-	std::lock_guard<std::mutex> lock(*g_logger_mutex);
+	auto seconds = std::chrono::time_point_cast<std::chrono::seconds>(timestamp);
+	auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp - seconds);
+	time_t in_time_t = std::chrono::system_clock::to_time_t(timestamp);
+
+	char date_time[32];
+	strftime(date_time, sizeof(date_time), "%Y-%m-%d %H:%M:%S", std::localtime(&in_time_t));
 
-	LoggerStream::write_line();
-}
\ No newline at end of file
+	output_buffer.push_back('[');
+	output_buffer.append(date_time);
+	output_buffer.push_back('.');
+	output_buffer.append(std::to_string(milliseconds.count()));
+	output_buffer.append("]: ");
+}
@@ -2,6 +2,7 @@
 #define SERVER_LOG_H
 
 //-- includes -----
+#include <chrono>
 #include <string>
 #include <sstream>
 
@@ -17,39 +18,38 @@ enum e_log_severity_level
 };
 
 //-- includes -----
+// Collects one log line on the calling thread.
+// The streamed values are formatted right here, on the calling thread: most of them are
+// references to state the caller goes on to change (or to temporaries), so only their text can
+// be handed off safely. Only the timestamp prefix, the console/file writes and their locking move
+// to the logging thread. On destruction the line is handed (with its raw timestamp) to the calling
+// thread's lock-free ring buffer. The logging thread formats the timestamp and writes the lines in batches.
 class LoggerStream
 {
 protected:
 	std::ostringstream m_lineBuffer;
-	bool m_bEmitLine;
+	std::chrono::system_clock::time_point m_timestamp;
+	e_log_severity_level m_level;
 
 public:
-	LoggerStream(bool bEmit);
-	virtual ~LoggerStream();
+	LoggerStream(e_log_severity_level level);
+	~LoggerStream();
 
 	// accepts just about anything
 	template<class T>
 	LoggerStream &operator<<(const T &x)
 	{
-		if (m_bEmitLine)
-		{
-			m_lineBuffer << x;
-		}
+		m_lineBuffer << x;
 
 		return *this;
 	}
-
-protected:
-	virtual void write_line();
 };
 
-class ThreadSafeLoggerStream : public LoggerStream
+// Turns a whole logger stream expression into void,
+// so that it can sit in the false branch of the level check in SELECT_LOG_STREAM
+struct LoggerStreamVoidify
 {
-public:
-	ThreadSafeLoggerStream(bool bEmit);
-
-protected:
-	void write_line() override;
+	inline void operator&(const LoggerStream &) {}
 };
 
 //-- interface -----
@@ -59,27 +59,26 @@ bool log_can_emit_level(e_log_severity_level level);
 std::string log_get_timestamp_prefix();
 
 //-- macros -----
-#define SELECT_LOG_STREAM(level) LoggerStream(log_can_emit_level(level))
-#define SELECT_MT_LOG_STREAM(level) ThreadSafeLoggerStream(log_can_emit_level(level))
+// The level check happens before the stream (or anything streamed into it) is evaluated,
+// so filtered out log lines cost a single compare
+#define SELECT_LOG_STREAM(level) !log_can_emit_level(level) ? (void)0 : LoggerStreamVoidify() & LoggerStream(level)
 
-// Non Thread Safe Logger Macros
-// Almost everything is on the main thread, so you almost always want to use these
-#define SERVER_LOG_TRACE(function_name) SELECT_LOG_STREAM(_log_severity_level_trace) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_DEBUG(function_name) SELECT_LOG_STREAM(_log_severity_level_debug) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_INFO(function_name) SELECT_LOG_STREAM(_log_severity_level_info) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_WARNING(function_name) SELECT_LOG_STREAM(_log_severity_level_warning) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_ERROR(function_name) SELECT_LOG_STREAM(_log_severity_level_error) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_LOG_FATAL(function_name) SELECT_LOG_STREAM(_log_severity_level_fatal) << log_get_timestamp_prefix() << function_name << " - "
+// Logger Macros
+// Every thread writes into its own ring buffer, so these are safe to use from any thread
+#define SERVER_LOG_TRACE(function_name) SELECT_LOG_STREAM(_log_severity_level_trace) << function_name << " - "
+#define SERVER_LOG_DEBUG(function_name) SELECT_LOG_STREAM(_log_severity_level_debug) << function_name << " - "
+#define SERVER_LOG_INFO(function_name) SELECT_LOG_STREAM(_log_severity_level_info) << function_name << " - "
+#define SERVER_LOG_WARNING(function_name) SELECT_LOG_STREAM(_log_severity_level_warning) << function_name << " - "
+#define SERVER_LOG_ERROR(function_name) SELECT_LOG_STREAM(_log_severity_level_error) << function_name << " - "
+#define SERVER_LOG_FATAL(function_name) SELECT_LOG_STREAM(_log_severity_level_fatal) << function_name << " - "
 
 // Thread Safe Logger Macros
-// Uses thread safe locking before appending data to the logging stream
-// Only use this when logging from other threads
-#define SERVER_MT_LOG_TRACE(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_trace) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_DEBUG(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_debug) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_INFO(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_info) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_WARNING(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_warning) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_ERROR(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_error) << log_get_timestamp_prefix() << function_name << " - "
-#define SERVER_MT_LOG_FATAL(function_name) SELECT_MT_LOG_STREAM(_log_severity_level_fatal) << log_get_timestamp_prefix() << function_name << " - "
- 
-#endif  // SERVER_LOG_H
+// Kept for the worker thread code that already uses them, same as the macros above
+#define SERVER_MT_LOG_TRACE(function_name) SERVER_LOG_TRACE(function_name)
+#define SERVER_MT_LOG_DEBUG(function_name) SERVER_LOG_DEBUG(function_name)
+#define SERVER_MT_LOG_INFO(function_name) SERVER_LOG_INFO(function_name)
+#define SERVER_MT_LOG_WARNING(function_name) SERVER_LOG_WARNING(function_name)
+#define SERVER_MT_LOG_ERROR(function_name) SERVER_LOG_ERROR(function_name)
+#define SERVER_MT_LOG_FATAL(function_name) SERVER_LOG_FATAL(function_name)
 
+#endif  // SERVER_LOG_H
@@ -2,10 +2,13 @@
 #include "ServerNetworkManager.h"
 #include "ServerRequestHandler.h"
 #include "ServerLog.h"
+#include "ServerStatistics.h"
+#include "ServerTrace.h"
 #include "PackedMessage.h"
 #include "PSMoveProtocolInterface.h"
 #include "PSMoveProtocol.pb.h"
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -34,6 +37,10 @@ typedef std::pair<int, ClientConnectionPtr> t_id_client_connection_pair;
 //-- constants -----
 const int PSMOVE_SERVER_PORT = 9512;
 
+// Most bytes taken off a client's TCP socket per read.
+// Every complete request in them gets handled before the next read starts.
+const size_t k_tcp_request_read_chunk_size = 4096;
+
 //-- private implementation -----
 class IServerNetworkEventListener
 {
@@ -132,7 +139,7 @@ public:
         send_connection_info();
 
         // Wait for incoming requests from the client
-        start_tcp_read_request_header();
+        start_tcp_read_requests();
     }
 
     void stop()
@@ -217,25 +224,40 @@ public:
             {
                 if (m_pending_responses.size() > 0)
                 {
-                    ResponsePtr response= m_pending_responses.front();
+                    // Everything queued so far goes out in a single gather write
+                    const size_t response_count= m_pending_responses.size();
+
+                    if (m_response_write_buffers.size() < response_count)
+                    {
+                        m_response_write_buffers.resize(response_count);
+                    }
+                    m_response_gather_buffers.clear();
 
-                    m_packed_response.set_msg(response);
-                    m_packed_response.pack(m_response_write_buffer);
+                    for (size_t response_index= 0; response_index < response_count; ++response_index)
+                    {
+                        data_buffer &write_buffer= m_response_write_buffers[response_index];
+
+                        m_packed_response.set_msg(m_pending_responses[response_index]);
+                        m_packed_response.pack(write_buffer);
+                        m_response_gather_buffers.push_back(boost::asio::buffer(write_buffer));
 
-                    SERVER_LOG_DEBUG("ClientConnection::start_tcp_write_queued_response") << "Sending TCP response";
-                    SERVER_LOG_DEBUG("   ") << show_hex(m_response_write_buffer);
-                    SERVER_LOG_DEBUG("   ") << m_packed_response.get_msg()->ByteSize() << " bytes";
+                        SERVER_LOG_DEBUG("ClientConnection::start_tcp_write_queued_response") << "Sending TCP response";
+                        SERVER_LOG_DEBUG("   ") << show_hex(write_buffer);
+                        SERVER_LOG_DEBUG("   ") << m_packed_response.get_msg()->ByteSize() << " bytes";
+                    }
 
-                    // The queue should prevent us from writing more than one request as once
+                    // The queue should prevent us from starting a write while one is in flight
                     assert(!m_has_pending_tcp_write);
                     m_has_pending_tcp_write= true;
+                    m_writing_response_count= response_count;
+                    m_tcp_write_start_time= std::chrono::high_resolution_clock::now();
                     write_in_progress= true;
 
-                    // Start an asynchronous operation to send a heartbeat message.
+                    // Start an asynchronous operation to send the responses.
                     // NOTE: Even if the write completes immediate, the callback will only be called from io_service::poll()
                     boost::asio::async_write(
                         m_tcp_socket, 
-                        boost::asio::buffer(m_response_write_buffer),
+                        m_response_gather_buffers,
                         boost::bind(&ClientConnection::handle_write_response_complete, this, _1));
                 }
             }
@@ -277,6 +299,7 @@ public:
                         // The queue should prevent us from writing more than one data frame at once
                         assert(!m_has_pending_udp_write);
                         m_has_pending_udp_write= true;
+                        m_udp_write_start_time= std::chrono::high_resolution_clock::now();
                         write_in_progress= true;
 
                         // Start an asynchronous operation to send the data frame
@@ -316,9 +339,12 @@ private:
     bool m_is_udp_remote_endpoint_bound;
 
     vector<uint8_t> m_request_read_buffer;
+    size_t m_request_read_size; // bytes of m_request_read_buffer not handled yet
     PackedMessage<PSMoveProtocol::Request> m_packed_request;
 
-    vector<uint8_t> m_response_write_buffer;
+    vector<data_buffer> m_response_write_buffers;
+    vector<asio::const_buffer> m_response_gather_buffers;
+    size_t m_writing_response_count; // responses at the front of m_pending_responses being written
     PackedMessage<PSMoveProtocol::Response> m_packed_response;
 
     uint8_t m_output_dataframe_buffer[HEADER_SIZE+MAX_OUTPUT_DATA_FRAME_MESSAGE_SIZE];
@@ -331,6 +357,8 @@ private:
     bool m_connection_stopped;
     bool m_has_pending_tcp_write;
     bool m_has_pending_udp_write;
+    std::chrono::high_resolution_clock::time_point m_tcp_write_start_time;
+    std::chrono::high_resolution_clock::time_point m_udp_write_start_time;
 
     ClientConnection(
         IServerNetworkEventListener *network_event_listener,
@@ -345,8 +373,11 @@ private:
         , m_udp_remote_endpoint()
         , m_is_udp_remote_endpoint_bound(false)
         , m_request_read_buffer()
+        , m_request_read_size(0)
         , m_packed_request(std::shared_ptr<PSMoveProtocol::Request>(new PSMoveProtocol::Request()))
-        , m_response_write_buffer()
+        , m_response_write_buffers()
+        , m_response_gather_buffers()
+        , m_writing_response_count(0)
         , m_packed_response()
         , m_packed_output_dataframe()
         , m_pending_responses()
@@ -355,6 +386,8 @@ private:
         , m_connection_stopped(false)
         , m_has_pending_tcp_write(false)
         , m_has_pending_udp_write(false)
+        , m_tcp_write_start_time()
+        , m_udp_write_start_time()
     {
         memset(m_output_dataframe_buffer, 0, sizeof(m_output_dataframe_buffer));
         next_connection_id++;
@@ -376,116 +409,137 @@ private:
         start_tcp_write_queued_response();
     }
 
-    void start_tcp_read_request_header()
+    void start_tcp_read_requests()
     {
-        SERVER_LOG_DEBUG("ClientConnection::start_tcp_read_request_header") 
-            << "Start TCP header read on connection id to client " << m_connection_id;
-
-        m_request_read_buffer.resize(HEADER_SIZE);
-        asio::async_read(
-            m_tcp_socket, 
-            asio::buffer(m_request_read_buffer),
+        SERVER_LOG_DEBUG("ClientConnection::start_tcp_read_requests") 
+            << "Start TCP request read on connection id to client " << m_connection_id;
+
+        // Anything left over from the last read is the start of a request whose rest hasn't arrived yet.
+        // Read whatever is available after it.
+        m_request_read_buffer.resize(m_request_read_size + k_tcp_request_read_chunk_size);
+        m_tcp_socket.async_read_some(
+            asio::buffer(&m_request_read_buffer[m_request_read_size], k_tcp_request_read_chunk_size),
             boost::bind(
-                &ClientConnection::handle_tcp_read_request_header, 
+                &ClientConnection::handle_tcp_read_requests, 
                 shared_from_this(),
-                asio::placeholders::error));
+                asio::placeholders::error,
+                asio::placeholders::bytes_transferred));
     }
 
-    void handle_tcp_read_request_header(const boost::system::error_code& error)
+    void handle_tcp_read_requests(const boost::system::error_code& error, size_t bytes_transferred)
     {
         if (!error) 
         {
-            SERVER_LOG_DEBUG("ClientConnection::handle_tcp_read_request_header") 
-                << "Read TCP request header on connection id " << m_connection_id;
-            SERVER_LOG_DEBUG("    ") << show_hex(m_request_read_buffer);
+            SERVER_LOG_DEBUG("ClientConnection::handle_tcp_read_requests") 
+                << "Read " << bytes_transferred << " bytes on connection id " << m_connection_id;
 
-            unsigned msg_len = m_packed_request.decode_header(m_request_read_buffer);
+            m_request_read_size+= bytes_transferred;
 
-            SERVER_LOG_DEBUG("    ") << "Body Size = " << msg_len << " bytes";
+            // Handle every complete request that came in, in the order they were sent
+            size_t read_offset= 0;
+            bool bParsed= true;
 
-            if (msg_len > 0)
+            while (bParsed && m_request_read_size - read_offset >= HEADER_SIZE)
             {
-                start_tcp_read_request_body(msg_len);
-            }
-            else
-            {
-                // If there is no body, jump straight to the handle ready response body callback
-                handle_tcp_read_request_body(boost::system::error_code());
-            }
-        }
-        else
-        {
-            SERVER_LOG_ERROR("ClientConnection::handle_tcp_read_request_header") 
-                << "Failed to read header on connection " << m_connection_id << ": " << error.message();
-            stop();
-        }
-    }
+                const uint8_t *packed_request= &m_request_read_buffer[read_offset];
+                const size_t packed_size= HEADER_SIZE + m_packed_request.decode_header(packed_request, HEADER_SIZE);
 
-    void start_tcp_read_request_body(unsigned msg_len)
-    {
-        SERVER_LOG_DEBUG("ClientConnection::start_tcp_read_request_body") 
-            << "Start TCP request body read on connection id to client " << m_connection_id;
+                if (m_request_read_size - read_offset < packed_size)
+                {
+                    // The rest of this request comes with a later read
+                    break;
+                }
 
-        // m_readbuf already contains the header in its first HEADER_SIZE
-        // bytes. Expand it to fit in the body as well, and start async
-        // read into the body.
-        //
-        m_request_read_buffer.resize(HEADER_SIZE + msg_len);
-        asio::mutable_buffers_1 buf = asio::buffer(&m_request_read_buffer[HEADER_SIZE], msg_len);
-        asio::async_read(
-            m_tcp_socket, buf,
-            boost::bind(
-                &ClientConnection::handle_tcp_read_request_body, 
-                shared_from_this(),
-                asio::placeholders::error));
-    }
+                SERVER_LOG_DEBUG("    ") << show_hex(packed_request, static_cast<unsigned>(packed_size));
 
-    void handle_tcp_read_request_body(const boost::system::error_code& error)
-    {
-        if (!error) 
-        {
-            SERVER_LOG_DEBUG("ClientConnection::handle_tcp_read_request_body")
-                << "Read request body on connection" << m_connection_id;
-            SERVER_LOG_DEBUG("   ") << show_hex(m_request_read_buffer);
+                bParsed= handle_tcp_request(packed_request, static_cast<unsigned>(packed_size));
+                read_offset+= packed_size;
+            }
+
+            if (bParsed)
+            {
+                // Move the partial request at the end to the front of the buffer
+                if (read_offset > 0)
+                {
+                    m_request_read_buffer.erase(m_request_read_buffer.begin(), m_request_read_buffer.begin() + read_offset);
+                    m_request_read_size-= read_offset;
+                }
 
-            handle_tcp_request();
-            start_tcp_read_request_header();
+                // All of the responses to this read go out together
+                start_tcp_write_queued_response();
+
+                start_tcp_read_requests();
+            }
         }
         else
         {
-            SERVER_LOG_ERROR("ClientConnection::handle_tcp_read_request_body") 
-                << "Failed to read body on connection " << m_connection_id << ": " << error.message();
+            SERVER_LOG_ERROR("ClientConnection::handle_tcp_read_requests") 
+                << "Failed to read requests on connection " << m_connection_id << ": " << error.message();
             stop();
         }
     }
 
-    // Called when enough data was read into m_readbuf for a complete request
-    // message. 
-    // Parse the request, execute it and send back a response.
+    // Called for every complete request message read from the socket.
+    // Parse the request, execute it (or every request of a batch) and queue the responses.
+    // Returns false if the connection was stopped over a malformed request.
     //
-    void handle_tcp_request()
+    bool handle_tcp_request(const uint8_t *packed_request, unsigned packed_size)
     {
-        if (m_packed_request.unpack(m_request_read_buffer))
+        if (m_packed_request.unpack(packed_request, packed_size))
         {
             RequestPtr request = m_packed_request.get_msg();
 
-            SERVER_LOG_DEBUG("ClientConnection::handle_tcp_request") 
-                << "Handle request type " << request->request_id() 
-                << " on connection id to client " << m_connection_id;
+            if (request->type() == PSMoveProtocol::Request_RequestType_REQUEST_BATCH)
+            {
+                PSMoveProtocol::Request_RequestBatch *batch= request->mutable_request_batch();
+
+                SERVER_LOG_DEBUG("ClientConnection::handle_tcp_request") 
+                    << "Handle batch of " << batch->requests_size()
+                    << " requests on connection id to client " << m_connection_id;
+
+                for (int request_index= 0; request_index < batch->requests_size(); ++request_index)
+                {
+                    // Shares ownership of the batch rather than copying the request out of it
+                    RequestPtr batched_request(request, batch->mutable_requests(request_index));
 
-            ResponsePtr response = m_request_handler_ref.handle_request(m_connection_id, request);            
-            if (response)
+                    if (batched_request->type() != PSMoveProtocol::Request_RequestType_REQUEST_BATCH)
+                    {
+                        execute_request(batched_request);
+                    }
+                    else
+                    {
+                        SERVER_LOG_WARNING("ClientConnection::handle_tcp_request") 
+                            << "Ignoring nested request batch on connection " << m_connection_id;
+                    }
+                }
+            }
+            else
             {
-                add_tcp_response_to_write_queue(response);
+                execute_request(request);
             }
 
-            start_tcp_write_queued_response();
+            return true;
         }
         else
         {
             SERVER_LOG_ERROR("ClientConnection::handle_tcp_request") 
                 << "Failed to parse request on connection " << m_connection_id;
             stop();
+
+            return false;
+        }
+    }
+
+    void execute_request(RequestPtr request)
+    {
+        SERVER_LOG_DEBUG("ClientConnection::execute_request") 
+            << "Handle request type " << request->request_id() 
+            << " on connection id to client " << m_connection_id;
+
+        ResponsePtr response = m_request_handler_ref.handle_request(m_connection_id, request);            
+        if (response)
+        {
+            add_tcp_response_to_write_queue(response);
         }
     }
 
@@ -501,9 +555,16 @@ private:
 
             // no longer is there a pending write
             m_has_pending_tcp_write= false;
+            if (trace_is_recording())
+            {
+                trace_record_event(
+                    "ClientConnection::tcp_write_response", -1,
+                    m_tcp_write_start_time, std::chrono::high_resolution_clock::now());
+            }
 
-            // Remove the response from the pending send queue now that it's sent
-            m_pending_responses.pop_front();
+            // Remove the responses from the pending send queue now that they're sent
+            m_pending_responses.erase(m_pending_responses.begin(), m_pending_responses.begin() + m_writing_response_count);
+            m_writing_response_count= 0;
 
             // If there are more requests waiting to be sent, start sending the next one
             start_tcp_write_queued_response();
@@ -528,6 +589,14 @@ private:
 
             // no longer is there a pending write
             m_has_pending_udp_write= false;
+            const std::chrono::high_resolution_clock::time_point udp_write_end_time= std::chrono::high_resolution_clock::now();
+            stats_record_duration(_stat_stage_udp_send, -1, udp_write_end_time - m_udp_write_start_time);
+            if (trace_is_recording())
+            {
+                trace_record_event(
+                    "ClientConnection::udp_write_data_frame", -1,
+                    m_udp_write_start_time, udp_write_end_time);
+            }
 
             // Remove the dataframe from the pending send queue now that it's sent
             m_pending_dataframes.pop_front();
@@ -991,9 +1060,16 @@ ServerNetworkManager::~ServerNetworkManager()
 
 bool ServerNetworkManager::startup(
 	boost::asio::io_service *io_service,
-    ServerRequestHandler *requestHandler)
+    ServerRequestHandler *requestHandler,
+    int server_port_override)
 {    
     m_instance= this;
+
+    // Front-end instances each listen on their own port
+    if (server_port_override > 0)
+    {
+        m_cfg.server_port= server_port_override;
+    }
     
 	implementation_ptr= new ServerNetworkManagerImpl(*io_service, m_cfg, *requestHandler);
     implementation_ptr->start_connection_accept();
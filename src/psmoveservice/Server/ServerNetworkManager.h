@@ -48,8 +48,9 @@ public:
     /// Called first by PSMoveService::startup()
     /**
      Calls ServerNetworkManagerImpl::start_connection_accept()
+     \param server_port_override Listens on this port instead of the configured one when > 0 (not saved)
      */
-    bool startup(boost::asio::io_service *io_service, ServerRequestHandler *request_handler);
+    bool startup(boost::asio::io_service *io_service, ServerRequestHandler *request_handler, int server_port_override = 0);
     
     /// Called last by PSMoveService::update()
     /**
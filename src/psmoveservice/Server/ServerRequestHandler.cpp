@@ -24,20 +24,30 @@
 #include "ServerTrackerView.h"
 #include "ServerHMDView.h"
 #include "ServerLog.h"
+#include "ServerStatistics.h"
+#include "ServerTrace.h"
 #include "ServerUtility.h"
+#include "SharedDeviceState.h"
 #include "TrackerManager.h"
 #include "VirtualController.h"
 
+#include <algorithm>
 #include <cassert>
 #include <bitset>
+#include <chrono>
 #include <map>
 #include <boost/shared_ptr.hpp>
 
+//-- constants -----
+// How often a broker rebuilds the device lists it shares with the front-ends
+static const int k_shared_device_list_refresh_ms = 250;
+
 //-- pre-declarations -----
 class ServerRequestHandlerImpl;
 typedef boost::shared_ptr<ServerRequestHandlerImpl> ServerRequestHandlerImplPtr;
 
 //-- definitions -----
+// Stream state is sized by the compile time ceilings, only the first getMaxDevices() entries are used
 struct RequestConnectionState
 {
     int connection_id;
@@ -84,6 +94,286 @@ struct RequestContext
     RequestPtr request;
 };
 
+//-- private methods -----
+// Both start stream requests carry the same limit fields
+template <typename t_start_stream_request>
+static DataStreamLimits make_data_stream_limits(const t_start_stream_request &request)
+{
+    DataStreamLimits limits;
+
+    limits.max_rate_hz = std::max(request.max_stream_rate_hz(), 0.f);
+    limits.position_deadband_cm = std::max(request.position_deadband_cm(), 0.f);
+    limits.orientation_deadband_degrees = std::max(request.orientation_deadband_degrees(), 0.f);
+
+    return limits;
+}
+
+// A broker shares its data frames with every optional section in them.
+// These strip a copy of one down to what a front-end connection asked for,
+// matching what generate_*_data_frame_for_stream would have given that connection.
+template <typename t_device_state, typename t_stream_info>
+static void trim_tracked_device_state(const t_stream_info &stream_info, t_device_state *device_state)
+{
+    if (!stream_info.include_position_data)
+    {
+        device_state->mutable_position_cm()->set_x(0);
+        device_state->mutable_position_cm()->set_y(0);
+        device_state->mutable_position_cm()->set_z(0);
+    }
+
+    if (!stream_info.include_raw_tracker_data)
+    {
+        device_state->clear_raw_tracker_data();
+    }
+
+    if (!stream_info.include_physics_data)
+    {
+        device_state->clear_physics_data();
+    }
+}
+
+template <typename t_device_state, typename t_stream_info>
+static void trim_device_sensor_state(const t_stream_info &stream_info, t_device_state *device_state)
+{
+    if (!stream_info.include_raw_sensor_data)
+    {
+        device_state->clear_raw_sensor_data();
+    }
+
+    if (!stream_info.include_calibrated_sensor_data)
+    {
+        device_state->clear_calibrated_sensor_data();
+    }
+}
+
+static void trim_controller_data_frame(
+    const ControllerStreamInfo &stream_info,
+    PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket *controller_packet)
+{
+    if (controller_packet->has_psmove_state())
+    {
+        trim_tracked_device_state(stream_info, controller_packet->mutable_psmove_state());
+        trim_device_sensor_state(stream_info, controller_packet->mutable_psmove_state());
+    }
+    else if (controller_packet->has_psdualshock4_state())
+    {
+        trim_tracked_device_state(stream_info, controller_packet->mutable_psdualshock4_state());
+        trim_device_sensor_state(stream_info, controller_packet->mutable_psdualshock4_state());
+    }
+    else if (controller_packet->has_virtualcontroller_state())
+    {
+        trim_tracked_device_state(stream_info, controller_packet->mutable_virtualcontroller_state());
+    }
+}
+
+static void trim_hmd_data_frame(
+    const HMDStreamInfo &stream_info,
+    PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket *hmd_packet)
+{
+    if (hmd_packet->has_morpheus_state())
+    {
+        trim_tracked_device_state(stream_info, hmd_packet->mutable_morpheus_state());
+        trim_device_sensor_state(stream_info, hmd_packet->mutable_morpheus_state());
+    }
+    else if (hmd_packet->has_virtual_hmd_state())
+    {
+        trim_tracked_device_state(stream_info, hmd_packet->mutable_virtual_hmd_state());
+    }
+}
+
+template <typename t_device_state>
+static void get_device_state_position(const t_device_state &device_state, float out_position_cm[3])
+{
+    out_position_cm[0] = device_state.position_cm().x();
+    out_position_cm[1] = device_state.position_cm().y();
+    out_position_cm[2] = device_state.position_cm().z();
+}
+
+template <typename t_device_state>
+static void get_device_state_orientation(const t_device_state &device_state, float out_orientation[4])
+{
+    out_orientation[0] = device_state.orientation().w();
+    out_orientation[1] = device_state.orientation().x();
+    out_orientation[2] = device_state.orientation().y();
+    out_orientation[3] = device_state.orientation().z();
+}
+
+// Triggers and sticks go into the stream filter's discrete state in 1/16 steps of their range,
+// so a deadband doesn't hold back analog input, while noise within a step doesn't count as a change.
+// The steps are centered on the values, so a stick resting at 0x80 doesn't flicker between two of them.
+static void add_analog_filter_state(uint32_t &inout_hash, int value_0_255)
+{
+    const uint32_t step = static_cast<uint32_t>((std::max(std::min(value_0_255, 255), 0) + 8) >> 4);
+
+    // FNV-1a
+    inout_hash = (inout_hash ^ step) * 16777619u;
+}
+
+static void add_analog_filter_state(uint32_t &inout_hash, float value, float min_value)
+{
+    add_analog_filter_state(inout_hash, static_cast<int>((value - min_value) / (1.f - min_value) * 255.f + 0.5f));
+}
+
+// The analog part of the discrete state (bits 34 and up)
+static uint64_t get_analog_filter_state_bits(uint32_t hash)
+{
+    return static_cast<uint64_t>(hash & 0x3fffffff) << 34;
+}
+
+static uint64_t get_controller_analog_filter_state(const CommonControllerState *controller_state)
+{
+    uint32_t hash = 2166136261u;
+
+    if (controller_state != nullptr)
+    {
+        switch (controller_state->DeviceType)
+        {
+        case CommonDeviceState::PSMove:
+            {
+                const PSMoveControllerInputState *psmove_state = static_cast<const PSMoveControllerInputState *>(controller_state);
+
+                add_analog_filter_state(hash, psmove_state->TriggerValue);
+            } break;
+        case CommonDeviceState::PSNavi:
+            {
+                const PSNaviControllerInputState *psnavi_state = static_cast<const PSNaviControllerInputState *>(controller_state);
+
+                add_analog_filter_state(hash, psnavi_state->Trigger);
+                add_analog_filter_state(hash, psnavi_state->Stick_XAxis);
+                add_analog_filter_state(hash, psnavi_state->Stick_YAxis);
+            } break;
+        case CommonDeviceState::PSDualShock4:
+            {
+                const DualShock4ControllerInputState *ds4_state = static_cast<const DualShock4ControllerInputState *>(controller_state);
+
+                add_analog_filter_state(hash, ds4_state->LeftAnalogX, -1.f);
+                add_analog_filter_state(hash, ds4_state->LeftAnalogY, -1.f);
+                add_analog_filter_state(hash, ds4_state->RightAnalogX, -1.f);
+                add_analog_filter_state(hash, ds4_state->RightAnalogY, -1.f);
+                add_analog_filter_state(hash, ds4_state->LeftTrigger, 0.f);
+                add_analog_filter_state(hash, ds4_state->RightTrigger, 0.f);
+            } break;
+        case CommonDeviceState::VirtualController:
+            {
+                const VirtualControllerState *virtual_state = static_cast<const VirtualControllerState *>(controller_state);
+
+                for (int axis_index = 0; axis_index < virtual_state->numAxes; ++axis_index)
+                {
+                    add_analog_filter_state(hash, virtual_state->axisStates[axis_index]);
+                }
+            } break;
+        default:
+            break;
+        }
+    }
+
+    return get_analog_filter_state_bits(hash);
+}
+
+// Same as get_controller_analog_filter_state, from the values in a data frame
+static uint64_t get_controller_analog_filter_state(
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket &controller_packet)
+{
+    uint32_t hash = 2166136261u;
+
+    if (controller_packet.has_psmove_state())
+    {
+        add_analog_filter_state(hash, controller_packet.psmove_state().trigger_value());
+    }
+    else if (controller_packet.has_psnavi_state())
+    {
+        add_analog_filter_state(hash, controller_packet.psnavi_state().trigger_value());
+        add_analog_filter_state(hash, controller_packet.psnavi_state().stick_xaxis());
+        add_analog_filter_state(hash, controller_packet.psnavi_state().stick_yaxis());
+    }
+    else if (controller_packet.has_psdualshock4_state())
+    {
+        const auto &ds4_state = controller_packet.psdualshock4_state();
+
+        add_analog_filter_state(hash, ds4_state.left_thumbstick_x(), -1.f);
+        add_analog_filter_state(hash, ds4_state.left_thumbstick_y(), -1.f);
+        add_analog_filter_state(hash, ds4_state.right_thumbstick_x(), -1.f);
+        add_analog_filter_state(hash, ds4_state.right_thumbstick_y(), -1.f);
+        add_analog_filter_state(hash, ds4_state.left_trigger_value(), 0.f);
+        add_analog_filter_state(hash, ds4_state.right_trigger_value(), 0.f);
+    }
+    else if (controller_packet.has_virtualcontroller_state())
+    {
+        for (int axis_state : controller_packet.virtualcontroller_state().axisstates())
+        {
+            add_analog_filter_state(hash, axis_state);
+        }
+    }
+
+    return get_analog_filter_state_bits(hash);
+}
+
+// What the stream filters of a front-end compare against, taken from a shared data frame
+// (the broker's publish_controller_data_frame takes the same from the controller view)
+static uint64_t get_controller_data_frame_filter_state(
+    const PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket &controller_packet,
+    float out_position_cm[3],
+    float out_orientation[4])
+{
+    bool bIsCurrentlyTracking = false;
+
+    out_position_cm[0] = out_position_cm[1] = out_position_cm[2] = 0.f;
+    out_orientation[0] = 1.f;
+    out_orientation[1] = out_orientation[2] = out_orientation[3] = 0.f;
+
+    if (controller_packet.has_psmove_state())
+    {
+        get_device_state_position(controller_packet.psmove_state(), out_position_cm);
+        get_device_state_orientation(controller_packet.psmove_state(), out_orientation);
+        bIsCurrentlyTracking = controller_packet.psmove_state().iscurrentlytracking();
+    }
+    else if (controller_packet.has_psdualshock4_state())
+    {
+        get_device_state_position(controller_packet.psdualshock4_state(), out_position_cm);
+        get_device_state_orientation(controller_packet.psdualshock4_state(), out_orientation);
+        bIsCurrentlyTracking = controller_packet.psdualshock4_state().iscurrentlytracking();
+    }
+    else if (controller_packet.has_virtualcontroller_state())
+    {
+        get_device_state_position(controller_packet.virtualcontroller_state(), out_position_cm);
+        bIsCurrentlyTracking = controller_packet.virtualcontroller_state().iscurrentlytracking();
+    }
+
+    return
+        static_cast<uint64_t>(controller_packet.button_down_bitmask()) |
+        (static_cast<uint64_t>(bIsCurrentlyTracking) << 32) |
+        (static_cast<uint64_t>(controller_packet.isconnected()) << 33) |
+        get_controller_analog_filter_state(controller_packet);
+}
+
+static uint64_t get_hmd_data_frame_filter_state(
+    const PSMoveProtocol::DeviceOutputDataFrame_HMDDataPacket &hmd_packet,
+    float out_position_cm[3],
+    float out_orientation[4])
+{
+    bool bIsCurrentlyTracking = false;
+
+    out_position_cm[0] = out_position_cm[1] = out_position_cm[2] = 0.f;
+    out_orientation[0] = 1.f;
+    out_orientation[1] = out_orientation[2] = out_orientation[3] = 0.f;
+
+    if (hmd_packet.has_morpheus_state())
+    {
+        get_device_state_position(hmd_packet.morpheus_state(), out_position_cm);
+        get_device_state_orientation(hmd_packet.morpheus_state(), out_orientation);
+        bIsCurrentlyTracking = hmd_packet.morpheus_state().iscurrentlytracking();
+    }
+    else if (hmd_packet.has_virtual_hmd_state())
+    {
+        get_device_state_position(hmd_packet.virtual_hmd_state(), out_position_cm);
+        bIsCurrentlyTracking = hmd_packet.virtual_hmd_state().iscurrentlytracking();
+    }
+
+    return
+        static_cast<uint64_t>(bIsCurrentlyTracking) |
+        (static_cast<uint64_t>(hmd_packet.isconnected()) << 1);
+}
+
 //-- private implementation -----
 class ServerRequestHandlerImpl
 {
@@ -91,7 +381,29 @@ public:
     ServerRequestHandlerImpl(DeviceManager &deviceManager)
         : m_device_manager(deviceManager)
         , m_connection_state_map()
+        , m_sharing_mode(_eDeviceSharingMode_None)
+        , m_shared_state_writer()
+        , m_shared_state_reader()
+        , m_shared_data_frame(new PSMoveProtocol::DeviceOutputDataFrame)
+        , m_shared_list_connection_state(new RequestConnectionState())
+        , m_next_shared_device_list_time()
+        , m_broker_controller_tracking_mask(0)
+        , m_broker_hmd_tracking_mask(0)
     {
+        // Front-ends get every optional section of the shared data frames and trim them per connection
+        m_shared_controller_stream_info.Clear();
+        m_shared_controller_stream_info.include_position_data = true;
+        m_shared_controller_stream_info.include_physics_data = true;
+        m_shared_controller_stream_info.include_raw_sensor_data = true;
+        m_shared_controller_stream_info.include_calibrated_sensor_data = true;
+        m_shared_controller_stream_info.include_raw_tracker_data = true;
+
+        m_shared_hmd_stream_info.Clear();
+        m_shared_hmd_stream_info.include_position_data = true;
+        m_shared_hmd_stream_info.include_physics_data = true;
+        m_shared_hmd_stream_info.include_raw_sensor_data = true;
+        m_shared_hmd_stream_info.include_calibrated_sensor_data = true;
+        m_shared_hmd_stream_info.include_raw_tracker_data = true;
     }
 
     virtual ~ServerRequestHandlerImpl()
@@ -118,6 +430,56 @@ public:
         return any_active;
     }
 
+    bool startup(eDeviceSharingMode sharing_mode)
+    {
+        bool bSuccess= true;
+
+        m_sharing_mode= sharing_mode;
+
+        switch (m_sharing_mode)
+        {
+        case _eDeviceSharingMode_Broker:
+            {
+                bSuccess= m_shared_state_writer.startup(
+                    m_device_manager.getControllerViewMaxCount(),
+                    m_device_manager.getHMDViewMaxCount());
+
+                if (bSuccess)
+                {
+                    SERVER_LOG_INFO("ServerRequestHandler") << "Sharing device state with front-end instances";
+                }
+            } break;
+        case _eDeviceSharingMode_Frontend:
+            {
+                // Attaches to the broker on the first update (and again whenever the broker restarts)
+                SERVER_LOG_INFO("ServerRequestHandler") << "Serving clients from the device state of a broker instance";
+            } break;
+        default:
+            break;
+        }
+
+        return bSuccess;
+    }
+
+    void shutdown()
+    {
+        switch (m_sharing_mode)
+        {
+        case _eDeviceSharingMode_Broker:
+            {
+                // Let go of the tracking the front-ends asked for
+                apply_broker_tracking_requests(0, 0);
+                m_shared_state_writer.shutdown();
+            } break;
+        case _eDeviceSharingMode_Frontend:
+            {
+                m_shared_state_reader.shutdown();
+            } break;
+        default:
+            break;
+        }
+    }
+
     void update()
     {
         for (t_connection_state_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
@@ -166,6 +528,18 @@ public:
                 }
             }
         }
+
+        switch (m_sharing_mode)
+        {
+        case _eDeviceSharingMode_Broker:
+            update_broker();
+            break;
+        case _eDeviceSharingMode_Frontend:
+            update_frontend();
+            break;
+        default:
+            break;
+        }
     }
 
     ResponsePtr handle_request(int connection_id, RequestPtr request)
@@ -175,6 +549,12 @@ public:
         context.request= request;
         context.connection_state= FindOrCreateConnectionState(connection_id);
 
+        // A front-end has no devices of its own to run most requests against
+        if (m_sharing_mode == _eDeviceSharingMode_Frontend)
+        {
+            return handle_frontend_request(context);
+        }
+
         // All responses track which request they came from
         PSMoveProtocol::Response *response= nullptr;
 
@@ -379,6 +759,34 @@ public:
                 response = new PSMoveProtocol::Response;
                 handle_request__get_service_version(context, response);
                 break;
+            case PSMoveProtocol::Request_RequestType_GET_SERVICE_STATISTICS:
+                response = new PSMoveProtocol::Response;
+                handle_request__get_service_statistics(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_SET_TRACE_RECORDING:
+                response = new PSMoveProtocol::Response;
+                handle_request__set_trace_recording(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_DUMP_TRACE:
+                response = new PSMoveProtocol::Response;
+                handle_request__dump_trace(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_START_TRACKER_BUNDLE_ADJUSTMENT:
+                response = new PSMoveProtocol::Response;
+                handle_request__start_tracker_bundle_adjustment(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_SOLVE_TRACKER_BUNDLE_ADJUSTMENT:
+                response = new PSMoveProtocol::Response;
+                handle_request__solve_tracker_bundle_adjustment(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_START_TRACKING_COLOR_CALIBRATION:
+                response = new PSMoveProtocol::Response;
+                handle_request__start_tracking_color_calibration(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_REQUEST_CONTROLLER_KEYFRAME:
+                response = new PSMoveProtocol::Response;
+                handle_request__request_controller_keyframe(context, response);
+                break;
 
             default:
                 assert(0 && "Whoops, bad request!");
@@ -394,6 +802,12 @@ public:
 
     void handle_input_data_frame(DeviceInputDataFramePtr data_frame)
     {
+        // LED and rumble overrides need the devices, which only the broker has
+        if (m_sharing_mode == _eDeviceSharingMode_Frontend)
+        {
+            return;
+        }
+
         // The context holds everything a handler needs to evaluate a request
         RequestConnectionStatePtr connection_state = FindOrCreateConnectionState(data_frame->connection_id());
 
@@ -410,7 +824,13 @@ public:
     {
         t_connection_state_iter iter= m_connection_state_map.find(connection_id);
 
-        if (iter != m_connection_state_map.end())
+        // A front-end connection only holds stream state, the devices it had tracked
+        // drop out of the tracking requests sent to the broker on the next update
+        if (iter != m_connection_state_map.end() && m_sharing_mode == _eDeviceSharingMode_Frontend)
+        {
+            m_connection_state_map.erase(iter);
+        }
+        else if (iter != m_connection_state_map.end())
         {
             int connection_id= iter->first;
             RequestConnectionStatePtr connection_state= iter->second;
@@ -427,7 +847,7 @@ public:
             }
 
             // Clean up any controller state related to this connection
-            for (int controller_id = 0; controller_id < ControllerManager::k_max_devices; ++controller_id)
+            for (int controller_id = 0; controller_id < m_device_manager.getControllerViewMaxCount(); ++controller_id)
             {
                 const ControllerStreamInfo &streamInfo = connection_state->active_controller_stream_info[controller_id];
                 ServerControllerViewPtr controller_view = m_device_manager.getControllerViewPtr(controller_id);
@@ -459,7 +879,7 @@ public:
             }
 
             
-            for (int tracker_id = 0; tracker_id < TrackerManager::k_max_devices; ++tracker_id)
+            for (int tracker_id = 0; tracker_id < m_device_manager.getTrackerViewMaxCount(); ++tracker_id)
             {
                 // Restore any overridden camera settings from the config
                 if (connection_state->active_tracker_stream_info[tracker_id].has_temp_settings_override)
@@ -475,7 +895,7 @@ public:
             }
 
             // Clean up any hmd state related to this connection
-            for (int hmd_id = 0; hmd_id < HMDManager::k_max_devices; ++hmd_id)
+            for (int hmd_id = 0; hmd_id < m_device_manager.getHMDViewMaxCount(); ++hmd_id)
             {
                 const HMDStreamInfo &streamInfo = connection_state->active_hmd_stream_info[hmd_id];
                 ServerHMDViewPtr hmd_view = m_device_manager.getHMDViewPtr(hmd_id);
@@ -504,6 +924,29 @@ public:
     {
         int controller_id= controller_view->getDeviceID();
 
+        // Front-ends serve every streamable controller to their own connections
+        // (no point building the frame while none is attached)
+        if (m_sharing_mode == _eDeviceSharingMode_Broker &&
+            m_shared_state_writer.getHasFrontends() &&
+            controller_view->getIsStreamable())
+        {
+            m_shared_data_frame->Clear();
+            callback(controller_view, &m_shared_controller_stream_info, m_shared_data_frame.get());
+            m_shared_state_writer.writeControllerDataFrame(controller_id, *m_shared_data_frame);
+        }
+
+        // What the stream filters compare against (button, flag and coarse trigger/stick changes always go out)
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+        const CommonDevicePose pose= controller_view->getFilteredPose();
+        const CommonControllerState *controller_state= controller_view->getState();
+        const float position_cm[3]= {pose.PositionCm.x, pose.PositionCm.y, pose.PositionCm.z};
+        const float orientation[4]= {pose.Orientation.w, pose.Orientation.x, pose.Orientation.y, pose.Orientation.z};
+        const uint64_t discrete_state=
+            static_cast<uint64_t>(controller_state != nullptr ? controller_state->AllButtons : 0) |
+            (static_cast<uint64_t>(controller_view->getIsCurrentlyTracking()) << 32) |
+            (static_cast<uint64_t>(controller_view->getIsOpen()) << 33) |
+            get_controller_analog_filter_state(controller_state);
+
         // Notify any connections that care about the controller update
         for (t_connection_state_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
         {
@@ -512,13 +955,25 @@ public:
 
             if (connection_state->active_controller_streams.test(controller_id))
             {
-                const ControllerStreamInfo &streamInfo=
+                ControllerStreamInfo &streamInfo=
                     connection_state->active_controller_stream_info[controller_id];
 
+                // Skip the update before paying for the data frame if this connection doesn't want it
+                if (!streamInfo.stream_filter.filterUpdate(now, position_cm, orientation, discrete_state))
+                {
+                    continue;
+                }
+
                 // Fill out a data frame specific to this stream using the given callback
                 DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
                 callback(controller_view, &streamInfo, data_frame.get());
 
+                // Trim it down to what changed since the last keyframe if the connection asked for that
+                if (streamInfo.delta_encoder)
+                {
+                    streamInfo.delta_encoder->encode(data_frame->mutable_controller_data_packet());
+                }
+
                 // Send the controller data frame over the network
                 ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
             }
@@ -558,6 +1013,22 @@ public:
     {
         int hmd_id = hmd_view->getDeviceID();
 
+        if (m_sharing_mode == _eDeviceSharingMode_Broker && m_shared_state_writer.getHasFrontends())
+        {
+            m_shared_data_frame->Clear();
+            callback(hmd_view, &m_shared_hmd_stream_info, m_shared_data_frame);
+            m_shared_state_writer.writeHMDDataFrame(hmd_id, *m_shared_data_frame);
+        }
+
+        // What the stream filters compare against (tracking and connection changes always go out)
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+        const CommonDevicePose pose = hmd_view->getFilteredPose();
+        const float position_cm[3] = {pose.PositionCm.x, pose.PositionCm.y, pose.PositionCm.z};
+        const float orientation[4] = {pose.Orientation.w, pose.Orientation.x, pose.Orientation.y, pose.Orientation.z};
+        const uint64_t discrete_state =
+            static_cast<uint64_t>(hmd_view->getIsCurrentlyTracking()) |
+            (static_cast<uint64_t>(hmd_view->getIsOpen()) << 1);
+
         // Notify any connections that care about the tracker update
         for (t_connection_state_iter iter = m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
         {
@@ -566,9 +1037,15 @@ public:
 
             if (connection_state->active_hmd_streams.test(hmd_id))
             {
-                const HMDStreamInfo &streamInfo =
+                HMDStreamInfo &streamInfo =
                     connection_state->active_hmd_stream_info[hmd_id];
 
+                // Skip the update before paying for the data frame if this connection doesn't want it
+                if (!streamInfo.stream_filter.filterUpdate(now, position_cm, orientation, discrete_state))
+                {
+                    continue;
+                }
+
                 // Fill out a data frame specific to this stream using the given callback
                 DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame);
                 callback(hmd_view, &streamInfo, data_frame);
@@ -809,6 +1286,12 @@ protected:
                 streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
                 streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
                 streamInfo.disable_roi = request.disable_roi();
+                streamInfo.stream_filter.setLimits(make_data_stream_limits(request));
+
+                if (request.use_delta_frames())
+                {
+                    streamInfo.delta_encoder.reset(new ControllerDataFrameDeltaEncoder);
+                }
 
                 SERVER_LOG_INFO("ServerRequestHandler") << "Start controller(" << controller_id << ") stream ("
                     << "pos=" << streamInfo.include_position_data
@@ -817,6 +1300,8 @@ protected:
                     << ",cal_sens=" << streamInfo.include_calibrated_sensor_data
                     << ",trkr=" << streamInfo.include_raw_tracker_data
                     << ",roi=" << streamInfo.disable_roi
+                    << ",hz=" << streamInfo.stream_filter.getLimits().max_rate_hz
+                    << ",delta=" << (streamInfo.delta_encoder ? 1 : 0)
                     << ")";
 
                 if (streamInfo.include_position_data)
@@ -900,6 +1385,33 @@ protected:
         }
     }
 
+    void handle_request__request_controller_keyframe(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        const int controller_id= context.request->request_controller_keyframe().controller_id();
+
+        // Front-ends handle this too, so check against the stream state rather than the device manager
+        if (ServerUtility::is_index_valid(controller_id, ControllerManager::k_max_devices) &&
+            context.connection_state->active_controller_streams.test(controller_id))
+        {
+            ControllerStreamInfo &streamInfo =
+                context.connection_state->active_controller_stream_info[controller_id];
+
+            // The next data frame of the stream goes out whole
+            if (streamInfo.delta_encoder)
+            {
+                streamInfo.delta_encoder->requestKeyframe();
+            }
+
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
     void handle_request__reset_orientation(
         const RequestContext &context, 
         PSMoveProtocol::Response *response)
@@ -1086,7 +1598,7 @@ protected:
                 // Give up control of our existing tracking color
                 if (oldColorID != eCommonTrackingColorID::INVALID_COLOR)
                 {
-                    m_device_manager.m_tracker_manager->freeTrackingColorID(oldColorID);
+                    m_device_manager.m_tracker_manager->freeTrackingColorID(oldColorID, ControllerView.get());
                 }
 
                 // Take the color from any other controller that might have it
@@ -1819,6 +2331,12 @@ protected:
                 case CommonControllerState::PS3EYE:
                     tracker_info->set_tracker_type(PSMoveProtocol::PS3EYE);
                     break;
+                case CommonControllerState::VirtualTracker:
+                    tracker_info->set_tracker_type(PSMoveProtocol::VIRTUAL_TRACKER);
+                    break;
+                case CommonControllerState::RemoteTracker:
+                    tracker_info->set_tracker_type(PSMoveProtocol::REMOTE_TRACKER);
+                    break;
                 default:
                     assert(0 && "Unhandled tracker type");
                 }
@@ -2732,6 +3250,7 @@ protected:
                 streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
                 streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
                 streamInfo.disable_roi = request.disable_roi();
+                streamInfo.stream_filter.setLimits(make_data_stream_limits(request));
 
                 SERVER_LOG_INFO("ServerRequestHandler") << "Start hmd(" << hmd_id << ") stream ("
                     << "pos=" << streamInfo.include_position_data
@@ -2740,6 +3259,7 @@ protected:
                     << ",cal_sens=" << streamInfo.include_calibrated_sensor_data
                     << ",trkr=" << streamInfo.include_raw_tracker_data
                     << ",roi=" << streamInfo.disable_roi
+                    << ",hz=" << streamInfo.stream_filter.getLimits().max_rate_hz
                     << ")";
 
                 if (streamInfo.disable_roi)
@@ -3116,46 +3636,214 @@ protected:
         response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
     }
 
-    // -- Data Frame Updates -----
-    void handle_data_frame__controller_packet(
-        RequestConnectionStatePtr connection_state,
-        DeviceInputDataFramePtr data_frame)
+    void handle_request__get_service_statistics(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
     {
-        const auto &controllerDataPacket = data_frame->controller_data_packet();
-        const int controller_id = controllerDataPacket.controller_id();
+        PSMoveProtocol::Response_ResultServiceStatistics* statistics = response->mutable_result_service_statistics();
+        std::vector<StatStageSummary> summaries;
 
-        if (ServerUtility::is_index_valid(controller_id, m_device_manager.getControllerViewMaxCount()))
+        response->set_type(PSMoveProtocol::Response_ResponseType_SERVICE_STATISTICS);
+
+        const float window_seconds = stats_get_summaries(summaries);
+        statistics->set_sample_window_seconds(window_seconds);
+
+        for (const StatStageSummary &summary : summaries)
         {
-            ServerControllerViewPtr controller_view = m_device_manager.getControllerViewPtr(controller_id);
-            ControllerStreamInfo &streamInfo = connection_state->active_controller_stream_info[controller_id];
+            PSMoveProtocol::Response_ResultServiceStatistics_StageStatistics *stage_entry = statistics->add_stage_entries();
+
+            stage_entry->set_stage_name(stats_get_stage_name(summary.stage));
+            stage_entry->set_device_id(summary.device_id);
+            stage_entry->set_sample_count(summary.sample_count);
+            stage_entry->set_samples_per_second(summary.samples_per_second);
+            stage_entry->set_p50_microseconds(summary.p50_microseconds);
+            stage_entry->set_p99_microseconds(summary.p99_microseconds);
+            stage_entry->set_max_microseconds(summary.max_microseconds);
+        }
 
-            // Don't consider this data frame if the controller isn't in a streamable connection
-            // or if the sequence number is old
-            if (controller_view->getIsStreamable() && 
-                controllerDataPacket.sequence_num() > streamInfo.last_data_input_sequence_number)
-            {
-                // Remember the last sequence number we received from this connection
-                streamInfo.last_data_input_sequence_number = controllerDataPacket.sequence_num();
+        // Start a new sampling window, e.g. for a monitor that polls once a minute
+        if (context.request->request_get_service_statistics().reset_after_read())
+        {
+            stats_reset();
+        }
 
-                switch (controller_view->getControllerDeviceType())
-                {
-                case CommonDeviceState::eDeviceType::PSMove:
-                    {
-                        const auto &psmove_state= controllerDataPacket.psmove_state();
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+    }
 
-                        // Update the rumble
-                        const float rumbleValue= static_cast<float>(psmove_state.rumble_value()) / 255.f;
-                        controller_view->setControllerRumble(rumbleValue, CommonControllerState::ChannelAll);
+    void handle_request__set_trace_recording(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        trace_set_recording(context.request->request_set_trace_recording().enabled());
 
-                        // Update the override led color
-                        {
-                            unsigned char r = static_cast<unsigned char>(psmove_state.led_r());
-                            unsigned char g = static_cast<unsigned char>(psmove_state.led_g());
-                            unsigned char b = static_cast<unsigned char>(psmove_state.led_b());
+        response->set_type(PSMoveProtocol::Response_ResponseType_GENERAL_RESULT);
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+    }
 
-                            // (0,0,0) is treated as clearing the override
-                            if (r == 0 && g == 0 && b == 0)
-                            {
+    void handle_request__dump_trace(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        std::string filename = context.request->request_dump_trace().filename();
+
+        // Clients only get to pick the name, the dump always lands in the working directory
+        const size_t last_separator = filename.find_last_of("/\\");
+        if (last_separator != std::string::npos)
+        {
+            filename = filename.substr(last_separator + 1);
+        }
+        if (filename.empty() || filename == "." || filename == "..")
+        {
+            filename = TRACE_DEFAULT_DUMP_FILE;
+        }
+
+        int event_count = 0;
+        if (trace_write_chrome_json(filename, &event_count))
+        {
+            PSMoveProtocol::Response_ResultTraceDumped* trace_dumped = response->mutable_result_trace_dumped();
+
+            trace_dumped->set_filename(filename);
+            trace_dumped->set_event_count(event_count);
+
+            response->set_type(PSMoveProtocol::Response_ResponseType_TRACE_DUMPED);
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            response->set_type(PSMoveProtocol::Response_ResponseType_GENERAL_RESULT);
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
+    void handle_request__start_tracker_bundle_adjustment(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        const int controller_id = context.request->request_start_tracker_bundle_adjustment().controller_id();
+
+        response->set_type(PSMoveProtocol::Response_ResponseType_GENERAL_RESULT);
+
+        if (ServerUtility::is_index_valid(controller_id, m_device_manager.getControllerViewMaxCount()) &&
+            m_device_manager.getControllerViewPtr(controller_id)->getIsOpen())
+        {
+            m_device_manager.m_tracker_manager->startBundleAdjustmentRecording(controller_id);
+
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
+    void handle_request__solve_tracker_bundle_adjustment(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        const auto &request = context.request->request_solve_tracker_bundle_adjustment();
+        TrackerBundleAdjustmentSummary summary;
+
+        if (m_device_manager.m_tracker_manager->solveBundleAdjustment(
+                request.refine_intrinsics(), request.apply_result(), summary))
+        {
+            PSMoveProtocol::Response_ResultTrackerBundleAdjustment* result =
+                response->mutable_result_tracker_bundle_adjustment();
+
+            result->set_sample_count(summary.sample_count);
+            result->set_observation_count(summary.observation_count);
+            result->set_iteration_count(summary.iteration_count);
+            result->set_initial_rms_px(summary.initial_rms_px);
+            result->set_final_rms_px(summary.final_rms_px);
+            result->set_applied(summary.bApplied);
+
+            for (int entry_index = 0; entry_index < summary.tracker_count; ++entry_index)
+            {
+                const TrackerBundleAdjustmentEntry &entry = summary.trackers[entry_index];
+                PSMoveProtocol::Response_ResultTrackerBundleAdjustment_TrackerEntry *tracker_entry = result->add_tracker_entries();
+
+                tracker_entry->set_tracker_id(entry.tracker_id);
+                tracker_entry->set_observation_count(entry.observation_count);
+                tracker_entry->set_initial_rms_px(entry.initial_rms_px);
+                tracker_entry->set_final_rms_px(entry.final_rms_px);
+                common_device_pose_to_protocol_pose(entry.pose, tracker_entry->mutable_tracker_pose());
+                tracker_entry->set_focal_length_x(entry.focal_length_x);
+                tracker_entry->set_focal_length_y(entry.focal_length_y);
+                tracker_entry->set_principal_x(entry.principal_x);
+                tracker_entry->set_principal_y(entry.principal_y);
+            }
+
+            response->set_type(PSMoveProtocol::Response_ResponseType_TRACKER_BUNDLE_ADJUSTMENT_RESULT);
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            response->set_type(PSMoveProtocol::Response_ResponseType_GENERAL_RESULT);
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
+    void handle_request__start_tracking_color_calibration(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        const auto &request = context.request->request_start_tracking_color_calibration();
+        const int controller_id = request.controller_id();
+        const eCommonTrackingColorID color_id = static_cast<eCommonTrackingColorID>(request.color_type());
+
+        response->set_type(PSMoveProtocol::Response_ResponseType_GENERAL_RESULT);
+
+        // The result comes back later as a TRACKING_COLOR_CALIBRATED notification
+        if (ServerUtility::is_index_valid(controller_id, m_device_manager.getControllerViewMaxCount()) &&
+            m_device_manager.m_tracker_manager->startTrackingColorCalibration(controller_id, color_id))
+        {
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
+    // -- Data Frame Updates -----
+    void handle_data_frame__controller_packet(
+        RequestConnectionStatePtr connection_state,
+        DeviceInputDataFramePtr data_frame)
+    {
+        const auto &controllerDataPacket = data_frame->controller_data_packet();
+        const int controller_id = controllerDataPacket.controller_id();
+
+        if (ServerUtility::is_index_valid(controller_id, m_device_manager.getControllerViewMaxCount()))
+        {
+            ServerControllerViewPtr controller_view = m_device_manager.getControllerViewPtr(controller_id);
+            ControllerStreamInfo &streamInfo = connection_state->active_controller_stream_info[controller_id];
+
+            // Don't consider this data frame if the controller isn't in a streamable connection
+            // or if the sequence number is old
+            if (controller_view->getIsStreamable() && 
+                controllerDataPacket.sequence_num() > streamInfo.last_data_input_sequence_number)
+            {
+                // Remember the last sequence number we received from this connection
+                streamInfo.last_data_input_sequence_number = controllerDataPacket.sequence_num();
+
+                switch (controller_view->getControllerDeviceType())
+                {
+                case CommonDeviceState::eDeviceType::PSMove:
+                    {
+                        const auto &psmove_state= controllerDataPacket.psmove_state();
+
+                        // Update the rumble
+                        const float rumbleValue= static_cast<float>(psmove_state.rumble_value()) / 255.f;
+                        controller_view->setControllerRumble(rumbleValue, CommonControllerState::ChannelAll);
+
+                        // Update the override led color
+                        {
+                            unsigned char r = static_cast<unsigned char>(psmove_state.led_r());
+                            unsigned char g = static_cast<unsigned char>(psmove_state.led_g());
+                            unsigned char b = static_cast<unsigned char>(psmove_state.led_b());
+
+                            // (0,0,0) is treated as clearing the override
+                            if (r == 0 && g == 0 && b == 0)
+                            {
                                 if (controller_view->getIsLEDOverrideActive())
                                 {
                                     // Removes the over led color and restores the tracking color
@@ -3224,9 +3912,564 @@ protected:
         }
     }
 
+    // -- Device Sharing -----
+    void update_broker()
+    {
+        unsigned int controller_tracking_mask= 0;
+        unsigned int hmd_tracking_mask= 0;
+
+        m_shared_state_writer.update(controller_tracking_mask, hmd_tracking_mask);
+        apply_broker_tracking_requests(controller_tracking_mask, hmd_tracking_mask);
+
+        // The device lists rarely change, no need to rebuild them every update
+        const std::chrono::steady_clock::time_point now= std::chrono::steady_clock::now();
+
+        if (now >= m_next_shared_device_list_time)
+        {
+            publish_shared_device_lists();
+            m_next_shared_device_list_time= now + std::chrono::milliseconds(k_shared_device_list_refresh_ms);
+        }
+    }
+
+    // Holds one tracking reference on each device some front-end wants position data for,
+    // the same reference a local connection streaming position data would hold
+    void apply_broker_tracking_requests(unsigned int controller_tracking_mask, unsigned int hmd_tracking_mask)
+    {
+        for (int controller_id= 0; controller_id < m_device_manager.getControllerViewMaxCount(); ++controller_id)
+        {
+            ServerControllerViewPtr controller_view= m_device_manager.getControllerViewPtr(controller_id);
+            const unsigned int controller_bit= 1u << controller_id;
+            const bool bWantsTracking= (controller_tracking_mask & controller_bit) != 0;
+            const bool bIsTracking= (m_broker_controller_tracking_mask & controller_bit) != 0;
+
+            if (!controller_view->getIsOpen())
+            {
+                // The tracking reference went away with the controller
+                m_broker_controller_tracking_mask&= ~controller_bit;
+            }
+            else if (bWantsTracking && !bIsTracking && controller_view->getIsStreamable())
+            {
+                controller_view->startTracking();
+                m_broker_controller_tracking_mask|= controller_bit;
+            }
+            else if (!bWantsTracking && bIsTracking)
+            {
+                controller_view->stopTracking();
+                m_broker_controller_tracking_mask&= ~controller_bit;
+            }
+        }
+
+        for (int hmd_id= 0; hmd_id < m_device_manager.getHMDViewMaxCount(); ++hmd_id)
+        {
+            ServerHMDViewPtr hmd_view= m_device_manager.getHMDViewPtr(hmd_id);
+            const unsigned int hmd_bit= 1u << hmd_id;
+            const bool bWantsTracking= (hmd_tracking_mask & hmd_bit) != 0;
+            const bool bIsTracking= (m_broker_hmd_tracking_mask & hmd_bit) != 0;
+
+            if (!hmd_view->getIsOpen())
+            {
+                m_broker_hmd_tracking_mask&= ~hmd_bit;
+            }
+            else if (bWantsTracking && !bIsTracking)
+            {
+                hmd_view->startTracking();
+                m_broker_hmd_tracking_mask|= hmd_bit;
+            }
+            else if (!bWantsTracking && bIsTracking)
+            {
+                hmd_view->stopTracking();
+                m_broker_hmd_tracking_mask&= ~hmd_bit;
+            }
+        }
+    }
+
+    // Answers the list requests on behalf of the front-ends, using the same handlers our own clients hit
+    void publish_shared_device_lists()
+    {
+        RequestContext context;
+        context.connection_state= m_shared_list_connection_state;
+        context.request= RequestPtr(new PSMoveProtocol::Request);
+
+        // Front-ends drop the USB controllers themselves for clients that don't want them
+        context.request->mutable_request_get_controller_list()->set_include_usb_controllers(true);
+
+        PSMoveProtocol::Response response;
+
+        handle_request__get_controller_list(context, &response);
+        m_shared_state_writer.writeDeviceList(_eSharedDeviceList_Controllers, response);
+
+        response.Clear();
+        handle_request__get_tracker_list(context, &response);
+        m_shared_state_writer.writeDeviceList(_eSharedDeviceList_Trackers, response);
+
+        response.Clear();
+        handle_request__get_hmd_list(context, &response);
+        m_shared_state_writer.writeDeviceList(_eSharedDeviceList_HMDs, response);
+
+        response.Clear();
+        handle_request__get_tracking_space_settings(context, &response);
+        m_shared_state_writer.writeDeviceList(_eSharedDeviceList_TrackingSpace, response);
+
+        // Devices that closed stop publishing, so take their last frame down for them
+        for (int controller_id= 0; controller_id < m_device_manager.getControllerViewMaxCount(); ++controller_id)
+        {
+            ServerControllerViewPtr controller_view= m_device_manager.getControllerViewPtr(controller_id);
+
+            if (!controller_view->getIsOpen() || !controller_view->getIsStreamable())
+            {
+                m_shared_state_writer.clearControllerDataFrame(controller_id);
+            }
+        }
+
+        for (int hmd_id= 0; hmd_id < m_device_manager.getHMDViewMaxCount(); ++hmd_id)
+        {
+            if (!m_device_manager.getHMDViewPtr(hmd_id)->getIsOpen())
+            {
+                m_shared_state_writer.clearHMDDataFrame(hmd_id);
+            }
+        }
+    }
+
+    void update_frontend()
+    {
+        // Ask the broker to track whatever our connections stream position data for
+        unsigned int controller_tracking_mask= 0;
+        unsigned int hmd_tracking_mask= 0;
+
+        for (t_connection_state_const_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
+        {
+            const RequestConnectionStatePtr &connection_state= iter->second;
+
+            for (int controller_id= 0; controller_id < ControllerManager::k_max_devices; ++controller_id)
+            {
+                if (connection_state->active_controller_streams.test(controller_id) &&
+                    connection_state->active_controller_stream_info[controller_id].include_position_data)
+                {
+                    controller_tracking_mask|= 1u << controller_id;
+                }
+            }
+
+            for (int hmd_id= 0; hmd_id < HMDManager::k_max_devices; ++hmd_id)
+            {
+                if (connection_state->active_hmd_streams.test(hmd_id) &&
+                    connection_state->active_hmd_stream_info[hmd_id].include_position_data)
+                {
+                    hmd_tracking_mask|= 1u << hmd_id;
+                }
+            }
+        }
+
+        m_shared_state_reader.update(controller_tracking_mask, hmd_tracking_mask);
+
+        // Pass on changes to the broker's lists (including the broker coming or going) like a broker would
+        for (int list_index= 0; list_index < _eSharedDeviceList_COUNT; ++list_index)
+        {
+            const eSharedDeviceList list= static_cast<eSharedDeviceList>(list_index);
+
+            if (m_shared_state_reader.readDeviceList(list, m_frontend_device_lists[list_index]))
+            {
+                send_frontend_list_updated_notification(list);
+            }
+        }
+
+        for (int controller_id= 0; controller_id < ControllerManager::k_max_devices; ++controller_id)
+        {
+            const PSMoveProtocol::DeviceOutputDataFrame &shared_data_frame= m_frontend_controller_frames[controller_id];
+
+            if (m_shared_state_reader.readControllerDataFrame(controller_id, m_frontend_controller_frames[controller_id]) &&
+                shared_data_frame.has_controller_data_packet())
+            {
+                publish_frontend_controller_data_frame(controller_id, shared_data_frame);
+            }
+        }
+
+        for (int hmd_id= 0; hmd_id < HMDManager::k_max_devices; ++hmd_id)
+        {
+            const PSMoveProtocol::DeviceOutputDataFrame &shared_data_frame= m_frontend_hmd_frames[hmd_id];
+
+            if (m_shared_state_reader.readHMDDataFrame(hmd_id, m_frontend_hmd_frames[hmd_id]) &&
+                shared_data_frame.has_hmd_data_packet())
+            {
+                publish_frontend_hmd_data_frame(hmd_id, shared_data_frame);
+            }
+        }
+    }
+
+    void send_frontend_list_updated_notification(eSharedDeviceList list)
+    {
+        PSMoveProtocol::Response_ResponseType response_type;
+
+        switch (list)
+        {
+        case _eSharedDeviceList_Controllers:
+            response_type= PSMoveProtocol::Response_ResponseType_CONTROLLER_LIST_UPDATED;
+            break;
+        case _eSharedDeviceList_Trackers:
+            response_type= PSMoveProtocol::Response_ResponseType_TRACKER_LIST_UPDATED;
+            break;
+        case _eSharedDeviceList_HMDs:
+            response_type= PSMoveProtocol::Response_ResponseType_HMD_LIST_UPDATED;
+            break;
+        default:
+            // Clients aren't told about tracking space changes
+            return;
+        }
+
+        ResponsePtr response(new PSMoveProtocol::Response);
+        response->set_type(response_type);
+        response->set_request_id(-1);
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+
+        if (ServerNetworkManager::get_instance() != nullptr)
+        {
+            ServerNetworkManager::get_instance()->send_notification_to_all_clients(response);
+        }
+    }
+
+    void publish_frontend_controller_data_frame(
+        int controller_id,
+        const PSMoveProtocol::DeviceOutputDataFrame &shared_data_frame)
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+        float position_cm[3];
+        float orientation[4];
+        const uint64_t discrete_state=
+            get_controller_data_frame_filter_state(shared_data_frame.controller_data_packet(), position_cm, orientation);
+
+        for (t_connection_state_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
+        {
+            int connection_id= iter->first;
+            RequestConnectionStatePtr connection_state= iter->second;
+
+            if (connection_state->active_controller_streams.test(controller_id))
+            {
+                ControllerStreamInfo &streamInfo=
+                    connection_state->active_controller_stream_info[controller_id];
+
+                if (!streamInfo.stream_filter.filterUpdate(now, position_cm, orientation, discrete_state))
+                {
+                    continue;
+                }
+
+                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame(shared_data_frame));
+                trim_controller_data_frame(streamInfo, data_frame->mutable_controller_data_packet());
+
+                if (streamInfo.delta_encoder)
+                {
+                    streamInfo.delta_encoder->encode(data_frame->mutable_controller_data_packet());
+                }
+
+                ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+            }
+        }
+    }
+
+    void publish_frontend_hmd_data_frame(
+        int hmd_id,
+        const PSMoveProtocol::DeviceOutputDataFrame &shared_data_frame)
+    {
+        const std::chrono::time_point<std::chrono::high_resolution_clock> now= std::chrono::high_resolution_clock::now();
+        float position_cm[3];
+        float orientation[4];
+        const uint64_t discrete_state=
+            get_hmd_data_frame_filter_state(shared_data_frame.hmd_data_packet(), position_cm, orientation);
+
+        for (t_connection_state_iter iter= m_connection_state_map.begin(); iter != m_connection_state_map.end(); ++iter)
+        {
+            int connection_id= iter->first;
+            RequestConnectionStatePtr connection_state= iter->second;
+
+            if (connection_state->active_hmd_streams.test(hmd_id))
+            {
+                HMDStreamInfo &streamInfo=
+                    connection_state->active_hmd_stream_info[hmd_id];
+
+                if (!streamInfo.stream_filter.filterUpdate(now, position_cm, orientation, discrete_state))
+                {
+                    continue;
+                }
+
+                DeviceOutputDataFramePtr data_frame(new PSMoveProtocol::DeviceOutputDataFrame(shared_data_frame));
+                trim_hmd_data_frame(streamInfo, data_frame->mutable_hmd_data_packet());
+
+                ServerNetworkManager::get_instance()->send_device_data_frame(connection_id, data_frame);
+            }
+        }
+    }
+
+    // A front-end only serves the device lists and the controller and hmd streams.
+    // Everything that changes a device (or needs its video) has to go to the broker.
+    ResponsePtr handle_frontend_request(const RequestContext &context)
+    {
+        PSMoveProtocol::Response *response = new PSMoveProtocol::Response;
+
+        switch (context.request->type())
+        {
+            case PSMoveProtocol::Request_RequestType_GET_CONTROLLER_LIST:
+                handle_frontend_request__get_controller_list(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_START_CONTROLLER_DATA_STREAM:
+                handle_frontend_request__start_controller_data_stream(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_STOP_CONTROLLER_DATA_STREAM:
+                handle_frontend_request__stop_controller_data_stream(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_REQUEST_CONTROLLER_KEYFRAME:
+                handle_request__request_controller_keyframe(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_GET_TRACKER_LIST:
+                handle_frontend_request__get_shared_list(
+                    _eSharedDeviceList_Trackers, PSMoveProtocol::Response_ResponseType_TRACKER_LIST, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_GET_TRACKING_SPACE_SETTINGS:
+                handle_frontend_request__get_shared_list(
+                    _eSharedDeviceList_TrackingSpace, PSMoveProtocol::Response_ResponseType_TRACKING_SPACE_SETTINGS, response);
+
+                // Unlike an empty device list, there are no settings to hand out without a broker
+                if (!response->has_result_tracking_space_settings())
+                {
+                    response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+                }
+                break;
+            case PSMoveProtocol::Request_RequestType_GET_HMD_LIST:
+                handle_frontend_request__get_shared_list(
+                    _eSharedDeviceList_HMDs, PSMoveProtocol::Response_ResponseType_HMD_LIST, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_START_HMD_DATA_STREAM:
+                handle_frontend_request__start_hmd_data_stream(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_STOP_HMD_DATA_STREAM:
+                handle_frontend_request__stop_hmd_data_stream(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_GET_SERVICE_VERSION:
+                handle_request__get_service_version(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_GET_SERVICE_STATISTICS:
+                handle_request__get_service_statistics(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_SET_TRACE_RECORDING:
+                handle_request__set_trace_recording(context, response);
+                break;
+            case PSMoveProtocol::Request_RequestType_DUMP_TRACE:
+                handle_request__dump_trace(context, response);
+                break;
+
+            default:
+                SERVER_LOG_WARNING("ServerRequestHandler") 
+                    << "Request type " << context.request->type() << " needs the broker instance, refusing it.";
+
+                response->set_type(PSMoveProtocol::Response_ResponseType_GENERAL_RESULT);
+                response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+
+        response->set_request_id(context.request->request_id());
+
+        return ResponsePtr(response);
+    }
+
+    void handle_frontend_request__get_shared_list(
+        eSharedDeviceList list,
+        PSMoveProtocol::Response_ResponseType response_type,
+        PSMoveProtocol::Response *response)
+    {
+        // Without a broker the list is empty, same as a broker with no devices
+        response->CopyFrom(m_frontend_device_lists[list]);
+        response->set_type(response_type);
+        response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+    }
+
+    void handle_frontend_request__get_controller_list(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        handle_frontend_request__get_shared_list(
+            _eSharedDeviceList_Controllers, PSMoveProtocol::Response_ResponseType_CONTROLLER_LIST, response);
+
+        // The broker shares every open controller
+        if (!context.request->request_get_controller_list().include_usb_controllers())
+        {
+            auto *controllers= response->mutable_result_controller_list()->mutable_controllers();
+
+            for (int index= controllers->size() - 1; index >= 0; --index)
+            {
+                if (controllers->Get(index).connection_type() == 
+                    PSMoveProtocol::Response_ResultControllerList_ControllerInfo_ConnectionType_USB)
+                {
+                    controllers->DeleteSubrange(index, 1);
+                }
+            }
+        }
+    }
+
+    void handle_frontend_request__start_controller_data_stream(
+        const RequestContext &context, 
+        PSMoveProtocol::Response *response)
+    {
+        const PSMoveProtocol::Request_RequestStartPSMoveDataStream& request=
+            context.request->request_start_psmove_data_stream();
+        int controller_id= request.controller_id();
+
+        response->set_type(PSMoveProtocol::Response_ResponseType_CONTROLLER_STREAM_STARTED);
+
+        // The broker only shares the frames of stream-able controllers
+        if (ServerUtility::is_index_valid(controller_id, ControllerManager::k_max_devices) &&
+            m_frontend_controller_frames[controller_id].has_controller_data_packet())
+        {
+            ControllerStreamInfo &streamInfo =
+                context.connection_state->active_controller_stream_info[controller_id];
+
+            context.connection_state->active_controller_streams.set(controller_id, true);
+
+            // ROI suppression is left to the broker's own connections.
+            // The raw tracker data always comes from the broker's default tracker.
+            streamInfo.Clear();
+            streamInfo.include_position_data = request.include_position_data();
+            streamInfo.include_physics_data = request.include_physics_data();
+            streamInfo.include_raw_sensor_data = request.include_raw_sensor_data();
+            streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
+            streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
+            streamInfo.stream_filter.setLimits(make_data_stream_limits(request));
+
+            if (request.use_delta_frames())
+            {
+                streamInfo.delta_encoder.reset(new ControllerDataFrameDeltaEncoder);
+            }
+
+            SERVER_LOG_INFO("ServerRequestHandler") << "Start shared controller(" << controller_id << ") stream ("
+                << "pos=" << streamInfo.include_position_data
+                << ",phys=" << streamInfo.include_physics_data
+                << ",raw_sens=" << streamInfo.include_raw_sensor_data
+                << ",cal_sens=" << streamInfo.include_calibrated_sensor_data
+                << ",trkr=" << streamInfo.include_raw_tracker_data
+                << ",hz=" << streamInfo.stream_filter.getLimits().max_rate_hz
+                << ",delta=" << (streamInfo.delta_encoder ? 1 : 0)
+                << ")";
+
+            // Attach the latest state the broker shared.
+            // Tracking requested here shows up in the frames once the broker's next update picks it up.
+            {
+                auto *stream_started_response= response->mutable_result_controller_stream_started();
+                PSMoveProtocol::DeviceOutputDataFrame* data_frame= stream_started_response->mutable_initial_data_frame();
+
+                data_frame->CopyFrom(m_frontend_controller_frames[controller_id]);
+                trim_controller_data_frame(streamInfo, data_frame->mutable_controller_data_packet());
+            }
+
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            SERVER_LOG_INFO("ServerRequestHandler") << "Failed to start controller(" << controller_id << ") stream: Not shared by a broker.";
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
+    void handle_frontend_request__stop_controller_data_stream(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        int controller_id= context.request->request_stop_psmove_data_stream().controller_id();
+
+        if (ServerUtility::is_index_valid(controller_id, ControllerManager::k_max_devices))
+        {
+            // The broker lets go of the tracking on its next update if nobody else wants it
+            SERVER_LOG_INFO("ServerRequestHandler") << "Stop shared controller(" << controller_id << ") stream";
+
+            context.connection_state->active_controller_streams.set(controller_id, false);
+            context.connection_state->active_controller_stream_info[controller_id].Clear();
+
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
+    void handle_frontend_request__start_hmd_data_stream(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        const PSMoveProtocol::Request_RequestStartHmdDataStream& request =
+            context.request->request_start_hmd_data_stream();
+        int hmd_id = request.hmd_id();
+
+        if (ServerUtility::is_index_valid(hmd_id, HMDManager::k_max_devices) &&
+            m_frontend_hmd_frames[hmd_id].has_hmd_data_packet())
+        {
+            HMDStreamInfo &streamInfo =
+                context.connection_state->active_hmd_stream_info[hmd_id];
+
+            context.connection_state->active_hmd_streams.set(hmd_id, true);
+
+            streamInfo.Clear();
+            streamInfo.include_position_data = request.include_position_data();
+            streamInfo.include_physics_data = request.include_physics_data();
+            streamInfo.include_raw_sensor_data = request.include_raw_sensor_data();
+            streamInfo.include_calibrated_sensor_data = request.include_calibrated_sensor_data();
+            streamInfo.include_raw_tracker_data = request.include_raw_tracker_data();
+            streamInfo.stream_filter.setLimits(make_data_stream_limits(request));
+
+            SERVER_LOG_INFO("ServerRequestHandler") << "Start shared hmd(" << hmd_id << ") stream ("
+                << "pos=" << streamInfo.include_position_data
+                << ",phys=" << streamInfo.include_physics_data
+                << ",raw_sens=" << streamInfo.include_raw_sensor_data
+                << ",cal_sens=" << streamInfo.include_calibrated_sensor_data
+                << ",trkr=" << streamInfo.include_raw_tracker_data
+                << ",hz=" << streamInfo.stream_filter.getLimits().max_rate_hz
+                << ")";
+
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
+    void handle_frontend_request__stop_hmd_data_stream(
+        const RequestContext &context,
+        PSMoveProtocol::Response *response)
+    {
+        int hmd_id = context.request->request_stop_hmd_data_stream().hmd_id();
+
+        if (ServerUtility::is_index_valid(hmd_id, HMDManager::k_max_devices))
+        {
+            context.connection_state->active_hmd_streams.set(hmd_id, false);
+            context.connection_state->active_hmd_stream_info[hmd_id].Clear();
+
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_OK);
+        }
+        else
+        {
+            response->set_result_code(PSMoveProtocol::Response_ResultCode_RESULT_ERROR);
+        }
+    }
+
 private:
     DeviceManager &m_device_manager;
     t_connection_state_map m_connection_state_map;
+
+    // Device sharing between a broker and its front-ends
+    eDeviceSharingMode m_sharing_mode;
+    SharedDeviceStateWriter m_shared_state_writer;
+    SharedDeviceStateReader m_shared_state_reader;
+
+    // Broker: scratch frame, and the stream settings, the shared frames and lists are built with
+    DeviceOutputDataFramePtr m_shared_data_frame;
+    RequestConnectionStatePtr m_shared_list_connection_state;
+    std::chrono::steady_clock::time_point m_next_shared_device_list_time;
+    ControllerStreamInfo m_shared_controller_stream_info;
+    HMDStreamInfo m_shared_hmd_stream_info;
+
+    // Broker: the devices we hold a tracking reference on for the front-ends
+    unsigned int m_broker_controller_tracking_mask;
+    unsigned int m_broker_hmd_tracking_mask;
+
+    // Front-end: the latest lists and frames read from the broker
+    PSMoveProtocol::Response m_frontend_device_lists[_eSharedDeviceList_COUNT];
+    PSMoveProtocol::DeviceOutputDataFrame m_frontend_controller_frames[ControllerManager::k_max_devices];
+    PSMoveProtocol::DeviceOutputDataFrame m_frontend_hmd_frames[HMDManager::k_max_devices];
 };
 
 //-- public interface -----
@@ -3253,10 +4496,10 @@ bool ServerRequestHandler::any_active_bluetooth_requests() const
     return m_implementation_ptr->any_active_bluetooth_requests();
 }
 
-bool ServerRequestHandler::startup()
+bool ServerRequestHandler::startup(eDeviceSharingMode sharing_mode)
 {
     m_instance= this;
-    return true;
+    return m_implementation_ptr->startup(sharing_mode);
 }
 
 void ServerRequestHandler::update()
@@ -3266,6 +4509,7 @@ void ServerRequestHandler::update()
 
 void ServerRequestHandler::shutdown()
 {
+    m_implementation_ptr->shutdown();
     m_instance= NULL;
 }
 
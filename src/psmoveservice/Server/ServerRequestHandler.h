@@ -3,6 +3,9 @@
 
 // -- includes -----
 #include "PSMoveProtocolInterface.h"
+#include "DataStreamFilter.h"
+#include "DataFrameDelta.h"
+#include <memory>
 
 // -- pre-declarations -----
 class DeviceManager;
@@ -11,6 +14,15 @@ namespace boost {
         class variables_map;
 }};
 
+// -- constants -----
+// How an instance of the service shares its devices with other instances
+enum eDeviceSharingMode
+{
+    _eDeviceSharingMode_None,     // owns the devices and serves only its own clients
+    _eDeviceSharingMode_Broker,   // owns the devices and also publishes their state to front-end instances
+    _eDeviceSharingMode_Frontend  // opens no devices, serves its clients from the state a broker publishes
+};
+
 // -- definitions -----
 struct ControllerStreamInfo
 {
@@ -23,6 +35,8 @@ struct ControllerStreamInfo
 	bool disable_roi;
     int last_data_input_sequence_number;
     int selected_tracker_index;
+    DataStreamFilter stream_filter; // rate limit and deadband the connection asked for
+    std::shared_ptr<ControllerDataFrameDeltaEncoder> delta_encoder; // null unless the connection asked for delta frames
 
     inline void Clear()
     {
@@ -35,6 +49,8 @@ struct ControllerStreamInfo
 		disable_roi = false;
 		last_data_input_sequence_number = -1;
         selected_tracker_index = 0;
+        stream_filter.setLimits(DataStreamLimits());
+        delta_encoder.reset();
     }
 };
 
@@ -59,6 +75,7 @@ struct HMDStreamInfo
 	bool include_raw_tracker_data;
 	bool disable_roi;
     int selected_tracker_index;
+    DataStreamFilter stream_filter; // rate limit and deadband the connection asked for
 
     inline void Clear()
     {
@@ -69,6 +86,7 @@ struct HMDStreamInfo
 		include_raw_tracker_data = false;
 		disable_roi = false;
         selected_tracker_index = 0;
+        stream_filter.setLimits(DataStreamLimits());
     }
 };
 
@@ -82,7 +100,7 @@ public:
 
     bool any_active_bluetooth_requests() const;
 
-    bool startup();
+    bool startup(eDeviceSharingMode sharing_mode = _eDeviceSharingMode_None);
     void update();
     void shutdown();
 
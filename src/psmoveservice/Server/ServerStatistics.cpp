@@ -0,0 +1,328 @@
+//-- includes -----
+#include "ServerStatistics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//-- constants -----
+// Log-linear microsecond buckets: 0-7us get a bucket each,
+// above that every power of two is split into 4 buckets (each at most 25% wide)
+static const int k_stat_exact_bucket_count = 8;
+static const int k_stat_sub_bucket_bits = 2;
+static const int k_stat_sub_bucket_count = 1 << k_stat_sub_bucket_bits;
+static const int k_stat_min_exponent = 3;
+static const int k_stat_max_exponent = 26; // ~67s, anything slower lands in the last bucket
+static const int k_stat_bucket_count =
+    k_stat_exact_bucket_count + (k_stat_max_exponent - k_stat_min_exponent + 1) * k_stat_sub_bucket_count;
+static const unsigned int k_stat_max_microseconds = (1u << (k_stat_max_exponent + 1)) - 1;
+
+// One slot per device id plus one for samples not tied to a device
+static const int k_stat_device_slot_count = k_stat_max_device_count + 1;
+static const int k_stat_no_device_slot = k_stat_max_device_count;
+
+static const char *k_stat_stage_names[_stat_stage_count] = {
+    "controller_sensor",
+    "controller_filter",
+    "controller_publish",
+    "hmd_sensor",
+    "hmd_filter",
+    "hmd_publish",
+    "tracker_frame_grab",
+    "tracker_hsv",
+    "tracker_contours",
+    "tracker_pose_fit",
+    "tracker_publish",
+    "udp_send",
+    "tracker_drift_check"
+};
+
+//-- definitions -----
+// Only ever written by the thread that owns it, so the counters are bumped with a plain
+// load and store rather than a locked read-modify-write. They are atomic so that
+// the thread building a summary can read them at the same time.
+struct StatHistogram
+{
+    std::atomic<unsigned int> bucket_counts[k_stat_bucket_count];
+    std::atomic<unsigned int> max_microseconds;
+
+    void clear()
+    {
+        for (int bucket_index = 0; bucket_index < k_stat_bucket_count; ++bucket_index)
+        {
+            bucket_counts[bucket_index].store(0, std::memory_order_relaxed);
+        }
+        max_microseconds.store(0, std::memory_order_relaxed);
+    }
+
+    void record(const unsigned int microseconds, const int bucket_index)
+    {
+        std::atomic<unsigned int> &bucket_count = bucket_counts[bucket_index];
+
+        bucket_count.store(bucket_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (microseconds > max_microseconds.load(std::memory_order_relaxed))
+        {
+            max_microseconds.store(microseconds, std::memory_order_relaxed);
+        }
+    }
+};
+
+// All of the histograms recorded on one thread
+class StatThreadTable
+{
+public:
+    StatThreadTable(unsigned int epoch)
+        : m_epoch(epoch)
+        , m_bThreadExited(false)
+    {
+        clearHistograms();
+    }
+
+    // Owner thread side: a reset bumps the global epoch and
+    // each thread clears its own histograms the next time it records
+    StatHistogram &fetchHistogram(e_stat_stage stage, int slot, unsigned int current_epoch)
+    {
+        if (m_epoch.load(std::memory_order_relaxed) != current_epoch)
+        {
+            clearHistograms();
+            m_epoch.store(current_epoch, std::memory_order_release);
+        }
+
+        return m_histograms[stage][slot];
+    }
+
+    // Reader side
+    inline unsigned int getEpoch() const { return m_epoch.load(std::memory_order_acquire); }
+    inline const StatHistogram &getHistogram(int stage, int slot) const { return m_histograms[stage][slot]; }
+
+    inline void markThreadExited() { m_bThreadExited.store(true); }
+    inline bool hasThreadExited() const { return m_bThreadExited.load(); }
+
+private:
+    void clearHistograms()
+    {
+        for (int stage = 0; stage < _stat_stage_count; ++stage)
+        {
+            for (int slot = 0; slot < k_stat_device_slot_count; ++slot)
+            {
+                m_histograms[stage][slot].clear();
+            }
+        }
+    }
+
+    StatHistogram m_histograms[_stat_stage_count][k_stat_device_slot_count];
+    std::atomic<unsigned int> m_epoch;
+    std::atomic_bool m_bThreadExited;
+};
+
+// Owned by each thread that records. Lets the reader know when the table can be dropped.
+struct StatThreadTableHandle
+{
+    std::shared_ptr<StatThreadTable> table;
+
+    ~StatThreadTableHandle()
+    {
+        if (table)
+        {
+            table->markThreadExited();
+        }
+    }
+};
+
+//-- globals -----
+static std::atomic<unsigned int> g_stat_epoch(0);
+
+// Every thread's table. The mutex is only taken when a thread records for the first time
+// and when a summary is built.
+static std::mutex g_stat_table_registry_mutex;
+static std::vector<std::shared_ptr<StatThreadTable>> g_stat_tables;
+static std::chrono::high_resolution_clock::time_point g_stat_window_start = std::chrono::high_resolution_clock::now();
+static thread_local StatThreadTableHandle t_stat_table_handle;
+
+//-- prototypes -----
+static int stats_compute_bucket_index(unsigned int microseconds);
+static float stats_compute_bucket_midpoint(int bucket_index);
+static float stats_compute_percentile(const unsigned int *bucket_counts, unsigned int sample_count, float fraction);
+
+//-- public implementation -----
+void stats_record_duration(e_stat_stage stage, int device_id, std::chrono::high_resolution_clock::duration duration)
+{
+    // First sample from this thread: give it a table
+    if (!t_stat_table_handle.table)
+    {
+        std::lock_guard<std::mutex> lock(g_stat_table_registry_mutex);
+
+        t_stat_table_handle.table = std::make_shared<StatThreadTable>(g_stat_epoch.load());
+        g_stat_tables.push_back(t_stat_table_handle.table);
+    }
+
+    const long long elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    const unsigned int microseconds =
+        static_cast<unsigned int>(std::min(std::max(elapsed_us, 0LL), static_cast<long long>(k_stat_max_microseconds)));
+    const int slot = (device_id >= 0 && device_id < k_stat_max_device_count) ? device_id : k_stat_no_device_slot;
+
+    StatHistogram &histogram =
+        t_stat_table_handle.table->fetchHistogram(stage, slot, g_stat_epoch.load(std::memory_order_relaxed));
+    histogram.record(microseconds, stats_compute_bucket_index(microseconds));
+}
+
+const char *stats_get_stage_name(e_stat_stage stage)
+{
+    return (stage >= 0 && stage < _stat_stage_count) ? k_stat_stage_names[stage] : "unknown";
+}
+
+float stats_get_summaries(std::vector<StatStageSummary> &out_summaries)
+{
+    std::lock_guard<std::mutex> lock(g_stat_table_registry_mutex);
+    const unsigned int current_epoch = g_stat_epoch.load();
+    const int histogram_count = _stat_stage_count * k_stat_device_slot_count;
+
+    std::vector<unsigned int> merged_bucket_counts(histogram_count * k_stat_bucket_count, 0);
+    std::vector<unsigned int> merged_max_microseconds(histogram_count, 0);
+
+    for (auto it = g_stat_tables.begin(); it != g_stat_tables.end(); )
+    {
+        const StatThreadTable *table = it->get();
+
+        // Check for exit before reading, so a thread's last samples are still counted
+        const bool bThreadExited = table->hasThreadExited();
+
+        // Tables that haven't caught up with the last reset only hold stale samples
+        if (table->getEpoch() == current_epoch)
+        {
+            for (int histogram_index = 0; histogram_index < histogram_count; ++histogram_index)
+            {
+                const StatHistogram &histogram =
+                    table->getHistogram(histogram_index / k_stat_device_slot_count, histogram_index % k_stat_device_slot_count);
+                unsigned int *bucket_counts = &merged_bucket_counts[histogram_index * k_stat_bucket_count];
+
+                for (int bucket_index = 0; bucket_index < k_stat_bucket_count; ++bucket_index)
+                {
+                    bucket_counts[bucket_index] += histogram.bucket_counts[bucket_index].load(std::memory_order_relaxed);
+                }
+                merged_max_microseconds[histogram_index] =
+                    std::max(merged_max_microseconds[histogram_index], histogram.max_microseconds.load(std::memory_order_relaxed));
+            }
+        }
+        else if (bThreadExited)
+        {
+            // Nothing left in it that will ever be reported
+            it = g_stat_tables.erase(it);
+            continue;
+        }
+
+        ++it;
+    }
+
+    const float window_seconds =
+        std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - g_stat_window_start).count();
+
+    out_summaries.clear();
+    for (int histogram_index = 0; histogram_index < histogram_count; ++histogram_index)
+    {
+        const unsigned int *bucket_counts = &merged_bucket_counts[histogram_index * k_stat_bucket_count];
+
+        unsigned int sample_count = 0;
+        for (int bucket_index = 0; bucket_index < k_stat_bucket_count; ++bucket_index)
+        {
+            sample_count += bucket_counts[bucket_index];
+        }
+
+        if (sample_count > 0)
+        {
+            const int slot = histogram_index % k_stat_device_slot_count;
+            const float max_microseconds = static_cast<float>(merged_max_microseconds[histogram_index]);
+            StatStageSummary summary;
+
+            summary.stage = static_cast<e_stat_stage>(histogram_index / k_stat_device_slot_count);
+            summary.device_id = (slot == k_stat_no_device_slot) ? -1 : slot;
+            summary.sample_count = static_cast<long long>(sample_count);
+            summary.samples_per_second = (window_seconds > 0.f) ? static_cast<float>(sample_count) / window_seconds : 0.f;
+            summary.p50_microseconds = std::min(stats_compute_percentile(bucket_counts, sample_count, 0.5f), max_microseconds);
+            summary.p99_microseconds = std::min(stats_compute_percentile(bucket_counts, sample_count, 0.99f), max_microseconds);
+            summary.max_microseconds = max_microseconds;
+
+            out_summaries.push_back(summary);
+        }
+    }
+
+    return window_seconds;
+}
+
+void stats_reset()
+{
+    std::lock_guard<std::mutex> lock(g_stat_table_registry_mutex);
+
+    ++g_stat_epoch;
+    g_stat_window_start = std::chrono::high_resolution_clock::now();
+}
+
+//-- member functions -----
+StatScopedTimer::StatScopedTimer(e_stat_stage stage, int device_id)
+    : m_startTime(std::chrono::high_resolution_clock::now())
+    , m_stage(stage)
+    , m_deviceId(device_id)
+{
+}
+
+StatScopedTimer::~StatScopedTimer()
+{
+    stats_record_duration(m_stage, m_deviceId, std::chrono::high_resolution_clock::now() - m_startTime);
+}
+
+//-- private implementation -----
+static int stats_compute_bucket_index(unsigned int microseconds)
+{
+    if (microseconds < static_cast<unsigned int>(k_stat_exact_bucket_count))
+    {
+        return static_cast<int>(microseconds);
+    }
+
+    int exponent = k_stat_min_exponent;
+    while ((microseconds >> (exponent + 1)) != 0)
+    {
+        ++exponent;
+    }
+
+    const int sub_bucket = static_cast<int>(microseconds >> (exponent - k_stat_sub_bucket_bits)) & (k_stat_sub_bucket_count - 1);
+
+    return k_stat_exact_bucket_count + (exponent - k_stat_min_exponent) * k_stat_sub_bucket_count + sub_bucket;
+}
+
+static float stats_compute_bucket_midpoint(int bucket_index)
+{
+    if (bucket_index < k_stat_exact_bucket_count)
+    {
+        // Durations are truncated to whole microseconds
+        return static_cast<float>(bucket_index) + 0.5f;
+    }
+
+    const int exponent = (bucket_index - k_stat_exact_bucket_count) / k_stat_sub_bucket_count + k_stat_min_exponent;
+    const int sub_bucket = (bucket_index - k_stat_exact_bucket_count) % k_stat_sub_bucket_count;
+    const float bucket_width = static_cast<float>(1u << (exponent - k_stat_sub_bucket_bits));
+    const float lower_bound = static_cast<float>(k_stat_sub_bucket_count + sub_bucket) * bucket_width;
+
+    return lower_bound + 0.5f * bucket_width;
+}
+
+static float stats_compute_percentile(const unsigned int *bucket_counts, unsigned int sample_count, float fraction)
+{
+    // Rank of the sample at the given fraction (1-based)
+    const unsigned int target_rank =
+        std::max(static_cast<unsigned int>(static_cast<float>(sample_count) * fraction + 0.999f), 1u);
+    unsigned int cumulative_count = 0;
+
+    for (int bucket_index = 0; bucket_index < k_stat_bucket_count; ++bucket_index)
+    {
+        cumulative_count += bucket_counts[bucket_index];
+
+        if (cumulative_count >= target_rank)
+        {
+            return stats_compute_bucket_midpoint(bucket_index);
+        }
+    }
+
+    return stats_compute_bucket_midpoint(k_stat_bucket_count - 1);
+}
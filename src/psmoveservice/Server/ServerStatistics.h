@@ -0,0 +1,75 @@
+#ifndef SERVER_STATISTICS_H
+#define SERVER_STATISTICS_H
+
+//-- includes -----
+#include "SharedConstants.h"
+
+#include <chrono>
+#include <vector>
+
+//-- constants -----
+// Pipeline stages timed by the service.
+// Keep in sync with k_stat_stage_names in ServerStatistics.cpp.
+enum e_stat_stage
+{
+    _stat_stage_controller_sensor,  // HID packet hand off to the filter queue (controller worker thread)
+    _stat_stage_controller_filter,  // one pose filter update
+    _stat_stage_controller_publish, // building and queuing the data frame for every listening client
+    _stat_stage_hmd_sensor,         // HID poll and packet processing
+    _stat_stage_hmd_filter,
+    _stat_stage_hmd_publish,
+    _stat_stage_tracker_frame_grab, // video frame grab and debayer (done together by the capture driver)
+    _stat_stage_tracker_hsv,        // ROI selection and BGR to HSV conversion
+    _stat_stage_tracker_contours,   // HSV threshold and blob/contour extraction
+    _stat_stage_tracker_pose_fit,   // shape fit of the chosen contour(s)
+    _stat_stage_tracker_publish,
+    _stat_stage_udp_send,           // data frame packed until the async send completes (all connections)
+    _stat_stage_tracker_drift_check, // pose drift solve over the buffered bulb sightings (all trackers)
+
+    _stat_stage_count
+};
+
+// Covers every controller, tracker and hmd slot the device managers can be configured with.
+// Samples for device ids outside [0, k_stat_max_device_count) are merged under device id -1
+static const int k_stat_max_device_count =
+    (PSMOVESERVICE_MAX_CONTROLLER_COUNT > PSMOVESERVICE_MAX_TRACKER_COUNT)
+    ? ((PSMOVESERVICE_MAX_CONTROLLER_COUNT > PSMOVESERVICE_MAX_HMD_COUNT) ? PSMOVESERVICE_MAX_CONTROLLER_COUNT : PSMOVESERVICE_MAX_HMD_COUNT)
+    : ((PSMOVESERVICE_MAX_TRACKER_COUNT > PSMOVESERVICE_MAX_HMD_COUNT) ? PSMOVESERVICE_MAX_TRACKER_COUNT : PSMOVESERVICE_MAX_HMD_COUNT);
+
+//-- definitions -----
+struct StatStageSummary
+{
+    e_stat_stage stage;
+    int device_id; // -1 for stages that aren't tied to a device
+    long long sample_count;
+    float samples_per_second;
+    float p50_microseconds;
+    float p99_microseconds;
+    float max_microseconds;
+};
+
+// Records the time between construction and destruction to the given stage.
+// Only the calling thread's histograms are touched, so these can be used from any thread.
+class StatScopedTimer
+{
+public:
+    StatScopedTimer(e_stat_stage stage, int device_id);
+    ~StatScopedTimer();
+
+private:
+    std::chrono::high_resolution_clock::time_point m_startTime;
+    e_stat_stage m_stage;
+    int m_deviceId;
+};
+
+//-- interface -----
+void stats_record_duration(e_stat_stage stage, int device_id, std::chrono::high_resolution_clock::duration duration);
+const char *stats_get_stage_name(e_stat_stage stage);
+
+// Merges the histograms of every thread into one summary per (stage, device) with samples.
+// Percentiles have the resolution of the histogram buckets (within 12.5%).
+// Returns the length in seconds of the sampling window, which starts at startup or the last reset.
+float stats_get_summaries(std::vector<StatStageSummary> &out_summaries);
+void stats_reset();
+
+#endif  // SERVER_STATISTICS_H
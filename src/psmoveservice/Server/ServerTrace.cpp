@@ -0,0 +1,268 @@
+//-- includes -----
+#include "ServerTrace.h"
+#include "ServerLog.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//-- constants -----
+static const unsigned long long k_trace_ring_capacity = 1 << 16; // events, must be a power of two
+
+//-- definitions -----
+// One event in the ring. Written by any thread, so the fields are relaxed atomics guarded
+// by the sequence number (seqlock style): the sequence is zeroed while the slot is being
+// written and set to the event's index + 1 once it's complete.
+struct TraceEventSlot
+{
+    std::atomic<unsigned long long> sequence;
+    std::atomic<const char *> name;
+    std::atomic<int> device_id;
+    std::atomic<int> thread_id;
+    std::atomic<long long> start_ns;
+    std::atomic<long long> duration_ns;
+};
+
+struct TraceEvent
+{
+    const char *name;
+    int device_id;
+    int thread_id;
+    long long start_ns;
+    long long duration_ns;
+};
+
+//-- globals -----
+std::atomic_bool g_trace_recording(false);
+
+static const std::chrono::high_resolution_clock::time_point g_trace_epoch = std::chrono::high_resolution_clock::now();
+static std::atomic<unsigned long long> g_trace_next_event_index(0);
+static std::atomic<TraceEventSlot *> g_trace_ring(nullptr);
+static std::atomic<int> g_trace_next_thread_id(1);
+static thread_local int t_trace_thread_id = 0;
+
+// Ring allocation and thread names
+static std::mutex g_trace_mutex;
+static std::unique_ptr<TraceEventSlot[]> g_trace_ring_storage;
+static std::map<int, std::string> g_trace_thread_names;
+
+//-- prototypes -----
+static int trace_get_thread_id();
+static void trace_append_json_string(const std::string &value, std::string &output_buffer);
+static void trace_append_microseconds(long long nanoseconds, std::string &output_buffer);
+
+//-- public implementation -----
+void trace_set_recording(bool bEnabled)
+{
+    if (bEnabled && g_trace_ring.load() == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(g_trace_mutex);
+
+        g_trace_ring_storage.reset(new TraceEventSlot[k_trace_ring_capacity]);
+        for (unsigned long long slot_index = 0; slot_index < k_trace_ring_capacity; ++slot_index)
+        {
+            g_trace_ring_storage[slot_index].sequence.store(0, std::memory_order_relaxed);
+        }
+        g_trace_ring.store(g_trace_ring_storage.get());
+    }
+
+    if (bEnabled != g_trace_recording.load())
+    {
+        SERVER_LOG_INFO("trace_set_recording") << (bEnabled ? "Started" : "Stopped") << " trace recording";
+        g_trace_recording.store(bEnabled);
+    }
+}
+
+void trace_set_thread_name(const std::string &thread_name)
+{
+    const int thread_id = trace_get_thread_id();
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+
+    g_trace_thread_names[thread_id] = thread_name;
+}
+
+void trace_record_event(
+    const char *name, int device_id,
+    const std::chrono::high_resolution_clock::time_point &start_time,
+    const std::chrono::high_resolution_clock::time_point &end_time)
+{
+    TraceEventSlot *ring = g_trace_ring.load(std::memory_order_acquire);
+    if (ring == nullptr)
+    {
+        return;
+    }
+
+    const unsigned long long event_index = g_trace_next_event_index.fetch_add(1, std::memory_order_relaxed);
+    TraceEventSlot &slot = ring[event_index & (k_trace_ring_capacity - 1)];
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.device_id.store(device_id, std::memory_order_relaxed);
+    slot.thread_id.store(trace_get_thread_id(), std::memory_order_relaxed);
+    slot.start_ns.store(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start_time - g_trace_epoch).count(),
+        std::memory_order_relaxed);
+    slot.duration_ns.store(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count(),
+        std::memory_order_relaxed);
+
+    slot.sequence.store(event_index + 1, std::memory_order_release);
+}
+
+bool trace_write_chrome_json(const std::string &filename, int *out_event_count)
+{
+    std::vector<TraceEvent> events;
+    std::map<int, std::string> thread_names;
+
+    // Copy out the most recent ring's worth of events.
+    // Slots that are being (re)written while we read them are skipped.
+    TraceEventSlot *ring = g_trace_ring.load(std::memory_order_acquire);
+    if (ring != nullptr)
+    {
+        const unsigned long long end_index = g_trace_next_event_index.load();
+        const unsigned long long begin_index = (end_index > k_trace_ring_capacity) ? end_index - k_trace_ring_capacity : 0;
+
+        events.reserve(static_cast<size_t>(end_index - begin_index));
+        for (unsigned long long event_index = begin_index; event_index < end_index; ++event_index)
+        {
+            const TraceEventSlot &slot = ring[event_index & (k_trace_ring_capacity - 1)];
+            const unsigned long long sequence = slot.sequence.load(std::memory_order_acquire);
+
+            if (sequence == event_index + 1)
+            {
+                TraceEvent event;
+                event.name = slot.name.load(std::memory_order_relaxed);
+                event.device_id = slot.device_id.load(std::memory_order_relaxed);
+                event.thread_id = slot.thread_id.load(std::memory_order_relaxed);
+                event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+                event.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+                {
+                    events.push_back(event);
+                }
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_trace_mutex);
+        thread_names = g_trace_thread_names;
+    }
+
+    std::sort(
+        events.begin(), events.end(),
+        [](const TraceEvent &a, const TraceEvent &b) {
+            // Enclosing scopes first, so nested events that start together stack correctly
+            return (a.start_ns != b.start_ns) ? a.start_ns < b.start_ns : a.duration_ns > b.duration_ns;
+    });
+
+    // Chrome trace event format, complete ("X") events with microsecond timestamps
+    std::string output_buffer;
+    output_buffer.reserve(events.size() * 96 + 256);
+    output_buffer.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool bFirstEvent = true;
+    for (const auto &thread_name : thread_names)
+    {
+        output_buffer.append(bFirstEvent ? "" : ",\n");
+        output_buffer.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+        output_buffer.append(std::to_string(thread_name.first));
+        output_buffer.append(",\"args\":{\"name\":");
+        trace_append_json_string(thread_name.second, output_buffer);
+        output_buffer.append("}}");
+        bFirstEvent = false;
+    }
+
+    for (const TraceEvent &event : events)
+    {
+        output_buffer.append(bFirstEvent ? "" : ",\n");
+        output_buffer.append("{\"name\":");
+        trace_append_json_string(event.name, output_buffer);
+        output_buffer.append(",\"cat\":\"psmoveservice\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+        output_buffer.append(std::to_string(event.thread_id));
+        output_buffer.append(",\"ts\":");
+        trace_append_microseconds(event.start_ns, output_buffer);
+        output_buffer.append(",\"dur\":");
+        trace_append_microseconds(event.duration_ns, output_buffer);
+        if (event.device_id >= 0)
+        {
+            output_buffer.append(",\"args\":{\"device_id\":");
+            output_buffer.append(std::to_string(event.device_id));
+            output_buffer.append("}");
+        }
+        output_buffer.append("}");
+        bFirstEvent = false;
+    }
+    output_buffer.append("\n]}\n");
+
+    std::ofstream file_stream(filename, std::ofstream::out | std::ofstream::trunc);
+    if (!file_stream.is_open())
+    {
+        SERVER_LOG_ERROR("trace_write_chrome_json") << "Failed to open trace file: " << filename;
+        return false;
+    }
+
+    file_stream.write(output_buffer.data(), output_buffer.size());
+    file_stream.close();
+
+    if (file_stream.fail())
+    {
+        SERVER_LOG_ERROR("trace_write_chrome_json") << "Failed to write trace file: " << filename;
+        return false;
+    }
+
+    SERVER_LOG_INFO("trace_write_chrome_json") << "Wrote " << events.size() << " trace events to " << filename;
+    if (out_event_count != nullptr)
+    {
+        *out_event_count = static_cast<int>(events.size());
+    }
+
+    return true;
+}
+
+//-- private implementation -----
+static int trace_get_thread_id()
+{
+    if (t_trace_thread_id == 0)
+    {
+        t_trace_thread_id = g_trace_next_thread_id.fetch_add(1);
+    }
+
+    return t_trace_thread_id;
+}
+
+static void trace_append_json_string(const std::string &value, std::string &output_buffer)
+{
+    output_buffer.push_back('"');
+    for (const char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            output_buffer.push_back('\\');
+            output_buffer.push_back(c);
+        }
+        else if (static_cast<unsigned char>(c) >= 0x20)
+        {
+            output_buffer.push_back(c);
+        }
+    }
+    output_buffer.push_back('"');
+}
+
+static void trace_append_microseconds(long long nanoseconds, std::string &output_buffer)
+{
+    const long long fraction = nanoseconds % 1000;
+
+    output_buffer.append(std::to_string(nanoseconds / 1000));
+    output_buffer.push_back('.');
+    output_buffer.push_back(static_cast<char>('0' + fraction / 100));
+    output_buffer.push_back(static_cast<char>('0' + (fraction / 10) % 10));
+    output_buffer.push_back(static_cast<char>('0' + fraction % 10));
+}
@@ -0,0 +1,76 @@
+#ifndef SERVER_TRACE_H
+#define SERVER_TRACE_H
+
+//-- includes -----
+#include <atomic>
+#include <chrono>
+#include <string>
+
+//-- constants -----
+// Used for SIGUSR1 dumps and DUMP_TRACE requests without a filename
+#define TRACE_DEFAULT_DUMP_FILE "psmoveservice_trace.json"
+
+//-- globals -----
+extern std::atomic_bool g_trace_recording;
+
+//-- interface -----
+inline bool trace_is_recording()
+{
+    return g_trace_recording.load(std::memory_order_relaxed);
+}
+
+// The event ring is allocated the first time recording is turned on
+void trace_set_recording(bool bEnabled);
+
+// Names the calling thread in the trace (shown as the track name in chrome://tracing / Perfetto)
+void trace_set_thread_name(const std::string &thread_name);
+
+// Records a complete event for the calling thread.
+// The name has to outlive the trace, i.e. be a string literal.
+void trace_record_event(
+    const char *name, int device_id,
+    const std::chrono::high_resolution_clock::time_point &start_time,
+    const std::chrono::high_resolution_clock::time_point &end_time);
+
+// Writes the events currently in the ring to a Chrome trace event format JSON file
+bool trace_write_chrome_json(const std::string &filename, int *out_event_count);
+
+//-- definitions -----
+// Records the time between construction and destruction as one event.
+// When recording is off this costs a single relaxed load.
+class TraceScope
+{
+public:
+    inline TraceScope(const char *name, int device_id = -1)
+        : m_name(trace_is_recording() ? name : nullptr)
+        , m_deviceId(device_id)
+    {
+        if (m_name != nullptr)
+        {
+            m_startTime = std::chrono::high_resolution_clock::now();
+        }
+    }
+
+    inline ~TraceScope()
+    {
+        if (m_name != nullptr)
+        {
+            trace_record_event(m_name, m_deviceId, m_startTime, std::chrono::high_resolution_clock::now());
+        }
+    }
+
+private:
+    const char *m_name;
+    int m_deviceId;
+    std::chrono::high_resolution_clock::time_point m_startTime;
+};
+
+//-- macros -----
+#define SERVER_TRACE_CONCAT_INNER(a, b) a##b
+#define SERVER_TRACE_CONCAT(a, b) SERVER_TRACE_CONCAT_INNER(a, b)
+
+// Trace the rest of the enclosing scope
+#define SERVER_TRACE_SCOPE(name) TraceScope SERVER_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define SERVER_TRACE_DEVICE_SCOPE(name, device_id) TraceScope SERVER_TRACE_CONCAT(trace_scope_, __LINE__)(name, device_id)
+
+#endif  // SERVER_TRACE_H
@@ -0,0 +1,729 @@
+//-- includes -----
+#include "SharedDeviceState.h"
+#include "PSMoveProtocol.pb.h"
+#include "ServerLog.h"
+#include "SharedStateSlot.h"
+
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+
+//-- constants -----
+// Guards against attaching to a block laid out by a different build of the service
+static const unsigned int k_shared_device_state_magic = 0x50534453; // "PSDS"
+static const unsigned int k_shared_device_state_layout_version = 1;
+
+// Room for a controller or HMD data frame with every optional section in it
+static const unsigned int k_shared_data_frame_capacity = 2048;
+// Room for the device list responses, which carry strings per device
+static const unsigned int k_shared_device_list_capacity = 32*1024;
+
+// How often a broker starting up looks at the heartbeat of a block that is already there
+static const int k_shared_device_state_probe_interval_ms = 10;
+
+// Slot version a front-end has never read, never matches a version the writer leaves behind (always even)
+static const unsigned int k_unread_slot_version = ~0u;
+
+static_assert(PSMOVESERVICE_MAX_CONTROLLER_COUNT <= 32, "Controller tracking requests are a 32 bit mask");
+static_assert(PSMOVESERVICE_MAX_HMD_COUNT <= 32, "HMD tracking requests are a 32 bit mask");
+
+//-- definitions -----
+typedef SharedStateSlot<k_shared_data_frame_capacity> t_shared_data_frame_slot;
+typedef SharedStateSlot<k_shared_device_list_capacity> t_shared_device_list_slot;
+
+// What one front-end instance tells the broker
+struct SharedFrontendState
+{
+    std::atomic<unsigned int> owner_token; // 0 while the slot is free
+    std::atomic<unsigned int> heartbeat;
+    std::atomic<unsigned int> controller_tracking_mask;
+    std::atomic<unsigned int> hmd_tracking_mask;
+
+    void init()
+    {
+        owner_token.store(0);
+        heartbeat.store(0);
+        controller_tracking_mask.store(0);
+        hmd_tracking_mask.store(0);
+    }
+};
+
+// Everything in the shared memory block.
+// Only atomics and plain bytes, nothing here can be left locked by a process that dies.
+struct SharedDeviceStateLayout
+{
+    std::atomic<unsigned int> magic; // set last, once the rest is initialized
+    unsigned int layout_version;
+    unsigned int layout_size;
+    int controller_count;
+    int hmd_count;
+
+    std::atomic<unsigned int> broker_heartbeat;
+    std::atomic<unsigned int> next_frontend_token;
+    SharedFrontendState frontends[SHARED_DEVICE_STATE_MAX_FRONTENDS];
+
+    t_shared_data_frame_slot controller_frames[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    t_shared_data_frame_slot hmd_frames[PSMOVESERVICE_MAX_HMD_COUNT];
+    t_shared_device_list_slot device_lists[_eSharedDeviceList_COUNT];
+
+    void init(int in_controller_count, int in_hmd_count)
+    {
+        magic.store(0);
+        layout_version = k_shared_device_state_layout_version;
+        layout_size = sizeof(SharedDeviceStateLayout);
+        controller_count = in_controller_count;
+        hmd_count = in_hmd_count;
+
+        broker_heartbeat.store(0);
+        next_frontend_token.store(0);
+
+        for (int frontend_index = 0; frontend_index < SHARED_DEVICE_STATE_MAX_FRONTENDS; ++frontend_index)
+        {
+            frontends[frontend_index].init();
+        }
+
+        for (int controller_id = 0; controller_id < PSMOVESERVICE_MAX_CONTROLLER_COUNT; ++controller_id)
+        {
+            controller_frames[controller_id].init();
+        }
+
+        for (int hmd_id = 0; hmd_id < PSMOVESERVICE_MAX_HMD_COUNT; ++hmd_id)
+        {
+            hmd_frames[hmd_id].init();
+        }
+
+        for (int list_index = 0; list_index < _eSharedDeviceList_COUNT; ++list_index)
+        {
+            device_lists[list_index].init();
+        }
+
+        magic.store(k_shared_device_state_magic, std::memory_order_release);
+    }
+};
+
+//-- private methods -----
+static bool has_timed_out(
+    const t_shared_device_state_timestamp &now,
+    const t_shared_device_state_timestamp &last_activity,
+    int timeout_ms)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now - last_activity).count() > timeout_ms;
+}
+
+static bool is_layout_compatible(const boost::interprocess::mapped_region &region)
+{
+    const SharedDeviceStateLayout *layout = reinterpret_cast<const SharedDeviceStateLayout *>(region.get_address());
+
+    return
+        region.get_size() >= sizeof(SharedDeviceStateLayout) &&
+        layout->magic.load(std::memory_order_acquire) == k_shared_device_state_magic &&
+        layout->layout_version == k_shared_device_state_layout_version &&
+        layout->layout_size == sizeof(SharedDeviceStateLayout);
+}
+
+//-- SharedDeviceStateWriter -----
+SharedDeviceStateWriter::SharedDeviceStateWriter(const char *shared_memory_name, int heartbeat_timeout_ms)
+    : m_shared_memory_name(shared_memory_name)
+    , m_heartbeat_timeout_ms(heartbeat_timeout_ms)
+    , m_shared_memory_object(nullptr)
+    , m_region(nullptr)
+    , m_serialize_buffer()
+    , m_bHasFrontends(false)
+{
+    for (int frontend_index = 0; frontend_index < SHARED_DEVICE_STATE_MAX_FRONTENDS; ++frontend_index)
+    {
+        m_frontend_tokens[frontend_index] = 0;
+        m_frontend_heartbeats[frontend_index] = 0;
+    }
+}
+
+SharedDeviceStateWriter::~SharedDeviceStateWriter()
+{
+    shutdown();
+}
+
+bool SharedDeviceStateWriter::startup(int controller_count, int hmd_count)
+{
+    bool bSuccess = false;
+
+    if (getIsOtherBrokerRunning())
+    {
+        SERVER_LOG_ERROR("SharedDeviceStateWriter::startup") << "Another broker is already sharing its device state in: "
+            << m_shared_memory_name;
+        return false;
+    }
+
+    try
+    {
+        SERVER_LOG_INFO("SharedDeviceStateWriter::startup") << "Allocating shared memory: " << m_shared_memory_name;
+
+        // Throw away any block left behind by a broker that crashed
+        boost::interprocess::shared_memory_object::remove(m_shared_memory_name.c_str());
+
+        // Only processes running as the broker's user may attach as front-ends
+        boost::interprocess::permissions permissions;
+#ifndef _WIN32
+        permissions.set_permissions(0600);
+#endif
+
+        m_shared_memory_object =
+            new boost::interprocess::shared_memory_object(
+                boost::interprocess::create_only,
+                m_shared_memory_name.c_str(),
+                boost::interprocess::read_write,
+                permissions);
+        m_shared_memory_object->truncate(sizeof(SharedDeviceStateLayout));
+
+        m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
+
+        SharedDeviceStateLayout *layout = new (m_region->get_address()) SharedDeviceStateLayout;
+        layout->init(
+            std::min(controller_count, PSMOVESERVICE_MAX_CONTROLLER_COUNT),
+            std::min(hmd_count, PSMOVESERVICE_MAX_HMD_COUNT));
+
+        bSuccess = true;
+    }
+    catch (const boost::interprocess::interprocess_exception &e)
+    {
+        SERVER_LOG_ERROR("SharedDeviceStateWriter::startup") << "Failed to allocate shared memory: " << m_shared_memory_name
+            << ", reason: " << e.what();
+        shutdown();
+    }
+
+    return bSuccess;
+}
+
+void SharedDeviceStateWriter::shutdown()
+{
+    if (m_region != nullptr)
+    {
+        delete m_region;
+        m_region = nullptr;
+    }
+
+    if (m_shared_memory_object != nullptr)
+    {
+        delete m_shared_memory_object;
+        m_shared_memory_object = nullptr;
+
+        // Attached front-ends keep their mapping, they notice the heartbeat stopped and let go
+        if (!boost::interprocess::shared_memory_object::remove(m_shared_memory_name.c_str()))
+        {
+            SERVER_LOG_ERROR("SharedDeviceStateWriter::shutdown") << "Failed to free shared memory: " << m_shared_memory_name;
+        }
+    }
+
+    m_bHasFrontends = false;
+}
+
+void SharedDeviceStateWriter::writeControllerDataFrame(int controller_id, const PSMoveProtocol::DeviceOutputDataFrame &data_frame)
+{
+    SharedDeviceStateLayout *layout = getLayout();
+
+    if (layout != nullptr && controller_id >= 0 && controller_id < layout->controller_count && serializeMessage(data_frame))
+    {
+        if (!layout->controller_frames[controller_id].write(m_serialize_buffer.data(), static_cast<unsigned int>(m_serialize_buffer.size())))
+        {
+            SERVER_LOG_ERROR("SharedDeviceStateWriter") << "Controller(" << controller_id << ") data frame doesn't fit in shared memory";
+        }
+    }
+}
+
+void SharedDeviceStateWriter::clearControllerDataFrame(int controller_id)
+{
+    SharedDeviceStateLayout *layout = getLayout();
+
+    if (layout != nullptr && controller_id >= 0 && controller_id < layout->controller_count)
+    {
+        layout->controller_frames[controller_id].writeIfChanged(nullptr, 0);
+    }
+}
+
+void SharedDeviceStateWriter::writeHMDDataFrame(int hmd_id, const PSMoveProtocol::DeviceOutputDataFrame &data_frame)
+{
+    SharedDeviceStateLayout *layout = getLayout();
+
+    if (layout != nullptr && hmd_id >= 0 && hmd_id < layout->hmd_count && serializeMessage(data_frame))
+    {
+        if (!layout->hmd_frames[hmd_id].write(m_serialize_buffer.data(), static_cast<unsigned int>(m_serialize_buffer.size())))
+        {
+            SERVER_LOG_ERROR("SharedDeviceStateWriter") << "HMD(" << hmd_id << ") data frame doesn't fit in shared memory";
+        }
+    }
+}
+
+void SharedDeviceStateWriter::clearHMDDataFrame(int hmd_id)
+{
+    SharedDeviceStateLayout *layout = getLayout();
+
+    if (layout != nullptr && hmd_id >= 0 && hmd_id < layout->hmd_count)
+    {
+        layout->hmd_frames[hmd_id].writeIfChanged(nullptr, 0);
+    }
+}
+
+void SharedDeviceStateWriter::writeDeviceList(eSharedDeviceList list, const PSMoveProtocol::Response &response)
+{
+    SharedDeviceStateLayout *layout = getLayout();
+
+    if (layout != nullptr && serializeMessage(response))
+    {
+        t_shared_device_list_slot &slot = layout->device_lists[list];
+        const unsigned int list_size = static_cast<unsigned int>(m_serialize_buffer.size());
+
+        if (list_size > t_shared_device_list_slot::k_capacity)
+        {
+            SERVER_LOG_ERROR("SharedDeviceStateWriter") << "Device list " << list << " doesn't fit in shared memory";
+        }
+        else
+        {
+            slot.writeIfChanged(m_serialize_buffer.data(), list_size);
+        }
+    }
+}
+
+void SharedDeviceStateWriter::update(unsigned int &out_controller_tracking_mask, unsigned int &out_hmd_tracking_mask)
+{
+    SharedDeviceStateLayout *layout = getLayout();
+
+    out_controller_tracking_mask = 0;
+    out_hmd_tracking_mask = 0;
+
+    if (layout == nullptr)
+    {
+        return;
+    }
+
+    const t_shared_device_state_timestamp now = std::chrono::steady_clock::now();
+    bool bHasFrontends = false;
+
+    layout->broker_heartbeat.fetch_add(1, std::memory_order_release);
+
+    for (int frontend_index = 0; frontend_index < SHARED_DEVICE_STATE_MAX_FRONTENDS; ++frontend_index)
+    {
+        SharedFrontendState &frontend = layout->frontends[frontend_index];
+        const unsigned int owner_token = frontend.owner_token.load(std::memory_order_acquire);
+        const unsigned int heartbeat = frontend.heartbeat.load(std::memory_order_acquire);
+
+        if (owner_token == 0)
+        {
+            m_frontend_tokens[frontend_index] = 0;
+            continue;
+        }
+
+        if (owner_token != m_frontend_tokens[frontend_index] || heartbeat != m_frontend_heartbeats[frontend_index])
+        {
+            if (owner_token != m_frontend_tokens[frontend_index])
+            {
+                SERVER_LOG_INFO("SharedDeviceStateWriter") << "Front-end attached in slot " << frontend_index;
+            }
+
+            m_frontend_tokens[frontend_index] = owner_token;
+            m_frontend_heartbeats[frontend_index] = heartbeat;
+            m_frontend_heartbeat_times[frontend_index] = now;
+        }
+        else if (has_timed_out(now, m_frontend_heartbeat_times[frontend_index], m_heartbeat_timeout_ms))
+        {
+            SERVER_LOG_WARNING("SharedDeviceStateWriter") << "Front-end in slot " << frontend_index
+                << " stopped responding, dropping its tracking requests";
+
+            frontend.controller_tracking_mask.store(0);
+            frontend.hmd_tracking_mask.store(0);
+
+            // Leave the slot alone if the front-end came back (and re-claimed it) in the meantime
+            unsigned int expected_token = owner_token;
+            frontend.owner_token.compare_exchange_strong(expected_token, 0);
+
+            m_frontend_tokens[frontend_index] = 0;
+            continue;
+        }
+
+        out_controller_tracking_mask |= frontend.controller_tracking_mask.load(std::memory_order_acquire);
+        out_hmd_tracking_mask |= frontend.hmd_tracking_mask.load(std::memory_order_acquire);
+        bHasFrontends = true;
+    }
+
+    // Data frames stop being published while nobody reads them.
+    // Take the last ones down so the next front-end doesn't start out on an old frame.
+    if (m_bHasFrontends && !bHasFrontends)
+    {
+        for (int controller_id = 0; controller_id < layout->controller_count; ++controller_id)
+        {
+            layout->controller_frames[controller_id].writeIfChanged(nullptr, 0);
+        }
+
+        for (int hmd_id = 0; hmd_id < layout->hmd_count; ++hmd_id)
+        {
+            layout->hmd_frames[hmd_id].writeIfChanged(nullptr, 0);
+        }
+    }
+
+    m_bHasFrontends = bHasFrontends;
+}
+
+bool SharedDeviceStateWriter::getIsOtherBrokerRunning() const
+{
+    bool bIsRunning = false;
+
+    try
+    {
+        boost::interprocess::shared_memory_object shared_memory_object(
+            boost::interprocess::open_only,
+            m_shared_memory_name.c_str(),
+            boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(shared_memory_object, boost::interprocess::read_only);
+
+        // A block we can't make sense of can't have a heartbeat we could watch either
+        if (is_layout_compatible(region))
+        {
+            const SharedDeviceStateLayout *layout = reinterpret_cast<const SharedDeviceStateLayout *>(region.get_address());
+            const unsigned int broker_heartbeat = layout->broker_heartbeat.load(std::memory_order_acquire);
+            const t_shared_device_state_timestamp start_time = std::chrono::steady_clock::now();
+
+            // Give the owner as long to show signs of life as a front-end would
+            while (!bIsRunning && !has_timed_out(std::chrono::steady_clock::now(), start_time, m_heartbeat_timeout_ms))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(k_shared_device_state_probe_interval_ms));
+                bIsRunning = layout->broker_heartbeat.load(std::memory_order_acquire) != broker_heartbeat;
+            }
+
+            if (!bIsRunning)
+            {
+                SERVER_LOG_WARNING("SharedDeviceStateWriter::startup") << "Replacing shared memory left behind by a broker that stopped: "
+                    << m_shared_memory_name;
+            }
+        }
+    }
+    catch (const boost::interprocess::interprocess_exception &)
+    {
+        // No block there, nobody else is sharing
+    }
+
+    return bIsRunning;
+}
+
+bool SharedDeviceStateWriter::serializeMessage(const google::protobuf::Message &message)
+{
+    const int message_size = message.ByteSize();
+
+    m_serialize_buffer.resize(message_size);
+
+    return message_size == 0 || message.SerializeWithCachedSizesToArray(m_serialize_buffer.data()) != nullptr;
+}
+
+SharedDeviceStateLayout *SharedDeviceStateWriter::getLayout()
+{
+    return (m_region != nullptr) ? reinterpret_cast<SharedDeviceStateLayout *>(m_region->get_address()) : nullptr;
+}
+
+//-- SharedDeviceStateReader -----
+SharedDeviceStateReader::SharedDeviceStateReader(const char *shared_memory_name, int heartbeat_timeout_ms)
+    : m_shared_memory_name(shared_memory_name)
+    , m_heartbeat_timeout_ms(heartbeat_timeout_ms)
+    , m_shared_memory_object(nullptr)
+    , m_region(nullptr)
+    , m_read_buffer(std::max(k_shared_data_frame_capacity, k_shared_device_list_capacity))
+    , m_frontend_slot_index(-1)
+    , m_frontend_token(0)
+    , m_broker_heartbeat(0)
+    , m_broker_heartbeat_time()
+    , m_next_attach_time()
+{
+    // Nothing attached yet, so there is nothing that could read as gone either
+    std::fill(m_controller_frame_versions, m_controller_frame_versions + PSMOVESERVICE_MAX_CONTROLLER_COUNT, 0);
+    std::fill(m_hmd_frame_versions, m_hmd_frame_versions + PSMOVESERVICE_MAX_HMD_COUNT, 0);
+    std::fill(m_device_list_versions, m_device_list_versions + _eSharedDeviceList_COUNT, 0);
+}
+
+SharedDeviceStateReader::~SharedDeviceStateReader()
+{
+    shutdown();
+}
+
+void SharedDeviceStateReader::shutdown()
+{
+    SharedDeviceStateLayout *layout = getLayout();
+
+    // Hand our slot back right away rather than waiting for the broker to time us out
+    if (layout != nullptr && m_frontend_slot_index != -1)
+    {
+        SharedFrontendState &frontend = layout->frontends[m_frontend_slot_index];
+        unsigned int expected_token = m_frontend_token;
+
+        frontend.controller_tracking_mask.store(0);
+        frontend.hmd_tracking_mask.store(0);
+        frontend.owner_token.compare_exchange_strong(expected_token, 0);
+    }
+
+    detach();
+}
+
+int SharedDeviceStateReader::getControllerCount() const
+{
+    const SharedDeviceStateLayout *layout = getLayout();
+
+    return (layout != nullptr) ? layout->controller_count : 0;
+}
+
+int SharedDeviceStateReader::getHMDCount() const
+{
+    const SharedDeviceStateLayout *layout = getLayout();
+
+    return (layout != nullptr) ? layout->hmd_count : 0;
+}
+
+void SharedDeviceStateReader::update(unsigned int controller_tracking_mask, unsigned int hmd_tracking_mask)
+{
+    const t_shared_device_state_timestamp now = std::chrono::steady_clock::now();
+
+    if (!getIsAttached())
+    {
+        if (now < m_next_attach_time)
+        {
+            return;
+        }
+
+        // Look for a broker twice per timeout
+        m_next_attach_time = now + std::chrono::milliseconds(m_heartbeat_timeout_ms / 2);
+
+        if (!attach())
+        {
+            return;
+        }
+    }
+
+    SharedDeviceStateLayout *layout = getLayout();
+
+    // A broker that shut down or crashed leaves our mapping of its block frozen
+    const unsigned int broker_heartbeat = layout->broker_heartbeat.load(std::memory_order_acquire);
+    if (broker_heartbeat != m_broker_heartbeat)
+    {
+        m_broker_heartbeat = broker_heartbeat;
+        m_broker_heartbeat_time = now;
+    }
+    else if (has_timed_out(now, m_broker_heartbeat_time, m_heartbeat_timeout_ms))
+    {
+        SERVER_LOG_WARNING("SharedDeviceStateReader") << "Broker stopped updating the shared device state, detaching";
+        detach();
+        return;
+    }
+
+    // The broker drops front-ends that stall for too long, even ones that are still alive
+    if (layout->frontends[m_frontend_slot_index].owner_token.load(std::memory_order_acquire) != m_frontend_token)
+    {
+        SERVER_LOG_WARNING("SharedDeviceStateReader") << "Broker dropped this front-end, claiming a new slot";
+
+        if (!claimFrontendSlot())
+        {
+            detach();
+            return;
+        }
+    }
+
+    SharedFrontendState &frontend = layout->frontends[m_frontend_slot_index];
+    frontend.controller_tracking_mask.store(controller_tracking_mask, std::memory_order_release);
+    frontend.hmd_tracking_mask.store(hmd_tracking_mask, std::memory_order_release);
+    frontend.heartbeat.fetch_add(1, std::memory_order_release);
+}
+
+bool SharedDeviceStateReader::readControllerDataFrame(int controller_id, PSMoveProtocol::DeviceOutputDataFrame &out_data_frame)
+{
+    if (controller_id < 0 || controller_id >= PSMOVESERVICE_MAX_CONTROLLER_COUNT)
+    {
+        return false;
+    }
+
+    unsigned int &version = m_controller_frame_versions[controller_id];
+
+    if (!getIsAttached() || controller_id >= getControllerCount())
+    {
+        const bool bWasAvailable = version != 0;
+
+        version = 0;
+        out_data_frame.Clear();
+
+        return bWasAvailable;
+    }
+
+    return readMessage(getLayout()->controller_frames[controller_id], version, out_data_frame);
+}
+
+bool SharedDeviceStateReader::readHMDDataFrame(int hmd_id, PSMoveProtocol::DeviceOutputDataFrame &out_data_frame)
+{
+    if (hmd_id < 0 || hmd_id >= PSMOVESERVICE_MAX_HMD_COUNT)
+    {
+        return false;
+    }
+
+    unsigned int &version = m_hmd_frame_versions[hmd_id];
+
+    if (!getIsAttached() || hmd_id >= getHMDCount())
+    {
+        const bool bWasAvailable = version != 0;
+
+        version = 0;
+        out_data_frame.Clear();
+
+        return bWasAvailable;
+    }
+
+    return readMessage(getLayout()->hmd_frames[hmd_id], version, out_data_frame);
+}
+
+bool SharedDeviceStateReader::readDeviceList(eSharedDeviceList list, PSMoveProtocol::Response &out_response)
+{
+    unsigned int &version = m_device_list_versions[list];
+
+    if (!getIsAttached())
+    {
+        const bool bWasAvailable = version != 0;
+
+        version = 0;
+        out_response.Clear();
+
+        return bWasAvailable;
+    }
+
+    return readMessage(getLayout()->device_lists[list], version, out_response);
+}
+
+bool SharedDeviceStateReader::attach()
+{
+    bool bSuccess = false;
+
+    try
+    {
+        m_shared_memory_object =
+            new boost::interprocess::shared_memory_object(
+                boost::interprocess::open_only,
+                m_shared_memory_name.c_str(),
+                boost::interprocess::read_write);
+
+        m_region = new boost::interprocess::mapped_region(*m_shared_memory_object, boost::interprocess::read_write);
+
+        const SharedDeviceStateLayout *layout = getLayout();
+
+        if (m_region->get_size() < sizeof(SharedDeviceStateLayout) ||
+            layout->magic.load(std::memory_order_acquire) != k_shared_device_state_magic)
+        {
+            // Could also be a broker that is still setting the block up, try again later
+            SERVER_LOG_WARNING("SharedDeviceStateReader") << "Shared device state isn't ready or is from another build of the service";
+        }
+        else if (layout->layout_version != k_shared_device_state_layout_version ||
+                 layout->layout_size != sizeof(SharedDeviceStateLayout))
+        {
+            SERVER_LOG_ERROR("SharedDeviceStateReader") << "Shared device state layout v" << layout->layout_version
+                << " doesn't match this front-end (v" << k_shared_device_state_layout_version << ")";
+        }
+        else if (!claimFrontendSlot())
+        {
+            SERVER_LOG_ERROR("SharedDeviceStateReader") << "No free front-end slot, the broker already serves "
+                << SHARED_DEVICE_STATE_MAX_FRONTENDS << " front-ends";
+        }
+        else
+        {
+            SERVER_LOG_INFO("SharedDeviceStateReader") << "Attached to the broker's shared device state ("
+                << layout->controller_count << " controllers, " << layout->hmd_count << " HMDs)";
+
+            m_broker_heartbeat = layout->broker_heartbeat.load(std::memory_order_acquire);
+            m_broker_heartbeat_time = std::chrono::steady_clock::now();
+
+            // Read everything fresh, whatever we had came from an earlier broker
+            std::fill(m_controller_frame_versions, m_controller_frame_versions + PSMOVESERVICE_MAX_CONTROLLER_COUNT, k_unread_slot_version);
+            std::fill(m_hmd_frame_versions, m_hmd_frame_versions + PSMOVESERVICE_MAX_HMD_COUNT, k_unread_slot_version);
+            std::fill(m_device_list_versions, m_device_list_versions + _eSharedDeviceList_COUNT, k_unread_slot_version);
+
+            bSuccess = true;
+        }
+    }
+    catch (const boost::interprocess::interprocess_exception &)
+    {
+        // No broker running (yet), not worth a log line every retry
+    }
+
+    if (!bSuccess)
+    {
+        detach();
+    }
+
+    return bSuccess;
+}
+
+void SharedDeviceStateReader::detach()
+{
+    if (m_region != nullptr)
+    {
+        delete m_region;
+        m_region = nullptr;
+    }
+
+    if (m_shared_memory_object != nullptr)
+    {
+        delete m_shared_memory_object;
+        m_shared_memory_object = nullptr;
+    }
+
+    m_frontend_slot_index = -1;
+    m_frontend_token = 0;
+}
+
+bool SharedDeviceStateReader::claimFrontendSlot()
+{
+    SharedDeviceStateLayout *layout = getLayout();
+
+    // Tokens tell apart the front-ends that used the same slot over time
+    unsigned int token = 0;
+    while (token == 0)
+    {
+        token = layout->next_frontend_token.fetch_add(1) + 1;
+    }
+
+    for (int frontend_index = 0; frontend_index < SHARED_DEVICE_STATE_MAX_FRONTENDS; ++frontend_index)
+    {
+        SharedFrontendState &frontend = layout->frontends[frontend_index];
+        unsigned int expected_token = 0;
+
+        if (frontend.owner_token.compare_exchange_strong(expected_token, token))
+        {
+            frontend.controller_tracking_mask.store(0);
+            frontend.hmd_tracking_mask.store(0);
+
+            m_frontend_slot_index = frontend_index;
+            m_frontend_token = token;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template <typename t_slot>
+bool SharedDeviceStateReader::readMessage(const t_slot &slot, unsigned int &inout_version, google::protobuf::Message &out_message)
+{
+    unsigned int message_size = 0;
+
+    if (!slot.read(inout_version, m_read_buffer.data(), message_size))
+    {
+        return false;
+    }
+
+    out_message.Clear();
+
+    if (message_size > 0 && !out_message.ParseFromArray(m_read_buffer.data(), static_cast<int>(message_size)))
+    {
+        SERVER_LOG_ERROR("SharedDeviceStateReader") << "Failed to parse shared device state";
+        out_message.Clear();
+    }
+
+    return true;
+}
+
+SharedDeviceStateLayout *SharedDeviceStateReader::getLayout() const
+{
+    return (m_region != nullptr) ? reinterpret_cast<SharedDeviceStateLayout *>(m_region->get_address()) : nullptr;
+}
@@ -0,0 +1,159 @@
+#ifndef SHARED_DEVICE_STATE_H
+#define SHARED_DEVICE_STATE_H
+
+//-- includes -----
+#include "PSMoveProtocolInterface.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+//-- constants -----
+// Name of the shared memory block a broker instance publishes its device state in
+#define SHARED_DEVICE_STATE_NAME "PSMoveService_SharedDeviceState"
+
+// Most front-end instances that can be attached to one broker at a time
+#define SHARED_DEVICE_STATE_MAX_FRONTENDS 8
+
+// A broker or front-end that hasn't moved its heartbeat for this long is taken for dead
+#define SHARED_DEVICE_STATE_TIMEOUT_MS 2000
+
+// Device lists the broker keeps current for the front-ends, as the response to the matching request
+enum eSharedDeviceList
+{
+    _eSharedDeviceList_Controllers,   // GET_CONTROLLER_LIST (USB controllers included)
+    _eSharedDeviceList_Trackers,      // GET_TRACKER_LIST
+    _eSharedDeviceList_HMDs,          // GET_HMD_LIST
+    _eSharedDeviceList_TrackingSpace, // GET_TRACKING_SPACE_SETTINGS
+
+    _eSharedDeviceList_COUNT
+};
+
+//-- pre-declarations -----
+struct SharedDeviceStateLayout;
+
+namespace boost
+{
+    namespace interprocess
+    {
+        class shared_memory_object;
+        class mapped_region;
+    };
+};
+
+namespace google
+{
+    namespace protobuf
+    {
+        class Message;
+    };
+};
+
+//-- definitions -----
+typedef std::chrono::steady_clock::time_point t_shared_device_state_timestamp;
+
+/// Publishes the device state of the instance that owns the hardware (the broker)
+/// to the front-end instances serving their own clients on other ports.
+/// Every front-end keeps a heartbeat and the set of devices its clients want tracked in the block.
+/// A front-end whose heartbeat stops is dropped, so a crashed one doesn't keep devices tracking forever.
+class SharedDeviceStateWriter
+{
+public:
+    SharedDeviceStateWriter(
+        const char *shared_memory_name = SHARED_DEVICE_STATE_NAME,
+        int heartbeat_timeout_ms = SHARED_DEVICE_STATE_TIMEOUT_MS);
+    ~SharedDeviceStateWriter();
+
+    // Fails if another broker is still updating the block,
+    // a block left behind by a broker that crashed is replaced
+    bool startup(int controller_count, int hmd_count);
+    void shutdown();
+
+    // True once update() has seen a live front-end, nothing reads the data frames otherwise
+    inline bool getHasFrontends() const { return m_bHasFrontends; }
+
+    // Frames are written with every optional section included,
+    // each front-end trims them down to what its connections asked for
+    void writeControllerDataFrame(int controller_id, const PSMoveProtocol::DeviceOutputDataFrame &data_frame);
+    void clearControllerDataFrame(int controller_id);
+    void writeHMDDataFrame(int hmd_id, const PSMoveProtocol::DeviceOutputDataFrame &data_frame);
+    void clearHMDDataFrame(int hmd_id);
+
+    // Front-ends only see a change when the list really changed
+    void writeDeviceList(eSharedDeviceList list, const PSMoveProtocol::Response &response);
+
+    // Bumps the heartbeat the front-ends watch, drops any front-end that stopped updating its own,
+    // and returns the union of the devices the remaining front-ends want tracked
+    void update(unsigned int &out_controller_tracking_mask, unsigned int &out_hmd_tracking_mask);
+
+private:
+    bool getIsOtherBrokerRunning() const;
+    bool serializeMessage(const google::protobuf::Message &message);
+    SharedDeviceStateLayout *getLayout();
+
+    std::string m_shared_memory_name;
+    int m_heartbeat_timeout_ms;
+    boost::interprocess::shared_memory_object *m_shared_memory_object;
+    boost::interprocess::mapped_region *m_region;
+    std::vector<unsigned char> m_serialize_buffer;
+    bool m_bHasFrontends;
+
+    // Last token and heartbeat seen in each front-end slot, and when either last moved
+    unsigned int m_frontend_tokens[SHARED_DEVICE_STATE_MAX_FRONTENDS];
+    unsigned int m_frontend_heartbeats[SHARED_DEVICE_STATE_MAX_FRONTENDS];
+    t_shared_device_state_timestamp m_frontend_heartbeat_times[SHARED_DEVICE_STATE_MAX_FRONTENDS];
+};
+
+/// Reads the device state a broker publishes, from a front-end instance.
+/// The front-end attaches whenever a broker is around and detaches when the broker's heartbeat stops,
+/// at which point every device and list reads as gone once until a broker shows up again.
+class SharedDeviceStateReader
+{
+public:
+    SharedDeviceStateReader(
+        const char *shared_memory_name = SHARED_DEVICE_STATE_NAME,
+        int heartbeat_timeout_ms = SHARED_DEVICE_STATE_TIMEOUT_MS);
+    ~SharedDeviceStateReader();
+
+    void shutdown();
+
+    inline bool getIsAttached() const { return m_region != nullptr; }
+    int getControllerCount() const;
+    int getHMDCount() const;
+
+    // Refreshes our heartbeat and the devices we want tracked,
+    // and attaches to (or lets go of) the broker as it comes and goes
+    void update(unsigned int controller_tracking_mask, unsigned int hmd_tracking_mask);
+
+    // These return true if the state changed since the last read and fill out the message.
+    // A device or list that went away reads as an empty message.
+    bool readControllerDataFrame(int controller_id, PSMoveProtocol::DeviceOutputDataFrame &out_data_frame);
+    bool readHMDDataFrame(int hmd_id, PSMoveProtocol::DeviceOutputDataFrame &out_data_frame);
+    bool readDeviceList(eSharedDeviceList list, PSMoveProtocol::Response &out_response);
+
+private:
+    bool attach();
+    void detach();
+    bool claimFrontendSlot();
+    template <typename t_slot>
+    bool readMessage(const t_slot &slot, unsigned int &inout_version, google::protobuf::Message &out_message);
+    SharedDeviceStateLayout *getLayout() const;
+
+    std::string m_shared_memory_name;
+    int m_heartbeat_timeout_ms;
+    boost::interprocess::shared_memory_object *m_shared_memory_object;
+    boost::interprocess::mapped_region *m_region;
+    std::vector<unsigned char> m_read_buffer;
+
+    int m_frontend_slot_index;
+    unsigned int m_frontend_token;
+    unsigned int m_broker_heartbeat;
+    t_shared_device_state_timestamp m_broker_heartbeat_time;
+    t_shared_device_state_timestamp m_next_attach_time;
+
+    // Version of each slot we last read
+    unsigned int m_controller_frame_versions[PSMOVESERVICE_MAX_CONTROLLER_COUNT];
+    unsigned int m_hmd_frame_versions[PSMOVESERVICE_MAX_HMD_COUNT];
+    unsigned int m_device_list_versions[_eSharedDeviceList_COUNT];
+};
+
+#endif // SHARED_DEVICE_STATE_H
@@ -0,0 +1,159 @@
+#ifndef DATA_STREAM_FILTER_H
+#define DATA_STREAM_FILTER_H
+
+#include <chrono>
+#include <math.h>
+#include <stdint.h>
+
+//-- constants -----
+// Even a pose sitting in the deadband gets a frame this often, for the analog values that aren't part of the pose
+static const float k_data_stream_keepalive_seconds = 1.f;
+static const float k_data_stream_radians_to_degrees = 57.2957795f;
+
+// What a client asked for when starting a controller or HMD data stream.
+// All zero means every published update goes out.
+struct DataStreamLimits
+{
+    float max_rate_hz;                  // 0 = no limit
+    float position_deadband_cm;         // 0 = no position deadband
+    float orientation_deadband_degrees; // 0 = no orientation deadband
+
+    inline void clear()
+    {
+        max_rate_hz = 0.f;
+        position_deadband_cm = 0.f;
+        orientation_deadband_degrees = 0.f;
+    }
+
+    inline bool isUnlimited() const
+    {
+        return max_rate_hz <= 0.f && position_deadband_cm <= 0.f && orientation_deadband_degrees <= 0.f;
+    }
+};
+
+// Decides per connection which of a device's published updates are worth a data frame.
+// Changes of the discrete state (buttons, tracking and connection flags, coarse trigger and stick values)
+// always go out right away so a rate limited stream never loses a button press or a trigger pull.
+// Otherwise a frame goes out when the rate limit allows it and the pose has left the deadband
+// of the last frame sent, or after k_data_stream_keepalive_seconds at most.
+class DataStreamFilter
+{
+public:
+    typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_timestamp;
+
+    DataStreamFilter()
+    {
+        limits.clear();
+        reset();
+    }
+
+    inline const DataStreamLimits &getLimits() const
+    {
+        return limits;
+    }
+
+    void setLimits(const DataStreamLimits &new_limits)
+    {
+        limits = new_limits;
+        reset();
+    }
+
+    // Start over as if nothing was sent yet, the next update always goes out
+    inline void reset()
+    {
+        bHasSent = false;
+    }
+
+    // position_cm is {x, y, z}, orientation is {w, x, y, z}.
+    // Returns true if a frame should be sent for this update, and remembers it as sent.
+    bool filterUpdate(
+        const t_timestamp &now,
+        const float position_cm[3],
+        const float orientation[4],
+        const uint64_t discrete_state)
+    {
+        if (limits.isUnlimited())
+        {
+            return true;
+        }
+
+        bool bSend = !bHasSent || discrete_state != lastDiscreteState;
+
+        if (!bSend)
+        {
+            const float seconds_since_sent =
+                std::chrono::duration<float>(now - lastSentTimestamp).count();
+            const bool bRateAllows =
+                limits.max_rate_hz <= 0.f || seconds_since_sent * limits.max_rate_hz >= 1.f;
+
+            bSend = bRateAllows && (hasLeftDeadband(position_cm, orientation) || seconds_since_sent >= k_data_stream_keepalive_seconds);
+        }
+
+        if (bSend)
+        {
+            lastSentTimestamp = now;
+            lastDiscreteState = discrete_state;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                lastPositionCm[axis] = position_cm[axis];
+            }
+            for (int component = 0; component < 4; ++component)
+            {
+                lastOrientation[component] = orientation[component];
+            }
+            bHasSent = true;
+        }
+
+        return bSend;
+    }
+
+private:
+    bool hasLeftDeadband(const float position_cm[3], const float orientation[4]) const
+    {
+        const bool bHasPositionDeadband = limits.position_deadband_cm > 0.f;
+        const bool bHasOrientationDeadband = limits.orientation_deadband_degrees > 0.f;
+
+        if (!bHasPositionDeadband && !bHasOrientationDeadband)
+        {
+            return true;
+        }
+
+        bool bLeft = false;
+
+        if (bHasPositionDeadband)
+        {
+            float distance_sqr = 0.f;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float delta = position_cm[axis] - lastPositionCm[axis];
+                distance_sqr += delta * delta;
+            }
+
+            bLeft = distance_sqr >= limits.position_deadband_cm * limits.position_deadband_cm;
+        }
+
+        if (!bLeft && bHasOrientationDeadband)
+        {
+            // q and -q are the same rotation
+            float dot = 0.f;
+            for (int component = 0; component < 4; ++component)
+            {
+                dot += orientation[component] * lastOrientation[component];
+            }
+            dot = fminf(fabsf(dot), 1.f);
+
+            bLeft = 2.f * acosf(dot) * k_data_stream_radians_to_degrees >= limits.orientation_deadband_degrees;
+        }
+
+        return bLeft;
+    }
+
+    DataStreamLimits limits;
+    bool bHasSent;
+    t_timestamp lastSentTimestamp;
+    uint64_t lastDiscreteState;
+    float lastPositionCm[3];
+    float lastOrientation[4];
+};
+
+#endif // DATA_STREAM_FILTER_H
@@ -0,0 +1,82 @@
+#ifndef SCRATCH_VECTOR_LIST_H
+#define SCRATCH_VECTOR_LIST_H
+
+#include <vector>
+#include <assert.h>
+#include <stddef.h>
+
+// A list of vectors that is cleared every frame but never gives back memory.
+// Unlike a std::vector<std::vector<T>>, shrinking the list does not destroy the
+// inner vectors, so once every slot has grown to its working size
+// clear() + push_back() cycles stop touching the heap.
+template<typename t_element_type>
+class ScratchVectorList
+{
+public:
+    typedef std::vector<t_element_type> t_vector;
+
+    ScratchVectorList()
+        : m_vectors()
+        , m_count(0)
+    {}
+
+    // Pre-size the list so that the first frames don't allocate either
+    void reserve(size_t vector_count, size_t element_count)
+    {
+        if (m_vectors.size() < vector_count)
+        {
+            m_vectors.resize(vector_count);
+        }
+
+        for (auto it = m_vectors.begin(); it != m_vectors.end(); ++it)
+        {
+            it->reserve(element_count);
+        }
+    }
+
+    // Forget the contents of the list, keeping all slot buffers
+    inline void clear()
+    {
+        m_count = 0;
+    }
+
+    // Returns the next unused slot, emptied but with its old capacity intact
+    t_vector &push_back()
+    {
+        if (m_count >= m_vectors.size())
+        {
+            m_vectors.resize(m_count + 1);
+        }
+
+        t_vector &slot = m_vectors[m_count];
+        slot.clear();
+        ++m_count;
+
+        return slot;
+    }
+
+    // Drops the most recently added slot (e.g. when it failed validation)
+    inline void pop_back()
+    {
+        assert(m_count > 0);
+        --m_count;
+    }
+
+    inline size_t size() const { return m_count; }
+    inline bool empty() const { return m_count == 0; }
+    inline size_t capacity() const { return m_vectors.size(); }
+
+    inline t_vector &operator[](size_t index) { assert(index < m_count); return m_vectors[index]; }
+    inline const t_vector &operator[](size_t index) const { assert(index < m_count); return m_vectors[index]; }
+
+    inline t_vector *begin() { return m_vectors.data(); }
+    inline t_vector *end() { return m_vectors.data() + m_count; }
+    inline const t_vector *begin() const { return m_vectors.data(); }
+    inline const t_vector *end() const { return m_vectors.data() + m_count; }
+
+private:
+    std::vector<t_vector> m_vectors;
+    size_t m_count;
+};
+
+#endif // SCRATCH_VECTOR_LIST_H
@@ -0,0 +1,121 @@
+#ifndef SHARED_STATE_SLOT_H
+#define SHARED_STATE_SLOT_H
+
+#include <atomic>
+#include <string.h>
+
+// A fixed size block of bytes that one process writes and any number of processes read,
+// meant to be placed in shared memory.
+// The writer makes the version odd before touching the bytes and even again once it's done.
+// A reader copies the bytes out and throws the copy away if the version moved in the meantime.
+// Nobody ever waits on a lock, so a reader that dies halfway through a read can't stall the writer
+// (which an interprocess_mutex left locked by a crashed process would).
+template <unsigned int t_capacity>
+struct SharedStateSlot
+{
+    static const unsigned int k_capacity = t_capacity;
+
+    // Readers that keep catching the writer mid update give up after this many tries
+    // and pick the state up on their next poll instead
+    static const int k_max_read_attempts = 8;
+
+    std::atomic<unsigned int> version;
+    std::atomic<unsigned int> size;
+    unsigned char bytes[t_capacity];
+
+    void init()
+    {
+        version.store(0, std::memory_order_relaxed);
+        size.store(0, std::memory_order_relaxed);
+    }
+
+    inline unsigned int getVersion() const
+    {
+        return version.load(std::memory_order_acquire);
+    }
+
+    // Writer side. Returns false if the state doesn't fit in the slot.
+    bool write(const void *data, unsigned int data_size)
+    {
+        if (data_size > t_capacity)
+        {
+            return false;
+        }
+
+        const unsigned int start_version = version.load(std::memory_order_relaxed);
+
+        version.store(start_version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        size.store(data_size, std::memory_order_relaxed);
+        if (data_size > 0)
+        {
+            memcpy(bytes, data, data_size);
+        }
+
+        version.store(start_version + 2, std::memory_order_release);
+
+        return true;
+    }
+
+    // Writer side. Leaves the version alone when the slot already holds the same bytes,
+    // so readers only see a change when there is one.
+    // Returns true if the slot was written.
+    bool writeIfChanged(const void *data, unsigned int data_size)
+    {
+        // Only the writer changes the bytes, so it can compare against them without the version dance
+        if (size.load(std::memory_order_relaxed) == data_size &&
+            (data_size == 0 || memcmp(bytes, data, data_size) == 0))
+        {
+            return false;
+        }
+
+        return write(data, data_size);
+    }
+
+    // Reader side. Copies the state into out_data (which must hold k_capacity bytes)
+    // if it changed since inout_version, and updates inout_version to match.
+    // Returns false if nothing changed or the writer kept getting in the way.
+    bool read(unsigned int &inout_version, void *out_data, unsigned int &out_size) const
+    {
+        for (int attempt = 0; attempt < k_max_read_attempts; ++attempt)
+        {
+            const unsigned int start_version = version.load(std::memory_order_acquire);
+
+            if (start_version == inout_version)
+            {
+                return false;
+            }
+
+            if ((start_version & 1) != 0)
+            {
+                // Writer is in the middle of an update
+                continue;
+            }
+
+            const unsigned int data_size = size.load(std::memory_order_relaxed);
+            if (data_size > t_capacity)
+            {
+                continue;
+            }
+
+            if (data_size > 0)
+            {
+                memcpy(out_data, bytes, data_size);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) == start_version)
+            {
+                inout_version = start_version;
+                out_size = data_size;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+#endif // SHARED_STATE_SLOT_H
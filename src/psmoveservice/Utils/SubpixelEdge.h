@@ -0,0 +1,59 @@
+#ifndef SUBPIXEL_EDGE_H
+#define SUBPIXEL_EDGE_H
+
+#include <math.h>
+
+// Locates the steepest bright-to-dark transition in a run of evenly spaced intensity samples.
+// The gradient is a central difference at each sample. The strongest one is refined with a parabola
+// through it and the central differences two samples to either side, so all three use the same stencil.
+// Returns false if the peak is weaker than min_gradient (per unit length)
+// or too close to either end of the run to fit the parabola.
+// On success out_edge_index is the subpixel location of the edge in samples
+// and out_gradient the peak gradient per unit length.
+inline bool find_subpixel_falling_edge(
+    const float *intensity,
+    const int sample_count,
+    const float sample_step,
+    const float min_gradient,
+    float &out_edge_index,
+    float &out_gradient)
+{
+    const float gradient_scale = 1.f / (2.f * sample_step);
+
+    int best_index = -1;
+    float best_gradient = 0.f;
+    for (int sample_index = 1; sample_index < sample_count - 1; ++sample_index)
+    {
+        const float gradient = (intensity[sample_index - 1] - intensity[sample_index + 1]) * gradient_scale;
+
+        if (gradient > best_gradient)
+        {
+            best_gradient = gradient;
+            best_index = sample_index;
+        }
+    }
+
+    if (best_index < 2 || best_index > sample_count - 3 || best_gradient < min_gradient)
+    {
+        return false;
+    }
+
+    // Parabolic peak interpolation of the gradient
+    const float g_prev = (intensity[best_index - 2] - intensity[best_index]) * gradient_scale;
+    const float g_next = (intensity[best_index] - intensity[best_index + 2]) * gradient_scale;
+    const float denom = g_prev - 2.f * best_gradient + g_next;
+    float offset = 0.f;
+
+    if (fabsf(denom) > 1e-6f)
+    {
+        offset = 0.5f * (g_prev - g_next) / denom;
+        offset = (offset < -0.5f) ? -0.5f : ((offset > 0.5f) ? 0.5f : offset);
+    }
+
+    out_edge_index = static_cast<float>(best_index) + offset;
+    out_gradient = best_gradient;
+
+    return true;
+}
+
+#endif // SUBPIXEL_EDGE_H
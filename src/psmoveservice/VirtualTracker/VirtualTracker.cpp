@@ -0,0 +1,693 @@
+// -- includes -----
+#include "VirtualTracker.h"
+#include "VirtualTrackerScene.h"
+#include "ServerLog.h"
+#include "ServerUtility.h"
+#include "PSMoveProtocol.pb.h"
+#include "TrackerDeviceEnumerator.h"
+
+// -- constants -----
+#define VIRTUAL_TRACKER_STATE_BUFFER_MAX 16
+
+// -- public methods
+// -- Virtual Tracker Config
+const int VirtualTrackerConfig::CONFIG_VERSION = 1;
+
+VirtualTrackerConfig::VirtualTrackerConfig(const std::string &fnamebase)
+    : PSMoveConfig(fnamebase)
+    , is_valid(false)
+    , max_poll_failure_count(100)
+    , frame_width(640)
+    , frame_height(480)
+    , frame_rate(60)
+    , exposure(32)
+    , gain(32)
+    , focalLengthX(554.2563) // pixels, 60 degree hfov at 640 wide
+    , focalLengthY(554.2563) // pixels
+    , principalX(320.0) // pixels
+    , principalY(240.0) // pixels
+    , hfov(60.0) // degrees
+    , vfov(45.0) // degrees
+    , zNear(10.0) // cm
+    , zFar(200.0) // cm
+    , distortionK1(0.0) // an ideal lens by default
+    , distortionK2(0.0)
+    , distortionK3(0.0)
+    , distortionP1(0.0)
+    , distortionP2(0.0)
+    , pixel_noise_stddev(2.0)
+    , distractor_count(4)
+    , distractor_radius_px(3.0)
+{
+    pose.clear();
+
+    SharedColorPresets.table_name.clear();
+    for (int preset_index = 0; preset_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++preset_index)
+    {
+        SharedColorPresets.color_presets[preset_index] = k_default_color_presets[preset_index];
+    }
+};
+
+const boost::property_tree::ptree
+VirtualTrackerConfig::config2ptree()
+{
+    boost::property_tree::ptree pt;
+
+    pt.put("is_valid", is_valid);
+    pt.put("version", VirtualTrackerConfig::CONFIG_VERSION);
+    pt.put("max_poll_failure_count", max_poll_failure_count);
+    pt.put("frame_width", frame_width);
+    pt.put("frame_height", frame_height);
+    pt.put("frame_rate", frame_rate);
+    pt.put("exposure", exposure);
+    pt.put("gain", gain);
+    pt.put("focalLengthX", focalLengthX);
+    pt.put("focalLengthY", focalLengthY);
+    pt.put("principalX", principalX);
+    pt.put("principalY", principalY);
+    pt.put("hfov", hfov);
+    pt.put("vfov", vfov);
+    pt.put("zNear", zNear);
+    pt.put("zFar", zFar);
+    pt.put("distortionK1", distortionK1);
+    pt.put("distortionK2", distortionK2);
+    pt.put("distortionK3", distortionK3);
+    pt.put("distortionP1", distortionP1);
+    pt.put("distortionP2", distortionP2);
+    pt.put("pixel_noise_stddev", pixel_noise_stddev);
+    pt.put("distractor_count", distractor_count);
+    pt.put("distractor_radius_px", distractor_radius_px);
+
+    pt.put("pose.orientation.w", pose.Orientation.w);
+    pt.put("pose.orientation.x", pose.Orientation.x);
+    pt.put("pose.orientation.y", pose.Orientation.y);
+    pt.put("pose.orientation.z", pose.Orientation.z);
+    pt.put("pose.position.x", pose.PositionCm.x);
+    pt.put("pose.position.y", pose.PositionCm.y);
+    pt.put("pose.position.z", pose.PositionCm.z);
+
+    writeColorPropertyPresetTable(&SharedColorPresets, pt);
+
+    for (auto &controller_preset_table : DeviceColorPresets)
+    {
+        writeColorPropertyPresetTable(&controller_preset_table, pt);
+    }
+
+    return pt;
+}
+
+void
+VirtualTrackerConfig::ptree2config(const boost::property_tree::ptree &pt)
+{
+    int config_version = pt.get<int>("version", 0);
+    if (config_version == VirtualTrackerConfig::CONFIG_VERSION)
+    {
+        is_valid = pt.get<bool>("is_valid", false);
+        max_poll_failure_count = pt.get<long>("max_poll_failure_count", 100);
+        frame_width = pt.get<double>("frame_width", frame_width);
+        frame_height = pt.get<double>("frame_height", frame_height);
+        frame_rate = pt.get<double>("frame_rate", frame_rate);
+        exposure = pt.get<double>("exposure", exposure);
+        gain = pt.get<double>("gain", gain);
+        focalLengthX = pt.get<double>("focalLengthX", focalLengthX);
+        focalLengthY = pt.get<double>("focalLengthY", focalLengthY);
+        principalX = pt.get<double>("principalX", principalX);
+        principalY = pt.get<double>("principalY", principalY);
+        hfov = pt.get<double>("hfov", hfov);
+        vfov = pt.get<double>("vfov", vfov);
+        zNear = pt.get<double>("zNear", zNear);
+        zFar = pt.get<double>("zFar", zFar);
+        distortionK1 = pt.get<double>("distortionK1", distortionK1);
+        distortionK2 = pt.get<double>("distortionK2", distortionK2);
+        distortionK3 = pt.get<double>("distortionK3", distortionK3);
+        distortionP1 = pt.get<double>("distortionP1", distortionP1);
+        distortionP2 = pt.get<double>("distortionP2", distortionP2);
+        pixel_noise_stddev = pt.get<double>("pixel_noise_stddev", pixel_noise_stddev);
+        distractor_count = pt.get<int>("distractor_count", distractor_count);
+        distractor_radius_px = pt.get<double>("distractor_radius_px", distractor_radius_px);
+
+        pose.Orientation.w = pt.get<float>("pose.orientation.w", 1.0);
+        pose.Orientation.x = pt.get<float>("pose.orientation.x", 0.0);
+        pose.Orientation.y = pt.get<float>("pose.orientation.y", 0.0);
+        pose.Orientation.z = pt.get<float>("pose.orientation.z", 0.0);
+        pose.PositionCm.x = pt.get<float>("pose.position.x", 0.0);
+        pose.PositionCm.y = pt.get<float>("pose.position.y", 0.0);
+        pose.PositionCm.z = pt.get<float>("pose.position.z", 0.0);
+
+        // Read the default preset table
+        readColorPropertyPresetTable(pt, &SharedColorPresets);
+
+        // Read all of the controller preset tables
+        const std::string controller_prefix("controller_");
+        const std::string hmd_prefix("hmd_");
+        for (auto iter = pt.begin(); iter != pt.end(); iter++)
+        {
+            const std::string &entry_name = iter->first;
+
+            if (entry_name.compare(0, controller_prefix.length(), controller_prefix) == 0 ||
+                entry_name.compare(0, hmd_prefix.length(), hmd_prefix) == 0)
+            {
+                CommonHSVColorRangeTable table;
+
+                table.table_name = entry_name;
+                for (int preset_index = 0; preset_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++preset_index)
+                {
+                    table.color_presets[preset_index] = k_default_color_presets[preset_index];
+                }
+
+                readColorPropertyPresetTable(pt, &table);
+
+                DeviceColorPresets.push_back(table);
+            }
+        }
+    }
+    else
+    {
+        SERVER_LOG_WARNING("VirtualTrackerConfig") <<
+            "Config version " << config_version << " does not match expected version " <<
+            VirtualTrackerConfig::CONFIG_VERSION << ", Using defaults.";
+    }
+}
+
+const CommonHSVColorRangeTable *
+VirtualTrackerConfig::getColorRangeTable(const std::string &table_name) const
+{
+    const CommonHSVColorRangeTable *table = &SharedColorPresets;
+
+    if (table_name.length() > 0)
+    {
+        for (auto &entry : DeviceColorPresets)
+        {
+            if (entry.table_name == table_name)
+            {
+                table = &entry;
+            }
+        }
+    }
+
+    return table;
+}
+
+CommonHSVColorRangeTable *
+VirtualTrackerConfig::getOrAddColorRangeTable(const std::string &table_name)
+{
+    CommonHSVColorRangeTable *table = nullptr;
+
+    if (table_name.length() > 0)
+    {
+        for (auto &entry : DeviceColorPresets)
+        {
+            if (entry.table_name == table_name)
+            {
+                table = &entry;
+            }
+        }
+
+        if (table == nullptr)
+        {
+            CommonHSVColorRangeTable Table;
+
+            Table.table_name = table_name;
+            for (int preset_index = 0; preset_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++preset_index)
+            {
+                Table.color_presets[preset_index] = k_default_color_presets[preset_index];
+            }
+
+            DeviceColorPresets.push_back(Table);
+            table = &DeviceColorPresets[DeviceColorPresets.size() - 1];
+        }
+    }
+    else
+    {
+        table = &SharedColorPresets;
+    }
+
+    return table;
+}
+
+// -- Virtual Tracker
+VirtualTracker::VirtualTracker()
+    : cfg()
+    , DevicePath()
+    , CameraIndex(-1)
+    , bIsOpen(false)
+    , FrameBuffer()
+    , FrameWidth(0)
+    , FrameHeight(0)
+    , LastFrameTime()
+    , LastSceneFrameIndex(-1)
+    , NextPollSequenceNumber(0)
+    , TrackerStates()
+{
+}
+
+VirtualTracker::~VirtualTracker()
+{
+    if (getIsOpen())
+    {
+        SERVER_LOG_ERROR("~VirtualTracker") << "Tracker deleted without calling close() first!";
+    }
+}
+
+// -- IDeviceInterface
+bool VirtualTracker::matchesDeviceEnumerator(const DeviceEnumerator *enumerator) const
+{
+    // Down-cast the enumerator so we can use the correct get_path.
+    const TrackerDeviceEnumerator *pEnum = static_cast<const TrackerDeviceEnumerator *>(enumerator);
+
+    bool matches = false;
+
+    if (pEnum->get_device_type() == CommonDeviceState::VirtualTracker)
+    {
+        std::string enumerator_path = pEnum->get_path();
+
+        matches = (enumerator_path == DevicePath);
+    }
+
+    return matches;
+}
+
+bool VirtualTracker::open(const DeviceEnumerator *enumerator)
+{
+    const TrackerDeviceEnumerator *tracker_enumerator = static_cast<const TrackerDeviceEnumerator *>(enumerator);
+    const char *cur_dev_path = tracker_enumerator->get_path();
+
+    bool bSuccess = false;
+
+    if (getIsOpen())
+    {
+        SERVER_LOG_WARNING("VirtualTracker::open") << "VirtualTracker(" << cur_dev_path << ") already open. Ignoring request.";
+        bSuccess = true;
+    }
+    else
+    {
+        SERVER_LOG_INFO("VirtualTracker::open") << "Opening VirtualTracker(" << cur_dev_path << ")";
+
+        DevicePath = cur_dev_path;
+        CameraIndex = tracker_enumerator->get_camera_index();
+
+        // Load the config file, named after the device path
+        cfg = VirtualTrackerConfig(DevicePath);
+        cfg.load();
+
+        // Save the config back out again in case defaults changed
+        cfg.save();
+
+        resizeFrameBuffer(static_cast<int>(cfg.frame_width), static_cast<int>(cfg.frame_height));
+
+        LastFrameTime = std::chrono::time_point<std::chrono::high_resolution_clock>();
+        LastSceneFrameIndex = -1;
+        NextPollSequenceNumber = 0;
+        bIsOpen = true;
+        bSuccess = true;
+    }
+
+    return bSuccess;
+}
+
+bool VirtualTracker::getIsOpen() const
+{
+    return bIsOpen;
+}
+
+bool VirtualTracker::getIsReadyToPoll() const
+{
+    return getIsOpen();
+}
+
+IDeviceInterface::ePollResult VirtualTracker::poll()
+{
+    IDeviceInterface::ePollResult result = IDeviceInterface::_PollResultFailure;
+
+    if (getIsOpen())
+    {
+        const VirtualTrackerScene *scene = VirtualTrackerScene::getInstance();
+        bool bNewFrame;
+
+        // A stepped scene gets exactly one frame per step, otherwise run at the configured frame rate
+        if (scene->getIsManualTime())
+        {
+            bNewFrame = scene->getFrameIndex() != LastSceneFrameIndex;
+        }
+        else
+        {
+            const std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+            const std::chrono::duration<double> time_since_last_frame = now - LastFrameTime;
+
+            bNewFrame = time_since_last_frame.count() * cfg.frame_rate >= 1.0;
+        }
+
+        if (bNewFrame)
+        {
+            renderFrame();
+
+            // New data available. Keep iterating.
+            result = IDeviceInterface::_PollResultSuccessNewData;
+        }
+        else
+        {
+            // Device still in valid state
+            result = IDeviceInterface::_PollResultSuccessNoData;
+        }
+
+        {
+            VirtualTrackerState newState;
+
+            // Increment the sequence for every new polling packet
+            newState.PollSequenceNumber = NextPollSequenceNumber;
+            ++NextPollSequenceNumber;
+
+            // Make room for new entry if at the max queue size
+            if (TrackerStates.size() >= VIRTUAL_TRACKER_STATE_BUFFER_MAX)
+            {
+                TrackerStates.erase(TrackerStates.begin(), TrackerStates.begin() + TrackerStates.size() - VIRTUAL_TRACKER_STATE_BUFFER_MAX);
+            }
+
+            TrackerStates.push_back(newState);
+        }
+    }
+
+    return result;
+}
+
+void VirtualTracker::close()
+{
+    if (bIsOpen)
+    {
+        FrameBuffer.clear();
+        DevicePath = "";
+        bIsOpen = false;
+    }
+    else
+    {
+        SERVER_LOG_INFO("VirtualTracker::close") << "VirtualTracker already closed. Ignoring request.";
+    }
+}
+
+long VirtualTracker::getMaxPollFailureCount() const
+{
+    return cfg.max_poll_failure_count;
+}
+
+CommonDeviceState::eDeviceType VirtualTracker::getDeviceType() const
+{
+    return CommonDeviceState::VirtualTracker;
+}
+
+const CommonDeviceState *VirtualTracker::getState(int lookBack) const
+{
+    const int queueSize = static_cast<int>(TrackerStates.size());
+    const CommonDeviceState * result =
+        (lookBack < queueSize) ? &TrackerStates.at(queueSize - lookBack - 1) : nullptr;
+
+    return result;
+}
+
+// -- ITrackerInterface
+ITrackerInterface::eDriverType VirtualTracker::getDriverType() const
+{
+    // No driver of its own, report the closest match
+    return ITrackerInterface::Generic_Webcam;
+}
+
+std::string VirtualTracker::getUSBDevicePath() const
+{
+    return DevicePath;
+}
+
+bool VirtualTracker::getVideoFrameDimensions(
+    int *out_width,
+    int *out_height,
+    int *out_stride) const
+{
+    if (out_width != nullptr)
+    {
+        *out_width = FrameWidth;
+    }
+
+    if (out_height != nullptr)
+    {
+        *out_height = FrameHeight;
+    }
+
+    if (out_stride != nullptr)
+    {
+        *out_stride = FrameWidth * 3; // BGR
+    }
+
+    return getIsOpen();
+}
+
+const unsigned char *VirtualTracker::getVideoFrameBuffer() const
+{
+    return FrameBuffer.empty() ? nullptr : FrameBuffer.data();
+}
+
+void VirtualTracker::loadSettings()
+{
+    cfg.load();
+
+    if (static_cast<int>(cfg.frame_width) != FrameWidth || static_cast<int>(cfg.frame_height) != FrameHeight)
+    {
+        resizeFrameBuffer(static_cast<int>(cfg.frame_width), static_cast<int>(cfg.frame_height));
+    }
+}
+
+void VirtualTracker::saveSettings()
+{
+    cfg.save();
+}
+
+void VirtualTracker::setFrameWidth(double value, bool bUpdateConfig)
+{
+    if (value <= 0.0 || static_cast<int>(value) == FrameWidth)
+    {
+        return;
+    }
+
+    // Keep the aspect ratio and the field of view, like switching a real camera's video mode
+    const double scale = value / static_cast<double>(FrameWidth);
+    cfg.focalLengthX *= scale;
+    cfg.focalLengthY *= scale;
+    cfg.principalX *= scale;
+    cfg.principalY *= scale;
+
+    resizeFrameBuffer(static_cast<int>(value), static_cast<int>(FrameHeight * scale + 0.5));
+
+    if (bUpdateConfig)
+    {
+        cfg.frame_width = FrameWidth;
+        cfg.frame_height = FrameHeight;
+    }
+}
+
+double VirtualTracker::getFrameWidth() const
+{
+    return static_cast<double>(FrameWidth);
+}
+
+void VirtualTracker::setFrameHeight(double value, bool bUpdateConfig)
+{
+    // The height always follows the width
+}
+
+double VirtualTracker::getFrameHeight() const
+{
+    return static_cast<double>(FrameHeight);
+}
+
+void VirtualTracker::setFrameRate(double value, bool bUpdateConfig)
+{
+    if (bUpdateConfig)
+    {
+        cfg.frame_rate = value;
+    }
+}
+
+double VirtualTracker::getFrameRate() const
+{
+    return cfg.frame_rate;
+}
+
+void VirtualTracker::setExposure(double value, bool bUpdateConfig)
+{
+    if (bUpdateConfig)
+    {
+        cfg.exposure = value;
+    }
+}
+
+double VirtualTracker::getExposure() const
+{
+    return cfg.exposure;
+}
+
+void VirtualTracker::setGain(double value, bool bUpdateConfig)
+{
+    if (bUpdateConfig)
+    {
+        cfg.gain = value;
+    }
+}
+
+double VirtualTracker::getGain() const
+{
+    return cfg.gain;
+}
+
+void VirtualTracker::getCameraIntrinsics(
+    float &outFocalLengthX, float &outFocalLengthY,
+    float &outPrincipalX, float &outPrincipalY,
+    float &outDistortionK1, float &outDistortionK2, float &outDistortionK3,
+    float &outDistortionP1, float &outDistortionP2) const
+{
+    outFocalLengthX = static_cast<float>(cfg.focalLengthX);
+    outFocalLengthY = static_cast<float>(cfg.focalLengthY);
+    outPrincipalX = static_cast<float>(cfg.principalX);
+    outPrincipalY = static_cast<float>(cfg.principalY);
+    outDistortionK1 = static_cast<float>(cfg.distortionK1);
+    outDistortionK2 = static_cast<float>(cfg.distortionK2);
+    outDistortionK3 = static_cast<float>(cfg.distortionK3);
+    outDistortionP1 = static_cast<float>(cfg.distortionP1);
+    outDistortionP2 = static_cast<float>(cfg.distortionP2);
+}
+
+void VirtualTracker::setCameraIntrinsics(
+    float focalLengthX, float focalLengthY,
+    float principalX, float principalY,
+    float distortionK1, float distortionK2, float distortionK3,
+    float distortionP1, float distortionP2)
+{
+    cfg.focalLengthX = focalLengthX;
+    cfg.focalLengthY = focalLengthY;
+    cfg.principalX = principalX;
+    cfg.principalY = principalY;
+    cfg.distortionK1 = distortionK1;
+    cfg.distortionK2 = distortionK2;
+    cfg.distortionK3 = distortionK3;
+    cfg.distortionP1 = distortionP1;
+    cfg.distortionP2 = distortionP2;
+}
+
+CommonDevicePose VirtualTracker::getTrackerPose() const
+{
+    return cfg.pose;
+}
+
+void VirtualTracker::setTrackerPose(
+    const struct CommonDevicePose *pose)
+{
+    cfg.pose = *pose;
+    cfg.save();
+}
+
+void VirtualTracker::getFOV(float &outHFOV, float &outVFOV) const
+{
+    outHFOV = static_cast<float>(cfg.hfov);
+    outVFOV = static_cast<float>(cfg.vfov);
+}
+
+void VirtualTracker::getZRange(float &outZNear, float &outZFar) const
+{
+    outZNear = static_cast<float>(cfg.zNear);
+    outZFar = static_cast<float>(cfg.zFar);
+}
+
+void VirtualTracker::gatherTrackerOptions(
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+    // No tracker specific options
+}
+
+bool VirtualTracker::setOptionIndex(
+    const std::string &option_name,
+    int option_index)
+{
+    return false;
+}
+
+bool VirtualTracker::getOptionIndex(
+    const std::string &option_name,
+    int &out_option_index) const
+{
+    return false;
+}
+
+void VirtualTracker::gatherTrackingColorPresets(
+    const std::string &controller_serial,
+    PSMoveProtocol::Response_ResultTrackerSettings* settings) const
+{
+    const CommonHSVColorRangeTable *table = cfg.getColorRangeTable(controller_serial);
+
+    for (int list_index = 0; list_index < MAX_TRACKING_COLOR_TYPES; ++list_index)
+    {
+        const CommonHSVColorRange &hsvRange = table->color_presets[list_index];
+        const eCommonTrackingColorID colorType = static_cast<eCommonTrackingColorID>(list_index);
+
+        PSMoveProtocol::TrackingColorPreset *colorPreset = settings->add_color_presets();
+        colorPreset->set_color_type(static_cast<PSMoveProtocol::TrackingColorType>(colorType));
+        colorPreset->set_hue_center(hsvRange.hue_range.center);
+        colorPreset->set_hue_range(hsvRange.hue_range.range);
+        colorPreset->set_saturation_center(hsvRange.saturation_range.center);
+        colorPreset->set_saturation_range(hsvRange.saturation_range.range);
+        colorPreset->set_value_center(hsvRange.value_range.center);
+        colorPreset->set_value_range(hsvRange.value_range.range);
+    }
+}
+
+void VirtualTracker::setTrackingColorPreset(
+    const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    const CommonHSVColorRange *preset)
+{
+    CommonHSVColorRangeTable *table = cfg.getOrAddColorRangeTable(controller_serial);
+
+    table->color_presets[color] = *preset;
+    cfg.save();
+}
+
+void VirtualTracker::getTrackingColorPreset(
+    const std::string &controller_serial,
+    eCommonTrackingColorID color,
+    CommonHSVColorRange *out_preset) const
+{
+    const CommonHSVColorRangeTable *table = cfg.getColorRangeTable(controller_serial);
+
+    *out_preset = table->color_presets[color];
+}
+
+// -- private methods
+void VirtualTracker::resizeFrameBuffer(int width, int height)
+{
+    FrameWidth = width;
+    FrameHeight = height;
+    FrameBuffer.assign(static_cast<size_t>(width * height * 3), 0);
+}
+
+void VirtualTracker::renderFrame()
+{
+    const VirtualTrackerScene *scene = VirtualTrackerScene::getInstance();
+
+    VirtualTrackerCamera camera;
+    camera.frame_width = FrameWidth;
+    camera.frame_height = FrameHeight;
+    getCameraIntrinsics(
+        camera.focal_length_x, camera.focal_length_y,
+        camera.principal_x, camera.principal_y,
+        camera.distortion_k1, camera.distortion_k2, camera.distortion_k3,
+        camera.distortion_p1, camera.distortion_p2);
+    camera.pose = cfg.pose;
+
+    VirtualTrackerImageNoise noise;
+    noise.pixel_noise_stddev = static_cast<float>(cfg.pixel_noise_stddev);
+    noise.distractor_count = cfg.distractor_count;
+    noise.distractor_radius_px = static_cast<float>(cfg.distractor_radius_px);
+    noise.distractor_seed = static_cast<unsigned int>(CameraIndex + 1);
+    noise.frame_seed = static_cast<unsigned int>(NextPollSequenceNumber) * 31u + static_cast<unsigned int>(CameraIndex + 1);
+
+    // Objects are lit in the shared preset colors, the same ones the tracking blobs are filtered with
+    scene->render(camera, &cfg.SharedColorPresets, noise, FrameBuffer.data());
+
+    LastFrameTime = std::chrono::high_resolution_clock::now();
+    LastSceneFrameIndex = scene->getFrameIndex();
+}
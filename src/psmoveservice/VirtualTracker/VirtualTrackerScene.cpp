@@ -0,0 +1,636 @@
+//-- includes -----
+#include "VirtualTrackerScene.h"
+#include "MathGLM.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <math.h>
+
+//-- constants -----
+static const float k_point_cloud_led_radius_cm = 0.4f;
+static const float k_min_render_depth_cm = 1.f;
+static const unsigned char k_background_level = 16;
+static const int k_bounds_padding_px = 2;
+static const int k_undistort_iterations = 5;
+
+// 2x2 supersampling offsets around the pixel center (pixel centers are on integer coordinates, like OpenCV)
+static const float k_sample_offsets[4][2] = {
+    { -0.25f, -0.25f }, { 0.25f, -0.25f }, { -0.25f, 0.25f }, { 0.25f, 0.25f }
+};
+
+//-- definitions -----
+struct CameraRenderState
+{
+    const VirtualTrackerCamera *camera;
+    glm::mat4 world_to_camera;
+    glm::vec3 camera_position;
+    bool bHasDistortion;
+};
+
+struct PixelRect
+{
+    int x0, y0, x1, y1; // inclusive
+
+    inline bool isEmpty() const
+    { return x1 < x0 || y1 < y0; }
+};
+
+struct RenderPrimitive
+{
+    enum ePrimitiveType
+    {
+        SpherePrimitive,
+        QuadPrimitive
+    };
+
+    ePrimitiveType type;
+    float depth; // tracker relative z, used to draw far to near
+    glm::vec3 center; // tracker relative sphere center
+    float radius;
+    float quad_px[4][2]; // screen space quad corners
+    unsigned char bgr[3];
+};
+
+//-- prototypes -----
+static void hsv_color_to_bgr(const CommonHSVColorRange &hsv, unsigned char out_bgr[3]);
+static void distort_normalized_point(const VirtualTrackerCamera &camera, float x, float y, float &out_x, float &out_y);
+static void undistort_normalized_point(const VirtualTrackerCamera &camera, float x, float y, float &out_x, float &out_y);
+static bool project_tracker_relative_point(const CameraRenderState &state, const glm::vec3 &point, float &out_u, float &out_v);
+static void pixel_to_normalized_ray(const CameraRenderState &state, float u, float v, float &out_x, float &out_y);
+static PixelRect clip_pixel_bounds(const VirtualTrackerCamera &camera, float min_u, float min_v, float max_u, float max_v);
+static PixelRect compute_sphere_pixel_bounds(const CameraRenderState &state, const glm::vec3 &center, float radius);
+static PixelRect compute_quad_pixel_bounds(const CameraRenderState &state, const float quad_px[4][2]);
+static void add_sphere_primitive(
+    const CameraRenderState &state, const glm::vec3 &world_center, float radius, const unsigned char bgr[3],
+    std::vector<RenderPrimitive> &primitives);
+static void draw_sphere(const CameraRenderState &state, const RenderPrimitive &sphere, unsigned char *bgr_buffer);
+static void draw_quad(const CameraRenderState &state, const RenderPrimitive &quad, unsigned char *bgr_buffer);
+static void draw_disk(
+    const VirtualTrackerCamera &camera, float center_u, float center_v, float radius_px, const unsigned char bgr[3],
+    unsigned char *bgr_buffer);
+static void blend_pixel(unsigned char *pixel, const unsigned char bgr[3], int coverage_samples);
+static inline unsigned int xorshift32(unsigned int &state);
+
+//-- public implementation -----
+CommonDevicePose
+VirtualTrackerTrajectory::evaluate(double time_seconds) const
+{
+    const double two_pi = 2.0 * k_real_pi;
+    CommonDevicePose pose;
+
+    pose.PositionCm.set(
+        center_cm.x + amplitude_cm.i * static_cast<float>(sin(two_pi * frequency_hz.i * time_seconds + phase_radians.i)),
+        center_cm.y + amplitude_cm.j * static_cast<float>(sin(two_pi * frequency_hz.j * time_seconds + phase_radians.j)),
+        center_cm.z + amplitude_cm.k * static_cast<float>(sin(two_pi * frequency_hz.k * time_seconds + phase_radians.k)));
+
+    const float half_yaw = 0.5f * static_cast<float>(fmod(yaw_rate_radians * time_seconds, two_pi));
+    pose.Orientation.w = cosf(half_yaw);
+    pose.Orientation.x = 0.f;
+    pose.Orientation.y = sinf(half_yaw);
+    pose.Orientation.z = 0.f;
+
+    return pose;
+}
+
+VirtualTrackerScene::VirtualTrackerScene()
+    : m_objects()
+    , m_startTime(std::chrono::high_resolution_clock::now())
+    , m_manualTime(0.0)
+    , m_bManualTime(false)
+    , m_frameIndex(0)
+{
+}
+
+VirtualTrackerScene *
+VirtualTrackerScene::getInstance()
+{
+    static VirtualTrackerScene scene;
+
+    return &scene;
+}
+
+int
+VirtualTrackerScene::addObject(const VirtualTrackerSceneObject &object)
+{
+    m_objects.push_back(object);
+
+    return static_cast<int>(m_objects.size()) - 1;
+}
+
+void
+VirtualTrackerScene::clearObjects()
+{
+    m_objects.clear();
+}
+
+void
+VirtualTrackerScene::setObjectTrackingColor(int object_index, eCommonTrackingColorID tracking_color_id)
+{
+    m_objects[object_index].tracking_color_id = tracking_color_id;
+}
+
+CommonDevicePose
+VirtualTrackerScene::getObjectPose(int object_index) const
+{
+    return m_objects[object_index].trajectory.evaluate(getTime());
+}
+
+void
+VirtualTrackerScene::setTime(double time_seconds)
+{
+    m_manualTime = time_seconds;
+    m_bManualTime = true;
+    ++m_frameIndex;
+}
+
+double
+VirtualTrackerScene::getTime() const
+{
+    if (m_bManualTime)
+    {
+        return m_manualTime;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - m_startTime;
+
+    return elapsed.count();
+}
+
+void
+VirtualTrackerScene::render(
+    const VirtualTrackerCamera &camera,
+    const CommonHSVColorRangeTable *color_presets,
+    const VirtualTrackerImageNoise &noise,
+    unsigned char *out_bgr_buffer) const
+{
+    const int pixel_count = camera.frame_width * camera.frame_height;
+    const double time_seconds = getTime();
+
+    CameraRenderState state;
+    {
+        const CommonDevicePose &pose = camera.pose;
+        const glm::quat camera_orientation(pose.Orientation.w, pose.Orientation.x, pose.Orientation.y, pose.Orientation.z);
+        const glm::vec3 camera_position(pose.PositionCm.x, pose.PositionCm.y, pose.PositionCm.z);
+
+        state.camera = &camera;
+        state.world_to_camera = glm::inverse(glm_mat4_from_pose(camera_orientation, camera_position));
+        state.camera_position = camera_position;
+        state.bHasDistortion =
+            camera.distortion_k1 != 0.f || camera.distortion_k2 != 0.f || camera.distortion_k3 != 0.f ||
+            camera.distortion_p1 != 0.f || camera.distortion_p2 != 0.f;
+    }
+
+    unsigned char preset_bgr[eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES][3];
+    for (int color_index = 0; color_index < eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES; ++color_index)
+    {
+        hsv_color_to_bgr(color_presets->color_presets[color_index], preset_bgr[color_index]);
+    }
+
+    // Background
+    std::fill(out_bgr_buffer, out_bgr_buffer + pixel_count * 3, k_background_level);
+
+    // Distractors sit behind everything else
+    {
+        unsigned int rng_state = (noise.distractor_seed * 2654435761u) | 1;
+
+        for (int distractor_index = 0; distractor_index < noise.distractor_count; ++distractor_index)
+        {
+            const float u = static_cast<float>(xorshift32(rng_state) % camera.frame_width);
+            const float v = static_cast<float>(xorshift32(rng_state) % camera.frame_height);
+            const float radius = noise.distractor_radius_px * (0.5f + static_cast<float>(xorshift32(rng_state) % 1024) / 1024.f);
+            const int color_index = distractor_index % eCommonTrackingColorID::MAX_TRACKING_COLOR_TYPES;
+
+            draw_disk(camera, u, v, radius, preset_bgr[color_index], out_bgr_buffer);
+        }
+    }
+
+    // Turn the objects into tracker relative primitives
+    std::vector<RenderPrimitive> primitives;
+    for (const VirtualTrackerSceneObject &object : m_objects)
+    {
+        if (object.tracking_color_id == eCommonTrackingColorID::INVALID_COLOR)
+        {
+            continue;
+        }
+
+        const unsigned char *bgr = preset_bgr[object.tracking_color_id];
+        const CommonDevicePose object_pose = object.trajectory.evaluate(time_seconds);
+        const glm::quat object_orientation(
+            object_pose.Orientation.w, object_pose.Orientation.x, object_pose.Orientation.y, object_pose.Orientation.z);
+        const glm::vec3 object_position(object_pose.PositionCm.x, object_pose.PositionCm.y, object_pose.PositionCm.z);
+        const CommonDeviceTrackingShape &shape = object.shape;
+
+        switch (shape.shape_type)
+        {
+        case eCommonTrackingShapeType::Sphere:
+            {
+                const glm::vec3 local_center(shape.shape.sphere.center_cm.x, shape.shape.sphere.center_cm.y, shape.shape.sphere.center_cm.z);
+
+                add_sphere_primitive(
+                    state, object_position + object_orientation * local_center, shape.shape.sphere.radius_cm, bgr, primitives);
+            } break;
+        case eCommonTrackingShapeType::LightBar:
+            {
+                RenderPrimitive quad;
+                bool bAllVisible = true;
+                float depth_sum = 0.f;
+
+                quad.type = RenderPrimitive::QuadPrimitive;
+                for (int corner_index = 0; bAllVisible && corner_index < 4; ++corner_index)
+                {
+                    const CommonDevicePosition &corner = shape.shape.light_bar.quad[corner_index];
+                    const glm::vec3 world_corner = object_position + object_orientation * glm::vec3(corner.x, corner.y, corner.z);
+                    const glm::vec3 relative_corner = glm::vec3(state.world_to_camera * glm::vec4(world_corner, 1.f));
+
+                    bAllVisible = project_tracker_relative_point(state, relative_corner, quad.quad_px[corner_index][0], quad.quad_px[corner_index][1]);
+                    depth_sum += relative_corner.z;
+                }
+
+                if (bAllVisible)
+                {
+                    quad.depth = depth_sum * 0.25f;
+                    std::copy(bgr, bgr + 3, quad.bgr);
+                    primitives.push_back(quad);
+                }
+            } break;
+        case eCommonTrackingShapeType::PointCloud:
+            {
+                for (int point_index = 0; point_index < shape.shape.point_cloud.point_count; ++point_index)
+                {
+                    const CommonDevicePosition &point = shape.shape.point_cloud.point[point_index];
+                    const CommonDeviceVector &normal = shape.shape.point_cloud.normal[point_index];
+                    const glm::vec3 world_point = object_position + object_orientation * glm::vec3(point.x, point.y, point.z);
+                    const glm::vec3 world_normal = object_orientation * glm::vec3(normal.i, normal.j, normal.k);
+
+                    // LEDs only shine forward
+                    if (glm::dot(world_normal, state.camera_position - world_point) > 0.f)
+                    {
+                        add_sphere_primitive(state, world_point, k_point_cloud_led_radius_cm, bgr, primitives);
+                    }
+                }
+            } break;
+        default:
+            break;
+        }
+    }
+
+    // Far to near so nearer objects occlude
+    std::sort(
+        primitives.begin(), primitives.end(),
+        [](const RenderPrimitive &a, const RenderPrimitive &b) {
+            return a.depth > b.depth;
+    });
+
+    for (const RenderPrimitive &primitive : primitives)
+    {
+        if (primitive.type == RenderPrimitive::SpherePrimitive)
+        {
+            draw_sphere(state, primitive, out_bgr_buffer);
+        }
+        else
+        {
+            draw_quad(state, primitive, out_bgr_buffer);
+        }
+    }
+
+    // Sensor noise on top of everything
+    if (noise.pixel_noise_stddev > 0.f)
+    {
+        // A sum of four uniform bytes is close enough to a gaussian (stddev ~147.8)
+        const float noise_scale = noise.pixel_noise_stddev / 147.8f;
+        unsigned int rng_state = (noise.frame_seed * 2246822519u) | 1;
+
+        for (int channel_index = 0; channel_index < pixel_count * 3; ++channel_index)
+        {
+            const unsigned int random_bits = xorshift32(rng_state);
+            const int byte_sum =
+                static_cast<int>(random_bits & 0xff) + static_cast<int>((random_bits >> 8) & 0xff) +
+                static_cast<int>((random_bits >> 16) & 0xff) + static_cast<int>(random_bits >> 24);
+            const int value = out_bgr_buffer[channel_index] + static_cast<int>(static_cast<float>(byte_sum - 510) * noise_scale);
+
+            out_bgr_buffer[channel_index] = static_cast<unsigned char>(std::min(std::max(value, 0), 255));
+        }
+    }
+}
+
+//-- private implementation -----
+static void hsv_color_to_bgr(const CommonHSVColorRange &hsv, unsigned char out_bgr[3])
+{
+    // OpenCV ranges: hue [0, 180), saturation and value [0, 255]
+    const float hue_degrees = fmodf(hsv.hue_range.center * 2.f + 360.f, 360.f);
+    const float saturation = std::min(std::max(hsv.saturation_range.center / 255.f, 0.f), 1.f);
+    const float value = std::min(std::max(hsv.value_range.center / 255.f, 0.f), 1.f);
+
+    const float chroma = value * saturation;
+    const float sector = hue_degrees / 60.f;
+    const float x = chroma * (1.f - fabsf(fmodf(sector, 2.f) - 1.f));
+    const float m = value - chroma;
+    float r = 0.f, g = 0.f, b = 0.f;
+
+    switch (static_cast<int>(sector))
+    {
+    case 0: r = chroma; g = x; break;
+    case 1: r = x; g = chroma; break;
+    case 2: g = chroma; b = x; break;
+    case 3: g = x; b = chroma; break;
+    case 4: r = x; b = chroma; break;
+    default: r = chroma; b = x; break;
+    }
+
+    out_bgr[0] = static_cast<unsigned char>((b + m) * 255.f + 0.5f);
+    out_bgr[1] = static_cast<unsigned char>((g + m) * 255.f + 0.5f);
+    out_bgr[2] = static_cast<unsigned char>((r + m) * 255.f + 0.5f);
+}
+
+static void distort_normalized_point(const VirtualTrackerCamera &camera, float x, float y, float &out_x, float &out_y)
+{
+    // Same model as cv::projectPoints
+    const float r2 = x*x + y*y;
+    const float radial = 1.f + r2*(camera.distortion_k1 + r2*(camera.distortion_k2 + r2*camera.distortion_k3));
+
+    out_x = x*radial + 2.f*camera.distortion_p1*x*y + camera.distortion_p2*(r2 + 2.f*x*x);
+    out_y = y*radial + camera.distortion_p1*(r2 + 2.f*y*y) + 2.f*camera.distortion_p2*x*y;
+}
+
+static void undistort_normalized_point(const VirtualTrackerCamera &camera, float x, float y, float &out_x, float &out_y)
+{
+    // Fixed point iteration, same as cv::undistortPoints
+    float ux = x, uy = y;
+
+    for (int iteration = 0; iteration < k_undistort_iterations; ++iteration)
+    {
+        const float r2 = ux*ux + uy*uy;
+        const float radial = 1.f + r2*(camera.distortion_k1 + r2*(camera.distortion_k2 + r2*camera.distortion_k3));
+        const float delta_x = 2.f*camera.distortion_p1*ux*uy + camera.distortion_p2*(r2 + 2.f*ux*ux);
+        const float delta_y = camera.distortion_p1*(r2 + 2.f*uy*uy) + 2.f*camera.distortion_p2*ux*uy;
+
+        ux = (x - delta_x) / radial;
+        uy = (y - delta_y) / radial;
+    }
+
+    out_x = ux;
+    out_y = uy;
+}
+
+static bool project_tracker_relative_point(const CameraRenderState &state, const glm::vec3 &point, float &out_u, float &out_v)
+{
+    if (point.z < k_min_render_depth_cm)
+    {
+        return false;
+    }
+
+    const VirtualTrackerCamera &camera = *state.camera;
+    float x = point.x / point.z;
+    float y = point.y / point.z;
+
+    if (state.bHasDistortion)
+    {
+        distort_normalized_point(camera, x, y, x, y);
+    }
+
+    // Screen +Y is down, i.e. the negated F_PY used by ServerTrackerView
+    out_u = camera.focal_length_x * x + camera.principal_x;
+    out_v = -camera.focal_length_y * y + camera.principal_y;
+
+    return true;
+}
+
+static void pixel_to_normalized_ray(const CameraRenderState &state, float u, float v, float &out_x, float &out_y)
+{
+    const VirtualTrackerCamera &camera = *state.camera;
+
+    out_x = (u - camera.principal_x) / camera.focal_length_x;
+    out_y = (v - camera.principal_y) / -camera.focal_length_y;
+
+    if (state.bHasDistortion)
+    {
+        undistort_normalized_point(camera, out_x, out_y, out_x, out_y);
+    }
+}
+
+static PixelRect clip_pixel_bounds(const VirtualTrackerCamera &camera, float min_u, float min_v, float max_u, float max_v)
+{
+    PixelRect rect;
+
+    rect.x0 = std::max(static_cast<int>(floorf(min_u)) - k_bounds_padding_px, 0);
+    rect.y0 = std::max(static_cast<int>(floorf(min_v)) - k_bounds_padding_px, 0);
+    rect.x1 = std::min(static_cast<int>(ceilf(max_u)) + k_bounds_padding_px, camera.frame_width - 1);
+    rect.y1 = std::min(static_cast<int>(ceilf(max_v)) + k_bounds_padding_px, camera.frame_height - 1);
+
+    return rect;
+}
+
+static PixelRect compute_sphere_pixel_bounds(const CameraRenderState &state, const glm::vec3 &center, float radius)
+{
+    const VirtualTrackerCamera &camera = *state.camera;
+    const float k_max_tangent = 4.f; // clamp silhouettes reaching past ~75 degrees off axis
+    float normalized_min[2], normalized_max[2];
+
+    // The silhouette cone's extent is exact along each image axis
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        const float lateral = (axis == 0) ? center.x : center.y;
+        const float distance = sqrtf(lateral*lateral + center.z*center.z);
+        const float half_angle = asinf(std::min(radius / distance, 1.f));
+        const float axis_angle = atan2f(lateral, center.z);
+
+        normalized_min[axis] = std::max(tanf(std::max(axis_angle - half_angle, -1.3f)), -k_max_tangent);
+        normalized_max[axis] = std::min(tanf(std::min(axis_angle + half_angle, 1.3f)), k_max_tangent);
+    }
+
+    // Push the box corners and edge midpoints through the lens
+    float min_u = static_cast<float>(camera.frame_width), min_v = static_cast<float>(camera.frame_height);
+    float max_u = -1.f, max_v = -1.f;
+    for (int x_step = 0; x_step <= 2; ++x_step)
+    {
+        for (int y_step = 0; y_step <= 2; ++y_step)
+        {
+            const float x = normalized_min[0] + (normalized_max[0] - normalized_min[0]) * 0.5f * static_cast<float>(x_step);
+            const float y = normalized_min[1] + (normalized_max[1] - normalized_min[1]) * 0.5f * static_cast<float>(y_step);
+            float u, v;
+
+            project_tracker_relative_point(state, glm::vec3(x, y, 1.f), u, v);
+            min_u = std::min(min_u, u); max_u = std::max(max_u, u);
+            min_v = std::min(min_v, v); max_v = std::max(max_v, v);
+        }
+    }
+
+    return clip_pixel_bounds(camera, min_u, min_v, max_u, max_v);
+}
+
+static PixelRect compute_quad_pixel_bounds(const CameraRenderState &state, const float quad_px[4][2])
+{
+    float min_u = quad_px[0][0], max_u = quad_px[0][0];
+    float min_v = quad_px[0][1], max_v = quad_px[0][1];
+
+    for (int corner_index = 1; corner_index < 4; ++corner_index)
+    {
+        min_u = std::min(min_u, quad_px[corner_index][0]); max_u = std::max(max_u, quad_px[corner_index][0]);
+        min_v = std::min(min_v, quad_px[corner_index][1]); max_v = std::max(max_v, quad_px[corner_index][1]);
+    }
+
+    return clip_pixel_bounds(*state.camera, min_u, min_v, max_u, max_v);
+}
+
+static void add_sphere_primitive(
+    const CameraRenderState &state, const glm::vec3 &world_center, float radius, const unsigned char bgr[3],
+    std::vector<RenderPrimitive> &primitives)
+{
+    const glm::vec3 relative_center = glm::vec3(state.world_to_camera * glm::vec4(world_center, 1.f));
+
+    // Skip anything behind the camera or touching the lens
+    if (relative_center.z - radius >= k_min_render_depth_cm)
+    {
+        RenderPrimitive sphere;
+
+        sphere.type = RenderPrimitive::SpherePrimitive;
+        sphere.depth = relative_center.z;
+        sphere.center = relative_center;
+        sphere.radius = radius;
+        std::copy(bgr, bgr + 3, sphere.bgr);
+        primitives.push_back(sphere);
+    }
+}
+
+static void draw_sphere(const CameraRenderState &state, const RenderPrimitive &sphere, unsigned char *bgr_buffer)
+{
+    const PixelRect rect = compute_sphere_pixel_bounds(state, sphere.center, sphere.radius);
+    const int frame_width = state.camera->frame_width;
+    const float center_length_sqr = glm::dot(sphere.center, sphere.center);
+    const float radius_sqr = sphere.radius * sphere.radius;
+
+    if (rect.isEmpty())
+    {
+        return;
+    }
+
+    for (int y = rect.y0; y <= rect.y1; ++y)
+    {
+        for (int x = rect.x0; x <= rect.x1; ++x)
+        {
+            int coverage_samples = 0;
+
+            for (int sample_index = 0; sample_index < 4; ++sample_index)
+            {
+                float ray_x, ray_y;
+                pixel_to_normalized_ray(
+                    state, static_cast<float>(x) + k_sample_offsets[sample_index][0], static_cast<float>(y) + k_sample_offsets[sample_index][1],
+                    ray_x, ray_y);
+
+                // Ray (ray_x, ray_y, 1) from the focal point hits the sphere
+                // if its closest approach to the center is within the radius
+                const float ray_dot_center = ray_x*sphere.center.x + ray_y*sphere.center.y + sphere.center.z;
+                const float ray_length_sqr = ray_x*ray_x + ray_y*ray_y + 1.f;
+                const float closest_distance_sqr = center_length_sqr - ray_dot_center*ray_dot_center / ray_length_sqr;
+
+                coverage_samples += (ray_dot_center > 0.f && closest_distance_sqr <= radius_sqr) ? 1 : 0;
+            }
+
+            blend_pixel(bgr_buffer + (y*frame_width + x) * 3, sphere.bgr, coverage_samples);
+        }
+    }
+}
+
+static void draw_quad(const CameraRenderState &state, const RenderPrimitive &quad, unsigned char *bgr_buffer)
+{
+    const PixelRect rect = compute_quad_pixel_bounds(state, quad.quad_px);
+    const int frame_width = state.camera->frame_width;
+
+    if (rect.isEmpty())
+    {
+        return;
+    }
+
+    // Either winding, a point is inside a convex quad when it's on the same side of every edge
+    float edge_a[4], edge_b[4], edge_c[4];
+    for (int edge_index = 0; edge_index < 4; ++edge_index)
+    {
+        const float *p0 = quad.quad_px[edge_index];
+        const float *p1 = quad.quad_px[(edge_index + 1) % 4];
+
+        edge_a[edge_index] = p0[1] - p1[1];
+        edge_b[edge_index] = p1[0] - p0[0];
+        edge_c[edge_index] = p0[0]*p1[1] - p1[0]*p0[1];
+    }
+
+    for (int y = rect.y0; y <= rect.y1; ++y)
+    {
+        for (int x = rect.x0; x <= rect.x1; ++x)
+        {
+            int coverage_samples = 0;
+
+            for (int sample_index = 0; sample_index < 4; ++sample_index)
+            {
+                const float u = static_cast<float>(x) + k_sample_offsets[sample_index][0];
+                const float v = static_cast<float>(y) + k_sample_offsets[sample_index][1];
+                int positive_count = 0, negative_count = 0;
+
+                for (int edge_index = 0; edge_index < 4; ++edge_index)
+                {
+                    const float side = edge_a[edge_index]*u + edge_b[edge_index]*v + edge_c[edge_index];
+
+                    positive_count += (side >= 0.f) ? 1 : 0;
+                    negative_count += (side <= 0.f) ? 1 : 0;
+                }
+
+                coverage_samples += (positive_count == 4 || negative_count == 4) ? 1 : 0;
+            }
+
+            blend_pixel(bgr_buffer + (y*frame_width + x) * 3, quad.bgr, coverage_samples);
+        }
+    }
+}
+
+static void draw_disk(
+    const VirtualTrackerCamera &camera, float center_u, float center_v, float radius_px, const unsigned char bgr[3],
+    unsigned char *bgr_buffer)
+{
+    const PixelRect rect = clip_pixel_bounds(camera, center_u - radius_px, center_v - radius_px, center_u + radius_px, center_v + radius_px);
+    const float radius_sqr = radius_px * radius_px;
+
+    for (int y = rect.y0; y <= rect.y1; ++y)
+    {
+        for (int x = rect.x0; x <= rect.x1; ++x)
+        {
+            int coverage_samples = 0;
+
+            for (int sample_index = 0; sample_index < 4; ++sample_index)
+            {
+                const float du = static_cast<float>(x) + k_sample_offsets[sample_index][0] - center_u;
+                const float dv = static_cast<float>(y) + k_sample_offsets[sample_index][1] - center_v;
+
+                coverage_samples += (du*du + dv*dv <= radius_sqr) ? 1 : 0;
+            }
+
+            blend_pixel(bgr_buffer + (y*camera.frame_width + x) * 3, bgr, coverage_samples);
+        }
+    }
+}
+
+static void blend_pixel(unsigned char *pixel, const unsigned char bgr[3], int coverage_samples)
+{
+    if (coverage_samples == 4)
+    {
+        pixel[0] = bgr[0];
+        pixel[1] = bgr[1];
+        pixel[2] = bgr[2];
+    }
+    else if (coverage_samples > 0)
+    {
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            pixel[channel] = static_cast<unsigned char>(
+                (static_cast<int>(pixel[channel]) * (4 - coverage_samples) + static_cast<int>(bgr[channel]) * coverage_samples) / 4);
+        }
+    }
+}
+
+static inline unsigned int xorshift32(unsigned int &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state;
+}
@@ -0,0 +1,108 @@
+#ifndef VIRTUAL_TRACKER_SCENE_H
+#define VIRTUAL_TRACKER_SCENE_H
+
+//-- includes -----
+#include "DeviceInterface.h"
+#include <chrono>
+#include <vector>
+
+//-- definitions -----
+/// Lissajous path an object follows through the scene, evaluated in world space
+struct VirtualTrackerTrajectory
+{
+    CommonDevicePosition center_cm;
+    CommonDeviceVector amplitude_cm;
+    CommonDeviceVector frequency_hz;
+    CommonDeviceVector phase_radians;
+    float yaw_rate_radians; // spin about world up, shows lightbars and point clouds from all sides
+
+    inline void clear()
+    {
+        center_cm.clear();
+        amplitude_cm.clear();
+        frequency_hz.clear();
+        phase_radians.clear();
+        yaw_rate_radians = 0.f;
+    }
+
+    CommonDevicePose evaluate(double time_seconds) const;
+};
+
+/// Something the virtual trackers can see: a tracking shape lit in one of the tracking colors
+struct VirtualTrackerSceneObject
+{
+    CommonDeviceTrackingShape shape; // object space
+    eCommonTrackingColorID tracking_color_id;
+    VirtualTrackerTrajectory trajectory;
+};
+
+/// Camera model the scene is rendered through (same conventions as ITrackerInterface)
+struct VirtualTrackerCamera
+{
+    int frame_width;
+    int frame_height;
+    float focal_length_x, focal_length_y;
+    float principal_x, principal_y;
+    float distortion_k1, distortion_k2, distortion_k3;
+    float distortion_p1, distortion_p2;
+    CommonDevicePose pose;
+};
+
+/// Image degradations applied on top of the clean render
+struct VirtualTrackerImageNoise
+{
+    float pixel_noise_stddev; // per channel sensor noise, 8-bit levels
+    int distractor_count; // stray tracking colored blobs (reflections, lamps)
+    float distractor_radius_px;
+    unsigned int distractor_seed; // distractors stay put for a given seed
+    unsigned int frame_seed; // sensor noise changes every frame
+};
+
+/// The shared world every virtual tracker renders.
+/// Objects are added programmatically (e.g. by a benchmark) and move along their trajectories
+/// with either wall clock time or a manually stepped time. Main thread only.
+class VirtualTrackerScene
+{
+public:
+    static VirtualTrackerScene *getInstance();
+
+    // -- Objects -----
+    int addObject(const VirtualTrackerSceneObject &object);
+    void clearObjects();
+    void setObjectTrackingColor(int object_index, eCommonTrackingColorID tracking_color_id);
+    inline int getObjectCount() const
+    { return static_cast<int>(m_objects.size()); }
+    inline const VirtualTrackerSceneObject &getObject(int object_index) const
+    { return m_objects[object_index]; }
+    CommonDevicePose getObjectPose(int object_index) const;
+
+    // -- Time -----
+    // Stepping the time by hand switches the scene over from wall clock time.
+    // Every step is a new frame for the virtual trackers.
+    void setTime(double time_seconds);
+    double getTime() const;
+    inline bool getIsManualTime() const
+    { return m_bManualTime; }
+    inline int getFrameIndex() const
+    { return m_frameIndex; }
+
+    // -- Rendering -----
+    // Renders the scene into a tightly packed BGR frame of camera.frame_width x camera.frame_height.
+    // Objects are drawn in the center color of their tracking color preset.
+    void render(
+        const VirtualTrackerCamera &camera,
+        const CommonHSVColorRangeTable *color_presets,
+        const VirtualTrackerImageNoise &noise,
+        unsigned char *out_bgr_buffer) const;
+
+private:
+    VirtualTrackerScene();
+
+    std::vector<VirtualTrackerSceneObject> m_objects;
+    std::chrono::time_point<std::chrono::high_resolution_clock> m_startTime;
+    double m_manualTime;
+    bool m_bManualTime;
+    int m_frameIndex;
+};
+
+#endif // VIRTUAL_TRACKER_SCENE_H
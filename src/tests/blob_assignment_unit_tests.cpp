@@ -0,0 +1,197 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+#include "BlobAssignment.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_blob_assignment_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("blob_assignment")
+		UNIT_TEST_MODULE_CALL_TEST(blob_assignment_test_optimal);
+		UNIT_TEST_MODULE_CALL_TEST(blob_assignment_test_overlapping_devices);
+		UNIT_TEST_MODULE_CALL_TEST(blob_assignment_test_gating);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static float compute_assignment_total_cost(const float *costs, int device_count, int blob_count, const int *device_blob_indices)
+{
+	float total = 0.f;
+
+	for (int device_index = 0; device_index < device_count; ++device_index)
+	{
+		const int blob_index = device_blob_indices[device_index];
+
+		total += (blob_index != -1) ? costs[device_index*blob_count + blob_index] : BLOB_ASSIGNMENT_MAX_COST;
+	}
+
+	return total;
+}
+
+// Tries every way to hand out the blobs, devices may also go without one
+static float compute_brute_force_best_cost(const float *costs, int device_count, int blob_count, int device_index, bool *blob_taken)
+{
+	if (device_index >= device_count)
+	{
+		return 0.f;
+	}
+
+	float best = BLOB_ASSIGNMENT_MAX_COST + compute_brute_force_best_cost(costs, device_count, blob_count, device_index + 1, blob_taken);
+
+	for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+	{
+		const float cost = costs[device_index*blob_count + blob_index];
+
+		if (!blob_taken[blob_index] && cost <= BLOB_ASSIGNMENT_MAX_COST)
+		{
+			blob_taken[blob_index] = true;
+			best = std::min(best, cost + compute_brute_force_best_cost(costs, device_count, blob_count, device_index + 1, blob_taken));
+			blob_taken[blob_index] = false;
+		}
+	}
+
+	return best;
+}
+
+bool
+blob_assignment_test_optimal()
+{
+	UNIT_TEST_BEGIN("optimal")
+
+	BlobAssignmentSolver solver;
+	unsigned int random_state = 4321;
+
+	for (int trial = 0; success && trial < 200; ++trial)
+	{
+		const int device_count = 1 + trial % 5;
+		const int blob_count = (trial / 5) % 6;
+		float costs[5 * 6];
+		int device_blob_indices[5];
+		bool blob_taken[6] = { false, false, false, false, false, false };
+
+		for (int cost_index = 0; cost_index < device_count*blob_count; ++cost_index)
+		{
+			random_state = random_state*1103515245u + 12345u;
+			costs[cost_index] = static_cast<float>((random_state >> 16) % 2000) * 0.01f; // some above the max cost
+		}
+
+		const int assigned_count = solver.solve(costs, device_count, blob_count, device_blob_indices);
+		const float solved_cost = compute_assignment_total_cost(costs, device_count, blob_count, device_blob_indices);
+		const float best_cost = compute_brute_force_best_cost(costs, device_count, blob_count, 0, blob_taken);
+
+		// Matches the best possible total and never gives a blob out twice
+		int counted_assignments = 0;
+		for (int device_index = 0; device_index < device_count; ++device_index)
+		{
+			const int blob_index = device_blob_indices[device_index];
+
+			if (blob_index != -1)
+			{
+				++counted_assignments;
+				success &= !blob_taken[blob_index];
+				blob_taken[blob_index] = true;
+			}
+		}
+
+		success &= counted_assignments == assigned_count && fabsf(solved_cost - best_cost) < 1e-3f;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+blob_assignment_test_overlapping_devices()
+{
+	UNIT_TEST_BEGIN("overlapping devices")
+
+	// Two same colored bulbs crossing paths, each one's own blob is the other's closest too.
+	// Picking the best blob per device would give both devices blob 0.
+	BlobAssignmentPrediction predictions[2];
+	predictions[0].center = Eigen::Vector2f(100.f, 100.f);
+	predictions[0].radius = 10.f;
+	predictions[0].position_sigma_px = 6.f;
+	predictions[1].center = Eigen::Vector2f(104.f, 100.f);
+	predictions[1].radius = 10.f;
+	predictions[1].position_sigma_px = 6.f;
+
+	BlobAssignmentCandidate blobs[2];
+	blobs[0].center = Eigen::Vector2f(102.f, 100.f);
+	blobs[0].radius = 10.f;
+	blobs[1].center = Eigen::Vector2f(96.f, 101.f);
+	blobs[1].radius = 9.f;
+
+	float costs[2 * 2];
+	for (int device_index = 0; device_index < 2; ++device_index)
+	{
+		for (int blob_index = 0; blob_index < 2; ++blob_index)
+		{
+			costs[device_index * 2 + blob_index] = computeBlobAssignmentCost(predictions[device_index], blobs[blob_index]);
+		}
+	}
+
+	success = costs[0] < costs[1] && costs[2] < costs[3];
+	assert(success);
+
+	if (success)
+	{
+		BlobAssignmentSolver solver;
+		int device_blob_indices[2];
+
+		success =
+			solver.solve(costs, 2, 2, device_blob_indices) == 2 &&
+			device_blob_indices[0] == 1 && device_blob_indices[1] == 0;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+blob_assignment_test_gating()
+{
+	UNIT_TEST_BEGIN("gating")
+
+	BlobAssignmentPrediction prediction;
+	prediction.center = Eigen::Vector2f(200.f, 150.f);
+	prediction.radius = 12.f;
+	prediction.position_sigma_px = 5.f;
+
+	BlobAssignmentCandidate near_blob;
+	near_blob.center = Eigen::Vector2f(204.f, 152.f);
+	near_blob.radius = 12.f;
+
+	BlobAssignmentCandidate far_blob;
+	far_blob.center = Eigen::Vector2f(240.f, 150.f);
+	far_blob.radius = 12.f;
+
+	BlobAssignmentCandidate wrong_size_blob;
+	wrong_size_blob.center = Eigen::Vector2f(200.f, 150.f);
+	wrong_size_blob.radius = 40.f;
+
+	success =
+		computeBlobAssignmentCost(prediction, near_blob) <= BLOB_ASSIGNMENT_MAX_COST &&
+		computeBlobAssignmentCost(prediction, far_blob) > BLOB_ASSIGNMENT_MAX_COST &&
+		computeBlobAssignmentCost(prediction, wrong_size_blob) > BLOB_ASSIGNMENT_MAX_COST;
+	assert(success);
+
+	// A device with only gated blobs around stays unassigned
+	if (success)
+	{
+		const float costs[2] = {
+			computeBlobAssignmentCost(prediction, far_blob),
+			computeBlobAssignmentCost(prediction, wrong_size_blob) };
+		BlobAssignmentSolver solver;
+		int device_blob_index;
+
+		success = solver.solve(costs, 1, 2, &device_blob_index) == 0 && device_blob_index == -1;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
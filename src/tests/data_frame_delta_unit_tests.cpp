@@ -0,0 +1,495 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <limits.h>
+
+#include "DataFrameDelta.h"
+#include "PSMoveProtocol.pb.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_data_frame_delta_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("data_frame_delta")
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_position_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_orientation_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_orientation_sign);
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_delta_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_field_cleared);
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_missing_keyframe);
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_late_frames);
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_sequence_num_wrap);
+		UNIT_TEST_MODULE_CALL_TEST(data_frame_delta_test_keyframe_request);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- definitions -----
+typedef PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket t_controller_data_packet;
+
+//-- private functions -----
+// Largest component difference of two unit quaternions, q and -q being the same rotation
+static float quaternion_error(const float a[4], const float b[4])
+{
+	float dot = 0.f;
+	for (int component = 0; component < 4; ++component)
+	{
+		dot += a[component] * b[component];
+	}
+
+	const float sign = dot < 0.f ? -1.f : 1.f;
+	float max_error = 0.f;
+	for (int component = 0; component < 4; ++component)
+	{
+		max_error = fmaxf(max_error, fabsf(a[component] - sign * b[component]));
+	}
+
+	return max_error;
+}
+
+// A PSMove packet with a pose rotated by angle_rad about a tilted axis
+static void make_psmove_packet(
+	int sequence_num,
+	unsigned int buttons,
+	float position_x_cm,
+	float angle_rad,
+	t_controller_data_packet &out_packet)
+{
+	out_packet.Clear();
+	out_packet.set_controller_id(0);
+	out_packet.set_controller_type(PSMoveProtocol::PSMOVE);
+	out_packet.set_sequence_num(sequence_num);
+	out_packet.set_isconnected(true);
+	out_packet.set_button_down_bitmask(buttons);
+
+	PSMoveProtocol::DeviceOutputDataFrame_ControllerDataPacket_PSMoveState *state = out_packet.mutable_psmove_state();
+	state->set_validhardwarecalibration(true);
+	state->set_istrackingenabled(true);
+	state->set_iscurrentlytracking(true);
+	state->set_isorientationvalid(true);
+	state->set_ispositionvalid(true);
+	state->mutable_position_cm()->set_x(position_x_cm);
+	state->mutable_position_cm()->set_y(-20.5f);
+	state->mutable_position_cm()->set_z(150.25f);
+
+	const float s = sinf(0.5f * angle_rad);
+	state->mutable_orientation()->set_x(s * 0.48f);
+	state->mutable_orientation()->set_y(s * -0.6f);
+	state->mutable_orientation()->set_z(s * 0.64f);
+	state->mutable_orientation()->set_w(cosf(0.5f * angle_rad));
+	state->set_trigger_value(0);
+	state->set_battery_value(4);
+}
+
+// Encodes a copy of the packet the way the service does before sending it
+static void encode_packet(
+	ControllerDataFrameDeltaEncoder &encoder,
+	const t_controller_data_packet &packet,
+	t_controller_data_packet &out_encoded)
+{
+	out_encoded.CopyFrom(packet);
+	encoder.encode(&out_encoded);
+}
+
+// The packet a client ends up with for the result of a decode
+static const t_controller_data_packet &get_decoded_packet(
+	const ControllerDataFrameDeltaDecoder &decoder,
+	ControllerDataFrameDeltaDecoder::eDecodeResult result,
+	const t_controller_data_packet &encoded)
+{
+	return (result == ControllerDataFrameDeltaDecoder::decodeRebuiltFrame) ? decoder.getRebuiltPacket() : encoded;
+}
+
+// Same state as the original, with the pose within the compression error
+static bool is_decoded_packet_equal(const t_controller_data_packet &original, const t_controller_data_packet &decoded)
+{
+	const PSMoveProtocol::Position &original_position = original.psmove_state().position_cm();
+	const PSMoveProtocol::Position &decoded_position = decoded.psmove_state().position_cm();
+	const PSMoveProtocol::Orientation &original_orientation = original.psmove_state().orientation();
+	const PSMoveProtocol::Orientation &decoded_orientation = decoded.psmove_state().orientation();
+	const float position_tolerance = 0.5f / DATA_FRAME_DELTA_POSITION_UNITS_PER_CM + 0.0001f;
+	const float q_original[4] = { original_orientation.x(), original_orientation.y(), original_orientation.z(), original_orientation.w() };
+	const float q_decoded[4] = { decoded_orientation.x(), decoded_orientation.y(), decoded_orientation.z(), decoded_orientation.w() };
+
+	if (fabsf(original_position.x() - decoded_position.x()) > position_tolerance ||
+		fabsf(original_position.y() - decoded_position.y()) > position_tolerance ||
+		fabsf(original_position.z() - decoded_position.z()) > position_tolerance ||
+		quaternion_error(q_original, q_decoded) > 0.00001f)
+	{
+		return false;
+	}
+
+	// Everything else has to come back exactly
+	t_controller_data_packet expected;
+	t_controller_data_packet actual;
+
+	expected.CopyFrom(original);
+	actual.CopyFrom(decoded);
+	expected.mutable_psmove_state()->clear_position_cm();
+	expected.mutable_psmove_state()->clear_orientation();
+	actual.mutable_psmove_state()->clear_position_cm();
+	actual.mutable_psmove_state()->clear_orientation();
+	actual.clear_delta_frame_type();
+	actual.clear_keyframe_sequence_num();
+	actual.clear_changed_state_fields();
+	actual.clear_compressed_pose();
+
+	return expected.SerializeAsString() == actual.SerializeAsString();
+}
+
+bool
+data_frame_delta_test_position_round_trip()
+{
+	UNIT_TEST_BEGIN("position round trip")
+		static const float k_positions_cm[] = { 0.f, 0.004f, -0.006f, 12.345f, -250.5f, 1000.f };
+
+		success = true;
+		for (float position_cm : k_positions_cm)
+		{
+			const float decompressed = decompressPositionComponent(compressPositionComponent(position_cm));
+
+			success &= fabsf(decompressed - position_cm) <= 0.5f / DATA_FRAME_DELTA_POSITION_UNITS_PER_CM + 0.0001f;
+		}
+
+		// Negative positions round to nearest too, not toward zero
+		success &= compressPositionComponent(-0.016f) == -2;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_frame_delta_test_orientation_round_trip()
+{
+	UNIT_TEST_BEGIN("orientation round trip")
+		float max_error = 0.f;
+
+		// Rotations about a tilted axis, so the largest component moves through all four slots
+		for (int step = 0; step < 360; ++step)
+		{
+			const float half_angle = static_cast<float>(step) * 3.14159265f / 180.f;
+			const float s = sinf(half_angle);
+			const float q[4] = { s * 0.48f, s * -0.6f, s * 0.64f, cosf(half_angle) };
+			float decompressed[4];
+
+			decompressOrientation(
+				compressOrientation(q[0], q[1], q[2], q[3]),
+				decompressed[0], decompressed[1], decompressed[2], decompressed[3]);
+
+			max_error = fmaxf(max_error, quaternion_error(q, decompressed));
+		}
+
+		// 20 bits per component keeps them within about a millionth
+		success = max_error < 0.00001f;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_frame_delta_test_orientation_sign()
+{
+	UNIT_TEST_BEGIN("orientation sign")
+		// A negative largest component comes back flipped, which is the same rotation
+		const float q[4] = { 0.1f, -0.2f, 0.3f, -0.927362f };
+		float decompressed[4];
+
+		decompressOrientation(
+			compressOrientation(q[0], q[1], q[2], q[3]),
+			decompressed[0], decompressed[1], decompressed[2], decompressed[3]);
+
+		success =
+			decompressed[3] > 0.f &&
+			fabsf(decompressed[0] + q[0]) < 0.0001f &&
+			fabsf(decompressed[1] + q[1]) < 0.0001f &&
+			fabsf(decompressed[2] + q[2]) < 0.0001f &&
+			quaternion_error(q, decompressed) < 0.0001f;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_frame_delta_test_delta_round_trip()
+{
+	UNIT_TEST_BEGIN("delta round trip")
+		ControllerDataFrameDeltaEncoder encoder;
+		ControllerDataFrameDeltaDecoder decoder;
+		t_controller_data_packet packets[4];
+		t_controller_data_packet encoded;
+
+		make_psmove_packet(1, 0x0, 10.f, 0.3f, packets[0]);
+		// Only the buttons changed
+		make_psmove_packet(2, 0x5, 10.f, 0.3f, packets[1]);
+		// Only the pose changed
+		make_psmove_packet(3, 0x0, 10.37f, 0.45f, packets[2]);
+		// Both changed, plus the trigger
+		make_psmove_packet(4, 0x9, -3.21f, 1.2f, packets[3]);
+		packets[3].mutable_psmove_state()->set_trigger_value(200);
+
+		const t_controller_data_packet::DeltaFrameType k_expected_types[4] = {
+			t_controller_data_packet::KEYFRAME,
+			t_controller_data_packet::DELTA_FRAME,
+			t_controller_data_packet::DELTA_FRAME,
+			t_controller_data_packet::DELTA_FRAME
+		};
+
+		success = true;
+		for (int packet_index = 0; success && packet_index < 4; ++packet_index)
+		{
+			encode_packet(encoder, packets[packet_index], encoded);
+			success = encoded.delta_frame_type() == k_expected_types[packet_index];
+			assert(success);
+
+			if (success)
+			{
+				const ControllerDataFrameDeltaDecoder::eDecodeResult result = decoder.decode(encoded);
+
+				success =
+					result == ((packet_index == 0)
+						? ControllerDataFrameDeltaDecoder::decodeFullFrame
+						: ControllerDataFrameDeltaDecoder::decodeRebuiltFrame) &&
+					is_decoded_packet_equal(packets[packet_index], get_decoded_packet(decoder, result, encoded));
+				assert(success);
+			}
+
+			// The buttons live outside the device state, so that delta carries no state at all
+			if (success && packet_index == 1)
+			{
+				success = encoded.changed_state_fields() == 0 && !encoded.has_compressed_pose();
+				assert(success);
+			}
+
+			// Any pose change sends the whole pose compressed instead of the full fields
+			if (success && packet_index >= 2)
+			{
+				success =
+					encoded.has_compressed_pose() &&
+					!encoded.psmove_state().has_position_cm() &&
+					!encoded.psmove_state().has_orientation();
+				assert(success);
+			}
+		}
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_frame_delta_test_field_cleared()
+{
+	UNIT_TEST_BEGIN("field cleared")
+		ControllerDataFrameDeltaEncoder encoder;
+		ControllerDataFrameDeltaDecoder decoder;
+		t_controller_data_packet keyframe;
+		t_controller_data_packet delta;
+		t_controller_data_packet encoded;
+
+		make_psmove_packet(1, 0x0, 10.f, 0.3f, keyframe);
+		keyframe.mutable_psmove_state()->mutable_raw_tracker_data()->set_tracker_id(2);
+		keyframe.mutable_psmove_state()->mutable_raw_tracker_data()->set_valid_tracker_bitmask(0x4);
+		// Same state without the tracker data, e.g. the controller went out of view
+		make_psmove_packet(2, 0x0, 10.f, 0.3f, delta);
+
+		encode_packet(encoder, keyframe, encoded);
+		success = decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeFullFrame;
+		assert(success);
+
+		if (success)
+		{
+			encode_packet(encoder, delta, encoded);
+			success =
+				encoded.delta_frame_type() == t_controller_data_packet::DELTA_FRAME &&
+				decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeRebuiltFrame &&
+				!decoder.getRebuiltPacket().psmove_state().has_raw_tracker_data() &&
+				is_decoded_packet_equal(delta, decoder.getRebuiltPacket());
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_frame_delta_test_missing_keyframe()
+{
+	UNIT_TEST_BEGIN("missing keyframe")
+		ControllerDataFrameDeltaEncoder encoder;
+		ControllerDataFrameDeltaDecoder decoder;
+		t_controller_data_packet packet;
+		t_controller_data_packet encoded;
+
+		// The keyframe never reaches the client
+		make_psmove_packet(1, 0x0, 10.f, 0.3f, packet);
+		encode_packet(encoder, packet, encoded);
+
+		make_psmove_packet(2, 0x1, 10.f, 0.3f, packet);
+		encode_packet(encoder, packet, encoded);
+		success = decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeMissingKeyframe;
+		assert(success);
+
+		// Asked for once, later deltas of the same keyframe are only dropped
+		if (success)
+		{
+			make_psmove_packet(3, 0x2, 10.f, 0.3f, packet);
+			encode_packet(encoder, packet, encoded);
+			success = decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeDroppedFrame;
+			assert(success);
+		}
+
+		// The requested keyframe gets the stream going again
+		if (success)
+		{
+			encoder.requestKeyframe();
+			make_psmove_packet(4, 0x2, 10.f, 0.3f, packet);
+			encode_packet(encoder, packet, encoded);
+			success = decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeFullFrame;
+			assert(success);
+
+			make_psmove_packet(5, 0x3, 10.f, 0.3f, packet);
+			encode_packet(encoder, packet, encoded);
+			success &= decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeRebuiltFrame;
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_frame_delta_test_late_frames()
+{
+	UNIT_TEST_BEGIN("late frames")
+		ControllerDataFrameDeltaEncoder encoder;
+		ControllerDataFrameDeltaDecoder decoder;
+		t_controller_data_packet packet;
+		t_controller_data_packet old_keyframe;
+		t_controller_data_packet old_delta;
+		t_controller_data_packet encoded;
+
+		make_psmove_packet(1, 0x0, 10.f, 0.3f, packet);
+		encode_packet(encoder, packet, old_keyframe);
+		make_psmove_packet(2, 0x1, 10.f, 0.3f, packet);
+		encode_packet(encoder, packet, old_delta);
+
+		encoder.requestKeyframe();
+		make_psmove_packet(3, 0x0, 12.f, 0.5f, packet);
+		encode_packet(encoder, packet, encoded);
+
+		// The newer keyframe arrives first
+		success = decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeFullFrame;
+		assert(success);
+
+		// The older keyframe and its delta frame show up after it
+		if (success)
+		{
+			success =
+				decoder.decode(old_keyframe) == ControllerDataFrameDeltaDecoder::decodeDroppedFrame &&
+				decoder.decode(old_delta) == ControllerDataFrameDeltaDecoder::decodeDroppedFrame;
+			assert(success);
+		}
+
+		// Neither replaced the keyframe the stream goes on from
+		if (success)
+		{
+			make_psmove_packet(4, 0x2, 12.f, 0.5f, packet);
+			encode_packet(encoder, packet, encoded);
+
+			const ControllerDataFrameDeltaDecoder::eDecodeResult result = decoder.decode(encoded);
+			success =
+				result == ControllerDataFrameDeltaDecoder::decodeRebuiltFrame &&
+				is_decoded_packet_equal(packet, decoder.getRebuiltPacket());
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_frame_delta_test_sequence_num_wrap()
+{
+	UNIT_TEST_BEGIN("sequence num wrap")
+		ControllerDataFrameDeltaEncoder encoder;
+		ControllerDataFrameDeltaDecoder decoder;
+		t_controller_data_packet packet;
+		t_controller_data_packet encoded;
+		t_controller_data_packet stale_keyframe;
+
+		make_psmove_packet(INT_MAX - 1, 0x0, 10.f, 0.3f, packet);
+		encode_packet(encoder, packet, stale_keyframe);
+
+		encoder.requestKeyframe();
+		make_psmove_packet(INT_MAX, 0x0, 10.f, 0.3f, packet);
+		encode_packet(encoder, packet, encoded);
+		success = decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeFullFrame;
+		assert(success);
+
+		// INT_MIN comes right after INT_MAX
+		if (success)
+		{
+			encoder.requestKeyframe();
+			make_psmove_packet(INT_MIN, 0x1, 11.f, 0.4f, packet);
+			encode_packet(encoder, packet, encoded);
+			success = decoder.decode(encoded) == ControllerDataFrameDeltaDecoder::decodeFullFrame;
+			assert(success);
+		}
+
+		if (success)
+		{
+			make_psmove_packet(INT_MIN + 1, 0x2, 11.f, 0.4f, packet);
+			encode_packet(encoder, packet, encoded);
+
+			const ControllerDataFrameDeltaDecoder::eDecodeResult result = decoder.decode(encoded);
+			success =
+				result == ControllerDataFrameDeltaDecoder::decodeRebuiltFrame &&
+				is_decoded_packet_equal(packet, decoder.getRebuiltPacket());
+			assert(success);
+		}
+
+		// And a keyframe from before the wrap is older than both
+		if (success)
+		{
+			success = decoder.decode(stale_keyframe) == ControllerDataFrameDeltaDecoder::decodeDroppedFrame;
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_frame_delta_test_keyframe_request()
+{
+	UNIT_TEST_BEGIN("keyframe request")
+		ControllerDataFrameDeltaEncoder encoder;
+		t_controller_data_packet packet;
+		t_controller_data_packet encoded;
+		int sequence_num = 1;
+
+		make_psmove_packet(sequence_num++, 0x0, 10.f, 0.3f, packet);
+		encode_packet(encoder, packet, encoded);
+		success = encoded.delta_frame_type() == t_controller_data_packet::KEYFRAME;
+		assert(success);
+
+		if (success)
+		{
+			make_psmove_packet(sequence_num++, 0x1, 10.f, 0.3f, packet);
+			encode_packet(encoder, packet, encoded);
+			success = encoded.delta_frame_type() == t_controller_data_packet::DELTA_FRAME;
+			assert(success);
+		}
+
+		// A requested keyframe goes out on the very next packet
+		if (success)
+		{
+			encoder.requestKeyframe();
+			make_psmove_packet(sequence_num, 0x1, 10.f, 0.3f, packet);
+			encode_packet(encoder, packet, encoded);
+			success =
+				encoded.delta_frame_type() == t_controller_data_packet::KEYFRAME &&
+				encoded.keyframe_sequence_num() == sequence_num;
+			assert(success);
+			++sequence_num;
+		}
+
+		// Without a request one goes out every DATA_FRAME_DELTA_KEYFRAME_INTERVAL packets
+		for (int packet_index = 1; success && packet_index <= DATA_FRAME_DELTA_KEYFRAME_INTERVAL; ++packet_index)
+		{
+			make_psmove_packet(sequence_num++, 0x1, 10.f, 0.3f, packet);
+			encode_packet(encoder, packet, encoded);
+
+			success = encoded.delta_frame_type() == ((packet_index == DATA_FRAME_DELTA_KEYFRAME_INTERVAL)
+				? t_controller_data_packet::KEYFRAME
+				: t_controller_data_packet::DELTA_FRAME);
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,141 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "DataStreamFilter.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_data_stream_filter_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("data_stream_filter")
+		UNIT_TEST_MODULE_CALL_TEST(data_stream_filter_test_unlimited);
+		UNIT_TEST_MODULE_CALL_TEST(data_stream_filter_test_rate_limit);
+		UNIT_TEST_MODULE_CALL_TEST(data_stream_filter_test_deadband);
+		UNIT_TEST_MODULE_CALL_TEST(data_stream_filter_test_discrete_state_changes);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+static const float k_identity_orientation[4] = { 1.f, 0.f, 0.f, 0.f };
+static const float k_origin[3] = { 0.f, 0.f, 0.f };
+
+static DataStreamFilter::t_timestamp make_test_time(const int update_index, const float update_rate_hz)
+{
+	return DataStreamFilter::t_timestamp() +
+		std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+			std::chrono::duration<float>(static_cast<float>(update_index) / update_rate_hz));
+}
+
+bool
+data_stream_filter_test_unlimited()
+{
+	UNIT_TEST_BEGIN("unlimited")
+		DataStreamFilter filter;
+		int sent_count = 0;
+
+		for (int update_index = 0; update_index < 120; ++update_index)
+		{
+			if (filter.filterUpdate(make_test_time(update_index, 120.f), k_origin, k_identity_orientation, 0))
+			{
+				++sent_count;
+			}
+		}
+
+		success = sent_count == 120;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_stream_filter_test_rate_limit()
+{
+	UNIT_TEST_BEGIN("rate limit")
+		DataStreamLimits limits;
+		limits.clear();
+		limits.max_rate_hz = 10.f;
+
+		DataStreamFilter filter;
+		filter.setLimits(limits);
+
+		// Two seconds of a moving controller updating at 120Hz
+		int sent_count = 0;
+		for (int update_index = 0; update_index < 240; ++update_index)
+		{
+			const float position_cm[3] = { static_cast<float>(update_index), 0.f, 0.f };
+
+			if (filter.filterUpdate(make_test_time(update_index, 120.f), position_cm, k_identity_orientation, 0))
+			{
+				++sent_count;
+			}
+		}
+
+		success = sent_count >= 19 && sent_count <= 21;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_stream_filter_test_deadband()
+{
+	UNIT_TEST_BEGIN("deadband")
+		DataStreamLimits limits;
+		limits.clear();
+		limits.position_deadband_cm = 1.f;
+		limits.orientation_deadband_degrees = 2.f;
+
+		DataStreamFilter filter;
+		filter.setLimits(limits);
+
+		// The first update always goes out
+		success = filter.filterUpdate(make_test_time(0, 120.f), k_origin, k_identity_orientation, 0);
+
+		// Jitter inside the deadband doesn't
+		const float jitter_cm[3] = { 0.3f, -0.2f, 0.1f };
+		success &= !filter.filterUpdate(make_test_time(1, 120.f), jitter_cm, k_identity_orientation, 0);
+
+		// Moving out of it does
+		const float moved_cm[3] = { 1.5f, 0.f, 0.f };
+		success &= filter.filterUpdate(make_test_time(2, 120.f), moved_cm, k_identity_orientation, 0);
+
+		// So does turning past the orientation deadband (3 degrees about z), -q being the same rotation as q
+		const float half_angle = 1.5f / k_data_stream_radians_to_degrees;
+		const float turned[4] = { -cosf(half_angle), 0.f, 0.f, -sinf(half_angle) };
+		const float barely_turned[4] = { -cosf(half_angle * 1.2f), 0.f, 0.f, -sinf(half_angle * 1.2f) };
+		success &= filter.filterUpdate(make_test_time(3, 120.f), moved_cm, turned, 0);
+		success &= !filter.filterUpdate(make_test_time(4, 120.f), moved_cm, barely_turned, 0);
+
+		// A pose that stays put still gets a keep alive frame
+		success &= filter.filterUpdate(make_test_time(3 + 121, 120.f), moved_cm, turned, 0);
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+data_stream_filter_test_discrete_state_changes()
+{
+	UNIT_TEST_BEGIN("discrete state changes")
+		DataStreamLimits limits;
+		limits.clear();
+		limits.max_rate_hz = 1.f;
+		limits.position_deadband_cm = 10.f;
+
+		DataStreamFilter filter;
+		filter.setLimits(limits);
+
+		success = filter.filterUpdate(make_test_time(0, 120.f), k_origin, k_identity_orientation, 0);
+		success &= !filter.filterUpdate(make_test_time(1, 120.f), k_origin, k_identity_orientation, 0);
+
+		// A button press and its release go out right away despite the rate limit
+		success &= filter.filterUpdate(make_test_time(2, 120.f), k_origin, k_identity_orientation, 0x4);
+		success &= !filter.filterUpdate(make_test_time(3, 120.f), k_origin, k_identity_orientation, 0x4);
+		success &= filter.filterUpdate(make_test_time(4, 120.f), k_origin, k_identity_orientation, 0);
+
+		// Clearing the limits sends everything again
+		filter.setLimits(DataStreamLimits());
+		success &= filter.filterUpdate(make_test_time(5, 120.f), k_origin, k_identity_orientation, 0);
+		success &= filter.filterUpdate(make_test_time(6, 120.f), k_origin, k_identity_orientation, 0);
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
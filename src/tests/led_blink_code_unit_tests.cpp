@@ -0,0 +1,142 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <chrono>
+
+#include "LEDBlinkCode.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_led_blink_code_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("led_blink_code")
+		UNIT_TEST_MODULE_CALL_TEST(led_blink_code_test_timing);
+		UNIT_TEST_MODULE_CALL_TEST(led_blink_code_test_identify_shared_color);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> t_timestamp;
+
+static t_timestamp make_timestamp(const t_timestamp &epoch, float milliseconds)
+{
+	return epoch + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+		std::chrono::duration<float, std::milli>(milliseconds));
+}
+
+bool
+led_blink_code_test_timing()
+{
+	UNIT_TEST_BEGIN("timing")
+
+	LEDBlinkCodeTiming timing;
+	timing.epoch = t_timestamp();
+	timing.slot_count = 4;
+	timing.bit_duration_ms = 100.f;
+	timing.led_latency_ms = 30.f;
+
+	// Commanded slots cycle every slot_count bits
+	success =
+		timing.computeCommandedDarkSlot(make_timestamp(timing.epoch, 50.f)) == 0 &&
+		timing.computeCommandedDarkSlot(make_timestamp(timing.epoch, 150.f)) == 1 &&
+		timing.computeCommandedDarkSlot(make_timestamp(timing.epoch, 350.f)) == 3 &&
+		timing.computeCommandedDarkSlot(make_timestamp(timing.epoch, 450.f)) == 0;
+	assert(success);
+
+	// Observed slots lag by the LED latency and skip frames near the bit boundaries
+	if (success)
+	{
+		success =
+			timing.computeObservedDarkSlot(make_timestamp(timing.epoch, 180.f)) == 1 &&
+			timing.computeObservedDarkSlot(make_timestamp(timing.epoch, 100.f)) == 0 &&
+			timing.computeObservedDarkSlot(make_timestamp(timing.epoch, 135.f)) == -1 &&
+			timing.computeObservedDarkSlot(make_timestamp(timing.epoch, 125.f)) == -1;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+led_blink_code_test_identify_shared_color()
+{
+	UNIT_TEST_BEGIN("identify_shared_color")
+
+	const int k_controller_count = 3;
+	const int k_slots[k_controller_count] = { 0, 1, 2 };
+	const float k_frame_interval_ms = 1000.f / 60.f;
+	const int k_frame_count = 360; // six seconds
+	const float k_bulb_radius_px = 12.f;
+
+	LEDBlinkCodeTiming timing;
+	timing.epoch = t_timestamp();
+	timing.slot_count = 4;
+	timing.bit_duration_ms = 250.f;
+	timing.led_latency_ms = 70.f;
+
+	LEDBlinkCodeIdentifier identifier;
+	unsigned int random_state = 12345;
+	int wrong_slot_count = 0;
+	int identified_count = 0;
+	int last_frame_identified_count = 0;
+
+	for (int frame_index = 0; frame_index < k_frame_count; ++frame_index)
+	{
+		const float frame_ms = 1000.f + frame_index*k_frame_interval_ms;
+		LEDBlinkCodeBlob blobs[k_controller_count];
+		int blob_controllers[k_controller_count];
+		int blob_count = 0;
+
+		for (int controller_index = 0; controller_index < k_controller_count; ++controller_index)
+		{
+			// Each LED write lands 10-130ms after it was commanded
+			random_state = random_state*1103515245u + 12345u;
+			const float latency_ms = 10.f + static_cast<float>((random_state >> 16) % 120);
+			const int commanded_slot = timing.computeCommandedDarkSlot(make_timestamp(timing.epoch, frame_ms - latency_ms));
+
+			if (commanded_slot != k_slots[controller_index])
+			{
+				// Bulbs drift slowly around their own spot in the frame
+				const float angle = frame_ms*0.001f + controller_index;
+				blobs[blob_count].center = Eigen::Vector2f(
+					120.f + 180.f*controller_index + 20.f*cosf(angle),
+					240.f + 20.f*sinf(angle));
+				blobs[blob_count].radius = k_bulb_radius_px;
+				blob_controllers[blob_count] = controller_index;
+				++blob_count;
+			}
+		}
+
+		int blob_slots[k_controller_count];
+		identifier.addFrame(timing, make_timestamp(timing.epoch, frame_ms), blobs, blob_count, blob_slots);
+
+		last_frame_identified_count = 0;
+		for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+		{
+			if (blob_slots[blob_index] != -1)
+			{
+				++identified_count;
+				++last_frame_identified_count;
+
+				if (blob_slots[blob_index] != k_slots[blob_controllers[blob_index]])
+				{
+					++wrong_slot_count;
+				}
+			}
+		}
+	}
+
+	// Never mistakes one controller for another, and knows every lit bulb by the end
+	success = wrong_slot_count == 0 && identified_count > 0 && identifier.getTrackCount() == k_controller_count;
+	assert(success);
+
+	if (success)
+	{
+		success = last_frame_identified_count >= k_controller_count - 1;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
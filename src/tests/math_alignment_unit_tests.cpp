@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <chrono>
 
 #include "MathAlignment.h"
 #include "MathUtility.h"
@@ -12,6 +13,13 @@ bool run_math_alignment_unit_tests()
 {
 	UNIT_TEST_MODULE_BEGIN("math_alignment")
 		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_best_fit_exponential);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_robust_focal_cone_to_sphere);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_soft_posit);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_bundle_adjustment);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_refine_camera_pose);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_streaming_ellipsoid_fit);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_streaming_ellipsoid_restart);
+		UNIT_TEST_MODULE_CALL_TEST(math_alignment_test_streaming_ellipsoid_timing);
 	UNIT_TEST_MODULE_END()
 }
 
@@ -46,4 +54,587 @@ math_alignment_test_best_fit_exponential()
 	assert(success);	
 	
 	UNIT_TEST_COMPLETE()
-}
\ No newline at end of file
+}
+
+bool
+math_alignment_test_robust_focal_cone_to_sphere()
+{
+	UNIT_TEST_BEGIN("robust focal cone to sphere")
+
+	// A 2.25cm radius bulb about 2.5m from the camera, in normalized image space (focal length= 1)
+	const float k_radius = 2.25f;
+	Eigen::Vector3f true_center(20.f, -12.f, 250.f);
+
+	// Project the sphere silhouette onto the image plane
+	const float k = 1.f - (k_radius*k_radius) / true_center.squaredNorm();
+	EigenFitEllipse silhouette;
+	eigen_alignment_project_ellipse(&true_center, k, 1.f, 1.f, &silhouette);
+
+	const int k_point_count = 32;
+	Eigen::Vector2f points[k_point_count];
+	float weights[k_point_count];
+	const Eigen::Vector2f basis_x(cosf(silhouette.angle), sinf(silhouette.angle));
+	const Eigen::Vector2f basis_y(-basis_x.y(), basis_x.x());
+	for (int point_index = 0; point_index < k_point_count; ++point_index)
+	{
+		const float phi = k_real_two_pi * static_cast<float>(point_index) / static_cast<float>(k_point_count);
+
+		points[point_index] =
+			silhouette.center
+			+ basis_x*(silhouette.extents.x()*cosf(phi))
+			+ basis_y*(silhouette.extents.y()*sinf(phi));
+		weights[point_index] = 1.f;
+	}
+
+	// Clean points should reproduce the sphere
+	Eigen::Vector3f fit_center;
+	success = eigen_alignment_fit_focal_cone_to_sphere_robust(points, weights, k_point_count, k_radius, 1.f, 5, &fit_center);
+	assert(success);
+	if (success)
+	{
+		success = (fit_center - true_center).norm() < 0.5f;
+		assert(success);
+	}
+
+	// Push a few edge points well outside the silhouette (e.g. a reflection touching the bulb)
+	for (int point_index = 0; point_index < 3; ++point_index)
+	{
+		points[point_index] = silhouette.center + (points[point_index] - silhouette.center)*1.5f;
+	}
+
+	Eigen::Vector3f plain_center;
+	eigen_alignment_fit_focal_cone_to_sphere(points, k_point_count, k_radius, 1.f, &plain_center);
+
+	if (success)
+	{
+		success = eigen_alignment_fit_focal_cone_to_sphere_robust(points, weights, k_point_count, k_radius, 1.f, 10, &fit_center);
+		assert(success);
+	}
+	if (success)
+	{
+		// The re-weighted fit should land closer to the truth than the plain least squares fit
+		success = (fit_center - true_center).norm() < (plain_center - true_center).norm();
+		assert(success);
+	}
+
+	// Zero weights on the outliers should remove them entirely
+	if (success)
+	{
+		for (int point_index = 0; point_index < 3; ++point_index)
+		{
+			weights[point_index] = 0.f;
+		}
+
+		success = eigen_alignment_fit_focal_cone_to_sphere_robust(points, weights, k_point_count, k_radius, 1.f, 0, &fit_center);
+		assert(success);
+	}
+	if (success)
+	{
+		success = (fit_center - true_center).norm() < 0.5f;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+math_alignment_test_soft_posit()
+{
+	UNIT_TEST_BEGIN("soft_posit")
+
+	// The Morpheus LED layout (cm) and the direction each LED faces
+	const int k_model_point_count = 9;
+	const Eigen::Vector3f model_points[k_model_point_count] = {
+		Eigen::Vector3f(0.f, 0.f, 0.f),
+		Eigen::Vector3f(8.f, 4.5f, -2.5f),
+		Eigen::Vector3f(9.f, 0.f, -10.f),
+		Eigen::Vector3f(8.f, -4.5f, -2.5f),
+		Eigen::Vector3f(-8.f, 4.5f, -2.5f),
+		Eigen::Vector3f(-9.f, 0.f, -10.f),
+		Eigen::Vector3f(-8.f, -4.5f, -2.5f),
+		Eigen::Vector3f(6.f, -1.f, -24.f),
+		Eigen::Vector3f(-6.f, -1.f, -24.f)
+	};
+	const Eigen::Vector3f model_normals[k_model_point_count] = {
+		Eigen::Vector3f(0.f, 0.f, 1.f),
+		Eigen::Vector3f(0.f, 0.f, 1.f),
+		Eigen::Vector3f(1.f, 0.f, 0.f),
+		Eigen::Vector3f(0.f, 0.f, 1.f),
+		Eigen::Vector3f(0.f, 0.f, 1.f),
+		Eigen::Vector3f(-1.f, 0.f, 0.f),
+		Eigen::Vector3f(0.f, 0.f, 1.f),
+		Eigen::Vector3f(0.f, 0.f, -1.f),
+		Eigen::Vector3f(0.f, 0.f, -1.f)
+	};
+
+	// Headset 1.5m away, roughly facing the camera
+	const float k_focal_length = 550.f;
+	const Eigen::Quaternionf true_orientation = 
+		Eigen::AngleAxisf(160.f*k_degrees_to_radians, Eigen::Vector3f::UnitY()) *
+		Eigen::AngleAxisf(10.f*k_degrees_to_radians, Eigen::Vector3f::UnitX());
+	const Eigen::Vector3f true_position(10.f, -5.f, 150.f);
+
+	// Only the front 5 LEDs and the right side LED face the camera.
+	// Shuffle them, add some noise and a stray reflection
+	const int visible_model_indices[] = {3, 0, 6, 1, 4, 2};
+	const float noise[] = {0.4f, -0.3f, 0.2f, -0.5f, 0.3f, -0.2f};
+	const int k_image_point_count = 7;
+	Eigen::Vector2f image_points[k_image_point_count];
+	for (int image_index = 0; image_index < 6; ++image_index)
+	{
+		const Eigen::Vector3f camera_point = 
+			true_orientation * model_points[visible_model_indices[image_index]] + true_position;
+
+		image_points[image_index] = 
+			Eigen::Vector2f(k_focal_length*camera_point.x() / camera_point.z() + noise[image_index],
+							k_focal_length*camera_point.y() / camera_point.z() - noise[image_index]);
+	}
+	image_points[6] = Eigen::Vector2f(120.f, 80.f);
+
+	// Seeded with a prediction a few degrees and centimeters off
+	const Eigen::Quaternionf guess_orientation = 
+		true_orientation * Eigen::Quaternionf(Eigen::AngleAxisf(8.f*k_degrees_to_radians, Eigen::Vector3f(1.f, 1.f, 0.f).normalized()));
+	const Eigen::Vector3f guess_position = true_position + Eigen::Vector3f(3.f, -2.f, 6.f);
+
+	Eigen::Quaternionf orientation;
+	Eigen::Vector3f position;
+	int correspondences[k_image_point_count];
+	success = 
+		eigen_alignment_soft_posit(
+			model_points, model_normals, k_model_point_count, 
+			image_points, k_image_point_count,
+			k_focal_length, 1.f,
+			&guess_orientation, &guess_position,
+			200,
+			&orientation, &position, correspondences);
+	assert(success);
+
+	if (success)
+	{
+		success = (position - true_position).norm() < 2.f && orientation.angularDistance(true_orientation) < 2.f*k_degrees_to_radians;
+		assert(success);
+	}
+	if (success)
+	{
+		for (int image_index = 0; success && image_index < 6; ++image_index)
+		{
+			success = correspondences[image_index] == visible_model_indices[image_index];
+		}
+		success = success && correspondences[6] == -1;
+		assert(success);
+	}
+
+	// No guess at all, the canned starts should still find it
+	if (success)
+	{
+		success = 
+			eigen_alignment_soft_posit(
+				model_points, model_normals, k_model_point_count, 
+				image_points, k_image_point_count,
+				k_focal_length, 1.f,
+				nullptr, nullptr,
+				800,
+				&orientation, &position);
+		assert(success);
+	}
+	if (success)
+	{
+		success = (position - true_position).norm() < 2.f && orientation.angularDistance(true_orientation) < 2.f*k_degrees_to_radians;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+math_alignment_test_bundle_adjustment()
+{
+	UNIT_TEST_BEGIN("bundle_adjustment")
+
+	// Four cameras on a 1.5m ring, all looking at a bulb waved around the origin
+	const int k_camera_count = 4;
+	const int k_point_count = 150;
+	const float k_focal_length = 554.f;
+	EigenBundleAdjustmentCamera true_cameras[k_camera_count];
+	for (int camera_index = 0; camera_index < k_camera_count; ++camera_index)
+	{
+		const float angle = k_real_two_pi * (0.125f + 0.25f * static_cast<float>(camera_index) / 3.f);
+		const Eigen::Vector3f position(150.f*cosf(angle), 30.f, 150.f*sinf(angle));
+		const Eigen::Vector3f forward = -position.normalized();
+		const Eigen::Vector3f right = Eigen::Vector3f::UnitY().cross(forward).normalized();
+		Eigen::Matrix3f rotation;
+		rotation << right, forward.cross(right), forward;
+
+		true_cameras[camera_index].orientation = Eigen::Quaternionf(rotation);
+		true_cameras[camera_index].position = position;
+		true_cameras[camera_index].focal_length_x = k_focal_length;
+		true_cameras[camera_index].focal_length_y = k_focal_length;
+		true_cameras[camera_index].principal_x = 320.f;
+		true_cameras[camera_index].principal_y = 240.f;
+	}
+
+	// Every camera sees every point, with a little noise
+	const int k_outlier_count = 3;
+	const int k_observation_count = k_camera_count*k_point_count + k_outlier_count;
+	EigenBundleAdjustmentObservation observations[k_observation_count];
+	unsigned int seed = 12345;
+	int observation_count = 0;
+	for (int point_index = 0; point_index < k_point_count; ++point_index)
+	{
+		Eigen::Vector3f point;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			seed = seed*1103515245 + 12345;
+			point[axis] = (static_cast<float>((seed >> 16) & 0x7fff) / 32767.f - 0.5f)*60.f;
+		}
+
+		for (int camera_index = 0; camera_index < k_camera_count; ++camera_index)
+		{
+			const EigenBundleAdjustmentCamera &camera = true_cameras[camera_index];
+			const Eigen::Vector3f p = camera.orientation.conjugate() * (point - camera.position);
+			const float noise = 0.2f*static_cast<float>((point_index + camera_index) % 5 - 2) / 2.f;
+
+			EigenBundleAdjustmentObservation &observation = observations[observation_count++];
+			observation.camera_index = camera_index;
+			observation.point_index = point_index;
+			observation.pixel = Eigen::Vector2f(
+				camera.principal_x + camera.focal_length_x*p.x() / p.z() + noise,
+				camera.principal_y - camera.focal_length_y*p.y() / p.z() - noise);
+		}
+	}
+
+	// A few blobs that weren't the bulb
+	for (int outlier_index = 0; outlier_index < k_outlier_count; ++outlier_index)
+	{
+		observations[observation_count] = observations[outlier_index*7];
+		observations[observation_count].pixel += Eigen::Vector2f(25.f, -15.f);
+		++observation_count;
+	}
+
+	// Knock all but the first camera a few degrees and centimeters off
+	EigenBundleAdjustmentCamera cameras[k_camera_count];
+	for (int camera_index = 0; camera_index < k_camera_count; ++camera_index)
+	{
+		cameras[camera_index] = true_cameras[camera_index];
+
+		if (camera_index > 0)
+		{
+			const Eigen::Vector3f axis = Eigen::Vector3f(1.f, static_cast<float>(camera_index), -1.f).normalized();
+
+			cameras[camera_index].orientation =
+				cameras[camera_index].orientation * Eigen::Quaternionf(Eigen::AngleAxisf(1.5f*k_degrees_to_radians, axis));
+			cameras[camera_index].position += Eigen::Vector3f(2.f, -1.5f, 2.5f)*(camera_index % 2 == 0 ? 1.f : -1.f);
+		}
+	}
+
+	EigenBundleAdjustmentResult result;
+	float initial_camera_rms[k_camera_count];
+	float final_camera_rms[k_camera_count];
+	success =
+		eigen_alignment_bundle_adjust_cameras(
+			cameras, k_camera_count,
+			observations, observation_count, k_point_count,
+			false, 50,
+			&result, initial_camera_rms, final_camera_rms);
+	assert(success);
+
+	if (success)
+	{
+		success =
+			result.point_count == k_point_count &&
+			result.initial_rms_px > 3.f &&
+			result.final_rms_px < result.initial_rms_px;
+		assert(success);
+	}
+	if (success)
+	{
+		// Every camera should agree with the points again, give or take its one outlier
+		for (int camera_index = 0; success && camera_index < k_camera_count; ++camera_index)
+		{
+			success = final_camera_rms[camera_index] < initial_camera_rms[camera_index] || camera_index == 0;
+			success = success && final_camera_rms[camera_index] < 3.f;
+		}
+		assert(success);
+	}
+	if (success)
+	{
+		// The gauge can move the whole rig a little, but the cameras relative to each other
+		// should be back where they belong
+		for (int camera_index = 1; success && camera_index < k_camera_count; ++camera_index)
+		{
+			const Eigen::Quaternionf relative = cameras[0].orientation.conjugate() * cameras[camera_index].orientation;
+			const Eigen::Quaternionf true_relative = true_cameras[0].orientation.conjugate() * true_cameras[camera_index].orientation;
+			const float true_baseline = (true_cameras[camera_index].position - true_cameras[0].position).norm();
+			const float baseline = (cameras[camera_index].position - cameras[0].position).norm();
+
+			success =
+				relative.angularDistance(true_relative) < 0.25f*k_degrees_to_radians &&
+				fabsf(baseline - true_baseline) < 1.5f;
+		}
+		assert(success);
+	}
+
+	// A focal length that is a few percent off should come most of the way back
+	// (from a bulb waved this close to the origin the focal length trades off against the camera distance)
+	if (success)
+	{
+		for (int camera_index = 0; camera_index < k_camera_count; ++camera_index)
+		{
+			cameras[camera_index] = true_cameras[camera_index];
+		}
+		cameras[1].focal_length_x += 15.f;
+		cameras[1].focal_length_y += 15.f;
+
+		success =
+			eigen_alignment_bundle_adjust_cameras(
+				cameras, k_camera_count,
+				observations, observation_count, k_point_count,
+				true, 50,
+				&result);
+		assert(success);
+	}
+	if (success)
+	{
+		success =
+			result.final_rms_px < result.initial_rms_px &&
+			fabsf(cameras[1].focal_length_x - k_focal_length) < 7.5f;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+math_alignment_test_refine_camera_pose()
+{
+	UNIT_TEST_BEGIN("refine_camera_pose")
+
+	// A camera 1.5m out looking back at the origin
+	EigenBundleAdjustmentCamera true_camera;
+	true_camera.position = Eigen::Vector3f(0.f, 30.f, 150.f);
+	true_camera.orientation =
+		Eigen::Quaternionf(Eigen::AngleAxisf(k_real_pi, Eigen::Vector3f::UnitY())) *
+		Eigen::Quaternionf(Eigen::AngleAxisf(-11.f*k_degrees_to_radians, Eigen::Vector3f::UnitX()));
+	true_camera.focal_length_x = 554.f;
+	true_camera.focal_length_y = 554.f;
+	true_camera.principal_x = 320.f;
+	true_camera.principal_y = 240.f;
+
+	// Bulb positions known from the other cameras, seen with a little noise
+	const int k_point_count = 60;
+	Eigen::Vector3f world_points[k_point_count];
+	Eigen::Vector2f pixels[k_point_count];
+	unsigned int seed = 4321;
+	for (int point_index = 0; point_index < k_point_count; ++point_index)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			seed = seed*1103515245 + 12345;
+			world_points[point_index][axis] = (static_cast<float>((seed >> 16) & 0x7fff) / 32767.f - 0.5f)*60.f;
+		}
+
+		const Eigen::Vector3f p = true_camera.orientation.conjugate() * (world_points[point_index] - true_camera.position);
+		const float noise = 0.1f*static_cast<float>(point_index % 5 - 2);
+
+		pixels[point_index] = Eigen::Vector2f(
+			true_camera.principal_x + true_camera.focal_length_x*p.x() / p.z() + noise,
+			true_camera.principal_y - true_camera.focal_length_y*p.y() / p.z() - noise);
+	}
+
+	// The camera got bumped
+	EigenBundleAdjustmentCamera camera = true_camera;
+	camera.orientation =
+		camera.orientation * Eigen::Quaternionf(Eigen::AngleAxisf(2.f*k_degrees_to_radians, Eigen::Vector3f(0.f, 1.f, 1.f).normalized()));
+	camera.position += Eigen::Vector3f(1.5f, -1.f, 2.f);
+
+	float initial_rms_px, final_rms_px;
+	success = eigen_alignment_refine_camera_pose(&camera, world_points, pixels, k_point_count, 20, &initial_rms_px, &final_rms_px);
+	assert(success);
+
+	if (success)
+	{
+		success =
+			initial_rms_px > 10.f && final_rms_px < 0.5f &&
+			camera.orientation.angularDistance(true_camera.orientation) < 0.2f*k_degrees_to_radians &&
+			(camera.position - true_camera.position).norm() < 0.5f;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+math_alignment_test_streaming_ellipsoid_fit()
+{
+	UNIT_TEST_BEGIN("streaming_ellipsoid_fit")
+
+	// A tilted, offset magnetometer ellipsoid (raw sensor units) with noise and 5% outliers
+	const Eigen::Vector3f true_center(120.f, -40.f, 60.f);
+	const Eigen::Vector3f true_extents(300.f, 250.f, 200.f);
+	const Eigen::Matrix3f true_basis =
+		(Eigen::AngleAxisf(0.4f, Eigen::Vector3f::UnitZ()) * Eigen::AngleAxisf(-0.3f, Eigen::Vector3f::UnitX())).toRotationMatrix();
+	unsigned int seed = 2468;
+	auto random_unit = [&seed]() -> float {
+		seed = seed*1103515245 + 12345;
+		return static_cast<float>((seed >> 16) & 0x7fff) / 32767.f;
+	};
+
+	const int k_batch_count = 40;
+	const int k_batch_size = 50;
+	EigenStreamingEllipsoidFit fit;
+	fit.clear();
+
+	Eigen::Vector3f clean_points[k_batch_size];
+	for (int batch_index = 0; batch_index < k_batch_count; ++batch_index)
+	{
+		Eigen::Vector3f batch[k_batch_size];
+		for (int sample_index = 0; sample_index < k_batch_size; ++sample_index)
+		{
+			// Uniform direction on the unit sphere
+			const float z = 2.f*random_unit() - 1.f;
+			const float angle = k_real_two_pi*random_unit();
+			const float r = sqrtf(std::max(1.f - z*z, 0.f));
+			const Eigen::Vector3f direction(r*cosf(angle), r*sinf(angle), z);
+			const bool bOutlier = (batch_index*k_batch_size + sample_index) % 20 == 7;
+			const float radius = bOutlier ? (0.5f + 1.2f*random_unit()) : (1.f + 0.01f*(random_unit() - 0.5f));
+
+			batch[sample_index] = true_center + true_basis*(true_extents.cwiseProduct(direction)*radius);
+			clean_points[sample_index] = true_center + true_basis*true_extents.cwiseProduct(direction);
+		}
+
+		eigen_alignment_streaming_ellipsoid_add_samples(fit, batch, k_batch_size, 0.15f, 1.f);
+		eigen_alignment_streaming_ellipsoid_solve(fit);
+	}
+
+	success = fit.bHasFit && fit.rejected_count > 0;
+	assert(success);
+
+	if (success)
+	{
+		// Every true surface point has to map back onto the unit sphere
+		float max_radius_error = 0.f;
+		for (int sample_index = 0; sample_index < k_batch_size; ++sample_index)
+		{
+			const float radius = eigen_alignment_project_point_on_ellipsoid_basis(clean_points[sample_index], fit.ellipsoid).norm();
+			max_radius_error = std::max(max_radius_error, fabsf(radius - 1.f));
+		}
+
+		// The extents come back sorted by the eigen solver, compare them as a set
+		Eigen::Vector3f sorted_extents = fit.ellipsoid.extents;
+		std::sort(sorted_extents.data(), sorted_extents.data() + 3);
+
+		success =
+			(fit.ellipsoid.center - true_center).norm() < 5.f &&
+			fabsf(sorted_extents.x() - 200.f) < 6.f &&
+			fabsf(sorted_extents.y() - 250.f) < 7.5f &&
+			fabsf(sorted_extents.z() - 300.f) < 9.f &&
+			max_radius_error < 0.03f &&
+			fabsf(fit.ellipsoid.basis.determinant() - 1.f) < 1e-3f;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+math_alignment_test_streaming_ellipsoid_restart()
+{
+	UNIT_TEST_BEGIN("streaming_ellipsoid_restart")
+
+	// Background refinement: the controller moves to a spot with a different hard iron offset,
+	// the old fit rejects everything until it gives up and starts over on the new field
+	unsigned int seed = 1357;
+	auto random_unit = [&seed]() -> float {
+		seed = seed*1103515245 + 12345;
+		return static_cast<float>((seed >> 16) & 0x7fff) / 32767.f;
+	};
+
+	const Eigen::Vector3f centers[2] = {Eigen::Vector3f(0.f, 0.f, 0.f), Eigen::Vector3f(250.f, -150.f, 100.f)};
+	const Eigen::Vector3f extents(220.f, 200.f, 240.f);
+	EigenStreamingEllipsoidFit fit;
+	fit.clear();
+
+	for (int field_index = 0; field_index < 2; ++field_index)
+	{
+		for (int sample_index = 0; sample_index < 1000; ++sample_index)
+		{
+			const float z = 2.f*random_unit() - 1.f;
+			const float angle = k_real_two_pi*random_unit();
+			const float r = sqrtf(std::max(1.f - z*z, 0.f));
+			const Eigen::Vector3f point = centers[field_index] + extents.cwiseProduct(Eigen::Vector3f(r*cosf(angle), r*sinf(angle), z));
+
+			eigen_alignment_streaming_ellipsoid_add_samples(fit, &point, 1, 0.15f, 0.999f);
+			if (sample_index % 25 == 24)
+			{
+				eigen_alignment_streaming_ellipsoid_solve(fit);
+			}
+		}
+
+		success = fit.bHasFit && (fit.ellipsoid.center - centers[field_index]).norm() < 2.f;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+math_alignment_test_streaming_ellipsoid_timing()
+{
+	UNIT_TEST_BEGIN("streaming_ellipsoid_timing")
+
+	// The magnetometer calibration refits after every accepted sample, up to 500 of them
+	const int k_sample_count = 500;
+	Eigen::Vector3f points[k_sample_count];
+	unsigned int seed = 97531;
+	for (int sample_index = 0; sample_index < k_sample_count; ++sample_index)
+	{
+		Eigen::Vector3f direction;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			seed = seed*1103515245 + 12345;
+			direction[axis] = static_cast<float>((seed >> 16) & 0x7fff) / 32767.f - 0.5f;
+		}
+		direction.normalize();
+
+		points[sample_index] = Eigen::Vector3f(30.f, -20.f, 10.f) + Eigen::Vector3f(300.f, 250.f, 200.f).cwiseProduct(direction);
+	}
+
+	EigenFitEllipsoid least_squares_ellipsoid;
+	const auto least_squares_start = std::chrono::high_resolution_clock::now();
+	for (int sample_count = 1; sample_count <= k_sample_count; ++sample_count)
+	{
+		eigen_alignment_fit_least_squares_axis_aligned_ellipsoid(points, sample_count, least_squares_ellipsoid);
+	}
+	const auto least_squares_end = std::chrono::high_resolution_clock::now();
+
+	EigenFitEllipsoid min_volume_ellipsoid;
+	const auto min_volume_start = std::chrono::high_resolution_clock::now();
+	eigen_alignment_fit_min_volume_ellipsoid(points, k_sample_count, 0.0001f, min_volume_ellipsoid);
+	const auto min_volume_end = std::chrono::high_resolution_clock::now();
+
+	EigenStreamingEllipsoidFit streaming_fit;
+	streaming_fit.clear();
+	const auto streaming_start = std::chrono::high_resolution_clock::now();
+	for (int sample_index = 0; sample_index < k_sample_count; ++sample_index)
+	{
+		eigen_alignment_streaming_ellipsoid_add_samples(streaming_fit, &points[sample_index], 1, 0.15f, 1.f);
+		eigen_alignment_streaming_ellipsoid_solve(streaming_fit);
+	}
+	const auto streaming_end = std::chrono::high_resolution_clock::now();
+
+	fprintf(stdout, "      refit per sample (%d samples): least squares axis aligned %.2f ms, streaming %.2f ms\n",
+		k_sample_count,
+		std::chrono::duration<double, std::milli>(least_squares_end - least_squares_start).count(),
+		std::chrono::duration<double, std::milli>(streaming_end - streaming_start).count());
+	fprintf(stdout, "      single min volume fit (%d samples): %.2f ms\n",
+		k_sample_count,
+		std::chrono::duration<double, std::milli>(min_volume_end - min_volume_start).count());
+
+	// Both least squares fits see the same (axis aligned) ellipsoid
+	success =
+		streaming_fit.bHasFit &&
+		(streaming_fit.ellipsoid.center - least_squares_ellipsoid.center).norm() < 1.f;
+	assert(success);
+
+	UNIT_TEST_COMPLETE()
+}
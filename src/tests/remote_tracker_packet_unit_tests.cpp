@@ -0,0 +1,221 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <vector>
+
+#include "RemoteTrackerPacket.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_remote_tracker_packet_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("remote_tracker_packet")
+		UNIT_TEST_MODULE_CALL_TEST(remote_tracker_packet_test_round_trip);
+		UNIT_TEST_MODULE_CALL_TEST(remote_tracker_packet_test_reject_bad_packets);
+		UNIT_TEST_MODULE_CALL_TEST(remote_tracker_packet_test_packet_budget);
+		UNIT_TEST_MODULE_CALL_TEST(remote_tracker_packet_test_thin_long_outlines);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+// A roughly circular outline of the given radius, like the hull of a bulb
+static void make_test_outline(int center_x, int center_y, int radius, int point_count, std::vector<RemoteTrackerPoint> &out_points)
+{
+	out_points.clear();
+
+	for (int point_index = 0; point_index < point_count; ++point_index)
+	{
+		// Octagon-ish integer outline, the codec doesn't care about the shape
+		const int octant = (point_index * 8) / point_count;
+		static const int k_dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+		static const int k_dy[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+		RemoteTrackerPoint point;
+		point.x = static_cast<short>(center_x + k_dx[octant] * radius);
+		point.y = static_cast<short>(center_y + k_dy[octant] * radius);
+		out_points.push_back(point);
+	}
+}
+
+static void make_test_frame(int blob_count, int points_per_blob, RemoteTrackerFrame &out_frame)
+{
+	std::vector<RemoteTrackerPoint> outline;
+
+	out_frame.clear();
+	out_frame.camera_id = 3;
+	out_frame.sequence_number = 0xfffffffe;
+	out_frame.capture_age_us = 4200;
+	out_frame.frame_width = 640;
+	out_frame.frame_height = 480;
+	out_frame.intrinsics.focal_length_x = 554.2563f;
+	out_frame.intrinsics.focal_length_y = 554.2563f;
+	out_frame.intrinsics.principal_x = 320.f;
+	out_frame.intrinsics.principal_y = 240.f;
+	out_frame.intrinsics.distortion_k1 = -0.1f;
+	out_frame.intrinsics.distortion_k2 = 0.02f;
+	out_frame.intrinsics.distortion_k3 = 0.f;
+	out_frame.intrinsics.distortion_p1 = 0.001f;
+	out_frame.intrinsics.distortion_p2 = -0.001f;
+
+	for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+	{
+		make_test_outline(50 + blob_index * 20, 400 - blob_index * 10, 8, points_per_blob, outline);
+		out_frame.addBlob(blob_index % 6, 200.f - blob_index, outline.data(), static_cast<int>(outline.size()));
+	}
+}
+
+static bool frames_equal(const RemoteTrackerFrame &a, const RemoteTrackerFrame &b, size_t blob_count)
+{
+	bool bEqual =
+		a.camera_id == b.camera_id &&
+		a.sequence_number == b.sequence_number &&
+		a.capture_age_us == b.capture_age_us &&
+		a.frame_width == b.frame_width &&
+		a.frame_height == b.frame_height &&
+		a.intrinsics.focal_length_x == b.intrinsics.focal_length_x &&
+		a.intrinsics.principal_y == b.intrinsics.principal_y &&
+		a.intrinsics.distortion_k1 == b.intrinsics.distortion_k1 &&
+		a.intrinsics.distortion_p2 == b.intrinsics.distortion_p2 &&
+		a.blobs.size() >= blob_count &&
+		b.blobs.size() == blob_count;
+
+	for (size_t blob_index = 0; bEqual && blob_index < blob_count; ++blob_index)
+	{
+		const RemoteTrackerBlob &blob_a = a.blobs[blob_index];
+		const RemoteTrackerBlob &blob_b = b.blobs[blob_index];
+
+		bEqual =
+			blob_a.color_id == blob_b.color_id &&
+			blob_a.area == blob_b.area &&
+			blob_a.point_count == blob_b.point_count;
+
+		for (int point_index = 0; bEqual && point_index < blob_a.point_count; ++point_index)
+		{
+			const RemoteTrackerPoint &point_a = a.points[blob_a.first_point + point_index];
+			const RemoteTrackerPoint &point_b = b.points[blob_b.first_point + point_index];
+
+			bEqual = point_a.x == point_b.x && point_a.y == point_b.y;
+		}
+	}
+
+	return bEqual;
+}
+
+bool
+remote_tracker_packet_test_round_trip()
+{
+	UNIT_TEST_BEGIN("round trip")
+		RemoteTrackerFrame frame;
+		make_test_frame(4, 12, frame);
+
+		// Negative coordinates come from hulls clipped at the frame edge
+		frame.points[0].x = -3;
+
+		unsigned char packet[REMOTE_TRACKER_MAX_PACKET_SIZE];
+		int encoded_blob_count = 0;
+		const int packet_size = encodeRemoteTrackerFrame(frame, packet, sizeof(packet), &encoded_blob_count);
+
+		RemoteTrackerFrame decoded;
+		const bool bDecoded = decodeRemoteTrackerFrame(packet, packet_size, decoded);
+
+		success =
+			packet_size > 0 &&
+			encoded_blob_count == 4 &&
+			bDecoded &&
+			frames_equal(frame, decoded, 4) &&
+			decoded.points[0].x == -3;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+remote_tracker_packet_test_reject_bad_packets()
+{
+	UNIT_TEST_BEGIN("reject bad packets")
+		RemoteTrackerFrame frame;
+		make_test_frame(2, 10, frame);
+
+		unsigned char packet[REMOTE_TRACKER_MAX_PACKET_SIZE];
+		const int packet_size = encodeRemoteTrackerFrame(frame, packet, sizeof(packet));
+
+		RemoteTrackerFrame decoded;
+		success = packet_size > 0;
+
+		// Every truncation must be caught, including the ones that end between blobs
+		for (int truncated_size = 0; success && truncated_size < packet_size; ++truncated_size)
+		{
+			success = !decodeRemoteTrackerFrame(packet, truncated_size, decoded);
+		}
+
+		// Trailing garbage
+		success &= !decodeRemoteTrackerFrame(packet, packet_size + 1, decoded);
+
+		// Wrong version
+		packet[4] ^= 0xff;
+		success &= !decodeRemoteTrackerFrame(packet, packet_size, decoded);
+		packet[4] ^= 0xff;
+
+		// Not one of our packets
+		packet[0] ^= 0xff;
+		success &= !decodeRemoteTrackerFrame(packet, packet_size, decoded);
+		packet[0] ^= 0xff;
+
+		success &= decodeRemoteTrackerFrame(packet, packet_size, decoded);
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+remote_tracker_packet_test_packet_budget()
+{
+	UNIT_TEST_BEGIN("packet budget")
+		// 40 blobs of 20 points need 40 * (6 + 80) bytes, far more than one datagram
+		RemoteTrackerFrame frame;
+		make_test_frame(40, 20, frame);
+
+		unsigned char packet[REMOTE_TRACKER_MAX_PACKET_SIZE];
+		int encoded_blob_count = 0;
+		const int packet_size = encodeRemoteTrackerFrame(frame, packet, sizeof(packet), &encoded_blob_count);
+
+		RemoteTrackerFrame decoded;
+		const bool bDecoded = decodeRemoteTrackerFrame(packet, packet_size, decoded);
+
+		// The leading blobs make it whole, the rest are dropped
+		success =
+			packet_size <= REMOTE_TRACKER_MAX_PACKET_SIZE &&
+			encoded_blob_count > 0 &&
+			encoded_blob_count < 40 &&
+			bDecoded &&
+			frames_equal(frame, decoded, encoded_blob_count);
+
+		// A buffer smaller than the header can't hold anything
+		success &= encodeRemoteTrackerFrame(frame, packet, 8) == 0;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+remote_tracker_packet_test_thin_long_outlines()
+{
+	UNIT_TEST_BEGIN("thin long outlines")
+		std::vector<RemoteTrackerPoint> outline;
+		make_test_outline(320, 240, 100, 1000, outline);
+
+		RemoteTrackerFrame frame;
+		frame.clear();
+		frame.addBlob(0, 31400.f, outline.data(), static_cast<int>(outline.size()));
+
+		// Thinned evenly, so the outline still goes all the way around
+		const RemoteTrackerBlob &blob = frame.blobs[0];
+		const RemoteTrackerPoint &last_point = frame.points[blob.first_point + blob.point_count - 1];
+
+		success =
+			blob.point_count == REMOTE_TRACKER_MAX_BLOB_POINTS &&
+			frame.points.size() == REMOTE_TRACKER_MAX_BLOB_POINTS &&
+			last_point.x == outline.back().x &&
+			last_point.y == outline.back().y;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
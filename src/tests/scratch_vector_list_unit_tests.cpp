@@ -0,0 +1,60 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "ScratchVectorList.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_scratch_vector_list_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("scratch_vector_list")
+		UNIT_TEST_MODULE_CALL_TEST(scratch_vector_list_test_reuse_capacity);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- definitions -----
+struct TestPoint
+{
+	int x, y;
+};
+
+//-- private functions -----
+bool
+scratch_vector_list_test_reuse_capacity()
+{
+	UNIT_TEST_BEGIN("reuse capacity")
+
+	ScratchVectorList<TestPoint> list;
+	list.reserve(4, 32);
+
+	std::vector<TestPoint> &slot = list.push_back();
+	slot.resize(32);
+	const TestPoint *slot_data = slot.data();
+
+	list.clear();
+	success = list.empty() && list.capacity() == 4;
+	assert(success);
+
+	if (success)
+	{
+		std::vector<TestPoint> &reused_slot = list.push_back();
+
+		// Cleared slot comes back empty but keeps its buffer
+		success = reused_slot.empty() && reused_slot.capacity() >= 32 && reused_slot.data() == slot_data;
+		assert(success);
+	}
+
+	if (success)
+	{
+		list.pop_back();
+		success = list.size() == 0;
+		assert(success);
+	}
+
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,315 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "PSMoveProtocol.pb.h"
+#include "SharedDeviceState.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_shared_device_state_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("shared_device_state")
+		UNIT_TEST_MODULE_CALL_TEST(shared_device_state_test_heartbeat_timeout);
+		UNIT_TEST_MODULE_CALL_TEST(shared_device_state_test_live_broker);
+		UNIT_TEST_MODULE_CALL_TEST(shared_device_state_test_stale_segment);
+		UNIT_TEST_MODULE_CALL_TEST(shared_device_state_test_broker_restart);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- constants -----
+// Kept apart from the block a running service would use
+static const char *k_test_shared_memory_name = "PSMoveService_SharedDeviceStateUnitTest";
+static const int k_test_timeout_ms = 100;
+static const int k_test_update_interval_ms = 10;
+
+//-- private functions -----
+static void sleep_ms(int milliseconds)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+}
+
+// Updates both sides the way the service loop would until the reader reaches the wanted state.
+// A null writer stands in for a broker that stopped updating.
+static bool update_until_attached(
+	SharedDeviceStateWriter *writer,
+	SharedDeviceStateReader &reader,
+	bool bWantAttached)
+{
+	for (int update_count = 0; update_count * k_test_update_interval_ms < 10 * k_test_timeout_ms; ++update_count)
+	{
+		unsigned int controller_tracking_mask = 0;
+		unsigned int hmd_tracking_mask = 0;
+
+		if (writer != nullptr)
+		{
+			writer->update(controller_tracking_mask, hmd_tracking_mask);
+		}
+
+		reader.update(0, 0);
+
+		if (reader.getIsAttached() == bWantAttached)
+		{
+			return true;
+		}
+
+		sleep_ms(k_test_update_interval_ms);
+	}
+
+	return false;
+}
+
+static void make_controller_list(int controller_count, PSMoveProtocol::Response &out_response)
+{
+	out_response.Clear();
+	out_response.set_type(PSMoveProtocol::Response_ResponseType_CONTROLLER_LIST);
+
+	for (int controller_id = 0; controller_id < controller_count; ++controller_id)
+	{
+		out_response.mutable_result_controller_list()->add_controllers()->set_controller_id(controller_id);
+	}
+}
+
+bool
+shared_device_state_test_heartbeat_timeout()
+{
+	UNIT_TEST_BEGIN("heartbeat timeout")
+		SharedDeviceStateWriter writer(k_test_shared_memory_name, k_test_timeout_ms);
+		SharedDeviceStateReader reader(k_test_shared_memory_name, k_test_timeout_ms);
+		unsigned int controller_tracking_mask = 0;
+		unsigned int hmd_tracking_mask = 0;
+
+		success = writer.startup(4, 2);
+		assert(success);
+
+		// The front-end's tracking request reaches the broker
+		if (success)
+		{
+			reader.update(0x5, 0x1);
+			writer.update(controller_tracking_mask, hmd_tracking_mask);
+
+			success = reader.getIsAttached() && writer.getHasFrontends() &&
+				controller_tracking_mask == 0x5 && hmd_tracking_mask == 0x1;
+			assert(success);
+		}
+
+		// A front-end that stops updating gets dropped along with its tracking requests
+		if (success)
+		{
+			sleep_ms(2 * k_test_timeout_ms);
+			writer.update(controller_tracking_mask, hmd_tracking_mask);
+
+			success = !writer.getHasFrontends() && controller_tracking_mask == 0 && hmd_tracking_mask == 0;
+			assert(success);
+		}
+
+		// It claims a new slot once it notices
+		if (success)
+		{
+			reader.update(0x2, 0);
+			writer.update(controller_tracking_mask, hmd_tracking_mask);
+
+			success = reader.getIsAttached() && writer.getHasFrontends() && controller_tracking_mask == 0x2;
+			assert(success);
+		}
+
+		// A broker that stops updating gets detached from
+		if (success)
+		{
+			success = update_until_attached(nullptr, reader, false);
+			assert(success);
+		}
+
+		writer.shutdown();
+		reader.shutdown();
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_device_state_test_live_broker()
+{
+	UNIT_TEST_BEGIN("live broker")
+		SharedDeviceStateWriter writer(k_test_shared_memory_name, k_test_timeout_ms);
+
+		success = writer.startup(4, 2);
+		assert(success);
+
+		if (success)
+		{
+			std::atomic_bool bStopUpdating(false);
+			std::thread update_thread([&writer, &bStopUpdating]() {
+				while (!bStopUpdating.load())
+				{
+					unsigned int controller_tracking_mask = 0;
+					unsigned int hmd_tracking_mask = 0;
+
+					writer.update(controller_tracking_mask, hmd_tracking_mask);
+					sleep_ms(k_test_update_interval_ms);
+				}
+			});
+
+			// A second broker must not take the block away from one that is still updating it
+			{
+				SharedDeviceStateWriter second_writer(k_test_shared_memory_name, k_test_timeout_ms);
+
+				success = !second_writer.startup(4, 2);
+				assert(success);
+			}
+
+			bStopUpdating.store(true);
+			update_thread.join();
+		}
+
+		// The failed broker left the block alone
+		if (success)
+		{
+			SharedDeviceStateReader reader(k_test_shared_memory_name, k_test_timeout_ms);
+
+			success = update_until_attached(&writer, reader, true) && reader.getControllerCount() == 4;
+			assert(success);
+		}
+
+		writer.shutdown();
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_device_state_test_stale_segment()
+{
+	UNIT_TEST_BEGIN("stale segment")
+		// Never shut down, like a broker that crashed and left its block behind
+		SharedDeviceStateWriter *crashed_writer = new SharedDeviceStateWriter(k_test_shared_memory_name, k_test_timeout_ms);
+		unsigned int controller_tracking_mask = 0;
+		unsigned int hmd_tracking_mask = 0;
+
+		success = crashed_writer->startup(4, 2);
+		assert(success);
+
+		if (success)
+		{
+			crashed_writer->update(controller_tracking_mask, hmd_tracking_mask);
+		}
+
+		// The next broker waits out the heartbeat timeout and replaces the block
+		SharedDeviceStateWriter writer(k_test_shared_memory_name, k_test_timeout_ms);
+
+		if (success)
+		{
+			const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+			success = writer.startup(3, 1);
+			assert(success);
+
+			success &= std::chrono::steady_clock::now() - start_time >= std::chrono::milliseconds(k_test_timeout_ms);
+			assert(success);
+		}
+
+		// Front-ends find the new block
+		if (success)
+		{
+			SharedDeviceStateReader reader(k_test_shared_memory_name, k_test_timeout_ms);
+
+			success = update_until_attached(&writer, reader, true) &&
+				reader.getControllerCount() == 3 && reader.getHMDCount() == 1;
+			assert(success);
+		}
+
+		writer.shutdown();
+
+		// Its block is gone already, so this only lets go of the stale mapping
+		delete crashed_writer;
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_device_state_test_broker_restart()
+{
+	UNIT_TEST_BEGIN("broker restart")
+		SharedDeviceStateWriter writer(k_test_shared_memory_name, k_test_timeout_ms);
+		SharedDeviceStateReader reader(k_test_shared_memory_name, k_test_timeout_ms);
+		PSMoveProtocol::Response written_list;
+		PSMoveProtocol::Response read_list;
+
+		success = writer.startup(4, 2);
+		assert(success);
+
+		if (success)
+		{
+			make_controller_list(2, written_list);
+			writer.writeDeviceList(_eSharedDeviceList_Controllers, written_list);
+
+			success = update_until_attached(&writer, reader, true) &&
+				reader.readDeviceList(_eSharedDeviceList_Controllers, read_list) &&
+				read_list.result_controller_list().controllers_size() == 2;
+			assert(success);
+		}
+
+		// The list reads as gone once the broker goes away
+		if (success)
+		{
+			writer.shutdown();
+
+			success = update_until_attached(nullptr, reader, false) &&
+				reader.readDeviceList(_eSharedDeviceList_Controllers, read_list) &&
+				read_list.result_controller_list().controllers_size() == 0;
+			assert(success);
+		}
+
+		// And comes back with whatever the restarted broker publishes
+		if (success)
+		{
+			success = writer.startup(4, 2);
+			assert(success);
+
+			make_controller_list(3, written_list);
+			writer.writeDeviceList(_eSharedDeviceList_Controllers, written_list);
+
+			success &= update_until_attached(&writer, reader, true) &&
+				reader.readDeviceList(_eSharedDeviceList_Controllers, read_list) &&
+				read_list.result_controller_list().controllers_size() == 3;
+			assert(success);
+		}
+
+		// A frame written before the front-end came back isn't replayed once it attaches again
+		if (success)
+		{
+			PSMoveProtocol::DeviceOutputDataFrame data_frame;
+			unsigned int controller_tracking_mask = 0;
+			unsigned int hmd_tracking_mask = 0;
+
+			writer.update(controller_tracking_mask, hmd_tracking_mask);
+
+			success = writer.getHasFrontends();
+			assert(success);
+
+			data_frame.mutable_controller_data_packet()->set_controller_id(0);
+			data_frame.mutable_controller_data_packet()->set_sequence_num(1);
+			writer.writeControllerDataFrame(0, data_frame);
+
+			// The front-end hands its slot back on shutdown
+			reader.shutdown();
+			writer.update(controller_tracking_mask, hmd_tracking_mask);
+
+			success &= !writer.getHasFrontends();
+			assert(success);
+
+			if (success && update_until_attached(&writer, reader, true))
+			{
+				success = !reader.readControllerDataFrame(0, data_frame) || !data_frame.has_controller_data_packet();
+				assert(success);
+			}
+			else
+			{
+				success = false;
+				assert(success);
+			}
+		}
+
+		reader.shutdown();
+		writer.shutdown();
+	UNIT_TEST_COMPLETE()
+}
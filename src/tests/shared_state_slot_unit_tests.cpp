@@ -0,0 +1,175 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <thread>
+
+#include "SharedStateSlot.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_shared_state_slot_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("shared_state_slot")
+		UNIT_TEST_MODULE_CALL_TEST(shared_state_slot_test_write_read);
+		UNIT_TEST_MODULE_CALL_TEST(shared_state_slot_test_write_if_changed);
+		UNIT_TEST_MODULE_CALL_TEST(shared_state_slot_test_oversized_write);
+		UNIT_TEST_MODULE_CALL_TEST(shared_state_slot_test_write_in_progress);
+		UNIT_TEST_MODULE_CALL_TEST(shared_state_slot_test_concurrent_reader);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- private functions -----
+typedef SharedStateSlot<64> t_test_slot;
+
+bool
+shared_state_slot_test_write_read()
+{
+	UNIT_TEST_BEGIN("write read")
+		t_test_slot slot;
+		slot.init();
+
+		unsigned int read_version = 0;
+		unsigned char read_bytes[t_test_slot::k_capacity];
+		unsigned int read_size = 0;
+
+		// Nothing written yet
+		success = !slot.read(read_version, read_bytes, read_size);
+		assert(success);
+
+		if (success)
+		{
+			const unsigned char state[4] = { 1, 2, 3, 4 };
+
+			success = slot.write(state, sizeof(state));
+			assert(success);
+
+			success &= slot.read(read_version, read_bytes, read_size);
+			assert(success);
+
+			success &= read_size == sizeof(state) && memcmp(read_bytes, state, sizeof(state)) == 0;
+			assert(success);
+		}
+
+		// Already seen this version
+		if (success)
+		{
+			success = !slot.read(read_version, read_bytes, read_size);
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_state_slot_test_write_if_changed()
+{
+	UNIT_TEST_BEGIN("write if changed")
+		t_test_slot slot;
+		slot.init();
+
+		const unsigned char state[3] = { 7, 8, 9 };
+		const unsigned char new_state[3] = { 7, 8, 10 };
+
+		success = slot.writeIfChanged(state, sizeof(state));
+		assert(success);
+
+		if (success)
+		{
+			const unsigned int version = slot.getVersion();
+
+			success = !slot.writeIfChanged(state, sizeof(state)) && slot.getVersion() == version;
+			assert(success);
+
+			success &= slot.writeIfChanged(new_state, sizeof(new_state)) && slot.getVersion() != version;
+			assert(success);
+		}
+
+		// Clearing the slot counts as a change too
+		if (success)
+		{
+			success = slot.writeIfChanged(nullptr, 0) && !slot.writeIfChanged(nullptr, 0);
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_state_slot_test_oversized_write()
+{
+	UNIT_TEST_BEGIN("oversized write")
+		t_test_slot slot;
+		slot.init();
+
+		unsigned char state[t_test_slot::k_capacity + 1];
+		memset(state, 0xAB, sizeof(state));
+
+		success = !slot.write(state, sizeof(state)) && slot.getVersion() == 0;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_state_slot_test_write_in_progress()
+{
+	UNIT_TEST_BEGIN("write in progress")
+		t_test_slot slot;
+		slot.init();
+
+		const unsigned char state[2] = { 5, 6 };
+		slot.write(state, sizeof(state));
+
+		// Looks like a writer that died (or is stalled) halfway through an update
+		slot.version.store(slot.getVersion() + 1);
+
+		unsigned int read_version = 0;
+		unsigned char read_bytes[t_test_slot::k_capacity];
+		unsigned int read_size = 0;
+
+		success = !slot.read(read_version, read_bytes, read_size) && read_version == 0;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+shared_state_slot_test_concurrent_reader()
+{
+	UNIT_TEST_BEGIN("concurrent reader")
+		static const int k_write_count = 20000;
+
+		t_test_slot slot;
+		slot.init();
+
+		// Every state is a run of one repeated value, so a torn read shows up as mixed values
+		std::thread writer([&slot]() {
+			unsigned char state[t_test_slot::k_capacity];
+
+			for (int write_index = 1; write_index <= k_write_count; ++write_index)
+			{
+				memset(state, write_index & 0xFF, sizeof(state));
+				slot.write(state, 1 + (write_index % t_test_slot::k_capacity));
+			}
+		});
+
+		unsigned int read_version = 0;
+		unsigned char read_bytes[t_test_slot::k_capacity];
+		unsigned int read_size = 0;
+		bool any_torn_reads = false;
+
+		while (slot.getVersion() < 2 * k_write_count)
+		{
+			if (slot.read(read_version, read_bytes, read_size))
+			{
+				for (unsigned int byte_index = 1; byte_index < read_size; ++byte_index)
+				{
+					any_torn_reads |= read_bytes[byte_index] != read_bytes[0];
+				}
+			}
+		}
+
+		writer.join();
+
+		success = !any_torn_reads;
+		assert(success);
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,128 @@
+//-- includes -----
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+#include "SubpixelEdge.h"
+#include "unit_test.h"
+
+//-- public interface -----
+bool run_subpixel_edge_unit_tests()
+{
+	UNIT_TEST_MODULE_BEGIN("subpixel_edge")
+		UNIT_TEST_MODULE_CALL_TEST(subpixel_edge_test_synthetic_edge_error);
+		UNIT_TEST_MODULE_CALL_TEST(subpixel_edge_test_weak_edge);
+	UNIT_TEST_MODULE_END()
+}
+
+//-- constants -----
+// Same sampling as the sphere edge refinement in ServerTrackerView
+static const float k_sample_step_px = 0.5f;
+static const int k_half_sample_count = 6; // +/-3px search
+static const int k_sample_count = 2 * k_half_sample_count + 1;
+static const float k_min_edge_gradient = 12.f;
+
+// Bulb and background brightness (summed BGR) and the width of the camera's blur
+static const float k_bulb_intensity = 600.f;
+static const float k_background_intensity = 60.f;
+static const float k_edge_blur_px = 0.7f;
+
+//-- private functions -----
+// A blurred bright-to-dark step centered on edge_px
+static float
+synthetic_edge_intensity(float t, float edge_px)
+{
+	const float s = 1.f / (1.f + expf((t - edge_px) / k_edge_blur_px));
+
+	return k_background_intensity + (k_bulb_intensity - k_background_intensity) * s;
+}
+
+bool
+subpixel_edge_test_synthetic_edge_error()
+{
+	UNIT_TEST_BEGIN("synthetic edge error")
+		static const int k_edge_positions = 50;
+
+		float max_refined_error = 0.f;
+		float max_sample_error = 0.f;
+		float sum_refined_error = 0.f;
+		float sum_sample_error = 0.f;
+
+		// Walk the true edge across one sample step relative to where the hull put it
+		for (int position_index = 0; success && position_index < k_edge_positions; ++position_index)
+		{
+			const float true_edge_px =
+				-k_sample_step_px + 2.f * k_sample_step_px * static_cast<float>(position_index) / static_cast<float>(k_edge_positions);
+
+			float intensity[k_sample_count];
+			for (int sample_index = 0; sample_index < k_sample_count; ++sample_index)
+			{
+				const float t = static_cast<float>(sample_index - k_half_sample_count) * k_sample_step_px;
+
+				intensity[sample_index] = synthetic_edge_intensity(t, true_edge_px);
+			}
+
+			float edge_index = 0.f;
+			float gradient = 0.f;
+			success = find_subpixel_falling_edge(intensity, k_sample_count, k_sample_step_px, k_min_edge_gradient, edge_index, gradient);
+			assert(success);
+
+			if (success)
+			{
+				const float refined_edge_px = (edge_index - static_cast<float>(k_half_sample_count)) * k_sample_step_px;
+				// What picking the strongest sample alone (no parabola) would give
+				const float sample_edge_px = roundf(edge_index) * k_sample_step_px - static_cast<float>(k_half_sample_count) * k_sample_step_px;
+				const float refined_error = fabsf(refined_edge_px - true_edge_px);
+				const float sample_error = fabsf(sample_edge_px - true_edge_px);
+
+				max_refined_error = fmaxf(max_refined_error, refined_error);
+				max_sample_error = fmaxf(max_sample_error, sample_error);
+				sum_refined_error += refined_error;
+				sum_sample_error += sample_error;
+			}
+		}
+
+		if (success)
+		{
+			printf("      refined edge error: mean %.3fpx max %.3fpx (strongest sample: mean %.3fpx max %.3fpx)\n",
+				sum_refined_error / k_edge_positions, max_refined_error,
+				sum_sample_error / k_edge_positions, max_sample_error);
+
+			// A symmetric blurred edge should land well inside a tenth of a pixel,
+			// and clearly beat the half-sample quantization of the strongest sample
+			success = max_refined_error < 0.05f && sum_refined_error < 0.5f * sum_sample_error;
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
+
+bool
+subpixel_edge_test_weak_edge()
+{
+	UNIT_TEST_BEGIN("weak edge")
+		float intensity[k_sample_count];
+		for (int sample_index = 0; sample_index < k_sample_count; ++sample_index)
+		{
+			// A barely visible step, below the minimum gradient
+			intensity[sample_index] = (sample_index < k_half_sample_count) ? 100.f : 98.f;
+		}
+
+		float edge_index = 0.f;
+		float gradient = 0.f;
+		success = !find_subpixel_falling_edge(intensity, k_sample_count, k_sample_step_px, k_min_edge_gradient, edge_index, gradient);
+		assert(success);
+
+		// The edge at the very end of the run can't be fit
+		if (success)
+		{
+			for (int sample_index = 0; sample_index < k_sample_count; ++sample_index)
+			{
+				intensity[sample_index] = (sample_index < k_sample_count - 1) ? 600.f : 60.f;
+			}
+
+			success = !find_subpixel_falling_edge(intensity, k_sample_count, k_sample_step_px, k_min_edge_gradient, edge_index, gradient);
+			assert(success);
+		}
+	UNIT_TEST_COMPLETE()
+}
@@ -0,0 +1,192 @@
+#include "RLEBlobExtractor.h"
+#include "opencv2/opencv.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Benchmarks RLEBlobExtractor against the cv::findContours path ServerTrackerView uses.
+//
+// Usage: test_blob_extractor [frame image ...]
+// Each frame image is thresholded at 128 into a mask (i.e. feed it the saved gsLower masks or
+// any other recorded binary frames). With no arguments a set of synthetic 640x480 frames is
+// generated instead: one tracking bulb plus a few hundred noise speckles per frame.
+
+//-- constants -----
+static const int k_synthetic_frame_count = 100;
+static const int k_synthetic_noise_blob_count = 400;
+static const int k_iterations_per_frame = 20;
+static const int k_min_points_in_contour = 6;
+
+//-- prototypes -----
+static void generate_synthetic_frames(std::vector<cv::Mat> &out_frames);
+static bool load_recorded_frames(int argc, char *argv[], std::vector<cv::Mat> &out_frames);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    std::vector<cv::Mat> frames;
+
+    if (argc > 1)
+    {
+        if (!load_recorded_frames(argc, argv, frames))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    else
+    {
+        generate_synthetic_frames(frames);
+    }
+
+    // Baseline: findContours + contourArea + sort, as in OpenCVBufferState::computeBiggestNContours
+    std::vector<cv::Point2f> opencv_centers;
+    double opencv_total_ms = 0.0;
+    {
+        std::vector<std::vector<cv::Point>> contours;
+        std::vector<std::pair<double, int>> sorted_contours;
+        cv::Mat scratch;
+
+        for (const cv::Mat &frame : frames)
+        {
+            cv::Point2f center(-1.f, -1.f);
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            for (int iteration = 0; iteration < k_iterations_per_frame; ++iteration)
+            {
+                // findContours modifies its input on older OpenCV versions
+                frame.copyTo(scratch);
+                cv::findContours(scratch, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
+
+                sorted_contours.clear();
+                for (int contour_index = 0; contour_index < static_cast<int>(contours.size()); ++contour_index)
+                {
+                    sorted_contours.push_back(std::make_pair(cv::contourArea(contours[contour_index]), contour_index));
+                }
+                std::sort(sorted_contours.rbegin(), sorted_contours.rend());
+
+                for (auto it = sorted_contours.begin(); it != sorted_contours.end(); ++it)
+                {
+                    const std::vector<cv::Point> &contour = contours[it->second];
+
+                    if (contour.size() > k_min_points_in_contour)
+                    {
+                        const cv::Moments mu = cv::moments(contour);
+                        center = cv::Point2f(static_cast<float>(mu.m10 / mu.m00), static_cast<float>(mu.m01 / mu.m00));
+                        break;
+                    }
+                }
+            }
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            opencv_total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+            opencv_centers.push_back(center);
+        }
+    }
+
+    // RLE labeller + outline of the winning blob
+    std::vector<cv::Point2f> rle_centers;
+    double rle_total_ms = 0.0;
+    {
+        RLEBlobExtractor extractor;
+        std::vector<cv::Point> outline;
+
+        extractor.reserve(4096, 512);
+        for (const cv::Mat &frame : frames)
+        {
+            cv::Point2f center(-1.f, -1.f);
+
+            const auto start = std::chrono::high_resolution_clock::now();
+            for (int iteration = 0; iteration < k_iterations_per_frame; ++iteration)
+            {
+                extractor.extractBlobs(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step), 0, 0);
+
+                // Area equivalent of the contour point count check above
+                if (extractor.computeLargestBlobs(1, k_min_points_in_contour + 1) > 0)
+                {
+                    const RLEBlob &blob = extractor.getLargestBlob(0);
+
+                    extractor.computeLargestBlobOutline(0, outline);
+                    center = cv::Point2f(blob.getCenterX(), blob.getCenterY());
+                }
+            }
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            rle_total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+            rle_centers.push_back(center);
+        }
+    }
+
+    // Compare the two paths
+    double max_center_error = 0.0;
+    int mismatch_count = 0;
+    for (size_t frame_index = 0; frame_index < frames.size(); ++frame_index)
+    {
+        const double error = cv::norm(opencv_centers[frame_index] - rle_centers[frame_index]);
+
+        max_center_error = std::max(max_center_error, error);
+        if (error > 1.0)
+        {
+            ++mismatch_count;
+        }
+    }
+
+    const double sample_count = static_cast<double>(frames.size() * k_iterations_per_frame);
+    printf("frames: %d (x%d iterations)\n", static_cast<int>(frames.size()), k_iterations_per_frame);
+    printf("findContours: %.3f ms/frame\n", opencv_total_ms / sample_count);
+    printf("RLE labeller: %.3f ms/frame\n", rle_total_ms / sample_count);
+    printf("speedup: %.2fx\n", opencv_total_ms / std::max(rle_total_ms, 1e-6));
+    printf("largest blob center max difference: %.3f px (%d frames over 1px)\n", max_center_error, mismatch_count);
+
+    return EXIT_SUCCESS;
+}
+
+//-- private functions -----
+static void generate_synthetic_frames(std::vector<cv::Mat> &out_frames)
+{
+    cv::RNG rng(0x1234);
+
+    for (int frame_index = 0; frame_index < k_synthetic_frame_count; ++frame_index)
+    {
+        cv::Mat frame = cv::Mat::zeros(480, 640, CV_8UC1);
+
+        // The bulb drifts across the frame and shrinks as it "moves away"
+        const float u = static_cast<float>(frame_index) / static_cast<float>(k_synthetic_frame_count);
+        const cv::Point bulb_center(static_cast<int>(80 + 480 * u), static_cast<int>(120 + 240 * u));
+        const int bulb_radius = static_cast<int>(40 - 30 * u);
+        cv::circle(frame, bulb_center, bulb_radius, cv::Scalar(255), -1);
+
+        // Sensor noise and reflections
+        for (int noise_index = 0; noise_index < k_synthetic_noise_blob_count; ++noise_index)
+        {
+            const cv::Point noise_center(rng.uniform(0, 640), rng.uniform(0, 480));
+            const int noise_radius = rng.uniform(0, 3);
+
+            cv::circle(frame, noise_center, noise_radius, cv::Scalar(255), -1);
+        }
+
+        out_frames.push_back(frame);
+    }
+}
+
+static bool load_recorded_frames(int argc, char *argv[], std::vector<cv::Mat> &out_frames)
+{
+    for (int arg_index = 1; arg_index < argc; ++arg_index)
+    {
+        cv::Mat image = cv::imread(argv[arg_index], cv::IMREAD_GRAYSCALE);
+
+        if (image.empty())
+        {
+            fprintf(stderr, "Failed to load frame: %s\n", argv[arg_index]);
+            return false;
+        }
+
+        cv::Mat mask;
+        cv::threshold(image, mask, 128, 255, cv::THRESH_BINARY);
+        out_frames.push_back(mask);
+    }
+
+    return true;
+}
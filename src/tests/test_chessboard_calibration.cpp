@@ -0,0 +1,349 @@
+#include "ChessboardCalibration.h"
+#include "opencv2/opencv.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Checks and times the headless chessboard calibration library.
+//
+// Usage: test_chessboard_calibration
+// * Detection: synthetic 640x480 frames of a 9x6 board seen from random poses are searched at
+//   full resolution and at the downscaled detection resolution, then pushed through a
+//   ChessboardDetectorPool as fast as it takes them.
+// * Solver: boards projected through a known camera (with distortion and pixel noise) are fed
+//   to an IncrementalCameraCalibrator one at a time; the intrinsics have to come back.
+
+//-- constants -----
+static const int k_frame_width = 640;
+static const int k_frame_height = 480;
+static const int k_detection_width = 320;
+static const int k_frame_count = 40;
+static const int k_board_count = 12;
+static const float k_square_length_mm = 24.f;
+static const int k_board_image_square_px = 40;
+static const float k_max_mean_corner_error_px = 0.5f;
+static const float k_max_focal_length_error_px = 5.f;
+static const float k_max_principal_point_error_px = 8.f;
+static const float k_max_reprojection_error_px = 0.5f;
+
+//-- prototypes -----
+static ChessboardPattern make_pattern();
+static cv::Matx33d make_true_intrinsics();
+static void make_random_board_pose(cv::RNG &rng, cv::Vec3d &out_rvec, cv::Vec3d &out_tvec);
+static void generate_board_frames(
+    const ChessboardPattern &pattern, std::vector<cv::Mat> &out_frames, std::vector<std::vector<cv::Point2f>> &out_corners);
+static float compute_mean_corner_error(const std::vector<cv::Point2f> &corners, const std::vector<cv::Point2f> &truth);
+static bool test_detection(const ChessboardPattern &pattern);
+static bool test_incremental_solver(const ChessboardPattern &pattern);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    const ChessboardPattern pattern = make_pattern();
+    bool bSuccess = true;
+
+    bSuccess &= test_detection(pattern);
+    bSuccess &= test_incremental_solver(pattern);
+
+    printf(bSuccess ? "PASSED\n" : "FAILED\n");
+
+    return bSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-- tests -----
+static bool test_detection(const ChessboardPattern &pattern)
+{
+    std::vector<cv::Mat> frames;
+    std::vector<std::vector<cv::Point2f>> true_corners;
+    generate_board_frames(pattern, frames, true_corners);
+
+    bool bSuccess = true;
+
+    // Synchronous search, full resolution vs downscaled
+    const int detection_widths[2] = {0, k_detection_width};
+    for (int width_index = 0; width_index < 2; ++width_index)
+    {
+        const int detection_width = detection_widths[width_index];
+        std::vector<cv::Point2f> corners;
+        int found_count = 0;
+        double error_sum = 0.0;
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (size_t frame_index = 0; frame_index < frames.size(); ++frame_index)
+        {
+            if (chessboard_find_corners(frames[frame_index], pattern, detection_width, corners))
+            {
+                ++found_count;
+                error_sum += compute_mean_corner_error(corners, true_corners[frame_index]);
+            }
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const double total_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        const double mean_error = (found_count > 0) ? error_sum / found_count : 0.0;
+
+        printf("find corners (detection width %d): %.2f ms/frame, found %d/%d, mean corner error %.3f px\n",
+            (detection_width > 0) ? detection_width : k_frame_width,
+            total_ms / frames.size(), found_count, static_cast<int>(frames.size()), mean_error);
+
+        if (found_count < static_cast<int>(frames.size()) * 3 / 4)
+        {
+            printf("FAILED: found too few boards\n");
+            bSuccess = false;
+        }
+
+        if (mean_error > k_max_mean_corner_error_px)
+        {
+            printf("FAILED: mean corner error above %.2f px\n", k_max_mean_corner_error_px);
+            bSuccess = false;
+        }
+    }
+
+    // Worker pool, fed as fast as it will take frames
+    {
+        const int worker_count = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+        ChessboardDetectorPool pool(pattern, worker_count, k_detection_width);
+        int detection_count = 0;
+        int last_frame_index = -1;
+        bool bInOrder = true;
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (size_t frame_index = 0; frame_index < frames.size();)
+        {
+            if (pool.submitFrame(frames[frame_index]) != -1)
+            {
+                ++frame_index;
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+
+            ChessboardDetection detection;
+            if (pool.pollDetection(detection))
+            {
+                bInOrder &= detection.frame_index > last_frame_index;
+                last_frame_index = detection.frame_index;
+                ++detection_count;
+            }
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const double total_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        printf("detector pool (%d workers): %.2f ms/frame, %d detections polled\n",
+            worker_count, total_ms / frames.size(), detection_count);
+
+        if (!bInOrder)
+        {
+            printf("FAILED: detector pool returned an older detection after a newer one\n");
+            bSuccess = false;
+        }
+    }
+
+    return bSuccess;
+}
+
+static bool test_incremental_solver(const ChessboardPattern &pattern)
+{
+    const cv::Matx33d true_intrinsics = make_true_intrinsics();
+    const cv::Vec<double, 5> true_distortion(-0.2, 0.08, 0.001, -0.001, 0.0);
+    std::vector<cv::Point3f> object_points;
+    pattern.computeObjectPoints(object_points);
+
+    // Start from a deliberately poor guess, like an uncalibrated camera would
+    const cv::Matx33d initial_intrinsics(
+        500.0, 0.0, k_frame_width / 2.0,
+        0.0, 500.0, k_frame_height / 2.0,
+        0.0, 0.0, 1.0);
+    IncrementalCameraCalibrator calibrator(
+        pattern, cv::Size(k_frame_width, k_frame_height), initial_intrinsics, cv::Vec<double, 5>::all(0.0));
+
+    cv::RNG rng(0x5eed);
+    CameraCalibrationResult result;
+    double longest_solve_ms = 0.0;
+
+    for (int board_index = 0; board_index < k_board_count; ++board_index)
+    {
+        cv::Vec3d rvec, tvec;
+        make_random_board_pose(rng, rvec, tvec);
+
+        std::vector<cv::Point2f> corners;
+        cv::projectPoints(object_points, rvec, tvec, true_intrinsics, true_distortion, corners);
+        for (cv::Point2f &corner : corners)
+        {
+            corner.x += static_cast<float>(rng.gaussian(0.1));
+            corner.y += static_cast<float>(rng.gaussian(0.1));
+        }
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        calibrator.addBoard(corners);
+        calibrator.waitForResult(result);
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const double solve_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        longest_solve_ms = std::max(longest_solve_ms, solve_ms);
+
+        printf("board %2d: solve %.1f ms, fx %.1f, fy %.1f, cx %.1f, cy %.1f, error %.3f px\n",
+            result.board_count, solve_ms,
+            result.intrinsic_matrix(0, 0), result.intrinsic_matrix(1, 1),
+            result.intrinsic_matrix(0, 2), result.intrinsic_matrix(1, 2),
+            result.reprojection_error);
+    }
+
+    bool bSuccess = true;
+
+    if (result.board_count != k_board_count)
+    {
+        printf("FAILED: solved %d of %d boards\n", result.board_count, k_board_count);
+        bSuccess = false;
+    }
+
+    if (fabs(result.intrinsic_matrix(0, 0) - true_intrinsics(0, 0)) > k_max_focal_length_error_px ||
+        fabs(result.intrinsic_matrix(1, 1) - true_intrinsics(1, 1)) > k_max_focal_length_error_px)
+    {
+        printf("FAILED: focal length off by more than %.1f px\n", k_max_focal_length_error_px);
+        bSuccess = false;
+    }
+
+    if (fabs(result.intrinsic_matrix(0, 2) - true_intrinsics(0, 2)) > k_max_principal_point_error_px ||
+        fabs(result.intrinsic_matrix(1, 2) - true_intrinsics(1, 2)) > k_max_principal_point_error_px)
+    {
+        printf("FAILED: principal point off by more than %.1f px\n", k_max_principal_point_error_px);
+        bSuccess = false;
+    }
+
+    if (result.reprojection_error > k_max_reprojection_error_px)
+    {
+        printf("FAILED: reprojection error above %.2f px\n", k_max_reprojection_error_px);
+        bSuccess = false;
+    }
+
+    // Starting over has to drop every board
+    calibrator.reset();
+    calibrator.getLatestResult(result);
+    if (result.board_count != 0 || calibrator.getBoardCount() != 0 || calibrator.getIsSolving())
+    {
+        printf("FAILED: reset didn't clear the calibrator\n");
+        bSuccess = false;
+    }
+
+    printf("longest incremental solve: %.1f ms\n", longest_solve_ms);
+
+    return bSuccess;
+}
+
+//-- private functions -----
+static ChessboardPattern make_pattern()
+{
+    ChessboardPattern pattern;
+
+    pattern.corners_wide = 9;
+    pattern.corners_high = 6;
+    pattern.square_length_mm = k_square_length_mm;
+
+    return pattern;
+}
+
+static cv::Matx33d make_true_intrinsics()
+{
+    return cv::Matx33d(
+        554.0, 0.0, 322.0,
+        0.0, 554.0, 236.0,
+        0.0, 0.0, 1.0);
+}
+
+static void make_random_board_pose(cv::RNG &rng, cv::Vec3d &out_rvec, cv::Vec3d &out_tvec)
+{
+    // Board tilted up to ~35 degrees, 35-60cm out, roughly centered (board origin is a corner)
+    out_rvec = cv::Vec3d(rng.uniform(-0.6, 0.6), rng.uniform(-0.6, 0.6), rng.uniform(-0.3, 0.3));
+    out_tvec = cv::Vec3d(rng.uniform(-150.0, 30.0), rng.uniform(-100.0, 20.0), rng.uniform(350.0, 600.0));
+}
+
+static void generate_board_frames(
+    const ChessboardPattern &pattern, std::vector<cv::Mat> &out_frames, std::vector<std::vector<cv::Point2f>> &out_corners)
+{
+    // Board image with a one square white margin around the (corners+1) x (corners+1) squares
+    const int squares_wide = pattern.corners_wide + 1;
+    const int squares_high = pattern.corners_high + 1;
+    cv::Mat board_image(
+        (squares_high + 2) * k_board_image_square_px, (squares_wide + 2) * k_board_image_square_px, CV_8UC1, cv::Scalar(255));
+
+    for (int row = 0; row < squares_high; ++row)
+    {
+        for (int col = 0; col < squares_wide; ++col)
+        {
+            if ((row + col) % 2 == 0)
+            {
+                const cv::Rect square(
+                    (col + 1) * k_board_image_square_px, (row + 1) * k_board_image_square_px,
+                    k_board_image_square_px, k_board_image_square_px);
+                board_image(square).setTo(cv::Scalar(0));
+            }
+        }
+    }
+
+    // Internal corner (i, j) of the pattern sits at square (j+2, i+2) in the board image,
+    // corner (0, 0) maps to the board origin
+    const float mm_per_px = pattern.square_length_mm / k_board_image_square_px;
+    const cv::Point2f board_origin_px(2.f * k_board_image_square_px, 2.f * k_board_image_square_px);
+
+    const cv::Matx33d intrinsics = make_true_intrinsics();
+    std::vector<cv::Point3f> object_points;
+    pattern.computeObjectPoints(object_points);
+    cv::RNG rng(0xc0ffee);
+
+    for (int frame_index = 0; frame_index < k_frame_count; ++frame_index)
+    {
+        cv::Vec3d rvec, tvec;
+        make_random_board_pose(rng, rvec, tvec);
+
+        // Board image pixel -> board plane mm -> camera pixel
+        cv::Matx33d rotation;
+        cv::Rodrigues(rvec, rotation);
+        const cv::Matx33d plane_to_camera(
+            rotation(0, 0), rotation(0, 1), tvec[0],
+            rotation(1, 0), rotation(1, 1), tvec[1],
+            rotation(2, 0), rotation(2, 1), tvec[2]);
+        const cv::Matx33d board_image_to_plane(
+            mm_per_px, 0.0, -board_origin_px.x * mm_per_px,
+            0.0, mm_per_px, -board_origin_px.y * mm_per_px,
+            0.0, 0.0, 1.0);
+        const cv::Matx33d homography = intrinsics * plane_to_camera * board_image_to_plane;
+
+        cv::Mat frame;
+        cv::warpPerspective(
+            board_image, frame, cv::Mat(homography), cv::Size(k_frame_width, k_frame_height),
+            cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(128));
+        cv::GaussianBlur(frame, frame, cv::Size(3, 3), 0.0);
+
+        std::vector<cv::Point2f> corners;
+        cv::projectPoints(object_points, rvec, tvec, intrinsics, cv::noArray(), corners);
+
+        out_frames.push_back(frame);
+        out_corners.push_back(corners);
+    }
+}
+
+static float compute_mean_corner_error(const std::vector<cv::Point2f> &corners, const std::vector<cv::Point2f> &truth)
+{
+    if (corners.size() != truth.size() || corners.empty())
+    {
+        return 0.f;
+    }
+
+    // The detector may report the board rotated 180 degrees (it's symmetric with an even square count)
+    float forward_sum = 0.f;
+    float reverse_sum = 0.f;
+    for (size_t corner_index = 0; corner_index < corners.size(); ++corner_index)
+    {
+        forward_sum += static_cast<float>(cv::norm(corners[corner_index] - truth[corner_index]));
+        reverse_sum += static_cast<float>(cv::norm(corners[corner_index] - truth[truth.size() - 1 - corner_index]));
+    }
+
+    return std::min(forward_sum, reverse_sum) / static_cast<float>(corners.size());
+}
@@ -0,0 +1,372 @@
+#include "PSMoveConfig.h"
+#include "ServerLog.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Checks the background config writer used by PSMoveConfig::save().
+//
+// Usage: test_config_writer
+// Every config is kept in a test_config_writer directory under the working directory, which is
+// cleared on start. Checks that:
+// * several saves in a row are coalesced into one write, made after the quiet period
+// * saves that keep coming are still written out within the max write delay
+// * load() sees a save that hasn't been written out yet
+// * stopping the writer flushes the pending saves
+// * a crash mid-write never leaves a truncated config behind
+//   (the writing process gets killed at random points, POSIX only)
+
+//-- constants -----
+static const char *k_config_directory = "test_config_writer";
+static const int k_save_count = 10;
+static const std::chrono::milliseconds k_save_interval(20);
+// Past the writer's quiet period (500ms) but short of its max write delay (2s)
+static const std::chrono::milliseconds k_quiet_period_wait(1000);
+static const std::chrono::milliseconds k_max_write_delay_wait(3000);
+static const std::chrono::milliseconds k_steady_save_duration(3000);
+static const int k_crash_iteration_count = 20;
+static const int k_crash_config_entry_count = 2000;
+
+//-- definitions -----
+class TestConfig : public PSMoveConfig
+{
+public:
+    TestConfig(const std::string &fnamebase, int entry_count = 1)
+        : PSMoveConfig(fnamebase)
+        , value(0)
+        , m_entry_count(entry_count)
+    {
+    }
+
+    const boost::property_tree::ptree config2ptree() override
+    {
+        boost::property_tree::ptree pt;
+
+        pt.put("value", value);
+        // Padding so the crash test has a file that takes a while to write
+        for (int entry_index = 1; entry_index < m_entry_count; ++entry_index)
+        {
+            pt.put("entries.entry_" + std::to_string(entry_index), value);
+        }
+
+        return pt;
+    }
+
+    void ptree2config(const boost::property_tree::ptree &pt) override
+    {
+        value = pt.get<int>("value", -1);
+    }
+
+    int value;
+
+private:
+    int m_entry_count;
+};
+
+//-- prototypes -----
+static std::string get_config_path(const char *fnamebase);
+static bool read_config_value(const char *fnamebase, int &out_value);
+static bool wait_for_config_value(const char *fnamebase, int value, std::chrono::milliseconds timeout);
+static bool check_coalesced_saves();
+static bool check_max_write_delay();
+static bool check_pending_load();
+static bool check_stop_flushes();
+static bool check_crash_mid_write();
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    bool success = true;
+
+    // Keep the writer's error lines (if any) off to a file
+    log_init("info", "test_config_writer.log");
+
+    boost::filesystem::remove_all(k_config_directory);
+    PSMoveConfig::setConfigDirectory(k_config_directory);
+
+    PSMoveConfig::startBackgroundWriter();
+
+    if (!check_coalesced_saves())
+    {
+        printf("coalesced saves - FAILED\n");
+        success = false;
+    }
+
+    if (!check_max_write_delay())
+    {
+        printf("max write delay - FAILED\n");
+        success = false;
+    }
+
+    if (!check_pending_load())
+    {
+        printf("pending load - FAILED\n");
+        success = false;
+    }
+
+    if (!check_stop_flushes())
+    {
+        printf("stop flushes - FAILED\n");
+        success = false;
+    }
+
+    // The crash test writes synchronously, so the writer is stopped by now
+    if (!check_crash_mid_write())
+    {
+        printf("crash mid-write - FAILED\n");
+        success = false;
+    }
+
+    log_dispose();
+
+    printf("%s\n", success ? "PASSED" : "FAILED");
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-- private functions -----
+static std::string get_config_path(const char *fnamebase)
+{
+    return (boost::filesystem::path(k_config_directory) / (std::string(fnamebase) + ".json")).string();
+}
+
+// Fails if the file is missing or isn't a complete config
+static bool read_config_value(const char *fnamebase, int &out_value)
+{
+    const std::string path = get_config_path(fnamebase);
+
+    if (!boost::filesystem::exists(path))
+    {
+        return false;
+    }
+
+    try
+    {
+        boost::property_tree::ptree pt;
+
+        boost::property_tree::read_json(path, pt);
+        out_value = pt.get<int>("value");
+    }
+    catch (std::exception &)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static bool wait_for_config_value(const char *fnamebase, int value, std::chrono::milliseconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    for (;;)
+    {
+        int file_value = 0;
+
+        if (read_config_value(fnamebase, file_value) && file_value == value)
+        {
+            return true;
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+static bool check_coalesced_saves()
+{
+    const char *fnamebase = "coalesced";
+    TestConfig config(fnamebase);
+    int file_value = 0;
+
+    for (int save_index = 1; save_index <= k_save_count; ++save_index)
+    {
+        config.value = save_index;
+        config.save();
+        std::this_thread::sleep_for(k_save_interval);
+    }
+
+    // Nothing hits the disk while the saves keep coming
+    if (boost::filesystem::exists(get_config_path(fnamebase)))
+    {
+        printf("  config written before the quiet period\n");
+        return false;
+    }
+
+    // Only the last save gets written
+    if (!wait_for_config_value(fnamebase, k_save_count, k_quiet_period_wait))
+    {
+        printf("  last save not written after the quiet period\n");
+        return false;
+    }
+
+    // And nothing else was left waiting: a second write would bring the file back
+    boost::filesystem::remove(get_config_path(fnamebase));
+    std::this_thread::sleep_for(k_quiet_period_wait);
+
+    if (read_config_value(fnamebase, file_value))
+    {
+        printf("  config written more than once (value %d)\n", file_value);
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_max_write_delay()
+{
+    const char *fnamebase = "max_write_delay";
+    TestConfig config(fnamebase);
+    const auto start_time = std::chrono::steady_clock::now();
+    bool bWritten = false;
+
+    // Saves closer together than the quiet period, for longer than the max write delay
+    while (std::chrono::steady_clock::now() - start_time < k_steady_save_duration)
+    {
+        ++config.value;
+        config.save();
+        std::this_thread::sleep_for(k_save_interval);
+
+        bWritten |= boost::filesystem::exists(get_config_path(fnamebase));
+    }
+
+    if (!bWritten)
+    {
+        printf("  config not written while saves kept coming\n");
+        return false;
+    }
+
+    return wait_for_config_value(fnamebase, config.value, k_quiet_period_wait);
+}
+
+static bool check_pending_load()
+{
+    const char *fnamebase = "pending_load";
+    TestConfig config(fnamebase);
+
+    config.value = 1;
+    config.save();
+    if (!wait_for_config_value(fnamebase, 1, k_max_write_delay_wait))
+    {
+        printf("  first save not written\n");
+        return false;
+    }
+
+    // Still waiting out the quiet period, so the file has the old value
+    config.value = 2;
+    config.save();
+
+    TestConfig loaded_config(fnamebase);
+    int file_value = 0;
+
+    if (!loaded_config.load() || loaded_config.value != 2)
+    {
+        printf("  load() returned %d instead of the pending 2\n", loaded_config.value);
+        return false;
+    }
+
+    if (!read_config_value(fnamebase, file_value) || file_value != 1)
+    {
+        printf("  pending save already written, the check proves nothing\n");
+        return false;
+    }
+
+    return wait_for_config_value(fnamebase, 2, k_max_write_delay_wait);
+}
+
+static bool check_stop_flushes()
+{
+    const char *fnamebase = "stop_flushes";
+    TestConfig config(fnamebase);
+    int file_value = 0;
+
+    config.value = 42;
+    config.save();
+    PSMoveConfig::stopBackgroundWriter();
+
+    if (!read_config_value(fnamebase, file_value) || file_value != 42)
+    {
+        printf("  pending save not written on stop\n");
+        return false;
+    }
+
+    // Once stopped, saves go straight to disk
+    config.value = 43;
+    config.save();
+
+    return read_config_value(fnamebase, file_value) && file_value == 43;
+}
+
+static bool check_crash_mid_write()
+{
+    const char *fnamebase = "crash_mid_write";
+    TestConfig config(fnamebase, k_crash_config_entry_count);
+    int file_value = 0;
+
+    config.value = 0;
+    config.save();
+
+#ifdef _WIN32
+    // No fork() to kill a writer with, only check the config survived a stale temp file
+    std::ofstream(get_config_path(fnamebase) + ".tmp") << "{ \"value\": ";
+#else
+    for (int iteration = 0; iteration < k_crash_iteration_count; ++iteration)
+    {
+        const pid_t pid = fork();
+
+        if (pid < 0)
+        {
+            printf("  fork failed\n");
+            return false;
+        }
+
+        if (pid == 0)
+        {
+            // Rewrite the config until killed
+            for (int value = 1; ; ++value)
+            {
+                config.value = value;
+                config.save();
+            }
+        }
+
+        // Kill it somewhere in the middle of a write
+        std::this_thread::sleep_for(std::chrono::milliseconds(1 + rand() % 20));
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+
+        if (!read_config_value(fnamebase, file_value))
+        {
+            printf("  truncated config after the writer was killed (iteration %d)\n", iteration);
+            return false;
+        }
+    }
+#endif
+
+    // A temp file left behind by the crash doesn't get in the way of the next save
+    config.value = -2;
+    config.save();
+
+    TestConfig loaded_config(fnamebase);
+
+    return loaded_config.load() && loaded_config.value == -2;
+}
@@ -262,6 +262,12 @@ private:
             case PSMTracker_PS3Eye:
                 tracker_type= "PS3Eye";
                 break;
+            case PSMTracker_Virtual:
+                tracker_type= "Virtual";
+                break;
+            case PSMTracker_Remote:
+                tracker_type= "Remote";
+                break;
             }
 
             std::cout << "  Tracker ID: " << trackerList.trackers[tracker_ix].tracker_id << " is a " << tracker_type << std::endl;
@@ -0,0 +1,239 @@
+#include "DataFrameParser.h"
+#include "PackedMessage.h"
+#include "PSMoveProtocol.pb.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
+
+// Benchmarks decoding of the controller data frames the client receives over UDP.
+//
+// Usage: test_data_frame_decode [frame count]
+// Packs a PSMove data frame with every optional stream section filled in, then decodes it
+// over and over the way the client used to (a PackedMessage whose message is cleared
+// and re-parsed every frame) and through the arena backed DeviceOutputDataFrameParser.
+// Reports the time and heap allocations per frame for both and checks the parser
+// stops allocating once it has warmed up.
+
+//-- constants -----
+static const int k_default_frame_count = 200000;
+static const int k_warm_up_frame_count = 100;
+
+//-- globals -----
+// Counts every heap allocation made by this process
+static std::atomic<long long> g_allocation_count(0);
+
+void *operator new(size_t size)
+{
+    ++g_allocation_count;
+
+    void *block = malloc(size > 0 ? size : 1);
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return block;
+}
+
+void operator delete(void *block) noexcept
+{
+    free(block);
+}
+
+//-- definitions -----
+struct DecodeResult
+{
+    double ns_per_frame;
+    double allocations_per_frame;
+    int trigger_sum;
+};
+
+//-- prototypes -----
+static void build_packed_data_frame(data_buffer &out_buffer);
+static void fill_float_vector(PSMoveProtocol::FloatVector *vector, float value);
+static void fill_int_vector(PSMoveProtocol::IntVector *vector, int value);
+static DecodeResult decode_with_packed_message(const data_buffer &buffer, int frame_count);
+static DecodeResult decode_with_arena_parser(const data_buffer &buffer, int frame_count);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    const int frame_count = (argc > 1) ? std::max(atoi(argv[1]), 100) : k_default_frame_count;
+
+    data_buffer packed_data_frame;
+    build_packed_data_frame(packed_data_frame);
+
+    const DecodeResult packed_message_result = decode_with_packed_message(packed_data_frame, frame_count);
+    const DecodeResult arena_parser_result = decode_with_arena_parser(packed_data_frame, frame_count);
+
+    printf("frames: %d, frame size: %d bytes\n", frame_count, static_cast<int>(packed_data_frame.size()));
+    printf("packed message: %.1f ns/frame, %.2f allocations/frame\n",
+        packed_message_result.ns_per_frame, packed_message_result.allocations_per_frame);
+    printf("arena parser:   %.1f ns/frame, %.2f allocations/frame\n",
+        arena_parser_result.ns_per_frame, arena_parser_result.allocations_per_frame);
+
+    bool bSuccess = true;
+
+    if (arena_parser_result.trigger_sum != packed_message_result.trigger_sum)
+    {
+        printf("FAILED: the two decoders disagree on the frame contents\n");
+        bSuccess = false;
+    }
+
+    if (arena_parser_result.allocations_per_frame > 0.0)
+    {
+        printf("FAILED: the arena parser still allocates once warmed up\n");
+        bSuccess = false;
+    }
+
+    return bSuccess ? 0 : -1;
+}
+
+//-- private functions -----
+// The largest controller frame a stream produces: raw, calibrated, tracker and physics data all on
+static void build_packed_data_frame(data_buffer &out_buffer)
+{
+    std::shared_ptr<PSMoveProtocol::DeviceOutputDataFrame> data_frame(new PSMoveProtocol::DeviceOutputDataFrame());
+    data_frame->set_device_category(PSMoveProtocol::DeviceOutputDataFrame_DeviceCategory_CONTROLLER);
+
+    auto *controller_packet = data_frame->mutable_controller_data_packet();
+    controller_packet->set_controller_id(0);
+    controller_packet->set_controller_type(PSMoveProtocol::PSMOVE);
+    controller_packet->set_sequence_num(123456);
+    controller_packet->set_isconnected(true);
+    controller_packet->set_button_down_bitmask(0x105);
+
+    auto *psmove_state = controller_packet->mutable_psmove_state();
+    psmove_state->set_validhardwarecalibration(true);
+    psmove_state->set_istrackingenabled(true);
+    psmove_state->set_iscurrentlytracking(true);
+    psmove_state->set_isorientationvalid(true);
+    psmove_state->set_ispositionvalid(true);
+    psmove_state->mutable_position_cm()->set_x(12.5f);
+    psmove_state->mutable_position_cm()->set_y(-3.25f);
+    psmove_state->mutable_position_cm()->set_z(150.f);
+    psmove_state->mutable_orientation()->set_x(0.1f);
+    psmove_state->mutable_orientation()->set_y(0.2f);
+    psmove_state->mutable_orientation()->set_z(0.3f);
+    psmove_state->mutable_orientation()->set_w(0.927f);
+    psmove_state->set_trigger_value(200);
+    psmove_state->set_battery_value(4);
+
+    auto *raw_sensor_data = psmove_state->mutable_raw_sensor_data();
+    fill_int_vector(raw_sensor_data->mutable_magnetometer(), 300);
+    fill_int_vector(raw_sensor_data->mutable_accelerometer(), 4000);
+    fill_int_vector(raw_sensor_data->mutable_gyroscope(), -20);
+
+    auto *calibrated_sensor_data = psmove_state->mutable_calibrated_sensor_data();
+    fill_float_vector(calibrated_sensor_data->mutable_magnetometer(), 0.5f);
+    fill_float_vector(calibrated_sensor_data->mutable_accelerometer(), 0.98f);
+    fill_float_vector(calibrated_sensor_data->mutable_gyroscope(), 0.01f);
+
+    auto *raw_tracker_data = psmove_state->mutable_raw_tracker_data();
+    raw_tracker_data->set_tracker_id(1);
+    raw_tracker_data->mutable_screen_location()->set_x(320.5f);
+    raw_tracker_data->mutable_screen_location()->set_y(240.25f);
+    raw_tracker_data->mutable_relative_position_cm()->set_x(10.f);
+    raw_tracker_data->mutable_relative_position_cm()->set_y(20.f);
+    raw_tracker_data->mutable_relative_position_cm()->set_z(140.f);
+    raw_tracker_data->mutable_projected_sphere()->mutable_center()->set_x(320.5f);
+    raw_tracker_data->mutable_projected_sphere()->mutable_center()->set_y(240.25f);
+    raw_tracker_data->mutable_projected_sphere()->set_half_x_extent(12.f);
+    raw_tracker_data->mutable_projected_sphere()->set_half_y_extent(11.f);
+    raw_tracker_data->mutable_projected_sphere()->set_angle(0.3f);
+    raw_tracker_data->mutable_multicam_position_cm()->set_x(12.5f);
+    raw_tracker_data->mutable_multicam_position_cm()->set_y(-3.25f);
+    raw_tracker_data->mutable_multicam_position_cm()->set_z(150.f);
+    raw_tracker_data->set_valid_tracker_bitmask(0x3);
+
+    auto *physics_data = psmove_state->mutable_physics_data();
+    fill_float_vector(physics_data->mutable_velocity_cm_per_sec(), 5.f);
+    fill_float_vector(physics_data->mutable_acceleration_cm_per_sec_sqr(), -2.f);
+    fill_float_vector(physics_data->mutable_angular_velocity_rad_per_sec(), 0.5f);
+    fill_float_vector(physics_data->mutable_angular_acceleration_rad_per_sec_sqr(), 0.05f);
+
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> packed_message(data_frame);
+    packed_message.pack(out_buffer);
+}
+
+static void fill_float_vector(PSMoveProtocol::FloatVector *vector, float value)
+{
+    vector->set_i(value);
+    vector->set_j(value * 2.f);
+    vector->set_k(value * -3.f);
+}
+
+static void fill_int_vector(PSMoveProtocol::IntVector *vector, int value)
+{
+    vector->set_i(value);
+    vector->set_j(value * 2);
+    vector->set_k(value * -3);
+}
+
+// How the client decoded data frames before the arena parser
+static DecodeResult decode_with_packed_message(const data_buffer &buffer, int frame_count)
+{
+    PackedMessage<PSMoveProtocol::DeviceOutputDataFrame> packed_message(
+        std::shared_ptr<PSMoveProtocol::DeviceOutputDataFrame>(new PSMoveProtocol::DeviceOutputDataFrame()));
+    DecodeResult result = { 0.0, 0.0, 0 };
+
+    for (int frame_index = 0; frame_index < k_warm_up_frame_count; ++frame_index)
+    {
+        packed_message.unpack(buffer);
+    }
+
+    const long long start_allocation_count = g_allocation_count;
+    const auto start_time = std::chrono::high_resolution_clock::now();
+
+    for (int frame_index = 0; frame_index < frame_count; ++frame_index)
+    {
+        if (packed_message.unpack(buffer))
+        {
+            result.trigger_sum += packed_message.get_msg()->controller_data_packet().psmove_state().trigger_value();
+        }
+    }
+
+    const auto end_time = std::chrono::high_resolution_clock::now();
+
+    result.ns_per_frame = std::chrono::duration<double, std::nano>(end_time - start_time).count() / frame_count;
+    result.allocations_per_frame = static_cast<double>(g_allocation_count - start_allocation_count) / frame_count;
+
+    return result;
+}
+
+static DecodeResult decode_with_arena_parser(const data_buffer &buffer, int frame_count)
+{
+    DeviceOutputDataFrameParser parser;
+    DecodeResult result = { 0.0, 0.0, 0 };
+
+    for (int frame_index = 0; frame_index < k_warm_up_frame_count; ++frame_index)
+    {
+        parser.parse(buffer.data(), static_cast<unsigned>(buffer.size()));
+    }
+
+    const long long start_allocation_count = g_allocation_count;
+    const auto start_time = std::chrono::high_resolution_clock::now();
+
+    for (int frame_index = 0; frame_index < frame_count; ++frame_index)
+    {
+        const PSMoveProtocol::DeviceOutputDataFrame *data_frame =
+            parser.parse(buffer.data(), static_cast<unsigned>(buffer.size()));
+
+        if (data_frame != nullptr)
+        {
+            result.trigger_sum += data_frame->controller_data_packet().psmove_state().trigger_value();
+        }
+    }
+
+    const auto end_time = std::chrono::high_resolution_clock::now();
+
+    result.ns_per_frame = std::chrono::duration<double, std::nano>(end_time - start_time).count() / frame_count;
+    result.allocations_per_frame = static_cast<double>(g_allocation_count - start_allocation_count) / frame_count;
+
+    return result;
+}
@@ -0,0 +1,237 @@
+#include "MathAlignment.h"
+#include "MathUtility.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+// Benchmarks the SoftPOSIT point cloud pose solver on synthetic Morpheus LED projections.
+//
+// Usage: test_point_cloud_pose [trial count]
+// Each trial picks a random headset pose in front of the camera, projects the LEDs that face
+// the camera, shuffles them, adds centroid noise and the odd stray reflection, then solves
+// once seeded with a perturbed "predicted" pose and once with no prediction at all.
+
+//-- constants -----
+static const int k_default_trial_count = 1000;
+static const int k_model_point_count = 9;
+static const int k_max_image_point_count = 6; // CommonDeviceTrackingProjection::MAX_POINT_CLOUD_POINT_COUNT
+static const float k_focal_length_px = 554.f; // PS3Eye, 640x480 at 75 degrees
+static const float k_image_half_width = 320.f;
+static const float k_image_half_height = 240.f;
+static const float k_image_noise_px = 2.f;
+static const int k_iteration_budget = 200;
+
+// The Morpheus LED layout and the direction each LED faces (cm)
+static const Eigen::Vector3f k_model_points[k_model_point_count] = {
+    Eigen::Vector3f(0.f, 0.f, 0.f),
+    Eigen::Vector3f(8.f, 4.5f, -2.5f),
+    Eigen::Vector3f(9.f, 0.f, -10.f),
+    Eigen::Vector3f(8.f, -4.5f, -2.5f),
+    Eigen::Vector3f(-8.f, 4.5f, -2.5f),
+    Eigen::Vector3f(-9.f, 0.f, -10.f),
+    Eigen::Vector3f(-8.f, -4.5f, -2.5f),
+    Eigen::Vector3f(6.f, -1.f, -24.f),
+    Eigen::Vector3f(-6.f, -1.f, -24.f)
+};
+static const Eigen::Vector3f k_model_normals[k_model_point_count] = {
+    Eigen::Vector3f(0.f, 0.f, 1.f),
+    Eigen::Vector3f(0.f, 0.f, 1.f),
+    Eigen::Vector3f(1.f, 0.f, 0.f),
+    Eigen::Vector3f(0.f, 0.f, 1.f),
+    Eigen::Vector3f(0.f, 0.f, 1.f),
+    Eigen::Vector3f(-1.f, 0.f, 0.f),
+    Eigen::Vector3f(0.f, 0.f, 1.f),
+    Eigen::Vector3f(0.f, 0.f, -1.f),
+    Eigen::Vector3f(0.f, 0.f, -1.f)
+};
+
+//-- definitions -----
+struct BenchmarkStats
+{
+    int solve_count;
+    int success_count;
+    int correct_count; // every image point matched to the right LED (or rejected as a stray)
+    double total_us;
+    double max_us;
+    double position_error_sum;
+    double angle_error_sum;
+};
+
+//-- prototypes -----
+static int generate_trial(
+    std::mt19937 &rng, Eigen::Quaternionf &out_orientation, Eigen::Vector3f &out_position,
+    Eigen::Vector2f *out_image_points, int *out_model_indices);
+static void run_solve(
+    const Eigen::Vector2f *image_points, const int *true_model_indices, const int image_point_count,
+    const Eigen::Quaternionf &true_orientation, const Eigen::Vector3f &true_position,
+    const Eigen::Quaternionf *guess_orientation, const Eigen::Vector3f *guess_position,
+    BenchmarkStats &stats);
+static void print_stats(const char *name, const BenchmarkStats &stats);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    const int trial_count = (argc > 1) ? std::max(atoi(argv[1]), 1) : k_default_trial_count;
+    std::mt19937 rng(0x5eed);
+    std::normal_distribution<float> guess_angle_noise(0.f, 5.f*k_degrees_to_radians);
+    std::normal_distribution<float> guess_position_noise(0.f, 3.f);
+
+    BenchmarkStats seeded_stats = {};
+    BenchmarkStats unseeded_stats = {};
+    int skipped_trial_count = 0;
+
+    for (int trial_index = 0; trial_index < trial_count; ++trial_index)
+    {
+        Eigen::Quaternionf true_orientation;
+        Eigen::Vector3f true_position;
+        Eigen::Vector2f image_points[k_max_image_point_count];
+        int true_model_indices[k_max_image_point_count];
+        const int image_point_count = generate_trial(rng, true_orientation, true_position, image_points, true_model_indices);
+
+        if (image_point_count < 3)
+        {
+            ++skipped_trial_count;
+            continue;
+        }
+
+        // Prediction with a few degrees and centimeters of error
+        const Eigen::Vector3f guess_axis = Eigen::Vector3f::Random().normalized();
+        const Eigen::Quaternionf guess_orientation =
+            true_orientation * Eigen::Quaternionf(Eigen::AngleAxisf(guess_angle_noise(rng), guess_axis));
+        const Eigen::Vector3f guess_position =
+            true_position + Eigen::Vector3f(guess_position_noise(rng), guess_position_noise(rng), guess_position_noise(rng));
+
+        run_solve(
+            image_points, true_model_indices, image_point_count, true_orientation, true_position,
+            &guess_orientation, &guess_position, seeded_stats);
+        run_solve(
+            image_points, true_model_indices, image_point_count, true_orientation, true_position,
+            nullptr, nullptr, unseeded_stats);
+    }
+
+    printf("trials: %d (%d skipped with fewer than 3 visible LEDs)\n", trial_count, skipped_trial_count);
+    printf("iteration budget: %d, image noise: %.1f px\n", k_iteration_budget, k_image_noise_px);
+    print_stats("seeded", seeded_stats);
+    print_stats("unseeded", unseeded_stats);
+
+    return EXIT_SUCCESS;
+}
+
+//-- private functions -----
+static int generate_trial(
+    std::mt19937 &rng, Eigen::Quaternionf &out_orientation, Eigen::Vector3f &out_position,
+    Eigen::Vector2f *out_image_points, int *out_model_indices)
+{
+    std::uniform_real_distribution<float> yaw_dist(120.f, 240.f); // facing the camera, +/-60 degrees
+    std::uniform_real_distribution<float> tilt_dist(-20.f, 20.f);
+    std::uniform_real_distribution<float> depth_dist(80.f, 300.f);
+    std::uniform_real_distribution<float> screen_dist(-0.7f, 0.7f);
+    std::uniform_real_distribution<float> unit_dist(0.f, 1.f);
+    std::normal_distribution<float> pixel_noise(0.f, 0.5f*k_image_noise_px);
+
+    out_orientation =
+        Eigen::AngleAxisf(yaw_dist(rng)*k_degrees_to_radians, Eigen::Vector3f::UnitY()) *
+        Eigen::AngleAxisf(tilt_dist(rng)*k_degrees_to_radians, Eigen::Vector3f::UnitX()) *
+        Eigen::AngleAxisf(tilt_dist(rng)*k_degrees_to_radians, Eigen::Vector3f::UnitZ());
+
+    const float depth = depth_dist(rng);
+    out_position = Eigen::Vector3f(
+        screen_dist(rng) * k_image_half_width * depth / k_focal_length_px,
+        screen_dist(rng) * k_image_half_height * depth / k_focal_length_px,
+        depth);
+
+    // Project the LEDs that face the camera, in a random order
+    int model_indices[k_model_point_count];
+    for (int model_index = 0; model_index < k_model_point_count; ++model_index)
+    {
+        model_indices[model_index] = model_index;
+    }
+    std::shuffle(model_indices, model_indices + k_model_point_count, rng);
+
+    int image_point_count = 0;
+    for (int list_index = 0; list_index < k_model_point_count && image_point_count < k_max_image_point_count; ++list_index)
+    {
+        const int model_index = model_indices[list_index];
+        const Eigen::Vector3f camera_point = out_orientation * k_model_points[model_index] + out_position;
+        const Eigen::Vector3f camera_normal = out_orientation * k_model_normals[model_index];
+
+        if (camera_normal.dot(camera_point) < 0.f)
+        {
+            out_image_points[image_point_count] = Eigen::Vector2f(
+                k_focal_length_px * camera_point.x() / camera_point.z() + pixel_noise(rng),
+                k_focal_length_px * camera_point.y() / camera_point.z() + pixel_noise(rng));
+            out_model_indices[image_point_count] = model_index;
+            ++image_point_count;
+        }
+    }
+
+    // Occasionally add a stray reflection
+    if (image_point_count < k_max_image_point_count && unit_dist(rng) < 0.2f)
+    {
+        out_image_points[image_point_count] = Eigen::Vector2f(
+            screen_dist(rng) * k_image_half_width,
+            screen_dist(rng) * k_image_half_height);
+        out_model_indices[image_point_count] = -1;
+        ++image_point_count;
+    }
+
+    return image_point_count;
+}
+
+static void run_solve(
+    const Eigen::Vector2f *image_points, const int *true_model_indices, const int image_point_count,
+    const Eigen::Quaternionf &true_orientation, const Eigen::Vector3f &true_position,
+    const Eigen::Quaternionf *guess_orientation, const Eigen::Vector3f *guess_position,
+    BenchmarkStats &stats)
+{
+    Eigen::Quaternionf orientation;
+    Eigen::Vector3f position;
+    int correspondences[k_max_image_point_count];
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    const bool bSuccess =
+        eigen_alignment_soft_posit(
+            k_model_points, k_model_normals, k_model_point_count,
+            image_points, image_point_count,
+            k_focal_length_px, k_image_noise_px,
+            guess_orientation, guess_position,
+            k_iteration_budget,
+            &orientation, &position, correspondences);
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double elapsed_us = std::chrono::duration<double, std::micro>(end - start).count();
+
+    ++stats.solve_count;
+    stats.total_us += elapsed_us;
+    stats.max_us = std::max(stats.max_us, elapsed_us);
+
+    if (bSuccess)
+    {
+        ++stats.success_count;
+
+        // With the right matches the remaining pose error is down to the pixel noise
+        if (std::equal(correspondences, correspondences + image_point_count, true_model_indices))
+        {
+            ++stats.correct_count;
+            stats.position_error_sum += (position - true_position).norm();
+            stats.angle_error_sum += orientation.angularDistance(true_orientation) / k_degrees_to_radians;
+        }
+    }
+}
+
+static void print_stats(const char *name, const BenchmarkStats &stats)
+{
+    const double solve_count = static_cast<double>(std::max(stats.solve_count, 1));
+    const double correct_count = static_cast<double>(std::max(stats.correct_count, 1));
+
+    printf("%s: %.1f%% solved, %.1f%% correctly matched (mean error %.2fcm, %.2fdeg), %.1f us/solve avg, %.1f us max\n",
+        name,
+        100.0 * static_cast<double>(stats.success_count) / solve_count,
+        100.0 * static_cast<double>(stats.correct_count) / solve_count,
+        stats.position_error_sum / correct_count,
+        stats.angle_error_sum / correct_count,
+        stats.total_us / solve_count,
+        stats.max_us);
+}
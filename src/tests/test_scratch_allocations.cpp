@@ -0,0 +1,244 @@
+#include "ScratchVectorList.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+// Counts the heap allocations a steady-state run of the per-frame contour buffer reuse makes.
+//
+// Usage: test_scratch_allocations
+// Runs a copy of the contour pipeline's buffer handling (find, sort, border filter, float and
+// undistorted copies) on plain point structs, with cv::findContours replaced by a generator that
+// resizes the contours in place. It checks the ScratchVectorList reuse pattern OpenCVBufferState
+// follows, not ServerTrackerView itself: cv::findContours, cv::convexHull and cv::undistortPoints
+// still allocate on the real path.
+// Global operator new is replaced for the whole executable, which is why this isn't in unit_test_suite.
+
+//-- constants -----
+static const int k_frame_width = 640;
+static const int k_frame_height = 480;
+static const int k_warmup_frame_count = 28;
+static const int k_steady_state_frame_count = 1000;
+
+//-- allocation counting -----
+static size_t g_allocation_count = 0;
+
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // The replacements below pair malloc with free themselves
+#endif
+
+void *operator new(std::size_t size)
+{
+    ++g_allocation_count;
+
+    void *ptr = malloc(size > 0 ? size : 1);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+//-- definitions -----
+struct TestPoint
+{
+    int x, y;
+};
+
+struct TestPointF
+{
+    float x, y;
+};
+
+struct TestContourInfo
+{
+    int contour_index;
+    double contour_area;
+};
+
+// Mirrors the per-tracker scratch state used by the blob extraction in ServerTrackerView
+struct TestContourScratch
+{
+    std::vector<std::vector<TestPoint>> raw_contours;
+    std::vector<TestContourInfo> sorted_contours;
+    ScratchVectorList<TestPoint> biggest_contours;
+    std::vector<double> contour_areas;
+    std::vector<TestPointF> float_contour;
+    ScratchVectorList<TestPointF> undistorted_contours;
+
+    TestContourScratch()
+    {
+        raw_contours.reserve(16);
+        sorted_contours.reserve(16);
+        biggest_contours.reserve(16, 512);
+        contour_areas.reserve(16);
+        float_contour.reserve(512);
+        undistorted_contours.reserve(16, 512);
+    }
+};
+
+//-- prototypes -----
+static void generate_frame_contours(int frame_index, std::vector<std::vector<TestPoint>> &out_contours);
+static void process_frame_contours(TestContourScratch &scratch, int frame_index, int max_contour_count);
+static bool check_border_filter();
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    bool success = true;
+
+    // Make sure the allocation hook is actually live, otherwise the count proves nothing
+    {
+        const size_t allocation_count_before = g_allocation_count;
+        std::vector<int> probe(1);
+
+        if (g_allocation_count == allocation_count_before || probe.size() != 1)
+        {
+            printf("allocation hook isn't live\n");
+            success = false;
+        }
+    }
+
+    if (success && !check_border_filter())
+    {
+        printf("border filter left points on the frame edge\n");
+        success = false;
+    }
+
+    if (success)
+    {
+        TestContourScratch scratch;
+
+        // Warm up on the largest frames the pipeline will see
+        for (int frame_index = 0; frame_index < k_warmup_frame_count; ++frame_index)
+        {
+            process_frame_contours(scratch, frame_index, 6);
+        }
+
+        const size_t allocation_count_before = g_allocation_count;
+        for (int frame_index = 0; frame_index < k_steady_state_frame_count; ++frame_index)
+        {
+            process_frame_contours(scratch, frame_index, (frame_index % 2 == 0) ? 6 : 1);
+        }
+        const size_t steady_state_allocations = g_allocation_count - allocation_count_before;
+
+        printf("steady state: %d allocations over %d frames\n",
+            static_cast<int>(steady_state_allocations), k_steady_state_frame_count);
+        success = steady_state_allocations == 0;
+    }
+
+    printf("%s\n", success ? "PASSED" : "FAILED");
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-- private functions -----
+// Stand-in for cv::findContours: resizes the contours in place.
+// The blob count is held fixed since findContours frees the point buffers of dropped contours.
+static void generate_frame_contours(int frame_index, std::vector<std::vector<TestPoint>> &out_contours)
+{
+    const int contour_count = 6;
+
+    out_contours.resize(contour_count);
+    for (int contour_index = 0; contour_index < contour_count; ++contour_index)
+    {
+        std::vector<TestPoint> &contour = out_contours[contour_index];
+        const int point_count = 20 + 10 * contour_index + (frame_index % 7);
+        // First contour hugs the left edge of the frame
+        const int x0 = (contour_index == 0) ? 0 : 50 * contour_index;
+
+        contour.resize(point_count);
+        for (int point_index = 0; point_index < point_count; ++point_index)
+        {
+            contour[point_index].x = (point_index % 2 == 0) ? x0 : x0 + point_index;
+            contour[point_index].y = 100 + point_index;
+        }
+    }
+}
+
+static void process_frame_contours(TestContourScratch &scratch, int frame_index, int max_contour_count)
+{
+    generate_frame_contours(frame_index, scratch.raw_contours);
+
+    scratch.sorted_contours.clear();
+    for (int contour_index = 0; contour_index < static_cast<int>(scratch.raw_contours.size()); ++contour_index)
+    {
+        const TestContourInfo info = { contour_index, static_cast<double>(scratch.raw_contours[contour_index].size()) };
+
+        scratch.sorted_contours.push_back(info);
+    }
+
+    std::sort(
+        scratch.sorted_contours.begin(), scratch.sorted_contours.end(),
+        [](const TestContourInfo &a, const TestContourInfo &b) {
+            return b.contour_area < a.contour_area;
+    });
+
+    scratch.biggest_contours.clear();
+    scratch.contour_areas.clear();
+    for (auto it = scratch.sorted_contours.begin();
+        it != scratch.sorted_contours.end() && static_cast<int>(scratch.biggest_contours.size()) < max_contour_count;
+        ++it)
+    {
+        std::vector<TestPoint> &contour = scratch.raw_contours[it->contour_index];
+
+        contour.erase(
+            std::remove_if(
+                contour.begin(), contour.end(),
+                [](const TestPoint &p) {
+                    return p.x == 0 || p.x == k_frame_width - 1 || p.y == 0 || p.y == k_frame_height - 1;
+            }),
+            contour.end());
+
+        std::vector<TestPoint> &out_contour = scratch.biggest_contours.push_back();
+        out_contour.assign(contour.begin(), contour.end());
+        scratch.contour_areas.push_back(it->contour_area);
+    }
+
+    scratch.undistorted_contours.clear();
+    for (auto it = scratch.biggest_contours.begin(); it != scratch.biggest_contours.end(); ++it)
+    {
+        scratch.float_contour.resize(it->size());
+        for (size_t point_index = 0; point_index < it->size(); ++point_index)
+        {
+            scratch.float_contour[point_index].x = static_cast<float>((*it)[point_index].x);
+            scratch.float_contour[point_index].y = static_cast<float>((*it)[point_index].y);
+        }
+
+        std::vector<TestPointF> &undistorted = scratch.undistorted_contours.push_back();
+        undistorted.assign(scratch.float_contour.begin(), scratch.float_contour.end());
+    }
+}
+
+static bool check_border_filter()
+{
+    TestContourScratch scratch;
+    process_frame_contours(scratch, 0, 16);
+
+    for (auto it = scratch.biggest_contours.begin(); it != scratch.biggest_contours.end(); ++it)
+    {
+        for (auto point_it = it->begin(); point_it != it->end(); ++point_it)
+        {
+            if (point_it->x == 0 || point_it->y == 0)
+            {
+                return false;
+            }
+        }
+    }
+
+    // The contour touching the frame edge lost its even (x=0) points, but none were dropped
+    return scratch.biggest_contours.size() == scratch.raw_contours.size();
+}
@@ -0,0 +1,195 @@
+#include "ServerLog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmarks the hot-path cost of the SERVER_LOG_* macros.
+//
+// Usage: test_server_log [lines per thread]
+// Measures the caller side only: a filtered out line (with an argument that would be
+// expensive to format, like the show_hex dumps in the network code), an emitted line on
+// one thread and emitted lines from several threads at once. For comparison the emitted
+// lines are also written the way the old synchronous logger did (timestamp formatted
+// up front, mutex, std::endl). Console output is discarded, the lines go to test_server_log*.log.
+// Emitted lines are logged in bursts that fit the per-thread ring, so nothing is dropped.
+
+//-- constants -----
+static const int k_default_line_count = 20000;
+static const int k_burst_line_count = 500;
+static const std::chrono::milliseconds k_burst_pause(20);
+static const int k_thread_count = 4;
+static const int k_payload_size = 64;
+
+//-- definitions -----
+class NullStreamBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+};
+
+//-- prototypes -----
+static std::string format_payload(const unsigned char *payload, int length);
+static double log_lines(e_log_severity_level level, int line_count, const unsigned char *payload);
+static double log_lines_synchronous_baseline(int line_count, std::ostream &console_stream, std::ofstream &file_stream);
+
+//-- globals -----
+static int g_format_call_count = 0;
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    const int line_count = (argc > 1) ? std::max(atoi(argv[1]), 1) : k_default_line_count;
+
+    unsigned char payload[k_payload_size];
+    for (int byte_index = 0; byte_index < k_payload_size; ++byte_index)
+    {
+        payload[byte_index] = static_cast<unsigned char>(byte_index);
+    }
+
+    // Keep the emitted lines off the console
+    NullStreamBuffer null_buffer;
+    std::streambuf *console_buffer = std::cout.rdbuf(&null_buffer);
+
+    log_init("info", "test_server_log.log");
+
+    // Filtered out: the level check should skip formatting the payload entirely
+    const double suppressed_ns = log_lines(_log_severity_level_debug, line_count, payload);
+    const int suppressed_format_calls = g_format_call_count;
+
+    // Emitted from one thread
+    const double emitted_ns = log_lines(_log_severity_level_info, line_count, payload);
+
+    // Emitted from several threads at once
+    std::vector<std::thread> threads;
+    std::vector<double> thread_ns(k_thread_count, 0.0);
+    for (int thread_index = 0; thread_index < k_thread_count; ++thread_index)
+    {
+        threads.push_back(std::thread([thread_index, line_count, &payload, &thread_ns]() {
+            thread_ns[thread_index] = log_lines(_log_severity_level_info, line_count, payload);
+        }));
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    double threaded_ns = 0.0;
+    for (double ns : thread_ns)
+    {
+        threaded_ns += ns / static_cast<double>(k_thread_count);
+    }
+
+    // Includes writing out whatever is still queued
+    const auto dispose_start = std::chrono::high_resolution_clock::now();
+    log_dispose();
+    const auto dispose_end = std::chrono::high_resolution_clock::now();
+
+    // The old logger
+    double baseline_ns = 0.0;
+    {
+        std::ostream console_stream(std::cout.rdbuf());
+        std::ofstream file_stream("test_server_log_baseline.log", std::ofstream::out);
+
+        baseline_ns = log_lines_synchronous_baseline(line_count, console_stream, file_stream);
+    }
+
+    std::cout.rdbuf(console_buffer);
+
+    printf("lines per test: %d\n", line_count);
+    printf("suppressed: %.1f ns/line (%d payload formats)\n", suppressed_ns, suppressed_format_calls);
+    printf("emitted, 1 thread: %.1f ns/line\n", emitted_ns);
+    printf("emitted, %d threads: %.1f ns/line\n", k_thread_count, threaded_ns);
+    printf("emitted, synchronous baseline: %.1f ns/line\n", baseline_ns);
+    printf("final drain: %.1f ms\n", std::chrono::duration<double, std::milli>(dispose_end - dispose_start).count());
+
+    return EXIT_SUCCESS;
+}
+
+//-- private functions -----
+static std::string format_payload(const unsigned char *payload, int length)
+{
+    static const char *k_hex_digits = "0123456789abcdef";
+    std::string result;
+
+    ++g_format_call_count;
+    for (int byte_index = 0; byte_index < length; ++byte_index)
+    {
+        result.push_back(k_hex_digits[payload[byte_index] >> 4]);
+        result.push_back(k_hex_digits[payload[byte_index] & 0xf]);
+        result.push_back(' ');
+    }
+
+    return result;
+}
+
+static double log_lines(e_log_severity_level level, int line_count, const unsigned char *payload)
+{
+    double total_ns = 0.0;
+
+    for (int burst_start = 0; burst_start < line_count; burst_start += k_burst_line_count)
+    {
+        const int burst_end = std::min(burst_start + k_burst_line_count, line_count);
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (int line_index = burst_start; line_index < burst_end; ++line_index)
+        {
+            if (level == _log_severity_level_debug)
+            {
+                SERVER_LOG_DEBUG("test_server_log") << "packet " << line_index << ": " << format_payload(payload, k_payload_size);
+            }
+            else
+            {
+                SERVER_LOG_INFO("test_server_log") << "packet " << line_index << ": " << line_index * 3;
+            }
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        total_ns += std::chrono::duration<double, std::nano>(end - start).count();
+
+        // Give the writer thread time to catch up (not timed)
+        if (level != _log_severity_level_debug)
+        {
+            std::this_thread::sleep_for(k_burst_pause);
+        }
+    }
+
+    return total_ns / static_cast<double>(line_count);
+}
+
+static double log_lines_synchronous_baseline(int line_count, std::ostream &console_stream, std::ofstream &file_stream)
+{
+    std::mutex mutex;
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int line_index = 0; line_index < line_count; ++line_index)
+    {
+        const auto now = std::chrono::system_clock::now();
+        const auto seconds = std::chrono::time_point_cast<std::chrono::seconds>(now);
+        const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now - seconds);
+        const time_t in_time_t = std::chrono::system_clock::to_time_t(now);
+        char date_time[32];
+        strftime(date_time, sizeof(date_time), "%Y-%m-%d %H:%M:%S", localtime(&in_time_t));
+
+        std::ostringstream line_buffer;
+        line_buffer << "[" << date_time << "." << milliseconds.count() << "]: " << "test_server_log" << " - "
+            << "packet " << line_index << ": " << line_index * 3;
+
+        const std::string line = line_buffer.str();
+        std::lock_guard<std::mutex> lock(mutex);
+        console_stream << line << std::endl;
+        file_stream << line << std::endl;
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(line_count);
+}
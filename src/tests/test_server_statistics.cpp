@@ -0,0 +1,177 @@
+#include "ServerStatistics.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Benchmarks the pipeline stage timers and checks the accuracy of the reported percentiles.
+//
+// Usage: test_server_statistics [samples per thread]
+// Measures the cost of a StatScopedTimer around an empty scope, then records a known
+// log-normal latency distribution from several threads at once (each thread is a different
+// "device") and compares the merged p50/p99/max against the exact values.
+// Finally checks that a reset starts a new, empty window.
+
+//-- constants -----
+static const int k_default_sample_count = 200000;
+static const int k_thread_count = 4;
+static const float k_percentile_tolerance = 0.125f; // half of the widest histogram bucket
+
+//-- definitions -----
+struct ExactPercentiles
+{
+    float p50;
+    float p99;
+    float max;
+};
+
+//-- prototypes -----
+static double time_scoped_timers(int sample_count);
+static void generate_latencies_us(int seed, int sample_count, std::vector<long long> &out_latencies);
+static ExactPercentiles compute_exact_percentiles(std::vector<long long> latencies);
+static bool check_value(const char *name, float reported, float expected);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    const int sample_count = (argc > 1) ? std::max(atoi(argv[1]), 100) : k_default_sample_count;
+    bool bSuccess = true;
+
+    // Timer overhead
+    const double timer_ns = time_scoped_timers(sample_count);
+    stats_reset();
+
+    // Known distributions recorded from several threads at once
+    std::vector<std::vector<long long>> thread_latencies(k_thread_count);
+    for (int thread_index = 0; thread_index < k_thread_count; ++thread_index)
+    {
+        generate_latencies_us(thread_index, sample_count, thread_latencies[thread_index]);
+    }
+
+    std::vector<std::thread> threads;
+    for (int thread_index = 0; thread_index < k_thread_count; ++thread_index)
+    {
+        threads.push_back(std::thread([thread_index, &thread_latencies]() {
+            for (long long latency_us : thread_latencies[thread_index])
+            {
+                stats_record_duration(_stat_stage_tracker_contours, thread_index, std::chrono::microseconds(latency_us));
+            }
+        }));
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    // The threads have exited, but their samples are still part of this window
+    std::vector<StatStageSummary> summaries;
+    const auto summary_start = std::chrono::high_resolution_clock::now();
+    stats_get_summaries(summaries);
+    const auto summary_end = std::chrono::high_resolution_clock::now();
+
+    printf("samples per thread: %d, threads: %d\n", sample_count, k_thread_count);
+    printf("scoped timer: %.1f ns/sample\n", timer_ns);
+    printf("summary: %.1f us\n", std::chrono::duration<double, std::micro>(summary_end - summary_start).count());
+
+    if (summaries.size() != static_cast<size_t>(k_thread_count))
+    {
+        printf("FAILED: expected %d summaries, got %d\n", k_thread_count, static_cast<int>(summaries.size()));
+        bSuccess = false;
+    }
+
+    for (const StatStageSummary &summary : summaries)
+    {
+        const ExactPercentiles exact = compute_exact_percentiles(thread_latencies[summary.device_id]);
+
+        printf("%s[%d]: %lld samples, p50 %.1f us (exact %.1f), p99 %.1f us (exact %.1f), max %.1f us (exact %.1f)\n",
+            stats_get_stage_name(summary.stage), summary.device_id, summary.sample_count,
+            summary.p50_microseconds, exact.p50, summary.p99_microseconds, exact.p99, summary.max_microseconds, exact.max);
+
+        bSuccess &= summary.stage == _stat_stage_tracker_contours;
+        bSuccess &= summary.sample_count == sample_count;
+        bSuccess &= check_value("p50", summary.p50_microseconds, exact.p50);
+        bSuccess &= check_value("p99", summary.p99_microseconds, exact.p99);
+        bSuccess &= check_value("max", summary.max_microseconds, exact.max);
+    }
+
+    // A reset drops everything recorded so far
+    stats_reset();
+    stats_get_summaries(summaries);
+    if (!summaries.empty())
+    {
+        printf("FAILED: %d summaries left after a reset\n", static_cast<int>(summaries.size()));
+        bSuccess = false;
+    }
+
+    // ... but samples recorded after it are reported
+    stats_record_duration(_stat_stage_udp_send, -1, std::chrono::microseconds(100));
+    stats_get_summaries(summaries);
+    if (summaries.size() != 1 || summaries[0].device_id != -1 || summaries[0].sample_count != 1)
+    {
+        printf("FAILED: expected a single udp_send sample after the reset\n");
+        bSuccess = false;
+    }
+
+    printf(bSuccess ? "PASSED\n" : "FAILED\n");
+
+    return bSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-- private functions -----
+static double time_scoped_timers(int sample_count)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int sample_index = 0; sample_index < sample_count; ++sample_index)
+    {
+        StatScopedTimer stat_timer(_stat_stage_controller_filter, sample_index % 2);
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(sample_count);
+}
+
+static void generate_latencies_us(int seed, int sample_count, std::vector<long long> &out_latencies)
+{
+    // Mostly a few hundred microseconds with a long tail, like a contour pass
+    std::mt19937 rng(0x5eed + seed);
+    std::lognormal_distribution<double> latency_dist(5.5 + 0.25 * seed, 0.6);
+
+    out_latencies.resize(sample_count);
+    for (long long &latency_us : out_latencies)
+    {
+        latency_us = static_cast<long long>(latency_dist(rng));
+    }
+}
+
+static ExactPercentiles compute_exact_percentiles(std::vector<long long> latencies)
+{
+    ExactPercentiles result;
+
+    std::sort(latencies.begin(), latencies.end());
+
+    const size_t count = latencies.size();
+    result.p50 = static_cast<float>(latencies[(count * 50 + 99) / 100 - 1]);
+    result.p99 = static_cast<float>(latencies[(count * 99 + 99) / 100 - 1]);
+    result.max = static_cast<float>(latencies[count - 1]);
+
+    return result;
+}
+
+static bool check_value(const char *name, float reported, float expected)
+{
+    // Whole microsecond samples are reported at the middle of their bucket
+    const float tolerance = std::max(expected * k_percentile_tolerance, 1.f);
+
+    if (fabsf(reported - expected) > tolerance)
+    {
+        printf("FAILED: %s is %.1f us, expected %.1f +/- %.1f us\n", name, reported, expected, tolerance);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,197 @@
+#include "ServerLog.h"
+#include "ServerTrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmarks the service timeline recorder and checks the Chrome trace it writes.
+//
+// Usage: test_server_trace [events per thread]
+// Measures the cost of a SERVER_TRACE_SCOPE around an empty scope with recording off,
+// records nested scopes from several named threads at once and checks that the dump
+// has every event, the thread names, and timestamps in order, then measures the cost
+// with recording on. Finally overfills the ring and checks that only the most recent
+// events are kept.
+// The dumps are left in test_server_trace*.json, open them in chrome://tracing or ui.perfetto.dev.
+
+//-- constants -----
+static const int k_default_event_count = 4000;
+static const int k_thread_count = 4;
+static const int k_ring_capacity = 1 << 16; // see ServerTrace.cpp
+static const int k_timing_iterations = 1000000;
+
+//-- definitions -----
+struct TraceFileSummary
+{
+    int complete_event_count;
+    int thread_name_count;
+    bool bTimestampsSorted;
+};
+
+//-- prototypes -----
+static double time_trace_scopes(int iteration_count);
+static void record_nested_scopes(int thread_index, int event_count);
+static bool read_trace_file(const std::string &filename, TraceFileSummary &out_summary);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    const int event_count = (argc > 1) ? std::max(atoi(argv[1]), 2) & ~1 : k_default_event_count;
+    bool bSuccess = true;
+
+    log_init("warning");
+
+    // Scope overhead with recording off
+    const double scope_off_ns = time_trace_scopes(k_timing_iterations);
+
+    // Nested scopes from several named threads at once
+    trace_set_recording(true);
+
+    std::vector<std::thread> threads;
+    for (int thread_index = 0; thread_index < k_thread_count; ++thread_index)
+    {
+        threads.push_back(std::thread(record_nested_scopes, thread_index, event_count));
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    trace_set_recording(false);
+
+    const int expected_events = std::min(k_thread_count * event_count, k_ring_capacity);
+    int dumped_count = 0;
+    const auto dump_start = std::chrono::high_resolution_clock::now();
+    bSuccess &= trace_write_chrome_json("test_server_trace.json", &dumped_count);
+    const auto dump_end = std::chrono::high_resolution_clock::now();
+
+    if (dumped_count != expected_events)
+    {
+        printf("FAILED: dumped %d events, expected %d\n", dumped_count, expected_events);
+        bSuccess = false;
+    }
+
+    TraceFileSummary summary;
+    if (read_trace_file("test_server_trace.json", summary))
+    {
+        if (summary.complete_event_count != dumped_count)
+        {
+            printf("FAILED: file has %d events, expected %d\n", summary.complete_event_count, dumped_count);
+            bSuccess = false;
+        }
+        if (summary.thread_name_count != k_thread_count)
+        {
+            printf("FAILED: file has %d thread names, expected %d\n", summary.thread_name_count, k_thread_count);
+            bSuccess = false;
+        }
+        if (!summary.bTimestampsSorted)
+        {
+            printf("FAILED: events aren't sorted by timestamp\n");
+            bSuccess = false;
+        }
+    }
+    else
+    {
+        printf("FAILED: couldn't read back test_server_trace.json\n");
+        bSuccess = false;
+    }
+
+    // Scope overhead with recording on
+    trace_set_recording(true);
+    const double scope_on_ns = time_trace_scopes(k_ring_capacity);
+    trace_set_recording(false);
+
+    printf("threads: %d, events per thread: %d\n", k_thread_count, event_count);
+    printf("scope (recording off): %.2f ns\n", scope_off_ns);
+    printf("scope (recording on): %.1f ns\n", scope_on_ns);
+    printf("dump: %d events in %.1f ms\n",
+        expected_events, std::chrono::duration<double, std::milli>(dump_end - dump_start).count());
+
+    // Overfill the ring, only the most recent events are kept
+    trace_set_recording(true);
+    record_nested_scopes(0, k_ring_capacity);
+    trace_set_recording(false);
+
+    bSuccess &= trace_write_chrome_json("test_server_trace_wrapped.json", &dumped_count);
+    if (dumped_count != k_ring_capacity)
+    {
+        printf("FAILED: dumped %d events after wrapping, expected %d\n", dumped_count, k_ring_capacity);
+        bSuccess = false;
+    }
+
+    log_dispose();
+
+    printf(bSuccess ? "PASSED\n" : "FAILED\n");
+
+    return bSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-- private functions -----
+static double time_trace_scopes(int iteration_count)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        SERVER_TRACE_DEVICE_SCOPE("timing", iteration & 1);
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iteration_count);
+}
+
+static void record_nested_scopes(int thread_index, int event_count)
+{
+    std::stringstream thread_name;
+    thread_name << "Test Thread " << thread_index;
+    trace_set_thread_name(thread_name.str());
+
+    // Pairs of an outer "frame" scope around an inner "work" scope
+    for (int pair_index = 0; pair_index < event_count / 2; ++pair_index)
+    {
+        SERVER_TRACE_DEVICE_SCOPE("frame", thread_index);
+        {
+            SERVER_TRACE_SCOPE("work");
+        }
+    }
+}
+
+static bool read_trace_file(const std::string &filename, TraceFileSummary &out_summary)
+{
+    std::ifstream file_stream(filename);
+    if (!file_stream.is_open())
+    {
+        return false;
+    }
+
+    out_summary.complete_event_count = 0;
+    out_summary.thread_name_count = 0;
+    out_summary.bTimestampsSorted = true;
+
+    // The writer puts one event per line
+    double last_timestamp = -1.0;
+    std::string line;
+    while (std::getline(file_stream, line))
+    {
+        if (line.find("\"ph\":\"X\"") != std::string::npos)
+        {
+            const size_t ts_offset = line.find("\"ts\":");
+            const double timestamp = (ts_offset != std::string::npos) ? atof(line.c_str() + ts_offset + 5) : -1.0;
+
+            out_summary.bTimestampsSorted &= timestamp >= last_timestamp;
+            last_timestamp = timestamp;
+            ++out_summary.complete_event_count;
+        }
+        else if (line.find("\"ph\":\"M\"") != std::string::npos)
+        {
+            ++out_summary.thread_name_count;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,304 @@
+#include "ControllerManager.h"
+#include "DeviceManager.h"
+#include "MathGLM.h"
+#include "MathUtility.h"
+#include "PSMoveConfig.h"
+#include "ServerControllerView.h"
+#include "ServerLog.h"
+#include "ServerRequestHandler.h"
+#include "ServerStatistics.h"
+#include "ServerTrackerView.h"
+#include "TrackerManager.h"
+#include "USBDeviceManager.h"
+#include "VirtualTrackerScene.h"
+
+#include <boost/filesystem.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Benchmarks the optical tracking pipeline end to end without any camera or controller hardware.
+//
+// Usage: test_tracking_benchmark [trackers] [controllers] [frames]
+// Starts the device managers headless (no network manager) with virtual trackers placed on a
+// ring around the origin and virtual controllers whose bulbs follow Lissajous paths through
+// the synthetic scene the virtual trackers render. The scene time is stepped once per frame,
+// so every service update sees exactly one new video frame per tracker.
+// Reports the service update rate, the per-stage latencies and the error of the multicam
+// position estimate against the ground truth path.
+// Note that the tracker frame grab stage includes rendering the synthetic frame.
+
+//-- constants -----
+static const int k_default_tracker_count = 2;
+static const int k_default_controller_count = 1;
+static const int k_default_frame_count = 600;
+static const int k_warmup_frame_count = 30; // initial full frame scans and filter convergence
+static const double k_scene_frame_rate = 60.0;
+static const float k_tracker_ring_radius_cm = 150.f;
+static const float k_tracker_height_cm = 30.f;
+static const float k_controller_spacing_cm = 20.f;
+static const float k_max_mean_error_cm = 3.f;
+static const float k_min_tracking_ratio = 0.9f;
+
+//-- definitions -----
+struct TrackingErrorStats
+{
+    long long sample_count;
+    long long tracked_count;
+    double error_sum;
+    double error_squared_sum;
+    double error_max;
+};
+
+//-- prototypes -----
+static void write_benchmark_configs(int tracker_count, int controller_count);
+static void place_trackers(DeviceManager &device_manager, int tracker_count);
+static void add_controller_objects(DeviceManager &device_manager, int controller_count);
+static void sync_object_colors(DeviceManager &device_manager, int controller_count);
+static void accumulate_tracking_error(DeviceManager &device_manager, int controller_count, TrackingErrorStats &stats);
+
+//-- entry point -----
+int main(int argc, char *argv[])
+{
+    const int tracker_count = (argc > 1) ? std::max(atoi(argv[1]), 1) : k_default_tracker_count;
+    const int controller_count = (argc > 2) ? std::max(atoi(argv[2]), 1) : k_default_controller_count;
+    const int frame_count = (argc > 3) ? std::max(atoi(argv[3]), 1) : k_default_frame_count;
+    bool bSuccess = true;
+
+    // Keep the benchmark configs away from the user's real ones
+    const boost::filesystem::path config_directory =
+        boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("psmove_tracking_benchmark_%%%%%%%%");
+    PSMoveConfig::setConfigDirectory(config_directory.string());
+    write_benchmark_configs(tracker_count, controller_count);
+
+    log_init("warning");
+
+    USBDeviceManager usb_device_manager;
+    DeviceManager device_manager;
+    ServerRequestHandler request_handler(&device_manager);
+
+    if (!usb_device_manager.startup() || !device_manager.startup() || !request_handler.startup())
+    {
+        printf("FAILED: couldn't start the device managers\n");
+        return EXIT_FAILURE;
+    }
+
+    // Poll every update, the scene time decides when there is a new frame
+    device_manager.m_controller_manager->poll_interval = 0;
+    device_manager.m_tracker_manager->poll_interval = 0;
+
+    // The first update enumerates and opens the virtual devices
+    VirtualTrackerScene *scene = VirtualTrackerScene::getInstance();
+    scene->clearObjects();
+    scene->setTime(0.0);
+    device_manager.update();
+
+    place_trackers(device_manager, tracker_count);
+    add_controller_objects(device_manager, controller_count);
+
+    // Timed frames
+    TrackingErrorStats error_stats = {0, 0, 0.0, 0.0, 0.0};
+    std::chrono::high_resolution_clock::duration update_duration(0);
+
+    for (int frame_index = 1; frame_index <= k_warmup_frame_count + frame_count; ++frame_index)
+    {
+        if (frame_index == k_warmup_frame_count + 1)
+        {
+            stats_reset();
+        }
+
+        scene->setTime(static_cast<double>(frame_index) / k_scene_frame_rate);
+        sync_object_colors(device_manager, controller_count);
+
+        const auto update_start = std::chrono::high_resolution_clock::now();
+        device_manager.update();
+        const auto update_end = std::chrono::high_resolution_clock::now();
+
+        if (frame_index > k_warmup_frame_count)
+        {
+            update_duration += update_end - update_start;
+            accumulate_tracking_error(device_manager, controller_count, error_stats);
+        }
+    }
+
+    // Report
+    std::vector<StatStageSummary> summaries;
+    stats_get_summaries(summaries);
+
+    const double update_seconds = std::chrono::duration<double>(update_duration).count();
+    const float tracking_ratio =
+        (error_stats.sample_count > 0)
+        ? static_cast<float>(error_stats.tracked_count) / static_cast<float>(error_stats.sample_count)
+        : 0.f;
+    const double mean_error =
+        (error_stats.tracked_count > 0) ? error_stats.error_sum / static_cast<double>(error_stats.tracked_count) : 0.0;
+    const double rms_error =
+        (error_stats.tracked_count > 0) ? sqrt(error_stats.error_squared_sum / static_cast<double>(error_stats.tracked_count)) : 0.0;
+
+    printf("trackers: %d, controllers: %d, frames: %d\n", tracker_count, controller_count, frame_count);
+    printf("update: %.3f ms/frame (%.1f fps)\n",
+        update_seconds * 1000.0 / frame_count, (update_seconds > 0.0) ? frame_count / update_seconds : 0.0);
+
+    for (const StatStageSummary &summary : summaries)
+    {
+        printf("%s[%d]: %lld samples, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+            stats_get_stage_name(summary.stage), summary.device_id, summary.sample_count,
+            summary.p50_microseconds, summary.p99_microseconds, summary.max_microseconds);
+    }
+
+    printf("tracked: %.1f%% of controller frames\n", tracking_ratio * 100.f);
+    printf("position error: mean %.2f cm, rms %.2f cm, max %.2f cm\n", mean_error, rms_error, error_stats.error_max);
+
+    if (tracking_ratio < k_min_tracking_ratio)
+    {
+        printf("FAILED: tracked less than %.0f%% of controller frames\n", k_min_tracking_ratio * 100.f);
+        bSuccess = false;
+    }
+
+    if (mean_error > k_max_mean_error_cm)
+    {
+        printf("FAILED: mean position error above %.1f cm\n", k_max_mean_error_cm);
+        bSuccess = false;
+    }
+
+    request_handler.shutdown();
+    device_manager.shutdown();
+    usb_device_manager.shutdown();
+    log_dispose();
+
+    boost::system::error_code error_code;
+    boost::filesystem::remove_all(config_directory, error_code);
+
+    printf(bSuccess ? "PASSED\n" : "FAILED\n");
+
+    return bSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-- private functions -----
+static void write_benchmark_configs(int tracker_count, int controller_count)
+{
+    ControllerManagerConfig controller_manager_config;
+    controller_manager_config.virtual_controller_count = controller_count;
+    controller_manager_config.save();
+
+    TrackerManagerConfig tracker_manager_config;
+    tracker_manager_config.virtual_tracker_count = tracker_count;
+    tracker_manager_config.save();
+}
+
+static void place_trackers(DeviceManager &device_manager, int tracker_count)
+{
+    for (int tracker_index = 0; tracker_index < tracker_count; ++tracker_index)
+    {
+        ServerTrackerViewPtr tracker_view = device_manager.getTrackerViewPtr(tracker_index);
+        if (!tracker_view || !tracker_view->getIsOpen())
+        {
+            continue;
+        }
+
+        // Spread the trackers over the front half of the ring, all looking at the origin
+        const float angle = (tracker_count > 1)
+            ? k_real_two_pi * (0.125f + 0.25f * static_cast<float>(tracker_index) / static_cast<float>(tracker_count - 1))
+            : k_real_half_pi;
+        const glm::vec3 position(
+            k_tracker_ring_radius_cm * cosf(angle), k_tracker_height_cm, k_tracker_ring_radius_cm * sinf(angle));
+        const glm::vec3 forward = glm::normalize(-position);
+        const glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0.f, 1.f, 0.f), forward));
+        const glm::vec3 up = glm::cross(forward, right);
+        const glm::quat orientation = glm::quat_cast(glm::mat3(right, up, forward));
+
+        CommonDevicePose pose;
+        pose.PositionCm.set(position.x, position.y, position.z);
+        pose.Orientation.w = orientation.w;
+        pose.Orientation.x = orientation.x;
+        pose.Orientation.y = orientation.y;
+        pose.Orientation.z = orientation.z;
+        tracker_view->setTrackerPose(&pose);
+    }
+}
+
+static void add_controller_objects(DeviceManager &device_manager, int controller_count)
+{
+    VirtualTrackerScene *scene = VirtualTrackerScene::getInstance();
+
+    for (int controller_index = 0; controller_index < controller_count; ++controller_index)
+    {
+        ServerControllerViewPtr controller_view = device_manager.getControllerViewPtr(controller_index);
+
+        VirtualTrackerSceneObject object;
+        if (!controller_view || !controller_view->getIsOpen() || !controller_view->getTrackingShape(object.shape))
+        {
+            // Keep the object indices lined up with the controller ids
+            object.shape.shape_type = eCommonTrackingShapeType::Sphere;
+            object.shape.shape.sphere.center_cm.clear();
+            object.shape.shape.sphere.radius_cm = 2.25f;
+        }
+
+        // Side by side bulbs on different, slow paths through the middle of the ring
+        const float offset = static_cast<float>(controller_index) - 0.5f * static_cast<float>(controller_count - 1);
+        object.tracking_color_id = eCommonTrackingColorID::Blue;
+        object.trajectory.clear();
+        object.trajectory.center_cm.set(offset * k_controller_spacing_cm, 0.f, 0.f);
+        object.trajectory.amplitude_cm.set(15.f, 10.f, 15.f);
+        object.trajectory.frequency_hz.set(0.23f + 0.02f * controller_index, 0.31f, 0.17f + 0.03f * controller_index);
+        object.trajectory.phase_radians.set(0.f, 0.7f * controller_index, 1.3f);
+        scene->addObject(object);
+
+        if (controller_view && controller_view->getIsOpen())
+        {
+            controller_view->startTracking();
+        }
+    }
+}
+
+static void sync_object_colors(DeviceManager &device_manager, int controller_count)
+{
+    VirtualTrackerScene *scene = VirtualTrackerScene::getInstance();
+
+    // Light each bulb in whatever color the controller manager assigned
+    for (int controller_index = 0; controller_index < controller_count; ++controller_index)
+    {
+        ServerControllerViewPtr controller_view = device_manager.getControllerViewPtr(controller_index);
+
+        if (controller_view && controller_view->getIsOpen())
+        {
+            scene->setObjectTrackingColor(controller_index, controller_view->getTrackingColorID());
+        }
+    }
+}
+
+static void accumulate_tracking_error(DeviceManager &device_manager, int controller_count, TrackingErrorStats &stats)
+{
+    const VirtualTrackerScene *scene = VirtualTrackerScene::getInstance();
+
+    for (int controller_index = 0; controller_index < controller_count; ++controller_index)
+    {
+        ServerControllerViewPtr controller_view = device_manager.getControllerViewPtr(controller_index);
+        if (!controller_view || !controller_view->getIsOpen())
+        {
+            continue;
+        }
+
+        const ControllerOpticalPoseEstimation *estimate = controller_view->getMulticamPoseEstimate();
+        ++stats.sample_count;
+
+        if (estimate != nullptr && estimate->bCurrentlyTracking)
+        {
+            const CommonDevicePose truth = scene->getObjectPose(controller_index);
+            const double dx = estimate->position_cm.x - truth.PositionCm.x;
+            const double dy = estimate->position_cm.y - truth.PositionCm.y;
+            const double dz = estimate->position_cm.z - truth.PositionCm.z;
+            const double error = sqrt(dx*dx + dy*dy + dz*dz);
+
+            ++stats.tracked_count;
+            stats.error_sum += error;
+            stats.error_squared_sum += error * error;
+            stats.error_max = std::max(stats.error_max, error);
+        }
+    }
+}
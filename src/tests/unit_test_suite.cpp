@@ -13,6 +13,15 @@ main(int argc, char* argv[])
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_alignment_unit_tests);
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_eigen_unit_tests);
 		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_math_utility_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_led_blink_code_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_blob_assignment_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_scratch_vector_list_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_subpixel_edge_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_remote_tracker_packet_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_data_stream_filter_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_data_frame_delta_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_shared_state_slot_unit_tests);
+		UNIT_TEST_SUITE_CALL_CPP_MODULE(run_shared_device_state_unit_tests);
 	UNIT_TEST_SUITE_END()
 
 	return success ? EXIT_SUCCESS : EXIT_FAILURE;